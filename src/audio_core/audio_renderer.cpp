@@ -0,0 +1,415 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "audio_core/audio_renderer.h"
+#include "audio_core/mix_kernels.h"
+#include "audio_core/sink.h"
+#include "audio_core/sink_details.h"
+#include "audio_core/stream.h"
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/thread_placement.h"
+#include "core/memory.h"
+#include "core/settings.h"
+
+namespace AudioCore {
+
+namespace {
+
+/// Rendered frames the stream holds before the renderer waits for the host to play them.
+/// Together they are the latency of the renderer, about 20ms with the usual 5ms audio frames.
+constexpr size_t MaxQueuedFrames = 4;
+
+/// Volume that the center and rear channels are folded into the front ones with
+constexpr float DownmixVolume = 0.707f;
+
+} // Anonymous namespace
+
+bool AudioRenderer::VoiceState::IsPlaying() const {
+    return is_in_use && info.play_state == PlayState::Started;
+}
+
+void AudioRenderer::VoiceState::Update(const VoiceInfo& new_info) {
+    info = new_info;
+    if (is_in_use && !info.is_in_use) {
+        // No longer in use, reset state
+        *this = {};
+        return;
+    }
+    is_in_use = info.is_in_use;
+    if (!is_in_use) {
+        return;
+    }
+
+    if (info.is_new) {
+        wave_index = info.wave_buffer_head % info.wave_buffer.size();
+        wave_buffer_queued = {};
+        wave_buffer_data = {};
+        is_refresh_pending = true;
+        offset = 0;
+        adpcm_history = {};
+        out_status = {};
+    }
+
+    // Wave buffers the application hasn't sent before are the ones it queued since the last update
+    bool copied = false;
+    for (size_t i = 0; i < info.wave_buffer_count && i < info.wave_buffer.size(); ++i) {
+        const size_t index = (info.wave_buffer_head + i) % info.wave_buffer.size();
+        if (!info.wave_buffer[index].sent_to_server && !wave_buffer_queued[index]) {
+            wave_buffer_queued[index] = true;
+            CopyWaveBuffer(index);
+            copied = true;
+        }
+    }
+    if (copied && info.sample_format == Codec::PcmFormat::Adpcm &&
+        info.additional_params_sz >= sizeof(adpcm_coeff)) {
+        Memory::ReadBlock(info.additional_params_addr, adpcm_coeff.data(), sizeof(adpcm_coeff));
+    }
+}
+
+void AudioRenderer::VoiceState::CopyWaveBuffer(size_t index) {
+    const WaveBuffer& wave_buffer = info.wave_buffer[index];
+    WaveBufferData& buffer_data = wave_buffer_data[index];
+    buffer_data = {};
+
+    const size_t channel_count = std::clamp<size_t>(info.channel_count, 1, MaxVoiceChannels);
+    const size_t start = std::max<s32>(wave_buffer.start_sample_offset, 0);
+    size_t end = std::max<s32>(wave_buffer.end_sample_offset, 0);
+    switch (info.sample_format) {
+    case Codec::PcmFormat::Int16: {
+        const size_t frame_size = channel_count * sizeof(s16);
+        const size_t buffer_frames = wave_buffer.buffer_sz / frame_size;
+        if (end == 0 || end > buffer_frames) {
+            end = buffer_frames;
+        }
+        if (start < end) {
+            buffer_data.data.resize((end - start) * frame_size);
+            Memory::ReadBlock(wave_buffer.buffer_addr + start * frame_size,
+                              buffer_data.data.data(), buffer_data.data.size());
+        }
+        break;
+    }
+    case Codec::PcmFormat::Adpcm: {
+        const size_t buffer_samples =
+            wave_buffer.buffer_sz / Codec::ADPCM_FRAME_SIZE * Codec::ADPCM_SAMPLES_PER_FRAME;
+        if (end == 0 || end > buffer_samples) {
+            end = buffer_samples;
+        }
+        if (start < end) {
+            const size_t first_frame = start / Codec::ADPCM_SAMPLES_PER_FRAME;
+            buffer_data.data.resize(wave_buffer.buffer_sz - first_frame * Codec::ADPCM_FRAME_SIZE);
+            Memory::ReadBlock(wave_buffer.buffer_addr + first_frame * Codec::ADPCM_FRAME_SIZE,
+                              buffer_data.data.data(), buffer_data.data.size());
+            buffer_data.first_sample = start % Codec::ADPCM_SAMPLES_PER_FRAME;
+            buffer_data.sample_count = end - start;
+        }
+        break;
+    }
+    default:
+        // Reported when the voice is played
+        break;
+    }
+}
+
+AudioRenderer::AudioRenderer(AudioRendererParameter params, std::function<void()> frame_callback)
+    : worker_params(params), frame_callback(std::move(frame_callback)),
+      voices(params.voice_count), voice_resources(params.voice_count),
+      mix_buffers(params.mix_buffer_count * params.sample_count),
+      voice_scratch(MaxVoiceChannels * params.sample_count) {
+    const auto& sink_details = GetSinkDetails(Settings::values.sink_id);
+    stream = std::make_unique<Stream>(
+        sink_details.factory(params.sample_rate, Settings::values.audio_device_id),
+        Settings::values.enable_audio_stretching, [] {});
+    stream->Play();
+
+    render_thread = std::thread(&AudioRenderer::RenderThread, this);
+}
+
+AudioRenderer::~AudioRenderer() {
+    stop_thread = true;
+    wake_event.Set();
+    render_thread.join();
+}
+
+std::vector<u8> AudioRenderer::UpdateAudioRenderer(const std::vector<u8>& input_params) {
+    // Copy UpdateDataHeader struct
+    UpdateDataHeader config{};
+    std::memcpy(&config, input_params.data(), std::min(input_params.size(), sizeof(config)));
+    const u32 memory_pool_count = worker_params.effect_count + (worker_params.voice_count * 4);
+
+    const size_t memory_pools_offset = sizeof(UpdateDataHeader) + config.behavior_size;
+    const size_t voice_resources_offset = memory_pools_offset + config.memory_pools_size;
+    const size_t voices_offset = voice_resources_offset + config.voice_resource_size;
+    if (input_params.size() < voices_offset + worker_params.voice_count * sizeof(VoiceInfo)) {
+        LOG_ERROR(Audio, "Update of 0x%zx bytes is too small", input_params.size());
+    } else {
+        std::lock_guard<std::mutex> lock(state_mutex);
+
+        const size_t resource_count =
+            std::min<size_t>(config.voice_resource_size / sizeof(VoiceChannelResource),
+                             voice_resources.size());
+        std::memcpy(voice_resources.data(), input_params.data() + voice_resources_offset,
+                    resource_count * sizeof(VoiceChannelResource));
+
+        size_t offset = voices_offset;
+        for (auto& voice : voices) {
+            VoiceInfo info;
+            std::memcpy(&info, input_params.data() + offset, sizeof(VoiceInfo));
+            voice.Update(info);
+            offset += sizeof(VoiceInfo);
+        }
+    }
+
+    // Update memory pool state
+    std::vector<MemoryPoolEntry> memory_pool(memory_pool_count);
+    if (input_params.size() >= memory_pools_offset + memory_pool_count * sizeof(MemoryPoolInfo)) {
+        for (size_t index = 0; index < memory_pool.size(); ++index) {
+            MemoryPoolInfo pool_info;
+            std::memcpy(&pool_info,
+                        input_params.data() + memory_pools_offset + index * sizeof(MemoryPoolInfo),
+                        sizeof(MemoryPoolInfo));
+            if (pool_info.pool_state == MemoryPoolStates::RequestAttach) {
+                memory_pool[index].state = MemoryPoolStates::Attached;
+            } else if (pool_info.pool_state == MemoryPoolStates::RequestDetach) {
+                memory_pool[index].state = MemoryPoolStates::Detached;
+            }
+        }
+    }
+
+    // Copy output header
+    UpdateDataHeader response_data{worker_params};
+    std::vector<u8> output_params(response_data.total_size);
+    std::memcpy(output_params.data(), &response_data, sizeof(UpdateDataHeader));
+
+    // Copy output memory pool entries
+    std::memcpy(output_params.data() + sizeof(UpdateDataHeader), memory_pool.data(),
+                response_data.memory_pools_size);
+
+    // Copy output voice status
+    std::lock_guard<std::mutex> lock(state_mutex);
+    size_t voice_out_status_offset{sizeof(UpdateDataHeader) + response_data.memory_pools_size};
+    for (const auto& voice : voices) {
+        std::memcpy(output_params.data() + voice_out_status_offset, &voice.out_status,
+                    sizeof(VoiceOutStatus));
+        voice_out_status_offset += sizeof(VoiceOutStatus);
+    }
+
+    return output_params;
+}
+
+void AudioRenderer::Start() {
+    is_started = true;
+}
+
+void AudioRenderer::Stop() {
+    is_started = false;
+}
+
+bool AudioRenderer::IsStarted() const {
+    return is_started;
+}
+
+u32 AudioRenderer::GetSampleRate() const {
+    return worker_params.sample_rate;
+}
+
+u32 AudioRenderer::GetSampleCount() const {
+    return worker_params.sample_count;
+}
+
+u32 AudioRenderer::GetMixBufferCount() const {
+    return worker_params.mix_buffer_count;
+}
+
+void AudioRenderer::WakeUp() {
+    wake_event.Set();
+}
+
+void AudioRenderer::RenderThread() {
+    Common::SetCurrentThreadRole(Common::ThreadRole::Audio);
+    while (true) {
+        wake_event.Wait();
+        if (stop_thread) {
+            return;
+        }
+
+        // Release what the host played, then top the stream up and push the new frames to it
+        stream->Update();
+        bool rendered = false;
+        while (is_started && stream->GetQueueSize() < MaxQueuedFrames) {
+            RenderFrame();
+            rendered = true;
+        }
+        if (rendered) {
+            stream->Update();
+        }
+    }
+}
+
+void AudioRenderer::RenderFrame() {
+    const size_t sample_count = worker_params.sample_count;
+    std::fill(mix_buffers.begin(), mix_buffers.end(), 0.0f);
+
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        for (auto& voice : voices) {
+            if (voice.IsPlaying()) {
+                MixVoice(voice);
+            }
+        }
+    }
+
+    // The first two mix buffers are the front channels. With six of them or more, the center and
+    // the rear channels of 5.1 are folded into the front ones. Without any, the frame is silent.
+    std::vector<float> left(sample_count);
+    if (worker_params.mix_buffer_count >= 1) {
+        left.assign(mix_buffers.begin(), mix_buffers.begin() + sample_count);
+    }
+    std::vector<float> right = left;
+    if (worker_params.mix_buffer_count >= 2) {
+        right.assign(mix_buffers.begin() + sample_count, mix_buffers.begin() + 2 * sample_count);
+    }
+    if (worker_params.mix_buffer_count >= 6) {
+        const float* const center = &mix_buffers[2 * sample_count];
+        MixScaled(left.data(), center, DownmixVolume, sample_count);
+        MixScaled(right.data(), center, DownmixVolume, sample_count);
+        MixScaled(left.data(), &mix_buffers[4 * sample_count], DownmixVolume, sample_count);
+        MixScaled(right.data(), &mix_buffers[5 * sample_count], DownmixVolume, sample_count);
+    }
+
+    std::vector<s16> samples(sample_count * NumChannels);
+    ConvertToPCM16(samples.data(), left.data(), right.data(), sample_count);
+    stream->AppendBuffer(frame_count++, std::move(samples));
+
+    frame_callback();
+}
+
+void AudioRenderer::MixVoice(VoiceState& voice) {
+    const size_t sample_count = worker_params.sample_count;
+    const size_t mix_buffer_count = worker_params.mix_buffer_count;
+    if (mix_buffer_count == 0) {
+        return;
+    }
+
+    ResampleVoice(voice);
+
+    const size_t channel_count = std::min<size_t>(voice.info.channel_count, MaxVoiceChannels);
+    for (size_t channel = 0; channel < channel_count; ++channel) {
+        const float* const source = &voice_scratch[channel * sample_count];
+        const u32 resource_id = voice.info.voice_channel_resource_ids[channel];
+
+        if (resource_id >= voice_resources.size() || !voice_resources[resource_id].in_use) {
+            // Without volumes for the mix buffers, each channel goes to the buffer of its own
+            MixScaled(&mix_buffers[(channel % mix_buffer_count) * sample_count], source,
+                      voice.info.volume, sample_count);
+            continue;
+        }
+
+        const VoiceChannelResource& resource = voice_resources[resource_id];
+        for (size_t buffer = 0; buffer < std::min(mix_buffer_count, MaxMixBuffers); ++buffer) {
+            const float volume = voice.info.volume * resource.mix_volumes[buffer];
+            if (volume != 0.0f) {
+                MixScaled(&mix_buffers[buffer * sample_count], source, volume, sample_count);
+            }
+        }
+    }
+}
+
+void AudioRenderer::ResampleVoice(VoiceState& voice) {
+    const size_t sample_count = worker_params.sample_count;
+    const float pitch = voice.info.pitch > 0.0f ? static_cast<float>(voice.info.pitch) : 1.0f;
+    const double step = static_cast<double>(voice.info.sample_rate) * pitch /
+                        std::max<u32>(worker_params.sample_rate, 1);
+
+    // Each output frame is interpolated between the two input frames around its position. The
+    // positions depend on the pitch, so unlike the mixing this can't be vectorized on the host.
+    const size_t channel_count = std::min<size_t>(voice.info.channel_count, MaxVoiceChannels);
+    for (size_t i = 0; i < sample_count; ++i) {
+        const float fraction = static_cast<float>(voice.position);
+        for (size_t channel = 0; channel < channel_count; ++channel) {
+            const float current = voice.current_frame[channel];
+            voice_scratch[channel * sample_count + i] =
+                current + (voice.next_frame[channel] - current) * fraction;
+        }
+
+        voice.position += step;
+        while (voice.position >= 1.0) {
+            voice.position -= 1.0;
+            voice.current_frame = voice.next_frame;
+            if (!ReadFrame(voice, voice.next_frame)) {
+                // Fade to silence until the application queues more
+                voice.next_frame = {};
+            }
+        }
+    }
+}
+
+bool AudioRenderer::ReadFrame(VoiceState& voice, std::array<float, MaxVoiceChannels>& frame) {
+    const size_t channel_count = std::clamp<size_t>(voice.info.channel_count, 1, MaxVoiceChannels);
+    while (voice.IsPlaying()) {
+        if (voice.is_refresh_pending && !RefreshBuffer(voice)) {
+            return false;
+        }
+
+        if (voice.offset < voice.samples.size() / channel_count) {
+            const s16* const samples = &voice.samples[voice.offset * channel_count];
+            for (size_t channel = 0; channel < channel_count; ++channel) {
+                frame[channel] = samples[channel];
+            }
+            ++voice.offset;
+            ++voice.out_status.played_sample_count;
+            return true;
+        }
+
+        // The wave buffer was played to the end
+        const WaveBuffer& wave_buffer = voice.info.wave_buffer[voice.wave_index];
+        voice.offset = 0;
+        ++voice.out_status.wave_buffer_consumed;
+        if (wave_buffer.end_of_stream) {
+            voice.info.play_state = PlayState::Paused;
+        }
+        if (!wave_buffer.is_looping || voice.samples.empty()) {
+            voice.wave_buffer_queued[voice.wave_index] = false;
+            voice.wave_index = (voice.wave_index + 1) % voice.info.wave_buffer.size();
+            voice.is_refresh_pending = true;
+        }
+    }
+    return false;
+}
+
+bool AudioRenderer::RefreshBuffer(VoiceState& voice) {
+    if (!voice.wave_buffer_queued[voice.wave_index]) {
+        return false;
+    }
+
+    const WaveBufferData& buffer_data = voice.wave_buffer_data[voice.wave_index];
+    voice.samples.clear();
+    switch (voice.info.sample_format) {
+    case Codec::PcmFormat::Int16:
+        voice.samples.resize(buffer_data.data.size() / sizeof(s16));
+        std::memcpy(voice.samples.data(), buffer_data.data.data(),
+                    voice.samples.size() * sizeof(s16));
+        break;
+    case Codec::PcmFormat::Adpcm:
+        ASSERT_MSG(voice.info.channel_count <= 1, "ADPCM voices are mono");
+        if (!buffer_data.data.empty()) {
+            voice.samples = Codec::DecodeADPCM(
+                buffer_data.data.data(), buffer_data.data.size(), buffer_data.first_sample,
+                buffer_data.sample_count, voice.adpcm_coeff, voice.adpcm_history);
+        }
+        break;
+    default:
+        LOG_ERROR(Audio, "Unimplemented sample_format=%u",
+                  static_cast<u32>(voice.info.sample_format));
+        break;
+    }
+
+    voice.offset = 0;
+    voice.is_refresh_pending = false;
+    return true;
+}
+
+} // namespace AudioCore
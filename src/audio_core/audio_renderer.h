@@ -0,0 +1,282 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "audio_core/codec.h"
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/swap.h"
+#include "common/thread.h"
+
+namespace AudioCore {
+
+class Stream;
+
+/// Number of mix buffers a voice channel has volumes for
+constexpr size_t MaxMixBuffers = 24;
+/// Number of channels a voice has at most
+constexpr size_t MaxVoiceChannels = 6;
+
+enum class PlayState : u8 {
+    Started = 0,
+    Stopped = 1,
+    Paused = 2,
+};
+
+enum class MemoryPoolStates : u32 {
+    Invalid = 0x0,
+    Unknown = 0x1,
+    RequestDetach = 0x2,
+    Detached = 0x3,
+    RequestAttach = 0x4,
+    Attached = 0x5,
+    Released = 0x6,
+};
+
+struct AudioRendererParameter {
+    u32_le sample_rate;
+    u32_le sample_count;
+    u32_le mix_buffer_count;
+    u32_le unknown_c;
+    u32_le voice_count;
+    u32_le sink_count;
+    u32_le effect_count;
+    u32_le performance_frame_count;
+    u8 is_voice_drop_enabled;
+    u8 unknown_21;
+    u8 unknown_22;
+    u8 execution_mode;
+    u32_le splitter_count;
+    u32_le num_splitter_send_channels;
+    u32_le unknown_30;
+    u32_le revision;
+};
+static_assert(sizeof(AudioRendererParameter) == 52, "AudioRendererParameter is an invalid size");
+
+struct MemoryPoolEntry {
+    MemoryPoolStates state;
+    u32_le unknown_4;
+    u32_le unknown_8;
+    u32_le unknown_c;
+};
+static_assert(sizeof(MemoryPoolEntry) == 0x10, "MemoryPoolEntry has wrong size");
+
+struct MemoryPoolInfo {
+    u64_le pool_address;
+    u64_le pool_size;
+    MemoryPoolStates pool_state;
+    INSERT_PADDING_WORDS(3); // Unknown
+};
+static_assert(sizeof(MemoryPoolInfo) == 0x20, "MemoryPoolInfo has wrong size");
+
+struct BiquadFilter {
+    u8 enable;
+    INSERT_PADDING_BYTES(1);
+    std::array<s16_le, 3> numerator;
+    std::array<s16_le, 2> denominator;
+};
+static_assert(sizeof(BiquadFilter) == 0xc, "BiquadFilter has wrong size");
+
+struct WaveBuffer {
+    u64_le buffer_addr;
+    u64_le buffer_sz;
+    s32_le start_sample_offset;
+    s32_le end_sample_offset;
+    u8 is_looping;
+    u8 end_of_stream;
+    u8 sent_to_server;
+    INSERT_PADDING_BYTES(5);
+    u64 context_addr;
+    u64 context_sz;
+    INSERT_PADDING_BYTES(8);
+};
+static_assert(sizeof(WaveBuffer) == 0x38, "WaveBuffer has wrong size");
+
+struct VoiceChannelResource {
+    u32_le id;
+    std::array<float_le, MaxMixBuffers> mix_volumes;
+    u8 in_use;
+    INSERT_PADDING_BYTES(11);
+};
+static_assert(sizeof(VoiceChannelResource) == 0x70, "VoiceChannelResource has wrong size");
+
+struct VoiceInfo {
+    u32_le id;
+    u32_le node_id;
+    u8 is_new;
+    u8 is_in_use;
+    PlayState play_state;
+    Codec::PcmFormat sample_format;
+    u32_le sample_rate;
+    u32_le priority;
+    u32_le sorting_order;
+    u32_le channel_count;
+    float_le pitch;
+    float_le volume;
+    std::array<BiquadFilter, 2> biquad_filter;
+    u32_le wave_buffer_count;
+    u32_le wave_buffer_head;
+    INSERT_PADDING_WORDS(1);
+    u64_le additional_params_addr;
+    u64_le additional_params_sz;
+    u32_le mix_id;
+    u32_le splitter_info_id;
+    std::array<WaveBuffer, 4> wave_buffer;
+    std::array<u32_le, MaxVoiceChannels> voice_channel_resource_ids;
+    INSERT_PADDING_BYTES(24);
+};
+static_assert(sizeof(VoiceInfo) == 0x170, "VoiceInfo is wrong size");
+
+struct VoiceOutStatus {
+    u64_le played_sample_count;
+    u32_le wave_buffer_consumed;
+    u32_le voice_drops_count;
+};
+static_assert(sizeof(VoiceOutStatus) == 0x10, "VoiceOutStatus has wrong size");
+
+struct UpdateDataHeader {
+    UpdateDataHeader() {}
+
+    explicit UpdateDataHeader(const AudioRendererParameter& config) {
+        revision = Common::MakeMagic('R', 'E', 'V', '4'); // 5.1.0 Revision
+        behavior_size = 0xb0;
+        memory_pools_size = (config.effect_count + (config.voice_count * 4)) * 0x10;
+        voices_size = config.voice_count * 0x10;
+        voice_resource_size = 0x0;
+        effects_size = config.effect_count * 0x10;
+        mixes_size = 0x0;
+        sinks_size = config.sink_count * 0x20;
+        performance_manager_size = 0x10;
+        total_size = sizeof(UpdateDataHeader) + behavior_size + memory_pools_size + voices_size +
+                     effects_size + sinks_size + performance_manager_size;
+    }
+
+    u32_le revision;
+    u32_le behavior_size;
+    u32_le memory_pools_size;
+    u32_le voices_size;
+    u32_le voice_resource_size;
+    u32_le effects_size;
+    u32_le mixes_size;
+    u32_le sinks_size;
+    u32_le performance_manager_size;
+    INSERT_PADDING_WORDS(6);
+    u32_le total_size;
+};
+static_assert(sizeof(UpdateDataHeader) == 0x40, "UpdateDataHeader has wrong size");
+
+/**
+ * Audio renderer of audren:u. The voices an application sets up are decoded, resampled to the
+ * rate of the renderer and mixed into its mix buffers, which are played through a Stream.
+ *
+ * Frames are rendered on a thread of their own, which CoreTiming wakes up every audio frame. It
+ * only renders while the host has few frames left to play, and hands every rendered frame to the
+ * frame callback, so applications that time themselves by the renderer run at the host's pace.
+ */
+class AudioRenderer final {
+public:
+    /**
+     * @param params Configuration the application opened the renderer with.
+     * @param frame_callback Called on the audio thread whenever a frame was rendered.
+     */
+    AudioRenderer(AudioRendererParameter params, std::function<void()> frame_callback);
+    ~AudioRenderer();
+
+    /// Applies the voice and memory pool updates of the application and returns their status.
+    std::vector<u8> UpdateAudioRenderer(const std::vector<u8>& input_params);
+
+    void Start();
+    void Stop();
+    bool IsStarted() const;
+
+    u32 GetSampleRate() const;
+    u32 GetSampleCount() const;
+    u32 GetMixBufferCount() const;
+
+    /// Wakes up the audio thread, to be called every audio frame of emulated time.
+    void WakeUp();
+
+private:
+    /// Guest data of a wave buffer, copied when the application sends it, as only the CPU thread
+    /// can read guest memory
+    struct WaveBufferData {
+        /// PCM16 frames to play, or the ADPCM frames from the one holding the first sample
+        std::vector<u8> data;
+        /// ADPCM samples to skip in the first frame, and how many samples to decode
+        size_t first_sample = 0;
+        size_t sample_count = 0;
+    };
+
+    struct VoiceState {
+        VoiceInfo info{};
+        VoiceOutStatus out_status{};
+        bool is_in_use = false;
+
+        /// Index of the wave buffer being played
+        u32 wave_index = 0;
+        /// Wave buffers sent by the application that haven't been played to the end yet
+        std::array<bool, 4> wave_buffer_queued{};
+        std::array<WaveBufferData, 4> wave_buffer_data{};
+        Codec::ADPCM_Coeff adpcm_coeff{};
+        bool is_refresh_pending = true;
+
+        /// Decoded frames of the wave buffer being played, interleaved, and how many were read
+        std::vector<s16> samples;
+        size_t offset = 0;
+        Codec::ADPCM_History adpcm_history{};
+
+        /// The frames between which the next output frame is interpolated, and its position
+        std::array<float, MaxVoiceChannels> current_frame{};
+        std::array<float, MaxVoiceChannels> next_frame{};
+        double position = 0.0;
+
+        bool IsPlaying() const;
+        /// Copies a new VoiceInfo from the application, along with the data of its new wave
+        /// buffers. Called on the CPU thread.
+        void Update(const VoiceInfo& new_info);
+        /// Copies the samples of a wave buffer from guest memory.
+        void CopyWaveBuffer(size_t index);
+    };
+
+    void RenderThread();
+    /// Renders the next frame and queues it to the stream.
+    void RenderFrame();
+    /// Mixes a voice into the mix buffers.
+    void MixVoice(VoiceState& voice);
+    /// Resamples the next frames of a voice into voice_scratch, one channel after the other.
+    void ResampleVoice(VoiceState& voice);
+    /// Reads the next frame of a voice. Returns false if it has none queued.
+    bool ReadFrame(VoiceState& voice, std::array<float, MaxVoiceChannels>& frame);
+    /// Decodes the copied wave buffer of a voice that is to be played next.
+    bool RefreshBuffer(VoiceState& voice);
+
+    AudioRendererParameter worker_params;
+    std::function<void()> frame_callback;
+
+    /// Guards the voices from the application's updates while a frame is rendered
+    std::mutex state_mutex;
+    std::vector<VoiceState> voices;
+    std::vector<VoiceChannelResource> voice_resources;
+    std::atomic<bool> is_started{false};
+
+    /// Mix buffers, one after the other, and the scratch a voice is resampled into
+    std::vector<float> mix_buffers;
+    std::vector<float> voice_scratch;
+    u64 frame_count = 0;
+
+    std::unique_ptr<Stream> stream;
+    std::thread render_thread;
+    Common::Event wake_event;
+    std::atomic<bool> stop_thread{false};
+};
+
+} // namespace AudioCore
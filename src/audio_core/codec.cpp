@@ -0,0 +1,50 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/codec.h"
+
+namespace AudioCore::Codec {
+
+std::vector<s16> DecodeADPCM(const u8* data, size_t size, size_t first_sample,
+                             size_t sample_count, const ADPCM_Coeff& coeff,
+                             ADPCM_History& history) {
+    std::vector<s16> samples;
+    samples.reserve(sample_count);
+
+    s32 yn1 = history[0];
+    s32 yn2 = history[1];
+    for (size_t frame = 0; frame * ADPCM_FRAME_SIZE < size && samples.size() < sample_count;
+         ++frame) {
+        const u8* const frame_data = data + frame * ADPCM_FRAME_SIZE;
+        const size_t frame_size = std::min(ADPCM_FRAME_SIZE, size - frame * ADPCM_FRAME_SIZE);
+
+        const u8 header = frame_data[0];
+        const s32 scale = 1 << (header & 0xF);
+        const s32 coef1 = coeff[((header >> 4) & 0x7) * 2];
+        const s32 coef2 = coeff[((header >> 4) & 0x7) * 2 + 1];
+
+        const size_t end = std::min(ADPCM_SAMPLES_PER_FRAME, (frame_size - 1) * 2);
+        for (size_t i = 0; i < end && samples.size() < sample_count; ++i) {
+            const u8 byte = frame_data[1 + i / 2];
+            // The high nibble holds the first of the two samples, both are signed
+            const s32 nibble = static_cast<s8>(i % 2 == 0 ? byte & 0xF0 : byte << 4) >> 4;
+
+            const s32 value = ((nibble * scale) << 11) + 1024 + coef1 * yn1 + coef2 * yn2;
+            const s16 sample = static_cast<s16>(std::clamp(value >> 11, -32768, 32767));
+            // The samples before the first one still have to be decoded for the prediction
+            if (frame != 0 || i >= first_sample) {
+                samples.push_back(sample);
+            }
+
+            yn2 = yn1;
+            yn1 = sample;
+        }
+    }
+
+    history = {static_cast<s16>(yn1), static_cast<s16>(yn2)};
+    return samples;
+}
+
+} // namespace AudioCore::Codec
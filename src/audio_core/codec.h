@@ -0,0 +1,49 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace AudioCore::Codec {
+
+/// Sample formats of the buffers played by the audio renderer
+enum class PcmFormat : u8 {
+    Invalid = 0,
+    Int8 = 1,
+    Int16 = 2,
+    Int24 = 3,
+    Int32 = 4,
+    PcmFloat = 5,
+    Adpcm = 6,
+};
+
+/// Eight pairs of prediction coefficients, the predictor of each ADPCM frame picks one of them
+using ADPCM_Coeff = std::array<s16, 16>;
+
+/// Two samples before the next one to decode, as they are carried over between buffers
+using ADPCM_History = std::array<s16, 2>;
+
+/// ADPCM frames are a header byte followed by 14 samples of four bits
+constexpr size_t ADPCM_FRAME_SIZE = 8;
+constexpr size_t ADPCM_SAMPLES_PER_FRAME = 14;
+
+/**
+ * Decodes mono DSP ADPCM.
+ * @param data ADPCM frames, starting at the frame that holds the first sample to decode.
+ * @param size Size of the frames in bytes.
+ * @param first_sample Index of the first sample to decode within the first frame.
+ * @param sample_count Number of samples to decode.
+ * @param coeff Prediction coefficients of the stream.
+ * @param history Previous two samples, updated to the last two decoded ones.
+ * @returns The decoded samples, fewer than sample_count if the frames ran out.
+ */
+std::vector<s16> DecodeADPCM(const u8* data, size_t size, size_t first_sample,
+                             size_t sample_count, const ADPCM_Coeff& coeff,
+                             ADPCM_History& history);
+
+} // namespace AudioCore::Codec
@@ -0,0 +1,96 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/mix_kernels.h"
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+
+namespace AudioCore {
+
+namespace {
+
+void MixScaledGeneric(float* dest, const float* src, float volume, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        dest[i] += src[i] * volume;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// GCC and Clang only emit AVX2 in functions that ask for it, MSVC emits it anywhere.
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+void MixScaledSSE2(float* dest, const float* src, float volume, size_t count) {
+    const __m128 scale = _mm_set1_ps(volume);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128 mixed = _mm_add_ps(_mm_loadu_ps(dest + i),
+                                        _mm_mul_ps(_mm_loadu_ps(src + i), scale));
+        _mm_storeu_ps(dest + i, mixed);
+    }
+    MixScaledGeneric(dest + i, src + i, volume, count - i);
+}
+
+TARGET_AVX2 void MixScaledAVX2(float* dest, const float* src, float volume, size_t count) {
+    const __m256 scale = _mm256_set1_ps(volume);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 mixed = _mm256_add_ps(_mm256_loadu_ps(dest + i),
+                                           _mm256_mul_ps(_mm256_loadu_ps(src + i), scale));
+        _mm256_storeu_ps(dest + i, mixed);
+    }
+    MixScaledGeneric(dest + i, src + i, volume, count - i);
+}
+
+#undef TARGET_AVX2
+
+#endif
+
+using MixScaledFn = void (*)(float*, const float*, float, size_t);
+
+MixScaledFn SelectMixScaled() {
+#ifdef ARCHITECTURE_x86_64
+    return Common::GetCPUCaps().avx2 ? &MixScaledAVX2 : &MixScaledSSE2;
+#else
+    return &MixScaledGeneric;
+#endif
+}
+
+s16 ClampToPCM16(float sample) {
+    return static_cast<s16>(std::clamp(sample, -32768.0f, 32767.0f));
+}
+
+} // Anonymous namespace
+
+void MixScaled(float* dest, const float* src, float volume, size_t count) {
+    static const MixScaledFn mix_scaled = SelectMixScaled();
+    mix_scaled(dest, src, volume, count);
+}
+
+void ConvertToPCM16(s16* dest, const float* left, const float* right, size_t count) {
+    size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    // SSE2 is part of x86-64, and the conversion and packing already saturate
+    for (; i + 4 <= count; i += 4) {
+        const __m128i l = _mm_cvtps_epi32(_mm_loadu_ps(left + i));
+        const __m128i r = _mm_cvtps_epi32(_mm_loadu_ps(right + i));
+        const __m128i interleaved =
+            _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i * 2), interleaved);
+    }
+#endif
+    for (; i < count; ++i) {
+        dest[i * 2] = ClampToPCM16(left[i]);
+        dest[i * 2 + 1] = ClampToPCM16(right[i]);
+    }
+}
+
+} // namespace AudioCore
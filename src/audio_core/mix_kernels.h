@@ -0,0 +1,23 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/**
+ * Inner loops of the audio renderer. They pick the widest vector instructions the host supports
+ * the first time they are used.
+ */
+
+/// Adds the samples of src, multiplied by volume, to the ones of dest.
+void MixScaled(float* dest, const float* src, float volume, size_t count);
+
+/// Interleaves two channels into stereo PCM16, saturating the samples that are out of range.
+void ConvertToPCM16(s16* dest, const float* left, const float* right, size_t count);
+
+} // namespace AudioCore
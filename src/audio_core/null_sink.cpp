@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/null_sink.h"
+
+namespace AudioCore {
+
+NullSink::NullSink(u32 sample_rate) : sample_rate(sample_rate), drained_until(Clock::now()) {}
+
+u32 NullSink::GetSampleRate() const {
+    return sample_rate;
+}
+
+size_t NullSink::EnqueueSamples(const s16* samples, size_t frame_count) {
+    Drain();
+    queued_frames += frame_count;
+    return frame_count;
+}
+
+size_t NullSink::SamplesInQueue() const {
+    Drain();
+    return queued_frames;
+}
+
+void NullSink::Drain() const {
+    const Clock::time_point now = Clock::now();
+    if (queued_frames == 0) {
+        // Nothing plays while the queue is empty
+        drained_until = now;
+        return;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - drained_until);
+    const size_t played_frames = std::min<size_t>(
+        queued_frames, static_cast<size_t>(elapsed.count() * sample_rate / 1000000));
+    queued_frames -= played_frames;
+    // Only the time of the whole frames played is accounted for, the rest carries over
+    drained_until += std::chrono::microseconds(played_frames * 1000000 / sample_rate);
+}
+
+} // namespace AudioCore
@@ -0,0 +1,36 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include "audio_core/sink.h"
+
+namespace AudioCore {
+
+/**
+ * Sink that plays nothing. It still consumes its queue at the sample rate, as a real device
+ * would, so that the audio keeps the same cadence with and without a host audio device.
+ */
+class NullSink final : public Sink {
+public:
+    explicit NullSink(u32 sample_rate);
+    ~NullSink() override = default;
+
+    u32 GetSampleRate() const override;
+    size_t EnqueueSamples(const s16* samples, size_t frame_count) override;
+    size_t SamplesInQueue() const override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /// Takes out of the queue the frames that would have been played since the last call.
+    void Drain() const;
+
+    u32 sample_rate;
+    mutable size_t queued_frames = 0;
+    mutable Clock::time_point drained_until;
+};
+
+} // namespace AudioCore
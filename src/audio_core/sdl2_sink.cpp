@@ -0,0 +1,100 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <SDL.h>
+#include "audio_core/sdl2_sink.h"
+#include "common/logging/log.h"
+
+namespace AudioCore {
+
+SDL2Sink::SDL2Sink(u32 sample_rate, const std::string& device_id) : sample_rate(sample_rate) {
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        LOG_CRITICAL(Audio_Sink, "SDL_InitSubSystem audio failed: %s", SDL_GetError());
+        return;
+    }
+
+    SDL_AudioSpec desired{};
+    desired.freq = static_cast<int>(sample_rate);
+    desired.format = AUDIO_S16SYS;
+    desired.channels = static_cast<u8>(NumChannels);
+    desired.samples = 512;
+    desired.callback = &SDL2Sink::Callback;
+    desired.userdata = this;
+
+    const char* device_name = nullptr;
+    const std::vector<std::string> devices = ListDevices();
+    if (std::find(devices.begin(), devices.end(), device_id) != devices.end()) {
+        device_name = device_id.c_str();
+    }
+
+    // SDL2 converts the frames when the device can't play them at the sample rate they come in
+    SDL_AudioSpec obtained;
+    device = SDL_OpenAudioDevice(device_name, 0, &desired, &obtained, 0);
+    if (device == 0) {
+        LOG_CRITICAL(Audio_Sink, "SDL_OpenAudioDevice failed: %s", SDL_GetError());
+        return;
+    }
+
+    SDL_PauseAudioDevice(device, 0);
+}
+
+SDL2Sink::~SDL2Sink() {
+    if (device != 0) {
+        SDL_CloseAudioDevice(device);
+    }
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+bool SDL2Sink::IsOpen() const {
+    return device != 0;
+}
+
+u32 SDL2Sink::GetSampleRate() const {
+    return sample_rate;
+}
+
+size_t SDL2Sink::EnqueueSamples(const s16* samples, size_t frame_count) {
+    if (device == 0) {
+        return 0;
+    }
+    return queue.Push(samples, frame_count);
+}
+
+size_t SDL2Sink::SamplesInQueue() const {
+    return queue.Size();
+}
+
+std::vector<std::string> SDL2Sink::ListDevices() {
+    std::vector<std::string> devices;
+    if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0) {
+        LOG_CRITICAL(Audio_Sink, "SDL_InitSubSystem audio failed: %s", SDL_GetError());
+        return devices;
+    }
+
+    const int device_count = SDL_GetNumAudioDevices(0);
+    for (int i = 0; i < device_count; ++i) {
+        const char* name = SDL_GetAudioDeviceName(i, 0);
+        if (name != nullptr) {
+            devices.emplace_back(name);
+        }
+    }
+
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    return devices;
+}
+
+void SDL2Sink::Callback(void* sink, u8* buffer, int buffer_size) {
+    auto* const self = static_cast<SDL2Sink*>(sink);
+    const size_t frame_size = NumChannels * sizeof(s16);
+    const size_t frame_count = static_cast<size_t>(buffer_size) / frame_size;
+
+    const size_t popped = self->queue.Pop(reinterpret_cast<s16*>(buffer), frame_count);
+
+    // Play silence when the emulated audio fell behind
+    std::memset(buffer + popped * frame_size, 0, (frame_count - popped) * frame_size);
+}
+
+} // namespace AudioCore
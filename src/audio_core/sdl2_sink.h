@@ -0,0 +1,44 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "audio_core/sink.h"
+#include "common/ring_buffer.h"
+
+namespace AudioCore {
+
+class SDL2Sink final : public Sink {
+public:
+    /**
+     * Opens an SDL2 audio device, or the default one if device_id is empty, "auto" or not found.
+     * The device is left closed if opening it fails, see IsOpen.
+     */
+    SDL2Sink(u32 sample_rate, const std::string& device_id);
+    ~SDL2Sink() override;
+
+    /// Returns whether a device was opened. Nothing is consumed otherwise.
+    bool IsOpen() const;
+
+    u32 GetSampleRate() const override;
+    size_t EnqueueSamples(const s16* samples, size_t frame_count) override;
+    size_t SamplesInQueue() const override;
+
+    /// Returns the names of the audio output devices SDL2 knows of.
+    static std::vector<std::string> ListDevices();
+
+private:
+    /// Called by SDL2 on its audio thread to get the next frames to play.
+    static void Callback(void* sink, u8* buffer, int buffer_size);
+
+    u32 sample_rate;
+    u32 device = 0;
+
+    /// Frames from the emulation thread to the audio thread, about a third of a second at 48kHz
+    Common::RingBuffer<s16, NumChannels, 0x4000> queue;
+};
+
+} // namespace AudioCore
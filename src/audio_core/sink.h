@@ -0,0 +1,38 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/// Samples are interleaved stereo PCM16, and a frame is one sample of each channel.
+constexpr size_t NumChannels = 2;
+
+/**
+ * Host audio output. Frames are queued by the emulation thread and consumed by the host at its
+ * own pace, so how fast the queue drains is what paces the emulated audio.
+ */
+class Sink {
+public:
+    virtual ~Sink() = default;
+
+    /// Sample rate the frames are queued at, in frames per second.
+    virtual u32 GetSampleRate() const = 0;
+
+    /**
+     * Queues frames to be played.
+     * @param samples Interleaved samples of the frames, NumChannels for each of them.
+     * @param frame_count Number of frames to queue.
+     * @returns How many frames were queued, fewer than frame_count if the queue got full.
+     */
+    virtual size_t EnqueueSamples(const s16* samples, size_t frame_count) = 0;
+
+    /// Returns the number of frames queued that the host hasn't consumed yet.
+    virtual size_t SamplesInQueue() const = 0;
+};
+
+} // namespace AudioCore
@@ -0,0 +1,52 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "audio_core/null_sink.h"
+#include "audio_core/sink_details.h"
+#ifdef HAVE_SDL2
+#include "audio_core/sdl2_sink.h"
+#endif
+#include "common/logging/log.h"
+
+namespace AudioCore {
+
+// g_sink_details is ordered in terms of desirability, with the best choice at the top.
+const std::vector<SinkDetails> g_sink_details = {
+#ifdef HAVE_SDL2
+    {"sdl2",
+     [](u32 sample_rate, std::string device_id) -> std::unique_ptr<Sink> {
+         auto sink = std::make_unique<SDL2Sink>(sample_rate, device_id);
+         if (!sink->IsOpen()) {
+             return std::make_unique<NullSink>(sample_rate);
+         }
+         return sink;
+     },
+     &SDL2Sink::ListDevices},
+#endif
+    {"null",
+     [](u32 sample_rate, std::string) -> std::unique_ptr<Sink> {
+         return std::make_unique<NullSink>(sample_rate);
+     },
+     [] { return std::vector<std::string>{"null"}; }},
+};
+
+const SinkDetails& GetSinkDetails(const std::string& sink_id) {
+    auto iter = std::find_if(g_sink_details.begin(), g_sink_details.end(),
+                             [&sink_id](const auto& details) { return details.id == sink_id; });
+
+    if (sink_id == "auto" || iter == g_sink_details.end()) {
+        if (sink_id != "auto") {
+            LOG_ERROR(Audio, "AudioCore::GetSinkDetails given invalid sink_id %s", sink_id.c_str());
+        }
+        // Auto-select
+        iter = g_sink_details.begin();
+    }
+
+    return *iter;
+}
+
+} // namespace AudioCore
@@ -0,0 +1,35 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+class Sink;
+
+struct SinkDetails {
+    using FactoryFn = std::function<std::unique_ptr<Sink>(u32 sample_rate, std::string device_id)>;
+    using ListDevicesFn = std::function<std::vector<std::string>()>;
+
+    /// Name of the sink, as used in the settings.
+    const char* id;
+    /// Creates the sink. It falls back to a NullSink when the host device can't be opened.
+    FactoryFn factory;
+    /// Lists the devices the sink can output to.
+    ListDevicesFn list_devices;
+};
+
+/// The sinks this build supports, the preferred one first.
+extern const std::vector<SinkDetails> g_sink_details;
+
+/// Returns the details of a sink from its id, or of the preferred one for "auto" or unknown ids.
+const SinkDetails& GetSinkDetails(const std::string& sink_id);
+
+} // namespace AudioCore
@@ -0,0 +1,213 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/sink.h"
+#include "audio_core/stream.h"
+#include "core/memory.h"
+#include "core/settings.h"
+
+namespace AudioCore {
+
+namespace {
+
+constexpr size_t FrameSize = NumChannels * sizeof(s16);
+
+/// Milliseconds of audio kept queued in the sink. Buffers are released once they are played, so
+/// this is the latency of the audio as well as how long the application can stall for.
+constexpr u32 TargetLatencyMs = 40;
+
+/// Ratio the stretching slows the audio down by at most
+constexpr double MaxStretchRatio = 2.0;
+
+/// Below this ratio the frames are played as they are
+constexpr double MinStretchRatio = 1.01;
+
+} // Anonymous namespace
+
+Stream::Stream(std::unique_ptr<Sink> sink, bool enable_stretching,
+               ReleaseCallback release_callback)
+    : sink(std::move(sink)), enable_stretching(enable_stretching),
+      release_callback(std::move(release_callback)), last_update(std::chrono::steady_clock::now()) {
+    input_rate = this->sink->GetSampleRate();
+}
+
+Stream::~Stream() = default;
+
+void Stream::Play() {
+    playing = true;
+}
+
+void Stream::Stop() {
+    playing = false;
+    stretcher.Reset();
+}
+
+bool Stream::IsPlaying() const {
+    return playing;
+}
+
+void Stream::AppendBuffer(u64 tag, VAddr address, u64 size) {
+    const u64 frame_count = size / FrameSize;
+    buffers.push_back({tag, address, {}, frame_count, 0, 0});
+    frames_appended += frame_count;
+}
+
+void Stream::AppendBuffer(u64 tag, std::vector<s16> samples) {
+    const u64 frame_count = samples.size() / NumChannels;
+    buffers.push_back({tag, 0, std::move(samples), frame_count, 0, 0});
+    frames_appended += frame_count;
+}
+
+bool Stream::ContainsBuffer(u64 tag) const {
+    return std::any_of(buffers.begin(), buffers.end(),
+                       [tag](const Buffer& buffer) { return buffer.tag == tag; });
+}
+
+std::vector<u64> Stream::PopReleasedBuffers(size_t max_count) {
+    const size_t count = std::min(max_count, released_tags.size());
+    std::vector<u64> tags(released_tags.begin(), released_tags.begin() + count);
+    released_tags.erase(released_tags.begin(), released_tags.begin() + count);
+    return tags;
+}
+
+size_t Stream::GetQueueSize() const {
+    return buffers.size();
+}
+
+u64 Stream::GetPlayedSampleCount() const {
+    return played_sample_count;
+}
+
+void Stream::Update() {
+    const u64 pending_count = pending_frames.size() / NumChannels;
+    const u64 played_position = sink_position - pending_count - sink->SamplesInQueue();
+
+    // While fast forwarding, buffers are released as soon as they are queued, so that the
+    // application doesn't wait on the host playing them
+    const bool fast_forward = Settings::values.use_fast_forward;
+
+    bool released = false;
+    while (!buffers.empty()) {
+        const Buffer& buffer = buffers.front();
+        if (buffer.frames_queued != buffer.frame_count ||
+            (!fast_forward && buffer.sink_end > played_position)) {
+            break;
+        }
+        released_tags.push_back(buffer.tag);
+        played_sample_count += buffer.frame_count;
+        buffers.pop_front();
+        released = true;
+    }
+
+    UpdateStretchRatio();
+
+    if (playing && PushPendingFrames()) {
+        for (Buffer& buffer : buffers) {
+            if (buffer.frames_queued == buffer.frame_count) {
+                continue;
+            }
+            if (QueueFrames(buffer)) {
+                continue;
+            }
+            if (!fast_forward) {
+                break;
+            }
+            // The sink has no room for the rest of the buffer, which is dropped
+            buffer.frames_queued = buffer.frame_count;
+            buffer.sink_end = sink_position;
+        }
+    }
+
+    if (released) {
+        release_callback();
+    }
+}
+
+void Stream::UpdateStretchRatio() {
+    using namespace std::chrono;
+    const steady_clock::time_point now = steady_clock::now();
+    const double elapsed = duration_cast<duration<double>>(now - last_update).count();
+    last_update = now;
+    if (elapsed > 0.0) {
+        constexpr double smoothing = 0.05;
+        input_rate += (frames_appended / elapsed - input_rate) * smoothing;
+    }
+    frames_appended = 0;
+
+    // Only stretch when the application falls behind and the sink is about to run out. The
+    // frames it queues come in bursts, so the rate alone would have the audio wobble.
+    const u32 sample_rate = sink->GetSampleRate();
+    const size_t low_water = sample_rate * TargetLatencyMs / 1000 / 2;
+    double target_ratio = 1.0;
+    if (enable_stretching && playing && sink->SamplesInQueue() < low_water && input_rate > 0.0) {
+        target_ratio = std::clamp(sample_rate / input_rate, 1.0, MaxStretchRatio);
+    }
+    stretch_ratio += (target_ratio - stretch_ratio) * 0.1;
+}
+
+bool Stream::QueueFrames(Buffer& buffer) {
+    const size_t target = sink->GetSampleRate() * TargetLatencyMs / 1000;
+    const size_t queued = sink->SamplesInQueue();
+    if (!pending_frames.empty() || queued >= target) {
+        return false;
+    }
+
+    const bool stretch = stretch_ratio >= MinStretchRatio;
+    const double ratio = stretch ? stretch_ratio : 1.0;
+    const u64 room = std::max<u64>(1, static_cast<u64>((target - queued) / ratio));
+    const u64 count = std::min(room, buffer.frame_count - buffer.frames_queued);
+
+    if (count > 0) {
+        const VAddr address = buffer.address + buffer.frames_queued * FrameSize;
+        const size_t size = count * FrameSize;
+        const s16* samples;
+        if (!buffer.samples.empty()) {
+            samples = buffer.samples.data() + buffer.frames_queued * NumChannels;
+        } else {
+            samples = reinterpret_cast<const s16*>(Memory::GetContiguousPointer(address, size));
+        }
+        if (samples == nullptr) {
+            scratch.resize(count * NumChannels);
+            Memory::ReadBlock(address, scratch.data(), size);
+            samples = scratch.data();
+        }
+
+        if (stretch) {
+            stretched.clear();
+            stretcher.Process(samples, count, ratio, stretched);
+            PushToSink(stretched.data(), stretched.size() / NumChannels);
+        } else {
+            stretcher.Reset();
+            PushToSink(samples, count);
+        }
+        buffer.frames_queued += count;
+    }
+
+    if (buffer.frames_queued != buffer.frame_count) {
+        return false;
+    }
+    buffer.sink_end = sink_position;
+    return true;
+}
+
+void Stream::PushToSink(const s16* samples, size_t frame_count) {
+    // Anything pending has to go in first for the frames to stay in order
+    const size_t pushed = pending_frames.empty() ? sink->EnqueueSamples(samples, frame_count) : 0;
+    pending_frames.insert(pending_frames.end(), samples + pushed * NumChannels,
+                          samples + frame_count * NumChannels);
+    sink_position += frame_count;
+}
+
+bool Stream::PushPendingFrames() {
+    if (pending_frames.empty()) {
+        return true;
+    }
+    const size_t pending_count = pending_frames.size() / NumChannels;
+    const size_t pushed = sink->EnqueueSamples(pending_frames.data(), pending_count);
+    pending_frames.erase(pending_frames.begin(), pending_frames.begin() + pushed * NumChannels);
+    return pending_frames.empty();
+}
+
+} // namespace AudioCore
@@ -0,0 +1,123 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "audio_core/time_stretch.h"
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+class Sink;
+
+/**
+ * Plays queued buffers of audio through a sink. The frames of buffers in guest memory are copied
+ * straight from it into the sink, and each buffer is released once the host has played all of
+ * it, so the release cadence follows the host's playback.
+ */
+class Stream final {
+public:
+    using ReleaseCallback = std::function<void()>;
+
+    /**
+     * @param sink Sink to play the buffers through.
+     * @param enable_stretching Whether to stretch the audio when the application doesn't queue
+     *                          frames as fast as the host plays them.
+     * @param release_callback Called whenever buffers were released.
+     */
+    Stream(std::unique_ptr<Sink> sink, bool enable_stretching, ReleaseCallback release_callback);
+    ~Stream();
+
+    void Play();
+    void Stop();
+    bool IsPlaying() const;
+
+    /**
+     * Queues a buffer of guest memory. It has to stay untouched until it is released.
+     * @param tag Value that identifies the buffer to the application.
+     * @param address Guest address of the interleaved stereo PCM16 frames of the buffer.
+     * @param size Size of the frames in bytes.
+     */
+    void AppendBuffer(u64 tag, VAddr address, u64 size);
+
+    /**
+     * Queues a buffer of frames made on the host, which the stream keeps until it is released.
+     * @param tag Value that identifies the buffer.
+     * @param samples Interleaved stereo PCM16 frames of the buffer.
+     */
+    void AppendBuffer(u64 tag, std::vector<s16> samples);
+
+    /// Returns whether the buffer with a tag is queued and hasn't been released yet.
+    bool ContainsBuffer(u64 tag) const;
+
+    /// Takes the tags of up to max_count buffers released since the last call, oldest first.
+    std::vector<u64> PopReleasedBuffers(size_t max_count);
+
+    /// Returns the number of buffers queued that haven't been released yet.
+    size_t GetQueueSize() const;
+
+    /// Returns the number of frames the host has played so far.
+    u64 GetPlayedSampleCount() const;
+
+    /**
+     * Moves frames from the queued buffers into the sink, up to the latency it is kept at, and
+     * releases the buffers the host finished playing. To be called periodically.
+     */
+    void Update();
+
+private:
+    struct Buffer {
+        u64 tag;
+        /// Guest address of the frames, unless they are held in samples
+        VAddr address;
+        std::vector<s16> samples;
+        u64 frame_count;
+        /// Number of frames of the buffer that were moved into the sink
+        u64 frames_queued;
+        /// Sink position right after the last frame of the buffer, once all of it was queued
+        u64 sink_end;
+    };
+
+    /// Eases the stretch ratio towards what makes up for the frames the application falls short of
+    void UpdateStretchRatio();
+    /// Moves frames from a buffer into the sink, returns whether all of them went in.
+    bool QueueFrames(Buffer& buffer);
+    /// Pushes frames to the sink, keeping the ones it has no room for in pending_frames.
+    void PushToSink(const s16* samples, size_t frame_count);
+    /// Pushes the frames still pending from an earlier call, returns whether all of them went in.
+    bool PushPendingFrames();
+
+    std::unique_ptr<Sink> sink;
+    bool enable_stretching;
+    ReleaseCallback release_callback;
+    bool playing = false;
+
+    /// Buffers not released yet, the ones with frames still to be queued at the back
+    std::deque<Buffer> buffers;
+    std::deque<u64> released_tags;
+    u64 played_sample_count = 0;
+
+    /// Number of frames handed to the sink so far, its playback position is derived from it
+    u64 sink_position = 0;
+    /// Frames the sink had no room for, pushed before any new ones
+    std::vector<s16> pending_frames;
+    /// Frames copied out of guest memory that isn't contiguous on the host
+    std::vector<s16> scratch;
+
+    TimeStretcher stretcher;
+    std::vector<s16> stretched;
+    /// Output frames for each frame in, eased towards its target to avoid audible steps
+    double stretch_ratio = 1.0;
+    /// Frames the application queues per second of host time, averaged over the last updates
+    double input_rate = 0.0;
+    u64 frames_appended = 0;
+    std::chrono::steady_clock::time_point last_update;
+};
+
+} // namespace AudioCore
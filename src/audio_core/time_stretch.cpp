@@ -0,0 +1,42 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "audio_core/time_stretch.h"
+
+namespace AudioCore {
+
+void TimeStretcher::Process(const s16* samples, size_t frame_count, double ratio,
+                            std::vector<s16>& output) {
+    if (frame_count == 0) {
+        return;
+    }
+    const double step = 1.0 / std::max(ratio, 1.0);
+
+    // Frame 0 is previous_frame and frame i is the i-1th of the input
+    const auto sample = [&](size_t frame, size_t channel) -> double {
+        return frame == 0 ? previous_frame[channel] : samples[(frame - 1) * NumChannels + channel];
+    };
+
+    output.reserve(output.size() + static_cast<size_t>(frame_count * ratio + 1) * NumChannels);
+    for (; position <= frame_count; position += step) {
+        const size_t frame = static_cast<size_t>(position);
+        const double fraction = position - frame;
+        for (size_t channel = 0; channel < NumChannels; ++channel) {
+            const double first = sample(frame, channel);
+            const double second = frame < frame_count ? sample(frame + 1, channel) : first;
+            output.push_back(static_cast<s16>(first + (second - first) * fraction));
+        }
+    }
+
+    position -= frame_count;
+    std::copy_n(samples + (frame_count - 1) * NumChannels, NumChannels, previous_frame.begin());
+}
+
+void TimeStretcher::Reset() {
+    previous_frame.fill(0);
+    position = 1.0;
+}
+
+} // namespace AudioCore
@@ -0,0 +1,41 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "audio_core/sink.h"
+#include "common/common_types.h"
+
+namespace AudioCore {
+
+/**
+ * Stretches audio to fill in for emulation running slower than the host plays. It resamples the
+ * frames with linear interpolation, so the pitch drops along with the speed; that is far less
+ * jarring than the gaps the host would otherwise fill with silence.
+ */
+class TimeStretcher {
+public:
+    /**
+     * Stretches frames, keeping the position between them across calls.
+     * @param samples Interleaved samples of the frames to stretch.
+     * @param frame_count Number of frames to stretch.
+     * @param ratio Number of frames to output for each frame in, at least 1.
+     * @param output Where the stretched frames are appended to.
+     */
+    void Process(const s16* samples, size_t frame_count, double ratio, std::vector<s16>& output);
+
+    /// Forgets the previous frames, for when the next ones don't follow on from them.
+    void Reset();
+
+private:
+    /// Last frame of the previous call, interpolated from towards the first one of the next
+    std::array<s16, NumChannels> previous_frame{};
+    /// Position of the next output frame, in frames after previous_frame
+    double position = 1.0;
+};
+
+} // namespace AudioCore
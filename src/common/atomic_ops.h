@@ -0,0 +1,59 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+/**
+ * Atomically replaces the value at pointer with desired if it currently holds expected.
+ * @return true if the exchange took place.
+ */
+inline bool AtomicCompareAndSwap(volatile u8* pointer, u8 desired, u8 expected) {
+#ifdef _MSC_VER
+    const u8 result = _InterlockedCompareExchange8(reinterpret_cast<volatile char*>(pointer),
+                                                   desired, expected);
+    return result == expected;
+#else
+    return __sync_bool_compare_and_swap(pointer, expected, desired);
+#endif
+}
+
+inline bool AtomicCompareAndSwap(volatile u16* pointer, u16 desired, u16 expected) {
+#ifdef _MSC_VER
+    const u16 result = _InterlockedCompareExchange16(reinterpret_cast<volatile short*>(pointer),
+                                                     desired, expected);
+    return result == expected;
+#else
+    return __sync_bool_compare_and_swap(pointer, expected, desired);
+#endif
+}
+
+inline bool AtomicCompareAndSwap(volatile u32* pointer, u32 desired, u32 expected) {
+#ifdef _MSC_VER
+    const u32 result = _InterlockedCompareExchange(reinterpret_cast<volatile long*>(pointer),
+                                                   desired, expected);
+    return result == expected;
+#else
+    return __sync_bool_compare_and_swap(pointer, expected, desired);
+#endif
+}
+
+inline bool AtomicCompareAndSwap(volatile u64* pointer, u64 desired, u64 expected) {
+#ifdef _MSC_VER
+    const u64 result = _InterlockedCompareExchange64(reinterpret_cast<volatile __int64*>(pointer),
+                                                     desired, expected);
+    return result == expected;
+#else
+    return __sync_bool_compare_and_swap(pointer, expected, desired);
+#endif
+}
+
+} // namespace Common
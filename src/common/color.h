@@ -4,10 +4,18 @@
 
 #pragma once
 
+#include <cstddef>
+#include <utility>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "common/vector_math.h"
 
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 namespace Color {
 
 /// Convert a 1-bit color component to 8 bit
@@ -110,6 +118,40 @@ inline const Math::Vec4<u8> DecodeRGBA4(const u8* bytes) {
             Convert4To8((pixel >> 4) & 0xF), Convert4To8(pixel & 0xF)};
 }
 
+/**
+ * Convert a row of colors stored in RGBA8 byte order, with red in the first byte, to 32-bit words
+ * holding 0xAARRGGBB, the layout Qt and most host pixel formats expect.
+ * @param source Pointer to the encoded source colors
+ * @param dest Destination pointer to store the converted colors
+ * @param count Number of colors in the row
+ */
+inline void ConvertRGBA8ToARGB32(const u8* source, u32* dest, size_t count) {
+    size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    // Read as little endian words the colors are 0xAABBGGRR, so only red and blue swap places
+    const __m128i alpha_green = _mm_set1_epi32(static_cast<int>(0xFF00FF00));
+    for (; i + 4 <= count; i += 4) {
+        const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 4));
+        const __m128i red_blue = _mm_andnot_si128(alpha_green, colors);
+        const __m128i swapped =
+            _mm_or_si128(_mm_slli_epi32(red_blue, 16), _mm_srli_epi32(red_blue, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i),
+                         _mm_or_si128(_mm_and_si128(colors, alpha_green), swapped));
+    }
+#elif defined(__aarch64__)
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t colors = vld4q_u8(source + i * 4);
+        std::swap(colors.val[0], colors.val[2]);
+        vst4q_u8(reinterpret_cast<u8*>(dest + i), colors);
+    }
+#endif
+    for (; i < count; ++i) {
+        const u8* bytes = source + i * 4;
+        dest[i] =
+            (static_cast<u32>(bytes[3]) << 24) | (bytes[0] << 16) | (bytes[1] << 8) | bytes[2];
+    }
+}
+
 /**
  * Decode a depth value stored in D16 format
  * @param bytes Pointer to encoded source value
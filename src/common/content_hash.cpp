@@ -0,0 +1,342 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/cityhash.h"
+#include "common/content_hash.h"
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+constexpr u64 PRIME32_1 = 0x9E3779B1;
+constexpr u64 PRIME32_2 = 0x85EBCA77;
+constexpr u64 PRIME32_3 = 0xC2B2AE3D;
+constexpr u64 PRIME64_1 = 0x9E3779B185EBCA87;
+constexpr u64 PRIME64_2 = 0xC2B2AE3D27D4EB4F;
+constexpr u64 PRIME64_3 = 0x165667B19E3779F9;
+constexpr u64 PRIME64_4 = 0x85EBCA77C2B2AE63;
+constexpr u64 PRIME64_5 = 0x27D4EB2F165667C5;
+
+constexpr size_t StripeSize = 64;
+constexpr size_t NumLanes = 8;
+
+constexpr u64 SplitMix64(u64& state) {
+    u64 z = (state += 0x9E3779B97F4A7C15);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+    return z ^ (z >> 31);
+}
+
+template <size_t Size>
+constexpr std::array<u64, Size> MakeSecret() {
+    std::array<u64, Size> secret{};
+    u64 state = PRIME64_3;
+    for (size_t i = 0; i < Size; ++i) {
+        secret[i] = SplitMix64(state);
+    }
+    return secret;
+}
+
+u64 Read64(const u8* data) {
+    u64 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+u64 Mul128Fold64(u64 lhs, u64 rhs) {
+#ifdef _MSC_VER
+    u64 high;
+    const u64 low = _umul128(lhs, rhs, &high);
+    return low ^ high;
+#else
+    const unsigned __int128 product = static_cast<unsigned __int128>(lhs) * rhs;
+    return static_cast<u64>(product) ^ static_cast<u64>(product >> 64);
+#endif
+}
+
+u64 Avalanche(u64 hash) {
+    hash ^= hash >> 37;
+    hash *= 0x165667919E3779F9;
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * Mixes stripes of input into the lanes, with the keys starting at keys for the first stripe and
+ * moving one lane further for every stripe. Each lane gets the input of its neighbour added, and
+ * the product of the two halves of its input mixed with its key.
+ */
+[[maybe_unused]] void AccumulateGeneric(u64* lanes, const u8* input, size_t num_stripes,
+                                         const u64* keys) {
+    for (size_t stripe = 0; stripe < num_stripes; ++stripe) {
+        for (size_t lane = 0; lane < NumLanes; ++lane) {
+            const u64 data = Read64(input + lane * 8);
+            const u64 data_key = data ^ keys[stripe + lane];
+            lanes[lane ^ 1] += data;
+            lanes[lane] += (data_key & 0xFFFFFFFF) * (data_key >> 32);
+        }
+        input += StripeSize;
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// GCC and Clang only emit AVX2 in functions that ask for it, MSVC emits it anywhere.
+#ifdef _MSC_VER
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+void AccumulateSSE2(u64* lanes, const u8* input, size_t num_stripes, const u64* keys) {
+    __m128i* const acc = reinterpret_cast<__m128i*>(lanes);
+    __m128i values[NumLanes / 2];
+    for (size_t i = 0; i < NumLanes / 2; ++i) {
+        values[i] = _mm_loadu_si128(acc + i);
+    }
+    for (size_t stripe = 0; stripe < num_stripes; ++stripe) {
+        for (size_t i = 0; i < NumLanes / 2; ++i) {
+            const __m128i data =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i * 16));
+            const __m128i key =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + stripe + i * 2));
+            const __m128i data_key = _mm_xor_si128(data, key);
+            // _mm_mul_epu32 multiplies the low halves, so the high halves are moved down
+            const __m128i data_key_high = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+            const __m128i product = _mm_mul_epu32(data_key, data_key_high);
+            const __m128i data_swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+            values[i] = _mm_add_epi64(product, _mm_add_epi64(values[i], data_swapped));
+        }
+        input += StripeSize;
+    }
+    for (size_t i = 0; i < NumLanes / 2; ++i) {
+        _mm_storeu_si128(acc + i, values[i]);
+    }
+}
+
+/// Mixes the half of a stripe at input into four lanes.
+TARGET_AVX2 __m256i AccumulateHalfAVX2(__m256i lanes, const u8* input, const u64* keys) {
+    const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+    const __m256i key = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    const __m256i data_key = _mm256_xor_si256(data, key);
+    const __m256i data_key_high = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+    const __m256i product = _mm256_mul_epu32(data_key, data_key_high);
+    const __m256i data_swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+    return _mm256_add_epi64(product, _mm256_add_epi64(lanes, data_swapped));
+}
+
+TARGET_AVX2 void AccumulateAVX2(u64* lanes, const u8* input, size_t num_stripes,
+                                const u64* keys) {
+    __m256i* const acc = reinterpret_cast<__m256i*>(lanes);
+    __m256i low = _mm256_loadu_si256(acc);
+    __m256i high = _mm256_loadu_si256(acc + 1);
+    for (size_t stripe = 0; stripe < num_stripes; ++stripe) {
+        low = AccumulateHalfAVX2(low, input, keys + stripe);
+        high = AccumulateHalfAVX2(high, input + 32, keys + stripe + 4);
+        input += StripeSize;
+    }
+    _mm256_storeu_si256(acc, low);
+    _mm256_storeu_si256(acc + 1, high);
+}
+
+#undef TARGET_AVX2
+
+#endif
+
+using AccumulateFn = void (*)(u64*, const u8*, size_t, const u64*);
+
+AccumulateFn SelectAccumulate() {
+#ifdef ARCHITECTURE_x86_64
+    return GetCPUCaps().avx2 ? &AccumulateAVX2 : &AccumulateSSE2;
+#else
+    return &AccumulateGeneric;
+#endif
+}
+
+void Accumulate(u64* lanes, const u8* input, size_t num_stripes, const u64* keys) {
+    static const AccumulateFn accumulate = SelectAccumulate();
+    accumulate(lanes, input, num_stripes, keys);
+}
+
+/// Keeps the lanes from saturating with input, once every block
+void Scramble(u64* lanes, const u64* keys) {
+    for (size_t lane = 0; lane < NumLanes; ++lane) {
+        u64 value = lanes[lane];
+        value ^= value >> 47;
+        value ^= keys[lane];
+        lanes[lane] = value * PRIME32_1;
+    }
+}
+
+using Lanes = std::array<u64, NumLanes>;
+
+constexpr size_t StripesPerBlock = 16;
+/// Keys of the stripes of a block, which overlap each other, followed by the keys of the scramble
+constexpr size_t SecretSize = StripesPerBlock + NumLanes;
+constexpr std::array<u64, SecretSize> BaseSecret = MakeSecret<SecretSize>();
+
+constexpr Lanes InitialLanes{
+    {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1}};
+
+void SeedSecret(u64 seed, u64* secret) {
+    for (size_t i = 0; i < SecretSize; ++i) {
+        secret[i] = i % 2 == 0 ? BaseSecret[i] + seed : BaseSecret[i] - seed;
+    }
+}
+
+u64 ShortHash64(const u8* input, size_t len, u64 seed) {
+    const char* const data = reinterpret_cast<const char*>(input);
+    return seed == 0 ? CityHash64(data, len) : CityHash64WithSeed(data, len, seed);
+}
+
+u128 ShortHash128(const u8* input, size_t len, u64 seed) {
+    const uint128 hash = CityHash128WithSeed(reinterpret_cast<const char*>(input), len,
+                                             {seed, ~seed});
+    return {Uint128Low64(hash), Uint128High64(hash)};
+}
+
+/// Mixes the last 1 to StripeSize bytes of the input into the lanes. They are padded with zeroes,
+/// which the length mixed into the digest tells apart.
+void AccumulateTail(Lanes& lanes, const u8* input, size_t len, const u64* keys) {
+    std::array<u8, StripeSize> tail{};
+    std::memcpy(tail.data(), input, len);
+    Accumulate(lanes.data(), tail.data(), 1, keys);
+}
+
+u64 MergeLanes(const Lanes& lanes, const u64* keys, u64 start) {
+    u64 result = start;
+    for (size_t i = 0; i < NumLanes; i += 2) {
+        result += Mul128Fold64(lanes[i] ^ keys[i], lanes[i + 1] ^ keys[i + 1]);
+    }
+    return Avalanche(result);
+}
+
+u64 Digest64(const Lanes& lanes, const u64* secret, u64 len) {
+    return MergeLanes(lanes, secret + 3, len * PRIME64_1);
+}
+
+u128 Digest128(const Lanes& lanes, const u64* secret, u64 len) {
+    return {MergeLanes(lanes, secret + 3, len * PRIME64_1),
+            MergeLanes(lanes, secret + 13, ~(len * PRIME64_2))};
+}
+
+/// Returns the keys for a seed, which are put in seeded_secret unless the seed is 0
+const u64* GetSecret(u64 seed, std::array<u64, SecretSize>& seeded_secret) {
+    if (seed == 0) {
+        return BaseSecret.data();
+    }
+    SeedSecret(seed, seeded_secret.data());
+    return seeded_secret.data();
+}
+
+/// Mixes an input longer than a stripe into the lanes in one go, the way ContentHasher does
+Lanes HashLong(const u8* input, size_t len, const u64* secret) {
+    Lanes lanes = InitialLanes;
+    const size_t total_stripes = (len - 1) / StripeSize;
+    size_t num_stripes = total_stripes;
+    for (; num_stripes >= StripesPerBlock; num_stripes -= StripesPerBlock) {
+        Accumulate(lanes.data(), input, StripesPerBlock, secret);
+        Scramble(lanes.data(), secret + StripesPerBlock);
+        input += StripesPerBlock * StripeSize;
+    }
+    Accumulate(lanes.data(), input, num_stripes, secret);
+    input += num_stripes * StripeSize;
+    AccumulateTail(lanes, input, len - total_stripes * StripeSize, secret + num_stripes);
+    return lanes;
+}
+
+} // Anonymous namespace
+
+u64 ContentHash64(const void* data, size_t len, u64 seed) {
+    const u8* const input = static_cast<const u8*>(data);
+    if (len <= StripeSize) {
+        return ShortHash64(input, len, seed);
+    }
+    std::array<u64, SecretSize> seeded_secret;
+    const u64* const secret = GetSecret(seed, seeded_secret);
+    return Digest64(HashLong(input, len, secret), secret, len);
+}
+
+u128 ContentHash128(const void* data, size_t len, u64 seed) {
+    const u8* const input = static_cast<const u8*>(data);
+    if (len <= StripeSize) {
+        return ShortHash128(input, len, seed);
+    }
+    std::array<u64, SecretSize> seeded_secret;
+    const u64* const secret = GetSecret(seed, seeded_secret);
+    return Digest128(HashLong(input, len, secret), secret, len);
+}
+
+ContentHasher::ContentHasher(u64 seed) : seed(seed), lanes(InitialLanes) {
+    static_assert(ContentHasher::SecretSize == Common::SecretSize, "Secret sizes don't match");
+    SeedSecret(seed, secret.data());
+}
+
+void ContentHasher::Update(const void* data, size_t len) {
+    const u8* input = static_cast<const u8*>(data);
+    total_len += len;
+    if (buffered + len <= StripeSize) {
+        std::memcpy(buffer.data() + buffered, input, len);
+        buffered += len;
+        return;
+    }
+
+    if (buffered != 0) {
+        const size_t fill = StripeSize - buffered;
+        std::memcpy(buffer.data() + buffered, input, fill);
+        ConsumeStripes(buffer.data(), 1);
+        input += fill;
+        len -= fill;
+    }
+
+    // At least one byte is left, and up to a whole stripe is kept for the digest
+    const size_t num_stripes = (len - 1) / StripeSize;
+    ConsumeStripes(input, num_stripes);
+    input += num_stripes * StripeSize;
+    len -= num_stripes * StripeSize;
+    std::memcpy(buffer.data(), input, len);
+    buffered = len;
+}
+
+void ContentHasher::ConsumeStripes(const u8* input, size_t num_stripes) {
+    while (num_stripes != 0) {
+        const size_t count = std::min(num_stripes, StripesPerBlock - stripe_in_block);
+        Accumulate(lanes.data(), input, count, secret.data() + stripe_in_block);
+        input += count * StripeSize;
+        num_stripes -= count;
+        stripe_in_block += count;
+        if (stripe_in_block == StripesPerBlock) {
+            Scramble(lanes.data(), secret.data() + StripesPerBlock);
+            stripe_in_block = 0;
+        }
+    }
+}
+
+u64 ContentHasher::Digest64() const {
+    if (total_len <= StripeSize) {
+        return ShortHash64(buffer.data(), buffered, seed);
+    }
+    Lanes final_lanes = lanes;
+    AccumulateTail(final_lanes, buffer.data(), buffered, secret.data() + stripe_in_block);
+    return Common::Digest64(final_lanes, secret.data(), total_len);
+}
+
+u128 ContentHasher::Digest128() const {
+    if (total_len <= StripeSize) {
+        return ShortHash128(buffer.data(), buffered, seed);
+    }
+    Lanes final_lanes = lanes;
+    AccumulateTail(final_lanes, buffer.data(), buffered, secret.data() + stripe_in_block);
+    return Common::Digest128(final_lanes, secret.data(), total_len);
+}
+
+} // namespace Common
@@ -0,0 +1,61 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Hash for the contents of large buffers, such as textures, vertex buffers and executable code,
+ * modelled on the long input loop of XXH3. Input is consumed in 64 byte stripes, each of which is
+ * mixed into eight 64-bit lanes with the widest vector instructions the host supports. Inputs of
+ * up to one stripe are hashed with CityHash instead.
+ *
+ * The resulting hashes are not those of xxHash, and may change between builds, so they must not
+ * be stored for later sessions unless the store is tagged with the build.
+ */
+
+/// Computes a 64-bit hash of a buffer.
+u64 ContentHash64(const void* data, size_t len, u64 seed = 0);
+
+/// Computes a 128-bit hash of a buffer, for keys that have to stay unique across many buffers.
+u128 ContentHash128(const void* data, size_t len, u64 seed = 0);
+
+/**
+ * Computes the hash of a buffer given in pieces. The digests equal ContentHash64 and
+ * ContentHash128 of all the pieces put together, however the input was split up.
+ */
+class ContentHasher {
+public:
+    explicit ContentHasher(u64 seed = 0);
+
+    void Update(const void* data, size_t len);
+
+    u64 Digest64() const;
+    u128 Digest128() const;
+
+private:
+    static constexpr size_t StripeSize = 64;
+    static constexpr size_t StripesPerBlock = 16;
+    static constexpr size_t SecretSize = StripesPerBlock + 8;
+
+    void ConsumeStripes(const u8* input, size_t num_stripes);
+
+    u64 seed;
+    std::array<u64, SecretSize> secret;
+    std::array<u64, 8> lanes;
+    size_t stripe_in_block = 0;
+    u64 total_len = 0;
+
+    /// Input that doesn't make a whole stripe yet. The last stripe is only consumed once more
+    /// input follows, so that there always is a tail for the digest.
+    std::array<u8, StripeSize> buffer;
+    size_t buffered = 0;
+};
+
+} // namespace Common
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/common_funcs.h"
 #include "common/common_paths.h"
@@ -36,6 +37,7 @@
 #include <cstring>
 #include <dirent.h>
 #include <pwd.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #endif
 
@@ -57,6 +59,7 @@
 #endif
 
 #include <algorithm>
+#include <limits>
 #include <sys/stat.h>
 
 #ifndef S_ISDIR
@@ -251,8 +254,8 @@ bool DeleteDir(const std::string& filename) {
 bool Rename(const std::string& srcFilename, const std::string& destFilename) {
     LOG_TRACE(Common_Filesystem, "%s --> %s", srcFilename.c_str(), destFilename.c_str());
 #ifdef _WIN32
-    if (_wrename(Common::UTF8ToUTF16W(srcFilename).c_str(),
-                 Common::UTF8ToUTF16W(destFilename).c_str()) == 0)
+    if (MoveFileExW(Common::UTF8ToUTF16W(srcFilename).c_str(),
+                    Common::UTF8ToUTF16W(destFilename).c_str(), MOVEFILE_REPLACE_EXISTING))
         return true;
 #else
     if (rename(srcFilename.c_str(), destFilename.c_str()) == 0)
@@ -888,4 +891,218 @@ bool IOFile::Resize(u64 size) {
     return m_good;
 }
 
+size_t IOFile::ReadAt(void* data, size_t length, u64 offset) const {
+    if (!IsOpen()) {
+        return 0;
+    }
+
+    u8* const output = static_cast<u8*>(data);
+    size_t total_read = 0;
+    while (total_read < length) {
+        const u64 position = offset + total_read;
+#ifdef _WIN32
+        const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk_size = static_cast<DWORD>(
+            std::min<size_t>(length - total_read, std::numeric_limits<DWORD>::max()));
+        DWORD bytes_read = 0;
+        if (!ReadFile(file_handle, output + total_read, chunk_size, &bytes_read, &overlapped) ||
+            bytes_read == 0) {
+            break;
+        }
+#else
+        const ssize_t bytes_read = pread(fileno(m_file), output + total_read, length - total_read,
+                                         static_cast<off_t>(position));
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read <= 0) {
+            break;
+        }
+#endif
+        total_read += static_cast<size_t>(bytes_read);
+    }
+    return total_read;
+}
+
+size_t IOFile::WriteAt(const void* data, size_t length, u64 offset) {
+    if (!IsOpen()) {
+        m_good = false;
+        return 0;
+    }
+
+    const u8* const input = static_cast<const u8*>(data);
+    size_t total_written = 0;
+    while (total_written < length) {
+        const u64 position = offset + total_written;
+#ifdef _WIN32
+        const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(position);
+        overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+        const DWORD chunk_size = static_cast<DWORD>(
+            std::min<size_t>(length - total_written, std::numeric_limits<DWORD>::max()));
+        DWORD bytes_written = 0;
+        if (!WriteFile(file_handle, input + total_written, chunk_size, &bytes_written,
+                       &overlapped) ||
+            bytes_written == 0) {
+            break;
+        }
+#else
+        const ssize_t bytes_written =
+            pwrite(fileno(m_file), input + total_written, length - total_written,
+                   static_cast<off_t>(position));
+        if (bytes_written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_written <= 0) {
+            break;
+        }
+#endif
+        total_written += static_cast<size_t>(bytes_written);
+    }
+
+    if (total_written != length)
+        m_good = false;
+    return total_written;
+}
+
+MappedFile::MappedFile(const IOFile& file, AccessPattern pattern) {
+    if (!file.IsOpen()) {
+        return;
+    }
+
+    const u64 file_size = file.GetSize();
+    if (file_size == 0 || file_size > std::numeric_limits<size_t>::max()) {
+        return;
+    }
+
+#ifdef _WIN32
+    const HANDLE file_handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file.m_file)));
+    // Views take no read-ahead hints, the access pattern only matters to other systems
+    (void)pattern;
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        LOG_ERROR(Common_Filesystem, "CreateFileMapping failed: %s", GetLastErrorMsg());
+        return;
+    }
+
+    void* view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        LOG_ERROR(Common_Filesystem, "MapViewOfFile failed: %s", GetLastErrorMsg());
+        CloseHandle(mapping_handle);
+        mapping_handle = nullptr;
+        return;
+    }
+#else
+    void* view = mmap(nullptr, file_size, PROT_READ, MAP_SHARED, fileno(file.m_file), 0);
+    if (view == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "mmap failed: %s", GetLastErrorMsg());
+        return;
+    }
+
+    // Only a hint, the mapping works the same if the OS ignores it
+    if (pattern == AccessPattern::Sequential) {
+        madvise(view, file_size, MADV_SEQUENTIAL);
+    } else if (pattern == AccessPattern::Random) {
+        madvise(view, file_size, MADV_RANDOM);
+    }
+#endif
+
+    data = static_cast<const u8*>(view);
+    size = file_size;
+}
+
+MappedFile::~MappedFile() {
+    if (!IsMapped()) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping_handle);
+#else
+    munmap(const_cast<u8*>(data), size);
+#endif
+}
+
+CopyOnWriteMapping::CopyOnWriteMapping(const IOFile& file, u64 file_length, u64 zero_length) {
+    if (!file.IsOpen() || file_length > file.GetSize() ||
+        file_length + zero_length > std::numeric_limits<size_t>::max() ||
+        file_length + zero_length == 0) {
+        return;
+    }
+
+#ifdef _WIN32
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    const size_t page_size = system_info.dwPageSize;
+#else
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+    const size_t total_size =
+        Common::AlignUp(static_cast<size_t>(file_length + zero_length), page_size);
+
+#ifdef _WIN32
+    // Committed pages are only backed by memory once they are touched
+    void* base = VirtualAlloc(nullptr, total_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (base == nullptr) {
+        LOG_ERROR(Common_Filesystem, "VirtualAlloc failed: %s", GetLastErrorMsg());
+        return;
+    }
+
+    std::FILE* const handle = file.m_file;
+    const bool read = _fseeki64(handle, 0, SEEK_SET) == 0 &&
+                      std::fread(base, 1, static_cast<size_t>(file_length), handle) == file_length;
+    if (!read) {
+        LOG_ERROR(Common_Filesystem, "Failed to read the file to map");
+        VirtualFree(base, 0, MEM_RELEASE);
+        return;
+    }
+#else
+    // Reserve the whole range with anonymous memory first, then place the file over its start
+    void* base = mmap(nullptr, total_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                      -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR(Common_Filesystem, "mmap failed: %s", GetLastErrorMsg());
+        return;
+    }
+
+    const size_t mapped_file_length = Common::AlignUp(static_cast<size_t>(file_length), page_size);
+    if (file_length != 0) {
+        void* view = mmap(base, mapped_file_length, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_FIXED, fileno(file.m_file), 0);
+        if (view == MAP_FAILED) {
+            LOG_ERROR(Common_Filesystem, "mmap failed: %s", GetLastErrorMsg());
+            munmap(base, total_size);
+            return;
+        }
+    }
+
+    // The file may go on past the part that was asked for, which has to read as zero
+    if (mapped_file_length != file_length) {
+        std::memset(static_cast<u8*>(base) + file_length, 0,
+                    static_cast<size_t>(mapped_file_length - file_length));
+    }
+#endif
+
+    data = static_cast<u8*>(base);
+    size = file_length + zero_length;
+    reserved_size = total_size;
+}
+
+CopyOnWriteMapping::~CopyOnWriteMapping() {
+    if (!IsMapped()) {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, reserved_size);
+#endif
+}
+
 } // namespace FileUtil
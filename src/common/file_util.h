@@ -68,7 +68,8 @@ bool Delete(const std::string& filename);
 // Deletes a directory filename, returns true on success
 bool DeleteDir(const std::string& filename);
 
-// renames file srcFilename to destFilename, returns true on success
+// renames file srcFilename to destFilename, replacing any existing destFilename atomically,
+// returns true on success
 bool Rename(const std::string& srcFilename, const std::string& destFilename);
 
 // copies file srcFilename to destFilename, returns true on success
@@ -224,6 +225,15 @@ public:
         return WriteArray(&object, 1);
     }
 
+    /**
+     * Positional reads and writes. They go straight to the OS at the given offset instead of
+     * through the stream, so several threads can use them on the same file at once. Stream writes
+     * that are still buffered have to be flushed before the same bytes are read this way.
+     * @returns The number of bytes transferred, fewer than length on errors or at the end of file.
+     */
+    size_t ReadAt(void* data, size_t length, u64 offset) const;
+    size_t WriteAt(const void* data, size_t length, u64 offset);
+
     bool IsOpen() const {
         return nullptr != m_file;
     }
@@ -249,10 +259,87 @@ public:
     }
 
 private:
+    friend class MappedFile;
+    friend class CopyOnWriteMapping;
+
     std::FILE* m_file = nullptr;
     bool m_good = true;
 };
 
+/**
+ * Read-only memory mapping of the whole contents of an open file, which lets several readers
+ * access the file at the same time without sharing a file position. The mapping stays valid after
+ * the file it was created from is closed.
+ */
+class MappedFile : public NonCopyable {
+public:
+    /// How the mapping is going to be read, which tells the OS how much of the file to read ahead
+    enum class AccessPattern {
+        Normal,
+        Sequential,
+        Random,
+    };
+
+    explicit MappedFile(const IOFile& file, AccessPattern pattern = AccessPattern::Normal);
+    ~MappedFile();
+
+    /// Returns whether the file could be mapped. Empty files are never mapped.
+    bool IsMapped() const {
+        return data != nullptr;
+    }
+
+    const u8* Data() const {
+        return data;
+    }
+
+    u64 Size() const {
+        return size;
+    }
+
+private:
+    const u8* data = nullptr;
+    u64 size = 0;
+#ifdef _WIN32
+    void* mapping_handle = nullptr;
+#endif
+};
+
+/**
+ * Private, writable memory mapping of the beginning of a file followed by zero-filled memory.
+ * Writes only change private copies of the pages they touch, the pages that are only ever read
+ * stay shared with the OS file cache and every other mapping of the file. The zero-filled part
+ * takes no memory until it is written. The bytes of the last page of the file that come after
+ * file_length read as zero, like the zero-filled part.
+ *
+ * Windows has no way to place a file view right before anonymous memory, so there the file is
+ * read into lazily committed memory instead.
+ */
+class CopyOnWriteMapping : public NonCopyable {
+public:
+    CopyOnWriteMapping(const IOFile& file, u64 file_length, u64 zero_length);
+    ~CopyOnWriteMapping();
+
+    /// Returns whether the mapping could be created.
+    bool IsMapped() const {
+        return data != nullptr;
+    }
+
+    u8* Data() const {
+        return data;
+    }
+
+    /// Returns the size of the mapping, file_length + zero_length.
+    u64 Size() const {
+        return size;
+    }
+
+private:
+    u8* data = nullptr;
+    u64 size = 0;
+    /// Size of the host memory reserved for the mapping, a multiple of the host page size
+    size_t reserved_size = 0;
+};
+
 } // namespace FileUtil
 
 // To deal with Windows being dumb at unicode:
@@ -8,6 +8,7 @@
 #include <cstring>
 #include "common/cityhash.h"
 #include "common/common_types.h"
+#include "common/content_hash.h"
 
 namespace Common {
 
@@ -18,7 +19,18 @@ namespace Common {
  * @returns 64-bit hash value that was computed over the data block
  */
 static inline u64 ComputeHash64(const void* data, size_t len) {
-    return CityHash64(static_cast<const char*>(data), len);
+    return ContentHash64(data, len);
+}
+
+/**
+ * Computes a 128-bit hash over the specified block of data, for keys that have to stay unique
+ * across very many blocks
+ * @param data Block of data to compute hash over
+ * @param len Length of data (in bytes) to compute hash over
+ * @returns 128-bit hash value that was computed over the data block
+ */
+static inline u128 ComputeHash128(const void* data, size_t len) {
+    return ContentHash128(data, len);
 }
 
 /**
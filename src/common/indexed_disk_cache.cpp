@@ -0,0 +1,371 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <unordered_set>
+#include "common/common_funcs.h"
+#include "common/indexed_disk_cache.h"
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "common/thread.h"
+#include "common/thread_placement.h"
+
+// On disk format:
+// Header
+// Records, each a RecordHeader followed by the value
+// Indices, each an array of IndexEntry sorted by key, only the one of the header being valid
+// Records appended after the index by sessions that weren't closed
+
+namespace Common {
+
+namespace {
+
+constexpr u32 CACHE_MAGIC = MakeMagic('D', 'C', 'I', 'X');
+constexpr u32 FORMAT_VERSION = 2;
+
+/// Stale data has to take up at least this much of the file before it is compacted
+constexpr u64 MIN_STALE_SIZE = 1024 * 1024;
+/// ...as well as a quarter of the size of the live records
+constexpr u64 STALE_SIZE_DIVISOR = 4;
+
+struct Header {
+    u32_le magic;
+    u32_le format_version;
+    u64_le tag;
+    /// Offset of the index, or 0 if none was written yet
+    u64_le index_offset;
+    u64_le index_count;
+};
+static_assert(sizeof(Header) == 0x20, "Header has wrong size");
+
+struct RecordHeader {
+    u64_le key;
+    u32_le size;
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(RecordHeader) == 0x10, "RecordHeader has wrong size");
+
+struct IndexEntry {
+    u64_le key;
+    /// Offset of the value of the record
+    u64_le offset;
+    u32_le size;
+    INSERT_PADDING_WORDS(1);
+};
+static_assert(sizeof(IndexEntry) == 0x18, "IndexEntry has wrong size");
+
+Header MakeHeader(u64 tag, u64 index_offset, u64 index_count) {
+    Header header{};
+    header.magic = CACHE_MAGIC;
+    header.format_version = FORMAT_VERSION;
+    header.tag = tag;
+    header.index_offset = index_offset;
+    header.index_count = index_count;
+    return header;
+}
+
+/// Writes a record at offset of file, returning the offset of its value or 0 on failure.
+u64 WriteRecord(FileUtil::IOFile& file, u64 offset, u64 key, const u8* data, u32 size) {
+    std::vector<u8> record(sizeof(RecordHeader) + size);
+    RecordHeader header{};
+    header.key = key;
+    header.size = size;
+    std::memcpy(record.data(), &header, sizeof(header));
+    if (size != 0) {
+        std::memcpy(record.data() + sizeof(header), data, size);
+    }
+    if (file.WriteAt(record.data(), record.size(), offset) != record.size()) {
+        return 0;
+    }
+    return offset + sizeof(RecordHeader);
+}
+
+} // Anonymous namespace
+
+IndexedDiskCache::~IndexedDiskCache() {
+    Close();
+}
+
+bool IndexedDiskCache::Open(const std::string& path_, u64 tag_) {
+    Close();
+    path = path_;
+    tag = tag_;
+
+    file.Open(path, "r+b");
+    if (file.IsOpen() && Load()) {
+        return true;
+    }
+
+    // Missing, outdated and damaged files are all started over
+    entries.clear();
+    mapping.reset();
+    mapped_size = 0;
+    file.Open(path, "w+b");
+    const Header header = MakeHeader(tag, 0, 0);
+    if (!file.IsOpen() || file.WriteAt(&header, sizeof(header), 0) != sizeof(header)) {
+        LOG_ERROR(Common_Filesystem, "Unable to create the disk cache %s", path.c_str());
+        file.Close();
+        return false;
+    }
+    file_end = sizeof(Header);
+    index_dirty = false;
+    return true;
+}
+
+bool IndexedDiskCache::Load() {
+    Header header;
+    if (file.ReadAt(&header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != CACHE_MAGIC || header.format_version != FORMAT_VERSION ||
+        header.tag != tag) {
+        return false;
+    }
+    const u64 file_size = file.GetSize();
+
+    u64 offset = sizeof(Header);
+    u64 index_size = 0;
+    if (header.index_offset != 0) {
+        const u64 index_offset = header.index_offset;
+        if (index_offset < sizeof(Header) || index_offset > file_size ||
+            header.index_count > (file_size - index_offset) / sizeof(IndexEntry)) {
+            return false;
+        }
+        std::vector<IndexEntry> index(header.index_count);
+        index_size = index.size() * sizeof(IndexEntry);
+        if (file.ReadAt(index.data(), index_size, index_offset) != index_size) {
+            return false;
+        }
+        for (const IndexEntry& entry : index) {
+            if (entry.offset > index_offset || entry.size > index_offset - entry.offset) {
+                return false;
+            }
+            entries[entry.key] = {entry.offset, entry.size};
+        }
+        offset = index_offset + index_size;
+    }
+
+    // Records written by sessions that didn't close the cache are found by walking them. A torn
+    // record at the end is overwritten by the next one.
+    index_dirty = false;
+    RecordHeader record;
+    while (file_size - offset >= sizeof(RecordHeader) &&
+           file.ReadAt(&record, sizeof(record), offset) == sizeof(record)) {
+        const u64 value_offset = offset + sizeof(RecordHeader);
+        if (record.size > file_size - value_offset) {
+            break;
+        }
+        entries[record.key] = {value_offset, record.size};
+        offset = value_offset + record.size;
+        index_dirty = true;
+    }
+    file_end = offset;
+
+    mapping = std::make_unique<FileUtil::MappedFile>(file,
+                                                     FileUtil::MappedFile::AccessPattern::Random);
+    if (mapping->IsMapped()) {
+        mapped_size = std::min(mapping->Size(), file_end);
+    } else {
+        mapping.reset();
+        mapped_size = 0;
+    }
+
+    StartCompaction(index_size);
+    return true;
+}
+
+void IndexedDiskCache::Close() {
+    if (!file.IsOpen()) {
+        return;
+    }
+    if (compaction_thread.joinable()) {
+        compaction_thread.join();
+    }
+    mapping.reset();
+    mapped_size = 0;
+
+    if (!compaction_succeeded || !FinishCompaction()) {
+        if (index_dirty || !written_keys.empty()) {
+            WriteIndex(file, file_end, entries);
+        }
+        file.Close();
+    }
+
+    entries.clear();
+    written_keys.clear();
+    compacted_entries.clear();
+    compaction_succeeded = false;
+}
+
+std::vector<u64> IndexedDiskCache::GetKeys() const {
+    std::vector<u64> keys;
+    keys.reserve(entries.size());
+    for (const auto& entry : entries) {
+        keys.push_back(entry.first);
+    }
+    return keys;
+}
+
+bool IndexedDiskCache::Read(u64 key, std::vector<u8>& value) const {
+    const auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    const Location& location = it->second;
+    value.resize(location.size);
+    if (location.size == 0) {
+        return true;
+    }
+
+    // Values written since the file was mapped are read from the file
+    if (location.offset + location.size <= mapped_size) {
+        std::memcpy(value.data(), mapping->Data() + location.offset, location.size);
+        return true;
+    }
+    if (file.ReadAt(value.data(), location.size, location.offset) != location.size) {
+        LOG_ERROR(Common_Filesystem, "Unable to read from the disk cache %s", path.c_str());
+        value.clear();
+        return false;
+    }
+    return true;
+}
+
+bool IndexedDiskCache::Write(u64 key, const u8* data, size_t size) {
+    if (!file.IsOpen() || size > UINT32_MAX) {
+        return false;
+    }
+    const u32 value_size = static_cast<u32>(size);
+    const u64 value_offset = WriteRecord(file, file_end, key, data, value_size);
+    if (value_offset == 0) {
+        LOG_ERROR(Common_Filesystem, "Unable to write to the disk cache %s", path.c_str());
+        return false;
+    }
+    entries[key] = {value_offset, value_size};
+    written_keys.push_back(key);
+    file_end = value_offset + value_size;
+    return true;
+}
+
+bool IndexedDiskCache::WriteIndex(FileUtil::IOFile& target, u64 end,
+                                  const std::unordered_map<u64, Location>& index) const {
+    std::vector<IndexEntry> sorted;
+    sorted.reserve(index.size());
+    for (const auto& entry : index) {
+        IndexEntry index_entry{};
+        index_entry.key = entry.first;
+        index_entry.offset = entry.second.offset;
+        index_entry.size = entry.second.size;
+        sorted.push_back(index_entry);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const IndexEntry& a, const IndexEntry& b) { return a.key < b.key; });
+
+    // The header is only pointed at the new index once all of it was written, leaving the old
+    // index intact if the write fails.
+    const size_t index_size = sorted.size() * sizeof(IndexEntry);
+    const Header header = MakeHeader(tag, end, sorted.size());
+    if ((index_size != 0 && target.WriteAt(sorted.data(), index_size, end) != index_size) ||
+        target.WriteAt(&header, sizeof(header), 0) != sizeof(header)) {
+        LOG_ERROR(Common_Filesystem, "Unable to write the index of the disk cache %s",
+                  path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void IndexedDiskCache::StartCompaction(u64 index_size) {
+    if (!mapping) {
+        return;
+    }
+    u64 live_size = 0;
+    for (const auto& entry : entries) {
+        live_size += sizeof(RecordHeader) + entry.second.size;
+    }
+    const u64 stale_size = file_end - sizeof(Header) - index_size - live_size;
+    if (live_size + index_size + sizeof(Header) > file_end || stale_size < MIN_STALE_SIZE ||
+        stale_size < live_size / STALE_SIZE_DIVISOR) {
+        return;
+    }
+
+    LOG_INFO(Common_Filesystem, "Compacting the disk cache %s, %" PRIu64 " bytes are stale",
+             path.c_str(), stale_size);
+    std::vector<std::pair<u64, Location>> values(entries.begin(), entries.end());
+    // Copying the values in file order keeps the reads of the mapping sequential
+    std::sort(values.begin(), values.end(), [](const auto& a, const auto& b) {
+        return a.second.offset < b.second.offset;
+    });
+    compaction_thread = std::thread(&IndexedDiskCache::Compact, this, std::move(values));
+}
+
+void IndexedDiskCache::Compact(std::vector<std::pair<u64, Location>> values) {
+    Common::SetCurrentThreadName("DiskCacheCompact");
+    Common::SetCurrentThreadRole(Common::ThreadRole::Worker);
+
+    FileUtil::IOFile compacted(path + ".tmp", "wb");
+    u64 offset = sizeof(Header);
+    const Header header = MakeHeader(tag, 0, 0);
+    if (!compacted.IsOpen() || compacted.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+        return;
+    }
+    for (const auto& value : values) {
+        const Location& location = value.second;
+        RecordHeader record{};
+        record.key = value.first;
+        record.size = location.size;
+        if (compacted.WriteBytes(&record, sizeof(record)) != sizeof(record) ||
+            compacted.WriteBytes(mapping->Data() + location.offset, location.size) !=
+                location.size) {
+            compacted.Close();
+            FileUtil::Delete(path + ".tmp");
+            return;
+        }
+        compacted_entries[value.first] = {offset + sizeof(RecordHeader), location.size};
+        offset += sizeof(RecordHeader) + location.size;
+    }
+    if (!compacted.Close()) {
+        FileUtil::Delete(path + ".tmp");
+        return;
+    }
+    compacted_end = offset;
+    compaction_succeeded = true;
+}
+
+bool IndexedDiskCache::FinishCompaction() {
+    const std::string compacted_path = path + ".tmp";
+    FileUtil::IOFile compacted(compacted_path, "r+b");
+    bool success = compacted.IsOpen();
+
+    // Only the latest value of each key written in this session is copied over
+    std::unordered_set<u64> copied_keys;
+    std::vector<u8> value;
+    for (const u64 key : written_keys) {
+        if (!success) {
+            break;
+        }
+        if (!copied_keys.insert(key).second) {
+            continue;
+        }
+        const u32 size = entries.at(key).size;
+        const u64 value_offset =
+            Read(key, value) ? WriteRecord(compacted, compacted_end, key, value.data(), size) : 0;
+        success = value_offset != 0;
+        compacted_entries[key] = {value_offset, size};
+        compacted_end = value_offset + size;
+    }
+    success = success && WriteIndex(compacted, compacted_end, compacted_entries);
+    success = compacted.Close() && success;
+
+    if (!success) {
+        FileUtil::Delete(compacted_path);
+        return false;
+    }
+    file.Close();
+    if (!FileUtil::Rename(compacted_path, path)) {
+        LOG_ERROR(Common_Filesystem, "Unable to replace the disk cache %s", path.c_str());
+        FileUtil::Delete(compacted_path);
+    }
+    return true;
+}
+
+} // namespace Common
@@ -0,0 +1,112 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Common {
+
+/**
+ * On-disk key-value store for caching generated data, such as shaders, between sessions. Values
+ * are appended to the file as records, and an index sorted by key is written after them when the
+ * cache is closed, so that opening the cache only reads the index and the records appended after
+ * it. Values are then read on demand from a mapping of the file.
+ *
+ * The header of the file holds a tag chosen by the owner, such as the hash of the driver or of the
+ * build the values were generated with, and files with a different tag are started over. Once
+ * overwritten values and old indices take up a good part of the file, the values it was opened
+ * with are copied to a new file on a thread of their own, which replaces the old one on Close.
+ *
+ * The cache is not thread safe. Values must be smaller than 4GB.
+ */
+class IndexedDiskCache final : NonCopyable {
+public:
+    IndexedDiskCache() = default;
+    ~IndexedDiskCache();
+
+    /**
+     * Opens the cache file at path, creating it if it doesn't exist yet or if it was written with
+     * another tag or format.
+     * @returns Whether the file could be opened.
+     */
+    bool Open(const std::string& path, u64 tag);
+    /// Writes the index of the values and closes the file.
+    void Close();
+
+    bool IsOpen() const {
+        return file.IsOpen();
+    }
+
+    /// Returns the number of values in the cache.
+    size_t GetSize() const {
+        return entries.size();
+    }
+
+    bool Contains(u64 key) const {
+        return entries.count(key) != 0;
+    }
+
+    /// Returns the keys of every value in the cache, in no particular order.
+    std::vector<u64> GetKeys() const;
+
+    /**
+     * Reads the value stored for a key.
+     * @returns Whether the key has a value that could be read.
+     */
+    bool Read(u64 key, std::vector<u8>& value) const;
+
+    /// Stores a value for a key, replacing the one it had.
+    bool Write(u64 key, const u8* data, size_t size);
+
+private:
+    struct Location {
+        /// Offset of the data of the record in the file
+        u64 offset;
+        u32 size;
+    };
+
+    /// Reads back the index and the records after it. Returns false if the file is to be redone.
+    bool Load();
+    /// Writes the index of entries to the end of a file, followed by a header pointing to it.
+    bool WriteIndex(FileUtil::IOFile& target, u64 end,
+                    const std::unordered_map<u64, Location>& index) const;
+    /// Starts writing the compacted file if enough of the cache file is stale.
+    void StartCompaction(u64 index_size);
+    /// Runs on the compaction thread, writing the values read at Open to the compacted file.
+    void Compact(std::vector<std::pair<u64, Location>> values);
+    /// Appends the values written since Open to the compacted file and makes it the cache file.
+    bool FinishCompaction();
+
+    std::string path;
+    u64 tag = 0;
+    FileUtil::IOFile file;
+    /// Where the next record is written
+    u64 file_end = 0;
+    /// Whether the index in the file is missing records
+    bool index_dirty = false;
+
+    /// Mapping of the file as it was opened, and how much of it holds valid records
+    std::unique_ptr<FileUtil::MappedFile> mapping;
+    u64 mapped_size = 0;
+
+    std::unordered_map<u64, Location> entries;
+    /// Keys written since the file was opened
+    std::vector<u64> written_keys;
+
+    std::thread compaction_thread;
+    std::atomic<bool> compaction_succeeded{false};
+    /// Written by the compaction thread, only to be read once it was joined
+    std::unordered_map<u64, Location> compacted_entries;
+    u64 compacted_end = 0;
+};
+
+} // namespace Common
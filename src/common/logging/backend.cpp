@@ -4,7 +4,12 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
+#include <mutex>
+#include <thread>
 #include "common/assert.h"
 #include "common/common_funcs.h" // snprintf compatibility define
 #include "common/logging/backend.h"
@@ -12,6 +17,8 @@
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
 #include "common/string_util.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 
 namespace Log {
 
@@ -125,15 +132,142 @@ Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsign
     return entry;
 }
 
-static Filter* filter = nullptr;
+namespace Detail {
+std::array<std::atomic<u8>, static_cast<size_t>(Class::Count)> filtered_levels{};
+} // namespace Detail
+
+static std::atomic<const Filter*> filter{nullptr};
+
+static void UpdateFilteredLevels(const Filter* new_filter) {
+    for (size_t log_class = 0; log_class < Detail::filtered_levels.size(); ++log_class) {
+        u8 filtered = 0;
+        for (u8 level = 0; new_filter && level < static_cast<u8>(Level::Count); ++level) {
+            if (!new_filter->CheckMessage(static_cast<Class>(log_class), static_cast<Level>(level)))
+                filtered |= 1U << level;
+        }
+        Detail::filtered_levels[log_class].store(filtered, std::memory_order_relaxed);
+    }
+}
 
 void SetFilter(Filter* new_filter) {
     filter = new_filter;
+    UpdateFilteredLevels(new_filter);
+}
+
+void FilterChanged(const Filter& changed_filter) {
+    if (filter == &changed_filter)
+        UpdateFilteredLevels(&changed_filter);
+}
+
+/**
+ * Writes out the entries logged by every thread on a thread of its own, so that threads logging a
+ * message only pay for formatting it and not for the console output.
+ */
+class Logger {
+public:
+    Logger() {
+        StartThread();
+    }
+
+    ~Logger() {
+        StopThread();
+    }
+
+    void StartThread() {
+        stop = false;
+        thread = std::thread(&Logger::Run, this);
+    }
+
+    void StopThread() {
+        if (!thread.joinable())
+            return;
+        stop = true;
+        wake_event.Set();
+        thread.join();
+    }
+
+    void Push(Entry entry) {
+        // Wait for the thread to make room when the queue is full, rather than dropping messages
+        while (!queue.TryPush(std::move(entry))) {
+            wake_event.Set();
+            std::this_thread::yield();
+        }
+    }
+
+    void Flush() {
+        std::unique_lock<std::mutex> lock(flush_mutex);
+        const u64 request = ++flush_requested;
+        wake_event.Set();
+        flush_done.wait(lock, [this, request] { return flushed >= request; });
+    }
+
+private:
+    /// How long the thread sleeps between checks of the queue, unless it is woken up earlier
+    static constexpr std::chrono::milliseconds write_interval{10};
+
+    void Run() {
+        Common::SetCurrentThreadName("Logger");
+        while (true) {
+            wake_event.WaitUntil(std::chrono::steady_clock::now() + write_interval);
+
+            // Everything pushed before the flush request was made is in the queue by now
+            u64 request;
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                request = flush_requested;
+            }
+            queue.PopAll([](Entry entry) { PrintColoredMessage(entry); });
+            if (request != flushed) {
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                flushed = request;
+                flush_done.notify_all();
+            }
+
+            if (stop && queue.Empty())
+                return;
+        }
+    }
+
+    Common::MPSCRingQueue<Entry, 1024> queue;
+    Common::Event wake_event;
+    std::atomic<bool> stop{false};
+
+    std::mutex flush_mutex;
+    std::condition_variable flush_done;
+    u64 flush_requested = 0;
+    u64 flushed = 0;
+
+    std::thread thread;
+};
+
+static Logger& GetLogger() {
+    static Logger logger;
+    return logger;
+}
+
+static void WriteEntry(Entry entry) {
+    const bool is_critical = entry.log_level == Level::Critical;
+    GetLogger().Push(std::move(entry));
+    // Critical messages are usually followed by a crash, make sure they make it out before it
+    if (is_critical)
+        GetLogger().Flush();
+}
+
+void FlushLog() {
+    GetLogger().Flush();
+}
+
+void StopLogThread() {
+    GetLogger().StopThread();
+}
+
+void StartLogThread() {
+    GetLogger().StartThread();
 }
 
 void LogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
                 const char* function, const char* format, ...) {
-    if (filter && !filter->CheckMessage(log_class, log_level))
+    if (!IsLogged(log_class, log_level))
         return;
     std::array<char, 4 * 1024> formatting_buffer;
     va_list args;
@@ -143,17 +277,17 @@ void LogMessage(Class log_class, Level log_level, const char* filename, unsigned
     Entry entry = CreateEntry(log_class, log_level, filename, line_num, function,
                               std::string(formatting_buffer.data()));
 
-    PrintColoredMessage(entry);
+    WriteEntry(std::move(entry));
 }
 
 void FmtLogMessageImpl(Class log_class, Level log_level, const char* filename,
                        unsigned int line_num, const char* function, const char* format,
                        const fmt::format_args& args) {
-    if (filter && !filter->CheckMessage(log_class, log_level))
+    if (!IsLogged(log_class, log_level))
         return;
     Entry entry =
         CreateEntry(log_class, log_level, filename, line_num, function, fmt::vformat(format, args));
 
-    PrintColoredMessage(entry);
+    WriteEntry(std::move(entry));
 }
 } // namespace Log
@@ -49,5 +49,21 @@ const char* GetLevelName(Level log_level);
 Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                   const char* function, std::string message);
 
+/// Sets the filter messages are checked against. It must stay alive as long as it is in use.
 void SetFilter(Filter* filter);
+
+/// Called by a filter whenever it changes, so that the messages it filters are up to date.
+void FilterChanged(const Filter& filter);
+
+/// Waits until every message logged so far has been written out.
+void FlushLog();
+
+/**
+ * Writes out every message logged so far, then stops the thread that writes them, so that the
+ * process can fork without it. Nothing may be logged until StartLogThread is called.
+ */
+void StopLogThread();
+
+/// Starts the thread stopped by StopLogThread again, in each process after forking.
+void StartLogThread();
 } // namespace Log
@@ -15,10 +15,12 @@ Filter::Filter(Level default_level) {
 
 void Filter::ResetAll(Level level) {
     class_levels.fill(level);
+    FilterChanged(*this);
 }
 
 void Filter::SetClassLevel(Class log_class, Level level) {
     class_levels[static_cast<size_t>(log_class)] = level;
+    FilterChanged(*this);
 }
 
 void Filter::ParseFilterString(const std::string& filter_str) {
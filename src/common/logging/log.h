@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <fmt/format.h>
 #include "common/common_types.h"
 
@@ -23,6 +26,8 @@ enum class Level : u8 {
 
     Count ///< Total number of logging levels
 };
+static_assert(static_cast<u8>(Level::Error) == 4 && static_cast<u8>(Level::Count) == 6,
+              "The levels are checked against LOG_MIN_LEVEL by their value");
 
 typedef u8 ClassType;
 
@@ -91,6 +96,19 @@ enum class Class : ClassType {
     Count              ///< Total number of logging classes
 };
 
+namespace Detail {
+/// For every log class, a bit for each level whose messages are filtered out. Kept up to date with
+/// the active filter by the backend.
+extern std::array<std::atomic<u8>, static_cast<size_t>(Class::Count)> filtered_levels;
+} // namespace Detail
+
+/// Returns whether messages of this class and level pass the active filter.
+inline bool IsLogged(Class log_class, Level log_level) {
+    const u8 filtered =
+        Detail::filtered_levels[static_cast<size_t>(log_class)].load(std::memory_order_relaxed);
+    return (filtered & (1U << static_cast<u8>(log_level))) == 0;
+}
+
 /// Logs a message to the global logger.
 void LogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_num,
                 const char* function,
@@ -118,48 +136,90 @@ void FmtLogMessage(Class log_class, Level log_level, const char* filename, unsig
 
 } // namespace Log
 
+// Lowest level of the messages that are compiled in, as the value of its Log::Level. Builds can set
+// it through the YUZU_MIN_LOG_LEVEL CMake option, messages below it then cost nothing at all.
+#ifndef LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define LOG_MIN_LEVEL 0
+#else
+#define LOG_MIN_LEVEL 1
+#endif
+#endif
+
+// The filter is checked first, so that the arguments of filtered messages aren't even evaluated.
 #define LOG_GENERIC(log_class, log_level, ...)                                                     \
-    ::Log::LogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__)
+    (::Log::IsLogged(log_class, log_level)                                                         \
+         ? ::Log::LogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__)      \
+         : void(0))
 
-#ifdef _DEBUG
+#if LOG_MIN_LEVEL <= 0
 #define LOG_TRACE(log_class, ...)                                                                  \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Trace, __VA_ARGS__)
 #else
 #define LOG_TRACE(log_class, ...) (void(0))
 #endif
-
+#if LOG_MIN_LEVEL <= 1
 #define LOG_DEBUG(log_class, ...)                                                                  \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 2
 #define LOG_INFO(log_class, ...)                                                                   \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 3
 #define LOG_WARNING(log_class, ...)                                                                \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Warning, __VA_ARGS__)
+#else
+#define LOG_WARNING(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 4
 #define LOG_ERROR(log_class, ...)                                                                  \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(log_class, ...) (void(0))
+#endif
 #define LOG_CRITICAL(log_class, ...)                                                               \
     LOG_GENERIC(::Log::Class::log_class, ::Log::Level::Critical, __VA_ARGS__)
 
 // Define the fmt lib macros
-#ifdef _DEBUG
+#define LOG_FMT_GENERIC(log_class, log_level, ...)                                                 \
+    (::Log::IsLogged(log_class, log_level)                                                         \
+         ? ::Log::FmtLogMessage(log_class, log_level, __FILE__, __LINE__, __func__, __VA_ARGS__)   \
+         : void(0))
+
+#if LOG_MIN_LEVEL <= 0
 #define NGLOG_TRACE(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Trace, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Trace, __VA_ARGS__)
 #else
-#define NGLOG_TRACE(log_class, fmt, ...) (void(0))
+#define NGLOG_TRACE(log_class, ...) (void(0))
 #endif
-
+#if LOG_MIN_LEVEL <= 1
 #define NGLOG_DEBUG(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Debug, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Debug, __VA_ARGS__)
+#else
+#define NGLOG_DEBUG(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 2
 #define NGLOG_INFO(log_class, ...)                                                                 \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Info, __FILE__, __LINE__,          \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Info, __VA_ARGS__)
+#else
+#define NGLOG_INFO(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 3
 #define NGLOG_WARNING(log_class, ...)                                                              \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Warning, __FILE__, __LINE__,       \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Warning, __VA_ARGS__)
+#else
+#define NGLOG_WARNING(log_class, ...) (void(0))
+#endif
+#if LOG_MIN_LEVEL <= 4
 #define NGLOG_ERROR(log_class, ...)                                                                \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Error, __FILE__, __LINE__,         \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Error, __VA_ARGS__)
+#else
+#define NGLOG_ERROR(log_class, ...) (void(0))
+#endif
 #define NGLOG_CRITICAL(log_class, ...)                                                             \
-    ::Log::FmtLogMessage(::Log::Class::log_class, ::Log::Level::Critical, __FILE__, __LINE__,      \
-                         __func__, __VA_ARGS__)
+    LOG_FMT_GENERIC(::Log::Class::log_class, ::Log::Level::Critical, __VA_ARGS__)
@@ -0,0 +1,106 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include "common/logging/log.h"
+#include "common/memory_usage.h"
+
+#ifdef _WIN32
+#include <windows.h>
+// windows.h needs to be included before psapi.h
+#include <psapi.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+struct CounterRegistry {
+    std::mutex mutex;
+    std::vector<MemoryUsageCounter*> counters;
+};
+
+/// Counters are constructed during static initialization, so the registry is made on first use
+CounterRegistry& GetRegistry() {
+    static CounterRegistry registry;
+    return registry;
+}
+
+} // Anonymous namespace
+
+MemoryUsageCounter::MemoryUsageCounter(const char* name) : name(name) {
+    CounterRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.counters.push_back(this);
+}
+
+MemoryUsageCounter::~MemoryUsageCounter() {
+    CounterRegistry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.counters.erase(std::find(registry.counters.begin(), registry.counters.end(), this));
+}
+
+std::vector<MemoryUsageEntry> GetMemoryUsage() {
+    std::vector<MemoryUsageEntry> entries;
+    {
+        CounterRegistry& registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const MemoryUsageCounter* counter : registry.counters) {
+            entries.push_back({counter->GetName(), counter->Get()});
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return std::strcmp(lhs.name, rhs.name) < 0;
+    });
+    return entries;
+}
+
+u64 GetResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#elif defined(__linux__)
+    // The second field of statm is the resident set size, in pages
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long long total_pages = 0;
+    unsigned long long resident_pages = 0;
+    const int fields = std::fscanf(file, "%llu %llu", &total_pages, &resident_pages);
+    std::fclose(file);
+    if (fields != 2) {
+        return 0;
+    }
+    return static_cast<u64>(resident_pages) * static_cast<u64>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+}
+
+void LogMemoryUsage() {
+    const std::vector<MemoryUsageEntry> entries = GetMemoryUsage();
+    const u64 resident = GetResidentMemory();
+
+    u64 accounted = 0;
+    for (const MemoryUsageEntry& entry : entries) {
+        accounted += entry.bytes;
+    }
+    LOG_INFO(Common_Memory, "Memory usage: %" PRIu64 " KiB resident, %" PRIu64 " KiB accounted for",
+             resident / 1024, accounted / 1024);
+    for (const MemoryUsageEntry& entry : entries) {
+        LOG_INFO(Common_Memory, "  %s: %" PRIu64 " KiB", entry.name, entry.bytes / 1024);
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,64 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Named counter of the host memory a subsystem holds, for the memory usage statistics. Counters
+ * are meant to live at namespace scope, and are listed by GetMemoryUsage from their construction
+ * until their destruction. Updates are atomic, so they can be made from any thread.
+ */
+class MemoryUsageCounter final : NonCopyable {
+public:
+    /// @param name Name shown for the counter, has to outlive it
+    explicit MemoryUsageCounter(const char* name);
+    ~MemoryUsageCounter();
+
+    void Add(u64 size) {
+        bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    void Subtract(u64 size) {
+        bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /// Replaces the value, for subsystems that recompute their usage as a whole
+    void Set(u64 size) {
+        bytes.store(size, std::memory_order_relaxed);
+    }
+
+    u64 Get() const {
+        return bytes.load(std::memory_order_relaxed);
+    }
+
+    const char* GetName() const {
+        return name;
+    }
+
+private:
+    const char* name;
+    std::atomic<u64> bytes{0};
+};
+
+struct MemoryUsageEntry {
+    const char* name;
+    u64 bytes;
+};
+
+/// Returns the current value of every counter, sorted by name.
+std::vector<MemoryUsageEntry> GetMemoryUsage();
+
+/// Returns the memory the host has resident for the emulator process, or 0 if it doesn't tell.
+u64 GetResidentMemory();
+
+/// Logs the value of every counter along with the resident memory of the process.
+void LogMemoryUsage();
+
+} // namespace Common
@@ -90,6 +90,80 @@ void* AllocateMemoryPages(size_t size) {
     return ptr;
 }
 
+void* ReserveMemoryRegion(size_t size) {
+#ifdef _WIN32
+    void* ptr = VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    int flags = MAP_ANON | MAP_PRIVATE;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    void* ptr = mmap(nullptr, size, PROT_NONE, flags, -1, 0);
+
+    if (ptr == MAP_FAILED)
+        ptr = nullptr;
+#endif
+
+    if (ptr == nullptr)
+        LOG_ERROR(Common_Memory, "Failed to reserve 0x%zx bytes of address space", size);
+
+    return ptr;
+}
+
+bool CommitMemoryRegion(void* ptr, size_t size) {
+#ifdef _WIN32
+    if (VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE) == nullptr) {
+        LOG_ERROR(Common_Memory, "CommitMemoryRegion failed!\n%s", GetLastErrorMsg());
+        return false;
+    }
+#else
+    if (mprotect(ptr, size, PROT_READ | PROT_WRITE) != 0) {
+        LOG_ERROR(Common_Memory, "CommitMemoryRegion failed!");
+        return false;
+    }
+#endif
+    return true;
+}
+
+void DecommitMemoryRegion(void* ptr, size_t size) {
+#ifdef _WIN32
+    if (!VirtualFree(ptr, size, MEM_DECOMMIT))
+        LOG_ERROR(Common_Memory, "DecommitMemoryRegion failed!\n%s", GetLastErrorMsg());
+#else
+    // Mapping fresh anonymous pages over the range drops the old ones and leaves it reserved.
+    int flags = MAP_ANON | MAP_PRIVATE | MAP_FIXED;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    if (mmap(ptr, size, PROT_NONE, flags, -1, 0) == MAP_FAILED)
+        LOG_ERROR(Common_Memory, "DecommitMemoryRegion failed!");
+#endif
+}
+
+void ReleaseMemoryRegion(void* ptr, size_t size) {
+    if (ptr) {
+#ifdef _WIN32
+        if (!VirtualFree(ptr, 0, MEM_RELEASE))
+            LOG_ERROR(Common_Memory, "ReleaseMemoryRegion failed!\n%s", GetLastErrorMsg());
+#else
+        munmap(ptr, size);
+#endif
+    }
+}
+
+void AdviseHugePages(void* ptr, size_t size) {
+#ifdef MADV_HUGEPAGE
+    // madvise requires a page aligned start, only the huge pages fully within the range matter.
+    constexpr uintptr_t huge_page_size = 2 * 1024 * 1024;
+    const uintptr_t start = (reinterpret_cast<uintptr_t>(ptr) + huge_page_size - 1) &
+                            ~(huge_page_size - 1);
+    const uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + size) & ~(huge_page_size - 1);
+    if (start < end) {
+        madvise(reinterpret_cast<void*>(start), end - start, MADV_HUGEPAGE);
+    }
+#endif
+}
+
 void* AllocateAlignedMemory(size_t size, size_t alignment) {
 #ifdef _WIN32
     void* ptr = _aligned_malloc(size, alignment);
@@ -10,6 +10,30 @@
 void* AllocateExecutableMemory(size_t size, bool low = true);
 void* AllocateMemoryPages(size_t size);
 void FreeMemoryPages(void* ptr, size_t size);
+
+/**
+ * Reserves a range of host address space without committing any memory to it. Accessing the
+ * range faults until parts of it are committed with CommitMemoryRegion.
+ * @param size Size of the range to reserve, which should be a multiple of the host page size.
+ * @returns Pointer to the start of the reserved range, or nullptr on failure.
+ */
+void* ReserveMemoryRegion(size_t size);
+
+/// Commits readable and writable, zero-filled memory to part of a reserved range.
+bool CommitMemoryRegion(void* ptr, size_t size);
+
+/// Returns the memory backing part of a reserved range to the host, keeping the range reserved.
+void DecommitMemoryRegion(void* ptr, size_t size);
+
+/// Releases a range previously reserved with ReserveMemoryRegion.
+void ReleaseMemoryRegion(void* ptr, size_t size);
+
+/**
+ * Hints the host that a range of memory should be backed by huge pages where possible. The hint
+ * is only applied to the whole huge pages within the range, and ignored on hosts without support.
+ */
+void AdviseHugePages(void* ptr, size_t size);
+
 void* AllocateAlignedMemory(size_t size, size_t alignment);
 void FreeAlignedMemory(void* ptr);
 void WriteProtectMemory(void* ptr, size_t size, bool executable = false);
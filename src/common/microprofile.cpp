@@ -5,3 +5,37 @@
 // Includes the MicroProfile implementation in this file for compilation
 #define MICROPROFILE_IMPL 1
 #include "common/microprofile.h"
+
+#include <atomic>
+
+namespace Common {
+
+static std::atomic<ProfilerGpuTimer*> gpu_timer{nullptr};
+
+void SetProfilerGpuTimer(ProfilerGpuTimer* timer) {
+    gpu_timer = timer;
+}
+
+} // namespace Common
+
+#if MICROPROFILE_ENABLED
+uint32_t MicroProfileGpuInsertTimeStamp() {
+    Common::ProfilerGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr ? timer->InsertTimestamp() : 0;
+}
+
+uint64_t MicroProfileGpuGetTimeStamp(uint32_t key) {
+    Common::ProfilerGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr ? timer->GetTimestamp(key) : 0;
+}
+
+uint64_t MicroProfileTicksPerSecondGpu() {
+    Common::ProfilerGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr ? timer->GetTicksPerSecond() : 1;
+}
+
+int MicroProfileGetGpuTickReference(int64_t* cpu_tick, int64_t* gpu_tick) {
+    Common::ProfilerGpuTimer* const timer = Common::gpu_timer;
+    return timer != nullptr && timer->GetTickReference(cpu_tick, gpu_tick) ? 1 : 0;
+}
+#endif
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "common/common_types.h"
+
 // Uncomment this to disable microprofile. This will get you cleaner profiles when using
 // external sampling profilers like "Very Sleepy", and will improve performance somewhat.
 // #define MICROPROFILE_ENABLED 0
@@ -11,7 +13,7 @@
 // Customized Citra settings.
 // This file wraps the MicroProfile header so that these are consistent everywhere.
 #define MICROPROFILE_WEBSERVER 0
-#define MICROPROFILE_GPU_TIMERS 0 // TODO: Implement timer queries when we upgrade to OpenGL 3.3
+#define MICROPROFILE_GPU_TIMERS 1 // Taken by the renderer, see Common::ProfilerGpuTimer
 #define MICROPROFILE_CONTEXT_SWITCH_TRACE 0
 #define MICROPROFILE_PER_THREAD_BUFFER_SIZE (2048 << 13) // 16 MB
 
@@ -32,3 +34,29 @@ typedef void* HANDLE;
 #ifdef PAGE_MASK
 #undef PAGE_MASK
 #endif
+
+namespace Common {
+
+/**
+ * Takes the GPU timestamps of the profiler's GPU scopes, for the renderer in use. MicroProfile
+ * asks for timestamps from the threads the scopes and frame flips are on, and reads them back
+ * a few frames later, so an implementation has to take care of the threads its API can be used
+ * from itself. Until one is set, GPU scopes have no duration.
+ */
+class ProfilerGpuTimer {
+public:
+    virtual ~ProfilerGpuTimer() = default;
+
+    /// Requests a timestamp, which is looked up by the returned key once it has been taken.
+    virtual u32 InsertTimestamp() = 0;
+    /// Returns the timestamp of a key, in GPU ticks.
+    virtual u64 GetTimestamp(u32 key) = 0;
+    virtual u64 GetTicksPerSecond() = 0;
+    /// Gets a CPU tick and a GPU tick taken at the same time, to line the timelines up.
+    virtual bool GetTickReference(s64* cpu_tick, s64* gpu_tick) = 0;
+};
+
+/// Sets the timer of the GPU scopes, or unsets it with nullptr.
+void SetProfilerGpuTimer(ProfilerGpuTimer* timer);
+
+} // namespace Common
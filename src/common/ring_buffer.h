@@ -0,0 +1,92 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A lockless single reader, single writer ring buffer of fixed size slots, each made of
+ * `granularity` elements of T (e.g. the samples of every channel of an audio frame). Slots are
+ * pushed and popped in bulk with plain copies, so neither side ever waits on the other.
+ */
+template <typename T, size_t granularity, size_t capacity>
+class RingBuffer {
+    static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+    static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+                  "capacity must be a power of two");
+    static_assert(granularity > 0, "granularity must be non-zero");
+
+public:
+    /// Number of slots the buffer can hold.
+    static constexpr size_t Capacity() {
+        return capacity;
+    }
+
+    /// Number of slots currently in the buffer. Either side may call this.
+    size_t Size() const {
+        return write_index.load(std::memory_order_acquire) -
+               read_index.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Pushes slots into the buffer. Only the writer may call this.
+     * @param new_slots Elements of the slots to push, slot_count * granularity of them.
+     * @returns How many slots were pushed, fewer than slot_count if the buffer got full.
+     */
+    size_t Push(const T* new_slots, size_t slot_count) {
+        const size_t write = write_index.load(std::memory_order_relaxed);
+        const size_t read = read_index.load(std::memory_order_acquire);
+        slot_count = std::min(slot_count, capacity - (write - read));
+
+        const size_t position = write % capacity;
+        const size_t first_copy = std::min(slot_count, capacity - position);
+        std::memcpy(&data[position * granularity], new_slots, first_copy * slot_size);
+        std::memcpy(&data[0], new_slots + first_copy * granularity,
+                    (slot_count - first_copy) * slot_size);
+
+        write_index.store(write + slot_count, std::memory_order_release);
+        return slot_count;
+    }
+
+    /**
+     * Pops slots from the buffer. Only the reader may call this.
+     * @param output Where to copy the elements of the popped slots to.
+     * @param max_slots Maximum number of slots to pop.
+     * @returns How many slots were popped.
+     */
+    size_t Pop(T* output, size_t max_slots) {
+        const size_t read = read_index.load(std::memory_order_relaxed);
+        const size_t write = write_index.load(std::memory_order_acquire);
+        const size_t slot_count = std::min(max_slots, write - read);
+
+        const size_t position = read % capacity;
+        const size_t first_copy = std::min(slot_count, capacity - position);
+        std::memcpy(output, &data[position * granularity], first_copy * slot_size);
+        std::memcpy(output + first_copy * granularity, &data[0],
+                    (slot_count - first_copy) * slot_size);
+
+        read_index.store(read + slot_count, std::memory_order_release);
+        return slot_count;
+    }
+
+private:
+    static constexpr size_t slot_size = granularity * sizeof(T);
+
+    // Kept on separate cache lines so that each side only writes to its own.
+    alignas(64) std::atomic<size_t> read_index{0};
+    alignas(64) std::atomic<size_t> write_index{0};
+
+    std::array<T, granularity * capacity> data;
+};
+
+} // namespace Common
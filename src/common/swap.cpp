@@ -0,0 +1,125 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/swap.h"
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+#ifdef __ARM_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+template <typename T, T (*Swap)(T)>
+void SwapGeneric(u8* dest, const u8* src, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        T value;
+        std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+        value = Swap(value);
+        std::memcpy(dest + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// GCC and Clang only emit SSSE3 in functions that ask for it, MSVC emits it anywhere.
+#ifdef _MSC_VER
+#define TARGET_SSSE3
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
+/// Reverses each group of Size bytes in a vector.
+template <size_t Size>
+TARGET_SSSE3 __m128i MakeShuffleMask() {
+    alignas(16) u8 mask[16];
+    for (size_t i = 0; i < 16; ++i) {
+        mask[i] = static_cast<u8>(i - i % Size + Size - 1 - i % Size);
+    }
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+}
+
+template <typename T, T (*Swap)(T)>
+TARGET_SSSE3 void SwapSSSE3(u8* dest, const u8* src, size_t count) {
+    const __m128i mask = MakeShuffleMask<sizeof(T)>();
+    const size_t size = count * sizeof(T);
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset + 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_shuffle_epi8(low, mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset + 16),
+                         _mm_shuffle_epi8(high, mask));
+    }
+    for (; offset + 16 <= size; offset += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + offset));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + offset), _mm_shuffle_epi8(value, mask));
+    }
+    SwapGeneric<T, Swap>(dest + offset, src + offset, (size - offset) / sizeof(T));
+}
+
+#undef TARGET_SSSE3
+
+#endif
+
+#ifdef __ARM_NEON
+
+template <size_t Size>
+uint8x16_t ReverseBytes(uint8x16_t value) {
+    if constexpr (Size == 2) {
+        return vrev16q_u8(value);
+    } else if constexpr (Size == 4) {
+        return vrev32q_u8(value);
+    } else {
+        return vrev64q_u8(value);
+    }
+}
+
+template <typename T, T (*Swap)(T)>
+void SwapNEON(u8* dest, const u8* src, size_t count) {
+    const size_t size = count * sizeof(T);
+    size_t offset = 0;
+    for (; offset + 16 <= size; offset += 16) {
+        vst1q_u8(dest + offset, ReverseBytes<sizeof(T)>(vld1q_u8(src + offset)));
+    }
+    SwapGeneric<T, Swap>(dest + offset, src + offset, (size - offset) / sizeof(T));
+}
+
+#endif
+
+using SwapFn = void (*)(u8*, const u8*, size_t);
+
+template <typename T, T (*Swap)(T)>
+SwapFn SelectSwap() {
+#if defined(ARCHITECTURE_x86_64)
+    return GetCPUCaps().ssse3 ? &SwapSSSE3<T, Swap> : &SwapGeneric<T, Swap>;
+#elif defined(__ARM_NEON)
+    return &SwapNEON<T, Swap>;
+#else
+    return &SwapGeneric<T, Swap>;
+#endif
+}
+
+} // Anonymous namespace
+
+void SwapArray16(void* dest, const void* src, size_t count) {
+    static const SwapFn swap = SelectSwap<u16, swap16>();
+    swap(static_cast<u8*>(dest), static_cast<const u8*>(src), count);
+}
+
+void SwapArray32(void* dest, const void* src, size_t count) {
+    static const SwapFn swap = SelectSwap<u32, swap32>();
+    swap(static_cast<u8*>(dest), static_cast<const u8*>(src), count);
+}
+
+void SwapArray64(void* dest, const void* src, size_t count) {
+    static const SwapFn swap = SelectSwap<u64, swap64>();
+    swap(static_cast<u8*>(dest), static_cast<const u8*>(src), count);
+}
+
+} // namespace Common
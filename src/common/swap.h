@@ -25,7 +25,9 @@
     defined(__NetBSD__) || defined(__OpenBSD__)
 #include <sys/endian.h>
 #endif
+#include <cstddef>
 #include <cstring>
+#include <type_traits>
 #include "common/common_types.h"
 
 // GCC 4.6+
@@ -163,6 +165,54 @@ inline double swapd(double f) {
     return f;
 }
 
+/**
+ * Bulk versions of swap16, swap32 and swap64, swapping the bytes of count values from src into
+ * dest, which may be the same array or not overlap with it. They use vector byte shuffles when
+ * the host has them.
+ */
+void SwapArray16(void* dest, const void* src, size_t count);
+void SwapArray32(void* dest, const void* src, size_t count);
+void SwapArray64(void* dest, const void* src, size_t count);
+
+/// Swaps the bytes of every value of an array of integers or floating point values.
+template <typename T>
+void SwapArray(T* dest, const T* src, size_t count) {
+    static_assert(std::is_arithmetic<T>::value, "SwapArray only swaps arithmetic types");
+    if constexpr (sizeof(T) == 1) {
+        if (dest != src) {
+            std::memcpy(dest, src, count);
+        }
+    } else if constexpr (sizeof(T) == 2) {
+        SwapArray16(dest, src, count);
+    } else if constexpr (sizeof(T) == 4) {
+        SwapArray32(dest, src, count);
+    } else {
+        static_assert(sizeof(T) == 8, "Unsupported type size");
+        SwapArray64(dest, src, count);
+    }
+}
+
+template <typename T>
+void SwapArray(T* data, size_t count) {
+    SwapArray(data, data, count);
+}
+
+/// Converts an array of values stored in big endian from or to the byte order of the host.
+template <typename T>
+void ConvertBigEndianArray(T* data, size_t count) {
+#if COMMON_LITTLE_ENDIAN
+    SwapArray(data, count);
+#endif
+}
+
+/// Converts an array of values stored in little endian from or to the byte order of the host.
+template <typename T>
+void ConvertLittleEndianArray(T* data, size_t count) {
+#if COMMON_BIG_ENDIAN
+    SwapArray(data, count);
+#endif
+}
+
 } // Namespace Common
 
 template <typename T, typename F>
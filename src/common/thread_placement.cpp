@@ -0,0 +1,249 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include "common/logging/log.h"
+#include "common/thread_placement.h"
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+namespace Common {
+
+namespace {
+
+/// Roles that get a physical core of their own, in the order cores are handed out
+constexpr std::array<ThreadRole, 3> CriticalRoles{ThreadRole::CPU, ThreadRole::GPU,
+                                                  ThreadRole::Audio};
+
+std::atomic<bool> placement_enabled{false};
+
+/// Planned on first use, as detecting the topology reads a few hundred files on some hosts
+const ThreadPlacement& GetPlacement() {
+    static const ThreadPlacement placement = [] {
+        const std::vector<HostCore> cores = DetectHostCores();
+        ThreadPlacement plan = PlanThreadPlacement(cores);
+        LOG_INFO(Common, "Placing threads over %zu physical cores", cores.size());
+        return plan;
+    }();
+    return placement;
+}
+
+/// Returns one core for each logical CPU, for when the topology can't be told.
+std::vector<HostCore> CoresFromCPUCount() {
+    std::vector<HostCore> cores(std::max(1u, std::thread::hardware_concurrency()));
+    for (u32 cpu = 0; cpu < cores.size(); ++cpu) {
+        cores[cpu].logical_cpus.push_back(cpu);
+    }
+    return cores;
+}
+
+#ifdef __linux__
+/// Parses a list of CPUs as sysfs writes them, such as "0-3,8,10-11".
+std::vector<u32> ParseCPUList(const std::string& list) {
+    std::vector<u32> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        const size_t end = std::min(list.find(',', pos), list.size());
+        const std::string range = list.substr(pos, end - pos);
+        const size_t dash = range.find('-');
+        try {
+            const u32 first = static_cast<u32>(std::stoul(range.substr(0, dash)));
+            const u32 last = dash == std::string::npos
+                                 ? first
+                                 : static_cast<u32>(std::stoul(range.substr(dash + 1)));
+            for (u32 cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // Ignore the parts that aren't numbers, such as the trailing newline
+        }
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+std::string ReadSysfs(const std::string& path) {
+    std::ifstream file(path);
+    std::string contents;
+    std::getline(file, contents);
+    return contents;
+}
+#endif
+
+} // Anonymous namespace
+
+std::vector<HostCore> DetectHostCores() {
+    std::vector<HostCore> cores;
+#ifdef _WIN32
+    DWORD length = 0;
+    GetLogicalProcessorInformationEx(RelationProcessorCore, nullptr, &length);
+    std::vector<u8> buffer(length);
+    auto info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data());
+    if (!GetLogicalProcessorInformationEx(RelationProcessorCore, info, &length)) {
+        return CoresFromCPUCount();
+    }
+
+    // Only the first processor group, as thread affinities are set within it
+    u8 max_efficiency_class = 0;
+    for (DWORD offset = 0; offset < length;) {
+        const auto entry = reinterpret_cast<const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(
+            buffer.data() + offset);
+        offset += entry->Size;
+        const GROUP_AFFINITY& group = entry->Processor.GroupMask[0];
+        if (group.Group != 0) {
+            continue;
+        }
+        HostCore core;
+        for (u32 cpu = 0; cpu < sizeof(group.Mask) * 8; ++cpu) {
+            if ((group.Mask >> cpu) & 1) {
+                core.logical_cpus.push_back(cpu);
+            }
+        }
+        // Higher classes are the faster cores, the class is 0 for all of them on most hosts
+        core.is_efficiency_core = entry->Processor.EfficiencyClass == 0;
+        max_efficiency_class = std::max(max_efficiency_class, entry->Processor.EfficiencyClass);
+        cores.push_back(std::move(core));
+    }
+    if (max_efficiency_class == 0) {
+        for (HostCore& core : cores) {
+            core.is_efficiency_core = false;
+        }
+    }
+#elif defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        return CoresFromCPUCount();
+    }
+
+    // Hybrid Intel hosts list their performance cores, ARM hosts give each core a capacity
+    const std::vector<u32> performance_cpus =
+        ParseCPUList(ReadSysfs("/sys/devices/cpu_core/cpus"));
+    std::map<std::pair<int, int>, size_t> core_indices;
+    u32 max_capacity = 0;
+    std::vector<u32> capacities;
+    for (u32 cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) {
+            continue;
+        }
+        const std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+        int package = 0;
+        int core_id = static_cast<int>(cpu);
+        try {
+            package = std::stoi(ReadSysfs(topology + "/topology/physical_package_id"));
+            core_id = std::stoi(ReadSysfs(topology + "/topology/core_id"));
+        } catch (const std::exception&) {
+            // Without topology, every logical CPU counts as a core
+        }
+
+        const auto [itr, inserted] = core_indices.emplace(std::make_pair(package, core_id),
+                                                          cores.size());
+        if (inserted) {
+            cores.emplace_back();
+            u32 capacity = 0;
+            try {
+                capacity = static_cast<u32>(std::stoul(ReadSysfs(topology + "/cpu_capacity")));
+            } catch (const std::exception&) {
+            }
+            capacities.push_back(capacity);
+            max_capacity = std::max(max_capacity, capacity);
+            if (!performance_cpus.empty()) {
+                cores.back().is_efficiency_core =
+                    std::find(performance_cpus.begin(), performance_cpus.end(), cpu) ==
+                    performance_cpus.end();
+            }
+        }
+        cores[itr->second].logical_cpus.push_back(cpu);
+    }
+    for (size_t i = 0; i < cores.size(); ++i) {
+        if (capacities[i] != 0 && capacities[i] < max_capacity) {
+            cores[i].is_efficiency_core = true;
+        }
+    }
+#endif
+    if (cores.empty()) {
+        return CoresFromCPUCount();
+    }
+    std::stable_partition(cores.begin(), cores.end(),
+                          [](const HostCore& core) { return !core.is_efficiency_core; });
+    return cores;
+}
+
+ThreadPlacement PlanThreadPlacement(const std::vector<HostCore>& cores) {
+    ThreadPlacement placement;
+    if (cores.size() < 2) {
+        return placement;
+    }
+
+    // Critical roles take the performance cores, which come first
+    const size_t num_dedicated = std::min(CriticalRoles.size(), cores.size() - 1);
+    for (size_t i = 0; i < num_dedicated; ++i) {
+        placement[static_cast<size_t>(CriticalRoles[i])] = cores[i].logical_cpus;
+    }
+
+    std::vector<u32> shared_cpus;
+    for (size_t i = num_dedicated; i < cores.size(); ++i) {
+        shared_cpus.insert(shared_cpus.end(), cores[i].logical_cpus.begin(),
+                           cores[i].logical_cpus.end());
+    }
+    for (size_t i = num_dedicated; i < CriticalRoles.size(); ++i) {
+        placement[static_cast<size_t>(CriticalRoles[i])] = shared_cpus;
+    }
+    placement[static_cast<size_t>(ThreadRole::Worker)] = std::move(shared_cpus);
+    return placement;
+}
+
+void SetThreadPlacementEnabled(bool enabled) {
+    placement_enabled = enabled;
+}
+
+void SetCurrentThreadRole(ThreadRole role) {
+    if (!placement_enabled) {
+        return;
+    }
+    const std::vector<u32>& cpus = GetPlacement()[static_cast<size_t>(role)];
+    const bool is_worker = role == ThreadRole::Worker;
+
+#ifdef _WIN32
+    if (!cpus.empty()) {
+        DWORD_PTR mask = 0;
+        for (const u32 cpu : cpus) {
+            mask |= DWORD_PTR(1) << cpu;
+        }
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+    }
+    SetThreadPriority(GetCurrentThread(),
+                      is_worker ? THREAD_PRIORITY_BELOW_NORMAL : THREAD_PRIORITY_ABOVE_NORMAL);
+#elif defined(__linux__)
+    if (!cpus.empty()) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (const u32 cpu : cpus) {
+            CPU_SET(cpu, &cpu_set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+    // Raising the priority takes privileges processes usually don't have, so only the workers
+    // are lowered. The nice value of a Linux thread is set through its thread id.
+    if (is_worker) {
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 5);
+    }
+#endif
+}
+
+} // namespace Common
@@ -0,0 +1,61 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/// What a host thread is for, which decides the cores it runs on and its priority.
+enum class ThreadRole : u32 {
+    /// Runs the emulated CPU
+    CPU,
+    /// Processes the GPU command lists and presents the frames
+    GPU,
+    /// Mixes and outputs the audio
+    Audio,
+    /// Background work whose results can wait, such as building shaders, decoding textures or
+    /// file and network I/O
+    Worker,
+};
+
+constexpr size_t NumThreadRoles = 4;
+
+/// A physical core of the host, and the logical CPUs it runs through SMT.
+struct HostCore {
+    std::vector<u32> logical_cpus;
+    /// Whether this is one of the slower cores of a host that has two kinds
+    bool is_efficiency_core = false;
+};
+
+/// Logical CPUs the threads of each role run on, where empty leaves the choice to the OS.
+using ThreadPlacement = std::array<std::vector<u32>, NumThreadRoles>;
+
+/// Returns the physical cores the process may run on, performance cores first.
+std::vector<HostCore> DetectHostCores();
+
+/**
+ * Places the latency critical roles, CPU, GPU and audio in that order, on physical cores of their
+ * own, so that they don't share one through SMT or get moved around by the OS. One core is always
+ * left for the workers, which share all the cores that aren't taken.
+ */
+ThreadPlacement PlanThreadPlacement(const std::vector<HostCore>& cores);
+
+/**
+ * Sets whether threads are placed by their role at all. Until then, and when disabled, the OS
+ * places them and they all run at normal priority.
+ */
+void SetThreadPlacementEnabled(bool enabled);
+
+/**
+ * Moves the calling thread to the cores planned for its role, and sets the priority of the role.
+ * Threads call this themselves, right after they start.
+ */
+void SetCurrentThreadRole(ThreadRole role);
+
+} // namespace Common
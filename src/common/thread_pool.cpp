@@ -0,0 +1,130 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/thread.h"
+#include "common/thread_placement.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+namespace {
+
+/// Pool and index of the worker running on this thread, if any
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+} // Anonymous namespace
+
+ThreadPool::ThreadPool(size_t num_threads, std::string name, u32 affinity_mask)
+    : name(std::move(name)), affinity_mask(affinity_mask) {
+    if (num_threads == 0) {
+        const size_t host_threads = std::thread::hardware_concurrency();
+        num_threads = std::max<size_t>(host_threads, 2) - 1;
+    }
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    // The workers only start once every queue of the others exists
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stop_requested = true;
+    }
+    wake_cv.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+void ThreadPool::WaitIdle() {
+    std::unique_lock<std::mutex> lock(sleep_mutex);
+    idle_cv.wait(lock, [this] { return unfinished_jobs.load() == 0; });
+}
+
+void ThreadPool::Enqueue(Job job) {
+    unfinished_jobs.fetch_add(1);
+    if (current_pool == this) {
+        Worker& worker = *workers[current_worker];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_back(std::move(job));
+    } else if (!shared_jobs.TryPush(std::move(job))) {
+        // TryPush leaves the job alone when the queue is full
+        const size_t index = next_overflow_worker.fetch_add(1) % workers.size();
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.push_front(std::move(job));
+    }
+    queued_jobs.fetch_add(1);
+
+    // Taking the lock makes sure a worker that is about to sleep sees the new job
+    { std::lock_guard<std::mutex> lock(sleep_mutex); }
+    wake_cv.notify_one();
+}
+
+bool ThreadPool::PopJob(size_t index, Job& job) {
+    {
+        Worker& worker = *workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            job = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            return true;
+        }
+    }
+    if (shared_jobs.TryPop(job)) {
+        return true;
+    }
+    for (size_t i = 1; i < workers.size(); ++i) {
+        Worker& victim = *workers[(index + i) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    SetCurrentThreadName(name.c_str());
+    if (affinity_mask != 0) {
+        SetCurrentThreadAffinity(affinity_mask);
+    } else {
+        SetCurrentThreadRole(ThreadRole::Worker);
+    }
+    current_pool = this;
+    current_worker = index;
+
+    Job job;
+    while (true) {
+        if (PopJob(index, job)) {
+            queued_jobs.fetch_sub(1);
+            job();
+            // Release whatever the task captured before anyone is told it finished
+            job = nullptr;
+            if (unfinished_jobs.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleep_mutex);
+                idle_cv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_cv.wait(lock, [this] { return stop_requested || queued_jobs.load() > 0; });
+        if (stop_requested && queued_jobs.load() <= 0) {
+            return;
+        }
+    }
+}
+
+} // namespace Common
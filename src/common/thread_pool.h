@@ -0,0 +1,131 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+/**
+ * Flag shared between whoever submitted a group of tasks and the tasks themselves. Tasks that
+ * haven't started yet when it is cancelled are dropped, and running ones may poll it to stop
+ * early. Copies share the same flag.
+ */
+class CancellationToken {
+public:
+    CancellationToken() : cancelled(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() {
+        cancelled->store(true, std::memory_order_relaxed);
+    }
+
+    bool IsCancelled() const {
+        return cancelled->load(std::memory_order_relaxed);
+    }
+
+private:
+    std::shared_ptr<std::atomic<bool>> cancelled;
+};
+
+/**
+ * Pool of worker threads running short tasks, for work that can be spread over the host cores,
+ * such as building shaders or decoding textures and executables.
+ *
+ * Tasks submitted from other threads go through a bounded lock-free queue shared by all workers,
+ * while tasks that workers submit themselves go to a queue of their own, which they run newest
+ * first. Workers that run out of tasks take the oldest tasks of the others.
+ */
+class ThreadPool final : NonCopyable {
+public:
+    /**
+     * @param num_threads Number of workers, or 0 to have one for every host thread but one.
+     * @param name Name given to the workers, as seen by debuggers and profilers.
+     * @param affinity_mask Host cores the workers may run on, or 0 for any of them.
+     */
+    explicit ThreadPool(size_t num_threads = 0, std::string name = "Worker", u32 affinity_mask = 0);
+    /// Runs the tasks that are still queued, then stops the workers.
+    ~ThreadPool();
+
+    size_t GetThreadCount() const {
+        return workers.size();
+    }
+
+    /**
+     * Queues a task to be run on a worker.
+     * @returns Future of the result of func, which also holds any exception it threw.
+     */
+    template <typename Func>
+    auto Submit(Func&& func) -> std::future<decltype(func())> {
+        using Result = decltype(func());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> future = task->get_future();
+        Enqueue([task] { (*task)(); });
+        return future;
+    }
+
+    /**
+     * Queues a task that is dropped if token is cancelled before it starts, in which case its
+     * future reports std::future_errc::broken_promise.
+     */
+    template <typename Func>
+    auto Submit(Func&& func, CancellationToken token) -> std::future<decltype(func())> {
+        using Result = decltype(func());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(func));
+        std::future<Result> future = task->get_future();
+        Enqueue([task, token] {
+            if (!token.IsCancelled()) {
+                (*task)();
+            }
+        });
+        return future;
+    }
+
+    /// Waits for every task submitted so far to finish. Must not be called from a task.
+    void WaitIdle();
+
+private:
+    using Job = std::function<void()>;
+
+    struct Worker {
+        std::thread thread;
+        /// Tasks submitted by this worker
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    void Enqueue(Job job);
+    bool PopJob(size_t index, Job& job);
+    void WorkerLoop(size_t index);
+
+    std::string name;
+    u32 affinity_mask;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    MPMCRingQueue<Job, 1024> shared_jobs;
+    /// Worker that gets the tasks that don't fit in shared_jobs
+    std::atomic<size_t> next_overflow_worker{0};
+
+    /// Tasks that were queued but not taken by a worker yet, and tasks that haven't finished
+    std::atomic<s64> queued_jobs{0};
+    std::atomic<s64> unfinished_jobs{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wake_cv;
+    std::condition_variable idle_cv;
+    bool stop_requested = false;
+};
+
+} // namespace Common
@@ -8,9 +8,11 @@
 // single reader, single writer queue
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <mutex>
+#include <utility>
 #include "common/common_types.h"
 
 namespace Common {
@@ -119,4 +121,166 @@ public:
 private:
     std::mutex write_lock;
 };
+
+// a bounded lockless thread-safe,
+// single reader, multiple writer ring buffer
+//
+// Every cell carries a sequence number telling whose turn it is: writers claim a cell by bumping
+// write_pos and publish it by advancing the cell's sequence, so no writer ever waits on a lock.
+
+template <typename T, size_t Capacity>
+class MPSCRingQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    MPSCRingQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Adds an element to the queue. Returns false, leaving the queue untouched, if it is full.
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        size_t pos = write_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos % Capacity];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (difference == 0) {
+                if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::forward<Arg>(t);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = write_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Only the reader may call the functions below.
+
+    bool Empty() const {
+        return cells[read_pos % Capacity].sequence.load(std::memory_order_acquire) != read_pos + 1;
+    }
+
+    bool Pop(T& t) {
+        Cell& cell = cells[read_pos % Capacity];
+        if (cell.sequence.load(std::memory_order_acquire) != read_pos + 1) {
+            return false;
+        }
+
+        t = std::move(cell.value);
+        cell.sequence.store(read_pos + Capacity, std::memory_order_release);
+        ++read_pos;
+        return true;
+    }
+
+    /// Pops every element that has been published so far, calling func on each of them in order.
+    /// Returns the number of elements popped.
+    template <typename Func>
+    size_t PopAll(Func&& func) {
+        size_t count = 0;
+        for (T t; Pop(t); ++count) {
+            func(std::move(t));
+        }
+        return count;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> cells;
+    // Kept on separate cache lines so that writers don't keep stealing the reader's line.
+    alignas(64) std::atomic<size_t> write_pos{0};
+    alignas(64) size_t read_pos = 0;
+};
+
+// a bounded lockless thread-safe,
+// multiple reader, multiple writer ring buffer
+//
+// Works like MPSCRingQueue, with readers claiming cells by bumping read_pos the same way writers
+// bump write_pos.
+
+template <typename T, size_t Capacity>
+class MPMCRingQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    MPMCRingQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    /// Adds an element to the queue. Returns false, leaving the queue untouched, if it is full.
+    template <typename Arg>
+    bool TryPush(Arg&& t) {
+        size_t pos = write_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos % Capacity];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (difference == 0) {
+                if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::forward<Arg>(t);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = write_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Takes the oldest element out of the queue. Returns false if it is empty.
+    bool TryPop(T& t) {
+        size_t pos = read_pos.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos % Capacity];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const auto difference =
+                static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (difference == 0) {
+                if (read_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    t = std::move(cell.value);
+                    cell.sequence.store(pos + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                pos = read_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Returns whether the queue looked empty at the time of the call.
+    bool Empty() const {
+        const size_t pos = read_pos.load(std::memory_order_relaxed);
+        return cells[pos % Capacity].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::array<Cell, Capacity> cells;
+    alignas(64) std::atomic<size_t> write_pos{0};
+    alignas(64) std::atomic<size_t> read_pos{0};
+};
 } // namespace Common
@@ -41,9 +41,26 @@ public:
     /// Clear all instruction cache
     virtual void ClearInstructionCache() = 0;
 
+    /**
+     * Invalidate the instruction cache for a range of guest memory, dropping only the translated
+     * code that covers it.
+     * @param page_table Page table the range belongs to
+     * @param start Start address of the range
+     * @param length Length of the range in bytes
+     */
+    virtual void InvalidateCacheRange(const Memory::PageTable* page_table, VAddr start,
+                                      size_t length) = 0;
+
     /// Notify CPU emulation that page tables have changed
     virtual void PageTableChanged() = 0;
 
+    /**
+     * Notify CPU emulation that the contents of a page table were discarded, so that any state
+     * cached for it (such as translated code) is dropped.
+     * @param page_table Page table that was reset
+     */
+    virtual void PageTableReset(const Memory::PageTable* page_table) {}
+
     /**
      * Set the Program Counter to an address
      * @param addr Address to set PC to
@@ -70,6 +87,32 @@ public:
      */
     virtual void SetReg(int index, u64 value) = 0;
 
+    /// Registers that SVCs take their arguments in and return their results in, X0 to X7
+    using SvcRegisters = std::array<u64, 8>;
+
+    /**
+     * Reads all registers an SVC may take arguments in
+     * @param regs Array to store the registers in
+     */
+    virtual void GetSvcRegisters(SvcRegisters& regs) const {
+        for (size_t i = 0; i < regs.size(); ++i) {
+            regs[i] = GetReg(static_cast<int>(i));
+        }
+    }
+
+    /**
+     * Writes the results of an SVC back to the registers
+     * @param regs Register values
+     * @param mask Bit i is set if register i is to be written
+     */
+    virtual void SetSvcRegisters(const SvcRegisters& regs, u32 mask) {
+        for (size_t i = 0; i < regs.size(); ++i) {
+            if (mask & (1U << i)) {
+                SetReg(static_cast<int>(i), regs[i]);
+            }
+        }
+    }
+
     virtual u128 GetExtReg(int index) const = 0;
 
     virtual void SetExtReg(int index, u128 value) = 0;
@@ -108,13 +151,44 @@ public:
      * Saves the current CPU context
      * @param ctx Thread context to save
      */
-    virtual void SaveContext(ThreadContext& ctx) = 0;
+    void SaveContext(ThreadContext& ctx) {
+        SaveGeneralContext(ctx);
+        SaveVectorContext(ctx);
+    }
 
     /**
      * Loads a CPU context
      * @param ctx Thread context to load
      */
-    virtual void LoadContext(const ThreadContext& ctx) = 0;
+    void LoadContext(const ThreadContext& ctx) {
+        LoadGeneralContext(ctx);
+        LoadVectorContext(ctx);
+    }
+
+    /**
+     * Saves the general purpose registers, SP, PC, PSTATE and TLS address of the CPU context.
+     * @param ctx Thread context to save
+     */
+    virtual void SaveGeneralContext(ThreadContext& ctx) = 0;
+
+    /**
+     * Loads the general purpose registers, SP, PC, PSTATE and TLS address of a CPU context.
+     * @param ctx Thread context to load
+     */
+    virtual void LoadGeneralContext(const ThreadContext& ctx) = 0;
+
+    /**
+     * Saves the vector registers and FPCR of the CPU context. Kept apart from the rest, so that
+     * they can stay in the CPU while its thread isn't running.
+     * @param ctx Thread context to save
+     */
+    virtual void SaveVectorContext(ThreadContext& ctx) = 0;
+
+    /**
+     * Loads the vector registers and FPCR of a CPU context.
+     * @param ctx Thread context to load
+     */
+    virtual void LoadVectorContext(const ThreadContext& ctx) = 0;
 
     /// Prepare core for thread reschedule (if needed to correctly handle state)
     virtual void PrepareReschedule() = 0;
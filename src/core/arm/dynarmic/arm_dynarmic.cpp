@@ -2,20 +2,30 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include <memory>
+#include <unordered_set>
 #include <dynarmic/A64/a64.h>
 #include <dynarmic/A64/config.h>
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/svc.h"
 #include "core/memory.h"
 
 using Vector = Dynarmic::A64::Vector;
 
+/// Dynarmic reserves the code cache of each JIT instance up front, and doesn't tell how much of it
+/// is filled, so the whole reservation is counted.
+constexpr u64 JIT_CODE_CACHE_SIZE = 128 * 1024 * 1024;
+
+static Common::MemoryUsageCounter jit_usage("JIT code caches (reserved)");
+
 class ARM_Dynarmic_Callbacks : public Dynarmic::A64::UserCallbacks {
 public:
     explicit ARM_Dynarmic_Callbacks(ARM_Dynarmic& parent) : parent(parent) {}
@@ -55,15 +65,20 @@ public:
     }
 
     void InterpreterFallback(u64 pc, size_t num_instructions) override {
-        LOG_INFO(Core_ARM, "Unicorn fallback @ 0x%" PRIx64 " for %zu instructions (instr = %08x)",
-                 pc, num_instructions, MemoryReadCode(pc));
+        // Blocks that fall back do so every time they are executed, only report them once.
+        if (fallback_locations.insert(pc).second) {
+            LOG_INFO(Core_ARM,
+                     "Unicorn fallback @ 0x%" PRIx64 " for %zu instructions (instr = %08x)", pc,
+                     num_instructions, MemoryReadCode(pc));
+        }
 
-        ARM_Interface::ThreadContext ctx;
-        parent.SaveContext(ctx);
-        parent.inner_unicorn.LoadContext(ctx);
+        // The inner unicorn instance shares all memory mappings with the JIT, so only the
+        // register state has to be transferred.
+        parent.SaveContext(fallback_context);
+        parent.inner_unicorn.LoadContext(fallback_context);
         parent.inner_unicorn.ExecuteInstructions(static_cast<int>(num_instructions));
-        parent.inner_unicorn.SaveContext(ctx);
-        parent.LoadContext(ctx);
+        parent.inner_unicorn.SaveContext(fallback_context);
+        parent.LoadContext(fallback_context);
         num_interpreted_instructions += num_instructions;
     }
 
@@ -71,10 +86,29 @@ public:
         switch (exception) {
         case Dynarmic::A64::Exception::WaitForInterrupt:
         case Dynarmic::A64::Exception::WaitForEvent:
+            // The guest is waiting in a spin loop. Nothing it waits on can happen before the
+            // next timing event, so end the timeslice early.
+            CoreTiming::Idle();
+            return;
         case Dynarmic::A64::Exception::SendEvent:
         case Dynarmic::A64::Exception::SendEventLocal:
         case Dynarmic::A64::Exception::Yield:
             return;
+        case Dynarmic::A64::Exception::Breakpoint:
+            // Execute breakpoints of the gdbstub are BRK instructions written into guest code
+            if (GDBStub::IsConnected()) {
+                parent.jit->HaltExecution();
+                parent.SetPC(pc);
+                GDBStub::Break();
+                return;
+            }
+            // Left behind by a client that is gone. The instruction is run again once restored.
+            if (GDBStub::RestoreExecuteBreakpoints(pc)) {
+                parent.jit->HaltExecution();
+                parent.SetPC(pc);
+                return;
+            }
+            [[fallthrough]];
         default:
             ASSERT_MSG(false, "ExceptionRaised(exception = %zu, pc = %" PRIx64 ")",
                        static_cast<size_t>(exception), pc);
@@ -98,12 +132,14 @@ public:
 
     ARM_Dynarmic& parent;
     size_t num_interpreted_instructions = 0;
+    std::unordered_set<u64> fallback_locations;
+    ARM_Interface::ThreadContext fallback_context{};
     u64 tpidrro_el0 = 0;
     u64 tpidr_el0 = 0;
 };
 
-std::unique_ptr<Dynarmic::A64::Jit> MakeJit(const std::unique_ptr<ARM_Dynarmic_Callbacks>& cb) {
-    const auto page_table = Core::CurrentProcess()->vm_manager.page_table.pointers.data();
+std::unique_ptr<Dynarmic::A64::Jit> MakeJit(const std::unique_ptr<ARM_Dynarmic_Callbacks>& cb,
+                                            Memory::PageTable& page_table) {
 
     Dynarmic::A64::UserConfig config;
     config.callbacks = cb.get();
@@ -111,7 +147,7 @@ std::unique_ptr<Dynarmic::A64::Jit> MakeJit(const std::unique_ptr<ARM_Dynarmic_C
     config.tpidr_el0 = &cb->tpidr_el0;
     config.dczid_el0 = 4;
     config.ctr_el0 = 0x8444c004;
-    config.page_table = reinterpret_cast<void**>(page_table);
+    config.page_table = reinterpret_cast<void**>(page_table.pointers.data());
     config.page_table_address_space_bits = Memory::ADDRESS_SPACE_BITS;
     config.silently_mirror_page_table = false;
 
@@ -128,15 +164,16 @@ void ARM_Dynarmic::Step() {
     cb->InterpreterFallback(jit->GetPC(), 1);
 }
 
-ARM_Dynarmic::ARM_Dynarmic()
-    : cb(std::make_unique<ARM_Dynarmic_Callbacks>(*this)), jit(MakeJit(cb)) {
+ARM_Dynarmic::ARM_Dynarmic() : cb(std::make_unique<ARM_Dynarmic_Callbacks>(*this)) {
+    PageTableChanged();
     ARM_Interface::ThreadContext ctx;
     inner_unicorn.SaveContext(ctx);
     LoadContext(ctx);
-    PageTableChanged();
 }
 
-ARM_Dynarmic::~ARM_Dynarmic() = default;
+ARM_Dynarmic::~ARM_Dynarmic() {
+    jit_usage.Subtract(jits.size() * JIT_CODE_CACHE_SIZE);
+}
 
 void ARM_Dynarmic::MapBackingMemory(u64 address, size_t size, u8* memory,
                                     Kernel::VMAPermission perms) {
@@ -163,6 +200,11 @@ void ARM_Dynarmic::SetReg(int index, u64 value) {
     jit->SetRegister(index, value);
 }
 
+void ARM_Dynarmic::GetSvcRegisters(SvcRegisters& regs) const {
+    const auto registers = jit->GetRegisters();
+    std::copy_n(registers.begin(), regs.size(), regs.begin());
+}
+
 u128 ARM_Dynarmic::GetExtReg(int index) const {
     return jit->GetVector(index);
 }
@@ -196,24 +238,30 @@ void ARM_Dynarmic::SetTlsAddress(u64 address) {
     cb->tpidrro_el0 = address;
 }
 
-void ARM_Dynarmic::SaveContext(ARM_Interface::ThreadContext& ctx) {
+void ARM_Dynarmic::SaveGeneralContext(ARM_Interface::ThreadContext& ctx) {
     ctx.cpu_registers = jit->GetRegisters();
     ctx.sp = jit->GetSP();
     ctx.pc = jit->GetPC();
     ctx.cpsr = jit->GetPstate();
-    ctx.fpu_registers = jit->GetVectors();
-    ctx.fpscr = jit->GetFpcr();
     ctx.tls_address = cb->tpidrro_el0;
 }
 
-void ARM_Dynarmic::LoadContext(const ARM_Interface::ThreadContext& ctx) {
+void ARM_Dynarmic::LoadGeneralContext(const ARM_Interface::ThreadContext& ctx) {
     jit->SetRegisters(ctx.cpu_registers);
     jit->SetSP(ctx.sp);
     jit->SetPC(ctx.pc);
     jit->SetPstate(static_cast<u32>(ctx.cpsr));
+    cb->tpidrro_el0 = ctx.tls_address;
+}
+
+void ARM_Dynarmic::SaveVectorContext(ARM_Interface::ThreadContext& ctx) {
+    ctx.fpu_registers = jit->GetVectors();
+    ctx.fpscr = jit->GetFpcr();
+}
+
+void ARM_Dynarmic::LoadVectorContext(const ARM_Interface::ThreadContext& ctx) {
     jit->SetVectors(ctx.fpu_registers);
     jit->SetFpcr(static_cast<u32>(ctx.fpscr));
-    cb->tpidrro_el0 = ctx.tls_address;
 }
 
 void ARM_Dynarmic::PrepareReschedule() {
@@ -226,7 +274,42 @@ void ARM_Dynarmic::ClearInstructionCache() {
     jit->ClearCache();
 }
 
+void ARM_Dynarmic::InvalidateCacheRange(const Memory::PageTable* page_table, VAddr start,
+                                        size_t length) {
+    const auto iter = jits.find(page_table);
+    if (iter != jits.end()) {
+        iter->second->InvalidateCacheRange(start, length);
+    }
+}
+
 void ARM_Dynarmic::PageTableChanged() {
-    jit = MakeJit(cb);
     current_page_table = Memory::GetCurrentPageTable();
+
+    // No page table is current before the first thread gets scheduled, start out with the one of
+    // the current process in that case.
+    Memory::PageTable* const page_table =
+        current_page_table ? current_page_table : &Core::CurrentProcess()->vm_manager.page_table;
+
+    auto& cached_jit = jits[page_table];
+    if (!cached_jit) {
+        cached_jit = MakeJit(cb, *page_table);
+        jit_usage.Add(JIT_CODE_CACHE_SIZE);
+    }
+    jit = cached_jit.get();
+}
+
+void ARM_Dynarmic::PageTableReset(const Memory::PageTable* page_table) {
+    const auto iter = jits.find(page_table);
+    if (iter == jits.end()) {
+        return;
+    }
+
+    if (iter->second.get() == jit) {
+        // The page table stays current, only the code translated from its old contents is stale.
+        jit->ClearCache();
+        return;
+    }
+
+    jits.erase(iter);
+    jit_usage.Subtract(JIT_CODE_CACHE_SIZE);
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include <dynarmic/A64/a64.h>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
@@ -24,6 +25,7 @@ public:
     u64 GetPC() const override;
     u64 GetReg(int index) const override;
     void SetReg(int index, u64 value) override;
+    void GetSvcRegisters(SvcRegisters& regs) const override;
     u128 GetExtReg(int index) const override;
     void SetExtReg(int index, u128 value) override;
     u32 GetVFPReg(int index) const override;
@@ -35,18 +37,28 @@ public:
     VAddr GetTlsAddress() const override;
     void SetTlsAddress(VAddr address) override;
 
-    void SaveContext(ThreadContext& ctx) override;
-    void LoadContext(const ThreadContext& ctx) override;
+    void SaveGeneralContext(ThreadContext& ctx) override;
+    void LoadGeneralContext(const ThreadContext& ctx) override;
+    void SaveVectorContext(ThreadContext& ctx) override;
+    void LoadVectorContext(const ThreadContext& ctx) override;
 
     void PrepareReschedule() override;
 
     void ClearInstructionCache() override;
+    void InvalidateCacheRange(const Memory::PageTable* page_table, VAddr start,
+                              size_t length) override;
     void PageTableChanged() override;
+    void PageTableReset(const Memory::PageTable* page_table) override;
 
 private:
     friend class ARM_Dynarmic_Callbacks;
     std::unique_ptr<ARM_Dynarmic_Callbacks> cb;
-    std::unique_ptr<Dynarmic::A64::Jit> jit;
+
+    /// JIT instances for every page table that has been current, so that switching between
+    /// processes keeps the code translated for each of them.
+    std::unordered_map<const Memory::PageTable*, std::unique_ptr<Dynarmic::A64::Jit>> jits;
+    /// JIT instance for the current page table, owned by jits.
+    Dynarmic::A64::Jit* jit = nullptr;
     ARM_Unicorn inner_unicorn;
 
     Memory::PageTable* current_page_table = nullptr;
@@ -0,0 +1,149 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <type_traits>
+#include "common/assert.h"
+#include "common/atomic_ops.h"
+#include "core/arm/exclusive_monitor.h"
+#include "core/memory.h"
+
+namespace Core {
+
+namespace {
+
+template <typename T>
+T ReadGuest(VAddr address) {
+    if constexpr (std::is_same_v<T, u8>) {
+        return Memory::Read8(address);
+    } else if constexpr (std::is_same_v<T, u16>) {
+        return Memory::Read16(address);
+    } else if constexpr (std::is_same_v<T, u32>) {
+        return Memory::Read32(address);
+    } else {
+        return Memory::Read64(address);
+    }
+}
+
+template <typename T>
+void WriteGuest(VAddr address, T value) {
+    if constexpr (std::is_same_v<T, u8>) {
+        Memory::Write8(address, value);
+    } else if constexpr (std::is_same_v<T, u16>) {
+        Memory::Write16(address, value);
+    } else if constexpr (std::is_same_v<T, u32>) {
+        Memory::Write32(address, value);
+    } else {
+        Memory::Write64(address, value);
+    }
+}
+
+/// Returns a host pointer to address if it may be updated directly with host atomics.
+template <typename T>
+T* GetHostPointer(VAddr address) {
+    if (address % sizeof(T) != 0) {
+        return nullptr;
+    }
+
+    const Memory::PageTable* page_table = Memory::GetCurrentPageTable();
+    const size_t page_index = address >> Memory::PAGE_BITS;
+    if (page_table->attributes[page_index] != Memory::PageType::Memory) {
+        return nullptr;
+    }
+
+    u8* const page_pointer = page_table->pointers[page_index];
+    return reinterpret_cast<T*>(page_pointer + (address & Memory::PAGE_MASK));
+}
+
+} // namespace
+
+ExclusiveMonitor::ExclusiveMonitor(size_t core_count) : reservations(core_count) {}
+
+ExclusiveMonitor::~ExclusiveMonitor() = default;
+
+u8 ExclusiveMonitor::ExclusiveRead8(size_t core_index, VAddr address) {
+    return ExclusiveRead<u8>(core_index, address);
+}
+
+u16 ExclusiveMonitor::ExclusiveRead16(size_t core_index, VAddr address) {
+    return ExclusiveRead<u16>(core_index, address);
+}
+
+u32 ExclusiveMonitor::ExclusiveRead32(size_t core_index, VAddr address) {
+    return ExclusiveRead<u32>(core_index, address);
+}
+
+u64 ExclusiveMonitor::ExclusiveRead64(size_t core_index, VAddr address) {
+    return ExclusiveRead<u64>(core_index, address);
+}
+
+bool ExclusiveMonitor::ExclusiveWrite8(size_t core_index, VAddr address, u8 value) {
+    return ExclusiveWrite<u8>(core_index, address, value);
+}
+
+bool ExclusiveMonitor::ExclusiveWrite16(size_t core_index, VAddr address, u16 value) {
+    return ExclusiveWrite<u16>(core_index, address, value);
+}
+
+bool ExclusiveMonitor::ExclusiveWrite32(size_t core_index, VAddr address, u32 value) {
+    return ExclusiveWrite<u32>(core_index, address, value);
+}
+
+bool ExclusiveMonitor::ExclusiveWrite64(size_t core_index, VAddr address, u64 value) {
+    return ExclusiveWrite<u64>(core_index, address, value);
+}
+
+void ExclusiveMonitor::ClearExclusive(size_t core_index) {
+    ASSERT(core_index < reservations.size());
+    reservations[core_index].valid = false;
+}
+
+bool ExclusiveMonitor::CompareExchange32(VAddr address, u32 expected, u32 desired) {
+    return CompareExchange<u32>(address, expected, desired);
+}
+
+template <typename T>
+T ExclusiveMonitor::ExclusiveRead(size_t core_index, VAddr address) {
+    ASSERT(core_index < reservations.size());
+
+    const T value = ReadGuest<T>(address);
+    reservations[core_index] = {true, address, value};
+    return value;
+}
+
+template <typename T>
+bool ExclusiveMonitor::ExclusiveWrite(size_t core_index, VAddr address, T value) {
+    ASSERT(core_index < reservations.size());
+
+    Reservation& reservation = reservations[core_index];
+    const bool reserved = reservation.valid && reservation.address == address;
+    reservation.valid = false;
+
+    if (!reserved) {
+        return false;
+    }
+
+    return CompareExchange<T>(address, static_cast<T>(reservation.value), value);
+}
+
+template <typename T>
+bool ExclusiveMonitor::CompareExchange(VAddr address, T expected, T desired) {
+    if (T* const pointer = GetHostPointer<T>(address)) {
+        return Common::AtomicCompareAndSwap(pointer, desired, expected);
+    }
+
+    std::lock_guard<std::mutex> lock(GetStripe(address));
+    if (ReadGuest<T>(address) != expected) {
+        return false;
+    }
+
+    WriteGuest<T>(address, desired);
+    return true;
+}
+
+std::mutex& ExclusiveMonitor::GetStripe(VAddr address) {
+    // Stripe by 16-byte granule, so that all accesses within one granule share a lock.
+    return stripes[(address >> 4) % STRIPE_COUNT];
+}
+
+} // namespace Core
@@ -0,0 +1,81 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Global exclusive monitor shared by all emulated cores.
+ *
+ * Each core holds at most one reservation, consisting of the reserved address and the value that
+ * was observed by the exclusive load. An exclusive store succeeds only if memory still holds that
+ * value, which is checked with a host compare-and-swap when the address is backed by host memory.
+ * Addresses without a direct host mapping fall back to a lock selected by the address, so that
+ * distinct addresses never contend on a single lock.
+ */
+class ExclusiveMonitor final : NonCopyable {
+public:
+    explicit ExclusiveMonitor(size_t core_count);
+    ~ExclusiveMonitor();
+
+    /// Reads a value and places a reservation on its address for the given core.
+    u8 ExclusiveRead8(size_t core_index, VAddr address);
+    u16 ExclusiveRead16(size_t core_index, VAddr address);
+    u32 ExclusiveRead32(size_t core_index, VAddr address);
+    u64 ExclusiveRead64(size_t core_index, VAddr address);
+
+    /**
+     * Writes a value if the given core still holds a valid reservation on the address.
+     * The reservation is consumed regardless of the outcome.
+     * @return true if the store took place.
+     */
+    bool ExclusiveWrite8(size_t core_index, VAddr address, u8 value);
+    bool ExclusiveWrite16(size_t core_index, VAddr address, u16 value);
+    bool ExclusiveWrite32(size_t core_index, VAddr address, u32 value);
+    bool ExclusiveWrite64(size_t core_index, VAddr address, u64 value);
+
+    /// Drops the reservation held by the given core, if any.
+    void ClearExclusive(size_t core_index);
+
+    /**
+     * Atomically replaces the guest word at address with desired if it currently holds expected.
+     * Intended for HLE code that updates guest synchronization words (e.g. mutex tags).
+     * @return true if the exchange took place.
+     */
+    bool CompareExchange32(VAddr address, u32 expected, u32 desired);
+
+private:
+    struct Reservation {
+        bool valid = false;
+        VAddr address = 0;
+        u64 value = 0;
+    };
+
+    template <typename T>
+    T ExclusiveRead(size_t core_index, VAddr address);
+
+    template <typename T>
+    bool ExclusiveWrite(size_t core_index, VAddr address, T value);
+
+    template <typename T>
+    bool CompareExchange(VAddr address, T expected, T desired);
+
+    std::mutex& GetStripe(VAddr address);
+
+    static constexpr size_t STRIPE_COUNT = 64;
+
+    /// Per-core reservations. Each entry is only ever accessed by the thread running that core.
+    std::vector<Reservation> reservations;
+
+    /// Locks guarding accesses to addresses that can't be updated with a host CAS.
+    std::array<std::mutex, STRIPE_COUNT> stripes;
+};
+
+} // namespace Core
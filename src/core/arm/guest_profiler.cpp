@@ -0,0 +1,104 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <iterator>
+#include <map>
+#include <unordered_map>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "common/string_util.h"
+#include "core/arm/guest_profiler.h"
+#include "core/settings.h"
+
+namespace GuestProfiler {
+
+struct Module {
+    std::string name;
+    VAddr end;
+};
+
+/// Loaded modules, keyed by base address
+static std::map<VAddr, Module> modules;
+/// Symbol names, keyed by address
+static std::map<VAddr, std::string> symbols;
+/// Accumulated ticks, keyed by guest PC
+static std::unordered_map<VAddr, u64> samples;
+
+/// Looks up the entry of map that starts at or before address, if any.
+template <typename Map>
+static auto FindPreceding(const Map& map, VAddr address) {
+    auto iter = map.upper_bound(address);
+    return iter == map.begin() ? map.end() : std::prev(iter);
+}
+
+bool IsEnabled() {
+    return Settings::values.profile_guest_code;
+}
+
+void RegisterModule(const std::string& path, VAddr base, u64 size) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    std::string name;
+    if (!Common::SplitPath(path, nullptr, &name, nullptr) || name.empty()) {
+        name = path;
+    }
+    modules[base] = {std::move(name), base + size};
+}
+
+void RegisterSymbol(const std::string& name, VAddr address) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    symbols.emplace(address, name);
+}
+
+void AddSample(VAddr pc, u64 ticks) {
+    samples[pc] += ticks;
+}
+
+bool WriteFoldedStacks(const std::string& path) {
+    // Aggregate by frame first, most of the samples share the same module and symbol.
+    std::map<std::string, u64> stacks;
+    for (const auto& sample : samples) {
+        const VAddr pc = sample.first;
+
+        std::string module_name = "[unknown]";
+        VAddr module_base = 0;
+        const auto module = FindPreceding(modules, pc);
+        const bool in_module = module != modules.end() && pc < module->second.end;
+        if (in_module) {
+            module_name = module->second.name;
+            module_base = module->first;
+        }
+
+        // Without a symbol of the same module, fall back to the module relative offset.
+        std::string symbol_name;
+        const auto symbol = FindPreceding(symbols, pc);
+        if (in_module && symbol != symbols.end() && symbol->first >= module_base) {
+            symbol_name = symbol->second;
+        } else {
+            symbol_name = fmt::format("{:#x}", pc - module_base);
+        }
+
+        stacks[module_name + ';' + symbol_name] += sample.second;
+    }
+
+    std::string output;
+    for (const auto& stack : stacks) {
+        output += fmt::format("{} {}\n", stack.first, stack.second);
+    }
+
+    return FileUtil::WriteStringToFile(true, output, path.c_str()) == output.size();
+}
+
+void Reset() {
+    modules.clear();
+    symbols.clear();
+    samples.clear();
+}
+
+} // namespace GuestProfiler
@@ -0,0 +1,44 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "common/common_types.h"
+
+/**
+ * Sampling profiler for guest code. When enabled through Settings::values.profile_guest_code, the
+ * run loop records the guest PC at the end of every timeslice along with the number of ticks the
+ * slice took. Samples are attributed to the loaded modules and their exported symbols, and can be
+ * written out in the folded stack format understood by flame graph tools.
+ */
+namespace GuestProfiler {
+
+/// Returns whether guest code profiling is enabled.
+bool IsEnabled();
+
+/**
+ * Registers a loaded module, so that samples within it can be attributed to it.
+ * @param path Path the module was loaded from, only its file name is kept.
+ * @param base Address the module was loaded at.
+ * @param size Size of the module's memory image.
+ */
+void RegisterModule(const std::string& path, VAddr base, u64 size);
+
+/// Registers a named symbol. Samples are attributed to the closest preceding symbol.
+void RegisterSymbol(const std::string& name, VAddr address);
+
+/// Records that the guest was executing at pc during a timeslice of the given length.
+void AddSample(VAddr pc, u64 ticks);
+
+/**
+ * Writes the collected samples as "module;symbol ticks" lines.
+ * @return true if the file was written successfully.
+ */
+bool WriteFoldedStacks(const std::string& path);
+
+/// Discards all registered modules, symbols and samples.
+void Reset();
+
+} // namespace GuestProfiler
@@ -170,7 +170,7 @@ void ARM_Unicorn::ExecuteInstructions(int num_instructions) {
     CoreTiming::AddTicks(num_instructions);
 }
 
-void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
+void ARM_Unicorn::SaveGeneralContext(ARM_Interface::ThreadContext& ctx) {
     int uregs[32];
     void* tregs[32];
 
@@ -190,6 +190,11 @@ void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
     CHECKED(uc_reg_read_batch(uc, uregs, tregs, 31));
 
     ctx.tls_address = GetTlsAddress();
+}
+
+void ARM_Unicorn::SaveVectorContext(ARM_Interface::ThreadContext& ctx) {
+    int uregs[32];
+    void* tregs[32];
 
     for (int i = 0; i < 32; ++i) {
         uregs[i] = UC_ARM64_REG_Q0 + i;
@@ -199,7 +204,7 @@ void ARM_Unicorn::SaveContext(ARM_Interface::ThreadContext& ctx) {
     CHECKED(uc_reg_read_batch(uc, uregs, tregs, 32));
 }
 
-void ARM_Unicorn::LoadContext(const ARM_Interface::ThreadContext& ctx) {
+void ARM_Unicorn::LoadGeneralContext(const ARM_Interface::ThreadContext& ctx) {
     int uregs[32];
     void* tregs[32];
 
@@ -219,6 +224,11 @@ void ARM_Unicorn::LoadContext(const ARM_Interface::ThreadContext& ctx) {
     CHECKED(uc_reg_write_batch(uc, uregs, tregs, 31));
 
     SetTlsAddress(ctx.tls_address);
+}
+
+void ARM_Unicorn::LoadVectorContext(const ARM_Interface::ThreadContext& ctx) {
+    int uregs[32];
+    void* tregs[32];
 
     for (auto i = 0; i < 32; ++i) {
         uregs[i] = UC_ARM64_REG_Q0 + i;
@@ -27,13 +27,17 @@ public:
     void SetCPSR(u32 cpsr) override;
     VAddr GetTlsAddress() const override;
     void SetTlsAddress(VAddr address) override;
-    void SaveContext(ThreadContext& ctx) override;
-    void LoadContext(const ThreadContext& ctx) override;
+    void SaveGeneralContext(ThreadContext& ctx) override;
+    void LoadGeneralContext(const ThreadContext& ctx) override;
+    void SaveVectorContext(ThreadContext& ctx) override;
+    void LoadVectorContext(const ThreadContext& ctx) override;
     void PrepareReschedule() override;
     void ExecuteInstructions(int num_instructions);
     void Run() override;
     void Step() override;
     void ClearInstructionCache() override;
+    void InvalidateCacheRange(const Memory::PageTable* page_table, VAddr start,
+                              size_t length) override{};
     void PageTableChanged() override{};
 
 private:
@@ -2,36 +2,60 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
 #include <memory>
 #include <utility>
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
 #ifdef ARCHITECTURE_x86_64
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #endif
+#include "core/arm/exclusive_monitor.h"
+#include "core/arm/guest_profiler.h"
 #include "core/arm/unicorn/arm_unicorn.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/file_sys/cached_storage.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
+#include "core/hle/kernel/snapshot.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/service/ipc_recorder.h"
 #include "core/hle/service/service.h"
 #include "core/hw/hw.h"
 #include "core/loader/loader.h"
+#include "core/memory.h"
 #include "core/memory_setup.h"
+#include "core/metrics_exporter.h"
+#include "core/movie.h"
 #include "core/settings.h"
+#include "video_core/gpu_trace_player.h"
+#include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
 namespace Core {
 
 /*static*/ System System::s_instance;
 
+System::System() = default;
+System::~System() = default;
+
 System::ResultStatus System::RunLoop(bool tight_loop) {
     status = ResultStatus::Success;
     if (!cpu_core) {
         return ResultStatus::ErrorNotInitialized;
     }
 
+    if (gpu_trace_player) {
+        if (!gpu_trace_finished && !gpu_trace_player->PlayFrame()) {
+            LOG_INFO(Core, "Replayed the whole GPU trace");
+            gpu_trace_finished = true;
+        }
+        return status;
+    }
+
     if (GDBStub::IsServerEnabled()) {
         GDBStub::HandlePacket();
 
@@ -56,19 +80,40 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         PrepareReschedule();
     } else {
         CoreTiming::Advance();
-        if (tight_loop) {
-            cpu_core->Run();
-        } else {
-            cpu_core->Step();
+        const u64 ticks_before = CoreTiming::GetTicks();
+        {
+            PerfStats::SubsystemScope scope(perf_stats, PerfStats::Subsystem::CpuJit);
+            if (tight_loop) {
+                cpu_core->Run();
+            } else {
+                cpu_core->Step();
+            }
+        }
+        if (GuestProfiler::IsEnabled()) {
+            GuestProfiler::AddSample(cpu_core->GetPC(), CoreTiming::GetTicks() - ticks_before);
         }
     }
 
     HW::Update();
     Reschedule();
+    Kernel::CaptureSnapshotIfRequested();
+    LogMemoryUsageIfDue();
 
     return status;
 }
 
+void System::LogMemoryUsageIfDue() {
+    if (Settings::values.memory_usage_log_interval == 0) {
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now();
+    if (now < next_memory_usage_log) {
+        return;
+    }
+    Common::LogMemoryUsage();
+    next_memory_usage_log = now + std::chrono::seconds(Settings::values.memory_usage_log_interval);
+}
+
 System::ResultStatus System::SingleStep() {
     return RunLoop(false);
 }
@@ -127,6 +172,29 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
     return status;
 }
 
+System::ResultStatus System::LoadGPUTrace(EmuWindow* emu_window, const std::string& filepath) {
+    // The default system mode of the loaders, the kernel is only needed for the process memory
+    constexpr u32 SYSTEM_MODE = 2;
+    ResultStatus init_result{Init(emu_window, SYSTEM_MODE)};
+    if (init_result != ResultStatus::Success) {
+        LOG_CRITICAL(Core, "Failed to initialize system (Error %i)!",
+                     static_cast<int>(init_result));
+        System::Shutdown();
+        return init_result;
+    }
+
+    gpu_trace_player = std::make_unique<Tegra::GPUTracePlayer>(*gpu_core);
+    if (!gpu_trace_player->Load(filepath, *current_process)) {
+        System::Shutdown();
+        return ResultStatus::ErrorLoader;
+    }
+    Memory::SetCurrentPageTable(&current_process->vm_manager.page_table);
+    gpu_trace_finished = false;
+
+    status = ResultStatus::Success;
+    return status;
+}
+
 void System::PrepareReschedule() {
     cpu_core->PrepareReschedule();
     reschedule_pending = true;
@@ -149,6 +217,9 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
     LOG_DEBUG(HW_Memory, "initialized OK");
 
     CoreTiming::Init();
+    CoreTiming::SetHostSynchronized(Settings::values.use_host_timing);
+    CoreTiming::SetEventStatsEnabled(Settings::values.profile_timing_events);
+    Service::IPCRecorder::SetEnabled(Settings::values.record_ipc_calls);
 
     current_process = Kernel::Process::Create("main");
 
@@ -163,21 +234,50 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
         cpu_core = std::make_shared<ARM_Unicorn>();
     }
 
+    exclusive_monitor = std::make_unique<ExclusiveMonitor>(1);
     gpu_core = std::make_unique<Tegra::GPU>();
 
     telemetry_session = std::make_unique<Core::TelemetrySession>();
 
     HW::Init();
+    Memory::Init();
     Kernel::Init(system_mode);
     scheduler = std::make_unique<Kernel::Scheduler>(cpu_core.get());
     Service::Init();
     GDBStub::Init();
 
+    if (emu_window != nullptr) {
+        const ResultStatus video_result = AttachWindow(emu_window);
+        if (video_result != ResultStatus::Success) {
+            return video_result;
+        }
+    }
+
+    LOG_DEBUG(Core, "Initialized OK");
+
+    return ResultStatus::Success;
+}
+
+System::ResultStatus System::AttachWindow(EmuWindow* emu_window) {
     if (!VideoCore::Init(emu_window)) {
         return ResultStatus::ErrorVideoCore;
     }
+    if (Settings::values.record_gpu_trace) {
+        gpu_core->StartTrace();
+    }
+    if (Settings::values.use_asynchronous_gpu_emulation) {
+        gpu_core->StartThread(*VideoCore::g_renderer, *emu_window);
+    }
 
-    LOG_DEBUG(Core, "Initialized OK");
+    // The system may have been loaded a while ago, so the host clock starts over from here
+    CoreTiming::SetHostSynchronized(Settings::values.use_host_timing);
+
+    if (Settings::values.metrics_export_port != 0) {
+        metrics_exporter = std::make_unique<MetricsExporter>(perf_stats);
+        if (!metrics_exporter->Start(Settings::values.metrics_export_port)) {
+            metrics_exporter = nullptr;
+        }
+    }
 
     // Reset counters and set time origin to current frame
     GetAndResetPerfStats();
@@ -186,6 +286,24 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
     return ResultStatus::Success;
 }
 
+void System::InitKernel(std::shared_ptr<ARM_Interface> cpu, u32 system_mode) {
+    CoreTiming::Init();
+
+    cpu_core = std::move(cpu);
+    exclusive_monitor = std::make_unique<ExclusiveMonitor>(1);
+
+    Kernel::Init(system_mode);
+    scheduler = std::make_unique<Kernel::Scheduler>(cpu_core.get());
+}
+
+void System::ShutdownKernel() {
+    scheduler = nullptr;
+    Kernel::Shutdown();
+    exclusive_monitor = nullptr;
+    cpu_core = nullptr;
+    CoreTiming::Shutdown();
+}
+
 void System::Shutdown() {
     // Log last frame performance stats
     auto perf_results = GetAndResetPerfStats();
@@ -195,21 +313,56 @@ void System::Shutdown() {
                          perf_results.game_fps);
     Telemetry().AddField(Telemetry::FieldType::Performance, "Shutdown_Frametime",
                          perf_results.frametime * 1000.0);
+    Telemetry().AddPerformanceFields(CoreTiming::GetGlobalTimeUs());
 
     // Shutdown emulation session
+    metrics_exporter = nullptr;
+    gpu_trace_player = nullptr;
+    if (gpu_core) {
+        gpu_core->StopThread();
+        gpu_core->FinishTrace(FileUtil::GetUserPath(D_LOGS_IDX) + "gpu_trace.ctf");
+    }
     VideoCore::Shutdown();
     GDBStub::Shutdown();
     Service::Shutdown();
+    Movie::GetInstance().Shutdown();
     scheduler = nullptr;
+    Kernel::ClearSnapshots();
     Kernel::Shutdown();
     HW::Shutdown();
     telemetry_session = nullptr;
     gpu_core = nullptr;
+    exclusive_monitor = nullptr;
     cpu_core = nullptr;
     CoreTiming::Shutdown();
 
     app_loader = nullptr;
 
+    if (GuestProfiler::IsEnabled()) {
+        const std::string profile_path =
+            FileUtil::GetUserPath(D_LOGS_IDX) + "guest_profile.folded";
+        if (!GuestProfiler::WriteFoldedStacks(profile_path)) {
+            LOG_ERROR(Core, "Failed to write guest profile to %s", profile_path.c_str());
+        }
+    }
+    GuestProfiler::Reset();
+
+    if (Settings::values.record_ipc_calls) {
+        const std::string stats_path = FileUtil::GetUserPath(D_LOGS_IDX) + "ipc_calls.csv";
+        if (!Service::IPCRecorder::WriteCSV(stats_path)) {
+            LOG_ERROR(Core, "Failed to write IPC statistics to %s", stats_path.c_str());
+        }
+    }
+    Service::IPCRecorder::SetEnabled(false);
+    Service::IPCRecorder::Reset();
+
+    const FileSys::StorageCacheStats cache_stats = FileSys::GetStorageCacheStats();
+    LOG_DEBUG(Core,
+              "Storage cache: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64
+              " blocks read ahead, %" PRIu64 " evictions",
+              cache_stats.hits, cache_stats.misses, cache_stats.read_ahead_blocks,
+              cache_stats.evictions);
+
     LOG_DEBUG(Core, "Shutdown OK");
 }
 
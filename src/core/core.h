@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 #include "common/common_types.h"
@@ -19,8 +20,15 @@
 class EmuWindow;
 class ARM_Interface;
 
+namespace Tegra {
+class GPUTracePlayer;
+} // namespace Tegra
+
 namespace Core {
 
+class ExclusiveMonitor;
+class MetricsExporter;
+
 class System {
 public:
     /**
@@ -31,6 +39,9 @@ public:
         return s_instance;
     }
 
+    System();
+    ~System();
+
     /// Enumeration representing the return values of the System Initialize and Load process.
     enum class ResultStatus : u32 {
         Success,                    ///< Succeeded
@@ -69,14 +80,50 @@ public:
     /// Shutdown the emulated system.
     void Shutdown();
 
+    /**
+     * Initialize only the timing and kernel parts of the emulated system, without a window,
+     * services or an application. The current process and its page table are left as they are,
+     * so the caller sets them up. Used by tests that issue SVCs through Kernel::CallSVC directly.
+     * @param cpu CPU the threads are switched on, which may not execute any code.
+     * @param system_mode The system mode.
+     */
+    void InitKernel(std::shared_ptr<ARM_Interface> cpu, u32 system_mode);
+
+    /// Shutdown the parts of the emulated system initialized by InitKernel.
+    void ShutdownKernel();
+
     /**
      * Load an executable application.
      * @param emu_window Pointer to the host-system window used for video output and keyboard input.
+     * May be null to leave the video core to AttachWindow, which has to be called before running.
      * @param filepath String path to the executable application to load on the host file system.
      * @returns ResultStatus code, indicating if the operation succeeded.
      */
     ResultStatus Load(EmuWindow* emu_window, const std::string& filepath);
 
+    /**
+     * Initialize the video core and the metrics exporter of a system that was loaded without a
+     * window. Until then the system runs no host threads of its own, so it can be forked to run
+     * several times from the same boot.
+     * @param emu_window Pointer to the host-system window used for video output.
+     * @returns ResultStatus code, indicating if the operation succeeded.
+     */
+    ResultStatus AttachWindow(EmuWindow* emu_window);
+
+    /**
+     * Load a GPU trace recorded with record_gpu_trace, to be replayed instead of running an
+     * application. Each RunLoop then replays a frame of the trace, and the CPU doesn't run.
+     * @param emu_window Pointer to the host-system window used for video output.
+     * @param filepath String path to the trace on the host file system.
+     * @returns ResultStatus code, indicating if the operation succeeded.
+     */
+    ResultStatus LoadGPUTrace(EmuWindow* emu_window, const std::string& filepath);
+
+    /// Whether the GPU trace being replayed has been replayed to its end.
+    bool IsGPUTraceFinished() const {
+        return gpu_trace_finished;
+    }
+
     /**
      * Indicates if the emulated system is powered on (all subsystems initialized and able to run an
      * application).
@@ -111,6 +158,11 @@ public:
         return *gpu_core;
     }
 
+    /// Gets the exclusive monitor shared by all emulated cores.
+    ExclusiveMonitor& Monitor() {
+        return *exclusive_monitor;
+    }
+
     Kernel::Scheduler& Scheduler() {
         return *scheduler;
     }
@@ -148,7 +200,8 @@ public:
 private:
     /**
      * Initialize the emulated system.
-     * @param emu_window Pointer to the host-system window used for video output and keyboard input.
+     * @param emu_window Pointer to the host-system window used for video output and keyboard input,
+     * or null to leave the video core to AttachWindow.
      * @param system_mode The system mode.
      * @return ResultStatus code, indicating if the operation succeeded.
      */
@@ -157,13 +210,21 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Writes the memory usage statistics to the log when the interval set in the settings passed
+    void LogMemoryUsageIfDue();
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
     std::shared_ptr<ARM_Interface> cpu_core;
+    std::unique_ptr<ExclusiveMonitor> exclusive_monitor;
     std::unique_ptr<Kernel::Scheduler> scheduler;
     std::unique_ptr<Tegra::GPU> gpu_core;
 
+    /// Player of the GPU trace loaded with LoadGPUTrace, if any
+    std::unique_ptr<Tegra::GPUTracePlayer> gpu_trace_player;
+    bool gpu_trace_finished = false;
+
     std::shared_ptr<Tegra::DebugContext> debug_context;
 
     Kernel::SharedPtr<Kernel::Process> current_process;
@@ -171,9 +232,15 @@ private:
     /// When true, signals that a reschedule should happen
     bool reschedule_pending{};
 
+    /// Walltime the memory usage statistics are written to the log next
+    std::chrono::steady_clock::time_point next_memory_usage_log{};
+
     /// Telemetry session for this emulation session
     std::unique_ptr<Core::TelemetrySession> telemetry_session;
 
+    /// Serves the statistics while the system runs, if enabled in the settings
+    std::unique_ptr<MetricsExporter> metrics_exporter;
+
     static System s_instance;
 
     ResultStatus status = ResultStatus::Success;
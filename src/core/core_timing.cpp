@@ -5,14 +5,21 @@
 #include "core/core_timing.h"
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cinttypes>
+#include <limits>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
 #include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/chunk_file.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "common/thread.h"
 #include "common/threadsafe_queue.h"
 
@@ -22,9 +29,31 @@ static s64 global_timer;
 static int slice_length;
 static int downcount;
 
+/// Index of an event in the event pool, used to link events without pointers into the pool.
+using EventIndex = u32;
+static constexpr EventIndex INVALID_EVENT = std::numeric_limits<EventIndex>::max();
+
+struct EventTypeStats {
+    static constexpr size_t NUM_LATENESS_BUCKETS = 16;
+
+    u64 num_calls = 0;
+    std::chrono::nanoseconds host_time{};
+    s64 max_cycles_late = 0;
+    /// Bucket 0 counts calls that were on time, bucket i calls that were late by [2^(i-1), 2^i)
+    /// cycles. The last bucket also counts everything later than that.
+    std::array<u64, NUM_LATENESS_BUCKETS> lateness{};
+};
+
 struct EventType {
     TimedCallback callback;
     const std::string* name;
+    /// Head of the list of pending events of this type. This is queue bookkeeping rather than
+    /// part of the type itself, so it may be updated through the const handles given to callers.
+    mutable EventIndex first_pending = INVALID_EVENT;
+    mutable EventTypeStats stats;
+#if MICROPROFILE_ENABLED
+    MicroProfileToken profile_token = 0;
+#endif
 };
 
 struct Event {
@@ -32,6 +61,15 @@ struct Event {
     u64 fifo_order;
     u64 userdata;
     const EventType* type;
+
+    /// Links within the wheel slot the event is filed in.
+    EventIndex prev = INVALID_EVENT;
+    EventIndex next = INVALID_EVENT;
+    /// Links within the list of pending events of the same type.
+    EventIndex prev_of_type = INVALID_EVENT;
+    EventIndex next_of_type = INVALID_EVENT;
+    /// Wheel slot the event is filed in, or one of the special lists below.
+    u32 list = 0;
 };
 
 // Sort by time, unless the times are the same, in which case sort by the order added to the queue
@@ -39,23 +77,48 @@ static bool operator>(const Event& left, const Event& right) {
     return std::tie(left.time, left.fifo_order) > std::tie(right.time, right.fifo_order);
 }
 
-static bool operator<(const Event& left, const Event& right) {
-    return std::tie(left.time, left.fifo_order) < std::tie(right.time, right.fifo_order);
-}
-
 // unordered_map stores each element separately as a linked list node so pointers to elements
 // remain stable regardless of rehashes/resizing.
 static std::unordered_map<std::string, EventType> event_types;
 
-// The queue is a min-heap using std::make_heap/push_heap/pop_heap.
-// We don't use std::priority_queue because we need to be able to serialize, unserialize and
-// erase arbitrary events (RemoveEvent()) regardless of the queue order. These aren't accomodated
-// by the standard adaptor class.
-static std::vector<Event> event_queue;
+// Pending events are kept in a hierarchical timing wheel. Each level has 64 slots and each slot of
+// a level spans a whole revolution of the level below it, so level 0 slots hold a single cycle and
+// the top level slots hold 2^30 cycles (about a second). An event is filed at the lowest level
+// where its time shares all higher bits with wheel_time, which makes scheduling and unscheduling
+// O(1). As wheel_time advances, slots of the higher levels are cascaded down. Events that are due
+// are moved to due_events, which is kept sorted by (time, fifo_order) so that events still fire in
+// a deterministic order.
+static constexpr u32 WHEEL_SLOT_BITS = 6;
+static constexpr u32 WHEEL_SLOTS = 1U << WHEEL_SLOT_BITS;
+static constexpr u32 WHEEL_LEVELS = 6;
+/// Events too far into the future for the wheel. Re-filed when wheel_time catches up with them.
+static constexpr u32 OVERFLOW_LIST = WHEEL_LEVELS * WHEEL_SLOTS;
+/// Events that are due, tracked by due_events rather than a linked list.
+static constexpr u32 DUE_LIST = OVERFLOW_LIST + 1;
+
+static std::vector<Event> event_pool;
+static EventIndex free_events = INVALID_EVENT;
+static size_t num_pending_events;
+static std::array<EventIndex, OVERFLOW_LIST + 1> wheel_lists;
+static std::array<u64, WHEEL_LEVELS> occupied_slots;
+static s64 wheel_time;
+// Sorted in descending order so that the earliest event can be popped from the back.
+static std::vector<EventIndex> due_events;
+
 static u64 event_fifo_id;
+
+/// An event scheduled from another thread, waiting to be filed by the emu thread.
+struct ThreadsafeEvent {
+    s64 time;
+    u64 userdata;
+    const EventType* type;
+};
+
 // the queue for storing the events from other threads threadsafe until they will be added
-// to the event_queue by the emu thread
-static Common::MPSCQueue<Event, false> ts_queue;
+// to the timing wheel by the emu thread. It is drained at the start of every slice, so it only
+// has to hold what other threads can post within one slice.
+static Common::MPSCRingQueue<ThreadsafeEvent, 1024> ts_queue;
+static ThreadsafeEventStats ts_stats;
 
 static constexpr int MAX_SLICE_LENGTH = 20000;
 
@@ -68,8 +131,272 @@ static bool is_global_timer_sane;
 
 static EventType* ev_lost = nullptr;
 
+// When synchronized with the host, global_timer is kept within MAX_HOST_SKEW cycles of the time
+// that has passed on the host's steady clock since host_sync_start.
+static bool host_synchronized;
+static std::chrono::steady_clock::time_point host_sync_start;
+static s64 host_sync_start_ticks;
+static constexpr s64 MAX_HOST_SKEW = BASE_CLOCK_RATE / 1000;
+// Falling further behind than this is taken to be a stall (e.g. emulation being paused) rather
+// than slow emulation. Catching up would fire every periodic event missed in the meantime, so the
+// host clock is rebased instead.
+static constexpr s64 MAX_HOST_LAG = BASE_CLOCK_RATE / 10;
+
+static bool event_stats_enabled;
+
 static void EmptyTimedCallback(u64 userdata, s64 cyclesLate) {}
 
+static EventIndex AllocateEvent(const Event& event) {
+    EventIndex index;
+    if (free_events != INVALID_EVENT) {
+        index = free_events;
+        free_events = event_pool[index].next;
+        event_pool[index] = event;
+    } else {
+        index = static_cast<EventIndex>(event_pool.size());
+        event_pool.push_back(event);
+    }
+
+    Event& new_event = event_pool[index];
+    new_event.prev_of_type = INVALID_EVENT;
+    new_event.next_of_type = new_event.type->first_pending;
+    if (new_event.next_of_type != INVALID_EVENT) {
+        event_pool[new_event.next_of_type].prev_of_type = index;
+    }
+    new_event.type->first_pending = index;
+
+    ++num_pending_events;
+    return index;
+}
+
+static void FreeEvent(EventIndex index) {
+    Event& event = event_pool[index];
+    if (event.prev_of_type != INVALID_EVENT) {
+        event_pool[event.prev_of_type].next_of_type = event.next_of_type;
+    } else {
+        event.type->first_pending = event.next_of_type;
+    }
+    if (event.next_of_type != INVALID_EVENT) {
+        event_pool[event.next_of_type].prev_of_type = event.prev_of_type;
+    }
+
+    // Marks the slot as free for handles that still refer to it
+    event.type = nullptr;
+    event.next = free_events;
+    free_events = index;
+    --num_pending_events;
+}
+
+static void InsertDueEvent(EventIndex index) {
+    const Event& event = event_pool[index];
+    const auto itr = std::lower_bound(
+        due_events.begin(), due_events.end(), event,
+        [](EventIndex other, const Event& value) { return event_pool[other] > value; });
+    due_events.insert(itr, index);
+    event_pool[index].list = DUE_LIST;
+}
+
+static void LinkEvent(EventIndex index, u32 list) {
+    Event& event = event_pool[index];
+    event.list = list;
+    event.prev = INVALID_EVENT;
+    event.next = wheel_lists[list];
+    if (event.next != INVALID_EVENT) {
+        event_pool[event.next].prev = index;
+    }
+    wheel_lists[list] = index;
+
+    if (list != OVERFLOW_LIST) {
+        occupied_slots[list / WHEEL_SLOTS] |= u64(1) << (list % WHEEL_SLOTS);
+    }
+}
+
+static void UnlinkEvent(EventIndex index) {
+    const Event& event = event_pool[index];
+    if (event.list == DUE_LIST) {
+        due_events.erase(std::find(due_events.begin(), due_events.end(), index));
+        return;
+    }
+
+    if (event.prev != INVALID_EVENT) {
+        event_pool[event.prev].next = event.next;
+    } else {
+        wheel_lists[event.list] = event.next;
+    }
+    if (event.next != INVALID_EVENT) {
+        event_pool[event.next].prev = event.prev;
+    }
+
+    if (event.list != OVERFLOW_LIST && wheel_lists[event.list] == INVALID_EVENT) {
+        occupied_slots[event.list / WHEEL_SLOTS] &= ~(u64(1) << (event.list % WHEEL_SLOTS));
+    }
+}
+
+/// Files an event into the wheel relative to the current wheel_time.
+static void FileEvent(EventIndex index) {
+    const s64 time = event_pool[index].time;
+    if (time <= wheel_time) {
+        InsertDueEvent(index);
+        return;
+    }
+
+    const u64 differing_bits = static_cast<u64>(time) ^ static_cast<u64>(wheel_time);
+    for (u32 level = 0; level < WHEEL_LEVELS; ++level) {
+        const u32 shift = level * WHEEL_SLOT_BITS;
+        if ((differing_bits >> (shift + WHEEL_SLOT_BITS)) == 0) {
+            const u32 slot = static_cast<u32>(time >> shift) % WHEEL_SLOTS;
+            LinkEvent(index, level * WHEEL_SLOTS + slot);
+            return;
+        }
+    }
+    LinkEvent(index, OVERFLOW_LIST);
+}
+
+/// Detaches a whole list and files its events again, to move them closer to the front.
+static void RefileList(u32 list) {
+    EventIndex index = wheel_lists[list];
+    wheel_lists[list] = INVALID_EVENT;
+    if (list != OVERFLOW_LIST) {
+        occupied_slots[list / WHEEL_SLOTS] &= ~(u64(1) << (list % WHEEL_SLOTS));
+    }
+
+    while (index != INVALID_EVENT) {
+        const EventIndex next = event_pool[index].next;
+        FileEvent(index);
+        index = next;
+    }
+}
+
+static s64 GetEarliestTimeInList(u32 list) {
+    s64 earliest = std::numeric_limits<s64>::max();
+    for (EventIndex index = wheel_lists[list]; index != INVALID_EVENT;
+         index = event_pool[index].next) {
+        earliest = std::min(earliest, event_pool[index].time);
+    }
+    return earliest;
+}
+
+/// Returns the time of the earliest pending event, or the largest s64 if there is none.
+static s64 GetNextEventTime() {
+    if (!due_events.empty()) {
+        return event_pool[due_events.back()].time;
+    }
+    if (occupied_slots[0] != 0) {
+        const s64 slot = Common::LeastSignificantSetBit(occupied_slots[0]);
+        return (wheel_time & ~static_cast<s64>(WHEEL_SLOTS - 1)) | slot;
+    }
+    for (u32 level = 1; level < WHEEL_LEVELS; ++level) {
+        if (occupied_slots[level] != 0) {
+            const u32 slot = Common::LeastSignificantSetBit(occupied_slots[level]);
+            return GetEarliestTimeInList(level * WHEEL_SLOTS + slot);
+        }
+    }
+    return GetEarliestTimeInList(OVERFLOW_LIST);
+}
+
+/// Turns the wheel forward to target, moving every event due by then to due_events.
+static void AdvanceWheel(s64 target) {
+    while (wheel_time < target) {
+        if (occupied_slots[0] != 0) {
+            const s64 revolution_start = wheel_time & ~static_cast<s64>(WHEEL_SLOTS - 1);
+            u64 due_slots = occupied_slots[0];
+            const bool ends_in_revolution = target < revolution_start + WHEEL_SLOTS;
+            if (ends_in_revolution) {
+                due_slots &= ~u64(0) >> (WHEEL_SLOTS - 1 - target % WHEEL_SLOTS);
+            }
+
+            while (due_slots != 0) {
+                const u32 slot = Common::LeastSignificantSetBit(due_slots);
+                due_slots &= due_slots - 1;
+                occupied_slots[0] &= ~(u64(1) << slot);
+
+                EventIndex index = wheel_lists[slot];
+                wheel_lists[slot] = INVALID_EVENT;
+                while (index != INVALID_EVENT) {
+                    const EventIndex next = event_pool[index].next;
+                    InsertDueEvent(index);
+                    index = next;
+                }
+            }
+
+            if (ends_in_revolution) {
+                wheel_time = target;
+                return;
+            }
+        }
+
+        u32 level = 1;
+        while (level < WHEEL_LEVELS && occupied_slots[level] == 0) {
+            ++level;
+        }
+
+        if (level == WHEEL_LEVELS) {
+            if (wheel_lists[OVERFLOW_LIST] == INVALID_EVENT) {
+                wheel_time = target;
+                return;
+            }
+            // Every overflowed event is past the wheel's range, so they can all be refiled once
+            // the wheel is turned up to the earliest one.
+            wheel_time = std::min(target, GetEarliestTimeInList(OVERFLOW_LIST));
+            RefileList(OVERFLOW_LIST);
+            continue;
+        }
+
+        // The first occupied slot of the lowest occupied level holds the earliest events. Skip
+        // straight to the start of that slot and cascade it down.
+        const u32 slot = Common::LeastSignificantSetBit(occupied_slots[level]);
+        const u32 shift = level * WHEEL_SLOT_BITS;
+        const s64 revolution_mask = (s64(1) << (shift + WHEEL_SLOT_BITS)) - 1;
+        const s64 slot_start = (wheel_time & ~revolution_mask) | (static_cast<s64>(slot) << shift);
+        if (slot_start > target) {
+            wheel_time = target;
+            return;
+        }
+        wheel_time = slot_start;
+        RefileList(level * WHEEL_SLOTS + slot);
+    }
+}
+
+static void ResyncHostClock() {
+    host_sync_start = std::chrono::steady_clock::now();
+    host_sync_start_ticks = global_timer;
+}
+
+/// Brings global_timer back within MAX_HOST_SKEW of the host clock, by waiting for the host when
+/// the guest has run ahead or by skipping guest time when it has fallen behind.
+static void SyncWithHost() {
+    const auto host_elapsed = std::chrono::steady_clock::now() - host_sync_start;
+    const s64 host_ticks =
+        host_sync_start_ticks +
+        nsToCycles(static_cast<s64>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(host_elapsed).count()));
+    const s64 skew = global_timer - host_ticks;
+
+    if (skew > MAX_HOST_SKEW) {
+        // Idling can put the guest far ahead of the host, so work in microseconds to stay clear
+        // of overflowing the conversion.
+        std::this_thread::sleep_for(std::chrono::microseconds(cyclesToUs(skew)));
+    } else if (skew < -MAX_HOST_LAG) {
+        LOG_DEBUG(Core_Timing, "Fell %" PRId64 " cycles behind the host, resynchronizing", -skew);
+        ResyncHostClock();
+    } else if (skew < -MAX_HOST_SKEW) {
+        const s64 skipped = -skew - MAX_HOST_SKEW;
+        global_timer += skipped;
+        idled_cycles += skipped;
+    }
+}
+
+static EventIndex ScheduleEventAt(const Event& event) {
+    const EventIndex index = AllocateEvent(event);
+    FileEvent(index);
+    return index;
+}
+
+static void RemovePendingEvent(EventIndex index) {
+    UnlinkEvent(index);
+    FreeEvent(index);
+}
+
 EventType* RegisterEvent(const std::string& name, TimedCallback callback) {
     // check for existing type with same name.
     // we want event type names to remain unique so that we can use them for serialization.
@@ -78,14 +405,21 @@ EventType* RegisterEvent(const std::string& name, TimedCallback callback) {
                "during Init to avoid breaking save states.",
                name.c_str());
 
-    auto info = event_types.emplace(name, EventType{callback, nullptr});
+    EventType new_type{};
+    new_type.callback = std::move(callback);
+    auto info = event_types.emplace(name, std::move(new_type));
     EventType* event_type = &info.first->second;
     event_type->name = &info.first->first;
+#if MICROPROFILE_ENABLED
+    event_type->profile_token =
+        MicroProfileGetToken("CoreTiming", name.c_str(), MP_RGB(160, 160, 80),
+                             MicroProfileTokenTypeCpu);
+#endif
     return event_type;
 }
 
 void UnregisterAllEvents() {
-    ASSERT_MSG(event_queue.empty(), "Cannot unregister events with events pending");
+    ASSERT_MSG(num_pending_events == 0, "Cannot unregister events with events pending");
     event_types.clear();
 }
 
@@ -102,11 +436,90 @@ void Init() {
     is_global_timer_sane = true;
 
     event_fifo_id = 0;
+    wheel_time = 0;
+    host_synchronized = false;
+    event_stats_enabled = false;
+    ClearPendingEvents();
     ev_lost = RegisterEvent("_lost_event", &EmptyTimedCallback);
 }
 
+static void LogEventStats() {
+    std::vector<const EventType*> types;
+    for (const auto& entry : event_types) {
+        if (entry.second.stats.num_calls != 0) {
+            types.push_back(&entry.second);
+        }
+    }
+    std::sort(types.begin(), types.end(), [](const EventType* a, const EventType* b) {
+        return a->stats.host_time > b->stats.host_time;
+    });
+
+    // The lateness a given share of the calls stayed under, as the upper bound of its bucket.
+    const auto lateness_percentile = [](const EventTypeStats& stats, u64 percent) -> s64 {
+        const u64 target = (stats.num_calls * percent + 99) / 100;
+        u64 count = 0;
+        for (size_t bucket = 0; bucket < stats.lateness.size() - 1; ++bucket) {
+            count += stats.lateness[bucket];
+            if (count >= target) {
+                const s64 upper_bound = bucket == 0 ? 0 : (s64(1) << bucket) - 1;
+                return std::min(upper_bound, stats.max_cycles_late);
+            }
+        }
+        return stats.max_cycles_late;
+    };
+
+    LOG_INFO(Core_Timing, "Event statistics (name: calls, host time, lateness p50/p99/max cycles)");
+    for (const EventType* type : types) {
+        const EventTypeStats& stats = type->stats;
+        const auto host_us =
+            std::chrono::duration_cast<std::chrono::microseconds>(stats.host_time).count();
+        LOG_INFO(Core_Timing,
+                 "%s: %" PRIu64 " calls, %lld us (%lld us per call), <=%" PRId64 "/<=%" PRId64
+                 "/%" PRId64,
+                 type->name->c_str(), stats.num_calls, static_cast<long long>(host_us),
+                 static_cast<long long>(host_us / stats.num_calls),
+                 lateness_percentile(stats, 50), lateness_percentile(stats, 99),
+                 stats.max_cycles_late);
+    }
+}
+
+static void RunCallback(const EventType* type, u64 userdata, s64 cycles_late) {
+#if MICROPROFILE_ENABLED
+    MICROPROFILE_SCOPE_TOKEN(type->profile_token);
+#endif
+    if (!event_stats_enabled) {
+        type->callback(userdata, static_cast<int>(cycles_late));
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    type->callback(userdata, static_cast<int>(cycles_late));
+    const auto end = std::chrono::steady_clock::now();
+
+    EventTypeStats& stats = type->stats;
+    ++stats.num_calls;
+    stats.host_time += end - start;
+    stats.max_cycles_late = std::max(stats.max_cycles_late, cycles_late);
+    size_t bucket = 0;
+    while (bucket < stats.lateness.size() - 1 && (cycles_late >> bucket) != 0) {
+        ++bucket;
+    }
+    ++stats.lateness[bucket];
+}
+
 void Shutdown() {
     MoveEvents();
+    if (event_stats_enabled) {
+        LogEventStats();
+    }
+    if (ts_stats.num_events != 0) {
+        LOG_DEBUG(Core_Timing,
+                  "%" PRIu64 " threadsafe events, %" PRIu64 " of them late by %" PRId64
+                  " cycles in total, at most %" PRId64,
+                  ts_stats.num_events, ts_stats.num_late_events, ts_stats.total_cycles_late,
+                  ts_stats.max_cycles_late);
+    }
+    ts_stats = {};
     ClearPendingEvents();
     UnregisterAllEvents();
 }
@@ -130,10 +543,18 @@ u64 GetIdleTicks() {
 }
 
 void ClearPendingEvents() {
-    event_queue.clear();
+    event_pool.clear();
+    free_events = INVALID_EVENT;
+    num_pending_events = 0;
+    wheel_lists.fill(INVALID_EVENT);
+    occupied_slots.fill(0);
+    due_events.clear();
+    for (auto& entry : event_types) {
+        entry.second.first_pending = INVALID_EVENT;
+    }
 }
 
-void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
+EventHandle ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
     ASSERT(event_type != nullptr);
     s64 timeout = GetTicks() + cycles_into_future;
 
@@ -141,34 +562,45 @@ void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 user
     if (!is_global_timer_sane)
         ForceExceptionCheck(cycles_into_future);
 
-    event_queue.emplace_back(Event{timeout, event_fifo_id++, userdata, event_type});
-    std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    const u64 fifo_order = event_fifo_id++;
+    const EventIndex index = ScheduleEventAt(Event{timeout, fifo_order, userdata, event_type});
+    return EventHandle{index, fifo_order};
 }
 
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata) {
-    ts_queue.Push(Event{global_timer + cycles_into_future, 0, userdata, event_type});
+    const ThreadsafeEvent event{global_timer + cycles_into_future, userdata, event_type};
+    while (!ts_queue.TryPush(event)) {
+        // The emu thread empties the queue every slice, so give it a chance to catch up.
+        std::this_thread::yield();
+    }
 }
 
 void UnscheduleEvent(const EventType* event_type, u64 userdata) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(), [&](const Event& e) {
-        return e.type == event_type && e.userdata == userdata;
-    });
+    EventIndex index = event_type->first_pending;
+    while (index != INVALID_EVENT) {
+        const EventIndex next = event_pool[index].next_of_type;
+        if (event_pool[index].userdata == userdata) {
+            RemovePendingEvent(index);
+        }
+        index = next;
+    }
+}
 
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+void UnscheduleEvent(const EventHandle& handle) {
+    // The fifo order is unique to each scheduled event, so a slot that was reused since doesn't
+    // match the handle
+    if (handle.index >= event_pool.size()) {
+        return;
+    }
+    const Event& event = event_pool[handle.index];
+    if (event.type != nullptr && event.fifo_order == handle.fifo_order) {
+        RemovePendingEvent(handle.index);
     }
 }
 
 void RemoveEvent(const EventType* event_type) {
-    auto itr = std::remove_if(event_queue.begin(), event_queue.end(),
-                              [&](const Event& e) { return e.type == event_type; });
-
-    // Removing random items breaks the invariant so we have to re-establish it.
-    if (itr != event_queue.end()) {
-        event_queue.erase(itr, event_queue.end());
-        std::make_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    while (event_type->first_pending != INVALID_EVENT) {
+        RemovePendingEvent(event_type->first_pending);
     }
 }
 
@@ -188,11 +620,34 @@ void ForceExceptionCheck(s64 cycles) {
 }
 
 void MoveEvents() {
-    for (Event ev; ts_queue.Pop(ev);) {
-        ev.fifo_order = event_fifo_id++;
-        event_queue.emplace_back(std::move(ev));
-        std::push_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
+    if (ts_queue.Empty()) {
+        return;
     }
+
+    // Events earlier than the end of the slice that just ran should have fired during it.
+    const s64 current_time = static_cast<s64>(GetTicks());
+    ts_stats.num_events += ts_queue.PopAll([current_time](ThreadsafeEvent ev) {
+        const s64 cycles_late = current_time - ev.time;
+        if (cycles_late > 0) {
+            ++ts_stats.num_late_events;
+            ts_stats.total_cycles_late += cycles_late;
+            ts_stats.max_cycles_late = std::max(ts_stats.max_cycles_late, cycles_late);
+        }
+        ScheduleEventAt(Event{ev.time, event_fifo_id++, ev.userdata, ev.type});
+    });
+}
+
+void SetHostSynchronized(bool enabled) {
+    host_synchronized = enabled;
+    ResyncHostClock();
+}
+
+void SetEventStatsEnabled(bool enabled) {
+    event_stats_enabled = enabled;
+}
+
+ThreadsafeEventStats GetThreadsafeEventStats() {
+    return ts_stats;
 }
 
 void Advance() {
@@ -204,19 +659,26 @@ void Advance() {
 
     is_global_timer_sane = true;
 
-    while (!event_queue.empty() && event_queue.front().time <= global_timer) {
-        Event evt = std::move(event_queue.front());
-        std::pop_heap(event_queue.begin(), event_queue.end(), std::greater<Event>());
-        event_queue.pop_back();
-        evt.type->callback(evt.userdata, static_cast<int>(global_timer - evt.time));
+    if (host_synchronized) {
+        SyncWithHost();
+    }
+
+    AdvanceWheel(global_timer);
+    while (!due_events.empty()) {
+        const EventIndex index = due_events.back();
+        due_events.pop_back();
+
+        const Event evt = event_pool[index];
+        FreeEvent(index);
+        RunCallback(evt.type, evt.userdata, global_timer - evt.time);
     }
 
     is_global_timer_sane = false;
 
     // Still events left (scheduled in the future)
-    if (!event_queue.empty()) {
+    if (num_pending_events != 0) {
         slice_length = static_cast<int>(
-            std::min<s64>(event_queue.front().time - global_timer, MAX_SLICE_LENGTH));
+            std::min<s64>(GetNextEventTime() - global_timer, MAX_SLICE_LENGTH));
     }
 
     downcount = slice_length;
@@ -235,4 +697,54 @@ int GetDowncount() {
     return downcount;
 }
 
+void DoState(PointerWrap& p) {
+    // Events posted from other threads are filed first, so that they are part of the state too
+    MoveEvents();
+
+    p.Do(slice_length);
+    p.Do(global_timer);
+    p.Do(idled_cycles);
+    p.Do(downcount);
+    p.Do(event_fifo_id);
+    p.Do(wheel_time);
+    p.DoMarker("CoreTimingData");
+
+    u32 num_events = static_cast<u32>(num_pending_events);
+    p.Do(num_events);
+    if (p.GetMode() == PointerWrap::MODE_READ) {
+        ClearPendingEvents();
+        for (u32 i = 0; i < num_events; ++i) {
+            Event event{};
+            std::string name;
+            p.Do(event.time);
+            p.Do(event.fifo_order);
+            p.Do(event.userdata);
+            p.Do(name);
+
+            const auto itr = event_types.find(name);
+            if (itr != event_types.end()) {
+                event.type = &itr->second;
+            } else {
+                LOG_ERROR(Core_Timing, "Lost event of unregistered type %s", name.c_str());
+                event.type = ev_lost;
+            }
+            // The fifo order of every event is kept, so ties still fire in their original order
+            ScheduleEventAt(event);
+        }
+    } else {
+        for (const auto& entry : event_types) {
+            for (EventIndex index = entry.second.first_pending; index != INVALID_EVENT;
+                 index = event_pool[index].next_of_type) {
+                Event event = event_pool[index];
+                std::string name = entry.first;
+                p.Do(event.time);
+                p.Do(event.fifo_order);
+                p.Do(event.userdata);
+                p.Do(name);
+            }
+        }
+    }
+    p.DoMarker("CoreTimingEvents");
+}
+
 } // namespace CoreTiming
@@ -23,6 +23,8 @@
 #include "common/common_types.h"
 #include "common/logging/log.h"
 
+class PointerWrap;
+
 // The below clock rate is based on Switch's clockspeed being widely known as 1.020GHz
 // The exact value used is of course unverified.
 constexpr u64 BASE_CLOCK_RATE = 1019215872; // Switch clock speed is 1020MHz un/docked
@@ -144,12 +146,22 @@ struct EventType;
 EventType* RegisterEvent(const std::string& name, TimedCallback callback);
 void UnregisterAllEvents();
 
+/**
+ * Refers to one scheduled event, so that it can be unscheduled without searching the events of its
+ * type. Once the event has fired or been unscheduled the handle refers to nothing, and
+ * unscheduling it has no effect. Handles don't survive loading a state.
+ */
+struct EventHandle {
+    u32 index = std::numeric_limits<u32>::max();
+    u64 fifo_order = 0;
+};
+
 /**
  * After the first Advance, the slice lengths and the downcount will be reduced whenever an event
  * is scheduled earlier than the current values.
  * Scheduling from a callback will not update the downcount until the Advance() completes.
  */
-void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata = 0);
+EventHandle ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 userdata = 0);
 
 /**
  * This is to be called when outside of hle threads, such as the graphics thread, wants to
@@ -159,8 +171,22 @@ void ScheduleEvent(s64 cycles_into_future, const EventType* event_type, u64 user
  */
 void ScheduleEventThreadsafe(s64 cycles_into_future, const EventType* event_type, u64 userdata);
 
+/// Counters describing how promptly events scheduled from other threads were picked up.
+struct ThreadsafeEventStats {
+    u64 num_events = 0;
+    /// Events whose time had already passed when the emu thread picked them up.
+    u64 num_late_events = 0;
+    s64 total_cycles_late = 0;
+    s64 max_cycles_late = 0;
+};
+
+ThreadsafeEventStats GetThreadsafeEventStats();
+
 void UnscheduleEvent(const EventType* event_type, u64 userdata);
 
+/// Unschedules the event the handle refers to, if it is still pending.
+void UnscheduleEvent(const EventHandle& handle);
+
 /// We only permit one event of each type in the queue at a time.
 void RemoveEvent(const EventType* event_type);
 void RemoveNormalAndThreadsafeEvent(const EventType* event_type);
@@ -182,8 +208,28 @@ void ClearPendingEvents();
 
 void ForceExceptionCheck(s64 cycles);
 
+/**
+ * Keeps emulated time in step with the host's clock. Advance() will then wait for the host when
+ * emulation runs ahead, and skip emulated time when it falls behind, so that events fire close to
+ * when they would on hardware.
+ */
+void SetHostSynchronized(bool enabled);
+
+/**
+ * Collects the number of calls, the host time spent and the lateness of the callbacks of each
+ * event type. The statistics are written to the log on Shutdown().
+ */
+void SetEventStatsEnabled(bool enabled);
+
 u64 GetGlobalTimeUs();
 
 int GetDowncount();
 
+/**
+ * Saves or loads the timers and the pending events. Events are stored by the name of their type,
+ * so every type has to be registered again before a state is loaded. Events whose type isn't
+ * registered are loaded as lost events, which do nothing when they fire.
+ */
+void DoState(PointerWrap& p);
+
 } // namespace CoreTiming
@@ -0,0 +1,312 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "common/memory_usage.h"
+#include "core/file_sys/cached_storage.h"
+#include "core/settings.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr u64 BLOCK_SIZE = 0x10000;
+/// Maximum number of blocks read ahead of a miss
+constexpr u64 MAX_READ_AHEAD = 8;
+/// Reads at least this large go straight to the wrapped storage, so that they don't flush the
+/// blocks of smaller, more frequent reads out of the cache.
+constexpr size_t BYPASS_LENGTH = 0x100000;
+
+struct BlockKey {
+    u64 storage_id;
+    u64 block;
+
+    bool operator==(const BlockKey& other) const {
+        return storage_id == other.storage_id && block == other.block;
+    }
+};
+
+struct BlockKeyHash {
+    size_t operator()(const BlockKey& key) const {
+        return std::hash<u64>()(key.storage_id * 0x9E3779B97F4A7C15ULL ^ key.block);
+    }
+};
+
+struct CachedBlock {
+    BlockKey key;
+    std::vector<u8> data;
+};
+
+/// Blocks of the cache are read from both the CPU thread and the HLE worker.
+std::mutex cache_mutex;
+/// Cached blocks, most recently used first
+std::list<CachedBlock> lru_blocks;
+std::unordered_map<BlockKey, std::list<CachedBlock>::iterator, BlockKeyHash> block_map;
+/// Cached blocks of each storage, so that they can be dropped without going through the cache.
+std::unordered_map<u64, std::unordered_set<u64>> storage_blocks;
+u64 cached_bytes = 0;
+Common::MemoryUsageCounter cache_usage("Storage block cache");
+StorageCacheStats stats;
+
+struct StorageEntry {
+    u64 storage_id;
+    std::shared_ptr<std::mutex> mutex;
+};
+
+/// Storages that were opened, by identity. An identity keeps its id after its last instance is
+/// gone, so that its blocks are found again when it is reopened.
+std::unordered_map<std::string, StorageEntry> storages;
+
+u64 GetBudget() {
+    return static_cast<u64>(Settings::values.storage_cache_size) * 0x100000;
+}
+
+void EraseBlock(std::unordered_map<BlockKey, std::list<CachedBlock>::iterator,
+                                   BlockKeyHash>::iterator itr) {
+    cached_bytes -= itr->second->data.size();
+    cache_usage.Subtract(itr->second->data.size());
+    storage_blocks[itr->first.storage_id].erase(itr->first.block);
+    lru_blocks.erase(itr->second);
+    block_map.erase(itr);
+}
+
+/**
+ * Copies the part of a cached block that starts at block_offset into buffer.
+ * @returns The number of bytes copied, or -1 if the block is not cached.
+ */
+s64 CopyFromBlock(const BlockKey& key, u64 block_offset, size_t length, u8* buffer,
+                  bool count_hit) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    const auto itr = block_map.find(key);
+    if (itr == block_map.end()) {
+        return -1;
+    }
+
+    // Move the block to the front of the LRU list.
+    lru_blocks.splice(lru_blocks.begin(), lru_blocks, itr->second);
+    if (count_hit) {
+        ++stats.hits;
+    }
+
+    const std::vector<u8>& data = itr->second->data;
+    if (block_offset >= data.size()) {
+        return 0;
+    }
+    const size_t copy_length = std::min<size_t>(length, data.size() - block_offset);
+    std::memcpy(buffer, data.data() + block_offset, copy_length);
+    return static_cast<s64>(copy_length);
+}
+
+void InsertBlock(const BlockKey& key, std::vector<u8> data) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    const u64 budget = GetBudget();
+    if (data.size() > budget) {
+        return;
+    }
+
+    const auto existing = block_map.find(key);
+    if (existing != block_map.end()) {
+        EraseBlock(existing);
+    }
+
+    while (cached_bytes + data.size() > budget) {
+        EraseBlock(block_map.find(lru_blocks.back().key));
+        ++stats.evictions;
+    }
+
+    cached_bytes += data.size();
+    cache_usage.Add(data.size());
+    lru_blocks.push_front({key, std::move(data)});
+    block_map.emplace(key, lru_blocks.begin());
+    storage_blocks[key.storage_id].insert(key.block);
+}
+
+void InvalidateBlocks(u64 storage_id, u64 first_block, u64 end_block) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    for (u64 block = first_block; block < end_block; ++block) {
+        const auto itr = block_map.find({storage_id, block});
+        if (itr != block_map.end()) {
+            EraseBlock(itr);
+        }
+    }
+}
+
+/// Drops all the blocks of a storage. Called with cache_mutex held.
+void EraseStorageBlocks(u64 storage_id) {
+    const auto itr = storage_blocks.find(storage_id);
+    if (itr == storage_blocks.end()) {
+        return;
+    }
+    const std::unordered_set<u64> blocks = std::move(itr->second);
+    for (const u64 block : blocks) {
+        EraseBlock(block_map.find({storage_id, block}));
+    }
+    storage_blocks.erase(storage_id);
+}
+
+void InvalidateStorage(u64 storage_id) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    EraseStorageBlocks(storage_id);
+}
+
+StorageEntry GetStorageEntry(const std::string& identity) {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    const auto itr = storages.find(identity);
+    if (itr != storages.end()) {
+        return itr->second;
+    }
+    const StorageEntry entry{storages.size(), std::make_shared<std::mutex>()};
+    storages.emplace(identity, entry);
+    return entry;
+}
+
+} // Anonymous namespace
+
+CachedStorage::CachedStorage(std::unique_ptr<StorageBackend> backend, const std::string& identity)
+    : backend(std::move(backend)) {
+    StorageEntry entry = GetStorageEntry(identity);
+    storage_id = entry.storage_id;
+    mutex = std::move(entry.mutex);
+}
+
+ResultVal<size_t> CachedStorage::Read(u64 offset, size_t length, u8* buffer) const {
+    std::lock_guard<std::mutex> lock(*mutex);
+    const u64 size = backend->GetSize();
+    if (offset >= size) {
+        return MakeResult<size_t>(0);
+    }
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    if (length >= BYPASS_LENGTH) {
+        return backend->Read(offset, length, buffer);
+    }
+
+    size_t total_copied = 0;
+    while (total_copied < length) {
+        const u64 position = offset + total_copied;
+        const BlockKey key{storage_id, position / BLOCK_SIZE};
+        const u64 block_offset = position % BLOCK_SIZE;
+        const size_t remaining = length - total_copied;
+
+        s64 copied = CopyFromBlock(key, block_offset, remaining, buffer + total_copied, true);
+        if (copied < 0) {
+            const ResultCode result = FetchBlocks(key.block);
+            if (result.IsError()) {
+                return result;
+            }
+            copied = CopyFromBlock(key, block_offset, remaining, buffer + total_copied, false);
+        }
+
+        if (copied < 0) {
+            // The block could not be kept in the cache, read the rest directly.
+            const ResultVal<size_t> direct =
+                backend->Read(position, remaining, buffer + total_copied);
+            if (direct.Failed()) {
+                return direct.Code();
+            }
+            total_copied += *direct;
+            break;
+        }
+        if (copied == 0) {
+            // The wrapped storage returned less data than its size claims.
+            break;
+        }
+        total_copied += static_cast<size_t>(copied);
+    }
+
+    next_sequential_block = (offset + length - 1) / BLOCK_SIZE + 1;
+    return MakeResult<size_t>(total_copied);
+}
+
+ResultCode CachedStorage::FetchBlocks(u64 block) const {
+    // Ramp the read-ahead up while the storage is read sequentially, and drop it on a seek.
+    if (block != 0 && block == next_sequential_block) {
+        read_ahead = std::min(std::max<u64>(read_ahead * 2, 1), MAX_READ_AHEAD);
+    } else {
+        read_ahead = 0;
+    }
+
+    const u64 start = block * BLOCK_SIZE;
+    const u64 fetch_length = std::min((1 + read_ahead) * BLOCK_SIZE, backend->GetSize() - start);
+    std::vector<u8> data(static_cast<size_t>(fetch_length));
+    const ResultVal<size_t> read = backend->Read(start, data.size(), data.data());
+    if (read.Failed()) {
+        return read.Code();
+    }
+    data.resize(*read);
+
+    u64 num_blocks = 0;
+    for (size_t block_start = 0; block_start < data.size() || num_blocks == 0;
+         block_start += BLOCK_SIZE) {
+        const size_t block_end = std::min<size_t>(block_start + BLOCK_SIZE, data.size());
+        InsertBlock({storage_id, block + num_blocks},
+                    std::vector<u8>(data.begin() + block_start, data.begin() + block_end));
+        ++num_blocks;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    ++stats.misses;
+    stats.read_ahead_blocks += num_blocks - 1;
+    return RESULT_SUCCESS;
+}
+
+ResultVal<size_t> CachedStorage::Write(u64 offset, size_t length, bool flush,
+                                       const u8* buffer) const {
+    // Reads wait for the write, and the blocks are dropped once it's done, so that no read can
+    // cache the data the write replaces.
+    std::lock_guard<std::mutex> lock(*mutex);
+    const ResultVal<size_t> result = backend->Write(offset, length, flush, buffer);
+    const u64 end_block = (offset + length + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    InvalidateBlocks(storage_id, offset / BLOCK_SIZE, end_block);
+    return result;
+}
+
+void CachedStorage::Flush() const {
+    backend->Flush();
+}
+
+bool CachedStorage::SetSize(u64 size) const {
+    std::lock_guard<std::mutex> lock(*mutex);
+    const bool result = backend->SetSize(size);
+    InvalidateStorage(storage_id);
+    return result;
+}
+
+u64 CachedStorage::GetSize() const {
+    return backend->GetSize();
+}
+
+bool CachedStorage::Close() const {
+    return backend->Close();
+}
+
+std::unique_ptr<StorageBackend> MakeCachedStorage(std::unique_ptr<StorageBackend> backend,
+                                                  const std::string& identity) {
+    if (Settings::values.storage_cache_size == 0) {
+        return backend;
+    }
+    return std::make_unique<CachedStorage>(std::move(backend), identity);
+}
+
+void InvalidateCachedStorage(const std::string& identity) {
+    // Taken like a write, so that no read through an open instance caches the old data again.
+    const StorageEntry entry = GetStorageEntry(identity);
+    std::lock_guard<std::mutex> lock(*entry.mutex);
+    InvalidateStorage(entry.storage_id);
+}
+
+StorageCacheStats GetStorageCacheStats() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    return stats;
+}
+
+} // namespace FileSys
@@ -0,0 +1,83 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include "common/common_types.h"
+#include "core/file_sys/storage.h"
+
+namespace FileSys {
+
+struct StorageCacheStats {
+    u64 hits = 0;
+    u64 misses = 0;
+    /// Blocks that were read ahead of a miss because the storage was being read sequentially.
+    u64 read_ahead_blocks = 0;
+    u64 evictions = 0;
+};
+
+/**
+ * Storage decorator that keeps recently read blocks of the wrapped storage in memory. All the
+ * instances share a single LRU cache whose size is set by Settings::values.storage_cache_size.
+ * Blocks are cached under the identity of the data the storage reads, so the instances opened on
+ * the same file share them, and they outlive the instance for the next time the file is opened.
+ * When a miss continues a sequential run of reads, the following blocks are read ahead as part of
+ * the same request to the wrapped storage. Writes go straight to the wrapped storage and drop the
+ * blocks they overlap once they are done.
+ */
+class CachedStorage final : public StorageBackend {
+public:
+    /**
+     * @param backend Storage to wrap.
+     * @param identity Identifies the data of the storage, such as the path of its host file.
+     */
+    CachedStorage(std::unique_ptr<StorageBackend> backend, const std::string& identity);
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
+    void Flush() const override;
+    bool SetSize(u64 size) const override;
+    u64 GetSize() const override;
+    bool Close() const override;
+
+private:
+    /// Reads the given block from the wrapped storage, along with any blocks read ahead of it.
+    /// Called with mutex held.
+    ResultCode FetchBlocks(u64 block) const;
+
+    std::unique_ptr<StorageBackend> backend;
+    /// Identifies the blocks of this storage in the shared cache.
+    u64 storage_id;
+
+    /// Guards the read-ahead state and orders the reads against the writes, as the storage is
+    /// used from both the CPU thread and the HLE worker. Shared by all the instances with the
+    /// same identity, so that none of them caches the data a write through another replaces.
+    std::shared_ptr<std::mutex> mutex;
+    /// Block a sequential reader would ask for next, and how far ahead of it to read on a miss.
+    mutable u64 next_sequential_block = 0;
+    mutable u64 read_ahead = 0;
+};
+
+/**
+ * Wraps a storage in a CachedStorage, unless the cache is disabled in the settings.
+ * @param backend Storage to wrap.
+ * @param identity Identifies the data of the storage, such as the path of its host file.
+ * @returns The wrapped storage, or the storage itself if the cache is disabled.
+ */
+std::unique_ptr<StorageBackend> MakeCachedStorage(std::unique_ptr<StorageBackend> backend,
+                                                  const std::string& identity);
+
+/**
+ * Drops the cached blocks of the storages with the given identity. Called when their data is
+ * changed other than by writing to one of them, such as when their host file is replaced.
+ */
+void InvalidateCachedStorage(const std::string& identity);
+
+/// Returns the statistics of the block cache shared by all the CachedStorage instances.
+StorageCacheStats GetStorageCacheStats();
+
+} // namespace FileSys
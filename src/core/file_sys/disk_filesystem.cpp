@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include <memory>
+#include "common/common_paths.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "core/file_sys/cached_storage.h"
 #include "core/file_sys/disk_filesystem.h"
 #include "core/file_sys/errors.h"
 
@@ -52,17 +55,23 @@ ResultVal<std::unique_ptr<StorageBackend>> Disk_FileSystem::OpenFile(const std::
     if (!file->IsOpen()) {
         return ERROR_PATH_NOT_FOUND;
     }
+    // Opening the file to write it truncates it.
+    if (mode_str[0] == 'w') {
+        InvalidateCachedStorage(full_path);
+    }
 
     return MakeResult<std::unique_ptr<StorageBackend>>(
-        std::make_unique<Disk_Storage>(std::move(file)));
+        MakeCachedStorage(std::make_unique<Disk_Storage>(std::move(file)), full_path));
 }
 
 ResultCode Disk_FileSystem::DeleteFile(const std::string& path) const {
-    if (!FileUtil::Exists(path)) {
+    std::string full_path = base_directory + path;
+    if (!FileUtil::Exists(full_path)) {
         return ERROR_PATH_NOT_FOUND;
     }
 
-    FileUtil::Delete(path);
+    FileUtil::Delete(full_path);
+    InvalidateCachedStorage(full_path);
 
     return RESULT_SUCCESS;
 }
@@ -89,6 +98,7 @@ ResultCode Disk_FileSystem::CreateFile(const std::string& path, u64 size) const
     LOG_WARNING(Service_FS, "(STUBBED) called");
 
     std::string full_path = base_directory + path;
+    InvalidateCachedStorage(full_path);
     if (size == 0) {
         FileUtil::CreateEmptyFile(full_path);
         return RESULT_SUCCESS;
@@ -158,75 +168,90 @@ ResultVal<FileSys::EntryType> Disk_FileSystem::GetEntryType(const std::string& p
 
 ResultVal<size_t> Disk_Storage::Read(const u64 offset, const size_t length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%llu, length=%zu", offset, length);
+    std::lock_guard<std::mutex> lock(mutex);
     file->Seek(offset, SEEK_SET);
     return MakeResult<size_t>(file->ReadBytes(buffer, length));
 }
 
 ResultVal<size_t> Disk_Storage::Write(const u64 offset, const size_t length, const bool flush,
                                       const u8* buffer) const {
-    LOG_WARNING(Service_FS, "(STUBBED) called");
+    LOG_TRACE(Service_FS, "called offset=%llu, length=%zu, flush=%d", offset, length, flush);
+    std::lock_guard<std::mutex> lock(mutex);
     file->Seek(offset, SEEK_SET);
     size_t written = file->WriteBytes(buffer, length);
+    dirty = true;
     if (flush) {
-        file->Flush();
+        FlushPending();
     }
     return MakeResult<size_t>(written);
 }
 
+void Disk_Storage::Flush() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    FlushPending();
+}
+
+void Disk_Storage::FlushPending() const {
+    if (dirty) {
+        file->Flush();
+        dirty = false;
+    }
+}
+
 u64 Disk_Storage::GetSize() const {
+    // The size comes from the file on disk, which doesn't include the buffered writes yet.
+    std::lock_guard<std::mutex> lock(mutex);
+    FlushPending();
     return file->GetSize();
 }
 
 bool Disk_Storage::SetSize(const u64 size) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    FlushPending();
     file->Resize(size);
     file->Flush();
     return true;
 }
 
 Disk_Directory::Disk_Directory(const std::string& path) {
-    unsigned size = FileUtil::ScanDirectoryTree(path, directory);
-    directory.size = size;
-    directory.isDirectory = true;
-    children_iterator = directory.children.begin();
-}
-
-u64 Disk_Directory::Read(const u64 count, Entry* entries) {
-    u64 entries_read = 0;
-
-    while (entries_read < count && children_iterator != directory.children.cend()) {
-        const FileUtil::FSTEntry& file = *children_iterator;
-        const std::string& filename = file.virtualName;
-        Entry& entry = entries[entries_read];
-
-        LOG_TRACE(Service_FS, "File %s: size=%llu dir=%d", filename.c_str(), file.size,
-                  file.isDirectory);
+    const auto callback = [this](unsigned* num_entries_out, const std::string& directory,
+                                 const std::string& virtual_name) -> bool {
+        const std::string physical_name = directory + DIR_SEP + virtual_name;
+        Entry& entry = entries.emplace_back();
 
         // TODO(Link Mauve): use a proper conversion to UTF-16.
-        for (size_t j = 0; j < FILENAME_LENGTH; ++j) {
-            entry.filename[j] = filename[j];
-            if (!filename[j])
-                break;
-        }
+        const size_t name_length = std::min(virtual_name.size(), FILENAME_LENGTH - 1);
+        std::memcpy(entry.filename, virtual_name.data(), name_length);
+        entry.filename[name_length] = '\0';
 
-        if (file.isDirectory) {
-            entry.file_size = 0;
+        if (FileUtil::IsDirectory(physical_name)) {
             entry.type = EntryType::Directory;
+            entry.file_size = 0;
         } else {
-            entry.file_size = file.size;
             entry.type = EntryType::File;
+            entry.file_size = FileUtil::GetSize(physical_name);
         }
 
-        ++entries_read;
-        ++children_iterator;
+        LOG_TRACE(Service_FS, "File %s: size=%llu dir=%d", virtual_name.c_str(), entry.file_size,
+                  entry.type == EntryType::Directory);
+        ++*num_entries_out;
+        return true;
+    };
+
+    if (!FileUtil::ForeachDirectoryEntry(nullptr, path, callback)) {
+        LOG_ERROR(Service_FS, "Failed to list the directory %s", path.c_str());
     }
+}
+
+u64 Disk_Directory::Read(const u64 count, Entry* out) {
+    const u64 entries_read = std::min<u64>(count, entries.size() - next_entry);
+    std::copy_n(entries.begin() + next_entry, entries_read, out);
+    next_entry += entries_read;
     return entries_read;
 }
 
 u64 Disk_Directory::GetEntryCount() const {
-    // We convert the children iterator into a const_iterator to allow template argument deduction
-    // in std::distance.
-    std::vector<FileUtil::FSTEntry>::const_iterator current = children_iterator;
-    return std::distance(current, directory.children.end());
+    return entries.size() - next_entry;
 }
 
 } // namespace FileSys
@@ -6,7 +6,9 @@
 
 #include <cstddef>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "core/file_sys/directory.h"
@@ -52,10 +54,17 @@ public:
     bool Close() const override {
         return false;
     }
-    void Flush() const override {}
+    void Flush() const override;
 
 private:
+    /// Writes data still in the host file buffers to the disk. Requires the mutex to be held.
+    void FlushPending() const;
+
     std::shared_ptr<FileUtil::IOFile> file;
+    /// Requests may come from both the CPU thread and the HLE worker, and share the file position.
+    mutable std::mutex mutex;
+    /// Whether data was written since the last flush
+    mutable bool dirty = false;
 };
 
 class Disk_Directory : public DirectoryBackend {
@@ -74,11 +83,12 @@ public:
     }
 
 protected:
-    FileUtil::FSTEntry directory;
+    /// Entries of the directory, listed once when it is opened and already in the guest format,
+    /// so that reading them is a copy out of this block.
+    std::vector<Entry> entries;
 
-    // We need to remember the last entry we returned, so a subsequent call to Read will continue
-    // from the next one. This iterator will always point to the next unread entry.
-    std::vector<FileUtil::FSTEntry>::iterator children_iterator;
+    /// Index of the next entry to return, so a subsequent call to Read continues from there.
+    size_t next_entry = 0;
 };
 
 } // namespace FileSys
@@ -0,0 +1,130 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/file_sys/encrypted_storage.h"
+
+namespace FileSys {
+
+AESCTRStorage::AESCTRStorage(std::unique_ptr<StorageBackend> backend, const HW::AES::Key128& key,
+                             const HW::AES::Block& iv, u64 stream_offset)
+    : backend(std::move(backend)), engine(key), iv(iv), stream_offset(stream_offset) {}
+
+ResultVal<size_t> AESCTRStorage::Read(u64 offset, size_t length, u8* buffer) const {
+    const ResultVal<size_t> result = backend->Read(offset, length, buffer);
+    if (result.Succeeded()) {
+        HW::AES::TransformCTR(engine, iv, stream_offset + offset, buffer, buffer, *result);
+    }
+    return result;
+}
+
+ResultVal<size_t> AESCTRStorage::Write(u64 offset, size_t length, bool flush,
+                                       const u8* buffer) const {
+    LOG_ERROR(Service_FS, "Attempted to write to an AES-CTR encrypted storage");
+    return MakeResult<size_t>(0);
+}
+
+bool AESCTRStorage::SetSize(u64 size) const {
+    LOG_ERROR(Service_FS, "Attempted to set the size of an AES-CTR encrypted storage");
+    return false;
+}
+
+u64 AESCTRStorage::GetSize() const {
+    return backend->GetSize();
+}
+
+bool AESCTRStorage::Close() const {
+    return backend->Close();
+}
+
+AESXTSStorage::AESXTSStorage(std::unique_ptr<StorageBackend> backend,
+                             const HW::AES::Key128& data_key, const HW::AES::Key128& tweak_key,
+                             size_t sector_size, HW::AES::TweakByteOrder order, u64 first_sector)
+    : backend(std::move(backend)), data_engine(data_key), tweak_engine(tweak_key),
+      sector_size(sector_size), order(order), first_sector(first_sector) {
+    ASSERT_MSG(sector_size != 0 && sector_size % HW::AES::BLOCK_SIZE == 0,
+               "Invalid XTS sector size %zu", sector_size);
+}
+
+ResultVal<size_t> AESXTSStorage::Read(u64 offset, size_t length, u8* buffer) const {
+    const u64 size = backend->GetSize();
+    if (offset >= size) {
+        return MakeResult<size_t>(0);
+    }
+    length = static_cast<size_t>(std::min<u64>(length, size - offset));
+
+    std::vector<u8> partial_sector;
+    size_t total_read = 0;
+    while (total_read < length) {
+        const u64 position = offset + total_read;
+        const size_t sector_offset = static_cast<size_t>(position % sector_size);
+        const size_t remaining = length - total_read;
+
+        if (sector_offset == 0 && remaining >= sector_size) {
+            const size_t whole_length = remaining - remaining % sector_size;
+            const ResultVal<size_t> result =
+                ReadSectors(position, whole_length, buffer + total_read);
+            if (result.Failed()) {
+                return result.Code();
+            }
+            total_read += *result;
+            if (*result < whole_length) {
+                break;
+            }
+            continue;
+        }
+
+        partial_sector.resize(sector_size);
+        const ResultVal<size_t> result =
+            ReadSectors(position - sector_offset, sector_size, partial_sector.data());
+        if (result.Failed()) {
+            return result.Code();
+        }
+        if (*result <= sector_offset) {
+            break;
+        }
+        const size_t copy_length = std::min(*result - sector_offset, remaining);
+        std::memcpy(buffer + total_read, partial_sector.data() + sector_offset, copy_length);
+        total_read += copy_length;
+    }
+    return MakeResult<size_t>(total_read);
+}
+
+ResultVal<size_t> AESXTSStorage::ReadSectors(u64 offset, size_t length, u8* buffer) const {
+    const ResultVal<size_t> result = backend->Read(offset, length, buffer);
+    if (result.Failed()) {
+        return result.Code();
+    }
+
+    // Bytes past the last whole block of a truncated storage can't be decrypted
+    const size_t decrypted_length = *result - *result % HW::AES::BLOCK_SIZE;
+    HW::AES::DecryptXTS(data_engine, tweak_engine, first_sector + offset / sector_size,
+                        sector_size, order, buffer, buffer, decrypted_length);
+    return MakeResult<size_t>(decrypted_length);
+}
+
+ResultVal<size_t> AESXTSStorage::Write(u64 offset, size_t length, bool flush,
+                                       const u8* buffer) const {
+    LOG_ERROR(Service_FS, "Attempted to write to an AES-XTS encrypted storage");
+    return MakeResult<size_t>(0);
+}
+
+bool AESXTSStorage::SetSize(u64 size) const {
+    LOG_ERROR(Service_FS, "Attempted to set the size of an AES-XTS encrypted storage");
+    return false;
+}
+
+u64 AESXTSStorage::GetSize() const {
+    return backend->GetSize();
+}
+
+bool AESXTSStorage::Close() const {
+    return backend->Close();
+}
+
+} // namespace FileSys
@@ -0,0 +1,83 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include "common/common_types.h"
+#include "core/file_sys/storage.h"
+#include "core/hw/aes/aes.h"
+
+namespace FileSys {
+
+/**
+ * Read-only storage decorator that decrypts a storage encrypted with AES-CTR, like the sections of
+ * NCA files. Reads from the wrapped storage land in the destination buffer, which is then
+ * decrypted where it is.
+ */
+class AESCTRStorage final : public StorageBackend {
+public:
+    /**
+     * @param backend Storage holding the encrypted data.
+     * @param key Key the data is encrypted with.
+     * @param iv Counter of the first block of the stream.
+     * @param stream_offset Position of the first byte of the storage in the stream, like the
+     *                      offset of a section in its NCA file.
+     */
+    AESCTRStorage(std::unique_ptr<StorageBackend> backend, const HW::AES::Key128& key,
+                  const HW::AES::Block& iv, u64 stream_offset = 0);
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
+    void Flush() const override {}
+    bool SetSize(u64 size) const override;
+    u64 GetSize() const override;
+    bool Close() const override;
+
+private:
+    std::unique_ptr<StorageBackend> backend;
+    HW::AES::AESEngine engine;
+    HW::AES::Block iv;
+    u64 stream_offset;
+};
+
+/**
+ * Read-only storage decorator that decrypts a storage encrypted with AES-XTS, like the headers of
+ * NCA files. Reads of whole sectors are decrypted in the destination buffer, and only the sectors
+ * that a read starts or ends in the middle of go through a buffer of their own.
+ */
+class AESXTSStorage final : public StorageBackend {
+public:
+    /**
+     * @param backend Storage holding the encrypted data.
+     * @param data_key Key the sectors are encrypted with.
+     * @param tweak_key Key the sector numbers are encrypted with.
+     * @param sector_size Size of a sector in bytes, a multiple of HW::AES::BLOCK_SIZE.
+     * @param order Byte order of the sector numbers in the tweaks.
+     * @param first_sector Number of the sector at offset 0 of the storage.
+     */
+    AESXTSStorage(std::unique_ptr<StorageBackend> backend, const HW::AES::Key128& data_key,
+                  const HW::AES::Key128& tweak_key, size_t sector_size,
+                  HW::AES::TweakByteOrder order, u64 first_sector = 0);
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
+    void Flush() const override {}
+    bool SetSize(u64 size) const override;
+    u64 GetSize() const override;
+    bool Close() const override;
+
+private:
+    /// Reads and decrypts the whole sectors in [offset, offset + length) into buffer.
+    ResultVal<size_t> ReadSectors(u64 offset, size_t length, u8* buffer) const;
+
+    std::unique_ptr<StorageBackend> backend;
+    HW::AES::AESEngine data_engine;
+    HW::AES::AESEngine tweak_engine;
+    size_t sector_size;
+    HW::AES::TweakByteOrder order;
+    u64 first_sector;
+};
+
+} // namespace FileSys
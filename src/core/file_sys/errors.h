@@ -11,10 +11,12 @@ namespace FileSys {
 namespace ErrCodes {
 enum {
     NotFound = 1,
+    NotEnoughFreeSpace = 30,
 };
 }
 
 constexpr ResultCode ERROR_PATH_NOT_FOUND(ErrorModule::FS, ErrCodes::NotFound);
+constexpr ResultCode ERROR_NOT_ENOUGH_FREE_SPACE(ErrorModule::FS, ErrCodes::NotEnoughFreeSpace);
 
 // TODO(bunnei): Replace these with correct errors for Switch OS
 constexpr ResultCode ERROR_INVALID_PATH(ResultCode(-1));
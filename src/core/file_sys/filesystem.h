@@ -164,6 +164,14 @@ public:
      * @return The type of the specified path or error code
      */
     virtual ResultVal<EntryType> GetEntryType(const std::string& path) const = 0;
+
+    /**
+     * Write the changes made to the archive since it was opened or last committed to the host
+     * @return Result of the operation
+     */
+    virtual ResultCode Commit() const {
+        return RESULT_SUCCESS;
+    }
 };
 
 class FileSystemFactory : NonCopyable {
@@ -3,65 +3,100 @@
 // Refer to the license.txt file included.
 
 #include <cinttypes>
+#include <cstring>
 #include <utility>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/file_sys/partition_filesystem.h"
+#include "core/file_sys/romfs_filesystem.h"
 #include "core/loader/loader.h"
 
 namespace FileSys {
 
 Loader::ResultStatus PartitionFilesystem::Load(const std::string& file_path, size_t offset) {
-    FileUtil::IOFile file(file_path, "rb");
-    if (!file.IsOpen())
+    file = std::make_shared<FileUtil::IOFile>(file_path, "rb");
+    if (!file->IsOpen())
         return Loader::ResultStatus::Error;
 
     // At least be as large as the header
-    if (file.GetSize() < sizeof(Header))
-        return Loader::ResultStatus::Error;
-
-    // For cartridges, HFSs can get very large, so we need to calculate the size up to
-    // the actual content itself instead of just blindly reading in the entire file.
-    Header pfs_header;
-    if (!file.ReadBytes(&pfs_header, sizeof(Header)))
+    const u64 file_size = file->GetSize();
+    if (offset > file_size || file_size - offset < sizeof(Header))
         return Loader::ResultStatus::Error;
+    base_offset = offset;
+
+    Loader::ResultStatus result;
+    auto file_mapping = std::make_shared<const FileUtil::MappedFile>(*file);
+    if (file_mapping->IsMapped()) {
+        // Parse the metadata in place, only the pages it spans are read from the disk.
+        mapping = std::move(file_mapping);
+        result = Parse(mapping->Data() + offset, static_cast<size_t>(file_size - offset));
+    } else {
+        // For cartridges, HFSs can get very large, so we need to calculate the size up to
+        // the actual content itself instead of just blindly reading in the entire file.
+        Header header;
+        if (file->ReadAt(&header, sizeof(Header), offset) != sizeof(Header))
+            return Loader::ResultStatus::Error;
+
+        bool is_hfs = (memcmp(header.magic.data(), "HFS", 3) == 0);
+        size_t entry_size = is_hfs ? sizeof(HFSEntry) : sizeof(PFSEntry);
+        size_t metadata_size =
+            sizeof(Header) + (header.num_entries * entry_size) + header.strtab_size;
+        if (metadata_size > file_size - offset)
+            return Loader::ResultStatus::Error;
+
+        // Actually read in now...
+        std::vector<u8> file_data(metadata_size);
+        if (file->ReadAt(file_data.data(), metadata_size, offset) != metadata_size)
+            return Loader::ResultStatus::Error;
+
+        result = Parse(file_data.data(), file_data.size());
+    }
 
-    bool is_hfs = (memcmp(pfs_header.magic.data(), "HFS", 3) == 0);
-    size_t entry_size = is_hfs ? sizeof(HFSEntry) : sizeof(PFSEntry);
-    size_t metadata_size =
-        sizeof(Header) + (pfs_header.num_entries * entry_size) + pfs_header.strtab_size;
+    if (result != Loader::ResultStatus::Success)
+        LOG_ERROR(Service_FS, "Failed to load PFS from file %s!", file_path.c_str());
 
-    // Actually read in now...
-    file.Seek(offset, SEEK_SET);
-    std::vector<u8> file_data(metadata_size);
+    return result;
+}
 
-    if (!file.ReadBytes(file_data.data(), metadata_size))
+Loader::ResultStatus PartitionFilesystem::Load(const std::vector<u8>& file_data, size_t offset) {
+    if (offset > file_data.size())
         return Loader::ResultStatus::Error;
 
-    Loader::ResultStatus result = Load(file_data);
-    if (result != Loader::ResultStatus::Success)
-        LOG_ERROR(Service_FS, "Failed to load PFS from file %s!", file_path.c_str());
+    Loader::ResultStatus result = Parse(file_data.data() + offset, file_data.size() - offset);
 
+    // Entry offsets of filesystems loaded from memory are relative to the start of the data.
+    content_offset += offset;
     return result;
 }
 
-Loader::ResultStatus PartitionFilesystem::Load(const std::vector<u8>& file_data, size_t offset) {
-    size_t total_size = file_data.size() - offset;
-    if (total_size < sizeof(Header))
+Loader::ResultStatus PartitionFilesystem::Parse(const u8* data, size_t size) {
+    pfs_entries.clear();
+    content_offset = 0;
+
+    if (size < sizeof(Header))
         return Loader::ResultStatus::Error;
 
-    memcpy(&pfs_header, &file_data[offset], sizeof(Header));
+    memcpy(&pfs_header, data, sizeof(Header));
     is_hfs = (memcmp(pfs_header.magic.data(), "HFS", 3) == 0);
 
-    size_t entries_offset = offset + sizeof(Header);
+    size_t entries_offset = sizeof(Header);
     size_t entry_size = is_hfs ? sizeof(HFSEntry) : sizeof(PFSEntry);
     size_t strtab_offset = entries_offset + (pfs_header.num_entries * entry_size);
-    for (u16 i = 0; i < pfs_header.num_entries; i++) {
+    if (strtab_offset > size || pfs_header.strtab_size > size - strtab_offset)
+        return Loader::ResultStatus::Error;
+
+    const char* strtab = reinterpret_cast<const char*>(data + strtab_offset);
+    pfs_entries.reserve(pfs_header.num_entries);
+    for (u32 i = 0; i < pfs_header.num_entries; i++) {
         FileEntry entry;
 
-        memcpy(&entry.fs_entry, &file_data[entries_offset + (i * entry_size)], sizeof(FSEntry));
-        entry.name = std::string(reinterpret_cast<const char*>(
-            &file_data[strtab_offset + entry.fs_entry.strtab_offset]));
+        memcpy(&entry.fs_entry, data + entries_offset + (i * entry_size), sizeof(FSEntry));
+        if (entry.fs_entry.strtab_offset >= pfs_header.strtab_size)
+            return Loader::ResultStatus::Error;
+
+        const size_t max_length = pfs_header.strtab_size - entry.fs_entry.strtab_offset;
+        const char* name = strtab + entry.fs_entry.strtab_offset;
+        entry.name = std::string(name, strnlen(name, max_length));
         pfs_entries.push_back(std::move(entry));
     }
 
@@ -75,21 +110,21 @@ u32 PartitionFilesystem::GetNumEntries() const {
 }
 
 u64 PartitionFilesystem::GetEntryOffset(int index) const {
-    if (index > GetNumEntries())
+    if (index >= GetNumEntries())
         return 0;
 
     return content_offset + pfs_entries[index].fs_entry.offset;
 }
 
 u64 PartitionFilesystem::GetEntrySize(int index) const {
-    if (index > GetNumEntries())
+    if (index >= GetNumEntries())
         return 0;
 
     return pfs_entries[index].fs_entry.size;
 }
 
 std::string PartitionFilesystem::GetEntryName(int index) const {
-    if (index > GetNumEntries())
+    if (index >= GetNumEntries())
         return "";
 
     return pfs_entries[index].name;
@@ -113,6 +148,19 @@ u64 PartitionFilesystem::GetFileSize(const std::string& name) const {
     return 0;
 }
 
+std::unique_ptr<StorageBackend> PartitionFilesystem::OpenEntry(int index) const {
+    if (file == nullptr || index < 0 || index >= GetNumEntries())
+        return nullptr;
+
+    const u64 offset = base_offset + GetEntryOffset(index);
+    const u64 size = GetEntrySize(index);
+    if (offset > file->GetSize() || size > file->GetSize() - offset) {
+        LOG_ERROR(Service_FS, "PFS entry %d is past the end of the file", index);
+        return nullptr;
+    }
+    return std::make_unique<RomFS_Storage>(file, mapping, offset, size);
+}
+
 void PartitionFilesystem::Print() const {
     NGLOG_DEBUG(Service_FS, "Magic:                  {:.4}", pfs_header.magic.data());
     NGLOG_DEBUG(Service_FS, "Files:                  {}", pfs_header.num_entries);
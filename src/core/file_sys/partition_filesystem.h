@@ -5,21 +5,30 @@
 #pragma once
 
 #include <array>
+#include <memory>
 #include <string>
 #include <vector>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/swap.h"
 
+namespace FileUtil {
+class IOFile;
+class MappedFile;
+} // namespace FileUtil
+
 namespace Loader {
 enum class ResultStatus;
 }
 
 namespace FileSys {
 
+class StorageBackend;
+
 /**
  * Helper which implements an interface to parse PFS/HFS filesystems.
- * Data can either be loaded from a file path or data with an offset into it.
+ * Data can either be loaded from a file path or data with an offset into it. Files are mapped
+ * into memory, so that only the pages of the header and of the entries actually read are loaded.
  */
 class PartitionFilesystem {
 public:
@@ -33,9 +42,21 @@ public:
     u64 GetFileOffset(const std::string& name) const;
     u64 GetFileSize(const std::string& name) const;
 
+    /**
+     * Opens an entry of a filesystem loaded from a file, as a read-only storage on the part of
+     * the file it spans. The data isn't copied, reads come straight from the file mapping.
+     * @param index Index of the entry to open.
+     * @returns The storage, or nullptr if the index is out of range or the filesystem wasn't
+     * loaded from a file.
+     */
+    std::unique_ptr<StorageBackend> OpenEntry(int index) const;
+
     void Print() const;
 
 private:
+    /// Parses the header, entries and string table from the start of the given data.
+    Loader::ResultStatus Parse(const u8* data, size_t size);
+
     struct Header {
         std::array<char, 4> magic;
         u32_le num_entries;
@@ -82,6 +103,12 @@ private:
     size_t content_offset;
 
     std::vector<FileEntry> pfs_entries;
+
+    /// File the filesystem was loaded from, and its mapping, or nullptr if it couldn't be mapped
+    std::shared_ptr<FileUtil::IOFile> file;
+    std::shared_ptr<const FileUtil::MappedFile> mapping;
+    /// Offset of the filesystem in the file it was loaded from
+    size_t base_offset = 0;
 };
 
 } // namespace FileSys
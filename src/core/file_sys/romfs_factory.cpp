@@ -3,9 +3,12 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
 #include <memory>
+#include <string>
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "core/file_sys/errors.h"
 #include "core/file_sys/romfs_factory.h"
 #include "core/file_sys/romfs_filesystem.h"
 
@@ -13,13 +16,37 @@ namespace FileSys {
 
 RomFS_Factory::RomFS_Factory(Loader::AppLoader& app_loader) {
     // Load the RomFS from the app
-    if (Loader::ResultStatus::Success != app_loader.ReadRomFS(romfs_file, data_offset, data_size)) {
+    auto new_image = std::make_shared<RomFSImage>();
+    if (Loader::ResultStatus::Success !=
+        app_loader.ReadRomFS(new_image->file, new_image->data_offset, new_image->data_size)) {
         LOG_ERROR(Service_FS, "Unable to read RomFS!");
+        return;
     }
+
+    auto mapping = std::make_shared<const FileUtil::MappedFile>(*new_image->file);
+    if (mapping->IsMapped() && new_image->data_offset <= mapping->Size() &&
+        new_image->data_size <= mapping->Size() - new_image->data_offset) {
+        new_image->mapping = std::move(mapping);
+    } else {
+        LOG_WARNING(Service_FS, "Unable to map RomFS, falling back to file reads");
+    }
+
+    new_image->index = std::make_shared<const RomFSIndex>(
+        RomFS_Storage(new_image->file, new_image->mapping, new_image->data_offset,
+                      new_image->data_size));
+    // Images are never reused, so their files can't find the blocks of another image.
+    static std::atomic<u64> next_image_id{0};
+    new_image->cache_identity = "romfs" + std::to_string(next_image_id++) + ":";
+    image = std::move(new_image);
 }
 
 ResultVal<std::unique_ptr<FileSystemBackend>> RomFS_Factory::Open(const Path& path) {
-    auto archive = std::make_unique<RomFS_FileSystem>(romfs_file, data_offset, data_size);
+    if (image == nullptr) {
+        // The application has no RomFS, or it couldn't be read
+        return ERROR_PATH_NOT_FOUND;
+    }
+
+    auto archive = std::make_unique<RomFS_FileSystem>(image);
     return MakeResult<std::unique_ptr<FileSystemBackend>>(std::move(archive));
 }
 
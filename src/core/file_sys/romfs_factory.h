@@ -14,6 +14,8 @@
 
 namespace FileSys {
 
+struct RomFSImage;
+
 /// File system interface to the RomFS archive
 class RomFS_Factory final : public FileSystemFactory {
 public:
@@ -27,9 +29,9 @@ public:
     ResultVal<ArchiveFormatInfo> GetFormatInfo(const Path& path) const override;
 
 private:
-    std::shared_ptr<FileUtil::IOFile> romfs_file;
-    u64 data_offset;
-    u64 data_size;
+    /// The image of the app, mounted once and shared by every file system opened from it, or
+    /// nullptr if the app has no RomFS.
+    std::shared_ptr<const RomFSImage> image;
 };
 
 } // namespace FileSys
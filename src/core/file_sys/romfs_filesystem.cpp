@@ -6,6 +6,8 @@
 #include <memory>
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "core/file_sys/cached_storage.h"
+#include "core/file_sys/errors.h"
 #include "core/file_sys/romfs_filesystem.h"
 
 namespace FileSys {
@@ -16,8 +18,24 @@ std::string RomFS_FileSystem::GetName() const {
 
 ResultVal<std::unique_ptr<StorageBackend>> RomFS_FileSystem::OpenFile(const std::string& path,
                                                                       Mode mode) const {
-    return MakeResult<std::unique_ptr<StorageBackend>>(
-        std::make_unique<RomFS_Storage>(romfs_file, data_offset, data_size));
+    // An empty path opens the whole image, which is how the data storage is accessed.
+    if (path.empty()) {
+        return MakeResult<std::unique_ptr<StorageBackend>>(std::make_unique<RomFS_Storage>(
+            image->file, image->mapping, image->data_offset, image->data_size));
+    }
+
+    const RomFSIndex::Node* node = image->index->Find(path);
+    if (node == nullptr || node->type != EntryType::File) {
+        return ERROR_PATH_NOT_FOUND;
+    }
+
+    std::unique_ptr<StorageBackend> storage = std::make_unique<RomFS_Storage>(
+        image->file, image->mapping, image->data_offset + node->offset, node->size);
+    // Reads from the mapping are already served from memory.
+    if (image->mapping == nullptr) {
+        storage = MakeCachedStorage(std::move(storage), image->cache_identity + path);
+    }
+    return MakeResult<std::unique_ptr<StorageBackend>>(std::move(storage));
 }
 
 ResultCode RomFS_FileSystem::DeleteFile(const std::string& path) const {
@@ -71,8 +89,13 @@ ResultCode RomFS_FileSystem::RenameDirectory(const Path& src_path, const Path& d
 
 ResultVal<std::unique_ptr<DirectoryBackend>> RomFS_FileSystem::OpenDirectory(
     const std::string& path) const {
-    LOG_WARNING(Service_FS, "Opening Directory in a ROMFS archive");
-    return MakeResult<std::unique_ptr<DirectoryBackend>>(std::make_unique<ROMFSDirectory>());
+    const RomFSIndex::Node* node = image->index->Find(path);
+    if (node == nullptr || node->type != EntryType::Directory) {
+        return ERROR_PATH_NOT_FOUND;
+    }
+
+    return MakeResult<std::unique_ptr<DirectoryBackend>>(
+        std::make_unique<ROMFSDirectory>(image->index, *node));
 }
 
 u64 RomFS_FileSystem::GetFreeSpaceSize() const {
@@ -81,17 +104,28 @@ u64 RomFS_FileSystem::GetFreeSpaceSize() const {
 }
 
 ResultVal<FileSys::EntryType> RomFS_FileSystem::GetEntryType(const std::string& path) const {
-    LOG_CRITICAL(Service_FS, "Called within an ROMFS archive (path %s).", path.c_str());
-    // TODO(wwylele): Use correct error code
-    return ResultCode(-1);
+    const RomFSIndex::Node* node = image->index->Find(path);
+    if (node == nullptr) {
+        return ERROR_PATH_NOT_FOUND;
+    }
+    return MakeResult<EntryType>(node->type);
 }
 
 ResultVal<size_t> RomFS_Storage::Read(const u64 offset, const size_t length, u8* buffer) const {
     LOG_TRACE(Service_FS, "called offset=%llu, length=%zu", offset, length);
-    romfs_file->Seek(data_offset + offset, SEEK_SET);
+    if (offset >= data_size) {
+        return MakeResult<size_t>(0);
+    }
     size_t read_length = (size_t)std::min((u64)length, data_size - offset);
 
-    return MakeResult<size_t>(romfs_file->ReadBytes(buffer, read_length));
+    // Neither reads from the mapping nor positional reads touch the shared file position, so they
+    // can run concurrently.
+    if (romfs_mapping != nullptr) {
+        std::memcpy(buffer, romfs_mapping->Data() + data_offset + offset, read_length);
+        return MakeResult<size_t>(read_length);
+    }
+
+    return MakeResult<size_t>(romfs_file->ReadAt(buffer, read_length, data_offset + offset));
 }
 
 ResultVal<size_t> RomFS_Storage::Write(const u64 offset, const size_t length, const bool flush,
@@ -110,4 +144,23 @@ bool RomFS_Storage::SetSize(const u64 size) const {
     return false;
 }
 
+u64 ROMFSDirectory::Read(const u64 count, Entry* entries) {
+    u64 entries_read = 0;
+
+    while (entries_read < count && next_child != end_child) {
+        const RomFSIndex::Child& child = romfs_index->GetChildren()[next_child];
+        Entry& entry = entries[entries_read];
+
+        const size_t name_length = std::min(child.name.size(), FILENAME_LENGTH - 1);
+        std::memcpy(entry.filename, child.name.data(), name_length);
+        entry.filename[name_length] = '\0';
+        entry.type = child.type;
+        entry.file_size = child.size;
+
+        ++entries_read;
+        ++next_child;
+    }
+    return entries_read;
+}
+
 } // namespace FileSys
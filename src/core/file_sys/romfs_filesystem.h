@@ -12,11 +12,29 @@
 #include "common/file_util.h"
 #include "core/file_sys/directory.h"
 #include "core/file_sys/filesystem.h"
+#include "core/file_sys/romfs_index.h"
 #include "core/file_sys/storage.h"
 #include "core/hle/result.h"
 
 namespace FileSys {
 
+/**
+ * A mounted RomFS image. It is set up once when the image is registered and never changes
+ * afterwards, so every file system, storage and directory opened from it shares the same file,
+ * mapping and index without any locking.
+ */
+struct RomFSImage {
+    std::shared_ptr<FileUtil::IOFile> file;
+    /// Mapping of file, or nullptr if the file could not be mapped.
+    std::shared_ptr<const FileUtil::MappedFile> mapping;
+    /// Index of the entries of the image, used to open files and directories by path.
+    std::shared_ptr<const RomFSIndex> index;
+    u64 data_offset;
+    u64 data_size;
+    /// Identifies the image in the storage cache, which keeps the blocks of its files.
+    std::string cache_identity;
+};
+
 /**
  * Helper which implements an interface to deal with Switch .istorage ROMFS images used in some
  * archives This should be subclassed by concrete archive types, which will provide the input data
@@ -24,8 +42,7 @@ namespace FileSys {
  */
 class RomFS_FileSystem : public FileSystemBackend {
 public:
-    RomFS_FileSystem(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size)
-        : romfs_file(file), data_offset(offset), data_size(size) {}
+    explicit RomFS_FileSystem(std::shared_ptr<const RomFSImage> image) : image(std::move(image)) {}
 
     std::string GetName() const override;
 
@@ -44,15 +61,14 @@ public:
     ResultVal<EntryType> GetEntryType(const std::string& path) const override;
 
 protected:
-    std::shared_ptr<FileUtil::IOFile> romfs_file;
-    u64 data_offset;
-    u64 data_size;
+    std::shared_ptr<const RomFSImage> image;
 };
 
 class RomFS_Storage : public StorageBackend {
 public:
-    RomFS_Storage(std::shared_ptr<FileUtil::IOFile> file, u64 offset, u64 size)
-        : romfs_file(file), data_offset(offset), data_size(size) {}
+    RomFS_Storage(std::shared_ptr<FileUtil::IOFile> file,
+                  std::shared_ptr<const FileUtil::MappedFile> mapping, u64 offset, u64 size)
+        : romfs_file(file), romfs_mapping(mapping), data_offset(offset), data_size(size) {}
 
     ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override;
     ResultVal<size_t> Write(u64 offset, size_t length, bool flush, const u8* buffer) const override;
@@ -65,21 +81,31 @@ public:
 
 private:
     std::shared_ptr<FileUtil::IOFile> romfs_file;
+    /// Mapping of romfs_file, or nullptr if the file could not be mapped.
+    std::shared_ptr<const FileUtil::MappedFile> romfs_mapping;
     u64 data_offset;
     u64 data_size;
 };
 
 class ROMFSDirectory : public DirectoryBackend {
 public:
-    u64 Read(const u64 count, Entry* entries) override {
-        return 0;
-    }
+    ROMFSDirectory(std::shared_ptr<const RomFSIndex> index, const RomFSIndex::Node& directory)
+        : romfs_index(std::move(index)), next_child(directory.first_child),
+          end_child(directory.first_child + directory.num_children) {}
+
+    u64 Read(const u64 count, Entry* entries) override;
     u64 GetEntryCount() const override {
-        return 0;
+        return end_child - next_child;
     }
     bool Close() const override {
         return false;
     }
+
+private:
+    std::shared_ptr<const RomFSIndex> romfs_index;
+    /// Range of the directory's children in the index which have not been read yet
+    size_t next_child;
+    size_t end_child;
 };
 
 } // namespace FileSys
@@ -0,0 +1,208 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <deque>
+#include "common/logging/log.h"
+#include "common/swap.h"
+#include "core/file_sys/romfs_index.h"
+#include "core/file_sys/storage.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr u32 ROMFS_ENTRY_EMPTY = 0xFFFFFFFF;
+
+struct RomFSHeader {
+    u64_le header_size;
+    u64_le directory_hash_table_offset;
+    u64_le directory_hash_table_size;
+    u64_le directory_table_offset;
+    u64_le directory_table_size;
+    u64_le file_hash_table_offset;
+    u64_le file_hash_table_size;
+    u64_le file_table_offset;
+    u64_le file_table_size;
+    u64_le data_offset;
+};
+static_assert(sizeof(RomFSHeader) == 0x50, "RomFSHeader has incorrect size");
+
+struct DirectoryEntry {
+    u32_le parent;
+    u32_le sibling;
+    u32_le first_child_directory;
+    u32_le first_child_file;
+    u32_le hash_sibling;
+    u32_le name_length; ///< In bytes, followed by the UTF-8 name
+};
+static_assert(sizeof(DirectoryEntry) == 0x18, "DirectoryEntry has incorrect size");
+
+struct FileEntry {
+    u32_le parent;
+    u32_le sibling;
+    u64_le data_offset;
+    u64_le data_size;
+    u32_le hash_sibling;
+    u32_le name_length; ///< In bytes, followed by the UTF-8 name
+};
+static_assert(sizeof(FileEntry) == 0x20, "FileEntry has incorrect size");
+
+bool ReadTable(const StorageBackend& romfs, u64 offset, u64 size, std::vector<u8>& table) {
+    const u64 romfs_size = romfs.GetSize();
+    if (offset > romfs_size || size > romfs_size - offset) {
+        return false;
+    }
+
+    table.resize(size);
+    const ResultVal<size_t> read = romfs.Read(offset, table.size(), table.data());
+    return read.Succeeded() && *read == table.size();
+}
+
+/// Reads the entry at the given offset of a metadata table, along with its name.
+template <typename EntryT>
+bool ReadEntry(const std::vector<u8>& table, u32 offset, EntryT& entry, std::string& name) {
+    if (offset > table.size() || table.size() - offset < sizeof(EntryT)) {
+        return false;
+    }
+    std::memcpy(&entry, table.data() + offset, sizeof(EntryT));
+
+    const size_t name_offset = offset + sizeof(EntryT);
+    if (entry.name_length > table.size() - name_offset) {
+        return false;
+    }
+    name.assign(reinterpret_cast<const char*>(table.data() + name_offset), entry.name_length);
+    return true;
+}
+
+std::string JoinPath(const std::string& directory, const std::string& name) {
+    return directory == "/" ? directory + name : directory + '/' + name;
+}
+
+} // Anonymous namespace
+
+RomFSIndex::RomFSIndex(const StorageBackend& romfs) {
+    is_valid = Parse(romfs);
+    if (!is_valid) {
+        LOG_ERROR(Service_FS, "Unable to index the RomFS, the image is malformed");
+        nodes.clear();
+        children.clear();
+        node_indices.clear();
+    }
+}
+
+const RomFSIndex::Node* RomFSIndex::Find(const std::string& path) const {
+    const auto itr = node_indices.find(NormalizePath(path));
+    return itr == node_indices.end() ? nullptr : &nodes[itr->second];
+}
+
+std::string RomFSIndex::NormalizePath(const std::string& path) {
+    std::string normalized;
+    size_t component_start = 0;
+    while (component_start <= path.size()) {
+        size_t component_end = path.find_first_of("/\\", component_start);
+        if (component_end == std::string::npos) {
+            component_end = path.size();
+        }
+
+        const size_t length = component_end - component_start;
+        if (length != 0 && path.compare(component_start, length, ".") != 0) {
+            normalized += '/';
+            normalized.append(path, component_start, length);
+        }
+        component_start = component_end + 1;
+    }
+    return normalized.empty() ? "/" : normalized;
+}
+
+bool RomFSIndex::Parse(const StorageBackend& romfs) {
+    RomFSHeader header;
+    const ResultVal<size_t> read =
+        romfs.Read(0, sizeof(header), reinterpret_cast<u8*>(&header));
+    if (read.Failed() || *read != sizeof(header) || header.header_size < sizeof(header)) {
+        return false;
+    }
+
+    // File data is read straight from the image, so every file has to lie within its data region
+    const u64 romfs_size = romfs.GetSize();
+    if (header.data_offset > romfs_size) {
+        return false;
+    }
+    const u64 data_region_size = romfs_size - header.data_offset;
+
+    std::vector<u8> directory_table;
+    std::vector<u8> file_table;
+    if (!ReadTable(romfs, header.directory_table_offset, header.directory_table_size,
+                   directory_table) ||
+        !ReadTable(romfs, header.file_table_offset, header.file_table_size, file_table)) {
+        return false;
+    }
+
+    // Every entry of a well-formed image is visited exactly once, anything beyond that means the
+    // sibling links go around in circles.
+    const size_t max_entries = directory_table.size() / sizeof(DirectoryEntry) +
+                               file_table.size() / sizeof(FileEntry);
+    size_t num_entries = 0;
+
+    struct PendingDirectory {
+        u32 entry_offset;
+        size_t node_index;
+        std::string path;
+    };
+
+    // Directories are expanded breadth first, which keeps the children of each one contiguous.
+    nodes.push_back({EntryType::Directory, 0, 0, 0, 0});
+    node_indices.emplace("/", 0);
+    std::deque<PendingDirectory> pending{{0, 0, "/"}};
+
+    while (!pending.empty()) {
+        const PendingDirectory directory = std::move(pending.front());
+        pending.pop_front();
+
+        DirectoryEntry entry;
+        std::string name;
+        if (!ReadEntry(directory_table, directory.entry_offset, entry, name)) {
+            return false;
+        }
+
+        const size_t first_child = children.size();
+
+        for (u32 offset = entry.first_child_directory; offset != ROMFS_ENTRY_EMPTY;) {
+            DirectoryEntry child;
+            if (++num_entries > max_entries || !ReadEntry(directory_table, offset, child, name)) {
+                return false;
+            }
+
+            std::string path = JoinPath(directory.path, name);
+            children.push_back({std::move(name), EntryType::Directory, 0});
+            nodes.push_back({EntryType::Directory, 0, 0, 0, 0});
+            node_indices.emplace(path, nodes.size() - 1);
+            pending.push_back({offset, nodes.size() - 1, std::move(path)});
+            offset = child.sibling;
+        }
+
+        for (u32 offset = entry.first_child_file; offset != ROMFS_ENTRY_EMPTY;) {
+            FileEntry child;
+            if (++num_entries > max_entries || !ReadEntry(file_table, offset, child, name) ||
+                child.data_offset > data_region_size ||
+                child.data_size > data_region_size - child.data_offset) {
+                return false;
+            }
+
+            std::string path = JoinPath(directory.path, name);
+            children.push_back({std::move(name), EntryType::File, child.data_size});
+            nodes.push_back(
+                {EntryType::File, header.data_offset + child.data_offset, child.data_size, 0, 0});
+            node_indices.emplace(std::move(path), nodes.size() - 1);
+            offset = child.sibling;
+        }
+
+        nodes[directory.node_index].first_child = first_child;
+        nodes[directory.node_index].num_children = children.size() - first_child;
+    }
+
+    return true;
+}
+
+} // namespace FileSys
@@ -0,0 +1,78 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/file_sys/filesystem.h"
+
+namespace FileSys {
+
+class StorageBackend;
+
+/**
+ * Index of the files and directories of a Switch RomFS image, built once when the image is
+ * mounted. Paths are resolved with a single hash lookup of the normalized path instead of walking
+ * the directory and file tables of the image, and the children of each directory are stored next
+ * to each other so that they can be listed without further lookups.
+ */
+class RomFSIndex {
+public:
+    struct Node {
+        EntryType type;
+        /// Offset of the file data from the start of the image, 0 for directories.
+        u64 offset;
+        /// Size of the file data, 0 for directories.
+        u64 size;
+        /// Range of the directory's children in GetChildren(), empty for files.
+        size_t first_child;
+        size_t num_children;
+    };
+
+    struct Child {
+        std::string name;
+        EntryType type;
+        u64 size;
+    };
+
+    /// Parses the metadata of the RomFS image stored in the given storage.
+    explicit RomFSIndex(const StorageBackend& romfs);
+
+    /// Returns whether the image could be parsed.
+    bool IsValid() const {
+        return is_valid;
+    }
+
+    /**
+     * Looks up an entry of the image.
+     * @param path Path of the entry, which need not be normalized.
+     * @returns The entry, or nullptr if there is none with that path.
+     */
+    const Node* Find(const std::string& path) const;
+
+    /// Returns the children of all the directories, see Node::first_child.
+    const std::vector<Child>& GetChildren() const {
+        return children;
+    }
+
+    /**
+     * Converts a path to the form used as key of the index: components separated by a single
+     * '/', with a leading '/' and without trailing separators or "." components.
+     */
+    static std::string NormalizePath(const std::string& path);
+
+private:
+    bool Parse(const StorageBackend& romfs);
+
+    std::vector<Node> nodes;
+    std::vector<Child> children;
+    /// Index into `nodes` of each entry, keyed by normalized path
+    std::unordered_map<std::string, size_t> node_indices;
+    bool is_valid = false;
+};
+
+} // namespace FileSys
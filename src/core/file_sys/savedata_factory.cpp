@@ -8,8 +8,8 @@
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "core/core.h"
-#include "core/file_sys/disk_filesystem.h"
 #include "core/file_sys/savedata_factory.h"
+#include "core/file_sys/savedata_filesystem.h"
 #include "core/hle/kernel/process.h"
 
 namespace FileSys {
@@ -25,7 +25,7 @@ ResultVal<std::unique_ptr<FileSystemBackend>> SaveData_Factory::Open(const Path&
         return ResultCode(-1);
     }
 
-    auto archive = std::make_unique<Disk_FileSystem>(save_directory);
+    auto archive = std::make_unique<SaveData_FileSystem>(save_directory);
     return MakeResult<std::unique_ptr<FileSystemBackend>>(std::move(archive));
 }
 
@@ -0,0 +1,204 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/file_sys/errors.h"
+#include "core/file_sys/savedata_filesystem.h"
+
+namespace FileSys {
+
+namespace {
+
+/**
+ * Writes a file back to the host through a temporary file, which then replaces the original.
+ * Requires the overlay mutex to be held.
+ */
+bool WriteBack(const std::string& full_path, SaveData_FileSystem::BufferedFile& file) {
+    if (!file.dirty || file.detached) {
+        return true;
+    }
+
+    const std::string temp_path = full_path + ".tmp";
+    {
+        FileUtil::IOFile temp(temp_path, "wb");
+        if (!temp.IsOpen() || temp.WriteBytes(file.data.data(), file.data.size()) !=
+                                  file.data.size() ||
+            !temp.Flush()) {
+            LOG_ERROR(Service_FS, "Unable to write save data file %s", temp_path.c_str());
+            FileUtil::Delete(temp_path);
+            return false;
+        }
+    }
+
+    if (!FileUtil::Rename(temp_path, full_path)) {
+        FileUtil::Delete(temp_path);
+        return false;
+    }
+    file.dirty = false;
+    return true;
+}
+
+/// Storage on a save data file held in memory.
+class BufferedStorage final : public StorageBackend {
+public:
+    BufferedStorage(std::shared_ptr<SaveData_FileSystem::Overlay> overlay, std::string path,
+                    std::shared_ptr<SaveData_FileSystem::BufferedFile> file)
+        : overlay(std::move(overlay)), path(std::move(path)), file(std::move(file)) {}
+
+    ~BufferedStorage() override {
+        // Changes made after the archive was closed would be lost otherwise.
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        if (!overlay->archive_open) {
+            WriteBack(overlay->base_directory + path, *file);
+        }
+    }
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override {
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        const std::vector<u8>& data = file->data;
+        if (offset >= data.size()) {
+            return MakeResult<size_t>(0);
+        }
+        const size_t read_length = static_cast<size_t>(std::min<u64>(length, data.size() - offset));
+        std::memcpy(buffer, data.data() + offset, read_length);
+        return MakeResult<size_t>(read_length);
+    }
+
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush,
+                            const u8* buffer) const override {
+        // Flushing only takes effect on the next commit, which is what makes the commit atomic.
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        if (offset > SaveData_FileSystem::MAX_BUFFERED_FILE_SIZE ||
+            length > SaveData_FileSystem::MAX_BUFFERED_FILE_SIZE - offset) {
+            LOG_ERROR(Service_FS, "Write of 0x%zx bytes at 0x%" PRIx64 " to %s is too large",
+                      length, offset, path.c_str());
+            return ERROR_NOT_ENOUGH_FREE_SPACE;
+        }
+        std::vector<u8>& data = file->data;
+        if (offset + length > data.size()) {
+            data.resize(offset + length);
+        }
+        std::memcpy(data.data() + offset, buffer, length);
+        file->dirty = true;
+        return MakeResult<size_t>(length);
+    }
+
+    void Flush() const override {}
+
+    bool SetSize(u64 size) const override {
+        if (size > SaveData_FileSystem::MAX_BUFFERED_FILE_SIZE) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        file->data.resize(size);
+        file->dirty = true;
+        return true;
+    }
+
+    u64 GetSize() const override {
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        return file->data.size();
+    }
+
+    bool Close() const override {
+        return false;
+    }
+
+private:
+    std::shared_ptr<SaveData_FileSystem::Overlay> overlay;
+    std::string path;
+    std::shared_ptr<SaveData_FileSystem::BufferedFile> file;
+};
+
+} // Anonymous namespace
+
+SaveData_FileSystem::SaveData_FileSystem(std::string base_directory)
+    : Disk_FileSystem(std::move(base_directory)), overlay(std::make_shared<Overlay>()) {
+    overlay->base_directory = this->base_directory;
+}
+
+SaveData_FileSystem::~SaveData_FileSystem() {
+    Commit();
+    std::lock_guard<std::mutex> lock(overlay->mutex);
+    overlay->archive_open = false;
+}
+
+ResultVal<std::unique_ptr<StorageBackend>> SaveData_FileSystem::OpenFile(const std::string& path,
+                                                                         Mode mode) const {
+    std::lock_guard<std::mutex> lock(overlay->mutex);
+    auto itr = overlay->files.find(path);
+    if (itr == overlay->files.end()) {
+        const std::string full_path = base_directory + path;
+        if (!FileUtil::Exists(full_path) || FileUtil::IsDirectory(full_path)) {
+            return ERROR_PATH_NOT_FOUND;
+        }
+        if (FileUtil::GetSize(full_path) > MAX_BUFFERED_FILE_SIZE) {
+            return Disk_FileSystem::OpenFile(path, mode);
+        }
+
+        auto file = std::make_shared<BufferedFile>();
+        FileUtil::IOFile host_file(full_path, "rb");
+        file->data.resize(host_file.GetSize());
+        if (!host_file.IsOpen() ||
+            host_file.ReadBytes(file->data.data(), file->data.size()) != file->data.size()) {
+            LOG_ERROR(Service_FS, "Unable to read save data file %s", full_path.c_str());
+            return ERROR_PATH_NOT_FOUND;
+        }
+        itr = overlay->files.emplace(path, std::move(file)).first;
+    }
+
+    return MakeResult<std::unique_ptr<StorageBackend>>(
+        std::make_unique<BufferedStorage>(overlay, path, itr->second));
+}
+
+ResultCode SaveData_FileSystem::DeleteFile(const std::string& path) const {
+    // Storages still open on the file keep their contents, but they are never written back.
+    {
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        const auto itr = overlay->files.find(path);
+        if (itr != overlay->files.end()) {
+            itr->second->detached = true;
+            overlay->files.erase(itr);
+        }
+    }
+    return Disk_FileSystem::DeleteFile(path);
+}
+
+ResultCode SaveData_FileSystem::CreateFile(const std::string& path, u64 size) const {
+    {
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        const auto itr = overlay->files.find(path);
+        if (itr != overlay->files.end()) {
+            itr->second->detached = true;
+            overlay->files.erase(itr);
+        }
+    }
+    return Disk_FileSystem::CreateFile(path, size);
+}
+
+ResultVal<EntryType> SaveData_FileSystem::GetEntryType(const std::string& path) const {
+    {
+        std::lock_guard<std::mutex> lock(overlay->mutex);
+        if (overlay->files.count(path) != 0) {
+            return MakeResult(EntryType::File);
+        }
+    }
+    return Disk_FileSystem::GetEntryType(path);
+}
+
+ResultCode SaveData_FileSystem::Commit() const {
+    std::lock_guard<std::mutex> lock(overlay->mutex);
+    bool succeeded = true;
+    for (const auto& entry : overlay->files) {
+        succeeded &= WriteBack(base_directory + entry.first, *entry.second);
+    }
+    // Failing to write to the host is most likely from it running out of space
+    return succeeded ? RESULT_SUCCESS : ERROR_NOT_ENOUGH_FREE_SPACE;
+}
+
+} // namespace FileSys
@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/file_sys/disk_filesystem.h"
+#include "core/hle/result.h"
+
+namespace FileSys {
+
+/**
+ * Save data archive that keeps the files opened by the guest in memory and only writes them back
+ * to the host on Commit, or when the archive is closed. Each modified file is written to a
+ * temporary file first and then renamed over the original, so that a save is either fully updated
+ * or left as it was if the emulator is killed halfway through.
+ */
+class SaveData_FileSystem final : public Disk_FileSystem {
+public:
+    explicit SaveData_FileSystem(std::string base_directory);
+    ~SaveData_FileSystem() override;
+
+    ResultVal<std::unique_ptr<StorageBackend>> OpenFile(const std::string& path,
+                                                        Mode mode) const override;
+    ResultCode DeleteFile(const std::string& path) const override;
+    ResultCode CreateFile(const std::string& path, u64 size) const override;
+    ResultVal<EntryType> GetEntryType(const std::string& path) const override;
+    ResultCode Commit() const override;
+
+    /// Files larger than this are accessed on the host directly instead of being held in memory,
+    /// and the files held in memory can't grow past it.
+    static constexpr u64 MAX_BUFFERED_FILE_SIZE = 0x4000000;
+
+    /// Contents of a file of the archive, shared by every storage opened on it.
+    struct BufferedFile {
+        std::vector<u8> data;
+        /// Whether the data was changed since it was last written back
+        bool dirty = false;
+        /// Set when the file is deleted or recreated while storages are still open on it
+        bool detached = false;
+    };
+
+    /// State shared between the archive and the storages opened from it, which may outlive it.
+    struct Overlay {
+        std::string base_directory;
+        std::mutex mutex;
+        std::map<std::string, std::shared_ptr<BufferedFile>> files;
+        /// Cleared once the archive is closed, after which storages write their own file back
+        bool archive_open = true;
+    };
+
+private:
+    std::shared_ptr<Overlay> overlay;
+};
+
+} // namespace FileSys
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -23,6 +24,15 @@ public:
     virtual StatusType GetStatus() const {
         return {};
     }
+
+    /**
+     * Has the device call a callback with its new status whenever it changes, on whichever thread
+     * it learns of the change, so that it doesn't have to be polled.
+     * @returns Whether the device reports its changes. The ones that don't have to be polled.
+     */
+    virtual bool SetStatusCallback(std::function<void(const StatusType&)> callback) {
+        return false;
+    }
 };
 
 /// An abstract class template for a factory that can create input devices.
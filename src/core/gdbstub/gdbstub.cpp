@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <climits>
 #include <csignal>
@@ -13,7 +14,10 @@
 #include <cstdio>
 #include <cstring>
 #include <map>
+#include <mutex>
 #include <numeric>
+#include <string>
+#include <thread>
 #include <fcntl.h>
 
 #ifdef _WIN32
@@ -25,7 +29,6 @@
 #define SHUT_RDWR 2
 #else
 #include <netinet/in.h>
-#include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <unistd.h>
@@ -33,6 +36,8 @@
 
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread.h"
+#include "common/threadsafe_queue.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
@@ -63,6 +68,9 @@ const u32 SP_REGISTER = 31;
 const u32 PC_REGISTER = 32;
 const u32 CPSR_REGISTER = 33;
 
+/// BRK #0, which the JIT reports as a breakpoint exception.
+const u32 BRK_INSTRUCTION = 0xD4200000;
+
 // For sample XML files see the GDB source /gdb/features
 // GDB also wants the l character at the start
 // This XML defines what the registers are for this specific ARM device
@@ -132,21 +140,31 @@ static const char* target_xml =
 
 namespace GDBStub {
 
-static int gdbserver_socket = -1;
+static std::atomic<int> gdbserver_socket{-1};
 
+// Packet that is being handled on the emulation thread
 static u8 command_buffer[GDB_BUFFER_SIZE];
 static u32 command_length;
 
-static u32 latest_signal = 0;
+// The server thread blocks on the socket and queues complete packets for the emulation thread,
+// which handles them at the start of its next loop, or as soon as they arrive while it is halted.
+static std::thread server_thread;
+static Common::SPSCQueue<std::string, false> packet_queue;
+static Common::Event packet_event;
+
+// Both threads send to the client, only one of them may do so at a time
+static std::mutex send_mutex;
+
+static std::atomic<u32> latest_signal{0};
 static bool step_break = false;
-static bool memory_break = false;
+static std::atomic<bool> memory_break{false};
 
 // Binding to a port within the reserved ports range (0-1023) requires root permissions,
 // so default to a port outside of that range.
 static u16 gdbstub_port = 24689;
 
-static bool halt_loop = true;
-static bool step_loop = false;
+static std::atomic<bool> halt_loop{true};
+static std::atomic<bool> step_loop{false};
 
 // If set to false, the server will never be started and no
 // gdbstub-related functions will be executed.
@@ -160,12 +178,17 @@ struct Breakpoint {
     bool active;
     PAddr addr;
     u64 len;
+    /// Execute breakpoints are written into guest code as BRK instructions while the CPU runs
+    bool inserted = false;
+    u32 original_instruction = 0;
 };
 
 static std::map<u64, Breakpoint> breakpoints_execute;
 static std::map<u64, Breakpoint> breakpoints_read;
 static std::map<u64, Breakpoint> breakpoints_write;
 
+static void Disconnect();
+
 /**
  * Turns hex string character into the equivalent byte.
  *
@@ -321,7 +344,8 @@ static u8 ReadByte() {
     size_t received_size = recv(gdbserver_socket, reinterpret_cast<char*>(&c), 1, MSG_WAITALL);
     if (received_size != 1) {
         LOG_ERROR(Debug_GDBStub, "recv failed : %ld", received_size);
-        Shutdown();
+        Disconnect();
+        return 0;
     }
 
     return c;
@@ -425,6 +449,7 @@ bool CheckBreakpoint(PAddr addr, BreakpointType type) {
  * @param packet Packet to be sent to client.
  */
 static void SendPacket(const char packet) {
+    std::lock_guard<std::mutex> lock(send_mutex);
     size_t sent_size = send(gdbserver_socket, &packet, 1, 0);
     if (sent_size != 1) {
         LOG_ERROR(Debug_GDBStub, "send failed");
@@ -441,29 +466,32 @@ static void SendReply(const char* reply) {
         return;
     }
 
-    memset(command_buffer, 0, sizeof(command_buffer));
+    std::unique_lock<std::mutex> lock(send_mutex);
+    static u8 reply_buffer[GDB_BUFFER_SIZE];
+    memset(reply_buffer, 0, sizeof(reply_buffer));
 
-    command_length = static_cast<u32>(strlen(reply));
-    if (command_length + 4 > sizeof(command_buffer)) {
-        LOG_ERROR(Debug_GDBStub, "command_buffer overflow in SendReply");
+    const u32 reply_length = static_cast<u32>(strlen(reply));
+    if (reply_length + 4 > sizeof(reply_buffer)) {
+        LOG_ERROR(Debug_GDBStub, "reply_buffer overflow in SendReply");
         return;
     }
 
-    memcpy(command_buffer + 1, reply, command_length);
+    memcpy(reply_buffer + 1, reply, reply_length);
 
-    u8 checksum = CalculateChecksum(command_buffer, command_length + 1);
-    command_buffer[0] = GDB_STUB_START;
-    command_buffer[command_length + 1] = GDB_STUB_END;
-    command_buffer[command_length + 2] = NibbleToHex(checksum >> 4);
-    command_buffer[command_length + 3] = NibbleToHex(checksum);
+    u8 checksum = CalculateChecksum(reply_buffer, reply_length + 1);
+    reply_buffer[0] = GDB_STUB_START;
+    reply_buffer[reply_length + 1] = GDB_STUB_END;
+    reply_buffer[reply_length + 2] = NibbleToHex(checksum >> 4);
+    reply_buffer[reply_length + 3] = NibbleToHex(checksum);
 
-    u8* ptr = command_buffer;
-    u32 left = command_length + 4;
+    u8* ptr = reply_buffer;
+    u32 left = reply_length + 4;
     while (left > 0) {
         int sent_size = send(gdbserver_socket, reinterpret_cast<char*>(ptr), left, 0);
         if (sent_size < 0) {
             LOG_ERROR(Debug_GDBStub, "gdb: send failed");
-            return Shutdown();
+            lock.unlock();
+            return Disconnect();
         }
 
         left -= sent_size;
@@ -512,21 +540,22 @@ static void SendSignal(u32 signal) {
 
     latest_signal = signal;
 
-    std::string buffer = Common::StringFromFormat("T%02x", latest_signal);
+    std::string buffer = Common::StringFromFormat("T%02x", latest_signal.load());
     LOG_DEBUG(Debug_GDBStub, "Response: %s", buffer.c_str());
     SendReply(buffer.c_str());
 }
 
-/// Read command from gdb client.
+/// Read command from gdb client, and queue it for the emulation thread. Runs on the server thread.
 static void ReadCommand() {
-    command_length = 0;
-    memset(command_buffer, 0, sizeof(command_buffer));
+    static u8 receive_buffer[GDB_BUFFER_SIZE];
+    u32 receive_length = 0;
 
     u8 c = ReadByte();
     if (c == '+') {
         // ignore ack
         return;
     } else if (c == 0x03) {
+        // Handled right away, as the emulation thread only looks at packets between timeslices
         LOG_INFO(Debug_GDBStub, "gdb: found break command\n");
         halt_loop = true;
         SendSignal(SIGTRAP);
@@ -536,55 +565,45 @@ static void ReadCommand() {
         return;
     }
 
-    while ((c = ReadByte()) != GDB_STUB_END) {
-        if (command_length >= sizeof(command_buffer)) {
-            LOG_ERROR(Debug_GDBStub, "gdb: command_buffer overflow\n");
+    while (IsConnected() && (c = ReadByte()) != GDB_STUB_END) {
+        if (receive_length >= sizeof(receive_buffer)) {
+            LOG_ERROR(Debug_GDBStub, "gdb: receive_buffer overflow\n");
             SendPacket(GDB_STUB_NACK);
             return;
         }
-        command_buffer[command_length++] = c;
+        receive_buffer[receive_length++] = c;
+    }
+    if (!IsConnected()) {
+        return;
     }
 
     u8 checksum_received = HexCharToValue(ReadByte()) << 4;
     checksum_received |= HexCharToValue(ReadByte());
 
-    u8 checksum_calculated = CalculateChecksum(command_buffer, command_length);
+    u8 checksum_calculated = CalculateChecksum(receive_buffer, receive_length);
 
     if (checksum_received != checksum_calculated) {
         LOG_ERROR(Debug_GDBStub,
-                  "gdb: invalid checksum: calculated %02x and read %02x for $%s# (length: %d)\n",
-                  checksum_calculated, checksum_received, command_buffer, command_length);
-
-        command_length = 0;
+                  "gdb: invalid checksum: calculated %02x and read %02x for $%.*s# (length: %d)\n",
+                  checksum_calculated, checksum_received, static_cast<int>(receive_length),
+                  receive_buffer, receive_length);
 
         SendPacket(GDB_STUB_NACK);
         return;
     }
 
     SendPacket(GDB_STUB_ACK);
-}
-
-/// Check if there is data to be read from the gdb client.
-static bool IsDataAvailable() {
-    if (!IsConnected()) {
-        return false;
-    }
-
-    fd_set fd_socket;
-
-    FD_ZERO(&fd_socket);
-    FD_SET(gdbserver_socket, &fd_socket);
 
-    struct timeval t;
-    t.tv_sec = 0;
-    t.tv_usec = 0;
+    packet_queue.Push(std::string(reinterpret_cast<const char*>(receive_buffer), receive_length));
+    packet_event.Set();
+}
 
-    if (select(gdbserver_socket + 1, &fd_socket, nullptr, nullptr, &t) < 0) {
-        LOG_ERROR(Debug_GDBStub, "select failed");
-        return false;
+/// Entry point of the server thread, which blocks on the client socket until it is shut down.
+static void ServerLoop() {
+    Common::SetCurrentThreadName("GDBStub");
+    while (IsConnected()) {
+        ReadCommand();
     }
-
-    return FD_ISSET(gdbserver_socket, &fd_socket) != 0;
 }
 
 /// Send requested register to gdb client.
@@ -733,8 +752,7 @@ static void WriteMemory() {
 }
 
 void Break(bool is_memory_break) {
-    if (!halt_loop) {
-        halt_loop = true;
+    if (!halt_loop.exchange(true)) {
         SendSignal(SIGTRAP);
     }
 
@@ -875,20 +893,54 @@ static void RemoveBreakpoint() {
     SendReply("OK");
 }
 
-void HandlePacket() {
-    if (!IsConnected()) {
-        return;
+/**
+ * Writes the execute breakpoints into guest code while the CPU runs, and restores the original
+ * instructions while it is halted, so that the client never sees the BRK instructions. A
+ * breakpoint at the address execution resumes from is only written once the CPU moved past it.
+ */
+static void UpdateExecuteBreakpoints() {
+    const bool running = !halt_loop;
+    const VAddr pc = Core::CPU().GetPC();
+    bool changed = false;
+    for (auto& entry : breakpoints_execute) {
+        Breakpoint& breakpoint = entry.second;
+        if (!breakpoint.inserted && running && breakpoint.addr != pc &&
+            Memory::IsValidVirtualAddress(breakpoint.addr)) {
+            breakpoint.original_instruction = Memory::Read32(breakpoint.addr);
+            Memory::Write32(breakpoint.addr, BRK_INSTRUCTION);
+            breakpoint.inserted = true;
+            changed = true;
+        } else if (breakpoint.inserted && !running) {
+            Memory::Write32(breakpoint.addr, breakpoint.original_instruction);
+            breakpoint.inserted = false;
+            changed = true;
+        }
     }
-
-    if (!IsDataAvailable()) {
-        return;
+    if (changed) {
+        Core::CPU().ClearInstructionCache();
     }
+}
 
-    ReadCommand();
-    if (command_length == 0) {
-        return;
+bool RestoreExecuteBreakpoints(VAddr addr) {
+    bool changed = false;
+    bool found = false;
+    for (auto& entry : breakpoints_execute) {
+        Breakpoint& breakpoint = entry.second;
+        if (breakpoint.inserted) {
+            Memory::Write32(breakpoint.addr, breakpoint.original_instruction);
+            breakpoint.inserted = false;
+            changed = true;
+            found |= breakpoint.addr == addr;
+        }
     }
+    if (changed) {
+        Core::CPU().ClearInstructionCache();
+    }
+    return found;
+}
 
+/// Handle the packet in the command buffer.
+static void HandleCommand() {
     LOG_DEBUG(Debug_GDBStub, "Packet: %s", command_buffer);
 
     switch (command_buffer[0]) {
@@ -942,6 +994,35 @@ void HandlePacket() {
     }
 }
 
+void HandlePacket() {
+    if (!IsConnected()) {
+        // The client is gone, so the breakpoints it left in guest code are taken out and the CPU
+        // runs on as if it had never been attached.
+        RestoreExecuteBreakpoints(0);
+        halt_loop = false;
+        step_loop = false;
+        return;
+    }
+
+    // A halted CPU has nothing to do but wait for the client. The wait is bounded, so that the
+    // frontend can still stop emulation.
+    if (halt_loop && !step_loop && packet_queue.Empty()) {
+        packet_event.WaitUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    }
+
+    std::string packet;
+    while (IsConnected() && packet_queue.Pop(packet)) {
+        memset(command_buffer, 0, sizeof(command_buffer));
+        command_length = static_cast<u32>(std::min(packet.size(), sizeof(command_buffer) - 1));
+        memcpy(command_buffer, packet.data(), command_length);
+        HandleCommand();
+    }
+
+    if (IsConnected()) {
+        UpdateExecuteBreakpoints();
+    }
+}
+
 void SetServerPort(u16 port) {
     gdbstub_port = port;
 }
@@ -955,9 +1036,10 @@ void ToggleServer(bool status) {
             Init();
         }
     } else {
-        // Stop server
+        // Stop server. The CPU may be running on another thread, so it takes the breakpoints
+        // out of guest code itself, once it hits one of them.
         if (IsConnected()) {
-            Shutdown();
+            Disconnect();
         }
 
         server_enabled = status;
@@ -977,6 +1059,11 @@ static void Init(u16 port) {
     halt_loop = true;
     step_loop = false;
 
+    if (server_thread.joinable()) {
+        server_thread.join();
+    }
+    packet_queue.Clear();
+
     breakpoints_execute.clear();
     breakpoints_read.clear();
     breakpoints_write.clear();
@@ -1031,6 +1118,7 @@ static void Init(u16 port) {
     } else {
         LOG_INFO(Debug_GDBStub, "Client connected.\n");
         saddr_client.sin_addr.s_addr = ntohl(saddr_client.sin_addr.s_addr);
+        server_thread = std::thread(ServerLoop);
     }
 
     // Clean up temporary socket if it's still alive at this point.
@@ -1043,15 +1131,19 @@ void Init() {
     Init(gdbstub_port);
 }
 
-void Shutdown() {
-    if (!server_enabled) {
-        return;
+/// Closes the connection to the client. Can be called from any thread.
+static void Disconnect() {
+    LOG_INFO(Debug_GDBStub, "Stopping GDB ...");
+    const int socket = gdbserver_socket.exchange(-1);
+    if (socket != -1) {
+        shutdown(socket, SHUT_RDWR);
     }
 
-    LOG_INFO(Debug_GDBStub, "Stopping GDB ...");
-    if (gdbserver_socket != -1) {
-        shutdown(gdbserver_socket, SHUT_RDWR);
-        gdbserver_socket = -1;
+    // The server thread returns once its read from the shut down socket fails. It may also be
+    // the one shutting down after a failed read, in which case it is joined by the next Init or
+    // Shutdown.
+    if (server_thread.joinable() && server_thread.get_id() != std::this_thread::get_id()) {
+        server_thread.join();
     }
 
 #ifdef _WIN32
@@ -1061,6 +1153,15 @@ void Shutdown() {
     LOG_INFO(Debug_GDBStub, "GDB stopped.");
 }
 
+void Shutdown() {
+    if (!server_enabled) {
+        return;
+    }
+
+    Disconnect();
+    RestoreExecuteBreakpoints(0);
+}
+
 bool IsServerEnabled() {
     return server_enabled;
 }
@@ -41,7 +41,8 @@ void ToggleServer(bool status);
 /// Start the gdbstub server.
 void Init();
 
-/// Stop gdbstub server.
+/// Stop gdbstub server, and take its breakpoints out of guest code. Call it from the thread that
+/// runs the CPU, or while the CPU is stopped.
 void Shutdown();
 
 /// Checks if the gdbstub server is enabled.
@@ -63,6 +64,15 @@ bool IsMemoryBreak();
 /// Read and handle packet from gdb client.
 void HandlePacket();
 
+/**
+ * Writes the original instructions back over the execute breakpoints written into guest code.
+ * Only call it from the thread that runs the CPU.
+ *
+ * @param addr Address to look for a breakpoint at.
+ * @returns Whether one of the breakpoints written back was at addr.
+ */
+bool RestoreExecuteBreakpoints(VAddr addr);
+
 /**
  * Get the nearest breakpoint of the specified type at the given address.
  *
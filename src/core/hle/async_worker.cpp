@@ -0,0 +1,118 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include "common/assert.h"
+#include "common/common_types.h"
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "common/thread_placement.h"
+#include "core/core_timing.h"
+#include "core/hle/async_worker.h"
+
+namespace HLE::AsyncWorker {
+
+namespace {
+
+struct Job {
+    u64 id;
+    WorkFunction work;
+};
+
+std::thread worker_thread;
+
+// Shared between the CPU thread and the worker thread, protected by queue_mutex.
+std::mutex queue_mutex;
+std::condition_variable queue_cv;
+std::deque<Job> job_queue;
+bool stop_requested = false;
+
+// Only touched from the CPU thread.
+std::unordered_map<u64, CompletionFunction> pending_completions;
+CoreTiming::EventType* completion_event = nullptr;
+
+/// Job identifiers are never reused, so a completion posted by a previous session is ignored.
+u64 next_job_id = 0;
+
+void WorkerLoop() {
+    Common::SetCurrentThreadName("HLE Worker");
+    Common::SetCurrentThreadRole(Common::ThreadRole::Worker);
+
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_cv.wait(lock, [] { return stop_requested || !job_queue.empty(); });
+            if (stop_requested) {
+                return;
+            }
+            job = std::move(job_queue.front());
+            job_queue.pop_front();
+        }
+
+        job.work();
+        // Release anything captured by the work before handing control back to the CPU thread.
+        job.work = nullptr;
+
+        CoreTiming::ScheduleEventThreadsafe(0, completion_event, job.id);
+    }
+}
+
+void CompletionCallback(u64 job_id, int cycles_late) {
+    auto itr = pending_completions.find(job_id);
+    if (itr == pending_completions.end()) {
+        LOG_WARNING(Core, "Completion fired for unknown HLE job %" PRIu64, job_id);
+        return;
+    }
+
+    const CompletionFunction completion = std::move(itr->second);
+    pending_completions.erase(itr);
+    completion();
+}
+
+} // Anonymous namespace
+
+void Init() {
+    completion_event = CoreTiming::RegisterEvent("HLE::AsyncWorker", CompletionCallback);
+    stop_requested = false;
+}
+
+void Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        stop_requested = true;
+    }
+    queue_cv.notify_all();
+    if (worker_thread.joinable()) {
+        worker_thread.join();
+    }
+
+    job_queue.clear();
+    pending_completions.clear();
+    completion_event = nullptr;
+}
+
+void Submit(WorkFunction work, CompletionFunction completion) {
+    ASSERT_MSG(completion_event != nullptr, "HLE worker is not running");
+
+    if (!worker_thread.joinable()) {
+        worker_thread = std::thread(WorkerLoop);
+    }
+
+    const u64 id = next_job_id++;
+    pending_completions.emplace(id, std::move(completion));
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        job_queue.push_back({id, std::move(work)});
+    }
+    queue_cv.notify_one();
+}
+
+} // namespace HLE::AsyncWorker
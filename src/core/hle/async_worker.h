@@ -0,0 +1,39 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+
+namespace HLE::AsyncWorker {
+
+/// Work executed on the worker thread. It must not touch emulated memory or kernel objects.
+using WorkFunction = std::function<void()>;
+
+/// Function called on the CPU thread once the corresponding work has finished.
+using CompletionFunction = std::function<void()>;
+
+/**
+ * Prepares the worker, whose thread is started by the first Submit, so that a system booted before
+ * the guest submits any work can still be forked. Must be called after CoreTiming has been
+ * initialized.
+ */
+void Init();
+
+/// Stops the worker thread. Work that has not started yet is dropped along with its completion.
+void Shutdown();
+
+/**
+ * Queues a piece of work to be executed on the HLE worker thread, off the CPU thread. Work items
+ * are executed one at a time in submission order, so they never race each other, but they may run
+ * concurrently with any code on the CPU thread. Anything captured by `work` must therefore be safe
+ * to use from another thread; the data produced should be handed over to `completion`, which runs
+ * on the CPU thread from a CoreTiming callback and may freely access guest memory and the kernel.
+ * @param work Work to execute on the worker thread.
+ * @param completion Function called on the CPU thread after `work` has returned. It is destroyed
+ * on the CPU thread as well, so it may hold references to kernel objects.
+ */
+void Submit(WorkFunction work, CompletionFunction completion);
+
+} // namespace HLE::AsyncWorker
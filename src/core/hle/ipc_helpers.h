@@ -8,13 +8,16 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include "common/logging/log.h"
 #include "core/hle/ipc.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/server_port.h"
+#include "core/hle/result.h"
 
 namespace IPC {
 
@@ -118,7 +121,7 @@ public:
 
         AlignWithPadding();
 
-        const bool request_has_domain_header{context.GetDomainMessageHeader() != nullptr};
+        const bool request_has_domain_header{context.GetDomainMessageHeader().has_value()};
         if (context.Session()->IsDomain() && request_has_domain_header) {
             IPC::DomainMessageHeader domain_header{};
             domain_header.num_objects = num_domain_objects;
@@ -373,4 +376,64 @@ Kernel::SharedPtr<T> RequestParser::GetCopyObject(size_t index) {
     return context->GetCopyObject<T>(index);
 }
 
+/// Typed handlers ///
+
+/// Number of command buffer words taken up by a value pushed or popped with PushRaw/PopRaw.
+template <typename T>
+constexpr u32 RawWordSize = (sizeof(T) + 3) / 4;
+
+namespace Detail {
+template <typename T>
+struct IsResultVal : std::false_type {};
+
+template <typename T>
+struct IsResultVal<ResultVal<T>> : std::true_type {};
+
+template <typename T>
+void PushTypedResponse(Kernel::HLERequestContext& ctx, const ResultVal<T>& result) {
+    static_assert(std::is_trivially_copyable_v<T>, "Response values are copied as raw data");
+    if (result.Failed()) {
+        ResponseBuilder rb{ctx, 2};
+        rb.Push(result.Code());
+        return;
+    }
+
+    ResponseBuilder rb{ctx, 2 + RawWordSize<T>};
+    rb.Push(RESULT_SUCCESS);
+    rb.PushRaw(*result);
+}
+
+inline void PushTypedResponse(Kernel::HLERequestContext& ctx, ResultCode result) {
+    ResponseBuilder rb{ctx, 2};
+    rb.Push(result);
+}
+} // namespace Detail
+
+/**
+ * Unpacks the raw parameters of a request into typed arguments, calls the handler with them and
+ * builds the response from what it returns. The layout of the request and the response is fixed at
+ * compile time by the argument types and the return type, which must be either ResultCode or
+ * ResultVal<T>. Requests too short to hold all the arguments are rejected before the handler runs.
+ */
+template <typename Ret, typename... Args, typename Func>
+void InvokeTypedHandler(Kernel::HLERequestContext& ctx, Func&& func) {
+    static_assert((std::is_trivially_copyable_v<Args> && ...),
+                  "Request arguments are copied as raw data");
+    static_assert(std::is_same_v<Ret, ResultCode> || Detail::IsResultVal<Ret>::value,
+                  "Typed handlers must return ResultCode or ResultVal");
+
+    constexpr u32 arguments_size = (0 + ... + RawWordSize<Args>);
+    if (ctx.GetRawDataSize() < arguments_size) {
+        LOG_ERROR(IPC, "Request with %u words of data is too short for its %u words of arguments",
+                  ctx.GetRawDataSize(), arguments_size);
+        Detail::PushTypedResponse(ctx, Kernel::ERR_INVALID_SIZE);
+        return;
+    }
+
+    RequestParser rp{ctx};
+    // Braced initialization guarantees that the arguments are popped in order.
+    std::tuple<Args...> arguments{rp.PopRaw<Args>()...};
+    Detail::PushTypedResponse(ctx, std::apply(std::forward<Func>(func), std::move(arguments)));
+}
+
 } // namespace IPC
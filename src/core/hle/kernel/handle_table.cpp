@@ -25,11 +25,11 @@ ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     DEBUG_ASSERT(obj != nullptr);
 
     u16 slot = next_free_slot;
-    if (slot >= generations.size()) {
+    if (slot >= slots.size()) {
         LOG_ERROR(Kernel, "Unable to allocate Handle, too many slots in use.");
         return ERR_OUT_OF_HANDLES;
     }
-    next_free_slot = generations[slot];
+    next_free_slot = slots[slot].generation;
 
     u16 generation = next_generation++;
 
@@ -38,8 +38,8 @@ ResultVal<Handle> HandleTable::Create(SharedPtr<Object> obj) {
     if (next_generation >= (1 << 15))
         next_generation = 1;
 
-    generations[slot] = generation;
-    objects[slot] = std::move(obj);
+    slots[slot].generation = generation;
+    slots[slot].object = std::move(obj);
 
     Handle handle = generation | (slot << 15);
     return MakeResult<Handle>(handle);
@@ -60,37 +60,49 @@ ResultCode HandleTable::Close(Handle handle) {
 
     u16 slot = GetSlot(handle);
 
-    objects[slot] = nullptr;
+    slots[slot].object = nullptr;
 
-    generations[slot] = next_free_slot;
+    slots[slot].generation = next_free_slot;
     next_free_slot = slot;
     return RESULT_SUCCESS;
 }
 
-bool HandleTable::IsValid(Handle handle) const {
+const HandleTable::Slot* HandleTable::FindSlot(Handle handle) const {
     size_t slot = GetSlot(handle);
-    u16 generation = GetGeneration(handle);
+    if (slot >= MAX_COUNT) {
+        return nullptr;
+    }
+
+    const Slot& entry = slots[slot];
+    if (entry.object == nullptr || entry.generation != GetGeneration(handle)) {
+        return nullptr;
+    }
+    return &entry;
+}
 
-    return slot < MAX_COUNT && objects[slot] != nullptr && generations[slot] == generation;
+bool HandleTable::IsValid(Handle handle) const {
+    return FindSlot(handle) != nullptr;
 }
 
 SharedPtr<Object> HandleTable::GetGeneric(Handle handle) const {
+    return GetGenericBorrowed(handle);
+}
+
+Object* HandleTable::GetGenericBorrowed(Handle handle) const {
     if (handle == CurrentThread) {
         return GetCurrentThread();
     } else if (handle == CurrentProcess) {
-        return Core::CurrentProcess();
+        return Core::CurrentProcess().get();
     }
 
-    if (!IsValid(handle)) {
-        return nullptr;
-    }
-    return objects[GetSlot(handle)];
+    const Slot* slot = FindSlot(handle);
+    return slot != nullptr ? slot->object.get() : nullptr;
 }
 
 void HandleTable::Clear() {
     for (u16 i = 0; i < MAX_COUNT; ++i) {
-        generations[i] = i + 1;
-        objects[i] = nullptr;
+        slots[i].generation = i + 1;
+        slots[i].object = nullptr;
     }
     next_free_slot = 0;
 }
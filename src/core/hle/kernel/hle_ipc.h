@@ -5,7 +5,9 @@
 #pragma once
 
 #include <array>
+#include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 #include <boost/container/small_vector.hpp>
@@ -47,6 +49,11 @@ public:
      */
     virtual ResultCode HandleSyncRequest(Kernel::HLERequestContext& context) = 0;
 
+    /// Returns the direct request invoker of this handler, or nullptr if it has none.
+    RequestInvoker GetRequestInvoker() const {
+        return request_invoker;
+    }
+
     /**
      * Signals that a client has just connected to this HLE handler and keeps the
      * associated ServerSession alive for the duration of the connection.
@@ -66,6 +73,10 @@ protected:
     /// A ServerSession whose server endpoint is an HLE implementation is kept alive by this list
     // for the duration of the connection.
     std::vector<SharedPtr<ServerSession>> connected_sessions;
+
+    /// Set by handlers that can service requests directly, used as a fast path for domain
+    /// messages, which never carry anything but regular requests.
+    RequestInvoker request_invoker = nullptr;
 };
 
 /**
@@ -89,6 +100,10 @@ protected:
  */
 class HLERequestContext {
 public:
+    /// Buffer descriptors of a request. Requests rarely use more than a couple of each kind.
+    template <typename T>
+    using DescriptorList = boost::container::small_vector<T, 4>;
+
     HLERequestContext(SharedPtr<Kernel::ServerSession> session);
     ~HLERequestContext();
 
@@ -123,6 +138,19 @@ public:
     SharedPtr<Event> SleepClientThread(SharedPtr<Thread> thread, const std::string& reason,
                                        u64 timeout, WakeupCallback&& callback);
 
+    /**
+     * Puts the current guest thread to sleep while the specified work runs on the HLE worker
+     * thread, see HLE::AsyncWorker::Submit for the restrictions that apply to it. Once the work
+     * has finished the callback is invoked on the CPU thread and the thread is resumed.
+     * @param reason Reason for pausing the thread, to be used for debugging purposes.
+     * @param work Work to run off the CPU thread. It must not access emulated memory, the kernel
+     * or this context.
+     * @param callback Callback to be invoked when the thread is resumed. This callback must write
+     * the entire command response, as with SleepClientThread.
+     */
+    void RunAsync(const std::string& reason, std::function<void()>&& work,
+                  WakeupCallback&& callback);
+
     void ParseCommandBuffer(u32_le* src_cmdbuf, bool incoming);
 
     /// Populates this context with data from the requesting process/thread.
@@ -143,40 +171,61 @@ public:
         return data_payload_offset;
     }
 
-    const std::vector<IPC::BufferDescriptorX>& BufferDescriptorX() const {
+    /// Returns an upper bound of the number of words of raw data following the command id.
+    unsigned GetRawDataSize() const {
+        // Skip the u64 command id that starts the payload.
+        constexpr unsigned command_id_size = 2;
+        const unsigned payload_start = data_payload_offset + command_id_size;
+        return buffer_c_offset > payload_start ? buffer_c_offset - payload_start : 0;
+    }
+
+    const DescriptorList<IPC::BufferDescriptorX>& BufferDescriptorX() const {
         return buffer_x_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorA() const {
+    const DescriptorList<IPC::BufferDescriptorABW>& BufferDescriptorA() const {
         return buffer_a_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorABW>& BufferDescriptorB() const {
+    const DescriptorList<IPC::BufferDescriptorABW>& BufferDescriptorB() const {
         return buffer_b_desciptors;
     }
 
-    const std::vector<IPC::BufferDescriptorC>& BufferDescriptorC() const {
+    const DescriptorList<IPC::BufferDescriptorC>& BufferDescriptorC() const {
         return buffer_c_desciptors;
     }
 
-    const std::shared_ptr<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
+    const std::optional<IPC::DomainMessageHeader>& GetDomainMessageHeader() const {
         return domain_message_header;
     }
 
     /// Helper function to read a buffer using the appropriate buffer descriptor
-    std::vector<u8> ReadBuffer() const;
+    std::vector<u8> ReadBuffer(size_t buffer_index = 0) const;
 
     /// Helper function to write a buffer using the appropriate buffer descriptor
-    size_t WriteBuffer(const void* buffer, size_t size) const;
+    size_t WriteBuffer(const void* buffer, size_t size, size_t buffer_index = 0) const;
 
     /// Helper function to write a buffer using the appropriate buffer descriptor
-    size_t WriteBuffer(const std::vector<u8>& buffer) const;
+    size_t WriteBuffer(const std::vector<u8>& buffer, size_t buffer_index = 0) const;
 
     /// Helper function to get the size of the input buffer
-    size_t GetReadBufferSize() const;
+    size_t GetReadBufferSize(size_t buffer_index = 0) const;
 
     /// Helper function to get the size of the output buffer
-    size_t GetWriteBufferSize() const;
+    size_t GetWriteBufferSize(size_t buffer_index = 0) const;
+
+    /**
+     * Helper function to access the input buffer in place instead of copying it with ReadBuffer.
+     * Returns nullptr if the buffer is not backed by contiguous host memory.
+     */
+    const u8* GetReadBufferPointer() const;
+
+    /**
+     * Helper function to fill the first `size` bytes of the output buffer in place instead of
+     * going through WriteBuffer. Returns nullptr if those bytes are not backed by contiguous host
+     * memory, or if they don't fit in the buffer.
+     */
+    u8* GetWriteBufferPointer(size_t size) const;
 
     template <typename T>
     SharedPtr<T> GetCopyObject(size_t index) {
@@ -232,15 +281,17 @@ private:
     boost::container::small_vector<SharedPtr<Object>, 8> copy_objects;
     boost::container::small_vector<std::shared_ptr<SessionRequestHandler>, 8> domain_objects;
 
-    std::shared_ptr<IPC::CommandHeader> command_header;
-    std::shared_ptr<IPC::HandleDescriptorHeader> handle_descriptor_header;
-    std::shared_ptr<IPC::DataPayloadHeader> data_payload_header;
-    std::shared_ptr<IPC::DomainMessageHeader> domain_message_header;
-    std::vector<IPC::BufferDescriptorX> buffer_x_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_a_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_b_desciptors;
-    std::vector<IPC::BufferDescriptorABW> buffer_w_desciptors;
-    std::vector<IPC::BufferDescriptorC> buffer_c_desciptors;
+    // The headers and descriptors are stored inline, so that handling a request doesn't need any
+    // heap allocations in the common case.
+    std::optional<IPC::CommandHeader> command_header;
+    std::optional<IPC::HandleDescriptorHeader> handle_descriptor_header;
+    std::optional<IPC::DataPayloadHeader> data_payload_header;
+    std::optional<IPC::DomainMessageHeader> domain_message_header;
+    DescriptorList<IPC::BufferDescriptorX> buffer_x_desciptors;
+    DescriptorList<IPC::BufferDescriptorABW> buffer_a_desciptors;
+    DescriptorList<IPC::BufferDescriptorABW> buffer_b_desciptors;
+    DescriptorList<IPC::BufferDescriptorABW> buffer_w_desciptors;
+    DescriptorList<IPC::BufferDescriptorC> buffer_c_desciptors;
 
     unsigned data_payload_offset{};
     unsigned buffer_c_offset{};
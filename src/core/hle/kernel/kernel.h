@@ -11,6 +11,12 @@
 #include "common/assert.h"
 #include "common/common_types.h"
 
+/*
+ * The HLE kernel state (threads, processes, handle tables, wait objects and services) belongs to
+ * the CPU thread, which is the only thread that reads or modifies it, so none of it is locked.
+ * Host threads, such as the HLE worker or the sockets poller, hand their results back with
+ * CoreTiming::ScheduleEventThreadsafe, which runs them on the CPU thread.
+ */
 namespace Kernel {
 
 using Handle = u32;
@@ -122,6 +128,18 @@ inline SharedPtr<T> DynamicObjectCast(SharedPtr<Object> object) {
     return nullptr;
 }
 
+/**
+ * Attempts to downcast the given Object pointer to a pointer to T, without taking a reference.
+ * @return Derived pointer to the object, or `nullptr` if `object` isn't of type T.
+ */
+template <typename T>
+inline T* DynamicObjectCast(Object* object) {
+    if (object != nullptr && object->GetHandleType() == T::HANDLE_TYPE) {
+        return static_cast<T*>(object);
+    }
+    return nullptr;
+}
+
 /// Initialize the kernel with the specified system mode.
 void Init(u32 system_mode);
 
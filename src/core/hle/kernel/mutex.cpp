@@ -6,6 +6,7 @@
 #include <vector>
 #include <boost/range/algorithm_ext/erase.hpp>
 #include "common/assert.h"
+#include "core/arm/exclusive_monitor.h"
 #include "core/core.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/kernel.h"
@@ -96,11 +97,10 @@ void Mutex::UpdatePriority() {
     if (!GetHoldingThread())
         return;
 
-    u32 best_priority = THREADPRIO_LOWEST;
-    for (auto& waiter : GetWaitingThreads()) {
-        if (waiter->current_priority < best_priority)
-            best_priority = waiter->current_priority;
-    }
+    // Waiting threads are sorted by priority, the first one has the best priority.
+    const auto& waiters = GetWaitingThreads();
+    const u32 best_priority =
+        waiters.empty() ? THREADPRIO_LOWEST : waiters.front()->current_priority;
 
     if (best_priority != priority) {
         priority = best_priority;
@@ -119,9 +119,9 @@ SharedPtr<Thread> Mutex::GetHoldingThread() const {
 }
 
 void Mutex::SetHoldingThread(SharedPtr<Thread> thread) {
-    GuestState guest_state{Memory::Read32(guest_addr)};
-    guest_state.holding_thread_handle.Assign(thread ? thread->guest_handle : 0);
-    Memory::Write32(guest_addr, guest_state.raw);
+    UpdateGuestState([&](GuestState& guest_state) {
+        guest_state.holding_thread_handle.Assign(thread ? thread->guest_handle : 0);
+    });
 }
 
 bool Mutex::GetHasWaiters() const {
@@ -130,9 +130,22 @@ bool Mutex::GetHasWaiters() const {
 }
 
 void Mutex::SetHasWaiters(bool has_waiters) {
-    GuestState guest_state{Memory::Read32(guest_addr)};
-    guest_state.has_waiters.Assign(has_waiters ? 1 : 0);
-    Memory::Write32(guest_addr, guest_state.raw);
+    UpdateGuestState(
+        [&](GuestState& guest_state) { guest_state.has_waiters.Assign(has_waiters ? 1 : 0); });
+}
+
+template <typename Func>
+void Mutex::UpdateGuestState(Func&& func) {
+    // The guest may modify the mutex tag concurrently from another core, so the update is
+    // retried until it is applied to an unchanged value.
+    auto& monitor = Core::System::GetInstance().Monitor();
+    GuestState guest_state{};
+    u32 expected;
+    do {
+        expected = Memory::Read32(guest_addr);
+        guest_state.raw = expected;
+        func(guest_state);
+    } while (!monitor.CompareExchange32(guest_addr, expected, guest_state.raw));
 }
 
 } // namespace Kernel
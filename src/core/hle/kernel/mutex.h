@@ -90,6 +90,10 @@ private:
         BitField<30, 1, u32_le> has_waiters;
     };
     static_assert(sizeof(GuestState) == 4, "GuestState size is incorrect");
+
+    /// Atomically applies func to the guest state, retrying if the guest modifies it meanwhile.
+    template <typename Func>
+    void UpdateGuestState(Func&& func);
 };
 
 /**
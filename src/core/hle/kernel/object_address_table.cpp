@@ -2,33 +2,102 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <utility>
 #include "common/assert.h"
 #include "core/hle/kernel/object_address_table.h"
 
 namespace Kernel {
 
+/// Slots the table starts with, which most applications never outgrow
+constexpr size_t INITIAL_SLOT_COUNT = 256;
+
 ObjectAddressTable g_object_address_table;
 
+ObjectAddressTable::ObjectAddressTable() : slots(INITIAL_SLOT_COUNT) {}
+
+size_t ObjectAddressTable::HomeSlot(VAddr addr) const {
+    // Guest objects are word aligned and often allocated next to each other, so the bits are
+    // mixed for neighbours not to fill runs of slots
+    u64 hash = addr;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return static_cast<size_t>(hash) & (slots.size() - 1);
+}
+
 void ObjectAddressTable::Insert(VAddr addr, SharedPtr<Object> obj) {
-    ASSERT_MSG(objects.find(addr) == objects.end(), "Object already exists with addr=0x%lx", addr);
-    objects[addr] = obj;
+    ASSERT_MSG(addr != 0, "Objects can't be inserted at address 0");
+    if ((num_objects + 1) * 2 > slots.size()) {
+        Grow();
+    }
+
+    const size_t mask = slots.size() - 1;
+    for (size_t index = HomeSlot(addr);; index = (index + 1) & mask) {
+        Slot& slot = slots[index];
+        if (slot.addr == 0) {
+            slot.addr = addr;
+            slot.object = std::move(obj);
+            ++num_objects;
+            return;
+        }
+        ASSERT_MSG(slot.addr != addr, "Object already exists with addr=0x%lx", addr);
+    }
 }
 
 void ObjectAddressTable::Close(VAddr addr) {
-    ASSERT_MSG(objects.find(addr) != objects.end(), "Object does not exist with addr=0x%lx", addr);
-    objects.erase(addr);
+    const size_t mask = slots.size() - 1;
+    size_t index = HomeSlot(addr);
+    while (slots[index].addr != addr) {
+        ASSERT_MSG(slots[index].addr != 0, "Object does not exist with addr=0x%lx", addr);
+        index = (index + 1) & mask;
+    }
+    slots[index] = {};
+    --num_objects;
+
+    // Moves the objects after the freed slot back into it when they probed past it, so that
+    // lookups can stop at the first free slot without any markers of removed objects
+    size_t hole = index;
+    for (size_t next = (hole + 1) & mask; slots[next].addr != 0; next = (next + 1) & mask) {
+        const size_t home = HomeSlot(slots[next].addr);
+        const bool reaches_hole = ((next - home) & mask) >= ((next - hole) & mask);
+        if (reaches_hole) {
+            slots[hole] = std::move(slots[next]);
+            slots[next] = {};
+            hole = next;
+        }
+    }
+}
+
+Object* ObjectAddressTable::GetGenericBorrowed(VAddr addr) const {
+    if (addr == 0) {
+        return nullptr;
+    }
+    const size_t mask = slots.size() - 1;
+    for (size_t index = HomeSlot(addr);; index = (index + 1) & mask) {
+        const Slot& slot = slots[index];
+        if (slot.addr == addr) {
+            return slot.object.get();
+        }
+        if (slot.addr == 0) {
+            return nullptr;
+        }
+    }
 }
 
-SharedPtr<Object> ObjectAddressTable::GetGeneric(VAddr addr) const {
-    auto iter = objects.find(addr);
-    if (iter != objects.end()) {
-        return iter->second;
+void ObjectAddressTable::Grow() {
+    std::vector<Slot> old_slots(slots.size() * 2);
+    std::swap(slots, old_slots);
+    num_objects = 0;
+    for (Slot& slot : old_slots) {
+        if (slot.addr != 0) {
+            Insert(slot.addr, std::move(slot.object));
+        }
     }
-    return {};
 }
 
 void ObjectAddressTable::Clear() {
-    objects.clear();
+    slots.assign(INITIAL_SLOT_COUNT, {});
+    num_objects = 0;
 }
 
 } // namespace Kernel
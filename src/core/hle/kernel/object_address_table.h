@@ -4,7 +4,7 @@
 
 #pragma once
 
-#include <map>
+#include <vector>
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
 
@@ -18,7 +18,7 @@ namespace Kernel {
  */
 class ObjectAddressTable final : NonCopyable {
 public:
-    ObjectAddressTable() = default;
+    ObjectAddressTable();
 
     /**
      * Inserts an object and address pair into the table.
@@ -37,7 +37,9 @@ public:
      * Looks up an object by its address.
      * @return Pointer to the looked-up object, or `nullptr` if the handle is not valid.
      */
-    SharedPtr<Object> GetGeneric(VAddr addr) const;
+    SharedPtr<Object> GetGeneric(VAddr addr) const {
+        return GetGenericBorrowed(addr);
+    }
 
     /**
      * Looks up an object by its address while verifying its type.
@@ -49,12 +51,48 @@ public:
         return DynamicObjectCast<T>(GetGeneric(addr));
     }
 
+    /**
+     * Looks up an object by its address without taking a reference to it. The returned pointer
+     * is only valid while the object stays in the table, so it must not be kept beyond the
+     * current SVC.
+     * @return Pointer to the looked-up object, or `nullptr` if there is none at the address.
+     */
+    Object* GetGenericBorrowed(VAddr addr) const;
+
+    /**
+     * Looks up an object by its address while verifying its type, without taking a reference.
+     * @return Pointer to the looked-up object, or `nullptr` if there is none at the address or
+     *         its type differs from the requested one.
+     */
+    template <class T>
+    T* GetBorrowed(VAddr addr) const {
+        return DynamicObjectCast<T>(GetGenericBorrowed(addr));
+    }
+
     /// Closes all addresses held in this table.
     void Clear();
 
 private:
-    /// Stores the Object referenced by the address
-    std::map<VAddr, SharedPtr<Object>> objects;
+    struct Slot {
+        /// Address of the object, 0 for a free slot. Guest objects never live at address 0.
+        VAddr addr = 0;
+        SharedPtr<Object> object;
+    };
+
+    /// Returns the slot an address starts probing from.
+    size_t HomeSlot(VAddr addr) const;
+
+    /// Doubles the number of slots, and inserts the objects again.
+    void Grow();
+
+    /**
+     * Objects by address, with open addressing and linear probing. Lookups happen on every
+     * ArbitrateLock, ArbitrateUnlock and condition variable SVC, and that keeps the probes of
+     * one in a cache line or two. Lookups don't change the table, so they can run concurrently
+     * with each other. The number of slots is a power of two, at most half of them used.
+     */
+    std::vector<Slot> slots;
+    size_t num_objects = 0;
 };
 
 extern ObjectAddressTable g_object_address_table;
@@ -6,7 +6,10 @@
 #include <memory>
 #include "common/assert.h"
 #include "common/common_funcs.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/memory_util.h"
+#include "core/arm/guest_profiler.h"
 #include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
@@ -145,10 +148,16 @@ void Process::LoadModule(SharedPtr<CodeSet> module_, VAddr base_addr) {
 
     auto MapSegment = [&](CodeSet::Segment& segment, VMAPermission permissions,
                           MemoryState memory_state) {
-        auto vma = vm_manager
-                       .MapMemoryBlock(segment.addr + base_addr, module_->memory, segment.offset,
-                                       segment.size, memory_state)
-                       .Unwrap();
+        const VAddr address = segment.addr + base_addr;
+        auto vma = module_->mapping
+                       ? vm_manager
+                             .MapBackingMemory(address, module_->mapping->Data() + segment.offset,
+                                               segment.size, memory_state)
+                             .Unwrap()
+                       : vm_manager
+                             .MapMemoryBlock(address, module_->memory, segment.offset,
+                                             segment.size, memory_state)
+                             .Unwrap();
         vm_manager.Reprotect(vma, permissions);
         misc_memory_used += segment.size;
         memory_region->used += segment.size;
@@ -158,6 +167,12 @@ void Process::LoadModule(SharedPtr<CodeSet> module_, VAddr base_addr) {
     MapSegment(module_->code, VMAPermission::ReadExecute, MemoryState::CodeStatic);
     MapSegment(module_->rodata, VMAPermission::Read, MemoryState::CodeMutable);
     MapSegment(module_->data, VMAPermission::ReadWrite, MemoryState::CodeMutable);
+    if (module_->mapping) {
+        module_mappings.push_back(module_->mapping);
+    }
+
+    const u64 module_size = module_->data.addr + module_->data.size;
+    GuestProfiler::RegisterModule(module_->name, base_addr, module_size);
 }
 
 VAddr Process::GetLinearHeapAreaAddress() const {
@@ -189,18 +204,27 @@ ResultVal<VAddr> Process::HeapAllocate(VAddr target, u64 size, VMAPermission per
     }
 
     // If necessary, expand backing vector to cover new heap extents.
+    const u8* old_heap_data = heap_memory->data();
+    bool heap_moved = false;
     if (target < heap_start) {
         heap_memory->insert(begin(*heap_memory), heap_start - target, 0);
         heap_start = target;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+        heap_moved = true;
     }
     if (target + size > heap_end) {
         heap_memory->insert(end(*heap_memory), (target + size) - heap_end, 0);
         heap_end = target + size;
-        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+        heap_moved |= heap_memory->data() != old_heap_data;
+        AdviseHugePages(heap_memory->data(), heap_memory->size());
     }
     ASSERT(heap_end - heap_start == heap_memory->size());
 
+    // Growing the heap in place keeps the existing mappings valid, they only have to be refreshed
+    // when the backing memory moved.
+    if (heap_moved) {
+        vm_manager.RefreshMemoryBlockMappings(heap_memory.get());
+    }
+
     CASCADE_RESULT(auto vma, vm_manager.MapMemoryBlock(target, heap_memory, target - heap_start,
                                                        size, MemoryState::Heap));
     vm_manager.Reprotect(vma, perms);
@@ -280,19 +304,28 @@ ResultCode Process::MirrorMemory(VAddr dst_addr, VAddr src_addr, u64 size) {
     auto vma = vm_manager.FindVMA(src_addr);
 
     ASSERT_MSG(vma != vm_manager.vma_map.end(), "Invalid memory address");
-    ASSERT_MSG(vma->second.backing_block, "Backing block doesn't exist for address");
+    ASSERT_MSG(vma->second.backing_block || vma->second.type == VMAType::BackingMemory,
+               "Backing block doesn't exist for address");
 
     // The returned VMA might be a bigger one encompassing the desired address.
     auto vma_offset = src_addr - vma->first;
     ASSERT_MSG(vma_offset + size <= vma->second.size,
                "Shared memory exceeds bounds of mapped block");
 
-    const std::shared_ptr<std::vector<u8>>& backing_block = vma->second.backing_block;
-    size_t backing_block_offset = vma->second.offset + vma_offset;
+    VMManager::VMAHandle new_vma;
+    if (vma->second.type == VMAType::BackingMemory) {
+        // Modules mapped from their files
+        u8* const backing_memory = vma->second.backing_memory + vma_offset;
+        CASCADE_RESULT(new_vma, vm_manager.MapBackingMemory(dst_addr, backing_memory, size,
+                                                            MemoryState::Mapped));
+    } else {
+        const std::shared_ptr<std::vector<u8>>& backing_block = vma->second.backing_block;
+        size_t backing_block_offset = vma->second.offset + vma_offset;
 
-    CASCADE_RESULT(auto new_vma,
-                   vm_manager.MapMemoryBlock(dst_addr, backing_block, backing_block_offset, size,
-                                             MemoryState::Mapped));
+        CASCADE_RESULT(new_vma, vm_manager.MapMemoryBlock(dst_addr, backing_block,
+                                                          backing_block_offset, size,
+                                                          MemoryState::Mapped));
+    }
     // Protect mirror with permissions from old region
     vm_manager.Reprotect(new_vma, vma->second.permissions);
     // Remove permissions from old region
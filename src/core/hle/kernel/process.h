@@ -16,6 +16,10 @@
 #include "core/hle/kernel/thread.h"
 #include "core/hle/kernel/vm_manager.h"
 
+namespace FileUtil {
+class CopyOnWriteMapping;
+}
+
 namespace Kernel {
 
 struct AddressMapping {
@@ -74,11 +78,15 @@ struct CodeSet final : public Object {
     std::string name;
 
     std::shared_ptr<std::vector<u8>> memory;
+    /// Mapping of the module file that backs the segments in place of memory, if not null
+    std::shared_ptr<FileUtil::CopyOnWriteMapping> mapping;
 
     struct Segment {
         size_t offset = 0;
         VAddr addr = 0;
         u32 size = 0;
+        /// Hash of the segment contents as loaded, identifying the same code across boots
+        u64 content_hash = 0;
     };
 
     Segment segments[3];
@@ -168,6 +176,10 @@ public:
 
     u64 heap_used = 0, linear_heap_used = 0, misc_memory_used = 0;
 
+    /// File mappings backing the modules that were loaded from them, which live as long as the
+    /// process because nothing else owns them.
+    std::vector<std::shared_ptr<FileUtil::CopyOnWriteMapping>> module_mappings;
+
     MemoryRegionInfo* memory_region = nullptr;
 
     /// The Thread Local Storage area is allocated as processes create threads,
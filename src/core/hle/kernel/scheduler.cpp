@@ -50,7 +50,8 @@ void Scheduler::SwitchContext(Thread* new_thread) {
     // Save context for previous thread
     if (previous_thread) {
         previous_thread->last_running_ticks = CoreTiming::GetTicks();
-        cpu_core->SaveContext(previous_thread->context);
+        // The vector registers stay in the CPU until another thread needs it
+        cpu_core->SaveGeneralContext(previous_thread->context);
 
         if (previous_thread->status == THREADSTATUS_RUNNING) {
             // This is only the case when a reschedule is triggered without the current thread
@@ -80,7 +81,15 @@ void Scheduler::SwitchContext(Thread* new_thread) {
             SetCurrentPageTable(&Core::CurrentProcess()->vm_manager.page_table);
         }
 
-        cpu_core->LoadContext(new_thread->context);
+        cpu_core->LoadGeneralContext(new_thread->context);
+        if (vector_context_thread != new_thread) {
+            if (vector_context_thread != nullptr &&
+                vector_context_thread->status != THREADSTATUS_DEAD) {
+                cpu_core->SaveVectorContext(vector_context_thread->context);
+            }
+            cpu_core->LoadVectorContext(new_thread->context);
+            vector_context_thread = new_thread;
+        }
         cpu_core->SetTlsAddress(new_thread->GetTLSAddress());
     } else {
         current_thread = nullptr;
@@ -104,9 +113,20 @@ void Scheduler::Reschedule() {
     SwitchContext(next);
 }
 
+bool Scheduler::YieldCurrentThread() {
+    Thread* thread = GetCurrentThread();
+    if (ready_queue.empty(thread->current_priority)) {
+        return false;
+    }
+
+    // A ready thread isn't put back into the queue when switched out, so it stays at the back
+    thread->status = THREADSTATUS_READY;
+    ready_queue.push_back(thread->current_priority, thread);
+    return true;
+}
+
 void Scheduler::AddThread(SharedPtr<Thread> thread, u32 priority) {
     thread_list.push_back(thread);
-    ready_queue.prepare(priority);
 }
 
 void Scheduler::RemoveThread(Thread* thread) {
@@ -128,8 +148,6 @@ void Scheduler::SetThreadPriority(Thread* thread, u32 priority) {
     // If thread was ready, adjust queues
     if (thread->status == THREADSTATUS_READY)
         ready_queue.move(thread, thread->current_priority, priority);
-    else
-        ready_queue.prepare(priority);
 }
 
 } // namespace Kernel
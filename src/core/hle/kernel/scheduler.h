@@ -23,6 +23,13 @@ public:
     /// Reschedules to the next available thread (call after current thread is suspended)
     void Reschedule();
 
+    /**
+     * Moves the current thread behind the other ready threads of its priority. The switch to the
+     * next thread happens on the following reschedule.
+     * @return Whether another thread of the same priority was ready, if not nothing is changed
+     */
+    bool YieldCurrentThread();
+
     /// Gets the current running thread
     Thread* GetCurrentThread() const;
 
@@ -67,6 +74,11 @@ private:
 
     SharedPtr<Thread> current_thread = nullptr;
 
+    /// Thread whose vector registers the CPU holds, which are only saved to its context once
+    /// another thread's are loaded. Threads that get switched back to right away, after idling
+    /// or handling an event, then never have them copied.
+    SharedPtr<Thread> vector_context_thread = nullptr;
+
     ARM_Interface* cpu_core;
 };
 
@@ -8,6 +8,7 @@
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/client_port.h"
 #include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/errors.h"
 #include "core/hle/kernel/handle_table.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/process.h"
@@ -58,19 +59,43 @@ void ServerSession::Acquire(Thread* thread) {
     pending_requesting_threads.pop_back();
 }
 
+u32 ServerSession::AddDomainObject(std::shared_ptr<SessionRequestHandler> handler) {
+    const RequestInvoker invoker = handler->GetRequestInvoker();
+    domain_request_handlers.push_back({std::move(handler), invoker});
+    return static_cast<u32>(domain_request_handlers.size());
+}
+
 ResultCode ServerSession::HandleDomainSyncRequest(Kernel::HLERequestContext& context) {
     auto& domain_message_header = context.GetDomainMessageHeader();
     if (domain_message_header) {
         // If there is a DomainMessageHeader, then this is CommandType "Request"
         const u32 object_id{context.GetDomainMessageHeader()->object_id};
+        if (object_id == 0 || object_id > domain_request_handlers.size() ||
+            domain_request_handlers[object_id - 1].handler == nullptr) {
+            LOG_ERROR(IPC, "Domain request to invalid object_id=0x%08X", object_id);
+            IPC::ResponseBuilder rb{context, 2};
+            rb.Push(ERR_INVALID_HANDLE);
+            context.WriteToOutgoingCommandBuffer(*GetCurrentThread());
+            return RESULT_SUCCESS;
+        }
+
         switch (domain_message_header->command) {
-        case IPC::DomainMessageHeader::CommandType::SendMessage:
-            return domain_request_handlers[object_id - 1]->HandleSyncRequest(context);
+        case IPC::DomainMessageHeader::CommandType::SendMessage: {
+            // The handler may add objects to the domain, so don't keep a reference into the list.
+            const DomainObject& object = domain_request_handlers[object_id - 1];
+            SessionRequestHandler* const handler = object.handler.get();
+            if (const auto invoker = object.invoker) {
+                invoker(*handler, context);
+                context.WriteToOutgoingCommandBuffer(*GetCurrentThread());
+                return RESULT_SUCCESS;
+            }
+            return handler->HandleSyncRequest(context);
+        }
 
         case IPC::DomainMessageHeader::CommandType::CloseVirtualHandle: {
             LOG_DEBUG(IPC, "CloseVirtualHandle, object_id=0x%08X", object_id);
 
-            domain_request_handlers[object_id - 1] = nullptr;
+            domain_request_handlers[object_id - 1] = {};
 
             IPC::ResponseBuilder rb{context, 2};
             rb.Push(RESULT_SUCCESS);
@@ -139,7 +164,7 @@ ResultCode ServerSession::HandleSyncRequest(SharedPtr<Thread> thread) {
     // end of the command such that only commands following this one are handled as domains
     if (convert_to_domain) {
         ASSERT_MSG(domain_request_handlers.empty(), "already a domain");
-        domain_request_handlers = {hle_handler};
+        AddDomainObject(hle_handler);
         convert_to_domain = false;
     }
 
@@ -23,6 +23,10 @@ class SessionRequestHandler;
 class Thread;
 class HLERequestContext;
 
+/// Function that services a regular request to a handler without going through
+/// SessionRequestHandler::HandleSyncRequest. The caller is responsible for writing the response.
+using RequestInvoker = void (*)(SessionRequestHandler& handler, HLERequestContext& context);
+
 /**
  * Kernel object representing the server endpoint of an IPC session. Sessions are the basic CTR-OS
  * primitive for communication between different processes, and are used to implement service calls
@@ -82,8 +86,15 @@ public:
     std::shared_ptr<SessionRequestHandler>
         hle_handler; ///< This session's HLE request handler (applicable when not a domain)
 
-    /// This is the list of domain request handlers (after conversion to a domain)
-    std::vector<std::shared_ptr<SessionRequestHandler>> domain_request_handlers;
+    struct DomainObject {
+        std::shared_ptr<SessionRequestHandler> handler;
+        /// Cached from the handler, so that requests skip the HandleSyncRequest indirection.
+        RequestInvoker invoker;
+    };
+
+    /// This is the list of domain request handlers (after conversion to a domain), indexed by
+    /// object id - 1. Closed objects leave a null entry behind, ids are never reused.
+    std::vector<DomainObject> domain_request_handlers;
 
     /// List of threads that are pending a response after a sync request. This list is processed in
     /// a LIFO manner, thus, the last request will be dispatched first.
@@ -105,6 +116,12 @@ public:
         convert_to_domain = true;
     }
 
+    /**
+     * Adds an object to the domain.
+     * @returns The id of the new object.
+     */
+    u32 AddDomainObject(std::shared_ptr<SessionRequestHandler> handler);
+
 private:
     ServerSession();
     ~ServerSession() override;
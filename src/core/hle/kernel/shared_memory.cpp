@@ -60,15 +60,21 @@ SharedPtr<SharedMemory> SharedMemory::Create(SharedPtr<Process> owner_process, u
         // The memory is already available and mapped in the owner process.
         auto vma = vm_manager.FindVMA(address);
         ASSERT_MSG(vma != vm_manager.vma_map.end(), "Invalid memory address");
-        ASSERT_MSG(vma->second.backing_block, "Backing block doesn't exist for address");
+        ASSERT_MSG(vma->second.backing_block || vma->second.type == VMAType::BackingMemory,
+                   "Backing block doesn't exist for address");
 
         // The returned VMA might be a bigger one encompassing the desired address.
         auto vma_offset = address - vma->first;
         ASSERT_MSG(vma_offset + size <= vma->second.size,
                    "Shared memory exceeds bounds of mapped block");
 
-        shared_memory->backing_block = vma->second.backing_block;
-        shared_memory->backing_block_offset = vma->second.offset + vma_offset;
+        if (vma->second.type == VMAType::BackingMemory) {
+            shared_memory->backing_memory = vma->second.backing_memory + vma_offset;
+            shared_memory->backing_block_offset = 0;
+        } else {
+            shared_memory->backing_block = vma->second.backing_block;
+            shared_memory->backing_block_offset = vma->second.offset + vma_offset;
+        }
     }
 
     shared_memory->base_address = address;
@@ -128,8 +134,12 @@ ResultCode SharedMemory::Map(Process* target_process, VAddr address, MemoryPermi
     }
 
     // Map the memory block into the target process
-    auto result = target_process->vm_manager.MapMemoryBlock(
-        target_address, backing_block, backing_block_offset, size, MemoryState::Shared);
+    auto result = backing_memory != nullptr
+                      ? target_process->vm_manager.MapBackingMemory(target_address, backing_memory,
+                                                                    size, MemoryState::Shared)
+                      : target_process->vm_manager.MapMemoryBlock(target_address, backing_block,
+                                                                  backing_block_offset, size,
+                                                                  MemoryState::Shared);
     if (result.Failed()) {
         LOG_ERROR(Kernel,
                   "cannot map id=%u, target_address=0x%lx name=%s, error mapping to virtual memory",
@@ -154,6 +164,9 @@ VMAPermission SharedMemory::ConvertPermissions(MemoryPermission permission) {
 };
 
 u8* SharedMemory::GetPointer(u32 offset) {
+    if (backing_memory != nullptr) {
+        return backing_memory + offset;
+    }
     return backing_block->data() + backing_block_offset + offset;
 }
 
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
+#include "common/assert.h"
 #include "common/common_types.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
@@ -104,6 +106,20 @@ public:
      */
     u8* GetPointer(u32 offset = 0);
 
+    /**
+     * Gets a typed view of the shared memory block. The block is backed by a single host buffer
+     * that every mapping aliases, so updates through the view are immediately visible to the
+     * processes that mapped it.
+     * @param offset Offset from the start of the shared memory block to the viewed object
+     * @return Reference to the object at the specified offset
+     */
+    template <typename T>
+    T& GetView(u32 offset = 0) {
+        static_assert(std::is_trivially_copyable_v<T>, "Views require trivially copyable types");
+        ASSERT(offset + sizeof(T) <= size);
+        return *reinterpret_cast<T*>(GetPointer(offset));
+    }
+
     /// Process that created this shared memory block.
     SharedPtr<Process> owner_process;
     /// Address of shared memory block in the owner process if specified.
@@ -115,6 +131,9 @@ public:
     std::shared_ptr<std::vector<u8>> backing_block;
     /// Offset into the backing block for this shared memory.
     size_t backing_block_offset;
+    /// Memory that backs the block in place of backing_block when the block was created over a
+    /// BackingMemory mapping, like a file mapped into the owner process. Not owned by the block.
+    u8* backing_memory = nullptr;
     /// Size of the memory block. Page-aligned.
     u64 size;
     /// Permission restrictions applied to the process which created the block.
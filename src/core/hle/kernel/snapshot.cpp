@@ -0,0 +1,172 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <atomic>
+#include <mutex>
+#include "core/core.h"
+#include "core/hle/kernel/condition_variable.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/snapshot.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/timer.h"
+#include "core/hle/kernel/wait_object.h"
+
+namespace Kernel {
+
+namespace {
+
+std::atomic<bool> snapshot_requested{false};
+
+// Only held to exchange the pointer, the snapshot itself is immutable once published
+std::mutex latest_snapshot_mutex;
+std::shared_ptr<const KernelSnapshot> latest_snapshot;
+
+void CaptureThread(KernelSnapshot& snapshot, const Thread& thread);
+
+void CaptureObject(KernelSnapshot& snapshot, const WaitObject& object) {
+    if (snapshot.objects.count(object.GetObjectId()) != 0) {
+        return;
+    }
+
+    WaitObjectSnapshot& entry = snapshot.objects[object.GetObjectId()];
+    entry.object_id = object.GetObjectId();
+    entry.handle_type = object.GetHandleType();
+    entry.type_name = object.GetTypeName();
+    entry.name = object.GetName();
+
+    const auto& waiting_threads = object.GetWaitingThreads();
+    entry.waiting_threads.reserve(waiting_threads.size());
+    for (const auto& thread : waiting_threads) {
+        entry.waiting_threads.push_back(thread->GetObjectId());
+    }
+
+    switch (object.GetHandleType()) {
+    case HandleType::Event:
+        entry.reset_type = static_cast<const Event&>(object).reset_type;
+        break;
+    case HandleType::Mutex: {
+        const auto& mutex = static_cast<const Mutex&>(object);
+        if (mutex.GetHasWaiters()) {
+            const SharedPtr<Thread> holding_thread = mutex.GetHoldingThread();
+            if (holding_thread != nullptr) {
+                entry.holding_thread = holding_thread->GetObjectId();
+            }
+        }
+        break;
+    }
+    case HandleType::ConditionVariable:
+        entry.available_count = static_cast<const ConditionVariable&>(object).GetAvailableCount();
+        break;
+    case HandleType::Timer: {
+        const auto& timer = static_cast<const Timer&>(object);
+        entry.reset_type = timer.reset_type;
+        entry.initial_delay = timer.initial_delay;
+        entry.interval_delay = timer.interval_delay;
+        break;
+    }
+    default:
+        break;
+    }
+
+    for (const auto& thread : waiting_threads) {
+        CaptureThread(snapshot, *thread);
+    }
+    if (object.GetHandleType() == HandleType::Mutex) {
+        const SharedPtr<Thread> holding_thread =
+            static_cast<const Mutex&>(object).GetHoldingThread();
+        if (holding_thread != nullptr) {
+            CaptureThread(snapshot, *holding_thread);
+        }
+    } else if (object.GetHandleType() == HandleType::Thread) {
+        CaptureThread(snapshot, static_cast<const Thread&>(object));
+    }
+}
+
+void CaptureThread(KernelSnapshot& snapshot, const Thread& thread) {
+    if (snapshot.threads.count(thread.GetObjectId()) != 0) {
+        return;
+    }
+
+    ThreadSnapshot& entry = snapshot.threads[thread.GetObjectId()];
+    entry.object_id = thread.GetObjectId();
+    entry.thread_id = thread.GetThreadId();
+    entry.status = thread.status;
+    entry.pc = thread.context.pc;
+    entry.lr = thread.context.cpu_registers[30];
+    entry.processor_id = thread.processor_id;
+    entry.nominal_priority = thread.nominal_priority;
+    entry.current_priority = thread.current_priority;
+    entry.last_running_ticks = thread.last_running_ticks;
+    for (const auto& mutex : thread.held_mutexes) {
+        entry.held_mutexes.push_back(mutex->GetObjectId());
+    }
+    for (const auto& object : thread.wait_objects) {
+        entry.wait_objects.push_back(object->GetObjectId());
+    }
+    entry.wait_all = thread.IsSleepingOnWaitAll();
+
+    CaptureObject(snapshot, thread);
+    for (const auto& mutex : thread.held_mutexes) {
+        CaptureObject(snapshot, *mutex);
+    }
+    for (const auto& object : thread.wait_objects) {
+        CaptureObject(snapshot, *object);
+    }
+}
+
+} // Anonymous namespace
+
+const WaitObjectSnapshot* KernelSnapshot::FindObject(u32 object_id) const {
+    const auto it = objects.find(object_id);
+    return it != objects.end() ? &it->second : nullptr;
+}
+
+const ThreadSnapshot* KernelSnapshot::FindThread(u32 object_id) const {
+    const auto it = threads.find(object_id);
+    return it != threads.end() ? &it->second : nullptr;
+}
+
+std::shared_ptr<const KernelSnapshot> CaptureSnapshot() {
+    auto snapshot = std::make_shared<KernelSnapshot>();
+    Core::System& system = Core::System::GetInstance();
+    if (!system.IsPoweredOn()) {
+        return snapshot;
+    }
+
+    const auto& threads = system.Scheduler().GetThreadList();
+    snapshot->thread_list.reserve(threads.size());
+    for (const auto& thread : threads) {
+        snapshot->thread_list.push_back(thread->GetObjectId());
+        CaptureThread(*snapshot, *thread);
+    }
+    return snapshot;
+}
+
+void RequestSnapshot() {
+    snapshot_requested = true;
+}
+
+void CaptureSnapshotIfRequested() {
+    if (!snapshot_requested.exchange(false)) {
+        return;
+    }
+
+    auto snapshot = CaptureSnapshot();
+    std::lock_guard<std::mutex> lock(latest_snapshot_mutex);
+    latest_snapshot = std::move(snapshot);
+}
+
+std::shared_ptr<const KernelSnapshot> GetLatestSnapshot() {
+    std::lock_guard<std::mutex> lock(latest_snapshot_mutex);
+    return latest_snapshot;
+}
+
+void ClearSnapshots() {
+    snapshot_requested = false;
+    std::lock_guard<std::mutex> lock(latest_snapshot_mutex);
+    latest_snapshot = nullptr;
+}
+
+} // namespace Kernel
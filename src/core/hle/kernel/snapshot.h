@@ -0,0 +1,97 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/kernel/kernel.h"
+
+namespace Kernel {
+
+/// State of a wait object, copied out of the kernel so that it can be read from another thread.
+struct WaitObjectSnapshot {
+    u32 object_id = 0;
+    HandleType handle_type = HandleType::Unknown;
+    std::string type_name;
+    std::string name;
+    /// Object ids of the threads waiting on this object
+    std::vector<u32> waiting_threads;
+
+    // Events and timers
+    ResetType reset_type = ResetType::OneShot;
+    // Mutexes, the holding thread is 0 if the mutex has no waiters
+    u32 holding_thread = 0;
+    // Condition variables
+    s32 available_count = 0;
+    // Timers
+    u64 initial_delay = 0;
+    u64 interval_delay = 0;
+};
+
+/// State of a thread, in addition to its WaitObjectSnapshot.
+struct ThreadSnapshot {
+    u32 object_id = 0;
+    u32 thread_id = 0;
+    u32 status = 0;
+    u64 pc = 0;
+    u64 lr = 0;
+    s32 processor_id = 0;
+    u32 nominal_priority = 0;
+    u32 current_priority = 0;
+    u64 last_running_ticks = 0;
+    /// Object ids of the mutexes held by the thread
+    std::vector<u32> held_mutexes;
+    /// Object ids of the objects the thread waits on, in the order they were passed
+    std::vector<u32> wait_objects;
+    bool wait_all = false;
+};
+
+/**
+ * Threads and the wait objects reachable from them, as of one point in emulation. All references
+ * between objects are object ids, which can be looked up in the snapshot itself.
+ */
+struct KernelSnapshot {
+    /// Object ids of the threads known to the scheduler, in its order
+    std::vector<u32> thread_list;
+    std::map<u32, WaitObjectSnapshot> objects;
+    std::map<u32, ThreadSnapshot> threads;
+
+    /// Returns the object with the given id, or nullptr if it isn't part of the snapshot.
+    const WaitObjectSnapshot* FindObject(u32 object_id) const;
+
+    /// Returns the thread with the given id, or nullptr if it isn't part of the snapshot.
+    const ThreadSnapshot* FindThread(u32 object_id) const;
+};
+
+/**
+ * Copies the state of all threads and the objects they wait on.
+ * @warning Only call on the emulation thread, or while emulation is paused.
+ */
+std::shared_ptr<const KernelSnapshot> CaptureSnapshot();
+
+/**
+ * Asks the emulation thread for a snapshot at its next safe point. Retrieve it with
+ * GetLatestSnapshot once it has been captured.
+ * @note This function is thread-safe
+ */
+void RequestSnapshot();
+
+/// Captures a snapshot if one was requested. Called by the emulation thread between timeslices.
+void CaptureSnapshotIfRequested();
+
+/**
+ * Returns the most recently requested snapshot, or nullptr if none was captured since the last
+ * ClearSnapshots.
+ * @note This function is thread-safe
+ */
+std::shared_ptr<const KernelSnapshot> GetLatestSnapshot();
+
+/// Drops the latest snapshot and any pending request.
+void ClearSnapshots();
+
+} // namespace Kernel
@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
 #include <cinttypes>
 #include <iterator>
 
@@ -24,7 +25,6 @@
 #include "core/hle/kernel/svc.h"
 #include "core/hle/kernel/svc_wrap.h"
 #include "core/hle/kernel/thread.h"
-#include "core/hle/lock.h"
 #include "core/hle/result.h"
 #include "core/hle/service/service.h"
 
@@ -108,7 +108,7 @@ static ResultCode SendSyncRequest(Handle handle) {
 static ResultCode GetThreadId(u32* thread_id, Handle thread_handle) {
     LOG_TRACE(Kernel_SVC, "called thread=0x%08X", thread_handle);
 
-    const SharedPtr<Thread> thread = g_handle_table.Get<Thread>(thread_handle);
+    const Thread* thread = g_handle_table.GetBorrowed<Thread>(thread_handle);
     if (!thread) {
         return ERR_INVALID_HANDLE;
     }
@@ -121,7 +121,7 @@ static ResultCode GetThreadId(u32* thread_id, Handle thread_handle) {
 static ResultCode GetProcessId(u32* process_id, Handle process_handle) {
     LOG_TRACE(Kernel_SVC, "called process=0x%08X", process_handle);
 
-    const SharedPtr<Process> process = g_handle_table.Get<Process>(process_handle);
+    const Process* process = g_handle_table.GetBorrowed<Process>(process_handle);
     if (!process) {
         return ERR_INVALID_HANDLE;
     }
@@ -192,23 +192,27 @@ static ResultCode WaitSynchronization(Handle* index, VAddr handles_address, u64
 
     auto thread = GetCurrentThread();
 
+    // Most waits find an object that is already signalled, so the handles and objects are kept
+    // on the stack and only moved to the heap when the thread actually has to wait.
+    std::array<Handle, MaxHandles> handles;
+    Memory::ReadBlock(handles_address, handles.data(), handle_count * sizeof(Handle));
+
     using ObjectPtr = SharedPtr<WaitObject>;
-    std::vector<ObjectPtr> objects(handle_count);
+    std::array<ObjectPtr, MaxHandles> objects;
+    const auto objects_end = objects.begin() + handle_count;
 
     for (int i = 0; i < handle_count; ++i) {
-        Handle handle = Memory::Read32(handles_address + i * sizeof(Handle));
-        auto object = g_handle_table.Get<WaitObject>(handle);
-        if (object == nullptr)
+        objects[i] = g_handle_table.Get<WaitObject>(handles[i]);
+        if (objects[i] == nullptr)
             return ERR_INVALID_HANDLE;
-        objects[i] = object;
     }
 
     // Find the first object that is acquirable in the provided list of objects
-    auto itr = std::find_if(objects.begin(), objects.end(), [thread](const ObjectPtr& object) {
+    auto itr = std::find_if(objects.begin(), objects_end, [thread](const ObjectPtr& object) {
         return !object->ShouldWait(thread);
     });
 
-    if (itr != objects.end()) {
+    if (itr != objects_end) {
         // We found a ready object, acquire it and set the result value
         WaitObject* object = itr->get();
         object->Acquire(thread);
@@ -223,10 +227,11 @@ static ResultCode WaitSynchronization(Handle* index, VAddr handles_address, u64
     if (nano_seconds == 0)
         return RESULT_TIMEOUT;
 
-    for (auto& object : objects)
-        object->AddWaitingThread(thread);
+    for (auto object = objects.begin(); object != objects_end; ++object)
+        (*object)->AddWaitingThread(thread);
 
-    thread->wait_objects = std::move(objects);
+    thread->wait_objects.assign(std::make_move_iterator(objects.begin()),
+                                std::make_move_iterator(objects_end));
     thread->status = THREADSTATUS_WAIT_SYNCH_ANY;
 
     // Create an event to wake the thread up after the specified nanosecond delay has passed
@@ -284,7 +289,7 @@ static ResultCode ArbitrateLock(Handle holding_thread_handle, VAddr mutex_addr,
 static ResultCode ArbitrateUnlock(VAddr mutex_addr) {
     LOG_TRACE(Kernel_SVC, "called mutex_addr=0x%llx", mutex_addr);
 
-    SharedPtr<Mutex> mutex = g_object_address_table.Get<Mutex>(mutex_addr);
+    Mutex* mutex = g_object_address_table.GetBorrowed<Mutex>(mutex_addr);
     ASSERT(mutex);
 
     return mutex->Release(GetCurrentThread());
@@ -386,7 +391,7 @@ static ResultCode GetThreadContext(Handle handle, VAddr addr) {
 
 /// Gets the priority for the specified thread
 static ResultCode GetThreadPriority(u32* priority, Handle handle) {
-    const SharedPtr<Thread> thread = g_handle_table.Get<Thread>(handle);
+    const Thread* thread = g_handle_table.GetBorrowed<Thread>(handle);
     if (!thread)
         return ERR_INVALID_HANDLE;
 
@@ -400,7 +405,7 @@ static ResultCode SetThreadPriority(Handle handle, u32 priority) {
         return ERR_OUT_OF_RANGE;
     }
 
-    SharedPtr<Thread> thread = g_handle_table.Get<Thread>(handle);
+    Thread* thread = g_handle_table.GetBorrowed<Thread>(handle);
     if (!thread)
         return ERR_INVALID_HANDLE;
 
@@ -424,8 +429,10 @@ static ResultCode SetThreadPriority(Handle handle, u32 priority) {
 
 /// Get which CPU core is executing the current thread
 static u32 GetCurrentProcessorNumber() {
-    LOG_WARNING(Kernel_SVC, "(STUBBED) called, defaulting to processor 0");
-    return 0;
+    LOG_TRACE(Kernel_SVC, "called");
+    // All guest threads are executed by a single emulated core, so report the core the current
+    // thread would be running on if it was scheduled on its ideal core.
+    return static_cast<u32>(GetCurrentThread()->processor_id);
 }
 
 static ResultCode MapSharedMemory(Handle shared_memory_handle, VAddr addr, u64 size,
@@ -609,10 +616,29 @@ static void ExitThread() {
 static void SleepThread(s64 nanoseconds) {
     LOG_TRACE(Kernel_SVC, "called nanoseconds=%lld", nanoseconds);
 
-    // Don't attempt to yield execution if there are no available threads to run,
-    // this way we avoid a useless reschedule to the idle thread.
-    if (nanoseconds == 0 && !Core::System::GetInstance().Scheduler().HaveReadyThreads())
-        return;
+    // Zero and negative values yield execution instead of sleeping
+    if (nanoseconds <= 0) {
+        auto& scheduler = Core::System::GetInstance().Scheduler();
+
+        // Don't attempt to yield execution if there are no available threads to run,
+        // this way we avoid a useless reschedule to the idle thread. A thread yielding with
+        // nothing else to run is polling, and only a timing event can change what it observes,
+        // so skip the rest of the timeslice instead of spinning through it.
+        if (!scheduler.HaveReadyThreads()) {
+            CoreTiming::Idle();
+            return;
+        }
+
+        // Threads of the same priority take turns without going through a wakeup event
+        if (scheduler.YieldCurrentThread()) {
+            Core::System::GetInstance().PrepareReschedule();
+            return;
+        }
+
+        // Only threads of a lower priority are ready. On hardware they would keep running on
+        // the other cores, so sleep briefly to let them run rather than starving them.
+        nanoseconds = 0;
+    }
 
     // Sleep current thread and check for next thread to schedule
     WaitCurrentThread_Sleep();
@@ -755,7 +781,7 @@ static ResultCode CloseHandle(Handle handle) {
 /// Reset an event
 static ResultCode ResetSignal(Handle handle) {
     LOG_WARNING(Kernel_SVC, "(STUBBED) called handle 0x%08X", handle);
-    auto event = g_handle_table.Get<Event>(handle);
+    Event* event = g_handle_table.GetBorrowed<Event>(handle);
     ASSERT(event != nullptr);
     event->Clear();
     return RESULT_SUCCESS;
@@ -769,16 +795,49 @@ static ResultCode CreateTransferMemory(Handle* handle, VAddr addr, u64 size, u32
     return RESULT_SUCCESS;
 }
 
-static ResultCode GetThreadCoreMask(Handle handle, u32* mask, u64* unknown) {
-    LOG_WARNING(Kernel_SVC, "(STUBBED) called, handle=0x%08X", handle);
-    *mask = 0x0;
-    *unknown = 0xf;
+static ResultCode GetThreadCoreMask(Handle thread_handle, u32* core, u64* mask) {
+    LOG_TRACE(Kernel_SVC, "called, handle=0x%08X", thread_handle);
+
+    const Thread* thread = g_handle_table.GetBorrowed<Thread>(thread_handle);
+    if (!thread) {
+        return ERR_INVALID_HANDLE;
+    }
+
+    *core = static_cast<u32>(thread->processor_id);
+    *mask = thread->affinity_mask;
     return RESULT_SUCCESS;
 }
 
-static ResultCode SetThreadCoreMask(Handle handle, u32 mask, u64 unknown) {
-    LOG_WARNING(Kernel_SVC, "(STUBBED) called, handle=0x%08X, mask=0x%08X, unknown=0x%lx", handle,
-                mask, unknown);
+static ResultCode SetThreadCoreMask(Handle thread_handle, u32 core, u64 mask) {
+    LOG_TRACE(Kernel_SVC, "called, handle=0x%08X, core=0x%X, mask=0x%016" PRIX64, thread_handle,
+              core, mask);
+
+    Thread* thread = g_handle_table.GetBorrowed<Thread>(thread_handle);
+    if (!thread) {
+        return ERR_INVALID_HANDLE;
+    }
+
+    s32 ideal_core = static_cast<s32>(core);
+    if (ideal_core == THREADPROCESSORID_DEFAULT) {
+        ideal_core = thread->owner_process->ideal_processor;
+        mask = 1ULL << ideal_core;
+    } else if (ideal_core == THREADPROCESSORID_DONT_UPDATE) {
+        ideal_core = thread->processor_id;
+    }
+
+    if (mask == 0 || (mask & ~static_cast<u64>(THREADPROCESSORID_DEFAULT_MASK)) != 0) {
+        return ERR_INVALID_COMBINATION;
+    }
+
+    if (ideal_core < 0 || ideal_core >= THREADPROCESSORID_MAX ||
+        (mask & (1ULL << ideal_core)) == 0) {
+        return ERR_INVALID_COMBINATION;
+    }
+
+    // Note: The affinity is tracked so that guest queries observe it, but every thread is still
+    // executed by the single emulated core.
+    thread->processor_id = ideal_core;
+    thread->affinity_mask = mask;
     return RESULT_SUCCESS;
 }
 
@@ -798,7 +857,7 @@ static ResultCode CreateSharedMemory(Handle* handle, u64 size, u32 local_permiss
 static ResultCode ClearEvent(Handle handle) {
     LOG_TRACE(Kernel_SVC, "called, event=0xX", handle);
 
-    SharedPtr<Event> evt = g_handle_table.Get<Event>(handle);
+    Event* evt = g_handle_table.GetBorrowed<Event>(handle);
     if (evt == nullptr)
         return ERR_INVALID_HANDLE;
     evt->Clear();
@@ -807,7 +866,7 @@ static ResultCode ClearEvent(Handle handle) {
 
 namespace {
 struct FunctionDef {
-    using Func = void();
+    using Func = void(SvcContext&);
 
     u32 id;
     Func* func;
@@ -956,16 +1015,32 @@ static const FunctionDef* GetSVCInfo(u32 func_num) {
 
 MICROPROFILE_DEFINE(Kernel_SVC, "Kernel", "SVC", MP_RGB(70, 200, 70));
 
+#if MICROPROFILE_ENABLED
+/// Each SVC is timed on its own as well, which also shows how often it is called
+static const auto svc_profile_tokens = [] {
+    std::array<MicroProfileToken, std::size(SVC_Table)> tokens;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        tokens[i] = MicroProfileGetToken("SVC", SVC_Table[i].name, MP_RGB(70, 200, 70),
+                                         MicroProfileTokenTypeCpu);
+    }
+    return tokens;
+}();
+#endif
+
 void CallSVC(u32 immediate) {
     MICROPROFILE_SCOPE(Kernel_SVC);
-
-    // Lock the global kernel mutex when we enter the kernel HLE.
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
+    Core::PerfStats::SubsystemScope perf_scope(Core::System::GetInstance().perf_stats,
+                                               Core::PerfStats::Subsystem::HleServices);
 
     const FunctionDef* info = GetSVCInfo(immediate);
     if (info) {
         if (info->func) {
-            info->func();
+#if MICROPROFILE_ENABLED
+            MicroProfileScopeHandler svc_scope(svc_profile_tokens[immediate]);
+#endif
+            SvcContext context(Core::CPU());
+            info->func(context);
+            context.WriteBack(Core::CPU());
         } else {
             LOG_CRITICAL(Kernel_SVC, "unimplemented SVC function %s(..)", info->name);
         }
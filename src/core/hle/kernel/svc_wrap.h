@@ -13,142 +13,174 @@
 
 namespace Kernel {
 
-#define PARAM(n) Core::CPU().GetReg(n)
+/**
+ * Argument and result registers of an SVC. They are read from the CPU in one go before the SVC is
+ * called, and only the ones the SVC set are written back after it returns.
+ */
+class SvcContext {
+public:
+    explicit SvcContext(const ARM_Interface& cpu) {
+        cpu.GetSvcRegisters(regs);
+    }
+
+    u64 Get(size_t index) const {
+        return regs[index];
+    }
+
+    void Set(size_t index, u64 value) {
+        regs[index] = value;
+        written |= 1U << index;
+    }
+
+    void WriteBack(ARM_Interface& cpu) const {
+        if (written != 0) {
+            cpu.SetSvcRegisters(regs, written);
+        }
+    }
+
+private:
+    ARM_Interface::SvcRegisters regs;
+    u32 written = 0;
+};
+
+#define PARAM(n) context.Get(n)
 
 /**
  * HLE a function return from the current ARM userland process
  * @param res Result to return
  */
-static inline void FuncReturn(u64 res) {
-    Core::CPU().SetReg(0, res);
+static inline void FuncReturn(SvcContext& context, u64 res) {
+    context.Set(0, res);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Function wrappers that return type ResultCode
 
 template <ResultCode func(u64)>
-void SvcWrap() {
-    FuncReturn(func(PARAM(0)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func(PARAM(0)).raw);
 }
 
 template <ResultCode func(u32)>
-void SvcWrap() {
-    FuncReturn(func((u32)PARAM(0)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)PARAM(0)).raw);
 }
 
 template <ResultCode func(u32, u32)>
-void SvcWrap() {
-    FuncReturn(func((u32)PARAM(0), (u32)PARAM(1)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)PARAM(0), (u32)PARAM(1)).raw);
 }
 
 template <ResultCode func(u32*, u32)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u32 retval = func(&param_1, (u32)PARAM(1)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(u32*, u64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(u64, s32)>
-void SvcWrap() {
-    FuncReturn(func(PARAM(0), (s32)PARAM(1)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func(PARAM(0), (s32)PARAM(1)).raw);
 }
 
 template <ResultCode func(u64*, u64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u64 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(u32, u64)>
-void SvcWrap() {
-    FuncReturn(func((u32)(PARAM(0) & 0xFFFFFFFF), PARAM(1)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)(PARAM(0) & 0xFFFFFFFF), PARAM(1)).raw);
 }
 
 template <ResultCode func(u32, u32, u64)>
-void SvcWrap() {
-    FuncReturn(func((u32)(PARAM(0) & 0xFFFFFFFF), (u32)(PARAM(1) & 0xFFFFFFFF), PARAM(2)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context,
+               func((u32)(PARAM(0) & 0xFFFFFFFF), (u32)(PARAM(1) & 0xFFFFFFFF), PARAM(2)).raw);
 }
 
 template <ResultCode func(u32, u32*, u64*)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u64 param_2 = 0;
     ResultCode retval = func((u32)(PARAM(2) & 0xFFFFFFFF), &param_1, &param_2);
-    Core::CPU().SetReg(1, param_1);
-    Core::CPU().SetReg(2, param_2);
-    FuncReturn(retval.raw);
+    context.Set(1, param_1);
+    context.Set(2, param_2);
+    FuncReturn(context, retval.raw);
 }
 
 template <ResultCode func(u64, u64, u32, u32)>
-void SvcWrap() {
-    FuncReturn(
-        func(PARAM(0), PARAM(1), (u32)(PARAM(3) & 0xFFFFFFFF), (u32)(PARAM(3) & 0xFFFFFFFF)).raw);
+void SvcWrap(SvcContext& context) {
+    const ResultCode retval =
+        func(PARAM(0), PARAM(1), (u32)(PARAM(3) & 0xFFFFFFFF), (u32)(PARAM(3) & 0xFFFFFFFF));
+    FuncReturn(context, retval.raw);
 }
 
 template <ResultCode func(u32, u64, u32)>
-void SvcWrap() {
-    FuncReturn(func((u32)PARAM(0), PARAM(1), (u32)PARAM(2)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)PARAM(0), PARAM(1), (u32)PARAM(2)).raw);
 }
 
 template <ResultCode func(u64, u64, u64)>
-void SvcWrap() {
-    FuncReturn(func(PARAM(0), PARAM(1), PARAM(2)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func(PARAM(0), PARAM(1), PARAM(2)).raw);
 }
 
 template <ResultCode func(u32, u64, u64, u32)>
-void SvcWrap() {
-    FuncReturn(func((u32)PARAM(0), PARAM(1), PARAM(2), (u32)PARAM(3)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)PARAM(0), PARAM(1), PARAM(2), (u32)PARAM(3)).raw);
 }
 
 template <ResultCode func(u32, u64, u64)>
-void SvcWrap() {
-    FuncReturn(func((u32)PARAM(0), PARAM(1), PARAM(2)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func((u32)PARAM(0), PARAM(1), PARAM(2)).raw);
 }
 
 template <ResultCode func(u32*, u64, u64, s64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     ResultCode retval = func(&param_1, PARAM(1), (u32)(PARAM(2) & 0xFFFFFFFF), (s64)PARAM(3));
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval.raw);
+    context.Set(1, param_1);
+    FuncReturn(context, retval.raw);
 }
 
 template <ResultCode func(u64, u64, u32, s64)>
-void SvcWrap() {
-    FuncReturn(func(PARAM(0), PARAM(1), (u32)PARAM(2), (s64)PARAM(3)).raw);
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func(PARAM(0), PARAM(1), (u32)PARAM(2), (s64)PARAM(3)).raw);
 }
 
 template <ResultCode func(u64*, u64, u64, u64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u64 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1), PARAM(2), PARAM(3)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(u32*, u64, u64, u64, u32, s32)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u32 retval =
         func(&param_1, PARAM(1), PARAM(2), PARAM(3), (u32)PARAM(4), (s32)(PARAM(5) & 0xFFFFFFFF))
             .raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(MemoryInfo*, PageInfo*, u64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     MemoryInfo memory_info = {};
     PageInfo page_info = {};
     u32 retval = func(&memory_info, &page_info, PARAM(2)).raw;
@@ -159,66 +191,65 @@ void SvcWrap() {
     Memory::Write32(PARAM(0) + 20, memory_info.attributes);
     Memory::Write32(PARAM(0) + 24, memory_info.permission);
 
-    FuncReturn(retval);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(u32*, u64, u64, u32)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u32 retval = func(&param_1, PARAM(1), PARAM(2), (u32)(PARAM(3) & 0xFFFFFFFF)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 template <ResultCode func(Handle*, u64, u32, u32)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     u32 param_1 = 0;
     u32 retval =
         func(&param_1, PARAM(1), (u32)(PARAM(2) & 0xFFFFFFFF), (u32)(PARAM(3) & 0xFFFFFFFF)).raw;
-    Core::CPU().SetReg(1, param_1);
-    FuncReturn(retval);
+    context.Set(1, param_1);
+    FuncReturn(context, retval);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Function wrappers that return type u32
 
 template <u32 func()>
-void SvcWrap() {
-    FuncReturn(func());
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // Function wrappers that return type u64
 
 template <u64 func()>
-void SvcWrap() {
-    FuncReturn(func());
+void SvcWrap(SvcContext& context) {
+    FuncReturn(context, func());
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 /// Function wrappers that return type void
 
 template <void func()>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     func();
 }
 
 template <void func(s64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     func((s64)PARAM(0));
 }
 
 template <void func(u64, s32 len)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     func(PARAM(0), (s32)(PARAM(1) & 0xFFFFFFFF));
 }
 
 template <void func(u64, u64, u64)>
-void SvcWrap() {
+void SvcWrap(SvcContext& context) {
     func(PARAM(0), PARAM(1), PARAM(2));
 }
 
 #undef PARAM
-#undef FuncReturn
 
 } // namespace Kernel
@@ -57,7 +57,7 @@ Thread::~Thread() {}
 
 void Thread::Stop() {
     // Cancel any outstanding wakeup events for this thread
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::UnscheduleEvent(wakeup_event);
     wakeup_callback_handle_table.Close(callback_handle);
     callback_handle = 0;
 
@@ -84,7 +84,7 @@ void Thread::Stop() {
     u64 tls_page = (tls_address - Memory::TLS_AREA_VADDR) / Memory::PAGE_SIZE;
     u64 tls_slot =
         ((tls_address - Memory::TLS_AREA_VADDR) % Memory::PAGE_SIZE) / Memory::TLS_ENTRY_SIZE;
-    Core::CurrentProcess()->tls_slots[tls_page].reset(tls_slot);
+    owner_process->tls_slots[tls_page].reset(tls_slot);
 }
 
 void WaitCurrentThread_Sleep() {
@@ -135,11 +135,14 @@ void Thread::WakeAfterDelay(s64 nanoseconds) {
     if (nanoseconds == -1)
         return;
 
-    CoreTiming::ScheduleEvent(nsToCycles(nanoseconds), ThreadWakeupEventType, callback_handle);
+    // Only the latest wakeup is tracked, so drop any earlier one
+    CoreTiming::UnscheduleEvent(wakeup_event);
+    wakeup_event =
+        CoreTiming::ScheduleEvent(nsToCycles(nanoseconds), ThreadWakeupEventType, callback_handle);
 }
 
 void Thread::CancelWakeupTimer() {
-    CoreTiming::UnscheduleEvent(ThreadWakeupEventType, callback_handle);
+    CoreTiming::UnscheduleEvent(wakeup_event);
 }
 
 void Thread::ResumeFromWait() {
@@ -246,8 +249,6 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
 
     SharedPtr<Thread> thread(new Thread);
 
-    Core::System::GetInstance().Scheduler().AddThread(thread, priority);
-
     thread->thread_id = NewThreadId();
     thread->status = THREADSTATUS_DORMANT;
     thread->entry_point = entry_point;
@@ -255,10 +256,11 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     thread->nominal_priority = thread->current_priority = priority;
     thread->last_running_ticks = CoreTiming::GetTicks();
     thread->processor_id = processor_id;
+    thread->affinity_mask = processor_id >= 0 ? (1ULL << processor_id)
+                                              : static_cast<u64>(THREADPROCESSORID_DEFAULT_MASK);
     thread->wait_objects.clear();
     thread->wait_address = 0;
     thread->name = std::move(name);
-    thread->callback_handle = wakeup_callback_handle_table.Create(thread).Unwrap();
     thread->owner_process = owner_process;
 
     // Find the next available TLS index, and mark it as used
@@ -307,6 +309,17 @@ ResultVal<SharedPtr<Thread>> Thread::Create(std::string name, VAddr entry_point,
     thread->tls_address = Memory::TLS_AREA_VADDR + available_page * Memory::PAGE_SIZE +
                           available_slot * Memory::TLS_ENTRY_SIZE;
 
+    // Slots are handed out again once their thread stops, so clear what the previous thread left
+    // behind. Newly allocated pages are already zeroed.
+    if (!needs_allocation) {
+        Memory::ZeroBlock(*owner_process, thread->tls_address, Memory::TLS_ENTRY_SIZE);
+    }
+
+    // Only make the thread known once nothing can fail anymore, so that an error above doesn't
+    // leave it behind in the scheduler or the wakeup handle table.
+    thread->callback_handle = wakeup_callback_handle_table.Create(thread).Unwrap();
+    Core::System::GetInstance().Scheduler().AddThread(thread, priority);
+
     // TODO(peachum): move to ScheduleThread() when scheduler is added so selected core is used
     // to initialize the context
     ResetThreadContext(thread->context, stack_top, entry_point, arg);
@@ -319,6 +332,7 @@ void Thread::SetPriority(u32 priority) {
                "Invalid priority value.");
     Core::System::GetInstance().Scheduler().SetThreadPriority(this, priority);
     nominal_priority = current_priority = priority;
+    UpdateWaitingPosition();
 }
 
 void Thread::UpdatePriority() {
@@ -333,6 +347,13 @@ void Thread::UpdatePriority() {
 void Thread::BoostPriority(u32 priority) {
     Core::System::GetInstance().Scheduler().SetThreadPriority(this, priority);
     current_priority = priority;
+    UpdateWaitingPosition();
+}
+
+void Thread::UpdateWaitingPosition() {
+    for (auto& object : wait_objects) {
+        object->UpdateWaitingThreadPriority(this);
+    }
 }
 
 SharedPtr<Thread> SetupMainThread(VAddr entry_point, u32 priority,
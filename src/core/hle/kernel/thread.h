@@ -11,6 +11,7 @@
 #include <boost/container/flat_set.hpp>
 #include "common/common_types.h"
 #include "core/arm/arm_interface.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/wait_object.h"
 #include "core/hle/result.h"
@@ -23,12 +24,13 @@ enum ThreadPriority : u32 {
 };
 
 enum ThreadProcessorId : s32 {
-    THREADPROCESSORID_DEFAULT = -2, ///< Run thread on default core specified by exheader
-    THREADPROCESSORID_0 = 0,        ///< Run thread on core 0
-    THREADPROCESSORID_1 = 1,        ///< Run thread on core 1
-    THREADPROCESSORID_2 = 2,        ///< Run thread on core 2
-    THREADPROCESSORID_3 = 3,        ///< Run thread on core 3
-    THREADPROCESSORID_MAX = 4,      ///< Processor ID must be less than this
+    THREADPROCESSORID_DONT_UPDATE = -3, ///< Keep the current ideal core when changing masks
+    THREADPROCESSORID_DEFAULT = -2,     ///< Run thread on default core specified by exheader
+    THREADPROCESSORID_0 = 0,            ///< Run thread on core 0
+    THREADPROCESSORID_1 = 1,            ///< Run thread on core 1
+    THREADPROCESSORID_2 = 2,            ///< Run thread on core 2
+    THREADPROCESSORID_3 = 3,            ///< Run thread on core 3
+    THREADPROCESSORID_MAX = 4,          ///< Processor ID must be less than this
 
     /// Allowed CPU mask
     THREADPROCESSORID_DEFAULT_MASK = (1 << THREADPROCESSORID_0) | (1 << THREADPROCESSORID_1) |
@@ -201,7 +203,9 @@ public:
 
     u64 last_running_ticks; ///< CPU tick when thread was last running
 
-    s32 processor_id;
+    s32 processor_id; ///< Ideal core of the thread
+
+    u64 affinity_mask; ///< Mask of the cores the thread is allowed to run on
 
     VAddr tls_address; ///< Virtual address of the Thread Local Storage of the thread
 
@@ -226,6 +230,8 @@ public:
 
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
+    /// The pending wakeup event, if any
+    CoreTiming::EventHandle wakeup_event;
 
     using WakeupCallback = bool(ThreadWakeupReason reason, SharedPtr<Thread> thread,
                                 SharedPtr<WaitObject> object, size_t index);
@@ -237,6 +243,9 @@ public:
 private:
     Thread();
     ~Thread() override;
+
+    /// Keeps the waiting lists of the objects this thread waits on sorted after a priority change
+    void UpdateWaitingPosition();
 };
 
 /**
@@ -57,12 +57,13 @@ void Timer::Set(s64 initial, s64 interval) {
         // Immediately invoke the callback
         Signal(0);
     } else {
-        CoreTiming::ScheduleEvent(nsToCycles(initial), timer_callback_event_type, callback_handle);
+        callback_event = CoreTiming::ScheduleEvent(nsToCycles(initial), timer_callback_event_type,
+                                                   callback_handle);
     }
 }
 
 void Timer::Cancel() {
-    CoreTiming::UnscheduleEvent(timer_callback_event_type, callback_handle);
+    CoreTiming::UnscheduleEvent(callback_event);
 }
 
 void Timer::Clear() {
@@ -86,8 +87,8 @@ void Timer::Signal(int cycles_late) {
 
     if (interval_delay != 0) {
         // Reschedule the timer with the interval delay
-        CoreTiming::ScheduleEvent(nsToCycles(interval_delay) - cycles_late,
-                                  timer_callback_event_type, callback_handle);
+        callback_event = CoreTiming::ScheduleEvent(nsToCycles(interval_delay) - cycles_late,
+                                                   timer_callback_event_type, callback_handle);
     }
 }
 
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "common/common_types.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/wait_object.h"
 
@@ -69,6 +70,8 @@ private:
 
     /// Handle used as userdata to reference this object when inserting into the CoreTiming queue.
     Handle callback_handle;
+    /// The pending callback event, if any
+    CoreTiming::EventHandle callback_event;
 };
 
 /// Initializes the required variables for timers
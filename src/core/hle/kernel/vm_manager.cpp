@@ -4,8 +4,10 @@
 
 #include <cinttypes>
 #include <iterator>
+#include <unordered_set>
 #include "common/assert.h"
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/hle/kernel/errors.h"
@@ -16,6 +18,8 @@
 
 namespace Kernel {
 
+static Common::MemoryUsageCounter guest_memory_usage("Guest memory");
+
 static const char* GetMemoryStateName(MemoryState state) {
     static const char* names[] = {
         "Unmapped",
@@ -72,25 +76,44 @@ VMManager::~VMManager() {
 
 void VMManager::Reset() {
     vma_map.clear();
+    last_found_vma = vma_map.end();
 
     // Initialize the map with a single free region covering the entire managed space.
     VirtualMemoryArea initial_vma;
     initial_vma.size = MAX_ADDRESS;
     vma_map.emplace(initial_vma.base, initial_vma);
 
-    page_table.pointers.fill(nullptr);
+    page_table.pointers.Clear();
     page_table.special_regions.clear();
-    page_table.attributes.fill(Memory::PageType::Unmapped);
+    page_table.special_region_index.Clear();
+    page_table.attributes.Clear();
+
+    // The page table now reads as entirely unmapped, so only the rasterizer needs to be told about
+    // the change. Walking the whole table here would commit host memory for every entry.
+    Memory::RasterizerFlushVirtualRegion(initial_vma.base, initial_vma.size,
+                                         Memory::FlushMode::FlushAndInvalidate);
 
-    UpdatePageTableForVMA(initial_vma);
+    if (Core::System::GetInstance().IsPoweredOn()) {
+        Core::CPU().PageTableReset(&page_table);
+    }
+
+    UpdateMemoryUsage();
 }
 
 VMManager::VMAHandle VMManager::FindVMA(VAddr target) const {
     if (target >= MAX_ADDRESS) {
         return vma_map.end();
-    } else {
-        return std::prev(vma_map.upper_bound(target));
     }
+
+    if (last_found_vma != vma_map.end()) {
+        const VirtualMemoryArea& vma = last_found_vma->second;
+        if (target >= vma.base && target - vma.base < vma.size) {
+            return last_found_vma;
+        }
+    }
+
+    last_found_vma = std::prev(vma_map.upper_bound(target));
+    return last_found_vma;
 }
 
 ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
@@ -114,6 +137,7 @@ ResultVal<VMManager::VMAHandle> VMManager::MapMemoryBlock(VAddr target,
     final_vma.backing_block = block;
     final_vma.offset = offset;
     UpdatePageTableForVMA(final_vma);
+    UpdateMemoryUsage();
 
     return MakeResult<VMAHandle>(MergeAdjacent(vma_handle));
 }
@@ -186,6 +210,7 @@ ResultCode VMManager::UnmapRange(VAddr target, u64 size) {
     ASSERT(FindVMA(target)->second.size >= size);
 
     Core::CPU().UnmapMemory(target, size);
+    UpdateMemoryUsage();
 
     return RESULT_SUCCESS;
 }
@@ -223,6 +248,7 @@ void VMManager::RefreshMemoryBlockMappings(const std::vector<u8>* block) {
             UpdatePageTableForVMA(vma);
         }
     }
+    UpdateMemoryUsage();
 }
 
 void VMManager::LogLayout(Log::Level log_level) const {
@@ -345,6 +371,9 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
     VMAIter next_vma = std::next(iter);
     if (next_vma != vma_map.end() && iter->second.CanBeMergedWith(next_vma->second)) {
         iter->second.size += next_vma->second.size;
+        if (last_found_vma == next_vma) {
+            last_found_vma = vma_map.end();
+        }
         vma_map.erase(next_vma);
     }
 
@@ -352,6 +381,9 @@ VMManager::VMAIter VMManager::MergeAdjacent(VMAIter iter) {
         VMAIter prev_vma = std::prev(iter);
         if (prev_vma->second.CanBeMergedWith(iter->second)) {
             prev_vma->second.size += iter->second.size;
+            if (last_found_vma == iter) {
+                last_found_vma = vma_map.end();
+            }
             vma_map.erase(iter);
             iter = prev_vma;
         }
@@ -376,6 +408,12 @@ void VMManager::UpdatePageTableForVMA(const VirtualMemoryArea& vma) {
         Memory::MapIoRegion(page_table, vma.base, vma.size, vma.mmio_handler);
         break;
     }
+
+    // Code translated from this range may no longer match what is mapped there, or may not be
+    // executable anymore. Only the affected blocks need to be retranslated.
+    if (Core::System::GetInstance().IsPoweredOn()) {
+        Core::CPU().InvalidateCacheRange(&page_table, vma.base, vma.size);
+    }
 }
 
 u64 VMManager::GetTotalMemoryUsage() {
@@ -383,6 +421,29 @@ u64 VMManager::GetTotalMemoryUsage() {
     return 0xF8000000;
 }
 
+u64 VMManager::GetBackingMemorySize() const {
+    // A block is shared by several VMAs once its mapping is split or mapped again elsewhere
+    std::unordered_set<const std::vector<u8>*> blocks;
+    u64 size = 0;
+    for (const auto& p : vma_map) {
+        const VirtualMemoryArea& vma = p.second;
+        if (vma.type != VMAType::AllocatedMemoryBlock) {
+            continue;
+        }
+        if (blocks.insert(vma.backing_block.get()).second) {
+            size += vma.backing_block->size();
+        }
+    }
+    return size;
+}
+
+void VMManager::UpdateMemoryUsage() {
+    const u64 backing_size = GetBackingMemorySize();
+    guest_memory_usage.Add(backing_size);
+    guest_memory_usage.Subtract(reported_backing_size);
+    reported_backing_size = backing_size;
+}
+
 u64 VMManager::GetTotalHeapUsage() {
     LOG_WARNING(Kernel, "(STUBBED) called");
     return 0x0;
@@ -192,6 +192,9 @@ public:
     /// Gets the total memory usage, used by svcGetInfo
     u64 GetTotalMemoryUsage();
 
+    /// Gets the size of the host memory blocks backing mapped memory, counting each block once
+    u64 GetBackingMemorySize() const;
+
     /// Gets the total heap usage, used by svcGetInfo
     u64 GetTotalHeapUsage();
 
@@ -240,5 +243,18 @@ private:
 
     /// Updates the pages corresponding to this VMA so they match the VMA's attributes.
     void UpdatePageTableForVMA(const VirtualMemoryArea& vma);
+
+    /// Updates the guest memory counter of the memory usage statistics after a mapping change.
+    void UpdateMemoryUsage();
+
+    /// Backing memory size this VMManager last added to the memory usage statistics
+    u64 reported_backing_size = 0;
+
+    /**
+     * The VMA returned by the last call to FindVMA, or `vma_map.end()`. Lookups usually hit the
+     * same VMA repeatedly, so it is checked before searching the map. It must be reset whenever
+     * the VMA it refers to is erased.
+     */
+    mutable VMAHandle last_found_vma = vma_map.end();
 };
 } // namespace Kernel
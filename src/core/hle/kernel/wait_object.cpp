@@ -17,10 +17,22 @@
 
 namespace Kernel {
 
+/// Returns the position a thread of the given priority is inserted at, after all threads with the
+/// same or a better priority so that threads of equal priority are woken up in FIFO order.
+static auto FindInsertionPoint(std::vector<SharedPtr<Thread>>& waiting_threads, u32 priority) {
+    return std::upper_bound(waiting_threads.begin(), waiting_threads.end(), priority,
+                            [](u32 value, const SharedPtr<Thread>& thread) {
+                                return value < thread->current_priority;
+                            });
+}
+
 void WaitObject::AddWaitingThread(SharedPtr<Thread> thread) {
     auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
-    if (itr == waiting_threads.end())
-        waiting_threads.push_back(std::move(thread));
+    if (itr != waiting_threads.end())
+        return;
+
+    const u32 priority = thread->current_priority;
+    waiting_threads.insert(FindInsertionPoint(waiting_threads, priority), std::move(thread));
 }
 
 void WaitObject::RemoveWaitingThread(Thread* thread) {
@@ -32,10 +44,21 @@ void WaitObject::RemoveWaitingThread(Thread* thread) {
         waiting_threads.erase(itr);
 }
 
-SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
-    Thread* candidate = nullptr;
-    u32 candidate_priority = THREADPRIO_LOWEST + 1;
+void WaitObject::UpdateWaitingThreadPriority(Thread* thread) {
+    auto itr = std::find(waiting_threads.begin(), waiting_threads.end(), thread);
+    if (itr == waiting_threads.end())
+        return;
+
+    SharedPtr<Thread> waiting_thread = std::move(*itr);
+    waiting_threads.erase(itr);
+
+    const u32 priority = waiting_thread->current_priority;
+    waiting_threads.insert(FindInsertionPoint(waiting_threads, priority),
+                           std::move(waiting_thread));
+}
 
+SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
+    // The waiting threads are sorted by priority, so the first one that is ready to run wins.
     for (const auto& thread : waiting_threads) {
         // The list of waiting threads must not contain threads that are not waiting to be awakened.
         ASSERT_MSG(thread->status == THREADSTATUS_WAIT_SYNCH_ANY ||
@@ -43,9 +66,6 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
                        thread->status == THREADSTATUS_WAIT_HLE_EVENT,
                    "Inconsistent thread statuses in waiting_threads");
 
-        if (thread->current_priority >= candidate_priority)
-            continue;
-
         if (ShouldWait(thread.get()))
             continue;
 
@@ -59,13 +79,11 @@ SharedPtr<Thread> WaitObject::GetHighestPriorityReadyThread() {
                                         });
         }
 
-        if (ready_to_run) {
-            candidate = thread.get();
-            candidate_priority = thread->current_priority;
-        }
+        if (ready_to_run)
+            return thread;
     }
 
-    return candidate;
+    return nullptr;
 }
 
 void WaitObject::WakeupWaitingThread(SharedPtr<Thread> thread) {
@@ -38,6 +38,13 @@ public:
      */
     virtual void RemoveWaitingThread(Thread* thread);
 
+    /**
+     * Moves a waiting thread to the position matching its current priority. Must be called
+     * whenever the priority of a thread waiting on this object changes.
+     * @param thread Pointer to thread whose priority changed
+     */
+    void UpdateWaitingThreadPriority(Thread* thread);
+
     /**
      * Wake up all threads waiting on this object that can be awoken, in priority order,
      * and set the synchronization result and output of the thread.
@@ -53,11 +60,11 @@ public:
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
     SharedPtr<Thread> GetHighestPriorityReadyThread();
 
-    /// Get a const reference to the waiting threads list for debug use
+    /// Get a const reference to the waiting threads list, sorted by priority
     const std::vector<SharedPtr<Thread>>& GetWaitingThreads() const;
 
 private:
-    /// Threads waiting for this object to become available
+    /// Threads waiting for this object to become available, sorted by priority
     std::vector<SharedPtr<Thread>> waiting_threads;
 };
 
@@ -70,4 +77,12 @@ inline SharedPtr<WaitObject> DynamicObjectCast<WaitObject>(SharedPtr<Object> obj
     return nullptr;
 }
 
+template <>
+inline WaitObject* DynamicObjectCast<WaitObject>(Object* object) {
+    if (object != nullptr && object->IsWaitable()) {
+        return static_cast<WaitObject*>(object);
+    }
+    return nullptr;
+}
+
 } // namespace Kernel
@@ -2,13 +2,19 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
+#include <cstring>
+#include <memory>
 #include <vector>
+#include "audio_core/sink_details.h"
+#include "audio_core/stream.h"
 #include "common/logging/log.h"
 #include "core/core_timing.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/service/audio/audout_u.h"
+#include "core/settings.h"
 
 namespace Service::Audio {
 
@@ -17,12 +23,12 @@ constexpr u32 sample_rate{48000};
 /// TODO(st4rk): dynamic number of channels, as I think Switch has support
 /// to more audio channels (probably when Docked I guess)
 constexpr u32 audio_channels{2};
-/// TODO(st4rk): find a proper value for the audio_ticks
-constexpr u64 audio_ticks{static_cast<u64>(BASE_CLOCK_RATE / 500)};
+/// How often the stream moves frames into the sink and releases the buffers the host played
+constexpr u64 audio_ticks{static_cast<u64>(BASE_CLOCK_RATE / 200)};
 
 class IAudioOut final : public ServiceFramework<IAudioOut> {
 public:
-    IAudioOut() : ServiceFramework("IAudioOut"), audio_out_state(AudioState::Stopped) {
+    IAudioOut() : ServiceFramework("IAudioOut") {
         static const FunctionInfo functions[] = {
             {0, &IAudioOut::GetAudioOutState, "GetAudioOutState"},
             {1, &IAudioOut::StartAudioOut, "StartAudioOut"},
@@ -30,11 +36,11 @@ public:
             {3, &IAudioOut::AppendAudioOutBuffer, "AppendAudioOutBuffer"},
             {4, &IAudioOut::RegisterBufferEvent, "RegisterBufferEvent"},
             {5, &IAudioOut::GetReleasedAudioOutBuffer, "GetReleasedAudioOutBuffer"},
-            {6, nullptr, "ContainsAudioOutBuffer"},
-            {7, nullptr, "AppendAudioOutBufferAuto"},
-            {8, nullptr, "GetReleasedAudioOutBufferAuto"},
-            {9, nullptr, "GetAudioOutBufferCount"},
-            {10, nullptr, "GetAudioOutPlayedSampleCount"},
+            {6, &IAudioOut::ContainsAudioOutBuffer, "ContainsAudioOutBuffer"},
+            {7, &IAudioOut::AppendAudioOutBuffer, "AppendAudioOutBufferAuto"},
+            {8, &IAudioOut::GetReleasedAudioOutBuffer, "GetReleasedAudioOutBufferAuto"},
+            {9, &IAudioOut::GetAudioOutBufferCount, "GetAudioOutBufferCount"},
+            {10, &IAudioOut::GetAudioOutPlayedSampleCount, "GetAudioOutPlayedSampleCount"},
             {11, nullptr, "FlushAudioOutBuffers"},
         };
         RegisterHandlers(functions);
@@ -43,10 +49,15 @@ public:
         buffer_event =
             Kernel::Event::Create(Kernel::ResetType::OneShot, "IAudioOutBufferReleasedEvent");
 
+        const auto& sink_details = AudioCore::GetSinkDetails(Settings::values.sink_id);
+        stream = std::make_unique<AudioCore::Stream>(
+            sink_details.factory(sample_rate, Settings::values.audio_device_id),
+            Settings::values.enable_audio_stretching, [this] { buffer_event->Signal(); });
+
         // Register event callback to update the Audio Buffer
         audio_event = CoreTiming::RegisterEvent(
             "IAudioOut::UpdateAudioBuffersCallback", [this](u64 userdata, int cycles_late) {
-                UpdateAudioBuffersCallback();
+                stream->Update();
                 CoreTiming::ScheduleEvent(audio_ticks - cycles_late, audio_event);
             });
 
@@ -59,37 +70,42 @@ public:
     }
 
 private:
+    struct AudioOutBuffer {
+        u64_le next;
+        u64_le buffer;
+        u64_le buffer_capacity;
+        u64_le buffer_size;
+        u64_le offset;
+    };
+    static_assert(sizeof(AudioOutBuffer) == 0x28, "AudioOutBuffer is an invalid size");
+
     void GetAudioOutState(Kernel::HLERequestContext& ctx) {
         LOG_DEBUG(Service_Audio, "called");
         IPC::ResponseBuilder rb{ctx, 3};
         rb.Push(RESULT_SUCCESS);
-        rb.Push(static_cast<u32>(audio_out_state));
+        rb.Push(static_cast<u32>(stream->IsPlaying() ? AudioState::Started : AudioState::Stopped));
     }
 
     void StartAudioOut(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_Audio, "(STUBBED) called");
+        LOG_DEBUG(Service_Audio, "called");
 
-        // Start audio
-        audio_out_state = AudioState::Started;
+        stream->Play();
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
     }
 
     void StopAudioOut(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_Audio, "(STUBBED) called");
-
-        // Stop audio
-        audio_out_state = AudioState::Stopped;
+        LOG_DEBUG(Service_Audio, "called");
 
-        queue_keys.clear();
+        stream->Stop();
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
     }
 
     void RegisterBufferEvent(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_Audio, "(STUBBED) called");
+        LOG_DEBUG(Service_Audio, "called");
 
         IPC::ResponseBuilder rb{ctx, 2, 1};
         rb.Push(RESULT_SUCCESS);
@@ -97,49 +113,65 @@ private:
     }
 
     void AppendAudioOutBuffer(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_Audio, "(STUBBED) called");
         IPC::RequestParser rp{ctx};
+        const u64 tag{rp.Pop<u64>()};
+
+        // A buffer without a description is still queued, with no frames, so that it can be
+        // released to the application like the others.
+        AudioOutBuffer buffer{};
+        const bool has_description{!ctx.BufferDescriptorA().empty() ||
+                                   !ctx.BufferDescriptorX().empty()};
+        if (has_description && ctx.GetReadBufferSize() >= sizeof(buffer)) {
+            std::memcpy(&buffer, ctx.GetReadBufferPointer(), sizeof(buffer));
+        } else {
+            LOG_WARNING(Service_Audio, "Buffer 0x%016" PRIX64 " has no description", tag);
+        }
+        LOG_DEBUG(Service_Audio,
+                  "called, tag=0x%016" PRIX64 ", buffer=0x%016" PRIX64 ", size=0x%" PRIX64, tag,
+                  buffer.buffer, buffer.buffer_size);
 
-        const u64 key{rp.Pop<u64>()};
-        queue_keys.insert(queue_keys.begin(), key);
+        stream->AppendBuffer(tag, buffer.buffer, buffer.buffer_size);
 
         IPC::ResponseBuilder rb{ctx, 2};
         rb.Push(RESULT_SUCCESS);
     }
 
     void GetReleasedAudioOutBuffer(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_Audio, "(STUBBED) called");
+        LOG_DEBUG(Service_Audio, "called");
 
-        // TODO(st4rk): This is how libtransistor currently implements the
-        // GetReleasedAudioOutBuffer, it should return the key (a VAddr) to the app and this address
-        // is used to know which buffer should be filled with data and send again to the service
-        // through AppendAudioOutBuffer. Check if this is the proper way to do it.
-        u64 key{0};
+        const size_t max_count = ctx.GetWriteBufferSize() / sizeof(u64);
+        const std::vector<u64> tags = stream->PopReleasedBuffers(max_count);
+        ctx.WriteBuffer(tags.data(), tags.size() * sizeof(u64));
 
-        if (queue_keys.size()) {
-            key = queue_keys.back();
-            queue_keys.pop_back();
-        }
+        IPC::ResponseBuilder rb{ctx, 3};
+        rb.Push(RESULT_SUCCESS);
+        rb.Push<u32>(static_cast<u32>(tags.size()));
+    }
 
-        ctx.WriteBuffer(&key, sizeof(u64));
+    void ContainsAudioOutBuffer(Kernel::HLERequestContext& ctx) {
+        IPC::RequestParser rp{ctx};
+        const u64 tag{rp.Pop<u64>()};
+        LOG_DEBUG(Service_Audio, "called, tag=0x%016" PRIX64, tag);
 
         IPC::ResponseBuilder rb{ctx, 3};
         rb.Push(RESULT_SUCCESS);
-        // TODO(st4rk): This might be the total of released buffers, needs to be verified on
-        // hardware
-        rb.Push<u32>(static_cast<u32>(queue_keys.size()));
+        rb.Push<u32>(stream->ContainsBuffer(tag));
     }
 
-    void UpdateAudioBuffersCallback() {
-        if (audio_out_state != AudioState::Started) {
-            return;
-        }
+    void GetAudioOutBufferCount(Kernel::HLERequestContext& ctx) {
+        LOG_DEBUG(Service_Audio, "called");
 
-        if (queue_keys.empty()) {
-            return;
-        }
+        IPC::ResponseBuilder rb{ctx, 3};
+        rb.Push(RESULT_SUCCESS);
+        rb.Push<u32>(static_cast<u32>(stream->GetQueueSize()));
+    }
+
+    void GetAudioOutPlayedSampleCount(Kernel::HLERequestContext& ctx) {
+        LOG_DEBUG(Service_Audio, "called");
 
-        buffer_event->Signal();
+        IPC::ResponseBuilder rb{ctx, 4};
+        rb.Push(RESULT_SUCCESS);
+        rb.Push<u64>(stream->GetPlayedSampleCount());
     }
 
     enum class AudioState : u32 {
@@ -147,20 +179,14 @@ private:
         Stopped,
     };
 
-    /// This is used to trigger the audio event callback that is going to read the samples from the
-    /// audio_buffer list and enqueue the samples using the sink (audio_core).
+    /// This is used to trigger the audio event callback that moves the frames of the queued
+    /// buffers into the sink and releases the ones that were played.
     CoreTiming::EventType* audio_event;
 
     /// This is the evend handle used to check if the audio buffer was released
     Kernel::SharedPtr<Kernel::Event> buffer_event;
 
-    /// (st4rk): This is just a temporary workaround for the future implementation. Libtransistor
-    /// uses the key as an address in the App, so we need to return when the
-    /// GetReleasedAudioOutBuffer_1 is called, otherwise we'll run in problems, because
-    /// libtransistor uses the key returned as an pointer.
-    std::vector<u64> queue_keys;
-
-    AudioState audio_out_state;
+    std::unique_ptr<AudioCore::Stream> stream;
 };
 
 void AudOutU::ListAudioOuts(Kernel::HLERequestContext& ctx) {
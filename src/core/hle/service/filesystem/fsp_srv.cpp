@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
+#include <cstring>
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/file_sys/directory.h"
@@ -16,6 +18,81 @@
 
 namespace Service::FileSystem {
 
+/**
+ * Reads from a storage backend into the output buffer of a request. The data goes straight into
+ * guest memory when the buffer is contiguous in host memory, and through a temporary copy
+ * otherwise. Either way, the part of the requested length that could not be read is zeroed.
+ */
+static ResultVal<size_t> ReadToWriteBuffer(Kernel::HLERequestContext& ctx,
+                                           FileSys::StorageBackend& backend, u64 offset,
+                                           size_t length) {
+    if (u8* const output = ctx.GetWriteBufferPointer(length)) {
+        ResultVal<size_t> res = backend.Read(offset, length, output);
+        if (res.Succeeded() && *res < length) {
+            std::memset(output + *res, 0, length - *res);
+        }
+        return res;
+    }
+
+    std::vector<u8> output(length);
+    ResultVal<size_t> res = backend.Read(offset, length, output.data());
+    if (res.Succeeded()) {
+        ctx.WriteBuffer(output);
+    }
+    return res;
+}
+
+/// Requests for at least this many bytes are done on the HLE worker. Smaller ones are cheaper to
+/// serve in place than to hand over to another thread.
+constexpr size_t ASYNC_IO_THRESHOLD = 0x10000;
+
+/// Bit of the IFile::Write option that asks for the data to reach the disk before returning
+constexpr u64 WRITE_OPTION_FLUSH = 1;
+
+/// Data handed over from an asynchronous read to its completion on the CPU thread.
+struct PendingRead {
+    /// Zero-initialized, so the part of the requested length past the end of the data reads as 0
+    std::vector<u8> data;
+    size_t length = 0;
+    ResultCode result = RESULT_SUCCESS;
+};
+
+/**
+ * Reads from a storage backend on the HLE worker, and completes the request with the data once
+ * the client resumes. The client sleeps until then, so the read sees the writes it made before.
+ * Requests of other threads served in place may run meanwhile, which the backends lock against.
+ */
+static void ReadAsync(Kernel::HLERequestContext& ctx, const char* reason,
+                      std::shared_ptr<FileSys::StorageBackend> backend, u64 offset, size_t length,
+                      bool push_length) {
+    auto read = std::make_shared<PendingRead>();
+    read->data.resize(length);
+    ctx.RunAsync(
+        reason,
+        [backend = std::move(backend), read, offset] {
+            ResultVal<size_t> res = backend->Read(offset, read->data.size(), read->data.data());
+            if (res.Failed()) {
+                read->result = res.Code();
+            } else {
+                read->length = *res;
+            }
+        },
+        [read, push_length](Kernel::SharedPtr<Kernel::Thread> thread,
+                            Kernel::HLERequestContext& ctx, ThreadWakeupReason reason) {
+            if (read->result.IsError()) {
+                IPC::ResponseBuilder rb{ctx, 2};
+                rb.Push(read->result);
+                return;
+            }
+            ctx.WriteBuffer(read->data);
+            IPC::ResponseBuilder rb{ctx, push_length ? 4u : 2u};
+            rb.Push(RESULT_SUCCESS);
+            if (push_length) {
+                rb.Push(static_cast<u64>(read->length));
+            }
+        });
+}
+
 class IStorage final : public ServiceFramework<IStorage> {
 public:
     IStorage(std::unique_ptr<FileSys::StorageBackend>&& backend)
@@ -28,7 +105,8 @@ public:
     }
 
 private:
-    std::unique_ptr<FileSys::StorageBackend> backend;
+    /// Shared with reads in flight on the HLE worker, which may outlive this interface.
+    std::shared_ptr<FileSys::StorageBackend> backend;
 
     void Read(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx};
@@ -49,20 +127,9 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output(length);
-        ResultVal<size_t> res = backend->Read(offset, length, output.data());
-        if (res.Failed()) {
-            IPC::ResponseBuilder rb{ctx, 2};
-            rb.Push(res.Code());
-            return;
-        }
-
-        // Write the data to memory
-        ctx.WriteBuffer(output);
-
-        IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+        // RomFS reads can be large, so they are done on the HLE worker while the guest keeps
+        // running other threads. The data is copied into guest memory once the client resumes.
+        ReadAsync(ctx, "IStorage::Read", backend, offset, length, false);
     }
 };
 
@@ -79,7 +146,8 @@ public:
     }
 
 private:
-    std::unique_ptr<FileSys::StorageBackend> backend;
+    /// Shared with requests in flight on the HLE worker, which may outlive this interface.
+    std::shared_ptr<FileSys::StorageBackend> backend;
 
     void Read(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx};
@@ -101,18 +169,19 @@ private:
             return;
         }
 
-        // Read the data from the Storage backend
-        std::vector<u8> output(length);
-        ResultVal<size_t> res = backend->Read(offset, length, output.data());
+        if (static_cast<size_t>(length) >= ASYNC_IO_THRESHOLD) {
+            ReadAsync(ctx, "IFile::Read", backend, offset, length, true);
+            return;
+        }
+
+        // Read the data from the Storage backend into memory
+        ResultVal<size_t> res = ReadToWriteBuffer(ctx, *backend, offset, length);
         if (res.Failed()) {
             IPC::ResponseBuilder rb{ctx, 2};
             rb.Push(res.Code());
             return;
         }
 
-        // Write the data to memory
-        ctx.WriteBuffer(output);
-
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
         rb.Push(static_cast<u64>(*res));
@@ -120,11 +189,12 @@ private:
 
     void Write(Kernel::HLERequestContext& ctx) {
         IPC::RequestParser rp{ctx};
-        const u64 unk = rp.Pop<u64>();
+        const u64 option = rp.Pop<u64>();
         const s64 offset = rp.Pop<s64>();
         const s64 length = rp.Pop<s64>();
 
-        LOG_DEBUG(Service_FS, "called, offset=0x%ld, length=0x%ld", offset, length);
+        LOG_DEBUG(Service_FS, "called, option=0x%" PRIx64 ", offset=0x%ld, length=0x%ld", option,
+                  offset, length);
 
         // Error checking
         if (length < 0) {
@@ -138,9 +208,41 @@ private:
             return;
         }
 
-        // Write the data to the Storage backend
-        std::vector<u8> data = ctx.ReadBuffer();
-        ResultVal<size_t> res = backend->Write(offset, length, true, data.data());
+        // The data is left in the host file buffers unless the guest asks for it to be flushed,
+        // which lets consecutive small writes reach the disk together.
+        const bool flush = (option & WRITE_OPTION_FLUSH) != 0;
+
+        if (flush || static_cast<size_t>(length) >= ASYNC_IO_THRESHOLD) {
+            // The guest buffer is copied now, as guest memory may change once the client is
+            // asleep, and it sleeps until the write is done, so its later requests see it.
+            auto data = std::make_shared<std::vector<u8>>(ctx.ReadBuffer());
+            data->resize(length);
+            auto result = std::make_shared<ResultCode>(RESULT_SUCCESS);
+            ctx.RunAsync(
+                "IFile::Write",
+                [backend = backend, data, result, offset, flush] {
+                    ResultVal<size_t> res =
+                        backend->Write(offset, data->size(), flush, data->data());
+                    if (res.Failed()) {
+                        *result = res.Code();
+                    }
+                },
+                [result](Kernel::SharedPtr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                         ThreadWakeupReason reason) {
+                    IPC::ResponseBuilder rb{ctx, 2};
+                    rb.Push(*result);
+                });
+            return;
+        }
+
+        // Write the data to the Storage backend, straight from memory when possible
+        std::vector<u8> data;
+        const u8* input = ctx.GetReadBufferPointer();
+        if (input == nullptr) {
+            data = ctx.ReadBuffer();
+            input = data.data();
+        }
+        ResultVal<size_t> res = backend->Write(offset, length, false, input);
         if (res.Failed()) {
             IPC::ResponseBuilder rb{ctx, 2};
             rb.Push(res.Code());
@@ -153,29 +255,26 @@ private:
 
     void Flush(Kernel::HLERequestContext& ctx) {
         LOG_DEBUG(Service_FS, "called");
-        backend->Flush();
 
-        IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+        // Goes through the worker to stay ordered after the writes still in flight.
+        ctx.RunAsync("IFile::Flush", [backend = backend] { backend->Flush(); },
+                     [](Kernel::SharedPtr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                        ThreadWakeupReason reason) {
+                         IPC::ResponseBuilder rb{ctx, 2};
+                         rb.Push(RESULT_SUCCESS);
+                     });
     }
 
-    void SetSize(Kernel::HLERequestContext& ctx) {
-        IPC::RequestParser rp{ctx};
-        const u64 size = rp.Pop<u64>();
+    ResultCode SetSize(Kernel::HLERequestContext& ctx, u64 size) {
         backend->SetSize(size);
         LOG_DEBUG(Service_FS, "called, size=%" PRIu64, size);
-
-        IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+        return RESULT_SUCCESS;
     }
 
-    void GetSize(Kernel::HLERequestContext& ctx) {
+    ResultVal<u64> GetSize(Kernel::HLERequestContext& ctx) {
         const u64 size = backend->GetSize();
         LOG_DEBUG(Service_FS, "called, size=%" PRIu64, size);
-
-        IPC::ResponseBuilder rb{ctx, 4};
-        rb.Push(RESULT_SUCCESS);
-        rb.Push<u64>(size);
+        return MakeResult<u64>(size);
     }
 };
 
@@ -199,19 +298,20 @@ private:
 
         LOG_DEBUG(Service_FS, "called, unk=0x%llx", unk);
 
-        // Calculate how many entries we can fit in the output buffer
-        u64 count_entries = ctx.GetWriteBufferSize() / sizeof(FileSys::Entry);
-
-        // Read the data from the Directory backend
-        std::vector<FileSys::Entry> entries(count_entries);
-        u64 read_entries = backend->Read(count_entries, entries.data());
-
-        // Convert the data into a byte array
-        std::vector<u8> output(entries.size() * sizeof(FileSys::Entry));
-        std::memcpy(output.data(), entries.data(), output.size());
-
-        // Write the data to memory
-        ctx.WriteBuffer(output);
+        // Read as many entries as fit in the output buffer, and as are left
+        const u64 count_entries = std::min<u64>(ctx.GetWriteBufferSize() / sizeof(FileSys::Entry),
+                                                backend->GetEntryCount());
+        const size_t length = count_entries * sizeof(FileSys::Entry);
+
+        // The entries go straight into guest memory when the buffer is contiguous in host memory
+        u64 read_entries;
+        if (u8* const output = ctx.GetWriteBufferPointer(length)) {
+            read_entries = backend->Read(count_entries, reinterpret_cast<FileSys::Entry*>(output));
+        } else {
+            std::vector<FileSys::Entry> entries(count_entries);
+            read_entries = backend->Read(count_entries, entries.data());
+            ctx.WriteBuffer(entries.data(), read_entries * sizeof(FileSys::Entry));
+        }
 
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
@@ -376,10 +476,10 @@ public:
     }
 
     void Commit(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_FS, "(STUBBED) called");
+        LOG_DEBUG(Service_FS, "called");
 
         IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+        rb.Push(backend->Commit());
     }
 
 private:
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <atomic>
 #include "common/logging/log.h"
 #include "core/core_timing.h"
@@ -13,15 +14,18 @@
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/hid/hid.h"
 #include "core/hle/service/service.h"
+#include "core/movie.h"
 
 namespace Service::HID {
 
 // Updating period for each HID device.
 // TODO(shinyquagsire23): These need better values.
-constexpr u64 pad_update_ticks = BASE_CLOCK_RATE / 10000;
 constexpr u64 accelerometer_update_ticks = BASE_CLOCK_RATE / 10000;
 constexpr u64 gyroscope_update_ticks = BASE_CLOCK_RATE / 10000;
 
+/// Highest rate the pad can be updated at, in Hz
+constexpr u16 max_pad_update_rate = 1000;
+
 class IAppletResource final : public ServiceFramework<IAppletResource> {
 public:
     IAppletResource() : ServiceFramework("IAppletResource") {
@@ -33,19 +37,45 @@ public:
         shared_mem = Kernel::SharedMemory::Create(
             nullptr, 0x40000, Kernel::MemoryPermission::ReadWrite, Kernel::MemoryPermission::Read,
             0, Kernel::MemoryRegion::BASE, "HID:SharedMemory");
+        SetUpControllers();
+
+        const u16 update_rate =
+            std::clamp<u16>(Settings::values.pad_update_rate, 1, max_pad_update_rate);
+        pad_update_ticks = BASE_CLOCK_RATE / update_rate;
 
         // Register update callbacks
         pad_update_event = CoreTiming::RegisterEvent(
             "HID::UpdatePadCallback",
             [this](u64 userdata, int cycles_late) { UpdatePadCallback(userdata, cycles_late); });
+        pad_change_event = CoreTiming::RegisterEvent(
+            "HID::PadChangedCallback", [this](u64 userdata, int cycles_late) {
+                WritePadState(Core::Movie::SampleKind::Change);
+            });
 
         // TODO(shinyquagsire23): Other update callbacks? (accel, gyro?)
 
         CoreTiming::ScheduleEvent(pad_update_ticks, pad_update_event);
+
+        // A movie replaces the input devices, so the changes they reported are replayed at the
+        // ticks they were recorded at
+        const Core::Movie& movie = Core::Movie::GetInstance();
+        if (movie.IsPlayingBack()) {
+            const u64 now = CoreTiming::GetTicks();
+            for (const u64 ticks : movie.GetChangeTicks()) {
+                if (ticks >= now) {
+                    CoreTiming::ScheduleEvent(static_cast<s64>(ticks - now), pad_change_event);
+                }
+            }
+        }
     }
 
     ~IAppletResource() {
         CoreTiming::UnscheduleEvent(pad_update_event, 0);
+        // Drop the buttons first, so that no more changes get scheduled
+        for (auto& button : buttons) {
+            button.reset();
+        }
+        CoreTiming::RemoveNormalAndThreadsafeEvent(pad_change_event);
     }
 
 private:
@@ -61,16 +91,36 @@ private:
                        Settings::values.buttons.begin() + Settings::NativeButton::BUTTON_HID_END,
                        buttons.begin(), Input::CreateDevice<Input::ButtonDevice>);
         // TODO(shinyquagsire23): sticks, gyro, touch, mouse, keyboard
-    }
 
-    void UpdatePadCallback(u64 userdata, int cycles_late) {
-        SharedMemory mem{};
-        std::memcpy(&mem, shared_mem->GetPointer(), sizeof(SharedMemory));
-
-        if (is_device_reload_pending.exchange(false))
-            LoadInputDevices();
+        // The HID buttons are in the same order as the bits of ControllerPadState. The buttons
+        // that report their changes update the snapshot and have the pad updated right away, so
+        // that the guest sees them without waiting for the next update.
+        u64 state = 0;
+        polled_buttons = 0;
+        for (size_t index = 0; index < buttons.size(); ++index) {
+            const u64 bit = 1ULL << index;
+            const bool reports_changes =
+                buttons[index]->SetStatusCallback([this, bit](const bool& pressed) {
+                    if (pressed) {
+                        pad_snapshot.fetch_or(bit);
+                    } else {
+                        pad_snapshot.fetch_and(~bit);
+                    }
+                    CoreTiming::ScheduleEventThreadsafe(0, pad_change_event, 0);
+                });
+            if (!reports_changes) {
+                polled_buttons |= bit;
+            }
+            if (buttons[index]->GetStatus()) {
+                state |= bit;
+            }
+        }
+        pad_snapshot = state;
+    }
 
-        // Set up controllers as neon red+blue Joy-Con attached to console
+    /// Set up controllers as neon red+blue Joy-Con attached to console
+    void SetUpControllers() {
+        SharedMemory& mem = shared_mem->GetView<SharedMemory>();
         ControllerHeader& controller_header = mem.controllers[Controller_Handheld].header;
         controller_header.type = ControllerType_Handheld | ControllerType_JoyconPair;
         controller_header.single_colors_descriptor = ColorDesc_ColorsNonexistent;
@@ -83,61 +133,68 @@ private:
             ControllerLayout& layout = mem.controllers[Controller_Handheld].layouts[index];
             layout.header.num_entries = HID_NUM_ENTRIES;
             layout.header.max_entry_index = HID_NUM_ENTRIES - 1;
+        }
+    }
+
+    /**
+     * Samples the buttons that have to be polled, then writes the pad state as the latest entry.
+     * The state goes through the movie, which records it or replaces it with the recorded one.
+     */
+    void WritePadState(Core::Movie::SampleKind kind) {
+        Core::Movie& movie = Core::Movie::GetInstance();
+
+        u64 state = 0;
+        if (!movie.IsPlayingBack()) {
+            if (is_device_reload_pending.exchange(false))
+                LoadInputDevices();
+
+            state = pad_snapshot.load();
+            for (size_t index = 0; index < buttons.size(); ++index) {
+                const u64 bit = 1ULL << index;
+                if ((polled_buttons & bit) != 0) {
+                    state = buttons[index]->GetStatus() ? state | bit : state & ~bit;
+                }
+            }
+        }
+        state = movie.HandlePadState(state, kind);
+
+        // Update the shared memory in place, the guest observes it through the same host memory.
+        // Only the entry that becomes the latest one is written.
+        SharedMemory& mem = shared_mem->GetView<SharedMemory>();
+        const u64 timestamp_ticks = CoreTiming::GetTicks();
+        for (int index = 0; index < HID_NUM_LAYOUTS; index++) {
+            ControllerLayout& layout = mem.controllers[Controller_Handheld].layouts[index];
 
             // HID shared memory stores the state of the past 17 samples in a circlular buffer,
             // each with a timestamp in number of samples since boot.
-            layout.header.timestamp_ticks = CoreTiming::GetTicks();
-            layout.header.latest_entry = (layout.header.latest_entry + 1) % HID_NUM_ENTRIES;
+            const ControllerInputEntry& last_entry = layout.entries[layout.header.latest_entry];
+            const u64 sample_number = last_entry.timestamp + 1;
+            const u64 next_entry = (layout.header.latest_entry + 1) % HID_NUM_ENTRIES;
 
-            ControllerInputEntry& entry = layout.entries[layout.header.latest_entry];
+            ControllerInputEntry& entry = layout.entries[next_entry];
             entry.connection_state = ConnectionState_Connected | ConnectionState_Wired;
-            entry.timestamp++;
-            entry.timestamp_2++; // TODO(shinyquagsire23): Is this always identical to timestamp?
+            entry.timestamp = sample_number;
+            entry.timestamp_2 = sample_number; // TODO(shinyquagsire23): Is this always identical?
 
             // TODO(shinyquagsire23): Set up some LUTs for each layout mapping in the future?
             // For now everything is just the default handheld layout, but split Joy-Con will
             // rotate the face buttons and directions for certain layouts.
-            ControllerPadState& state = entry.buttons;
-            using namespace Settings::NativeButton;
-            state.a.Assign(buttons[A - BUTTON_HID_BEGIN]->GetStatus());
-            state.b.Assign(buttons[B - BUTTON_HID_BEGIN]->GetStatus());
-            state.x.Assign(buttons[X - BUTTON_HID_BEGIN]->GetStatus());
-            state.y.Assign(buttons[Y - BUTTON_HID_BEGIN]->GetStatus());
-            state.lstick.Assign(buttons[LStick - BUTTON_HID_BEGIN]->GetStatus());
-            state.rstick.Assign(buttons[RStick - BUTTON_HID_BEGIN]->GetStatus());
-            state.l.Assign(buttons[L - BUTTON_HID_BEGIN]->GetStatus());
-            state.r.Assign(buttons[R - BUTTON_HID_BEGIN]->GetStatus());
-            state.zl.Assign(buttons[ZL - BUTTON_HID_BEGIN]->GetStatus());
-            state.zr.Assign(buttons[ZR - BUTTON_HID_BEGIN]->GetStatus());
-            state.plus.Assign(buttons[Plus - BUTTON_HID_BEGIN]->GetStatus());
-            state.minus.Assign(buttons[Minus - BUTTON_HID_BEGIN]->GetStatus());
-
-            state.dleft.Assign(buttons[DLeft - BUTTON_HID_BEGIN]->GetStatus());
-            state.dup.Assign(buttons[DUp - BUTTON_HID_BEGIN]->GetStatus());
-            state.dright.Assign(buttons[DRight - BUTTON_HID_BEGIN]->GetStatus());
-            state.ddown.Assign(buttons[DDown - BUTTON_HID_BEGIN]->GetStatus());
-
-            state.lstick_left.Assign(buttons[LStick_Left - BUTTON_HID_BEGIN]->GetStatus());
-            state.lstick_up.Assign(buttons[LStick_Up - BUTTON_HID_BEGIN]->GetStatus());
-            state.lstick_right.Assign(buttons[LStick_Right - BUTTON_HID_BEGIN]->GetStatus());
-            state.lstick_down.Assign(buttons[LStick_Down - BUTTON_HID_BEGIN]->GetStatus());
-
-            state.rstick_left.Assign(buttons[RStick_Left - BUTTON_HID_BEGIN]->GetStatus());
-            state.rstick_up.Assign(buttons[RStick_Up - BUTTON_HID_BEGIN]->GetStatus());
-            state.rstick_right.Assign(buttons[RStick_Right - BUTTON_HID_BEGIN]->GetStatus());
-            state.rstick_down.Assign(buttons[RStick_Down - BUTTON_HID_BEGIN]->GetStatus());
-
-            state.sl.Assign(buttons[SL - BUTTON_HID_BEGIN]->GetStatus());
-            state.sr.Assign(buttons[SR - BUTTON_HID_BEGIN]->GetStatus());
+            entry.buttons.hex = state;
 
             // TODO(shinyquagsire23): Analog stick vals
 
-            // TODO(shinyquagsire23): Update pad info proper, (circular buffers, timestamps,
-            // layouts)
+            // Publish the entry once it is complete
+            layout.header.timestamp_ticks = timestamp_ticks;
+            layout.header.latest_entry = next_entry;
         }
+    }
+
+    void UpdatePadCallback(u64 userdata, int cycles_late) {
+        WritePadState(Core::Movie::SampleKind::Update);
 
         // TODO(bunnei): Properly implement the touch screen, the below will just write empty data
 
+        SharedMemory& mem = shared_mem->GetView<SharedMemory>();
         TouchScreen& touchscreen = mem.touchscreen;
         const u64 last_entry = touchscreen.header.latest_entry;
         const u64 curr_entry = (last_entry + 1) % touchscreen.entries.size();
@@ -153,8 +210,6 @@ private:
 
         // TODO(shinyquagsire23): Signal events
 
-        std::memcpy(shared_mem->GetPointer(), &mem, sizeof(SharedMemory));
-
         // Reschedule recurrent event
         CoreTiming::ScheduleEvent(pad_update_ticks - cycles_late, pad_update_event);
     }
@@ -163,10 +218,16 @@ private:
     Kernel::SharedPtr<Kernel::SharedMemory> shared_mem;
 
     // CoreTiming update events
+    u64 pad_update_ticks;
     CoreTiming::EventType* pad_update_event;
+    CoreTiming::EventType* pad_change_event;
 
     // Stored input state info
     std::atomic<bool> is_device_reload_pending{true};
+    /// State of the buttons that report their changes, in the layout of ControllerPadState
+    std::atomic<u64> pad_snapshot{0};
+    /// Bits of the buttons that don't report their changes, and are sampled at every update
+    u64 polled_buttons = 0;
     std::array<std::unique_ptr<Input::ButtonDevice>, Settings::NativeButton::NUM_BUTTONS_HID>
         buttons;
 };
@@ -0,0 +1,99 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+#include <unordered_map>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/hle/service/ipc_recorder.h"
+
+namespace Service::IPCRecorder {
+
+static std::atomic<bool> enabled{false};
+
+/// Requests are recorded on the CPU thread, while the debugger reads the statistics from the UI.
+static std::mutex stats_mutex;
+/// Statistics keyed by service name, then by command id
+static std::unordered_map<std::string, std::unordered_map<u32, CommandStats>> stats;
+
+bool IsEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void SetEnabled(bool enable) {
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+void Record(const std::string& service_name, u32 command_id, const char* function_name,
+            std::chrono::nanoseconds host_time, u64 bytes_in, u64 bytes_out) {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+
+    CommandStats& command = stats[service_name][command_id];
+    if (command.num_calls == 0) {
+        command.service_name = service_name;
+        command.command_id = command_id;
+        command.function_name = function_name != nullptr ? function_name : "";
+    }
+
+    ++command.num_calls;
+    command.host_time += host_time;
+    command.max_host_time = std::max(command.max_host_time, host_time);
+    command.bytes_in += bytes_in;
+    command.bytes_out += bytes_out;
+
+    const auto host_us = std::chrono::duration_cast<std::chrono::microseconds>(host_time).count();
+    size_t bucket = 0;
+    while (bucket < command.latency.size() - 1 && (host_us >> bucket) != 0) {
+        ++bucket;
+    }
+    ++command.latency[bucket];
+}
+
+std::vector<CommandStats> GetStats() {
+    std::vector<CommandStats> result;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        for (const auto& service : stats) {
+            for (const auto& command : service.second) {
+                result.push_back(command.second);
+            }
+        }
+    }
+
+    std::sort(result.begin(), result.end(), [](const CommandStats& a, const CommandStats& b) {
+        return std::tie(a.service_name, a.command_id) < std::tie(b.service_name, b.command_id);
+    });
+    return result;
+}
+
+bool WriteCSV(const std::string& path) {
+    std::string output = "service,command_id,function,calls,host_ns,max_host_ns,bytes_in,bytes_out";
+    for (size_t bucket = 0; bucket < CommandStats::NUM_LATENCY_BUCKETS - 1; ++bucket) {
+        output += fmt::format(",lt_{}us", u64(1) << bucket);
+    }
+    output += fmt::format(",ge_{}us\n", u64(1) << (CommandStats::NUM_LATENCY_BUCKETS - 2));
+
+    for (const CommandStats& command : GetStats()) {
+        output += fmt::format("{},{},{},{},{},{},{},{}", command.service_name, command.command_id,
+                              command.function_name, command.num_calls,
+                              command.host_time.count(), command.max_host_time.count(),
+                              command.bytes_in, command.bytes_out);
+        for (const u64 count : command.latency) {
+            output += fmt::format(",{}", count);
+        }
+        output += '\n';
+    }
+
+    return FileUtil::WriteStringToFile(true, output, path.c_str()) == output.size();
+}
+
+void Reset() {
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.clear();
+}
+
+} // namespace Service::IPCRecorder
@@ -0,0 +1,71 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+
+/**
+ * Records statistics about the IPC requests handled by HLE services, to find out which commands
+ * are hot paths. When enabled, ServiceFrameworkBase::InvokeRequest times every handler and adds
+ * it to the statistics of its (service, command id) pair. Recording is enabled initially through
+ * Settings::values.record_ipc_calls and can be toggled at runtime by the debugger.
+ */
+namespace Service::IPCRecorder {
+
+struct CommandStats {
+    static constexpr size_t NUM_LATENCY_BUCKETS = 16;
+
+    std::string service_name;
+    u32 command_id = 0;
+    /// Name of the handler, or empty if the command has no FunctionInfo.
+    std::string function_name;
+
+    u64 num_calls = 0;
+    std::chrono::nanoseconds host_time{};
+    std::chrono::nanoseconds max_host_time{};
+    /// Bytes of raw data and input buffers sent with the requests.
+    u64 bytes_in = 0;
+    /// Bytes of output buffer space offered with the requests.
+    u64 bytes_out = 0;
+    /// Bucket 0 counts calls that took less than a microsecond, bucket i calls that took
+    /// [2^(i-1), 2^i) microseconds. The last bucket also counts everything slower than that.
+    std::array<u64, NUM_LATENCY_BUCKETS> latency{};
+};
+
+/// Returns whether IPC requests are currently being recorded.
+bool IsEnabled();
+
+/// Enables or disables recording. The collected statistics are kept either way.
+void SetEnabled(bool enabled);
+
+/**
+ * Adds a handled request to the statistics of its command.
+ * @param service_name Name of the service that handled the request.
+ * @param command_id Id of the command that was requested.
+ * @param function_name Name of the handler, or nullptr if unknown.
+ * @param host_time Host time the handler took.
+ * @param bytes_in Bytes of raw data and input buffers sent with the request.
+ * @param bytes_out Bytes of output buffer space offered with the request.
+ */
+void Record(const std::string& service_name, u32 command_id, const char* function_name,
+            std::chrono::nanoseconds host_time, u64 bytes_in, u64 bytes_out);
+
+/// Returns a copy of the statistics of every command that was called, sorted by service and id.
+std::vector<CommandStats> GetStats();
+
+/**
+ * Writes the statistics as CSV, one line per command.
+ * @return true if the file was written successfully.
+ */
+bool WriteCSV(const std::string& path);
+
+/// Discards all collected statistics.
+void Reset();
+
+} // namespace Service::IPCRecorder
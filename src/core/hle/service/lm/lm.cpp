@@ -2,164 +2,406 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstring>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/hle/async_worker.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/client_session.h"
 #include "core/hle/service/lm/lm.h"
 
 namespace Service::LM {
 
-class Logger final : public ServiceFramework<Logger> {
-public:
-    Logger() : ServiceFramework("Logger") {
-        static const FunctionInfo functions[] = {
-            {0x00000000, &Logger::Log, "Log"},
-        };
-        RegisterHandlers(functions);
+namespace {
+
+struct MessageHeader {
+    enum Flags : u32_le {
+        IsHead = 1,
+        IsTail = 2,
+    };
+    enum Severity : u32_le {
+        Trace,
+        Info,
+        Warning,
+        Error,
+        Critical,
+    };
+
+    u64_le pid;
+    u64_le threadContext;
+    union {
+        BitField<0, 16, Flags> flags;
+        BitField<16, 8, Severity> severity;
+        BitField<24, 8, u32_le> verbosity;
+    };
+    u32_le payload_size;
+
+    bool IsHeadLog() const {
+        return flags & Flags::IsHead;
     }
+    bool IsTailLog() const {
+        return flags & Flags::IsTail;
+    }
+};
+static_assert(sizeof(MessageHeader) == 0x18, "MessageHeader is incorrect size");
 
-    ~Logger() = default;
+/// Log field type
+enum class Field : u8 {
+    Skip = 1,
+    Message = 2,
+    Line = 3,
+    Filename = 4,
+    Function = 5,
+    Module = 6,
+    Thread = 7,
+};
 
-private:
-    struct MessageHeader {
-        enum Flags : u32_le {
-            IsHead = 1,
-            IsTail = 2,
-        };
-        enum Severity : u32_le {
-            Trace,
-            Info,
-            Warning,
-            Error,
-            Critical,
-        };
+/// Packets are handed to the HLE worker once this many are pending, or after FLUSH_DELAY_MS.
+constexpr size_t MAX_PENDING_PACKETS = 64;
+constexpr int FLUSH_DELAY_MS = 16;
 
-        u64_le pid;
-        u64_le threadContext;
-        union {
-            BitField<0, 16, Flags> flags;
-            BitField<16, 8, Severity> severity;
-            BitField<24, 8, u32_le> verbosity;
-        };
-        u32_le payload_size;
+/// Each source of messages may write LINES_PER_SECOND messages a second on average, and up to
+/// MAX_BURST_LINES at once. The messages past that are dropped and counted.
+constexpr double LINES_PER_SECOND = 200.0;
+constexpr double MAX_BURST_LINES = 400.0;
 
-        bool IsHeadLog() const {
-            return flags & Flags::IsHead;
-        }
-        bool IsTailLog() const {
-            return flags & Flags::IsTail;
+Log::Level GetLogLevel(MessageHeader::Severity severity) {
+    switch (severity) {
+    case MessageHeader::Severity::Trace:
+        return Log::Level::Trace;
+    case MessageHeader::Severity::Info:
+        return Log::Level::Info;
+    case MessageHeader::Severity::Warning:
+        return Log::Level::Warning;
+    case MessageHeader::Severity::Error:
+        return Log::Level::Error;
+    default:
+        return Log::Level::Critical;
+    }
+}
+
+/// A log packet as the guest sent it, along with the session that sent it.
+struct Packet {
+    u64 session_id;
+    /// Header and fields of the packet, or empty once the session has been closed
+    std::vector<u8> data;
+};
+
+/**
+ * Turns log packets into messages of the log. It is only ever used by one thread at a time, on
+ * the HLE worker, so parsing and formatting the messages stays off the CPU thread.
+ */
+class LogProcessor final {
+public:
+    void Process(const std::vector<Packet>& packets) {
+        for (const Packet& packet : packets) {
+            if (packet.data.empty()) {
+                partial_messages.erase(packet.session_id);
+            } else {
+                ProcessPacket(packet);
+            }
         }
-    };
-    static_assert(sizeof(MessageHeader) == 0x18, "MessageHeader is incorrect size");
-
-    /// Log field type
-    enum class Field : u8 {
-        Skip = 1,
-        Message = 2,
-        Line = 3,
-        Filename = 4,
-        Function = 5,
-        Module = 6,
-        Thread = 7,
+        // Report the repeats at the end of each batch, so that a message the guest keeps
+        // repeating still shows up now and then
+        WriteRepeats();
+    }
+
+private:
+    /// Message whose tail packet hasn't arrived yet
+    struct PartialMessage {
+        std::string text;
+        std::string source;
     };
 
-    /**
-     * LM::Log service function
-     *  Inputs:
-     *      0: 0x00000000
-     *  Outputs:
-     *      0: ResultCode
-     */
-    void Log(Kernel::HLERequestContext& ctx) {
-        // This function only succeeds - Get that out of the way
-        IPC::ResponseBuilder rb{ctx, 2};
-        rb.Push(RESULT_SUCCESS);
+    struct Source {
+        double tokens = MAX_BURST_LINES;
+        std::chrono::steady_clock::time_point last_refill = std::chrono::steady_clock::now();
+        u64 dropped_lines = 0;
+    };
 
-        // Read MessageHeader, despite not doing anything with it right now
+    void ProcessPacket(const Packet& packet) {
         MessageHeader header{};
-        VAddr addr{ctx.BufferDescriptorX()[0].Address()};
-        const VAddr end_addr{addr + ctx.BufferDescriptorX()[0].size};
-        Memory::ReadBlock(addr, &header, sizeof(MessageHeader));
-        addr += sizeof(MessageHeader);
+        if (packet.data.size() < sizeof(MessageHeader)) {
+            return;
+        }
+        std::memcpy(&header, packet.data.data(), sizeof(MessageHeader));
 
+        PartialMessage& partial = partial_messages[packet.session_id];
         if (header.IsHeadLog()) {
-            log_stream.str("");
-            log_stream.clear();
+            partial = {};
         }
 
         // Parse out log metadata
         u32 line{};
-        std::string message, filename, function;
-        while (addr < end_addr) {
-            const Field field{static_cast<Field>(Memory::Read8(addr++))};
-            const size_t length{Memory::Read8(addr++)};
+        std::string message, filename, function, module;
+        const u8* addr = packet.data.data() + sizeof(MessageHeader);
+        const u8* const end_addr = packet.data.data() + packet.data.size();
+        while (end_addr - addr >= 2) {
+            const Field field{static_cast<Field>(*addr++)};
+            size_t length{*addr++};
 
-            if (static_cast<Field>(Memory::Read8(addr)) == Field::Skip) {
+            if (addr != end_addr && static_cast<Field>(*addr) == Field::Skip) {
                 ++addr;
             }
+            length = std::min<size_t>(length, end_addr - addr);
+            const char* const value = reinterpret_cast<const char*>(addr);
 
             switch (field) {
             case Field::Message:
-                message = Memory::ReadCString(addr, length);
+                message.assign(value, strnlen(value, length));
                 break;
             case Field::Line:
-                line = Memory::Read32(addr);
+                if (length >= sizeof(u32)) {
+                    std::memcpy(&line, value, sizeof(u32));
+                }
                 break;
             case Field::Filename:
-                filename = Memory::ReadCString(addr, length);
+                filename.assign(value, strnlen(value, length));
                 break;
             case Field::Function:
-                function = Memory::ReadCString(addr, length);
+                function.assign(value, strnlen(value, length));
+                break;
+            case Field::Module:
+                module.assign(value, strnlen(value, length));
                 break;
             }
 
             addr += length;
         }
 
+        if (partial.source.empty()) {
+            partial.source = !filename.empty() ? filename : module;
+        }
+
         // Empty log - nothing to do here
-        if (log_stream.str().empty() && message.empty()) {
+        if (partial.text.empty() && message.empty()) {
             return;
         }
 
         // Format a nicely printable string out of the log metadata
+        std::string& text = partial.text;
         if (!filename.empty()) {
-            log_stream << filename << ':';
+            text += filename + ':';
         }
         if (!function.empty()) {
-            log_stream << function << ':';
+            text += function + ':';
         }
         if (line) {
-            log_stream << std::to_string(line) << ':';
+            text += std::to_string(line) + ':';
         }
-        if (log_stream.str().length() > 0 && log_stream.str().back() == ':') {
-            log_stream << ' ';
+        if (!text.empty() && text.back() == ':') {
+            text += ' ';
         }
-        log_stream << message;
+        text += message;
 
         if (header.IsTailLog()) {
-            switch (header.severity) {
-            case MessageHeader::Severity::Trace:
-                LOG_TRACE(Debug_Emulated, "%s", log_stream.str().c_str());
-                break;
-            case MessageHeader::Severity::Info:
-                LOG_INFO(Debug_Emulated, "%s", log_stream.str().c_str());
-                break;
-            case MessageHeader::Severity::Warning:
-                LOG_WARNING(Debug_Emulated, "%s", log_stream.str().c_str());
-                break;
-            case MessageHeader::Severity::Error:
-                LOG_ERROR(Debug_Emulated, "%s", log_stream.str().c_str());
-                break;
-            case MessageHeader::Severity::Critical:
-                LOG_CRITICAL(Debug_Emulated, "%s", log_stream.str().c_str());
-                break;
-            }
+            WriteMessage(header.severity, partial.source, text);
+            partial_messages.erase(packet.session_id);
         }
     }
 
-    std::ostringstream log_stream;
+    void WriteMessage(MessageHeader::Severity severity, const std::string& source,
+                      const std::string& text) {
+        // Coalesce duplicates before rate limiting, so that they don't use up the budget
+        if (severity == last_severity && text == last_text) {
+            ++repeats;
+            return;
+        }
+        WriteRepeats();
+        last_severity = severity;
+        last_text = text;
+
+        if (!TakeLine(source)) {
+            return;
+        }
+        Write(severity, text.c_str());
+    }
+
+    void WriteRepeats() {
+        if (repeats == 0) {
+            return;
+        }
+        const std::string text =
+            "The previous message was repeated " + std::to_string(repeats) + " times";
+        repeats = 0;
+        Write(last_severity, text.c_str());
+    }
+
+    /// Returns whether the source may write another message right now.
+    bool TakeLine(const std::string& source_name) {
+        Source& source = sources[source_name];
+        const auto now = std::chrono::steady_clock::now();
+        const double elapsed = std::chrono::duration<double>(now - source.last_refill).count();
+        source.tokens = std::min(MAX_BURST_LINES, source.tokens + elapsed * LINES_PER_SECOND);
+        source.last_refill = now;
+
+        if (source.tokens < 1.0) {
+            ++source.dropped_lines;
+            return false;
+        }
+        source.tokens -= 1.0;
+
+        if (source.dropped_lines != 0) {
+            LOG_WARNING(Debug_Emulated, "%" PRIu64 " messages from %s were dropped",
+                        source.dropped_lines,
+                        source_name.empty() ? "the guest" : source_name.c_str());
+            source.dropped_lines = 0;
+        }
+        return true;
+    }
+
+    static void Write(MessageHeader::Severity severity, const char* text) {
+        switch (severity) {
+        case MessageHeader::Severity::Trace:
+            LOG_TRACE(Debug_Emulated, "%s", text);
+            break;
+        case MessageHeader::Severity::Info:
+            LOG_INFO(Debug_Emulated, "%s", text);
+            break;
+        case MessageHeader::Severity::Warning:
+            LOG_WARNING(Debug_Emulated, "%s", text);
+            break;
+        case MessageHeader::Severity::Error:
+            LOG_ERROR(Debug_Emulated, "%s", text);
+            break;
+        case MessageHeader::Severity::Critical:
+            LOG_CRITICAL(Debug_Emulated, "%s", text);
+            break;
+        }
+    }
+
+    std::unordered_map<u64, PartialMessage> partial_messages;
+    std::unordered_map<std::string, Source> sources;
+
+    /// Last message written, and how many times it came again since
+    MessageHeader::Severity last_severity = MessageHeader::Severity::Trace;
+    std::string last_text;
+    u64 repeats = 0;
+};
+
+} // Anonymous namespace
+
+/**
+ * Collects the log packets of every Logger session on the CPU thread, and hands them to the HLE
+ * worker in batches, where a LogProcessor turns them into messages.
+ */
+class LogBatcher final {
+public:
+    LogBatcher() : processor(std::make_shared<LogProcessor>()) {
+        flush_event = CoreTiming::RegisterEvent(
+            "LM::FlushLog", [this](u64 userdata, int cycles_late) { Flush(); });
+    }
+
+    ~LogBatcher() {
+        CoreTiming::RemoveEvent(flush_event);
+        // Services are destroyed after the HLE worker has stopped, so nothing else uses the
+        // processor anymore and the last packets can be written right here.
+        if (!pending_packets.empty()) {
+            processor->Process(pending_packets);
+        }
+    }
+
+    u64 OpenSession() {
+        return next_session_id++;
+    }
+
+    void CloseSession(u64 session_id) {
+        // Never flushes on its own, as sessions are also closed once the HLE worker has stopped
+        Queue({session_id, {}});
+    }
+
+    /// Queues a packet. Error messages are written without waiting for more packets.
+    void Push(Packet packet, bool urgent) {
+        Queue(std::move(packet));
+        if (urgent || pending_packets.size() >= MAX_PENDING_PACKETS) {
+            CoreTiming::UnscheduleEvent(flush_handle);
+            Flush();
+        }
+    }
+
+private:
+    void Queue(Packet packet) {
+        if (pending_packets.empty()) {
+            flush_handle = CoreTiming::ScheduleEvent(msToCycles(FLUSH_DELAY_MS), flush_event);
+        }
+        pending_packets.push_back(std::move(packet));
+    }
+
+    void Flush() {
+        if (pending_packets.empty()) {
+            return;
+        }
+        HLE::AsyncWorker::Submit(
+            [processor = processor, packets = std::move(pending_packets)] {
+                processor->Process(packets);
+            },
+            [] {});
+        pending_packets = {};
+    }
+
+    std::shared_ptr<LogProcessor> processor;
+    std::vector<Packet> pending_packets;
+    CoreTiming::EventType* flush_event;
+    /// Flush scheduled for the packets that are pending
+    CoreTiming::EventHandle flush_handle;
+    u64 next_session_id = 0;
+};
+
+class Logger final : public ServiceFramework<Logger> {
+public:
+    explicit Logger(std::shared_ptr<LogBatcher> batcher)
+        : ServiceFramework("Logger"), batcher(std::move(batcher)),
+          session_id(this->batcher->OpenSession()) {
+        static const FunctionInfo functions[] = {
+            {0x00000000, &Logger::Log, "Log"},
+        };
+        RegisterHandlers(functions);
+    }
+
+    ~Logger() {
+        batcher->CloseSession(session_id);
+    }
+
+private:
+    /**
+     * LM::Log service function
+     *  Inputs:
+     *      0: 0x00000000
+     *  Outputs:
+     *      0: ResultCode
+     */
+    void Log(Kernel::HLERequestContext& ctx) {
+        // This function only succeeds - Get that out of the way
+        IPC::ResponseBuilder rb{ctx, 2};
+        rb.Push(RESULT_SUCCESS);
+
+        // The packet is only copied here, it is parsed on the HLE worker
+        const VAddr addr{ctx.BufferDescriptorX()[0].Address()};
+        const size_t size{ctx.BufferDescriptorX()[0].size};
+        if (size < sizeof(MessageHeader)) {
+            return;
+        }
+        MessageHeader header{};
+        Memory::ReadBlock(addr, &header, sizeof(MessageHeader));
+        if (header.IsHeadLog() && header.IsTailLog() &&
+            !Log::IsLogged(Log::Class::Debug_Emulated, GetLogLevel(header.severity))) {
+            // A whole message that would be filtered out anyway
+            return;
+        }
+
+        Packet packet{session_id, std::vector<u8>(size)};
+        Memory::ReadBlock(addr, packet.data.data(), size);
+        batcher->Push(std::move(packet), header.severity >= MessageHeader::Severity::Error);
+    }
+
+    std::shared_ptr<LogBatcher> batcher;
+    u64 session_id;
 };
 
 void InstallInterfaces(SM::ServiceManager& service_manager) {
@@ -176,16 +418,18 @@ void InstallInterfaces(SM::ServiceManager& service_manager) {
 void LM::Initialize(Kernel::HLERequestContext& ctx) {
     IPC::ResponseBuilder rb{ctx, 2, 0, 1};
     rb.Push(RESULT_SUCCESS);
-    rb.PushIpcInterface<Logger>();
+    rb.PushIpcInterface<Logger>(batcher);
 
     LOG_DEBUG(Service_LM, "called");
 }
 
-LM::LM() : ServiceFramework("lm") {
+LM::LM() : ServiceFramework("lm"), batcher(std::make_shared<LogBatcher>()) {
     static const FunctionInfo functions[] = {
         {0x00000000, &LM::Initialize, "Initialize"},
     };
     RegisterHandlers(functions);
 }
 
+LM::~LM() = default;
+
 } // namespace Service::LM
@@ -4,19 +4,24 @@
 
 #pragma once
 
-#include <vector>
+#include <memory>
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/service/service.h"
 
 namespace Service::LM {
 
+class LogBatcher;
+
 class LM final : public ServiceFramework<LM> {
 public:
     LM();
-    ~LM() = default;
+    ~LM();
 
 private:
     void Initialize(Kernel::HLERequestContext& ctx);
+
+    /// Shared by every Logger session
+    std::shared_ptr<LogBatcher> batcher;
 };
 
 /// Registers all LM services with the specified service manager.
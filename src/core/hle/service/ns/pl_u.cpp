@@ -46,16 +46,26 @@ PL_U::PL_U() : ServiceFramework("pl:u") {
     FileUtil::CreateFullPath(filepath); // Create path if not already created
     FileUtil::IOFile file(filepath, "rb");
 
-    shared_font = std::make_shared<std::vector<u8>>(SHARED_FONT_MEM_SIZE);
     if (file.IsOpen()) {
-        // Read shared font data
         ASSERT(file.GetSize() == SHARED_FONT_MEM_SIZE);
-        file.ReadBytes(shared_font->data(), shared_font->size());
+        // The font is mapped rather than read, so that its pages are only loaded once the guest
+        // touches them and are shared with every other process that maps the dump on the host.
+        shared_font_mapping =
+            std::make_shared<FileUtil::CopyOnWriteMapping>(file, SHARED_FONT_MEM_SIZE, 0);
+        if (!shared_font_mapping->IsMapped()) {
+            shared_font_mapping = nullptr;
+            shared_font = std::make_shared<std::vector<u8>>(SHARED_FONT_MEM_SIZE);
+            file.Seek(0, SEEK_SET);
+            file.ReadBytes(shared_font->data(), shared_font->size());
+        }
     } else {
         LOG_WARNING(Service_NS, "Unable to load shared font: %s", filepath.c_str());
+        shared_font = std::make_shared<std::vector<u8>>(SHARED_FONT_MEM_SIZE);
     }
 }
 
+PL_U::~PL_U() = default;
+
 void PL_U::RequestLoad(Kernel::HLERequestContext& ctx) {
     IPC::RequestParser rp{ctx};
     const u32 shared_font_type{rp.Pop<u32>()};
@@ -100,15 +110,24 @@ void PL_U::GetSharedMemoryNativeHandle(Kernel::HLERequestContext& ctx) {
     // font data. This (likely) relies on exact address, size, and offsets from the original
     // dump. In the future, we need to replace this with a more robust solution.
 
-    // Map backing memory for the font data
-    Core::CurrentProcess()->vm_manager.MapMemoryBlock(
-        SHARED_FONT_MEM_VADDR, shared_font, 0, SHARED_FONT_MEM_SIZE, Kernel::MemoryState::Shared);
-
-    // Create shared font memory object
-    shared_font_mem = Kernel::SharedMemory::Create(
-        Core::CurrentProcess(), SHARED_FONT_MEM_SIZE, Kernel::MemoryPermission::ReadWrite,
-        Kernel::MemoryPermission::Read, SHARED_FONT_MEM_VADDR, Kernel::MemoryRegion::BASE,
-        "PL_U:shared_font_mem");
+    // The font is only mapped the first time, later calls hand out the same memory object
+    if (shared_font_mem == nullptr) {
+        // Map backing memory for the font data
+        auto& vm_manager = Core::CurrentProcess()->vm_manager;
+        if (shared_font_mapping != nullptr) {
+            vm_manager.MapBackingMemory(SHARED_FONT_MEM_VADDR, shared_font_mapping->Data(),
+                                        SHARED_FONT_MEM_SIZE, Kernel::MemoryState::Shared);
+        } else {
+            vm_manager.MapMemoryBlock(SHARED_FONT_MEM_VADDR, shared_font, 0, SHARED_FONT_MEM_SIZE,
+                                      Kernel::MemoryState::Shared);
+        }
+
+        // Create shared font memory object
+        shared_font_mem = Kernel::SharedMemory::Create(
+            Core::CurrentProcess(), SHARED_FONT_MEM_SIZE, Kernel::MemoryPermission::ReadWrite,
+            Kernel::MemoryPermission::Read, SHARED_FONT_MEM_VADDR, Kernel::MemoryRegion::BASE,
+            "PL_U:shared_font_mem");
+    }
 
     LOG_DEBUG(Service_NS, "called");
     IPC::ResponseBuilder rb{ctx, 2, 1};
@@ -5,15 +5,20 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/service.h"
 
+namespace FileUtil {
+class CopyOnWriteMapping;
+}
+
 namespace Service::NS {
 
 class PL_U final : public ServiceFramework<PL_U> {
 public:
     PL_U();
-    ~PL_U() = default;
+    ~PL_U();
 
 private:
     void RequestLoad(Kernel::HLERequestContext& ctx);
@@ -25,7 +30,9 @@ private:
     /// Handle to shared memory region designated for a shared font
     Kernel::SharedPtr<Kernel::SharedMemory> shared_font_mem;
 
-    /// Backing memory for the shared font data
+    /// Backing memory for the shared font data, mapped straight from the font dump when possible
+    std::shared_ptr<FileUtil::CopyOnWriteMapping> shared_font_mapping;
+    /// Backing memory for the shared font data when the dump couldn't be mapped
     std::shared_ptr<std::vector<u8>> shared_font;
 };
 
@@ -4,13 +4,56 @@
 
 #pragma once
 
-#include <vector>
+#include <cstddef>
+#include <functional>
+#include <boost/optional.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
 #include "common/swap.h"
+#include "core/hle/kernel/event.h"
 
 namespace Service::Nvidia::Devices {
 
+/**
+ * View over the input or output buffer of an ioctl. It points straight into the IPC buffer of the
+ * guest whenever that is contiguous in host memory, so that the ioctls don't go through copies.
+ */
+template <typename T>
+class IoctlBuffer {
+public:
+    constexpr IoctlBuffer(T* pointer, size_t length) : pointer(pointer), length(length) {}
+
+    constexpr T* data() const {
+        return pointer;
+    }
+
+    constexpr size_t size() const {
+        return length;
+    }
+
+private:
+    T* pointer;
+    size_t length;
+};
+
+using IoctlInput = IoctlBuffer<const u8>;
+using IoctlOutput = IoctlBuffer<u8>;
+
+/// Result of an ioctl whose wait wasn't done in time
+constexpr u32 NvErrorTimeout = 5;
+
+/// Wait an ioctl asks for when it can't complete yet, see nvdevice::WaitAndRetry
+struct IoctlWait {
+    /// Arranges for the event to be signaled once the ioctl can complete, and returns an id for
+    /// remove_waiter
+    std::function<u64(Kernel::SharedPtr<Kernel::Event> event)> add_waiter;
+    /// Undoes add_waiter when the wait times out, so that nothing holds on to the event
+    std::function<void(u64 waiter_id)> remove_waiter;
+    /// Nanoseconds after which the ioctl fails with NvErrorTimeout, or 0 to wait for as long as it
+    /// takes
+    u64 timeout_ns;
+};
+
 /// Represents an abstract nvidia device node. It is to be subclassed by concrete device nodes to
 /// implement the ioctl interface.
 class nvdevice {
@@ -33,7 +76,27 @@ public:
      * @param output A buffer where the output data will be written to.
      * @returns The result code of the ioctl.
      */
-    virtual u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) = 0;
+    virtual u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) = 0;
+
+    /// Returns the wait the last ioctl asked for, if it did, and clears it.
+    boost::optional<IoctlWait> TakePendingWait() {
+        boost::optional<IoctlWait> wait = std::move(pending_wait);
+        pending_wait = boost::none;
+        return wait;
+    }
+
+protected:
+    /**
+     * Asks for the guest thread to be put to sleep until the wait is done, instead of the ioctl
+     * returning. The ioctl is then run again, and its result is the one returned to the guest. Its
+     * output is kept as it is when the wait times out.
+     */
+    void WaitAndRetry(IoctlWait wait) {
+        pending_wait = std::move(wait);
+    }
+
+private:
+    boost::optional<IoctlWait> pending_wait;
 };
 
 } // namespace Service::Nvidia::Devices
@@ -9,6 +9,7 @@
 #include "common/common_types.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
+#include "video_core/gpu.h"
 
 namespace Service::Nvidia::Devices {
 
@@ -19,11 +20,15 @@ public:
     nvdisp_disp0(std::shared_ptr<nvmap> nvmap_dev) : nvdevice(), nvmap_dev(std::move(nvmap_dev)) {}
     ~nvdisp_disp0() = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
-    /// Performs a screen flip, drawing the buffer pointed to by the handle.
-    void flip(u32 buffer_handle, u32 offset, u32 format, u32 width, u32 height, u32 stride,
-              NVFlinger::BufferQueue::BufferTransformFlags transform);
+    /// Describes the buffer pointed to by the handle, for it to be drawn as a layer.
+    Tegra::FramebufferConfig GetFramebufferConfig(
+        u32 buffer_handle, u32 offset, u32 format, u32 width, u32 height, u32 stride,
+        NVFlinger::BufferQueue::BufferTransformFlags transform) const;
+
+    /// Performs a screen flip, drawing the layers from the bottom one to the top one.
+    void flip(const std::vector<Tegra::FramebufferConfig>& layers);
 
 private:
     std::shared_ptr<nvmap> nvmap_dev;
@@ -20,13 +20,14 @@ public:
     nvhost_as_gpu(std::shared_ptr<nvmap> nvmap_dev) : nvmap_dev(std::move(nvmap_dev)) {}
     ~nvhost_as_gpu() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
         IocInitalizeExCommand = 0x40284109,
         IocAllocateSpaceCommand = 0xC0184102,
         IocMapBufferExCommand = 0xC0284106,
+        IocUnmapBufferCommand = 0xC0084105,
         IocBindChannelCommand = 0x40044101,
         IocGetVaRegionsCommand = 0xC0404108,
     };
@@ -65,6 +66,11 @@ private:
     };
     static_assert(sizeof(IoctlMapBufferEx) == 40, "IoctlMapBufferEx is incorrect size");
 
+    struct IoctlUnmapBuffer {
+        u64_le offset;
+    };
+    static_assert(sizeof(IoctlUnmapBuffer) == 8, "IoctlUnmapBuffer is incorrect size");
+
     struct IoctlBindChannel {
         u32_le fd;
     };
@@ -89,11 +95,12 @@ private:
 
     u32 channel{};
 
-    u32 InitalizeEx(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocateSpace(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 MapBufferEx(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 BindChannel(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetVARegions(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 InitalizeEx(IoctlInput input, IoctlOutput output);
+    u32 AllocateSpace(IoctlInput input, IoctlOutput output);
+    u32 MapBufferEx(IoctlInput input, IoctlOutput output);
+    u32 UnmapBuffer(IoctlInput input, IoctlOutput output);
+    u32 BindChannel(IoctlInput input, IoctlOutput output);
+    u32 GetVARegions(IoctlInput input, IoctlOutput output);
 
     std::shared_ptr<nvmap> nvmap_dev;
 };
@@ -5,16 +5,21 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "core/hle/service/nvdrv/devices/nvhost_ctrl.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvhost_ctrl::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_ctrl::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called, command=0x%08x, input_size=0x%zx, output_size=0x%zx",
               command.raw, input.size(), output.size());
 
     switch (static_cast<IoctlCommand>(command.raw)) {
     case IoctlCommand::IocGetConfigCommand:
         return NvOsGetConfigU32(input, output);
+    case IoctlCommand::IocSyncptReadCommand:
+        return IocSyncptRead(input, output);
+    case IoctlCommand::IocSyncptReadMaxCommand:
+        return IocSyncptReadMax(input, output);
     case IoctlCommand::IocCtrlEventWaitCommand:
         return IocCtrlEventWait(input, output);
     }
@@ -22,7 +27,7 @@ u32 nvhost_ctrl::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<
     return 0;
 }
 
-u32 nvhost_ctrl::NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_ctrl::NvOsGetConfigU32(IoctlInput input, IoctlOutput output) {
     IocGetConfigParams params{};
     std::memcpy(&params, input.data(), sizeof(params));
     LOG_DEBUG(Service_NVDRV, "called, setting=%s!%s", params.domain_str.data(),
@@ -45,15 +50,59 @@ u32 nvhost_ctrl::NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>&
     return 0;
 }
 
-u32 nvhost_ctrl::IocCtrlEventWait(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_ctrl::IocSyncptRead(IoctlInput input, IoctlOutput output) {
+    IocSyncptReadParams params{};
+    std::memcpy(&params, input.data(), sizeof(params));
+    LOG_DEBUG(Service_NVDRV, "called, id=%u", params.id);
+
+    ASSERT(params.id < Tegra::MaxSyncPoints);
+    params.value = syncpoint_manager->GetSyncpointValue(params.id);
+    std::memcpy(output.data(), &params, sizeof(params));
+    return 0;
+}
+
+u32 nvhost_ctrl::IocSyncptReadMax(IoctlInput input, IoctlOutput output) {
+    IocSyncptReadParams params{};
+    std::memcpy(&params, input.data(), sizeof(params));
+    LOG_DEBUG(Service_NVDRV, "called, id=%u", params.id);
+
+    ASSERT(params.id < Tegra::MaxSyncPoints);
+    params.value = syncpoint_manager->GetSyncpointMax(params.id);
+    std::memcpy(output.data(), &params, sizeof(params));
+    return 0;
+}
+
+u32 nvhost_ctrl::IocCtrlEventWait(IoctlInput input, IoctlOutput output) {
     IocCtrlEventWaitParams params{};
     std::memcpy(&params, input.data(), sizeof(params));
-    LOG_WARNING(Service_NVDRV, "(STUBBED) called, syncpt_id=%u threshold=%u timeout=%d",
-                params.syncpt_id, params.threshold, params.timeout);
+    LOG_DEBUG(Service_NVDRV, "called, syncpt_id=%u threshold=%u timeout=%d", params.syncpt_id,
+              params.threshold, params.timeout);
 
-    // TODO(Subv): Implement actual syncpt waiting.
-    params.value = 0;
+    ASSERT(params.syncpt_id < Tegra::MaxSyncPoints);
+    const u32 syncpt_id = params.syncpt_id;
+    const u32 threshold = params.threshold;
+    params.value = syncpoint_manager->GetSyncpointValue(syncpt_id);
     std::memcpy(output.data(), &params, sizeof(params));
+
+    if (syncpoint_manager->IsSyncpointExpired(syncpt_id, threshold)) {
+        return 0;
+    }
+    if (params.timeout == 0) {
+        return NvErrorTimeout;
+    }
+
+    // The guest thread sleeps on a kernel event until the GPU reaches the threshold. A negative
+    // timeout waits for as long as it takes.
+    IoctlWait wait;
+    wait.add_waiter = [syncpoint_manager = syncpoint_manager, syncpt_id,
+                       threshold](Kernel::SharedPtr<Kernel::Event> event) {
+        return syncpoint_manager->AddWaiter(syncpt_id, threshold, std::move(event));
+    };
+    wait.remove_waiter = [syncpoint_manager = syncpoint_manager](u64 waiter_id) {
+        syncpoint_manager->RemoveWaiter(waiter_id);
+    };
+    wait.timeout_ns = params.timeout < 0 ? 0 : static_cast<u64>(params.timeout) * 1000000;
+    WaitAndRetry(std::move(wait));
     return 0;
 }
 
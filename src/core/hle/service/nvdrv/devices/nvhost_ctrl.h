@@ -7,18 +7,23 @@
 #include <array>
 #include <cstdlib>
 #include <cstring>
-#include <vector>
+#include <memory>
 #include "common/common_types.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 
+namespace Service::Nvidia {
+class SyncpointManager;
+}
+
 namespace Service::Nvidia::Devices {
 
 class nvhost_ctrl final : public nvdevice {
 public:
-    nvhost_ctrl() = default;
+    explicit nvhost_ctrl(std::shared_ptr<SyncpointManager> syncpoint_manager)
+        : syncpoint_manager(std::move(syncpoint_manager)) {}
     ~nvhost_ctrl() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -40,6 +45,12 @@ private:
     };
     static_assert(sizeof(IocGetConfigParams) == 387, "IocGetConfigParams is incorrect size");
 
+    struct IocSyncptReadParams {
+        u32_le id;
+        u32_le value;
+    };
+    static_assert(sizeof(IocSyncptReadParams) == 8, "IocSyncptReadParams is incorrect size");
+
     struct IocCtrlEventWaitParams {
         u32_le syncpt_id;
         u32_le threshold;
@@ -48,9 +59,15 @@ private:
     };
     static_assert(sizeof(IocCtrlEventWaitParams) == 16, "IocCtrlEventWaitParams is incorrect size");
 
-    u32 NvOsGetConfigU32(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 NvOsGetConfigU32(IoctlInput input, IoctlOutput output);
+
+    u32 IocSyncptRead(IoctlInput input, IoctlOutput output);
+
+    u32 IocSyncptReadMax(IoctlInput input, IoctlOutput output);
+
+    u32 IocCtrlEventWait(IoctlInput input, IoctlOutput output);
 
-    u32 IocCtrlEventWait(const std::vector<u8>& input, std::vector<u8>& output);
+    std::shared_ptr<SyncpointManager> syncpoint_manager;
 };
 
 } // namespace Service::Nvidia::Devices
@@ -16,7 +16,7 @@ public:
     nvhost_ctrl_gpu() = default;
     ~nvhost_ctrl_gpu() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -117,11 +117,11 @@ private:
     static_assert(sizeof(IoctlNvgpuGpuZcullGetInfoArgs) == 40,
                   "IoctlNvgpuGpuZcullGetInfoArgs is incorrect size");
 
-    u32 GetCharacteristics(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetTPCMasks(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetActiveSlotMask(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 ZCullGetCtxSize(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 ZCullGetInfo(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 GetCharacteristics(IoctlInput input, IoctlOutput output);
+    u32 GetTPCMasks(IoctlInput input, IoctlOutput output);
+    u32 GetActiveSlotMask(IoctlInput input, IoctlOutput output);
+    u32 ZCullGetCtxSize(IoctlInput input, IoctlOutput output);
+    u32 ZCullGetInfo(IoctlInput input, IoctlOutput output);
 };
 
 } // namespace Service::Nvidia::Devices
@@ -8,10 +8,17 @@
 #include "common/logging/log.h"
 #include "core/core.h"
 #include "core/hle/service/nvdrv/devices/nvhost_gpu.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
 
 namespace Service::Nvidia::Devices {
 
-u32 nvhost_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+nvhost_gpu::nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev,
+                       std::shared_ptr<SyncpointManager> syncpoint_manager)
+    : nvmap_dev(std::move(nvmap_dev)), syncpoint_manager(std::move(syncpoint_manager)) {
+    syncpoint_id = this->syncpoint_manager->AllocateSyncpoint();
+}
+
+u32 nvhost_gpu::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called, command=0x%08x, input_size=0x%zx, output_size=0x%zx",
               command.raw, input.size(), output.size());
 
@@ -44,7 +51,7 @@ u32 nvhost_gpu::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u
     return 0;
 };
 
-u32 nvhost_gpu::SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetNVMAPfd(IoctlInput input, IoctlOutput output) {
     IoctlSetNvmapFD params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, fd=%x", params.nvmap_fd);
@@ -53,7 +60,7 @@ u32 nvhost_gpu::SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output
     return 0;
 }
 
-u32 nvhost_gpu::SetClientData(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetClientData(IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called");
     IoctlClientData params{};
     std::memcpy(&params, input.data(), input.size());
@@ -62,7 +69,7 @@ u32 nvhost_gpu::SetClientData(const std::vector<u8>& input, std::vector<u8>& out
     return 0;
 }
 
-u32 nvhost_gpu::GetClientData(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::GetClientData(IoctlInput input, IoctlOutput output) {
     LOG_DEBUG(Service_NVDRV, "called");
     IoctlClientData params{};
     std::memcpy(&params, input.data(), input.size());
@@ -71,7 +78,7 @@ u32 nvhost_gpu::GetClientData(const std::vector<u8>& input, std::vector<u8>& out
     return 0;
 }
 
-u32 nvhost_gpu::ZCullBind(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::ZCullBind(IoctlInput input, IoctlOutput output) {
     std::memcpy(&zcull_params, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "called, gpu_va=%" PRIx64 ", mode=%x", zcull_params.gpu_va,
               zcull_params.mode);
@@ -79,7 +86,7 @@ u32 nvhost_gpu::ZCullBind(const std::vector<u8>& input, std::vector<u8>& output)
     return 0;
 }
 
-u32 nvhost_gpu::SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetErrorNotifier(IoctlInput input, IoctlOutput output) {
     IoctlSetErrorNotifier params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, offset=%" PRIx64 ", size=%" PRIx64 ", mem=%x",
@@ -88,27 +95,27 @@ u32 nvhost_gpu::SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>&
     return 0;
 }
 
-u32 nvhost_gpu::SetChannelPriority(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SetChannelPriority(IoctlInput input, IoctlOutput output) {
     std::memcpy(&channel_priority, input.data(), input.size());
     LOG_DEBUG(Service_NVDRV, "(STUBBED) called, priority=%x", channel_priority);
     std::memcpy(output.data(), &channel_priority, output.size());
     return 0;
 }
 
-u32 nvhost_gpu::AllocGPFIFOEx2(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::AllocGPFIFOEx2(IoctlInput input, IoctlOutput output) {
     IoctlAllocGpfifoEx2 params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV,
                 "(STUBBED) called, num_entries=%x, flags=%x, unk0=%x, unk1=%x, unk2=%x, unk3=%x",
                 params.num_entries, params.flags, params.unk0, params.unk1, params.unk2,
                 params.unk3);
-    params.fence_out.id = 0;
-    params.fence_out.value = 0;
+    params.fence_out.id = syncpoint_id;
+    params.fence_out.value = syncpoint_manager->GetSyncpointMax(syncpoint_id);
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
 
-u32 nvhost_gpu::AllocateObjectContext(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::AllocateObjectContext(IoctlInput input, IoctlOutput output) {
     IoctlAllocObjCtx params{};
     std::memcpy(&params, input.data(), input.size());
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, class_num=%x, flags=%x", params.class_num,
@@ -118,7 +125,7 @@ u32 nvhost_gpu::AllocateObjectContext(const std::vector<u8>& input, std::vector<
     return 0;
 }
 
-u32 nvhost_gpu::SubmitGPFIFO(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvhost_gpu::SubmitGPFIFO(IoctlInput input, IoctlOutput output) {
     if (input.size() < sizeof(IoctlSubmitGpfifo))
         UNIMPLEMENTED();
     IoctlSubmitGpfifo params{};
@@ -126,16 +133,23 @@ u32 nvhost_gpu::SubmitGPFIFO(const std::vector<u8>& input, std::vector<u8>& outp
     LOG_WARNING(Service_NVDRV, "(STUBBED) called, gpfifo=%" PRIx64 ", num_entries=%x, flags=%x",
                 params.gpfifo, params.num_entries, params.flags);
 
-    auto entries = std::vector<IoctlGpfifoEntry>();
-    entries.resize(params.num_entries);
-    std::memcpy(&entries[0], &input.data()[sizeof(IoctlSubmitGpfifo)],
-                params.num_entries * sizeof(IoctlGpfifoEntry));
-    for (auto entry : entries) {
-        VAddr va_addr = entry.Address();
-        Core::System::GetInstance().GPU().ProcessCommandList(va_addr, entry.sz);
+    // The entries are handed to the GPU straight from the input buffer
+    ASSERT(input.size() >=
+           sizeof(IoctlSubmitGpfifo) + params.num_entries * sizeof(IoctlGpfifoEntry));
+    const u8* entry_data = input.data() + sizeof(IoctlSubmitGpfifo);
+    auto& gpu = Core::System::GetInstance().GPU();
+    for (u32 i = 0; i < params.num_entries; ++i, entry_data += sizeof(IoctlGpfifoEntry)) {
+        IoctlGpfifoEntry entry;
+        std::memcpy(&entry, entry_data, sizeof(entry));
+        gpu.PushCommandList(entry.Address(), entry.sz);
     }
-    params.fence_out.id = 0;
-    params.fence_out.value = 0;
+
+    // The GPU increments the channel's syncpoint once it has processed the entries, and the fence
+    // handed back is the value it then reaches. Fences to wait for before the entries are already
+    // honored for this channel, as the GPU processes its submissions in order.
+    params.fence_out.id = syncpoint_id;
+    params.fence_out.value = syncpoint_manager->IncreaseSyncpointMax(syncpoint_id, 1);
+    gpu.IncrementSyncPoint(syncpoint_id);
     std::memcpy(output.data(), &params, output.size());
     return 0;
 }
@@ -10,6 +10,10 @@
 #include "common/swap.h"
 #include "core/hle/service/nvdrv/devices/nvdevice.h"
 
+namespace Service::Nvidia {
+class SyncpointManager;
+}
+
 namespace Service::Nvidia::Devices {
 
 class nvmap;
@@ -18,10 +22,11 @@ constexpr u32 NVGPU_IOCTL_CHANNEL_SUBMIT_GPFIFO(0x8);
 
 class nvhost_gpu final : public nvdevice {
 public:
-    nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev) : nvmap_dev(std::move(nvmap_dev)) {}
+    nvhost_gpu(std::shared_ptr<nvmap> nvmap_dev,
+               std::shared_ptr<SyncpointManager> syncpoint_manager);
     ~nvhost_gpu() override = default;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
 private:
     enum class IoctlCommand : u32_le {
@@ -124,17 +129,20 @@ private:
     IoctlZCullBind zcull_params{};
     u32_le channel_priority{};
 
-    u32 SetNVMAPfd(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetClientData(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 GetClientData(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 ZCullBind(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetErrorNotifier(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SetChannelPriority(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocGPFIFOEx2(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 AllocateObjectContext(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 SubmitGPFIFO(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 SetNVMAPfd(IoctlInput input, IoctlOutput output);
+    u32 SetClientData(IoctlInput input, IoctlOutput output);
+    u32 GetClientData(IoctlInput input, IoctlOutput output);
+    u32 ZCullBind(IoctlInput input, IoctlOutput output);
+    u32 SetErrorNotifier(IoctlInput input, IoctlOutput output);
+    u32 SetChannelPriority(IoctlInput input, IoctlOutput output);
+    u32 AllocGPFIFOEx2(IoctlInput input, IoctlOutput output);
+    u32 AllocateObjectContext(IoctlInput input, IoctlOutput output);
+    u32 SubmitGPFIFO(IoctlInput input, IoctlOutput output);
 
     std::shared_ptr<nvmap> nvmap_dev;
+    std::shared_ptr<SyncpointManager> syncpoint_manager;
+    /// Syncpoint the channel increments after each submission
+    u32 syncpoint_id;
 };
 
 } // namespace Service::Nvidia::Devices
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <cinttypes>
+#include <iterator>
 
 #include "common/assert.h"
 #include "common/logging/log.h"
@@ -18,7 +19,7 @@ VAddr nvmap::GetObjectAddress(u32 handle) const {
     return object->addr;
 }
 
-u32 nvmap::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::ioctl(Ioctl command, IoctlInput input, IoctlOutput output) {
     switch (static_cast<IoctlCommand>(command.raw)) {
     case IoctlCommand::Create:
         return IocCreate(input, output);
@@ -36,7 +37,7 @@ u32 nvmap::ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& o
     return 0;
 }
 
-u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocCreate(IoctlInput input, IoctlOutput output) {
     IocCreateParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -46,8 +47,8 @@ u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
     object->size = params.size;
     object->status = Object::Status::Created;
 
-    u32 handle = next_handle++;
-    handles[handle] = std::move(object);
+    handles.push_back(std::move(object));
+    const u32 handle = static_cast<u32>(handles.size());
 
     LOG_DEBUG(Service_NVDRV, "size=0x%08X", params.size);
 
@@ -57,7 +58,7 @@ u32 nvmap::IocCreate(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocAlloc(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocAlloc(IoctlInput input, IoctlOutput output) {
     IocAllocParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -76,7 +77,7 @@ u32 nvmap::IocAlloc(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocGetId(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocGetId(IoctlInput input, IoctlOutput output) {
     IocGetIdParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
@@ -91,24 +92,24 @@ u32 nvmap::IocGetId(const std::vector<u8>& input, std::vector<u8>& output) {
     return 0;
 }
 
-u32 nvmap::IocFromId(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocFromId(IoctlInput input, IoctlOutput output) {
     IocFromIdParams params;
     std::memcpy(&params, input.data(), sizeof(params));
 
     LOG_WARNING(Service_NVDRV, "(STUBBED) called");
 
     auto itr = std::find_if(handles.begin(), handles.end(),
-                            [&](const auto& entry) { return entry.second->id == params.id; });
+                            [&](const auto& object) { return object->id == params.id; });
     ASSERT(itr != handles.end());
 
     // Return the existing handle instead of creating a new one.
-    params.handle = itr->first;
+    params.handle = static_cast<u32>(std::distance(handles.begin(), itr) + 1);
 
     std::memcpy(output.data(), &params, sizeof(params));
     return 0;
 }
 
-u32 nvmap::IocParam(const std::vector<u8>& input, std::vector<u8>& output) {
+u32 nvmap::IocParam(IoctlInput input, IoctlOutput output) {
     enum class ParamTypes { Size = 1, Alignment = 2, Base = 3, Heap = 4, Kind = 5, Compr = 6 };
 
     IocParamParams params;
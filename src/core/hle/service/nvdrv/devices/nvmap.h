@@ -5,7 +5,6 @@
 #pragma once
 
 #include <memory>
-#include <unordered_map>
 #include <vector>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
@@ -22,7 +21,7 @@ public:
     /// Returns the allocated address of an nvmap object given its handle.
     VAddr GetObjectAddress(u32 handle) const;
 
-    u32 ioctl(Ioctl command, const std::vector<u8>& input, std::vector<u8>& output) override;
+    u32 ioctl(Ioctl command, IoctlInput input, IoctlOutput output) override;
 
     /// Represents an nvmap object.
     struct Object {
@@ -37,22 +36,19 @@ public:
     };
 
     std::shared_ptr<Object> GetObject(u32 handle) const {
-        auto itr = handles.find(handle);
-        if (itr != handles.end()) {
-            return itr->second;
+        if (handle == 0 || handle > handles.size()) {
+            return {};
         }
-        return {};
+        return handles[handle - 1];
     }
 
 private:
-    /// Id to use for the next handle that is created.
-    u32 next_handle = 1;
-
     /// Id to use for the next object that is created.
     u32 next_id = 1;
 
-    /// Mapping of currently allocated handles to the objects they represent.
-    std::unordered_map<u32, std::shared_ptr<Object>> handles;
+    /// Objects by their handle minus one. Handles are never freed, so they are dense and the
+    /// lookups done for every mapping and submission are a bounds check and an index.
+    std::vector<std::shared_ptr<Object>> handles;
 
     enum class IoctlCommand : u32 {
         Create = 0xC0080101,
@@ -102,11 +98,11 @@ private:
         u32_le value;
     };
 
-    u32 IocCreate(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocAlloc(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocGetId(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocFromId(const std::vector<u8>& input, std::vector<u8>& output);
-    u32 IocParam(const std::vector<u8>& input, std::vector<u8>& output);
+    u32 IocCreate(IoctlInput input, IoctlOutput output);
+    u32 IocAlloc(IoctlInput input, IoctlOutput output);
+    u32 IocGetId(IoctlInput input, IoctlOutput output);
+    u32 IocFromId(IoctlInput input, IoctlOutput output);
+    u32 IocParam(IoctlInput input, IoctlOutput output);
 };
 
 } // namespace Service::Nvidia::Devices
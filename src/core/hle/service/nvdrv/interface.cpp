@@ -6,11 +6,43 @@
 #include "common/logging/log.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/event.h"
+#include "core/hle/kernel/thread.h"
 #include "core/hle/service/nvdrv/interface.h"
 #include "core/hle/service/nvdrv/nvdrv.h"
 
 namespace Service::Nvidia {
 
+namespace {
+
+/// Runs an ioctl on the buffers of the request, and returns its result
+u32 RunIoctl(Module& nvdrv, Kernel::HLERequestContext& ctx, u32 fd, u32 command) {
+    // The ioctl works on the buffers in place, and they are only copied when they aren't
+    // contiguous in host memory.
+    const size_t input_size = ctx.GetReadBufferSize();
+    const size_t output_size = ctx.GetWriteBufferSize();
+    std::vector<u8> input_copy;
+    const u8* input = ctx.GetReadBufferPointer();
+    if (input == nullptr && input_size != 0) {
+        input_copy = ctx.ReadBuffer();
+        input = input_copy.data();
+    }
+    std::vector<u8> output_copy;
+    u8* output = ctx.GetWriteBufferPointer(output_size);
+    if (output == nullptr && output_size != 0) {
+        output_copy.resize(output_size);
+        output = output_copy.data();
+    }
+
+    const u32 result = nvdrv.Ioctl(fd, command, {input, input_size}, {output, output_size});
+
+    if (!output_copy.empty()) {
+        ctx.WriteBuffer(output_copy);
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
 void NVDRV::Open(Kernel::HLERequestContext& ctx) {
     LOG_DEBUG(Service_NVDRV, "called");
 
@@ -31,13 +63,33 @@ void NVDRV::Ioctl(Kernel::HLERequestContext& ctx) {
     u32 fd = rp.Pop<u32>();
     u32 command = rp.Pop<u32>();
 
-    std::vector<u8> output(ctx.GetWriteBufferSize());
+    const u32 result = RunIoctl(*nvdrv, ctx, fd, command);
+
+    if (auto wait = nvdrv->TakePendingWait(fd)) {
+        // The guest thread sleeps until the ioctl can complete, which then runs again
+        auto waiter_id = std::make_shared<u64>();
+        auto event = ctx.SleepClientThread(
+            Kernel::GetCurrentThread(), "NVDRV::Ioctl", wait->timeout_ns,
+            [nvdrv = nvdrv, fd, command, remove_waiter = wait->remove_waiter,
+             waiter_id](Kernel::SharedPtr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
+                        ThreadWakeupReason reason) {
+                u32 result = Devices::NvErrorTimeout;
+                if (reason == ThreadWakeupReason::Signal) {
+                    result = RunIoctl(*nvdrv, ctx, fd, command);
+                    nvdrv->TakePendingWait(fd);
+                } else if (remove_waiter) {
+                    remove_waiter(*waiter_id);
+                }
+                IPC::ResponseBuilder rb{ctx, 3};
+                rb.Push(RESULT_SUCCESS);
+                rb.Push(result);
+            });
+        *waiter_id = wait->add_waiter(event);
+    }
 
     IPC::ResponseBuilder rb{ctx, 3};
     rb.Push(RESULT_SUCCESS);
-    rb.Push(nvdrv->Ioctl(fd, command, ctx.ReadBuffer(), output));
-
-    ctx.WriteBuffer(output);
+    rb.Push(result);
 }
 
 void NVDRV::Close(Kernel::HLERequestContext& ctx) {
@@ -8,14 +8,11 @@
 #include <unordered_map>
 #include <vector>
 #include "common/common_types.h"
+#include "core/hle/service/nvdrv/devices/nvdevice.h"
 #include "core/hle/service/service.h"
 
 namespace Service::Nvidia {
 
-namespace Devices {
-class nvdevice;
-}
-
 struct IoctlFence {
     u32 id;
     u32 value;
@@ -40,7 +37,9 @@ public:
     /// Opens a device node and returns a file descriptor to it.
     u32 Open(std::string device_name);
     /// Sends an ioctl command to the specified file descriptor.
-    u32 Ioctl(u32 fd, u32 command, const std::vector<u8>& input, std::vector<u8>& output);
+    u32 Ioctl(u32 fd, u32 command, Devices::IoctlInput input, Devices::IoctlOutput output);
+    /// Returns the wait the last ioctl to the file descriptor asked for, if it did, and clears it.
+    boost::optional<Devices::IoctlWait> TakePendingWait(u32 fd);
     /// Closes a device file descriptor and returns operation success.
     ResultCode Close(u32 fd);
 
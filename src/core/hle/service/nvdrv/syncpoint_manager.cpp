@@ -0,0 +1,95 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/service/nvdrv/syncpoint_manager.h"
+
+namespace Service::Nvidia {
+
+SyncpointManager::SyncpointManager() {
+    increment_event = CoreTiming::RegisterEvent(
+        "SyncpointIncrement",
+        [this](u64 syncpoint_id, int) { OnSyncpointIncremented(static_cast<u32>(syncpoint_id)); });
+
+    Core::System::GetInstance().GPU().SetSyncPointCallback([this](u32 syncpoint_id) {
+        // Only the CPU thread empties the queue of threadsafe events, so it can't wait on it.
+        if (!Core::System::GetInstance().GPU().IsGPUThread()) {
+            OnSyncpointIncremented(syncpoint_id);
+            return;
+        }
+        CoreTiming::ScheduleEventThreadsafe(0, increment_event, syncpoint_id);
+    });
+}
+
+SyncpointManager::~SyncpointManager() {
+    Core::System::GetInstance().GPU().SetSyncPointCallback(nullptr);
+}
+
+u32 SyncpointManager::AllocateSyncpoint() {
+    ASSERT_MSG(next_syncpoint_id < Tegra::MaxSyncPoints, "All the syncpoints are allocated");
+    return next_syncpoint_id++;
+}
+
+u32 SyncpointManager::IncreaseSyncpointMax(u32 syncpoint_id, u32 increments) {
+    ASSERT(syncpoint_id < Tegra::MaxSyncPoints);
+    return syncpoint_max[syncpoint_id] += increments;
+}
+
+u32 SyncpointManager::GetSyncpointMax(u32 syncpoint_id) const {
+    ASSERT(syncpoint_id < Tegra::MaxSyncPoints);
+    return syncpoint_max[syncpoint_id];
+}
+
+u32 SyncpointManager::GetSyncpointValue(u32 syncpoint_id) const {
+    return Core::System::GetInstance().GPU().GetSyncPointValue(syncpoint_id);
+}
+
+bool SyncpointManager::IsSyncpointExpired(u32 syncpoint_id, u32 threshold) const {
+    // Syncpoints wrap around, so the threshold is compared within half of their range.
+    return static_cast<s32>(GetSyncpointValue(syncpoint_id) - threshold) >= 0;
+}
+
+u64 SyncpointManager::AddWaiter(u32 syncpoint_id, u32 threshold,
+                                Kernel::SharedPtr<Kernel::Event> event) {
+    const u64 waiter_id = next_waiter_id++;
+    // Increments the GPU thread does after this check reach the CPU thread after the waiter is
+    // added, so none of them is missed.
+    if (IsSyncpointExpired(syncpoint_id, threshold)) {
+        event->Signal();
+        return waiter_id;
+    }
+
+    // The waiters no thread waits for anymore, as their threads were stopped, are dropped.
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                 [](const Waiter& waiter) {
+                                     return waiter.event->GetWaitingThreads().empty();
+                                 }),
+                  waiters.end());
+    waiters.push_back({waiter_id, syncpoint_id, threshold, std::move(event)});
+    return waiter_id;
+}
+
+void SyncpointManager::RemoveWaiter(u64 waiter_id) {
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(),
+                                 [waiter_id](const Waiter& waiter) {
+                                     return waiter.id == waiter_id;
+                                 }),
+                  waiters.end());
+}
+
+void SyncpointManager::OnSyncpointIncremented(u32 syncpoint_id) {
+    const auto end = std::partition(waiters.begin(), waiters.end(), [&](const Waiter& waiter) {
+        return waiter.syncpoint_id != syncpoint_id ||
+               !IsSyncpointExpired(syncpoint_id, waiter.threshold);
+    });
+    for (auto it = end; it != waiters.end(); ++it) {
+        it->event->Signal();
+    }
+    waiters.erase(end, waiters.end());
+}
+
+} // namespace Service::Nvidia
@@ -0,0 +1,81 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/kernel/event.h"
+#include "video_core/gpu.h"
+
+namespace CoreTiming {
+struct EventType;
+}
+
+namespace Service::Nvidia {
+
+/**
+ * Tracks the syncpoints of the host1x for the nvhost devices. The GPU increments the syncpoints as
+ * it retires the command lists, while the fences handed to the guest are given out here, by
+ * reserving increments of them. Threads waiting for a fence sleep on a kernel event that is
+ * signaled once the GPU has reached it.
+ */
+class SyncpointManager final {
+public:
+    SyncpointManager();
+    ~SyncpointManager();
+
+    /// Allocates a syncpoint for a channel, and returns its id.
+    u32 AllocateSyncpoint();
+
+    /**
+     * Reserves increments of a syncpoint.
+     * @returns The value the syncpoint has once the GPU has done all the increments reserved so far.
+     */
+    u32 IncreaseSyncpointMax(u32 syncpoint_id, u32 increments);
+
+    /// Returns the highest value reserved for a syncpoint.
+    u32 GetSyncpointMax(u32 syncpoint_id) const;
+
+    /// Returns the value the GPU has incremented a syncpoint to so far.
+    u32 GetSyncpointValue(u32 syncpoint_id) const;
+
+    /// Returns whether the GPU has incremented a syncpoint up to the threshold, or past it.
+    bool IsSyncpointExpired(u32 syncpoint_id, u32 threshold) const;
+
+    /**
+     * Signals the event once the GPU has incremented the syncpoint up to the threshold, or right
+     * away when it already has.
+     * @returns Id of the waiter, to remove it with RemoveWaiter.
+     */
+    u64 AddWaiter(u32 syncpoint_id, u32 threshold, Kernel::SharedPtr<Kernel::Event> event);
+
+    /// Removes a waiter whose wait ended without its event being signaled, as it timed out.
+    void RemoveWaiter(u64 waiter_id);
+
+private:
+    struct Waiter {
+        u64 id;
+        u32 syncpoint_id;
+        u32 threshold;
+        Kernel::SharedPtr<Kernel::Event> event;
+    };
+
+    /// Signals the waiters of a syncpoint that has been incremented, on the CPU thread.
+    void OnSyncpointIncremented(u32 syncpoint_id);
+
+    std::array<u32, Tegra::MaxSyncPoints> syncpoint_max{};
+    /// Id to use for the next syncpoint that is allocated. The lowest ones are reserved.
+    u32 next_syncpoint_id = 1;
+
+    std::vector<Waiter> waiters;
+    /// Id to give to the next waiter that is added.
+    u64 next_waiter_id = 0;
+
+    /// CoreTiming event that moves the increments done by the GPU thread over to the CPU thread.
+    CoreTiming::EventType* increment_event;
+};
+
+} // namespace Service::Nvidia
@@ -68,6 +68,10 @@ void BufferQueue::QueueBuffer(u32 slot, BufferTransformFlags transform) {
     ASSERT(itr->status == Buffer::Status::Dequeued);
     itr->status = Buffer::Status::Queued;
     itr->transform = transform;
+
+    if (buffer_queued_callback) {
+        buffer_queued_callback();
+    }
 }
 
 boost::optional<const BufferQueue::Buffer&> BufferQueue::AcquireBuffer() {
@@ -110,4 +114,8 @@ void BufferQueue::SetBufferWaitEvent(Kernel::SharedPtr<Kernel::Event>&& wait_eve
     buffer_wait_event = std::move(wait_event);
 }
 
+void BufferQueue::SetBufferQueuedCallback(std::function<void()> callback) {
+    buffer_queued_callback = std::move(callback);
+}
+
 } // namespace Service::NVFlinger
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <vector>
 #include <boost/optional.hpp>
 #include "common/swap.h"
@@ -78,6 +79,9 @@ public:
     u32 Query(QueryType type);
     void SetBufferWaitEvent(Kernel::SharedPtr<Kernel::Event>&& wait_event);
 
+    /// Sets the function called whenever a buffer is queued, for it to be composed.
+    void SetBufferQueuedCallback(std::function<void()> callback);
+
     u32 GetId() const {
         return id;
     }
@@ -95,6 +99,8 @@ private:
 
     /// Used to signal waiting thread when no buffers are available
     Kernel::SharedPtr<Kernel::Event> buffer_wait_event;
+
+    std::function<void()> buffer_queued_callback;
 };
 
 } // namespace Service::NVFlinger
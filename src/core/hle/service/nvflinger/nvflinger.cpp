@@ -3,18 +3,18 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cinttypes>
 
 #include "common/alignment.h"
 #include "common/microprofile.h"
-#include "common/scope_exit.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/nvdrv/devices/nvdisp_disp0.h"
 #include "core/hle/service/nvdrv/nvdrv.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 #include "core/hle/service/nvflinger/nvflinger.h"
-#include "video_core/renderer_base.h"
-#include "video_core/video_core.h"
+#include "core/settings.h"
+#include "video_core/gpu.h"
 
 namespace Service::NVFlinger {
 
@@ -36,15 +36,21 @@ NVFlinger::NVFlinger() {
     // Schedule the screen composition events
     composition_event =
         CoreTiming::RegisterEvent("ScreenCompositioin", [this](u64 userdata, int cycles_late) {
-            Compose();
+            OnVSync();
             CoreTiming::ScheduleEvent(frame_ticks - cycles_late, composition_event);
         });
+    present_event = CoreTiming::RegisterEvent("ScreenPresent", [this](u64 userdata, int) {
+        present_scheduled = false;
+        presented_since_vsync = true;
+        Compose();
+    });
 
     CoreTiming::ScheduleEvent(frame_ticks, composition_event);
 }
 
 NVFlinger::~NVFlinger() {
     CoreTiming::UnscheduleEvent(composition_event, 0);
+    CoreTiming::UnscheduleEvent(present_event, 0);
 }
 
 u64 NVFlinger::OpenDisplay(const std::string& name) {
@@ -64,16 +70,32 @@ u64 NVFlinger::OpenDisplay(const std::string& name) {
 u64 NVFlinger::CreateLayer(u64 display_id) {
     auto& display = GetDisplay(display_id);
 
-    ASSERT_MSG(display.layers.empty(), "Only one layer is supported per display at the moment");
-
     u64 layer_id = next_layer_id++;
     u32 buffer_queue_id = next_buffer_queue_id++;
     auto buffer_queue = std::make_shared<BufferQueue>(buffer_queue_id, layer_id);
+    buffer_queue->SetBufferQueuedCallback([this] { OnBufferQueued(); });
     display.layers.emplace_back(layer_id, buffer_queue);
     buffer_queues.emplace_back(std::move(buffer_queue));
     return layer_id;
 }
 
+void NVFlinger::SetLayerZ(u64 layer_id, u64 z) {
+    for (auto& display : displays) {
+        auto itr = std::find_if(display.layers.begin(), display.layers.end(),
+                                [&](const Layer& layer) { return layer.id == layer_id; });
+        if (itr == display.layers.end()) {
+            continue;
+        }
+
+        itr->z = z;
+        std::stable_sort(display.layers.begin(), display.layers.end(),
+                         [](const Layer& a, const Layer& b) { return a.z < b.z; });
+        return;
+    }
+
+    UNREACHABLE_MSG("Layer 0x%" PRIx64 " does not exist", layer_id);
+}
+
 u32 NVFlinger::GetBufferQueueId(u64 display_id, u64 layer_id) {
     const auto& layer = GetLayer(display_id, layer_id);
     return layer.buffer_queue->GetId();
@@ -110,36 +132,33 @@ Layer& NVFlinger::GetLayer(u64 display_id, u64 layer_id) {
     return *itr;
 }
 
-void NVFlinger::Compose() {
+void NVFlinger::OnVSync() {
+    // With variable refresh, the buffers have been composed as they were queued. The frame is
+    // then only ended here when none were.
+    if (!presented_since_vsync) {
+        Compose();
+    }
+    presented_since_vsync = false;
+
     for (auto& display : displays) {
-        // Trigger vsync for this display at the end of drawing
-        SCOPE_EXIT({ display.vsync_event->Signal(); });
+        display.vsync_event->Signal();
+    }
+}
 
+void NVFlinger::OnBufferQueued() {
+    if (!Settings::values.use_variable_refresh || present_scheduled) {
+        return;
+    }
+    present_scheduled = true;
+    CoreTiming::ScheduleEvent(0, present_event);
+}
+
+void NVFlinger::Compose() {
+    for (auto& display : displays) {
         // Don't do anything for displays without layers.
         if (display.layers.empty())
             continue;
 
-        // TODO(Subv): Support more than 1 layer.
-        ASSERT_MSG(display.layers.size() == 1, "Max 1 layer per display is supported");
-
-        Layer& layer = display.layers[0];
-        auto& buffer_queue = layer.buffer_queue;
-
-        // Search for a queued buffer and acquire it
-        auto buffer = buffer_queue->AcquireBuffer();
-
-        MicroProfileFlip();
-
-        if (buffer == boost::none) {
-            // There was no queued buffer to draw, render previous frame
-            Core::System::GetInstance().perf_stats.EndGameFrame();
-            VideoCore::g_renderer->SwapBuffers({});
-            continue;
-        }
-
-        auto& igbp_buffer = buffer->igbp_buffer;
-
-        // Now send the buffer to the GPU for drawing.
         auto nvdrv = Nvidia::nvdrv.lock();
         ASSERT(nvdrv);
 
@@ -148,13 +167,45 @@ void NVFlinger::Compose() {
         auto nvdisp = nvdrv->GetDevice<Nvidia::Devices::nvdisp_disp0>("/dev/nvdisp_disp0");
         ASSERT(nvdisp);
 
-        nvdisp->flip(igbp_buffer.gpu_buffer_id, igbp_buffer.offset, igbp_buffer.format,
-                     igbp_buffer.width, igbp_buffer.height, igbp_buffer.stride, buffer->transform);
+        MicroProfileFlip();
 
-        buffer_queue->ReleaseBuffer(buffer->slot);
+        // Search each layer for a queued buffer and acquire it. The layers without one keep
+        // showing their last buffer.
+        bool has_new_buffer = false;
+        for (auto& layer : display.layers) {
+            auto& buffer_queue = layer.buffer_queue;
+            auto buffer = buffer_queue->AcquireBuffer();
+            if (buffer == boost::none) {
+                continue;
+            }
+
+            auto& igbp_buffer = buffer->igbp_buffer;
+            layer.framebuffer = nvdisp->GetFramebufferConfig(
+                igbp_buffer.gpu_buffer_id, igbp_buffer.offset, igbp_buffer.format,
+                igbp_buffer.width, igbp_buffer.height, igbp_buffer.stride, buffer->transform);
+            has_new_buffer = true;
+
+            buffer_queue->ReleaseBuffer(buffer->slot);
+
+            // TODO(Subv): Figure out when we should actually signal this event.
+            buffer_queue->GetNativeHandle()->Signal();
+        }
 
-        // TODO(Subv): Figure out when we should actually signal this event.
-        buffer_queue->GetNativeHandle()->Signal();
+        if (!has_new_buffer) {
+            // There was no queued buffer to draw, render previous frame
+            Core::System::GetInstance().perf_stats.EndGameFrame();
+            Core::System::GetInstance().GPU().SwapBuffers({});
+            continue;
+        }
+
+        // Now send the layers to the GPU, which draws them from the bottom one up.
+        std::vector<Tegra::FramebufferConfig> framebuffers;
+        for (const auto& layer : display.layers) {
+            if (layer.framebuffer) {
+                framebuffers.push_back(*layer.framebuffer);
+            }
+        }
+        nvdisp->flip(framebuffers);
     }
 }
 
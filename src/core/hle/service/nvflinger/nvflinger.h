@@ -7,6 +7,7 @@
 #include <memory>
 #include <boost/optional.hpp>
 #include "core/hle/kernel/event.h"
+#include "video_core/gpu.h"
 
 namespace CoreTiming {
 struct EventType;
@@ -22,6 +23,10 @@ struct Layer {
 
     u64 id;
     std::shared_ptr<BufferQueue> buffer_queue;
+    /// Layers with a higher z value are drawn over the ones with a lower one.
+    u64 z = 0;
+    /// The last buffer queued to the layer, which is drawn again until a new one is queued.
+    boost::optional<Tegra::FramebufferConfig> framebuffer;
 };
 
 struct Display {
@@ -31,6 +36,7 @@ struct Display {
     u64 id;
     std::string name;
 
+    /// Kept sorted by their z value, from the bottom layer to the top one.
     std::vector<Layer> layers;
     Kernel::SharedPtr<Kernel::Event> vsync_event;
 };
@@ -46,6 +52,9 @@ public:
     /// Creates a layer on the specified display and returns the layer id.
     u64 CreateLayer(u64 display_id);
 
+    /// Sets the z value of the specified layer, which orders it against the other ones.
+    void SetLayerZ(u64 layer_id, u64 z);
+
     /// Gets the buffer queue id of the specified layer in the specified display.
     u32 GetBufferQueueId(u64 display_id, u64 layer_id);
 
@@ -55,11 +64,17 @@ public:
     /// Obtains a buffer queue identified by the id.
     std::shared_ptr<BufferQueue> GetBufferQueue(u32 id) const;
 
-    /// Performs a composition request to the emulated nvidia GPU and triggers the vsync events when
-    /// finished.
+    /// Performs a composition request to the emulated nvidia GPU for the buffers queued to the
+    /// layers of every display.
     void Compose();
 
 private:
+    /// Composes the queued buffers and signals the vsync events, once every refresh.
+    void OnVSync();
+
+    /// Called when a layer queues a buffer. With variable refresh, it's composed right away.
+    void OnBufferQueued();
+
     /// Returns the display identified by the specified id.
     Display& GetDisplay(u64 display_id);
 
@@ -75,8 +90,14 @@ private:
     /// layers.
     u32 next_buffer_queue_id = 1;
 
-    /// CoreTiming event that handles screen composition.
+    /// CoreTiming event that handles screen composition and the vsync signal, at the refresh rate.
     CoreTiming::EventType* composition_event;
+    /// CoreTiming event that composes the buffers as they are queued, with variable refresh.
+    CoreTiming::EventType* present_event;
+    /// Whether present_event is already scheduled for the buffers queued so far.
+    bool present_scheduled = false;
+    /// Whether present_event has composed the displays since the last vsync.
+    bool presented_since_vsync = false;
 };
 
 } // namespace Service::NVFlinger
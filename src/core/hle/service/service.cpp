@@ -3,11 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <chrono>
 #include <fmt/format.h>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
 #include "core/core.h"
+#include "core/hle/async_worker.h"
 #include "core/hle/ipc.h"
 #include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/client_port.h"
@@ -24,6 +26,7 @@
 #include "core/hle/service/filesystem/filesystem.h"
 #include "core/hle/service/friend/friend.h"
 #include "core/hle/service/hid/hid.h"
+#include "core/hle/service/ipc_recorder.h"
 #include "core/hle/service/lm/lm.h"
 #include "core/hle/service/nfp/nfp.h"
 #include "core/hle/service/nifm/nifm.h"
@@ -69,7 +72,11 @@ static std::string MakeFunctionString(const char* name, const char* port_name,
 
 ServiceFrameworkBase::ServiceFrameworkBase(const char* service_name, u32 max_sessions,
                                            InvokerFn* handler_invoker)
-    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {}
+    : service_name(service_name), max_sessions(max_sessions), handler_invoker(handler_invoker) {
+    request_invoker = [](Kernel::SessionRequestHandler& handler, Kernel::HLERequestContext& ctx) {
+        static_cast<ServiceFrameworkBase&>(handler).InvokeRequest(ctx);
+    };
+}
 
 ServiceFrameworkBase::~ServiceFrameworkBase() = default;
 
@@ -99,12 +106,25 @@ Kernel::SharedPtr<Kernel::ClientPort> ServiceFrameworkBase::CreatePort() {
     return client_port;
 }
 
+/// Command ids below this are dispatched through the dense table, the rest through a search.
+constexpr u32 MaxDenseCommandId = 1024;
+
 void ServiceFrameworkBase::RegisterHandlersBase(const FunctionInfoBase* functions, size_t n) {
     handlers.reserve(handlers.size() + n);
     for (size_t i = 0; i < n; ++i) {
         // Usually this array is sorted by id already, so hint to insert at the end
         handlers.emplace_hint(handlers.cend(), functions[i].expected_header, functions[i]);
     }
+
+    // Inserting into the flat_map may have moved its elements, so rebuild the table from scratch.
+    dense_handlers.clear();
+    for (const auto& entry : handlers) {
+        if (entry.first >= MaxDenseCommandId) {
+            break;
+        }
+        dense_handlers.resize(entry.first + 1, nullptr);
+        dense_handlers[entry.first] = &entry.second;
+    }
 }
 
 void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext& ctx,
@@ -125,16 +145,52 @@ void ServiceFrameworkBase::ReportUnimplementedFunction(Kernel::HLERequestContext
 }
 
 void ServiceFrameworkBase::InvokeRequest(Kernel::HLERequestContext& ctx) {
-    auto itr = handlers.find(ctx.GetCommand());
-    const FunctionInfoBase* info = itr == handlers.end() ? nullptr : &itr->second;
-    if (info == nullptr || info->handler_callback == nullptr) {
+    const u32 command = ctx.GetCommand();
+    const FunctionInfoBase* info = nullptr;
+    if (command < dense_handlers.size()) {
+        info = dense_handlers[command];
+    } else if (command >= MaxDenseCommandId) {
+        auto itr = handlers.find(command);
+        info = itr == handlers.end() ? nullptr : &itr->second;
+    }
+    if (info == nullptr || (info->handler_callback == nullptr && !info->typed_invoker)) {
         return ReportUnimplementedFunction(ctx, info);
     }
 
     LOG_TRACE(
         Service, "%s",
         MakeFunctionString(info->name, GetServiceName().c_str(), ctx.CommandBuffer()).c_str());
-    handler_invoker(this, info->handler_callback, ctx);
+    const auto invoke = [this, info, &ctx] {
+        if (info->typed_invoker) {
+            info->typed_invoker(this, ctx);
+        } else {
+            handler_invoker(this, info->handler_callback, ctx);
+        }
+    };
+    if (!IPCRecorder::IsEnabled()) {
+        invoke();
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    invoke();
+    const auto end = std::chrono::steady_clock::now();
+
+    u64 bytes_in = ctx.GetRawDataSize() * sizeof(u32);
+    for (const auto& buffer : ctx.BufferDescriptorX()) {
+        bytes_in += buffer.Size();
+    }
+    for (const auto& buffer : ctx.BufferDescriptorA()) {
+        bytes_in += buffer.Size();
+    }
+    u64 bytes_out = 0;
+    for (const auto& buffer : ctx.BufferDescriptorB()) {
+        bytes_out += buffer.Size();
+    }
+    for (const auto& buffer : ctx.BufferDescriptorC()) {
+        bytes_out += buffer.Size();
+    }
+    IPCRecorder::Record(service_name, command, info->name, end - start, bytes_in, bytes_out);
 }
 
 ResultCode ServiceFrameworkBase::HandleSyncRequest(Kernel::HLERequestContext& context) {
@@ -171,6 +227,8 @@ void AddNamedPort(std::string name, SharedPtr<ClientPort> port) {
 
 /// Initialize ServiceManager
 void Init() {
+    HLE::AsyncWorker::Init();
+
     // NVFlinger needs to be accessed by several services like Vi and AppletOE so we instantiate it
     // here and pass it into the respective InstallInterfaces functions.
     auto nv_flinger = std::make_shared<NVFlinger::NVFlinger>();
@@ -205,6 +263,7 @@ void Init() {
 
 /// Shutdown ServiceManager
 void Shutdown() {
+    HLE::AsyncWorker::Shutdown();
     SM::g_service_manager = nullptr;
     g_kernel_named_ports.clear();
     LOG_DEBUG(Service, "shutdown OK");
@@ -5,11 +5,14 @@
 #pragma once
 
 #include <cstddef>
+#include <functional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <boost/container/flat_map.hpp>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "core/hle/ipc_helpers.h"
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/kernel/kernel.h"
 
@@ -74,15 +77,21 @@ private:
     template <typename T>
     friend class ServiceFramework;
 
+    using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
+                           Kernel::HLERequestContext& ctx);
+    /// Calls a handler with typed arguments, which it holds along with its exact signature.
+    using TypedInvokerFn = std::function<void(ServiceFrameworkBase* object,
+                                              Kernel::HLERequestContext& ctx)>;
+
     struct FunctionInfoBase {
         u32 expected_header;
+        /// Handler called through the service's invoker, nullptr for typed handlers
         HandlerFnP<ServiceFrameworkBase> handler_callback;
         const char* name;
+        /// Invoker of a handler with typed arguments, empty for the other handlers.
+        TypedInvokerFn typed_invoker;
     };
 
-    using InvokerFn = void(ServiceFrameworkBase* object, HandlerFnP<ServiceFrameworkBase> member,
-                           Kernel::HLERequestContext& ctx);
-
     ServiceFrameworkBase(const char* service_name, u32 max_sessions, InvokerFn* handler_invoker);
     ~ServiceFrameworkBase();
 
@@ -103,6 +112,9 @@ private:
     /// Function used to safely up-cast pointers to the derived class before invoking a handler.
     InvokerFn* handler_invoker;
     boost::container::flat_map<u32, FunctionInfoBase> handlers;
+    /// Entries of `handlers` with small command ids, indexed by command id to dispatch requests
+    /// without a search. Rebuilt whenever handlers are registered.
+    std::vector<const FunctionInfoBase*> dense_handlers;
 };
 
 /**
@@ -138,7 +150,26 @@ protected:
             : FunctionInfoBase{
                   expected_header,
                   // Type-erase member function pointer by casting it down to the base class.
-                  static_cast<HandlerFnP<ServiceFrameworkBase>>(handler_callback), name} {}
+                  static_cast<HandlerFnP<ServiceFrameworkBase>>(handler_callback), name, {}} {}
+
+        /**
+         * Constructs a FunctionInfo for a typed handler. Typed handlers take the raw parameters of
+         * the request as arguments following the context, and return a ResultCode or a
+         * ResultVal<T> whose value is sent back as raw data. The framework unpacks the request and
+         * builds the response for them.
+         *
+         * @see IPC::InvokeTypedHandler
+         */
+        template <typename Ret, typename... Args>
+        FunctionInfo(u32 expected_header,
+                     Ret (Self::*handler_callback)(Kernel::HLERequestContext&, Args...),
+                     const char* name)
+            : FunctionInfoBase{expected_header, nullptr, name,
+                               [handler_callback](ServiceFrameworkBase* object,
+                                                  Kernel::HLERequestContext& ctx) {
+                                   TypedInvoker<Ret, Args...>(static_cast<Self*>(object),
+                                                              handler_callback, ctx);
+                               }} {}
     };
 
     /**
@@ -175,6 +206,15 @@ private:
         // Cast back up to our original types and call the member function
         (static_cast<Self*>(object)->*static_cast<HandlerFnP<Self>>(member))(ctx);
     }
+
+    /// Invoker of typed handlers, unpacking their arguments from the request.
+    template <typename Ret, typename... Args>
+    static void TypedInvoker(Self* self,
+                             Ret (Self::*handler)(Kernel::HLERequestContext&, Args...),
+                             Kernel::HLERequestContext& ctx) {
+        IPC::InvokeTypedHandler<Ret, Args...>(
+            ctx, [self, handler, &ctx](Args... args) { return (self->*handler)(ctx, args...); });
+    }
 };
 
 /// Initialize ServiceManager
@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
 #include <tuple>
 #include "common/assert.h"
 #include "core/hle/ipc_helpers.h"
@@ -28,6 +30,12 @@ static ResultCode ValidateServiceName(const std::string& name) {
     return RESULT_SUCCESS;
 }
 
+u64 ServiceManager::PackServiceName(const std::string& name) {
+    u64 packed_name = 0;
+    std::memcpy(&packed_name, name.data(), std::min(name.size(), sizeof(packed_name)));
+    return packed_name;
+}
+
 void ServiceManager::InstallInterfaces(std::shared_ptr<ServiceManager> self) {
     ASSERT(self->sm_interface.expired());
 
@@ -42,14 +50,15 @@ ResultVal<Kernel::SharedPtr<Kernel::ServerPort>> ServiceManager::RegisterService
 
     CASCADE_CODE(ValidateServiceName(name));
 
-    if (registered_services.find(name) != registered_services.end())
+    const u64 packed_name = PackServiceName(name);
+    if (registered_services.find(packed_name) != registered_services.end())
         return ERR_ALREADY_REGISTERED;
 
     Kernel::SharedPtr<Kernel::ServerPort> server_port;
     Kernel::SharedPtr<Kernel::ClientPort> client_port;
     std::tie(server_port, client_port) = Kernel::ServerPort::CreatePortPair(max_sessions, name);
 
-    registered_services.emplace(std::move(name), std::move(client_port));
+    registered_services.emplace(packed_name, std::move(client_port));
     return MakeResult<Kernel::SharedPtr<Kernel::ServerPort>>(std::move(server_port));
 }
 
@@ -57,7 +66,14 @@ ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> ServiceManager::GetServicePort(
     const std::string& name) {
 
     CASCADE_CODE(ValidateServiceName(name));
-    auto it = registered_services.find(name);
+    return GetServicePort(PackServiceName(name));
+}
+
+ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> ServiceManager::GetServicePort(u64 packed_name) {
+    if (packed_name == 0) {
+        return ERR_INVALID_NAME_SIZE;
+    }
+    auto it = registered_services.find(packed_name);
     if (it == registered_services.end()) {
         return ERR_SERVICE_NOT_REGISTERED;
     }
@@ -92,17 +108,21 @@ void SM::GetService(Kernel::HLERequestContext& ctx) {
     auto name_buf = rp.PopRaw<std::array<char, 8>>();
     auto end = std::find(name_buf.begin(), name_buf.end(), '\0');
 
-    std::string name(name_buf.begin(), end);
+    // The name is looked up in its native form, anything after the first NUL is ignored
+    std::fill(end, name_buf.end(), '\0');
+    u64 packed_name;
+    std::memcpy(&packed_name, name_buf.data(), sizeof(packed_name));
+    const int name_length = static_cast<int>(end - name_buf.begin());
 
     // TODO(yuriks): Permission checks go here
 
-    auto client_port = service_manager->GetServicePort(name);
+    auto client_port = service_manager->GetServicePort(packed_name);
     if (client_port.Failed()) {
         IPC::ResponseBuilder rb = rp.MakeBuilder(2, 0, 0);
         rb.Push(client_port.Code());
-        LOG_ERROR(Service_SM, "called service=%s -> error 0x%08X", name.c_str(),
+        LOG_ERROR(Service_SM, "called service=%.*s -> error 0x%08X", name_length, name_buf.data(),
                   client_port.Code().raw);
-        if (name.length() == 0)
+        if (name_length == 0)
             return; // LibNX Fix
         UNIMPLEMENTED();
         return;
@@ -111,7 +131,7 @@ void SM::GetService(Kernel::HLERequestContext& ctx) {
     auto session = client_port.Unwrap()->Connect();
     ASSERT(session.Succeeded());
     if (session.Succeeded()) {
-        LOG_DEBUG(Service_SM, "called service=%s -> session=%u", name.c_str(),
+        LOG_DEBUG(Service_SM, "called service=%.*s -> session=%u", name_length, name_buf.data(),
                   (*session)->GetObjectId());
         IPC::ResponseBuilder rb =
             rp.MakeBuilder(2, 0, 1, IPC::ResponseBuilder::Flags::AlwaysMoveHandles);
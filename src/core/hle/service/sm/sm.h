@@ -47,16 +47,25 @@ public:
     ResultVal<Kernel::SharedPtr<Kernel::ServerPort>> RegisterService(std::string name,
                                                                      unsigned int max_sessions);
     ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> GetServicePort(const std::string& name);
+    /// Looks up a service by its name in the native form, see PackServiceName.
+    ResultVal<Kernel::SharedPtr<Kernel::ClientPort>> GetServicePort(u64 packed_name);
     ResultVal<Kernel::SharedPtr<Kernel::ClientSession>> ConnectToService(const std::string& name);
 
+    /**
+     * Packs a service name into the native form used by sm requests, the characters of the name
+     * in the bytes of a u64 from the lowest one up, padded with zeroes.
+     */
+    static u64 PackServiceName(const std::string& name);
+
     void InvokeControlRequest(Kernel::HLERequestContext& context);
 
 private:
     std::weak_ptr<SM> sm_interface;
     std::unique_ptr<Controller> controller_interface;
 
-    /// Map of registered services, retrieved using GetServicePort or ConnectToService.
-    std::unordered_map<std::string, Kernel::SharedPtr<Kernel::ClientPort>> registered_services;
+    /// Map of registered services by packed name, retrieved using GetServicePort or
+    /// ConnectToService.
+    std::unordered_map<u64, Kernel::SharedPtr<Kernel::ClientPort>> registered_services;
 };
 
 extern std::shared_ptr<ServiceManager> g_service_manager;
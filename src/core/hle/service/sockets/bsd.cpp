@@ -2,11 +2,95 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstring>
+#include <vector>
 #include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/event.h"
 #include "core/hle/service/sockets/bsd.h"
+#include "core/hle/service/sockets/poller.h"
 
 namespace Service::Sockets {
 
+namespace {
+
+constexpr u32 FCNTL_GETFL = 3;
+constexpr u32 FCNTL_SETFL = 4;
+constexpr u32 FLAG_O_NONBLOCK = 0x800;
+
+struct PollFD {
+    s32 fd;
+    s16 events;
+    s16 revents;
+};
+static_assert(sizeof(PollFD) == 0x8, "PollFD has incorrect size");
+
+/// Number of descriptors in the sets passed to Select, as they are sized by the guest libraries.
+constexpr u32 FD_SET_SIZE = 1024;
+/// Descriptor set of Select, a bit for each descriptor.
+using FDSet = std::array<u8, FD_SET_SIZE / 8>;
+/// Events polled for the descriptors of the read, write and exception sets of Select.
+constexpr std::array<s16, 3> FD_SET_EVENTS{POLL_IN, POLL_OUT, POLL_PRI};
+
+bool IsInFDSet(const FDSet& set, u32 fd) {
+    return (set[fd / 8] >> (fd % 8)) & 1;
+}
+
+void AddToFDSet(FDSet& set, u32 fd) {
+    set[fd / 8] |= static_cast<u8>(1 << (fd % 8));
+}
+
+/// Writes the response of a call that returns a value and an error number.
+Errno WriteResult(Kernel::HLERequestContext& ctx, s32 ret, Errno bsd_errno) {
+    IPC::ResponseBuilder rb{ctx, 4};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<s32>(bsd_errno == Errno::SUCCESS ? ret : -1);
+    rb.Push(static_cast<u32>(bsd_errno));
+    return bsd_errno;
+}
+
+/// Writes the response of a call that additionally returns the size of an output buffer.
+Errno WriteResultWithSize(Kernel::HLERequestContext& ctx, s32 ret, Errno bsd_errno, u32 size) {
+    IPC::ResponseBuilder rb{ctx, 5};
+    rb.Push(RESULT_SUCCESS);
+    rb.Push<s32>(bsd_errno == Errno::SUCCESS ? ret : -1);
+    rb.Push(static_cast<u32>(bsd_errno));
+    rb.Push<u32>(bsd_errno == Errno::SUCCESS ? size : 0);
+    return bsd_errno;
+}
+
+bool HasReadBuffer(const Kernel::HLERequestContext& ctx, size_t index) {
+    return ctx.BufferDescriptorA().size() > index || ctx.BufferDescriptorX().size() > index;
+}
+
+bool HasWriteBuffer(const Kernel::HLERequestContext& ctx, size_t index) {
+    return ctx.BufferDescriptorB().size() > index || ctx.BufferDescriptorC().size() > index;
+}
+
+bool ReadSockAddr(const Kernel::HLERequestContext& ctx, size_t index, SockAddrIn& out_addr) {
+    if (!HasReadBuffer(ctx, index)) {
+        return false;
+    }
+    const std::vector<u8> buffer = ctx.ReadBuffer(index);
+    if (buffer.size() < sizeof(SockAddrIn)) {
+        return false;
+    }
+    std::memcpy(&out_addr, buffer.data(), sizeof(SockAddrIn));
+    return true;
+}
+
+/// Writes an address to an output buffer, if the guest passed one. Returns the size written.
+u32 WriteSockAddr(const Kernel::HLERequestContext& ctx, size_t index, const SockAddrIn& addr) {
+    if (!HasWriteBuffer(ctx, index) || ctx.GetWriteBufferSize(index) == 0) {
+        return 0;
+    }
+    return static_cast<u32>(ctx.WriteBuffer(&addr, sizeof(addr), index));
+}
+
+} // Anonymous namespace
+
 void BSD::RegisterClient(Kernel::HLERequestContext& ctx) {
     LOG_WARNING(Service, "(STUBBED) called");
 
@@ -32,72 +116,605 @@ void BSD::Socket(Kernel::HLERequestContext& ctx) {
     u32 type = rp.Pop<u32>();
     u32 protocol = rp.Pop<u32>();
 
-    LOG_WARNING(Service, "(STUBBED) called domain=%u type=%u protocol=%u", domain, type, protocol);
+    LOG_DEBUG(Service, "called domain=%u type=%u protocol=%u", domain, type, protocol);
 
-    u32 fd = next_fd++;
+    SocketHandle socket;
+    const Errno error = CreateSocket(domain, type, protocol, socket);
+    if (error != Errno::SUCCESS) {
+        WriteResult(ctx, -1, error);
+        return;
+    }
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    const u32 fd = next_fd++;
+    file_descriptors[fd] = {socket};
+    WriteResult(ctx, static_cast<s32>(fd), Errno::SUCCESS);
+}
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(fd);
-    rb.Push<u32>(0); // bsd errno
+void BSD::Poll(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 nfds = rp.Pop<u32>();
+    const s32 timeout = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called nfds=%u timeout=%d", nfds, timeout);
+
+    std::vector<PollFD> guest_fds(nfds);
+    if (nfds != 0) {
+        const std::vector<u8> buffer = ctx.ReadBuffer();
+        if (buffer.size() < nfds * sizeof(PollFD)) {
+            WriteResult(ctx, -1, Errno::INVAL);
+            return;
+        }
+        std::memcpy(guest_fds.data(), buffer.data(), nfds * sizeof(PollFD));
+    }
+
+    // Negative descriptors are ignored, as they are by the host
+    std::vector<HostPollFD> host_fds;
+    for (const PollFD& guest_fd : guest_fds) {
+        const FileDescriptor* descriptor =
+            guest_fd.fd >= 0 ? GetFileDescriptor(guest_fd.fd) : nullptr;
+        if (descriptor != nullptr) {
+            host_fds.push_back({descriptor->socket, guest_fd.events, 0});
+        }
+    }
+
+    // Checks the descriptors without waiting and writes the response, returns the number of ready
+    // descriptors
+    const auto poll_now = [this, guest_fds](Kernel::HLERequestContext& ctx) {
+        std::vector<PollFD> result = guest_fds;
+        std::vector<HostPollFD> fds;
+        for (const PollFD& guest_fd : result) {
+            if (guest_fd.fd < 0) {
+                continue;
+            }
+            const FileDescriptor* descriptor = GetFileDescriptor(guest_fd.fd);
+            fds.push_back({descriptor != nullptr ? descriptor->socket : INVALID_SOCKET_HANDLE,
+                           guest_fd.events, 0});
+        }
+
+        s32 num_ready = 0;
+        const Errno error = Sockets::Poll(fds.data(), fds.size(), 0, num_ready);
+        if (error != Errno::SUCCESS) {
+            WriteResult(ctx, -1, error);
+            return -1;
+        }
+
+        auto host_fd = fds.begin();
+        num_ready = 0;
+        for (PollFD& guest_fd : result) {
+            guest_fd.revents = 0;
+            if (guest_fd.fd < 0) {
+                continue;
+            }
+            guest_fd.revents = host_fd->socket != INVALID_SOCKET_HANDLE ? host_fd->revents
+                                                                        : s16{POLL_NVAL};
+            ++host_fd;
+            if (guest_fd.revents != 0) {
+                ++num_ready;
+            }
+        }
+
+        ctx.WriteBuffer(result.data(), result.size() * sizeof(PollFD));
+        WriteResult(ctx, num_ready, Errno::SUCCESS);
+        return num_ready;
+    };
+
+    if (poll_now(ctx) != 0 || timeout == 0 || host_fds.empty()) {
+        return;
+    }
+
+    const u64 timeout_ns = timeout > 0 ? static_cast<u64>(timeout) * 1000000 : 0;
+    WaitForSockets(ctx, "BSD::Poll", std::move(host_fds), timeout_ns, poll_now);
 }
 
-void BSD::Connect(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+void BSD::Select(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 nfds = std::min(rp.Pop<u32>(), FD_SET_SIZE);
+    rp.Skip(1, false);
+    const u64 timeout_sec = rp.Pop<u64>();
+    const u64 timeout_usec = rp.Pop<u64>();
+    const bool null_timeout = rp.Pop<u32>() != 0;
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called nfds=%u timeout=%" PRIu64 ".%06" PRIu64 " null_timeout=%d", nfds,
+              timeout_sec, timeout_usec, null_timeout);
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+    // Missing sets are empty
+    std::array<FDSet, 3> guest_sets{};
+    for (size_t set = 0; set < guest_sets.size(); ++set) {
+        if (HasReadBuffer(ctx, set)) {
+            const std::vector<u8> buffer = ctx.ReadBuffer(set);
+            std::memcpy(guest_sets[set].data(), buffer.data(),
+                        std::min(buffer.size(), guest_sets[set].size()));
+        }
+    }
+
+    // The sets are translated to a poll of the descriptors in any of them
+    std::vector<PollFD> guest_fds;
+    for (u32 fd = 0; fd < nfds; ++fd) {
+        s16 events = 0;
+        for (size_t set = 0; set < guest_sets.size(); ++set) {
+            if (IsInFDSet(guest_sets[set], fd)) {
+                events |= FD_SET_EVENTS[set];
+            }
+        }
+        if (events != 0) {
+            guest_fds.push_back({static_cast<s32>(fd), events, 0});
+        }
+    }
+
+    std::vector<HostPollFD> host_fds;
+    for (const PollFD& guest_fd : guest_fds) {
+        const FileDescriptor* descriptor = GetFileDescriptor(guest_fd.fd);
+        if (descriptor == nullptr) {
+            WriteResult(ctx, -1, Errno::BADF);
+            return;
+        }
+        host_fds.push_back({descriptor->socket, guest_fd.events, 0});
+    }
+
+    // Checks the descriptors without waiting and writes the response, returns the number of ready
+    // descriptors
+    const auto select_now = [this, guest_fds](Kernel::HLERequestContext& ctx) {
+        std::vector<HostPollFD> fds;
+        for (const PollFD& guest_fd : guest_fds) {
+            const FileDescriptor* descriptor = GetFileDescriptor(guest_fd.fd);
+            if (descriptor == nullptr) {
+                // Closed while the thread was waiting
+                WriteResult(ctx, -1, Errno::BADF);
+                return -1;
+            }
+            fds.push_back({descriptor->socket, guest_fd.events, 0});
+        }
+
+        s32 num_ready = 0;
+        const Errno error = Sockets::Poll(fds.data(), fds.size(), 0, num_ready);
+        if (error != Errno::SUCCESS) {
+            WriteResult(ctx, -1, error);
+            return -1;
+        }
+
+        // Errors and hang ups make a descriptor readable and writable, so that the guest finds
+        // out about them from the call that fails
+        std::array<FDSet, 3> result_sets{};
+        num_ready = 0;
+        for (size_t i = 0; i < fds.size(); ++i) {
+            s16 revents = fds[i].revents;
+            if (revents & (POLL_ERR | POLL_HUP)) {
+                revents |= POLL_IN | POLL_OUT;
+            }
+            for (size_t set = 0; set < result_sets.size(); ++set) {
+                if (revents & fds[i].events & FD_SET_EVENTS[set]) {
+                    AddToFDSet(result_sets[set], static_cast<u32>(guest_fds[i].fd));
+                    ++num_ready;
+                }
+            }
+        }
+
+        for (size_t set = 0; set < result_sets.size(); ++set) {
+            if (HasWriteBuffer(ctx, set) && ctx.GetWriteBufferSize(set) != 0) {
+                ctx.WriteBuffer(result_sets[set].data(),
+                                std::min(result_sets[set].size(), ctx.GetWriteBufferSize(set)),
+                                set);
+            }
+        }
+        WriteResult(ctx, num_ready, Errno::SUCCESS);
+        return num_ready;
+    };
+
+    const bool zero_timeout = !null_timeout && timeout_sec == 0 && timeout_usec == 0;
+    if (select_now(ctx) != 0 || zero_timeout || host_fds.empty()) {
+        return;
+    }
+
+    const u64 timeout_ns = null_timeout ? 0 : timeout_sec * 1000000000 + timeout_usec * 1000;
+    WaitForSockets(ctx, "BSD::Select", std::move(host_fds), timeout_ns, select_now);
+}
+
+void BSD::Recv(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u flags=0x%X", fd, flags);
+
+    RunBlocking(ctx, "BSD::Recv", fd, POLL_IN, flags, Errno::AGAIN,
+                [this, fd, flags](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResult(ctx, -1, Errno::BADF);
+                    }
+
+                    std::vector<u8> buffer(ctx.GetWriteBufferSize());
+                    size_t received = 0;
+                    const Errno error = Sockets::Recv(descriptor->socket, flags, buffer.data(),
+                                                      buffer.size(), received, nullptr);
+                    if (error == Errno::SUCCESS) {
+                        ctx.WriteBuffer(buffer.data(), received);
+                    }
+                    return WriteResult(ctx, static_cast<s32>(received), error);
+                },
+                nullptr);
+}
+
+void BSD::RecvFrom(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u flags=0x%X", fd, flags);
+
+    RunBlocking(ctx, "BSD::RecvFrom", fd, POLL_IN, flags, Errno::AGAIN,
+                [this, fd, flags](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResultWithSize(ctx, -1, Errno::BADF, 0);
+                    }
+
+                    std::vector<u8> buffer(ctx.GetWriteBufferSize());
+                    size_t received = 0;
+                    SockAddrIn addr{};
+                    const Errno error = Sockets::Recv(descriptor->socket, flags, buffer.data(),
+                                                      buffer.size(), received, &addr);
+                    u32 addr_size = 0;
+                    if (error == Errno::SUCCESS) {
+                        ctx.WriteBuffer(buffer.data(), received);
+                        addr_size = WriteSockAddr(ctx, 1, addr);
+                    }
+                    return WriteResultWithSize(ctx, static_cast<s32>(received), error,
+                                               addr_size);
+                },
+                nullptr);
+}
+
+void BSD::Send(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 flags = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u flags=0x%X", fd, flags);
+
+    RunBlocking(ctx, "BSD::Send", fd, POLL_OUT, flags, Errno::AGAIN,
+                [this, fd, flags](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResult(ctx, -1, Errno::BADF);
+                    }
+
+                    const std::vector<u8> buffer = ctx.ReadBuffer();
+                    size_t sent = 0;
+                    const Errno error = Sockets::Send(descriptor->socket, flags, buffer.data(),
+                                                      buffer.size(), sent, nullptr);
+                    return WriteResult(ctx, static_cast<s32>(sent), error);
+                },
+                nullptr);
 }
 
 void BSD::SendTo(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 flags = rp.Pop<u32>();
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called fd=%u flags=0x%X", fd, flags);
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+    RunBlocking(ctx, "BSD::SendTo", fd, POLL_OUT, flags, Errno::AGAIN,
+                [this, fd, flags](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResult(ctx, -1, Errno::BADF);
+                    }
+
+                    // Without an address this behaves like Send
+                    SockAddrIn addr;
+                    const bool has_addr = ReadSockAddr(ctx, 1, addr);
+                    const std::vector<u8> buffer = ctx.ReadBuffer();
+                    size_t sent = 0;
+                    const Errno error =
+                        Sockets::Send(descriptor->socket, flags, buffer.data(), buffer.size(),
+                                      sent, has_addr ? &addr : nullptr);
+                    return WriteResult(ctx, static_cast<s32>(sent), error);
+                },
+                nullptr);
+}
+
+void BSD::Accept(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u", fd);
+
+    RunBlocking(ctx, "BSD::Accept", fd, POLL_IN, 0, Errno::AGAIN,
+                [this, fd](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResultWithSize(ctx, -1, Errno::BADF, 0);
+                    }
+
+                    SocketHandle socket;
+                    SockAddrIn addr{};
+                    const Errno error = Sockets::Accept(descriptor->socket, socket, addr);
+                    if (error != Errno::SUCCESS) {
+                        return WriteResultWithSize(ctx, -1, error, 0);
+                    }
+
+                    const u32 new_fd = next_fd++;
+                    file_descriptors[new_fd] = {socket};
+                    const u32 addr_size = WriteSockAddr(ctx, 0, addr);
+                    return WriteResultWithSize(ctx, static_cast<s32>(new_fd), Errno::SUCCESS,
+                                               addr_size);
+                },
+                nullptr);
+}
+
+void BSD::Bind(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u", fd);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    SockAddrIn addr;
+    if (descriptor == nullptr) {
+        WriteResult(ctx, -1, Errno::BADF);
+    } else if (!ReadSockAddr(ctx, 0, addr)) {
+        WriteResult(ctx, -1, Errno::INVAL);
+    } else {
+        WriteResult(ctx, 0, Sockets::Bind(descriptor->socket, addr));
+    }
+}
+
+void BSD::Connect(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u", fd);
+
+    // A blocking connect waits for the connection to be established and then reports its outcome
+    RunBlocking(ctx, "BSD::Connect", fd, POLL_OUT, 0, Errno::INPROGRESS,
+                [this, fd](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    SockAddrIn addr;
+                    if (descriptor == nullptr) {
+                        return WriteResult(ctx, -1, Errno::BADF);
+                    }
+                    if (!ReadSockAddr(ctx, 0, addr)) {
+                        return WriteResult(ctx, -1, Errno::INVAL);
+                    }
+                    return WriteResult(ctx, 0, Sockets::Connect(descriptor->socket, addr));
+                },
+                [this, fd](Kernel::HLERequestContext& ctx) {
+                    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+                    if (descriptor == nullptr) {
+                        return WriteResult(ctx, -1, Errno::BADF);
+                    }
+                    return WriteResult(ctx, 0, GetPendingError(descriptor->socket));
+                });
+}
+
+void BSD::GetPeerName(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u", fd);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResultWithSize(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    SockAddrIn addr{};
+    const Errno error = Sockets::GetPeerName(descriptor->socket, addr);
+    const u32 addr_size = error == Errno::SUCCESS ? WriteSockAddr(ctx, 0, addr) : 0;
+    WriteResultWithSize(ctx, 0, error, addr_size);
+}
+
+void BSD::GetSockName(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u", fd);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResultWithSize(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    SockAddrIn addr{};
+    const Errno error = Sockets::GetSockName(descriptor->socket, addr);
+    const u32 addr_size = error == Errno::SUCCESS ? WriteSockAddr(ctx, 0, addr) : 0;
+    WriteResultWithSize(ctx, 0, error, addr_size);
+}
+
+void BSD::GetSockOpt(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 level = rp.Pop<u32>();
+    const u32 optname = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u level=0x%X optname=0x%X", fd, level, optname);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResultWithSize(ctx, -1, Errno::BADF, 0);
+        return;
+    }
+
+    std::vector<u8> value(HasWriteBuffer(ctx, 0) ? ctx.GetWriteBufferSize() : 0);
+    size_t size = value.size();
+    const Errno error = Sockets::GetSockOpt(descriptor->socket, level, optname, value.data(), size);
+    if (error == Errno::SUCCESS) {
+        ctx.WriteBuffer(value.data(), size);
+    }
+    WriteResultWithSize(ctx, 0, error, static_cast<u32>(size));
+}
+
+void BSD::Listen(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const s32 backlog = rp.Pop<s32>();
+
+    LOG_DEBUG(Service, "called fd=%u backlog=%d", fd, backlog);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResult(ctx, -1, Errno::BADF);
+        return;
+    }
+    WriteResult(ctx, 0, Sockets::Listen(descriptor->socket, backlog));
+}
+
+void BSD::Fcntl(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 cmd = rp.Pop<u32>();
+    const u32 arg = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u cmd=%u arg=0x%X", fd, cmd, arg);
+
+    FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResult(ctx, -1, Errno::BADF);
+        return;
+    }
+
+    switch (cmd) {
+    case FCNTL_GETFL:
+        WriteResult(ctx, descriptor->is_non_blocking ? FLAG_O_NONBLOCK : 0, Errno::SUCCESS);
+        break;
+    case FCNTL_SETFL:
+        descriptor->is_non_blocking = (arg & FLAG_O_NONBLOCK) != 0;
+        WriteResult(ctx, 0, Errno::SUCCESS);
+        break;
+    default:
+        LOG_ERROR(Service, "Unimplemented fcntl command %u", cmd);
+        WriteResult(ctx, -1, Errno::INVAL);
+        break;
+    }
+}
+
+void BSD::SetSockOpt(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 level = rp.Pop<u32>();
+    const u32 optname = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u level=0x%X optname=0x%X", fd, level, optname);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResult(ctx, -1, Errno::BADF);
+        return;
+    }
+
+    const std::vector<u8> value = HasReadBuffer(ctx, 0) ? ctx.ReadBuffer() : std::vector<u8>{};
+    WriteResult(ctx, 0,
+                Sockets::SetSockOpt(descriptor->socket, level, optname, value.data(),
+                                    value.size()));
+}
+
+void BSD::Shutdown(Kernel::HLERequestContext& ctx) {
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
+    const u32 how = rp.Pop<u32>();
+
+    LOG_DEBUG(Service, "called fd=%u how=%u", fd, how);
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr) {
+        WriteResult(ctx, -1, Errno::BADF);
+        return;
+    }
+    WriteResult(ctx, 0, Sockets::Shutdown(descriptor->socket, how));
 }
 
 void BSD::Close(Kernel::HLERequestContext& ctx) {
-    LOG_WARNING(Service, "(STUBBED) called");
+    IPC::RequestParser rp{ctx};
+    const u32 fd = rp.Pop<u32>();
 
-    IPC::ResponseBuilder rb{ctx, 4};
+    LOG_DEBUG(Service, "called fd=%u", fd);
 
-    rb.Push(RESULT_SUCCESS);
-    rb.Push<u32>(0); // ret
-    rb.Push<u32>(0); // bsd errno
+    const auto itr = file_descriptors.find(fd);
+    if (itr == file_descriptors.end()) {
+        WriteResult(ctx, -1, Errno::BADF);
+        return;
+    }
+
+    CloseSocket(itr->second.socket);
+    file_descriptors.erase(itr);
+    // Threads blocked on the socket are woken up, and then find that it is gone
+    poller->Interrupt();
+    WriteResult(ctx, 0, Errno::SUCCESS);
 }
 
-BSD::BSD(const char* name) : ServiceFramework(name) {
+BSD::FileDescriptor* BSD::GetFileDescriptor(u32 fd) {
+    const auto itr = file_descriptors.find(fd);
+    return itr != file_descriptors.end() ? &itr->second : nullptr;
+}
+
+void BSD::WaitForSockets(Kernel::HLERequestContext& ctx, const char* reason,
+                         std::vector<HostPollFD> fds, u64 timeout_ns,
+                         std::function<s32(Kernel::HLERequestContext& ctx)> check) {
+    // The thread sleeps until one of the sockets is ready or the timeout expires
+    auto wait_id = std::make_shared<u64>();
+    auto event = ctx.SleepClientThread(
+        Kernel::GetCurrentThread(), reason, timeout_ns,
+        [this, check = std::move(check), wait_id](Kernel::SharedPtr<Kernel::Thread> thread,
+                                                  Kernel::HLERequestContext& ctx,
+                                                  ThreadWakeupReason reason) {
+            if (reason != ThreadWakeupReason::Signal) {
+                poller->Cancel(*wait_id);
+            }
+            check(ctx);
+        });
+    *wait_id = poller->Wait(std::move(fds), [event] { event->Signal(); });
+}
+
+void BSD::RunBlocking(Kernel::HLERequestContext& ctx, const char* reason, u32 fd, s16 events,
+                      u32 flags, Errno would_block, const Operation& operation, Operation retry) {
+    if (operation(ctx) != would_block) {
+        return;
+    }
+
+    const FileDescriptor* descriptor = GetFileDescriptor(fd);
+    if (descriptor == nullptr || descriptor->is_non_blocking || (flags & MSG_FLAG_DONTWAIT)) {
+        return;
+    }
+
+    // The response written so far is replaced once the operation could run again
+    auto event = ctx.SleepClientThread(
+        Kernel::GetCurrentThread(), reason, 0,
+        [retry = retry ? std::move(retry) : operation](Kernel::SharedPtr<Kernel::Thread> thread,
+                                                       Kernel::HLERequestContext& ctx,
+                                                       ThreadWakeupReason reason) { retry(ctx); });
+    poller->Wait({{descriptor->socket, events, 0}}, [event] { event->Signal(); });
+}
+
+BSD::BSD(std::shared_ptr<Poller> poller, const char* name)
+    : ServiceFramework(name), poller(std::move(poller)) {
     static const FunctionInfo functions[] = {
         {0, &BSD::RegisterClient, "RegisterClient"},
         {1, &BSD::StartMonitoring, "StartMonitoring"},
         {2, &BSD::Socket, "Socket"},
         {3, nullptr, "SocketExempt"},
         {4, nullptr, "Open"},
-        {5, nullptr, "Select"},
-        {6, nullptr, "Poll"},
+        {5, &BSD::Select, "Select"},
+        {6, &BSD::Poll, "Poll"},
         {7, nullptr, "Sysctl"},
-        {8, nullptr, "Recv"},
-        {9, nullptr, "RecvFrom"},
-        {10, nullptr, "Send"},
+        {8, &BSD::Recv, "Recv"},
+        {9, &BSD::RecvFrom, "RecvFrom"},
+        {10, &BSD::Send, "Send"},
         {11, &BSD::SendTo, "SendTo"},
-        {12, nullptr, "Accept"},
-        {13, nullptr, "Bind"},
+        {12, &BSD::Accept, "Accept"},
+        {13, &BSD::Bind, "Bind"},
         {14, &BSD::Connect, "Connect"},
-        {15, nullptr, "GetPeerName"},
-        {16, nullptr, "GetSockName"},
-        {17, nullptr, "GetSockOpt"},
-        {18, nullptr, "Listen"},
+        {15, &BSD::GetPeerName, "GetPeerName"},
+        {16, &BSD::GetSockName, "GetSockName"},
+        {17, &BSD::GetSockOpt, "GetSockOpt"},
+        {18, &BSD::Listen, "Listen"},
         {19, nullptr, "Ioctl"},
-        {20, nullptr, "Fcntl"},
-        {21, nullptr, "SetSockOpt"},
-        {22, nullptr, "Shutdown"},
+        {20, &BSD::Fcntl, "Fcntl"},
+        {21, &BSD::SetSockOpt, "SetSockOpt"},
+        {22, &BSD::Shutdown, "Shutdown"},
         {23, nullptr, "ShutdownAllSockets"},
         {24, nullptr, "Write"},
         {25, nullptr, "Read"},
@@ -110,4 +727,10 @@ BSD::BSD(const char* name) : ServiceFramework(name) {
     RegisterHandlers(functions);
 }
 
+BSD::~BSD() {
+    for (const auto& entry : file_descriptors) {
+        CloseSocket(entry.second.socket);
+    }
+}
+
 } // namespace Service::Sockets
@@ -4,26 +4,80 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "core/hle/kernel/hle_ipc.h"
 #include "core/hle/service/service.h"
+#include "core/hle/service/sockets/host_socket.h"
 
 namespace Service::Sockets {
 
+class Poller;
+
 class BSD final : public ServiceFramework<BSD> {
 public:
-    explicit BSD(const char* name);
-    ~BSD() = default;
+    BSD(std::shared_ptr<Poller> poller, const char* name);
+    ~BSD();
 
 private:
+    struct FileDescriptor {
+        SocketHandle socket;
+        /// Whether the guest asked for the socket not to block. The host socket never blocks.
+        bool is_non_blocking = false;
+    };
+
+    /// Performs a socket operation and writes its whole response.
+    using Operation = std::function<Errno(Kernel::HLERequestContext& ctx)>;
+
     void RegisterClient(Kernel::HLERequestContext& ctx);
     void StartMonitoring(Kernel::HLERequestContext& ctx);
     void Socket(Kernel::HLERequestContext& ctx);
-    void Connect(Kernel::HLERequestContext& ctx);
+    void Poll(Kernel::HLERequestContext& ctx);
+    void Select(Kernel::HLERequestContext& ctx);
+    void Recv(Kernel::HLERequestContext& ctx);
+    void RecvFrom(Kernel::HLERequestContext& ctx);
+    void Send(Kernel::HLERequestContext& ctx);
     void SendTo(Kernel::HLERequestContext& ctx);
+    void Accept(Kernel::HLERequestContext& ctx);
+    void Bind(Kernel::HLERequestContext& ctx);
+    void Connect(Kernel::HLERequestContext& ctx);
+    void GetPeerName(Kernel::HLERequestContext& ctx);
+    void GetSockName(Kernel::HLERequestContext& ctx);
+    void GetSockOpt(Kernel::HLERequestContext& ctx);
+    void Listen(Kernel::HLERequestContext& ctx);
+    void Fcntl(Kernel::HLERequestContext& ctx);
+    void SetSockOpt(Kernel::HLERequestContext& ctx);
+    void Shutdown(Kernel::HLERequestContext& ctx);
     void Close(Kernel::HLERequestContext& ctx);
 
+    /// Returns the descriptor with the given id, or nullptr if there is none.
+    FileDescriptor* GetFileDescriptor(u32 fd);
+
+    /**
+     * Puts the calling thread to sleep until one of `fds` is ready, or `timeout_ns` expires if it
+     * isn't 0, and then runs `check` to write the response.
+     */
+    void WaitForSockets(Kernel::HLERequestContext& ctx, const char* reason,
+                        std::vector<HostPollFD> fds, u64 timeout_ns,
+                        std::function<s32(Kernel::HLERequestContext& ctx)> check);
+
+    /**
+     * Runs an operation that the guest may expect to block. If the operation reports
+     * `would_block` on a blocking socket, the calling thread sleeps until the socket has one of
+     * `events`, and then `retry` runs in its place.
+     */
+    void RunBlocking(Kernel::HLERequestContext& ctx, const char* reason, u32 fd, s16 events,
+                     u32 flags, Errno would_block, const Operation& operation, Operation retry);
+
+    /// Guest file descriptors and the host sockets they refer to.
+    std::unordered_map<u32, FileDescriptor> file_descriptors;
+
     /// Id to use for the next open file descriptor.
     u32 next_fd = 1;
+
+    std::shared_ptr<Poller> poller;
 };
 
 } // namespace Service::Sockets
@@ -0,0 +1,557 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+// winsock2.h needs to be included first to prevent winsock.h being included by other includes
+#include <ws2tcpip.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/hle/service/sockets/host_socket.h"
+
+namespace Service::Sockets {
+
+namespace {
+
+#ifdef _WIN32
+int LastError() {
+    return WSAGetLastError();
+}
+
+auto HostPoll(WSAPOLLFD* fds, ULONG num_fds, INT timeout) {
+    return WSAPoll(fds, num_fds, timeout);
+}
+
+using HostPollFDType = WSAPOLLFD;
+
+constexpr int HOST_SHUT_RD = SD_RECEIVE;
+constexpr int HOST_SHUT_WR = SD_SEND;
+constexpr int HOST_SHUT_RDWR = SD_BOTH;
+constexpr int SEND_FLAGS = 0;
+#else
+int LastError() {
+    return errno;
+}
+
+auto HostPoll(pollfd* fds, nfds_t num_fds, int timeout) {
+    return poll(fds, num_fds, timeout);
+}
+
+using HostPollFDType = pollfd;
+
+constexpr int HOST_SHUT_RD = SHUT_RD;
+constexpr int HOST_SHUT_WR = SHUT_WR;
+constexpr int HOST_SHUT_RDWR = SHUT_RDWR;
+#ifdef MSG_NOSIGNAL
+// A peer that closed the connection must not kill the emulator with SIGPIPE
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+#endif
+
+constexpr u32 GUEST_SOL_SOCKET = 0xFFFF;
+constexpr u32 GUEST_IPPROTO_TCP = 6;
+
+Errno TranslateError(int error) {
+    switch (error) {
+    case 0:
+        return Errno::SUCCESS;
+#ifdef _WIN32
+    case WSAEWOULDBLOCK:
+        return Errno::AGAIN;
+    case WSAEBADF:
+    case WSAENOTSOCK:
+        return Errno::BADF;
+    case WSAEINVAL:
+        return Errno::INVAL;
+    case WSAEMFILE:
+        return Errno::MFILE;
+    case WSAESHUTDOWN:
+        return Errno::PIPE;
+    case WSAEMSGSIZE:
+        return Errno::MSGSIZE;
+    case WSAENOPROTOOPT:
+        return Errno::NOPROTOOPT;
+    case WSAEPROTONOSUPPORT:
+        return Errno::PROTONOSUPPORT;
+    case WSAEOPNOTSUPP:
+        return Errno::OPNOTSUPP;
+    case WSAEAFNOSUPPORT:
+        return Errno::AFNOSUPPORT;
+    case WSAEADDRINUSE:
+        return Errno::ADDRINUSE;
+    case WSAEADDRNOTAVAIL:
+        return Errno::ADDRNOTAVAIL;
+    case WSAENETUNREACH:
+        return Errno::NETUNREACH;
+    case WSAECONNABORTED:
+        return Errno::CONNABORTED;
+    case WSAECONNRESET:
+        return Errno::CONNRESET;
+    case WSAEISCONN:
+        return Errno::ISCONN;
+    case WSAENOTCONN:
+        return Errno::NOTCONN;
+    case WSAETIMEDOUT:
+        return Errno::TIMEDOUT;
+    case WSAECONNREFUSED:
+        return Errno::CONNREFUSED;
+    case WSAEHOSTUNREACH:
+        return Errno::HOSTUNREACH;
+    case WSAEALREADY:
+        return Errno::ALREADY;
+    case WSAEINPROGRESS:
+        return Errno::INPROGRESS;
+#else
+    case EAGAIN:
+#if EWOULDBLOCK != EAGAIN
+    case EWOULDBLOCK:
+#endif
+        return Errno::AGAIN;
+    case EBADF:
+    case ENOTSOCK:
+        return Errno::BADF;
+    case EINVAL:
+        return Errno::INVAL;
+    case EMFILE:
+        return Errno::MFILE;
+    case EPIPE:
+        return Errno::PIPE;
+    case EMSGSIZE:
+        return Errno::MSGSIZE;
+    case ENOPROTOOPT:
+        return Errno::NOPROTOOPT;
+    case EPROTONOSUPPORT:
+        return Errno::PROTONOSUPPORT;
+    case EOPNOTSUPP:
+        return Errno::OPNOTSUPP;
+    case EAFNOSUPPORT:
+        return Errno::AFNOSUPPORT;
+    case EADDRINUSE:
+        return Errno::ADDRINUSE;
+    case EADDRNOTAVAIL:
+        return Errno::ADDRNOTAVAIL;
+    case ENETUNREACH:
+        return Errno::NETUNREACH;
+    case ECONNABORTED:
+        return Errno::CONNABORTED;
+    case ECONNRESET:
+        return Errno::CONNRESET;
+    case EISCONN:
+        return Errno::ISCONN;
+    case ENOTCONN:
+        return Errno::NOTCONN;
+    case ETIMEDOUT:
+        return Errno::TIMEDOUT;
+    case ECONNREFUSED:
+        return Errno::CONNREFUSED;
+    case EHOSTUNREACH:
+        return Errno::HOSTUNREACH;
+    case EALREADY:
+        return Errno::ALREADY;
+    case EINPROGRESS:
+        return Errno::INPROGRESS;
+#endif
+    default:
+        LOG_ERROR(Service, "Unhandled host socket error %d", error);
+        return Errno::INVAL;
+    }
+}
+
+Errno GetLastErrno() {
+    return TranslateError(LastError());
+}
+
+sockaddr_in ToHostAddress(const SockAddrIn& addr) {
+    sockaddr_in result{};
+    result.sin_family = AF_INET;
+    result.sin_port = htons(addr.port);
+    std::memcpy(&result.sin_addr, addr.address.data(), addr.address.size());
+    return result;
+}
+
+SockAddrIn FromHostAddress(const sockaddr_in& addr) {
+    SockAddrIn result{};
+    result.len = sizeof(SockAddrIn);
+    result.family = GUEST_AF_INET;
+    result.port = ntohs(addr.sin_port);
+    std::memcpy(result.address.data(), &addr.sin_addr, result.address.size());
+    return result;
+}
+
+bool MakeNonBlocking(SocketHandle socket) {
+#ifdef _WIN32
+    u_long enabled = 1;
+    return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+    const int flags = fcntl(socket, F_GETFL);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+/// Prepares a socket created by the host for use by the guest.
+Errno SetUpSocket(SocketHandle socket) {
+    if (!MakeNonBlocking(socket)) {
+        const Errno error = GetLastErrno();
+        CloseSocket(socket);
+        return error;
+    }
+#ifdef SO_NOSIGPIPE
+    const int enabled = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+    return Errno::SUCCESS;
+}
+
+int ToHostMessageFlags(u32 flags) {
+    int result = 0;
+    if (flags & MSG_FLAG_OOB) {
+        result |= MSG_OOB;
+    }
+    if (flags & MSG_FLAG_PEEK) {
+        result |= MSG_PEEK;
+    }
+    // Every host socket is non-blocking, so MSG_FLAG_DONTWAIT needs no translation
+    const u32 unhandled = flags & ~(MSG_FLAG_OOB | MSG_FLAG_PEEK | MSG_FLAG_DONTWAIT);
+    if (unhandled != 0) {
+        LOG_WARNING(Service, "Unhandled message flags 0x%X", unhandled);
+    }
+    return result;
+}
+
+/**
+ * Translates a socket option of the guest. Only options with an int value are supported.
+ * @returns Whether the option is known
+ */
+bool ToHostSocketOption(u32 level, u32 optname, int& out_level, int& out_optname) {
+    if (level == GUEST_SOL_SOCKET) {
+        out_level = SOL_SOCKET;
+        switch (optname) {
+        case 0x4:
+            out_optname = SO_REUSEADDR;
+            return true;
+        case 0x8:
+            out_optname = SO_KEEPALIVE;
+            return true;
+        case 0x20:
+            out_optname = SO_BROADCAST;
+            return true;
+        case 0x1001:
+            out_optname = SO_SNDBUF;
+            return true;
+        case 0x1002:
+            out_optname = SO_RCVBUF;
+            return true;
+        case 0x1007:
+            out_optname = SO_ERROR;
+            return true;
+        }
+    } else if (level == GUEST_IPPROTO_TCP && optname == 0x1) {
+        out_level = IPPROTO_TCP;
+        out_optname = TCP_NODELAY;
+        return true;
+    }
+    return false;
+}
+
+s16 ToHostPollEvents(s16 events) {
+    s16 result = 0;
+    if (events & POLL_IN) {
+        result |= POLLIN;
+    }
+#ifndef _WIN32
+    // WSAPoll rejects POLLPRI
+    if (events & POLL_PRI) {
+        result |= POLLPRI;
+    }
+#endif
+    if (events & POLL_OUT) {
+        result |= POLLOUT;
+    }
+    return result;
+}
+
+s16 FromHostPollEvents(s16 events) {
+    s16 result = 0;
+    if (events & POLLIN) {
+        result |= POLL_IN;
+    }
+    if (events & POLLPRI) {
+        result |= POLL_PRI;
+    }
+    if (events & POLLOUT) {
+        result |= POLL_OUT;
+    }
+    if (events & POLLERR) {
+        result |= POLL_ERR;
+    }
+    if (events & POLLHUP) {
+        result |= POLL_HUP;
+    }
+    if (events & POLLNVAL) {
+        result |= POLL_NVAL;
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
+void InitializeHostSockets() {
+#ifdef _WIN32
+    WSADATA data;
+    WSAStartup(MAKEWORD(2, 2), &data);
+#endif
+}
+
+void ShutdownHostSockets() {
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+Errno CreateSocket(u32 domain, u32 type, u32 protocol, SocketHandle& out_socket) {
+    if (domain != GUEST_AF_INET) {
+        LOG_ERROR(Service, "Unsupported socket domain %u", domain);
+        return Errno::AFNOSUPPORT;
+    }
+
+    // The guest's socket types and protocol numbers are the same as the host's
+    const SocketHandle socket =
+        static_cast<SocketHandle>(::socket(AF_INET, static_cast<int>(type), protocol));
+    if (socket == INVALID_SOCKET_HANDLE) {
+        return GetLastErrno();
+    }
+
+    const Errno error = SetUpSocket(socket);
+    if (error == Errno::SUCCESS) {
+        out_socket = socket;
+    }
+    return error;
+}
+
+void CloseSocket(SocketHandle socket) {
+#ifdef _WIN32
+    closesocket(socket);
+#else
+    close(socket);
+#endif
+}
+
+Errno Bind(SocketHandle socket, const SockAddrIn& addr) {
+    const sockaddr_in host_addr = ToHostAddress(addr);
+    if (bind(socket, reinterpret_cast<const sockaddr*>(&host_addr), sizeof(host_addr)) != 0) {
+        return GetLastErrno();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno Connect(SocketHandle socket, const SockAddrIn& addr) {
+    const sockaddr_in host_addr = ToHostAddress(addr);
+    if (connect(socket, reinterpret_cast<const sockaddr*>(&host_addr), sizeof(host_addr)) != 0) {
+        const Errno error = GetLastErrno();
+#ifdef _WIN32
+        // Winsock reports a connection that is still being established as WSAEWOULDBLOCK
+        if (error == Errno::AGAIN) {
+            return Errno::INPROGRESS;
+        }
+#endif
+        return error;
+    }
+    return Errno::SUCCESS;
+}
+
+Errno Listen(SocketHandle socket, s32 backlog) {
+    if (listen(socket, backlog) != 0) {
+        return GetLastErrno();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno Accept(SocketHandle socket, SocketHandle& out_socket, SockAddrIn& out_addr) {
+    sockaddr_in host_addr{};
+    socklen_t addr_len = sizeof(host_addr);
+    const SocketHandle accepted = static_cast<SocketHandle>(
+        accept(socket, reinterpret_cast<sockaddr*>(&host_addr), &addr_len));
+    if (accepted == INVALID_SOCKET_HANDLE) {
+        return GetLastErrno();
+    }
+
+    const Errno error = SetUpSocket(accepted);
+    if (error == Errno::SUCCESS) {
+        out_socket = accepted;
+        out_addr = FromHostAddress(host_addr);
+    }
+    return error;
+}
+
+Errno GetSockName(SocketHandle socket, SockAddrIn& out_addr) {
+    sockaddr_in host_addr{};
+    socklen_t addr_len = sizeof(host_addr);
+    if (getsockname(socket, reinterpret_cast<sockaddr*>(&host_addr), &addr_len) != 0) {
+        return GetLastErrno();
+    }
+    out_addr = FromHostAddress(host_addr);
+    return Errno::SUCCESS;
+}
+
+Errno GetPeerName(SocketHandle socket, SockAddrIn& out_addr) {
+    sockaddr_in host_addr{};
+    socklen_t addr_len = sizeof(host_addr);
+    if (getpeername(socket, reinterpret_cast<sockaddr*>(&host_addr), &addr_len) != 0) {
+        return GetLastErrno();
+    }
+    out_addr = FromHostAddress(host_addr);
+    return Errno::SUCCESS;
+}
+
+Errno Shutdown(SocketHandle socket, u32 how) {
+    int host_how;
+    switch (how) {
+    case 0:
+        host_how = HOST_SHUT_RD;
+        break;
+    case 1:
+        host_how = HOST_SHUT_WR;
+        break;
+    case 2:
+        host_how = HOST_SHUT_RDWR;
+        break;
+    default:
+        return Errno::INVAL;
+    }
+
+    if (shutdown(socket, host_how) != 0) {
+        return GetLastErrno();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno GetPendingError(SocketHandle socket) {
+    int error = 0;
+    socklen_t size = sizeof(error);
+    if (getsockopt(socket, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &size) != 0) {
+        return GetLastErrno();
+    }
+    return TranslateError(error);
+}
+
+Errno Recv(SocketHandle socket, u32 flags, u8* buffer, size_t size, size_t& out_received,
+           SockAddrIn* out_addr) {
+    sockaddr_in host_addr{};
+    socklen_t addr_len = sizeof(host_addr);
+    const auto result =
+        recvfrom(socket, reinterpret_cast<char*>(buffer), static_cast<int>(size),
+                 ToHostMessageFlags(flags), reinterpret_cast<sockaddr*>(&host_addr), &addr_len);
+    if (result < 0) {
+        return GetLastErrno();
+    }
+
+    out_received = static_cast<size_t>(result);
+    if (out_addr != nullptr) {
+        *out_addr = FromHostAddress(host_addr);
+    }
+    return Errno::SUCCESS;
+}
+
+Errno Send(SocketHandle socket, u32 flags, const u8* buffer, size_t size, size_t& out_sent,
+           const SockAddrIn* addr) {
+    const int host_flags = ToHostMessageFlags(flags) | SEND_FLAGS;
+    const char* data = reinterpret_cast<const char*>(buffer);
+    const int data_size = static_cast<int>(size);
+
+    decltype(send(socket, data, data_size, host_flags)) result;
+    if (addr != nullptr) {
+        const sockaddr_in host_addr = ToHostAddress(*addr);
+        result = sendto(socket, data, data_size, host_flags,
+                        reinterpret_cast<const sockaddr*>(&host_addr), sizeof(host_addr));
+    } else {
+        result = send(socket, data, data_size, host_flags);
+    }
+    if (result < 0) {
+        return GetLastErrno();
+    }
+
+    out_sent = static_cast<size_t>(result);
+    return Errno::SUCCESS;
+}
+
+Errno SetSockOpt(SocketHandle socket, u32 level, u32 optname, const u8* value, size_t size) {
+    int host_level;
+    int host_optname;
+    if (!ToHostSocketOption(level, optname, host_level, host_optname) || size < sizeof(int)) {
+        LOG_ERROR(Service, "Unsupported socket option level=0x%X optname=0x%X size=%zu", level,
+                  optname, size);
+        return Errno::NOPROTOOPT;
+    }
+
+    int host_value;
+    std::memcpy(&host_value, value, sizeof(host_value));
+    if (setsockopt(socket, host_level, host_optname, reinterpret_cast<const char*>(&host_value),
+                   sizeof(host_value)) != 0) {
+        return GetLastErrno();
+    }
+    return Errno::SUCCESS;
+}
+
+Errno GetSockOpt(SocketHandle socket, u32 level, u32 optname, u8* value, size_t& size) {
+    int host_level;
+    int host_optname;
+    if (!ToHostSocketOption(level, optname, host_level, host_optname) || size < sizeof(int)) {
+        LOG_ERROR(Service, "Unsupported socket option level=0x%X optname=0x%X size=%zu", level,
+                  optname, size);
+        return Errno::NOPROTOOPT;
+    }
+
+    int host_value = 0;
+    socklen_t host_size = sizeof(host_value);
+    if (getsockopt(socket, host_level, host_optname, reinterpret_cast<char*>(&host_value),
+                   &host_size) != 0) {
+        return GetLastErrno();
+    }
+
+    // Errors are reported in the guest's numbering
+    if (host_optname == SO_ERROR && host_level == SOL_SOCKET) {
+        host_value = static_cast<int>(TranslateError(host_value));
+    }
+
+    std::memcpy(value, &host_value, sizeof(host_value));
+    size = sizeof(host_value);
+    return Errno::SUCCESS;
+}
+
+Errno Poll(HostPollFD* fds, size_t num_fds, s32 timeout_ms, s32& out_ready) {
+    std::vector<HostPollFDType> host_fds(num_fds);
+    for (size_t i = 0; i < num_fds; ++i) {
+        host_fds[i].fd = fds[i].socket;
+        host_fds[i].events = ToHostPollEvents(fds[i].events);
+        host_fds[i].revents = 0;
+    }
+
+    const int result = HostPoll(host_fds.data(), static_cast<unsigned>(num_fds), timeout_ms);
+    if (result < 0) {
+        return GetLastErrno();
+    }
+
+    for (size_t i = 0; i < num_fds; ++i) {
+        fds[i].revents = FromHostPollEvents(host_fds[i].revents);
+    }
+    out_ready = result;
+    return Errno::SUCCESS;
+}
+
+} // namespace Service::Sockets
@@ -0,0 +1,127 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "common/swap.h"
+
+namespace Service::Sockets {
+
+// Thin wrappers around the host's socket API. They take and return the values the guest uses, so
+// that the services don't have to deal with the differences between hosts. Every socket created
+// here is non-blocking on the host, blocking is emulated on top of it.
+
+#ifdef _WIN32
+using SocketHandle = std::uintptr_t; // SOCKET
+#else
+using SocketHandle = int;
+#endif
+
+constexpr SocketHandle INVALID_SOCKET_HANDLE = static_cast<SocketHandle>(-1);
+
+/// Error numbers as returned by the bsd services.
+enum class Errno : u32 {
+    SUCCESS = 0,
+    BADF = 9,
+    AGAIN = 11,
+    INVAL = 22,
+    MFILE = 24,
+    PIPE = 32,
+    MSGSIZE = 90,
+    NOPROTOOPT = 92,
+    PROTONOSUPPORT = 93,
+    OPNOTSUPP = 95,
+    AFNOSUPPORT = 97,
+    ADDRINUSE = 98,
+    ADDRNOTAVAIL = 99,
+    NETUNREACH = 101,
+    CONNABORTED = 103,
+    CONNRESET = 104,
+    ISCONN = 106,
+    NOTCONN = 107,
+    TIMEDOUT = 110,
+    CONNREFUSED = 111,
+    HOSTUNREACH = 113,
+    ALREADY = 114,
+    INPROGRESS = 115,
+};
+
+constexpr u32 GUEST_AF_INET = 2;
+
+/// Events of PollFD, as used by the guest.
+enum PollEvents : s16 {
+    POLL_IN = 0x1,
+    POLL_PRI = 0x2,
+    POLL_OUT = 0x4,
+    POLL_ERR = 0x8,
+    POLL_HUP = 0x10,
+    POLL_NVAL = 0x20,
+};
+
+/// Flags of Recv and Send, as used by the guest.
+enum MessageFlags : u32 {
+    MSG_FLAG_OOB = 0x1,
+    MSG_FLAG_PEEK = 0x2,
+    MSG_FLAG_DONTWAIT = 0x80,
+};
+
+/// IPv4 socket address in the layout of the guest.
+struct SockAddrIn {
+    u8 len;
+    u8 family;
+    u16_be port;
+    std::array<u8, 4> address;
+    INSERT_PADDING_BYTES(8);
+};
+static_assert(sizeof(SockAddrIn) == 0x10, "SockAddrIn has incorrect size");
+
+struct HostPollFD {
+    SocketHandle socket;
+    s16 events;  ///< PollEvents to wait for
+    s16 revents; ///< PollEvents that occurred
+};
+
+/// Prepares the host's socket library. Must be called before any of the other functions.
+void InitializeHostSockets();
+void ShutdownHostSockets();
+
+/// Creates a host socket for the guest's domain, type and protocol.
+Errno CreateSocket(u32 domain, u32 type, u32 protocol, SocketHandle& out_socket);
+void CloseSocket(SocketHandle socket);
+
+Errno Bind(SocketHandle socket, const SockAddrIn& addr);
+Errno Connect(SocketHandle socket, const SockAddrIn& addr);
+Errno Listen(SocketHandle socket, s32 backlog);
+Errno Accept(SocketHandle socket, SocketHandle& out_socket, SockAddrIn& out_addr);
+Errno GetSockName(SocketHandle socket, SockAddrIn& out_addr);
+Errno GetPeerName(SocketHandle socket, SockAddrIn& out_addr);
+Errno Shutdown(SocketHandle socket, u32 how);
+
+/// Returns and clears the error of an asynchronous operation, such as a connection attempt.
+Errno GetPendingError(SocketHandle socket);
+
+/// Receives up to `size` bytes. If `out_addr` isn't null, it is set to the address of the sender.
+Errno Recv(SocketHandle socket, u32 flags, u8* buffer, size_t size, size_t& out_received,
+           SockAddrIn* out_addr);
+
+/// Sends up to `size` bytes. If `addr` isn't null, they are sent to that address.
+Errno Send(SocketHandle socket, u32 flags, const u8* buffer, size_t size, size_t& out_sent,
+           const SockAddrIn* addr);
+
+Errno SetSockOpt(SocketHandle socket, u32 level, u32 optname, const u8* value, size_t size);
+Errno GetSockOpt(SocketHandle socket, u32 level, u32 optname, u8* value, size_t& size);
+
+/**
+ * Polls the sockets for the events they ask for, waiting at most `timeout_ms` milliseconds, or
+ * forever if it is negative.
+ * @param out_ready Number of sockets with events that occurred
+ */
+Errno Poll(HostPollFD* fds, size_t num_fds, s32 timeout_ms, s32& out_ready);
+
+} // namespace Service::Sockets
@@ -0,0 +1,184 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <utility>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "common/thread_placement.h"
+#include "core/core_timing.h"
+#include "core/hle/service/sockets/poller.h"
+
+namespace Service::Sockets {
+
+constexpr u32 GUEST_SOCK_DGRAM = 2;
+
+Poller::Poller() {
+    InitializeHostSockets();
+    ready_event = CoreTiming::RegisterEvent(
+        "Sockets::Poller", [this](u64 wait_id, int cycles_late) { ReadyCallback(wait_id); });
+}
+
+Poller::~Poller() {
+    if (poll_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            stop_requested = true;
+        }
+        Interrupt();
+        poll_thread.join();
+        CloseSocket(wakeup_sender);
+        CloseSocket(wakeup_receiver);
+    }
+
+    CoreTiming::RemoveNormalAndThreadsafeEvent(ready_event);
+    ShutdownHostSockets();
+}
+
+void Poller::StartPollThread() {
+    // A pair of connected loopback sockets serves to interrupt the poll thread, which works the
+    // same way on every host
+    SockAddrIn loopback{};
+    loopback.len = sizeof(SockAddrIn);
+    loopback.family = GUEST_AF_INET;
+    loopback.address = {127, 0, 0, 1};
+    SockAddrIn receiver_address{};
+    const bool created =
+        CreateSocket(GUEST_AF_INET, GUEST_SOCK_DGRAM, 0, wakeup_receiver) == Errno::SUCCESS &&
+        Bind(wakeup_receiver, loopback) == Errno::SUCCESS &&
+        GetSockName(wakeup_receiver, receiver_address) == Errno::SUCCESS &&
+        CreateSocket(GUEST_AF_INET, GUEST_SOCK_DGRAM, 0, wakeup_sender) == Errno::SUCCESS &&
+        Connect(wakeup_sender, receiver_address) == Errno::SUCCESS;
+    ASSERT_MSG(created, "Failed to create the wakeup sockets of the sockets poller");
+
+    poll_thread = std::thread([this] { PollLoop(); });
+}
+
+u64 Poller::Wait(std::vector<HostPollFD> fds, Callback callback) {
+    const u64 wait_id = next_wait_id++;
+    callbacks.emplace(wait_id, std::make_pair(fds, std::move(callback)));
+    Submit(wait_id, std::move(fds));
+    return wait_id;
+}
+
+void Poller::Cancel(u64 wait_id) {
+    callbacks.erase(wait_id);
+
+    // The poll thread may keep polling the sockets until it is woken up for something else, but
+    // it ignores what it finds for a wait that is gone
+    std::lock_guard<std::mutex> lock(wait_mutex);
+    pending_waits.erase(std::remove_if(pending_waits.begin(), pending_waits.end(),
+                                       [wait_id](const PendingWait& wait) {
+                                           return wait.id == wait_id;
+                                       }),
+                        pending_waits.end());
+}
+
+void Poller::Interrupt() {
+    if (!poll_thread.joinable()) {
+        return;
+    }
+    const u8 byte = 0;
+    size_t sent;
+    Send(wakeup_sender, 0, &byte, sizeof(byte), sent, nullptr);
+}
+
+void Poller::Submit(u64 wait_id, std::vector<HostPollFD> fds) {
+    if (!poll_thread.joinable()) {
+        StartPollThread();
+    }
+    {
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        pending_waits.push_back({wait_id, std::move(fds)});
+    }
+    Interrupt();
+}
+
+void Poller::PollLoop() {
+    Common::SetCurrentThreadName("Sockets Poller");
+    Common::SetCurrentThreadRole(Common::ThreadRole::Worker);
+
+    std::vector<HostPollFD> fds;
+    // Identifier and number of sockets of each wait, in the order their sockets are in fds
+    std::vector<std::pair<u64, size_t>> waits;
+
+    while (true) {
+        fds.clear();
+        waits.clear();
+        fds.push_back({wakeup_receiver, POLL_IN, 0});
+        {
+            std::lock_guard<std::mutex> lock(wait_mutex);
+            if (stop_requested) {
+                return;
+            }
+            for (const PendingWait& wait : pending_waits) {
+                waits.emplace_back(wait.id, wait.fds.size());
+                fds.insert(fds.end(), wait.fds.begin(), wait.fds.end());
+            }
+        }
+
+        s32 num_ready = 0;
+        const Errno error = Poll(fds.data(), fds.size(), -1, num_ready);
+        if (error != Errno::SUCCESS) {
+            LOG_ERROR(Service, "Polling sockets failed with errno %u", static_cast<u32>(error));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        if (fds[0].revents != 0) {
+            std::array<u8, 64> discarded;
+            size_t received;
+            while (Recv(wakeup_receiver, 0, discarded.data(), discarded.size(), received,
+                        nullptr) == Errno::SUCCESS) {
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(wait_mutex);
+        auto wait_fds = fds.begin() + 1;
+        for (const auto& [wait_id, num_fds] : waits) {
+            const bool ready = std::any_of(wait_fds, wait_fds + num_fds,
+                                           [](const HostPollFD& fd) { return fd.revents != 0; });
+            wait_fds += num_fds;
+            if (!ready) {
+                continue;
+            }
+
+            const auto itr = std::find_if(
+                pending_waits.begin(), pending_waits.end(),
+                [wait_id = wait_id](const PendingWait& wait) { return wait.id == wait_id; });
+            if (itr == pending_waits.end()) {
+                // Cancelled while the sockets were being polled
+                continue;
+            }
+            pending_waits.erase(itr);
+            CoreTiming::ScheduleEventThreadsafe(0, ready_event, wait_id);
+        }
+    }
+}
+
+void Poller::ReadyCallback(u64 wait_id) {
+    const auto itr = callbacks.find(wait_id);
+    if (itr == callbacks.end()) {
+        // Cancelled after its sockets became ready
+        return;
+    }
+
+    // Guest threads may have consumed what made the sockets ready in the meantime, in which case
+    // the wait goes on
+    std::vector<HostPollFD> fds = itr->second.first;
+    s32 num_ready = 0;
+    if (Poll(fds.data(), fds.size(), 0, num_ready) == Errno::SUCCESS && num_ready == 0) {
+        Submit(wait_id, std::move(fds));
+        return;
+    }
+
+    const Callback callback = std::move(itr->second.second);
+    callbacks.erase(itr);
+    callback();
+}
+
+} // namespace Service::Sockets
@@ -0,0 +1,77 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "core/hle/service/sockets/host_socket.h"
+
+namespace CoreTiming {
+struct EventType;
+}
+
+namespace Service::Sockets {
+
+/**
+ * Waits for host sockets to become ready on a thread of its own, so that guest threads blocking on
+ * a socket never block the CPU thread. There is one poller for all the sockets services. The thread
+ * and its wakeup sockets are only created by the first wait, so a system that is booted before the
+ * guest uses any socket can still be forked.
+ */
+class Poller final {
+public:
+    /// Called on the CPU thread once one of the sockets of a wait is ready.
+    using Callback = std::function<void()>;
+
+    Poller();
+    ~Poller();
+
+    /**
+     * Waits until any of the sockets reports one of the events it asks for, and then calls the
+     * callback on the CPU thread. The sockets are polled again on the CPU thread right before, so
+     * the callback only runs while they are still ready.
+     * @returns Identifier of the wait, to cancel it with
+     */
+    u64 Wait(std::vector<HostPollFD> fds, Callback callback);
+
+    /// Cancels a wait whose callback hasn't been called yet.
+    void Cancel(u64 wait_id);
+
+    /// Makes the poller pick up sockets that were closed while it was waiting on them.
+    void Interrupt();
+
+private:
+    struct PendingWait {
+        u64 id;
+        std::vector<HostPollFD> fds;
+    };
+
+    /// Creates the wakeup sockets and starts the poll thread. Only called from the CPU thread.
+    void StartPollThread();
+    void PollLoop();
+    void Submit(u64 wait_id, std::vector<HostPollFD> fds);
+    void ReadyCallback(u64 wait_id);
+
+    std::thread poll_thread;
+    /// Written to wake the poll thread, which polls the connected wakeup_receiver
+    SocketHandle wakeup_sender = INVALID_SOCKET_HANDLE;
+    SocketHandle wakeup_receiver = INVALID_SOCKET_HANDLE;
+
+    // Shared between the CPU thread and the poll thread, protected by wait_mutex.
+    std::mutex wait_mutex;
+    std::vector<PendingWait> pending_waits;
+    bool stop_requested = false;
+
+    // Only touched from the CPU thread.
+    std::unordered_map<u64, std::pair<std::vector<HostPollFD>, Callback>> callbacks;
+    CoreTiming::EventType* ready_event;
+    u64 next_wait_id = 0;
+};
+
+} // namespace Service::Sockets
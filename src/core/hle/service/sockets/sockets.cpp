@@ -4,14 +4,16 @@
 
 #include "core/hle/service/sockets/bsd.h"
 #include "core/hle/service/sockets/nsd.h"
+#include "core/hle/service/sockets/poller.h"
 #include "core/hle/service/sockets/sfdnsres.h"
 #include "core/hle/service/sockets/sockets.h"
 
 namespace Service::Sockets {
 
 void InstallInterfaces(SM::ServiceManager& service_manager) {
-    std::make_shared<BSD>("bsd:s")->InstallAsService(service_manager);
-    std::make_shared<BSD>("bsd:u")->InstallAsService(service_manager);
+    auto poller = std::make_shared<Poller>();
+    std::make_shared<BSD>(poller, "bsd:s")->InstallAsService(service_manager);
+    std::make_shared<BSD>(poller, "bsd:u")->InstallAsService(service_manager);
     std::make_shared<NSD>("nsd:a")->InstallAsService(service_manager);
     std::make_shared<NSD>("nsd:u")->InstallAsService(service_manager);
     std::make_shared<SFDNSRES>()->InstallAsService(service_manager);
@@ -14,6 +14,28 @@
 
 namespace Service::Time {
 
+/// The system clock offsets are refreshed at this interval, the steady clock needs no updates
+constexpr u64 shared_memory_update_ticks = BASE_CLOCK_RATE;
+
+/// Seconds since the POSIX epoch on the host
+static s64 GetHostPosixTime() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+/// Seconds since boot on the emulated steady clock
+static u64 GetSteadyClockSeconds() {
+    return cyclesToMs(CoreTiming::GetTicks()) / 1000;
+}
+
+template <typename T>
+static void StoreLockFree(LockFreeAtomicType<T>& atomic, const T& value) {
+    const u32 counter = atomic.counter + 1;
+    atomic.value[counter & 1] = value;
+    atomic.counter = counter;
+}
+
 class ISystemClock final : public ServiceFramework<ISystemClock> {
 public:
     ISystemClock() : ServiceFramework("ISystemClock") {
@@ -29,9 +51,7 @@ public:
 
 private:
     void GetCurrentTime(Kernel::HLERequestContext& ctx) {
-        const s64 time_since_epoch{std::chrono::duration_cast<std::chrono::seconds>(
-                                       std::chrono::system_clock::now().time_since_epoch())
-                                       .count()};
+        const s64 time_since_epoch{GetHostPosixTime()};
         LOG_DEBUG(Service_Time, "called");
         IPC::ResponseBuilder rb{ctx, 4};
         rb.Push(RESULT_SUCCESS);
@@ -59,7 +79,7 @@ public:
 private:
     void GetCurrentTimePoint(Kernel::HLERequestContext& ctx) {
         LOG_DEBUG(Service_Time, "called");
-        SteadyClockTimePoint steady_clock_time_point{cyclesToMs(CoreTiming::GetTicks()) / 1000};
+        SteadyClockTimePoint steady_clock_time_point{GetSteadyClockSeconds()};
         IPC::ResponseBuilder rb{ctx, (sizeof(SteadyClockTimePoint) / 4) + 2};
         rb.Push(RESULT_SUCCESS);
         rb.PushRaw(steady_clock_time_point);
@@ -156,6 +176,53 @@ void Module::Interface::GetStandardLocalSystemClock(Kernel::HLERequestContext& c
     LOG_DEBUG(Service_Time, "called");
 }
 
+void Module::Interface::GetSharedMemoryNativeHandle(Kernel::HLERequestContext& ctx) {
+    IPC::ResponseBuilder rb{ctx, 2, 1};
+    rb.Push(RESULT_SUCCESS);
+    rb.PushCopyObjects(time->shared_mem);
+    LOG_DEBUG(Service_Time, "called");
+}
+
+Module::Module() {
+    shared_mem = Kernel::SharedMemory::Create(
+        nullptr, 0x1000, Kernel::MemoryPermission::ReadWrite, Kernel::MemoryPermission::Read, 0,
+        Kernel::MemoryRegion::BASE, "Time:SharedMemory");
+
+    // The steady clock is derived from the system tick by the application, starting at zero
+    TimeSharedMemory& mem = shared_mem->GetView<TimeSharedMemory>();
+    StoreLockFree(mem.standard_steady_clock_context, SteadyClockContext{});
+    StoreLockFree(mem.standard_user_system_clock_automatic_correction, false);
+    UpdateSharedMemory();
+
+    update_event = CoreTiming::RegisterEvent("Time::UpdateSharedMemoryCallback",
+                                             [this](u64 userdata, int cycles_late) {
+                                                 UpdateSharedMemoryCallback(userdata, cycles_late);
+                                             });
+    CoreTiming::ScheduleEvent(shared_memory_update_ticks, update_event);
+}
+
+Module::~Module() {
+    CoreTiming::UnscheduleEvent(update_event, 0);
+}
+
+void Module::UpdateSharedMemory() {
+    // The host clock may be adjusted at any time, so the offset to the steady clock is recomputed
+    // on every update to keep it in line with ISystemClock::GetCurrentTime.
+    const u64 steady_seconds = GetSteadyClockSeconds();
+    SystemClockContext context{};
+    context.offset = GetHostPosixTime() - static_cast<s64>(steady_seconds);
+    context.time_point.value = steady_seconds;
+
+    TimeSharedMemory& mem = shared_mem->GetView<TimeSharedMemory>();
+    StoreLockFree(mem.standard_local_system_clock_context, context);
+    StoreLockFree(mem.standard_network_system_clock_context, context);
+}
+
+void Module::UpdateSharedMemoryCallback(u64 userdata, int cycles_late) {
+    UpdateSharedMemory();
+    CoreTiming::ScheduleEvent(shared_memory_update_ticks - cycles_late, update_event);
+}
+
 Module::Interface::Interface(std::shared_ptr<Module> time, const char* name)
     : ServiceFramework(name), time(std::move(time)) {}
 
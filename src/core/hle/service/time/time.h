@@ -4,8 +4,15 @@
 
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/service.h"
 
+namespace CoreTiming {
+struct EventType;
+}
+
 namespace Service::Time {
 
 // TODO(Rozelette) RE this structure
@@ -32,21 +39,60 @@ struct CalendarAdditionalInfo {
 static_assert(sizeof(CalendarAdditionalInfo) == 0x18,
               "CalendarAdditionalInfo structure has incorrect size");
 
-// TODO(bunnei) RE this structure
+struct SteadyClockTimePoint {
+    u64_le value; // In seconds
+    u128 clock_source_id;
+};
+static_assert(sizeof(SteadyClockTimePoint) == 0x18, "SteadyClockTimePoint is incorrect size");
+
 struct SystemClockContext {
-    INSERT_PADDING_BYTES(0x20);
+    s64_le offset; // Seconds to add to the steady clock time point to get the POSIX time
+    SteadyClockTimePoint time_point;
 };
 static_assert(sizeof(SystemClockContext) == 0x20,
               "SystemClockContext structure has incorrect size");
 
-struct SteadyClockTimePoint {
-    u64 value;
-    INSERT_PADDING_WORDS(4);
+struct SteadyClockContext {
+    u64_le internal_offset; // In nanoseconds, added to the time derived from the system tick
+    u128 clock_source_id;
 };
-static_assert(sizeof(SteadyClockTimePoint) == 0x18, "SteadyClockTimePoint is incorrect size");
+static_assert(sizeof(SteadyClockContext) == 0x18, "SteadyClockContext is incorrect size");
+
+/**
+ * Value in the time shared memory. Writers fill the copy the counter doesn't select and then
+ * increment the counter, so readers always see a complete value without taking a lock.
+ */
+template <typename T>
+struct LockFreeAtomicType {
+    u32_le counter;
+    std::array<T, 2> value;
+};
+
+/**
+ * Layout of the shared memory returned by GetSharedMemoryNativeHandle. Applications read the
+ * clocks from here instead of sending an IPC request for every query.
+ */
+struct TimeSharedMemory {
+    LockFreeAtomicType<SteadyClockContext> standard_steady_clock_context;
+    LockFreeAtomicType<SystemClockContext> standard_local_system_clock_context;
+    LockFreeAtomicType<SystemClockContext> standard_network_system_clock_context;
+    LockFreeAtomicType<bool> standard_user_system_clock_automatic_correction;
+    u32_le format_version;
+};
+static_assert(offsetof(TimeSharedMemory, standard_local_system_clock_context) == 0x38,
+              "TimeSharedMemory has incorrect layout");
+static_assert(offsetof(TimeSharedMemory, standard_network_system_clock_context) == 0x80,
+              "TimeSharedMemory has incorrect layout");
+static_assert(offsetof(TimeSharedMemory, standard_user_system_clock_automatic_correction) == 0xC8,
+              "TimeSharedMemory has incorrect layout");
+static_assert(offsetof(TimeSharedMemory, format_version) == 0xD0,
+              "TimeSharedMemory has incorrect layout");
 
 class Module final {
 public:
+    Module();
+    ~Module();
+
     class Interface : public ServiceFramework<Interface> {
     public:
         Interface(std::shared_ptr<Module> time, const char* name);
@@ -56,10 +102,19 @@ public:
         void GetStandardSteadyClock(Kernel::HLERequestContext& ctx);
         void GetTimeZoneService(Kernel::HLERequestContext& ctx);
         void GetStandardLocalSystemClock(Kernel::HLERequestContext& ctx);
+        void GetSharedMemoryNativeHandle(Kernel::HLERequestContext& ctx);
 
     protected:
         std::shared_ptr<Module> time;
     };
+
+private:
+    /// Writes the current clock contexts to the shared memory.
+    void UpdateSharedMemory();
+    void UpdateSharedMemoryCallback(u64 userdata, int cycles_late);
+
+    Kernel::SharedPtr<Kernel::SharedMemory> shared_mem;
+    CoreTiming::EventType* update_event;
 };
 
 /// Registers all Time services with the specified service manager.
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <array>
+#include <cinttypes>
 #include <memory>
 #include <boost/optional.hpp>
 #include "common/alignment.h"
@@ -32,19 +33,24 @@ struct DisplayInfo {
 };
 static_assert(sizeof(DisplayInfo) == 0x60, "DisplayInfo has wrong size");
 
+/**
+ * Parcels are parsed in place from the input buffer of a request, and built in fixed storage that
+ * is written to the output buffer as a whole, as TransactParcel runs several times per frame.
+ */
 class Parcel {
 public:
-    // This default size was chosen arbitrarily.
-    static constexpr size_t DefaultBufferSize = 0x40;
-    Parcel() : buffer(DefaultBufferSize) {}
-    explicit Parcel(std::vector<u8> data) : buffer(std::move(data)) {}
+    // Large enough for any parcel the service writes.
+    static constexpr size_t MaxBufferSize = 0x200;
+    Parcel() = default;
+    /// Reads the parcel from the given data, which has to stay valid while the parcel is read.
+    Parcel(const u8* data, size_t size) : read_data(data), read_size(size) {}
     virtual ~Parcel() = default;
 
     template <typename T>
     T Read() {
-        ASSERT(read_index + sizeof(T) <= buffer.size());
+        ASSERT(read_index + sizeof(T) <= read_size);
         T val;
-        std::memcpy(&val, buffer.data() + read_index, sizeof(T));
+        std::memcpy(&val, read_data + read_index, sizeof(T));
         read_index += sizeof(T);
         read_index = Common::AlignUp(read_index, 4);
         return val;
@@ -52,16 +58,16 @@ public:
 
     template <typename T>
     T ReadUnaligned() {
-        ASSERT(read_index + sizeof(T) <= buffer.size());
+        ASSERT(read_index + sizeof(T) <= read_size);
         T val;
-        std::memcpy(&val, buffer.data() + read_index, sizeof(T));
+        std::memcpy(&val, read_data + read_index, sizeof(T));
         read_index += sizeof(T);
         return val;
     }
 
     std::vector<u8> ReadBlock(size_t length) {
-        ASSERT(read_index + length <= buffer.size());
-        const u8* const begin = buffer.data() + read_index;
+        ASSERT(read_index + length <= read_size);
+        const u8* const begin = read_data + read_index;
         const u8* const end = begin + length;
         std::vector<u8> data(begin, end);
         read_index += length;
@@ -69,25 +75,19 @@ public:
         return data;
     }
 
-    std::u16string ReadInterfaceToken() {
+    /// Skips the interface token, which none of the transactions look at.
+    void SkipInterfaceToken() {
         u32 unknown = Read<u32_le>();
         u32 length = Read<u32_le>();
 
-        std::u16string token{};
-
-        for (u32 ch = 0; ch < length + 1; ++ch) {
-            token.push_back(ReadUnaligned<u16_le>());
-        }
-
+        ASSERT(read_index + (length + 1) * sizeof(u16_le) <= read_size);
+        read_index += (length + 1) * sizeof(u16_le);
         read_index = Common::AlignUp(read_index, 4);
-
-        return token;
     }
 
     template <typename T>
     void Write(const T& val) {
-        if (buffer.size() < write_index + sizeof(T))
-            buffer.resize(buffer.size() + sizeof(T) + DefaultBufferSize);
+        ASSERT(write_index + sizeof(T) <= buffer.size());
         std::memcpy(buffer.data() + write_index, &val, sizeof(T));
         write_index += sizeof(T);
         write_index = Common::AlignUp(write_index, 4);
@@ -103,16 +103,17 @@ public:
     }
 
     void Deserialize() {
-        ASSERT(buffer.size() > sizeof(Header));
+        ASSERT(read_size > sizeof(Header));
 
         Header header{};
-        std::memcpy(&header, buffer.data(), sizeof(Header));
+        std::memcpy(&header, read_data, sizeof(Header));
 
         read_index = header.data_offset;
         DeserializeData();
     }
 
-    std::vector<u8> Serialize() {
+    /// Writes the parcel to the output buffer of the request, returns the number of bytes written.
+    size_t Serialize(const Kernel::HLERequestContext& ctx) {
         ASSERT(read_index == 0);
         write_index = sizeof(Header);
 
@@ -125,7 +126,11 @@ public:
         header.objects_offset = sizeof(Header) + header.data_size;
         std::memcpy(buffer.data(), &header, sizeof(Header));
 
-        return buffer;
+        // The objects are left zeroed
+        ASSERT(header.objects_offset + header.objects_size <= buffer.size());
+        const size_t size = std::max<size_t>(header.objects_offset + header.objects_size,
+                                             DefaultSerializedSize);
+        return ctx.WriteBuffer(buffer.data(), size);
     }
 
 protected:
@@ -142,7 +147,12 @@ private:
     };
     static_assert(sizeof(Header) == 16, "ParcelHeader has wrong size");
 
-    std::vector<u8> buffer;
+    // Parcels are padded to at least this size, which games may rely on
+    static constexpr size_t DefaultSerializedSize = 0x40;
+
+    const u8* read_data = nullptr;
+    size_t read_size = 0;
+    std::array<u8, MaxBufferSize> buffer{};
     size_t read_index = 0;
     size_t write_index = 0;
 };
@@ -175,13 +185,13 @@ private:
 
 class IGBPConnectRequestParcel : public Parcel {
 public:
-    explicit IGBPConnectRequestParcel(const std::vector<u8>& buffer) : Parcel(buffer) {
+    IGBPConnectRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPConnectRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -222,14 +232,13 @@ private:
 
 class IGBPSetPreallocatedBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPSetPreallocatedBufferRequestParcel(const std::vector<u8>& buffer)
-        : Parcel(buffer) {
+    IGBPSetPreallocatedBufferRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPSetPreallocatedBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
         buffer = Read<NVFlinger::IGBPBuffer>();
     }
@@ -255,13 +264,13 @@ protected:
 
 class IGBPDequeueBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPDequeueBufferRequestParcel(const std::vector<u8>& buffer) : Parcel(buffer) {
+    IGBPDequeueBufferRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPDequeueBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -306,13 +315,13 @@ protected:
 
 class IGBPRequestBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPRequestBufferRequestParcel(const std::vector<u8>& buffer) : Parcel(buffer) {
+    IGBPRequestBufferRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPRequestBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         slot = Read<u32_le>();
     }
 
@@ -339,13 +348,13 @@ protected:
 
 class IGBPQueueBufferRequestParcel : public Parcel {
 public:
-    explicit IGBPQueueBufferRequestParcel(const std::vector<u8>& buffer) : Parcel(buffer) {
+    IGBPQueueBufferRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPQueueBufferRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         data = Read<Data>();
     }
 
@@ -404,13 +413,13 @@ private:
 
 class IGBPQueryRequestParcel : public Parcel {
 public:
-    explicit IGBPQueryRequestParcel(const std::vector<u8>& buffer) : Parcel(buffer) {
+    IGBPQueryRequestParcel(const u8* data, size_t size) : Parcel(data, size) {
         Deserialize();
     }
     ~IGBPQueryRequestParcel() override = default;
 
     void DeserializeData() override {
-        std::u16string token = ReadInterfaceToken();
+        SkipInterfaceToken();
         type = Read<u32_le>();
     }
 
@@ -472,19 +481,28 @@ private:
 
         LOG_DEBUG(Service_VI, "called, transaction=%x", static_cast<u32>(transaction));
 
+        // The request is parsed in place, and only copied if it isn't contiguous in host memory
+        const size_t input_size = ctx.GetReadBufferSize();
+        std::vector<u8> input_copy;
+        const u8* input = ctx.GetReadBufferPointer();
+        if (input == nullptr) {
+            input_copy = ctx.ReadBuffer();
+            input = input_copy.data();
+        }
+
         if (transaction == TransactionId::Connect) {
-            IGBPConnectRequestParcel request{ctx.ReadBuffer()};
+            IGBPConnectRequestParcel request{input, input_size};
             IGBPConnectResponseParcel response{1280, 720};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::SetPreallocatedBuffer) {
-            IGBPSetPreallocatedBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPSetPreallocatedBufferRequestParcel request{input, input_size};
 
             buffer_queue->SetPreallocatedBuffer(request.data.slot, request.buffer);
 
             IGBPSetPreallocatedBufferResponseParcel response{};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::DequeueBuffer) {
-            IGBPDequeueBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPDequeueBufferRequestParcel request{input, input_size};
             const u32 width{request.data.width};
             const u32 height{request.data.height};
             boost::optional<u32> slot = buffer_queue->DequeueBuffer(width, height);
@@ -492,7 +510,7 @@ private:
             if (slot != boost::none) {
                 // Buffer is available
                 IGBPDequeueBufferResponseParcel response{*slot};
-                ctx.WriteBuffer(response.Serialize());
+                response.Serialize(ctx);
             } else {
                 // Wait the current thread until a buffer becomes available
                 auto wait_event = ctx.SleepClientThread(
@@ -503,34 +521,34 @@ private:
                         auto buffer_queue = nv_flinger->GetBufferQueue(id);
                         boost::optional<u32> slot = buffer_queue->DequeueBuffer(width, height);
                         IGBPDequeueBufferResponseParcel response{*slot};
-                        ctx.WriteBuffer(response.Serialize());
+                        response.Serialize(ctx);
                         IPC::ResponseBuilder rb{ctx, 2};
                         rb.Push(RESULT_SUCCESS);
                     });
                 buffer_queue->SetBufferWaitEvent(std::move(wait_event));
             }
         } else if (transaction == TransactionId::RequestBuffer) {
-            IGBPRequestBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPRequestBufferRequestParcel request{input, input_size};
 
             auto& buffer = buffer_queue->RequestBuffer(request.slot);
 
             IGBPRequestBufferResponseParcel response{buffer};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::QueueBuffer) {
-            IGBPQueueBufferRequestParcel request{ctx.ReadBuffer()};
+            IGBPQueueBufferRequestParcel request{input, input_size};
 
             buffer_queue->QueueBuffer(request.data.slot, request.data.transform);
 
             IGBPQueueBufferResponseParcel response{1280, 720};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::Query) {
-            IGBPQueryRequestParcel request{ctx.ReadBuffer()};
+            IGBPQueryRequestParcel request{input, input_size};
 
             u32 value =
                 buffer_queue->Query(static_cast<NVFlinger::BufferQueue::QueryType>(request.type));
 
             IGBPQueryResponseParcel response{value};
-            ctx.WriteBuffer(response.Serialize());
+            response.Serialize(ctx);
         } else if (transaction == TransactionId::CancelBuffer) {
             LOG_WARNING(Service_VI, "(STUBBED) called, transaction=CancelBuffer");
         } else {
@@ -572,7 +590,8 @@ private:
 
 class ISystemDisplayService final : public ServiceFramework<ISystemDisplayService> {
 public:
-    ISystemDisplayService() : ServiceFramework("ISystemDisplayService") {
+    explicit ISystemDisplayService(std::shared_ptr<NVFlinger::NVFlinger> nv_flinger)
+        : ServiceFramework("ISystemDisplayService"), nv_flinger(std::move(nv_flinger)) {
         static const FunctionInfo functions[] = {
             {1200, nullptr, "GetZOrderCountMin"},
             {1202, nullptr, "GetZOrderCountMax"},
@@ -624,10 +643,13 @@ public:
 
 private:
     void SetLayerZ(Kernel::HLERequestContext& ctx) {
-        LOG_WARNING(Service_VI, "(STUBBED) called");
         IPC::RequestParser rp{ctx};
         u64 layer_id = rp.Pop<u64>();
         u64 z_value = rp.Pop<u64>();
+        LOG_DEBUG(Service_VI, "called, layer_id=0x%" PRIx64 ", z_value=0x%" PRIx64, layer_id,
+                  z_value);
+
+        nv_flinger->SetLayerZ(layer_id, z_value);
 
         IPC::ResponseBuilder rb = rp.MakeBuilder(2, 0, 0);
         rb.Push(RESULT_SUCCESS);
@@ -642,6 +664,8 @@ private:
         LOG_WARNING(Service_VI, "(STUBBED) called, layer_id=0x%x, visibility=%u", layer_id,
                     visibility);
     }
+
+    std::shared_ptr<NVFlinger::NVFlinger> nv_flinger;
 };
 
 class IManagerDisplayService final : public ServiceFramework<IManagerDisplayService> {
@@ -787,7 +811,7 @@ private:
 
         IPC::ResponseBuilder rb{ctx, 2, 0, 1};
         rb.Push(RESULT_SUCCESS);
-        rb.PushIpcInterface<ISystemDisplayService>();
+        rb.PushIpcInterface<ISystemDisplayService>(nv_flinger);
     }
 
     void GetManagerDisplayService(Kernel::HLERequestContext& ctx) {
@@ -884,7 +908,7 @@ private:
         NativeWindow native_window{buffer_queue_id};
         IPC::ResponseBuilder rb = rp.MakeBuilder(4, 0, 0);
         rb.Push(RESULT_SUCCESS);
-        rb.Push<u64>(ctx.WriteBuffer(native_window.Serialize()));
+        rb.Push<u64>(native_window.Serialize(ctx));
     }
 
     void CreateStrayLayer(Kernel::HLERequestContext& ctx) {
@@ -904,7 +928,7 @@ private:
         IPC::ResponseBuilder rb = rp.MakeBuilder(6, 0, 0);
         rb.Push(RESULT_SUCCESS);
         rb.Push(layer_id);
-        rb.Push<u64>(ctx.WriteBuffer(native_window.Serialize()));
+        rb.Push<u64>(native_window.Serialize(ctx));
     }
 
     void DestroyStrayLayer(Kernel::HLERequestContext& ctx) {
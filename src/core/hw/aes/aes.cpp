@@ -0,0 +1,428 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include "common/assert.h"
+#include "common/swap.h"
+#include "core/hw/aes/aes.h"
+#ifdef ARCHITECTURE_x86_64
+#include <immintrin.h>
+#include "common/x64/cpu_detect.h"
+#endif
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRYPTO)
+#include <arm_neon.h>
+#define HAVE_ARMV8_CRYPTO
+#endif
+
+namespace HW::AES {
+
+namespace {
+
+constexpr size_t NUM_ROUNDS = 10;
+/// Number of blocks whose counters or tweaks are prepared at once
+constexpr size_t BATCH_BLOCKS = 64;
+
+using BlockFn = void (*)(const u8* round_keys, u8* dest, const u8* src, size_t count);
+
+u8 MultiplyByTwo(u8 value) {
+    return static_cast<u8>((value << 1) ^ ((value >> 7) * 0x1B));
+}
+
+u8 Multiply(u8 a, u8 b) {
+    u8 result = 0;
+    for (; b != 0; b >>= 1) {
+        if (b & 1) {
+            result ^= a;
+        }
+        a = MultiplyByTwo(a);
+    }
+    return result;
+}
+
+u8 RotateLeft(u8 value, unsigned shift) {
+    return static_cast<u8>((value << shift) | (value >> (8 - shift)));
+}
+
+struct SBoxes {
+    std::array<u8, 256> forward;
+    std::array<u8, 256> inverse;
+};
+
+/// Builds the S-boxes by walking the multiplicative group of GF(2^8) with the generator 3.
+SBoxes MakeSBoxes() {
+    SBoxes boxes{};
+    u8 p = 1;
+    u8 q = 1;
+    do {
+        // Multiply p by 3 and divide q by 3, so that q stays the inverse of p
+        p = static_cast<u8>(p ^ MultiplyByTwo(p));
+        q ^= static_cast<u8>(q << 1);
+        q ^= static_cast<u8>(q << 2);
+        q ^= static_cast<u8>(q << 4);
+        if (q & 0x80) {
+            q ^= 0x09;
+        }
+        const u8 value = q ^ RotateLeft(q, 1) ^ RotateLeft(q, 2) ^ RotateLeft(q, 3) ^
+                         RotateLeft(q, 4) ^ 0x63;
+        boxes.forward[p] = value;
+    } while (p != 1);
+    boxes.forward[0] = 0x63;
+
+    for (size_t i = 0; i < boxes.forward.size(); ++i) {
+        boxes.inverse[boxes.forward[i]] = static_cast<u8>(i);
+    }
+    return boxes;
+}
+
+const SBoxes& GetSBoxes() {
+    static const SBoxes boxes = MakeSBoxes();
+    return boxes;
+}
+
+void InverseMixColumns(u8* state) {
+    for (size_t column = 0; column < 4; ++column) {
+        u8* c = state + column * 4;
+        const u8 a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+        c[0] = Multiply(a0, 14) ^ Multiply(a1, 11) ^ Multiply(a2, 13) ^ Multiply(a3, 9);
+        c[1] = Multiply(a0, 9) ^ Multiply(a1, 14) ^ Multiply(a2, 11) ^ Multiply(a3, 13);
+        c[2] = Multiply(a0, 13) ^ Multiply(a1, 9) ^ Multiply(a2, 14) ^ Multiply(a3, 11);
+        c[3] = Multiply(a0, 11) ^ Multiply(a1, 13) ^ Multiply(a2, 9) ^ Multiply(a3, 14);
+    }
+}
+
+void MixColumns(u8* state) {
+    for (size_t column = 0; column < 4; ++column) {
+        u8* c = state + column * 4;
+        const u8 a0 = c[0], a1 = c[1], a2 = c[2], a3 = c[3];
+        const u8 all = a0 ^ a1 ^ a2 ^ a3;
+        c[0] ^= all ^ MultiplyByTwo(a0 ^ a1);
+        c[1] ^= all ^ MultiplyByTwo(a1 ^ a2);
+        c[2] ^= all ^ MultiplyByTwo(a2 ^ a3);
+        c[3] ^= all ^ MultiplyByTwo(a3 ^ a0);
+    }
+}
+
+/// Substitutes the bytes of the state and moves row r of the state r columns to the left, or to
+/// the right when inverting.
+void SubstituteAndShift(u8* state, const std::array<u8, 256>& box, bool inverse) {
+    u8 result[BLOCK_SIZE];
+    for (size_t column = 0; column < 4; ++column) {
+        for (size_t row = 0; row < 4; ++row) {
+            const size_t source = inverse ? (column + 4 - row) % 4 : (column + row) % 4;
+            result[column * 4 + row] = box[state[source * 4 + row]];
+        }
+    }
+    std::memcpy(state, result, BLOCK_SIZE);
+}
+
+void AddRoundKey(u8* state, const u8* round_key) {
+    for (size_t i = 0; i < BLOCK_SIZE; ++i) {
+        state[i] ^= round_key[i];
+    }
+}
+
+void EncryptSoftware(const u8* round_keys, u8* dest, const u8* src, size_t count) {
+    const SBoxes& boxes = GetSBoxes();
+    for (size_t block = 0; block < count; ++block) {
+        u8 state[BLOCK_SIZE];
+        std::memcpy(state, src + block * BLOCK_SIZE, BLOCK_SIZE);
+        AddRoundKey(state, round_keys);
+        for (size_t round = 1; round < NUM_ROUNDS; ++round) {
+            SubstituteAndShift(state, boxes.forward, false);
+            MixColumns(state);
+            AddRoundKey(state, round_keys + round * BLOCK_SIZE);
+        }
+        SubstituteAndShift(state, boxes.forward, false);
+        AddRoundKey(state, round_keys + NUM_ROUNDS * BLOCK_SIZE);
+        std::memcpy(dest + block * BLOCK_SIZE, state, BLOCK_SIZE);
+    }
+}
+
+/// Runs the equivalent inverse cipher, whose round keys are in the order they are used.
+void DecryptSoftware(const u8* round_keys, u8* dest, const u8* src, size_t count) {
+    const SBoxes& boxes = GetSBoxes();
+    for (size_t block = 0; block < count; ++block) {
+        u8 state[BLOCK_SIZE];
+        std::memcpy(state, src + block * BLOCK_SIZE, BLOCK_SIZE);
+        AddRoundKey(state, round_keys);
+        for (size_t round = 1; round < NUM_ROUNDS; ++round) {
+            SubstituteAndShift(state, boxes.inverse, true);
+            InverseMixColumns(state);
+            AddRoundKey(state, round_keys + round * BLOCK_SIZE);
+        }
+        SubstituteAndShift(state, boxes.inverse, true);
+        AddRoundKey(state, round_keys + NUM_ROUNDS * BLOCK_SIZE);
+        std::memcpy(dest + block * BLOCK_SIZE, state, BLOCK_SIZE);
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+// GCC and Clang only emit AES-NI in functions that ask for it, MSVC emits it anywhere.
+#ifdef _MSC_VER
+#define TARGET_AES
+#else
+#define TARGET_AES __attribute__((target("aes,sse2")))
+#endif
+
+/// Blocks in flight at once, which hides the latency of the AES instructions.
+constexpr size_t AESNI_LANES = 8;
+
+template <bool encrypt, size_t lanes>
+TARGET_AES void ProcessAESNI(const __m128i* keys, u8* dest, const u8* src) {
+    __m128i state[lanes];
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        const auto in = reinterpret_cast<const __m128i*>(src + lane * BLOCK_SIZE);
+        state[lane] = _mm_xor_si128(_mm_loadu_si128(in), keys[0]);
+    }
+    for (size_t round = 1; round < NUM_ROUNDS; ++round) {
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            state[lane] = encrypt ? _mm_aesenc_si128(state[lane], keys[round])
+                                  : _mm_aesdec_si128(state[lane], keys[round]);
+        }
+    }
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        state[lane] = encrypt ? _mm_aesenclast_si128(state[lane], keys[NUM_ROUNDS])
+                              : _mm_aesdeclast_si128(state[lane], keys[NUM_ROUNDS]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + lane * BLOCK_SIZE), state[lane]);
+    }
+}
+
+template <bool encrypt>
+TARGET_AES void TransformAESNI(const u8* round_keys, u8* dest, const u8* src, size_t count) {
+    __m128i keys[NUM_ROUNDS + 1];
+    for (size_t round = 0; round <= NUM_ROUNDS; ++round) {
+        keys[round] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(round_keys) + round);
+    }
+
+    size_t block = 0;
+    for (; block + AESNI_LANES <= count; block += AESNI_LANES) {
+        ProcessAESNI<encrypt, AESNI_LANES>(keys, dest + block * BLOCK_SIZE,
+                                           src + block * BLOCK_SIZE);
+    }
+    for (; block < count; ++block) {
+        ProcessAESNI<encrypt, 1>(keys, dest + block * BLOCK_SIZE, src + block * BLOCK_SIZE);
+    }
+}
+
+#endif
+
+#ifdef HAVE_ARMV8_CRYPTO
+
+void EncryptARMv8(const u8* round_keys, u8* dest, const u8* src, size_t count) {
+    uint8x16_t keys[NUM_ROUNDS + 1];
+    for (size_t round = 0; round <= NUM_ROUNDS; ++round) {
+        keys[round] = vld1q_u8(round_keys + round * BLOCK_SIZE);
+    }
+    for (size_t block = 0; block < count; ++block) {
+        // AESE adds the round key before substituting, the last key is added on its own
+        uint8x16_t state = vld1q_u8(src + block * BLOCK_SIZE);
+        for (size_t round = 0; round < NUM_ROUNDS - 1; ++round) {
+            state = vaesmcq_u8(vaeseq_u8(state, keys[round]));
+        }
+        state = vaeseq_u8(state, keys[NUM_ROUNDS - 1]);
+        vst1q_u8(dest + block * BLOCK_SIZE, veorq_u8(state, keys[NUM_ROUNDS]));
+    }
+}
+
+void DecryptARMv8(const u8* round_keys, u8* dest, const u8* src, size_t count) {
+    uint8x16_t keys[NUM_ROUNDS + 1];
+    for (size_t round = 0; round <= NUM_ROUNDS; ++round) {
+        keys[round] = vld1q_u8(round_keys + round * BLOCK_SIZE);
+    }
+    for (size_t block = 0; block < count; ++block) {
+        uint8x16_t state = vld1q_u8(src + block * BLOCK_SIZE);
+        for (size_t round = 0; round < NUM_ROUNDS - 1; ++round) {
+            state = vaesimcq_u8(vaesdq_u8(state, keys[round]));
+        }
+        state = vaesdq_u8(state, keys[NUM_ROUNDS - 1]);
+        vst1q_u8(dest + block * BLOCK_SIZE, veorq_u8(state, keys[NUM_ROUNDS]));
+    }
+}
+
+#endif
+
+struct Implementation {
+    BlockFn encrypt;
+    BlockFn decrypt;
+    bool accelerated;
+};
+
+Implementation SelectImplementation() {
+#if defined(ARCHITECTURE_x86_64)
+    if (Common::GetCPUCaps().aes) {
+        return {&TransformAESNI<true>, &TransformAESNI<false>, true};
+    }
+#elif defined(HAVE_ARMV8_CRYPTO)
+    return {&EncryptARMv8, &DecryptARMv8, true};
+#endif
+    return {&EncryptSoftware, &DecryptSoftware, false};
+}
+
+const Implementation& GetImplementation() {
+    static const Implementation implementation = SelectImplementation();
+    return implementation;
+}
+
+/// Loads a u64_le or u64_be from unaligned memory.
+template <typename T>
+u64 Load64(const u8* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void Store64(u8* data, u64 value) {
+    const T stored = value;
+    std::memcpy(data, &stored, sizeof(T));
+}
+
+/// dest = a ^ b, eight bytes at a time. dest may be the same as a.
+void XorBytes(u8* dest, const u8* a, const u8* b, size_t length) {
+    size_t i = 0;
+    for (; i + sizeof(u64) <= length; i += sizeof(u64)) {
+        u64 x, y;
+        std::memcpy(&x, a + i, sizeof(u64));
+        std::memcpy(&y, b + i, sizeof(u64));
+        x ^= y;
+        std::memcpy(dest + i, &x, sizeof(u64));
+    }
+    for (; i < length; ++i) {
+        dest[i] = a[i] ^ b[i];
+    }
+}
+
+template <bool encrypt>
+void TransformXTS(const AESEngine& data_engine, const AESEngine& tweak_engine, u64 sector,
+                  size_t sector_size, TweakByteOrder order, u8* dest, const u8* src,
+                  size_t length) {
+    ASSERT_MSG(sector_size != 0 && sector_size % BLOCK_SIZE == 0, "Invalid XTS sector size %zu",
+               sector_size);
+    ASSERT_MSG(length % BLOCK_SIZE == 0, "XTS data of %zu bytes is not made of whole blocks",
+               length);
+
+    alignas(16) std::array<u8, BATCH_BLOCKS * BLOCK_SIZE> tweaks;
+    for (size_t sector_offset = 0; sector_offset < length; sector_offset += sector_size, ++sector) {
+        alignas(16) Block tweak{};
+        if (order == TweakByteOrder::Little) {
+            Store64<u64_le>(tweak.data(), sector);
+        } else {
+            Store64<u64_be>(tweak.data() + sizeof(u64), sector);
+        }
+        tweak_engine.EncryptBlocks(tweak.data(), tweak.data(), 1);
+        u64 tweak_low = Load64<u64_le>(tweak.data());
+        u64 tweak_high = Load64<u64_le>(tweak.data() + sizeof(u64));
+
+        const size_t sector_length = std::min(sector_size, length - sector_offset);
+        for (size_t done = 0; done < sector_length;) {
+            const size_t num_blocks = std::min(BATCH_BLOCKS, (sector_length - done) / BLOCK_SIZE);
+            for (size_t block = 0; block < num_blocks; ++block) {
+                Store64<u64_le>(tweaks.data() + block * BLOCK_SIZE, tweak_low);
+                Store64<u64_le>(tweaks.data() + block * BLOCK_SIZE + sizeof(u64), tweak_high);
+                // Multiply the tweak by x in GF(2^128)
+                const u64 carry = tweak_high >> 63;
+                tweak_high = (tweak_high << 1) | (tweak_low >> 63);
+                tweak_low = (tweak_low << 1) ^ (carry * 0x87);
+            }
+
+            const size_t batch_length = num_blocks * BLOCK_SIZE;
+            u8* const out = dest + sector_offset + done;
+            XorBytes(out, src + sector_offset + done, tweaks.data(), batch_length);
+            if (encrypt) {
+                data_engine.EncryptBlocks(out, out, num_blocks);
+            } else {
+                data_engine.DecryptBlocks(out, out, num_blocks);
+            }
+            XorBytes(out, out, tweaks.data(), batch_length);
+            done += batch_length;
+        }
+    }
+}
+
+} // Anonymous namespace
+
+AESEngine::AESEngine(const Key128& key) {
+    const SBoxes& boxes = GetSBoxes();
+    std::memcpy(encrypt_keys.data(), key.data(), key.size());
+    u8 round_constant = 1;
+    for (size_t i = key.size(); i < encrypt_keys.size(); i += 4) {
+        u8 word[4];
+        std::memcpy(word, &encrypt_keys[i - 4], sizeof(word));
+        if (i % BLOCK_SIZE == 0) {
+            const u8 first = word[0];
+            word[0] = boxes.forward[word[1]] ^ round_constant;
+            word[1] = boxes.forward[word[2]];
+            word[2] = boxes.forward[word[3]];
+            word[3] = boxes.forward[first];
+            round_constant = MultiplyByTwo(round_constant);
+        }
+        for (size_t j = 0; j < 4; ++j) {
+            encrypt_keys[i + j] = encrypt_keys[i - BLOCK_SIZE + j] ^ word[j];
+        }
+    }
+
+    // The equivalent inverse cipher takes the round keys backwards, with the columns of the inner
+    // ones unmixed. AES-NI and ARMv8 expect the same keys.
+    for (size_t round = 0; round <= NUM_ROUNDS; ++round) {
+        u8* const decrypt_key = &decrypt_keys[round * BLOCK_SIZE];
+        std::memcpy(decrypt_key, &encrypt_keys[(NUM_ROUNDS - round) * BLOCK_SIZE], BLOCK_SIZE);
+        if (round != 0 && round != NUM_ROUNDS) {
+            InverseMixColumns(decrypt_key);
+        }
+    }
+}
+
+void AESEngine::EncryptBlocks(u8* dest, const u8* src, size_t count) const {
+    GetImplementation().encrypt(encrypt_keys.data(), dest, src, count);
+}
+
+void AESEngine::DecryptBlocks(u8* dest, const u8* src, size_t count) const {
+    GetImplementation().decrypt(decrypt_keys.data(), dest, src, count);
+}
+
+bool AESEngine::IsAccelerated() {
+    return GetImplementation().accelerated;
+}
+
+void TransformCTR(const AESEngine& engine, const Block& iv, u64 offset, u8* dest, const u8* src,
+                  size_t length) {
+    const u64 iv_high = Load64<u64_be>(iv.data());
+    const u64 iv_low = Load64<u64_be>(iv.data() + sizeof(u64));
+
+    alignas(16) std::array<u8, BATCH_BLOCKS * BLOCK_SIZE> keystream;
+    u64 block = offset / BLOCK_SIZE;
+    size_t skip = static_cast<size_t>(offset % BLOCK_SIZE);
+    size_t done = 0;
+    while (done < length) {
+        const size_t num_blocks =
+            std::min(BATCH_BLOCKS, (skip + length - done + BLOCK_SIZE - 1) / BLOCK_SIZE);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            const u64 counter_low = iv_low + block + i;
+            const u64 counter_high = iv_high + (counter_low < iv_low ? 1 : 0);
+            Store64<u64_be>(keystream.data() + i * BLOCK_SIZE, counter_high);
+            Store64<u64_be>(keystream.data() + i * BLOCK_SIZE + sizeof(u64), counter_low);
+        }
+        engine.EncryptBlocks(keystream.data(), keystream.data(), num_blocks);
+
+        const size_t chunk = std::min(num_blocks * BLOCK_SIZE - skip, length - done);
+        XorBytes(dest + done, src + done, keystream.data() + skip, chunk);
+        done += chunk;
+        block += num_blocks;
+        skip = 0;
+    }
+}
+
+void EncryptXTS(const AESEngine& data_engine, const AESEngine& tweak_engine, u64 sector,
+                size_t sector_size, TweakByteOrder order, u8* dest, const u8* src, size_t length) {
+    TransformXTS<true>(data_engine, tweak_engine, sector, sector_size, order, dest, src, length);
+}
+
+void DecryptXTS(const AESEngine& data_engine, const AESEngine& tweak_engine, u64 sector,
+                size_t sector_size, TweakByteOrder order, u8* dest, const u8* src, size_t length) {
+    TransformXTS<false>(data_engine, tweak_engine, sector, sector_size, order, dest, src, length);
+}
+
+} // namespace HW::AES
@@ -0,0 +1,76 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace HW::AES {
+
+constexpr size_t BLOCK_SIZE = 16;
+
+using Key128 = std::array<u8, 16>;
+/// Initial counter of CTR mode, or a single block of data
+using Block = std::array<u8, BLOCK_SIZE>;
+
+/// Byte order of the sector number in the tweak of XTS mode.
+enum class TweakByteOrder {
+    /// Least significant byte first, as in IEEE 1619
+    Little,
+    /// Most significant byte last, as in the header of NCA files
+    Big,
+};
+
+/**
+ * AES-128 cipher with an expanded key. Blocks are processed with AES-NI or the ARMv8
+ * cryptography extensions when the host has them, and in software otherwise.
+ */
+class AESEngine final {
+public:
+    explicit AESEngine(const Key128& key);
+
+    /// Encrypts count consecutive blocks. dest may be the same as src.
+    void EncryptBlocks(u8* dest, const u8* src, size_t count) const;
+
+    /// Decrypts count consecutive blocks. dest may be the same as src.
+    void DecryptBlocks(u8* dest, const u8* src, size_t count) const;
+
+    /// Returns whether the blocks are processed by cryptography instructions of the host.
+    static bool IsAccelerated();
+
+private:
+    using RoundKeys = std::array<u8, 11 * BLOCK_SIZE>;
+
+    alignas(16) RoundKeys encrypt_keys;
+    /// Round keys of the equivalent inverse cipher
+    alignas(16) RoundKeys decrypt_keys;
+};
+
+/**
+ * Encrypts or decrypts data in CTR mode, which are the same operation. The counter of each block
+ * is the 128-bit big-endian sum of iv and the position of the block in the stream, so any part of
+ * a stream can be processed on its own.
+ * @param offset Position of the data in the stream, which doesn't have to fall on a block.
+ * @param dest Buffer to write the result to. It may be the same as src.
+ */
+void TransformCTR(const AESEngine& engine, const Block& iv, u64 offset, u8* dest, const u8* src,
+                  size_t length);
+
+/**
+ * Encrypts consecutive sectors in XTS mode.
+ * @param sector Number of the first sector
+ * @param sector_size Size of a sector in bytes, a multiple of BLOCK_SIZE
+ * @param length Size of the data in bytes, a multiple of BLOCK_SIZE. The last sector may be
+ *               shorter than the others.
+ */
+void EncryptXTS(const AESEngine& data_engine, const AESEngine& tweak_engine, u64 sector,
+                size_t sector_size, TweakByteOrder order, u8* dest, const u8* src, size_t length);
+
+/// Decrypts consecutive sectors in XTS mode, with the same parameters as EncryptXTS.
+void DecryptXTS(const AESEngine& data_engine, const AESEngine& tweak_engine, u64 sector,
+                size_t sector_size, TweakByteOrder order, u8* dest, const u8* src, size_t length);
+
+} // namespace HW::AES
@@ -178,19 +178,20 @@ typedef int SectionID;
 
 class ElfReader {
 private:
-    char* base;
-    u32* base32;
+    const char* base;
+    const u32* base32;
+    size_t size;
 
-    Elf32_Ehdr* header;
-    Elf32_Phdr* segments;
-    Elf32_Shdr* sections;
+    const Elf32_Ehdr* header;
+    const Elf32_Phdr* segments;
+    const Elf32_Shdr* sections;
 
     u32* sectionAddrs;
     bool relocate;
     u32 entryPoint;
 
 public:
-    ElfReader(void* ptr);
+    ElfReader(const void* ptr, size_t size);
 
     u32 Read32(int off) const {
         return base32[off >> 2];
@@ -218,7 +219,7 @@ public:
         return (int)(header->e_shnum);
     }
     const u8* GetPtr(int offset) const {
-        return (u8*)base + offset;
+        return (const u8*)base + offset;
     }
     const char* GetSectionName(int section) const;
     const u8* GetSectionDataPtr(int section) const {
@@ -248,13 +249,13 @@ public:
     }
 };
 
-ElfReader::ElfReader(void* ptr) {
-    base = (char*)ptr;
-    base32 = (u32*)ptr;
-    header = (Elf32_Ehdr*)ptr;
+ElfReader::ElfReader(const void* ptr, size_t size) : size(size) {
+    base = (const char*)ptr;
+    base32 = (const u32*)ptr;
+    header = (const Elf32_Ehdr*)ptr;
 
-    segments = (Elf32_Phdr*)(base + header->e_phoff);
-    sections = (Elf32_Shdr*)(base + header->e_shoff);
+    segments = (const Elf32_Phdr*)(base + header->e_phoff);
+    sections = (const Elf32_Shdr*)(base + header->e_shoff);
 
     entryPoint = header->e_entry;
 }
@@ -291,7 +292,7 @@ SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
 
     u32 total_image_size = 0;
     for (unsigned int i = 0; i < header->e_phnum; ++i) {
-        Elf32_Phdr* p = &segments[i];
+        const Elf32_Phdr* p = &segments[i];
         if (p->p_type == PT_LOAD) {
             total_image_size += (p->p_memsz + 0xFFF) & ~0xFFF;
         }
@@ -303,7 +304,7 @@ SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
     SharedPtr<CodeSet> codeset = CodeSet::Create("");
 
     for (unsigned int i = 0; i < header->e_phnum; ++i) {
-        Elf32_Phdr* p = &segments[i];
+        const Elf32_Phdr* p = &segments[i];
         LOG_DEBUG(Loader, "Type: %i Vaddr: %08X Filesz: %8X Memsz: %8X ", p->p_type, p->p_vaddr,
                   p->p_filesz, p->p_memsz);
 
@@ -330,6 +331,12 @@ SharedPtr<CodeSet> ElfReader::LoadInto(u32 vaddr) {
                 continue;
             }
 
+            if (p->p_filesz > p->p_memsz || p->p_offset > size ||
+                p->p_filesz > size - p->p_offset) {
+                LOG_ERROR(Loader, "ELF segment id %u is past the end of the file", i);
+                continue;
+            }
+
             u32 segment_addr = base_addr + p->p_vaddr;
             u32 aligned_size = (p->p_memsz + 0xFFF) & ~0xFFF;
 
@@ -394,15 +401,23 @@ ResultStatus AppLoader_ELF::Load(Kernel::SharedPtr<Kernel::Process>& process) {
     if (!file.IsOpen())
         return ResultStatus::Error;
 
-    // Reset read pointer in case this file has been read before.
-    file.Seek(0, SEEK_SET);
-
-    size_t size = file.GetSize();
-    std::unique_ptr<u8[]> buffer(new u8[size]);
-    if (file.ReadBytes(&buffer[0], size) != size)
+    // The segments are copied straight out of a mapping of the file, which leaves the rest of
+    // it, such as the debug information of test executables, unread.
+    const FileUtil::MappedFile mapping(file, FileUtil::MappedFile::AccessPattern::Sequential);
+    std::unique_ptr<u8[]> buffer;
+    const u8* data = mapping.Data();
+    size_t size = static_cast<size_t>(mapping.Size());
+    if (!mapping.IsMapped()) {
+        size = file.GetSize();
+        buffer.reset(new u8[size]);
+        if (file.ReadAt(&buffer[0], size, 0) != size)
+            return ResultStatus::Error;
+        data = &buffer[0];
+    }
+    if (size < sizeof(Elf32_Ehdr))
         return ResultStatus::Error;
 
-    ElfReader elf_reader(&buffer[0]);
+    ElfReader elf_reader(data, size);
     SharedPtr<CodeSet> codeset = elf_reader.LoadInto(Memory::PROCESS_IMAGE_VADDR);
     codeset->name = filename;
 
@@ -2,11 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
+#include <cstring>
 #include <vector>
 
 #include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
+#include "core/arm/guest_profiler.h"
 #include "core/loader/linker.h"
 #include "core/memory.h"
 
@@ -51,36 +54,58 @@ static_assert(sizeof(Elf64_Sym) == 0x18, "Elf64_Sym has incorrect size.");
 void Linker::WriteRelocations(std::vector<u8>& program_image, const std::vector<Symbol>& symbols,
                               u64 relocation_offset, u64 size, bool is_jump_relocation,
                               VAddr load_base) {
-    for (u64 i = 0; i < size; i += sizeof(Elf64_Rela)) {
+    if (relocation_offset > program_image.size() ||
+        size > program_image.size() - relocation_offset) {
+        LOG_ERROR(Loader, "Relocation table is past the end of the image");
+        return;
+    }
+
+    const auto write_value = [&program_image](u64 offset, u64 value) {
+        if (offset > program_image.size() - sizeof(u64)) {
+            LOG_ERROR(Loader, "Relocation at 0x%" PRIx64 " is past the end of the image", offset);
+            return;
+        }
+        std::memcpy(&program_image[offset], &value, sizeof(u64));
+    };
+
+    for (u64 i = 0; i + sizeof(Elf64_Rela) <= size; i += sizeof(Elf64_Rela)) {
         Elf64_Rela rela;
         std::memcpy(&rela, &program_image[relocation_offset + i], sizeof(Elf64_Rela));
 
-        const Symbol& symbol = symbols[rela.symbol];
-        switch (rela.type) {
-        case RelocationType::RELATIVE: {
+        // Relative relocations make up most of the table, and only need the symbol when it has
+        // a name to export.
+        if (rela.type == RelocationType::RELATIVE) {
             const u64 value = load_base + rela.addend;
-            if (!symbol.name.empty()) {
-                exports[symbol.name] = value;
+            if (rela.symbol != 0 && rela.symbol < symbols.size() &&
+                !symbols[rela.symbol].name.empty()) {
+                exports[symbols[rela.symbol].name] = value;
             }
-            std::memcpy(&program_image[rela.offset], &value, sizeof(u64));
-            break;
+            write_value(rela.offset, value);
+            continue;
+        }
+
+        if (rela.symbol >= symbols.size()) {
+            LOG_ERROR(Loader, "Relocation refers to unknown symbol %u", rela.symbol);
+            continue;
         }
+        const Symbol& symbol = symbols[rela.symbol];
+        switch (rela.type) {
         case RelocationType::JUMP_SLOT:
         case RelocationType::GLOB_DAT:
             if (!symbol.value) {
-                imports[symbol.name] = {rela.offset + load_base, 0};
+                imports.push_back({symbol.name, rela.offset + load_base, 0});
             } else {
                 exports[symbol.name] = symbol.value;
-                std::memcpy(&program_image[rela.offset], &symbol.value, sizeof(u64));
+                write_value(rela.offset, symbol.value);
             }
             break;
         case RelocationType::ABS64:
             if (!symbol.value) {
-                imports[symbol.name] = {rela.offset + load_base, rela.addend};
+                imports.push_back({symbol.name, rela.offset + load_base, rela.addend});
             } else {
                 const u64 value = symbol.value + rela.addend;
                 exports[symbol.name] = value;
-                std::memcpy(&program_image[rela.offset], &value, sizeof(u64));
+                write_value(rela.offset, value);
             }
             break;
         default:
@@ -105,7 +130,13 @@ void Linker::Relocate(std::vector<u8>& program_image, u32 dynamic_section_offset
 
     u64 offset = dynamic[DT_SYMTAB];
     std::vector<Symbol> symbols;
-    while (offset < program_image.size()) {
+    // The string table usually follows the symbol table, which bounds the number of symbols.
+    if (dynamic[DT_STRTAB] > offset && dynamic[DT_STRTAB] <= program_image.size()) {
+        const size_t num_symbols = (dynamic[DT_STRTAB] - offset) / sizeof(Elf64_Sym);
+        symbols.reserve(num_symbols);
+        exports.reserve(exports.size() + num_symbols);
+    }
+    while (offset + sizeof(Elf64_Sym) <= program_image.size()) {
         Elf64_Sym sym;
         std::memcpy(&sym, &program_image[offset], sizeof(Elf64_Sym));
         offset += sizeof(Elf64_Sym);
@@ -117,6 +148,7 @@ void Linker::Relocate(std::vector<u8>& program_image, u32 dynamic_section_offset
         std::string name = reinterpret_cast<char*>(&program_image[dynamic[DT_STRTAB] + sym.name]);
         if (sym.value) {
             exports[name] = load_base + sym.value;
+            GuestProfiler::RegisterSymbol(name, load_base + sym.value);
             symbols.emplace_back(std::move(name), load_base + sym.value);
         } else {
             symbols.emplace_back(std::move(name), 0);
@@ -136,12 +168,12 @@ void Linker::Relocate(std::vector<u8>& program_image, u32 dynamic_section_offset
 
 void Linker::ResolveImports() {
     // Resolve imports
-    for (const auto& import : imports) {
-        const auto& search = exports.find(import.first);
+    for (const Import& import : imports) {
+        const auto search = exports.find(import.name);
         if (search != exports.end()) {
-            Memory::Write64(import.second.ea, search->second + import.second.addend);
+            Memory::Write64(import.ea, search->second + import.addend);
         } else {
-            LOG_ERROR(Loader, "Unresolved import: %s", import.first.c_str());
+            LOG_ERROR(Loader, "Unresolved import: %s", import.name.c_str());
         }
     }
 }
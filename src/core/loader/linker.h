@@ -4,8 +4,10 @@
 
 #pragma once
 
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
+#include "common/cityhash.h"
 #include "common/common_types.h"
 
 namespace Loader {
@@ -19,10 +21,17 @@ protected:
     };
 
     struct Import {
+        std::string name;
         VAddr ea;
         s64 addend;
     };
 
+    struct SymbolNameHash {
+        size_t operator()(const std::string& name) const {
+            return static_cast<size_t>(Common::CityHash64(name.data(), name.size()));
+        }
+    };
+
     void WriteRelocations(std::vector<u8>& program_image, const std::vector<Symbol>& symbols,
                           u64 relocation_offset, u64 size, bool is_jump_relocation,
                           VAddr load_base);
@@ -30,8 +39,9 @@ protected:
 
     void ResolveImports();
 
-    std::map<std::string, Import> imports;
-    std::map<std::string, VAddr> exports;
+    /// Every slot that refers to an undefined symbol, in relocation order
+    std::vector<Import> imports;
+    std::unordered_map<std::string, VAddr, SymbolNameHash> exports;
 };
 
 } // namespace Loader
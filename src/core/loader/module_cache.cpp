@@ -0,0 +1,132 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include "common/common_funcs.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/swap.h"
+#include "core/loader/module_cache.h"
+#include "core/settings.h"
+
+namespace Loader::ModuleCache {
+
+namespace {
+
+constexpr u32 CACHE_VERSION = 2;
+
+struct CachedSegment {
+    u64_le offset;
+    u64_le addr;
+    u32_le size;
+    INSERT_PADDING_WORDS(1);
+    u64_le content_hash;
+};
+static_assert(sizeof(CachedSegment) == 0x20, "CachedSegment has incorrect size.");
+
+struct CacheHeader {
+    u32_le magic;
+    u32_le version;
+    u64_le key;
+    u64_le load_base;
+    /// Size of the program image, and of the part of it stored after the header. The rest of the
+    /// image is zero, which leaves .bss out of the file.
+    u64_le image_size;
+    u64_le stored_size;
+    std::array<CachedSegment, 3> segments;
+};
+static_assert(sizeof(CacheHeader) == 0x88, "CacheHeader has incorrect size.");
+
+std::string GetCachePath(u64 key, VAddr load_base) {
+    return Common::StringFromFormat("%smodules/%016" PRIX64 "_%016" PRIX64 ".bin",
+                                    FileUtil::GetUserPath(D_CACHE_IDX).c_str(), key, load_base);
+}
+
+} // Anonymous namespace
+
+bool Load(u64 key, VAddr load_base, Kernel::CodeSet& codeset) {
+    if (!Settings::values.use_loader_cache) {
+        return false;
+    }
+
+    const std::string path = GetCachePath(key, load_base);
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    CacheHeader header{};
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header) ||
+        header.magic != Common::MakeMagic('Y', 'M', 'C', '0') || header.version != CACHE_VERSION ||
+        header.key != key || header.load_base != load_base ||
+        header.stored_size > header.image_size ||
+        file.GetSize() != sizeof(header) + header.stored_size) {
+        LOG_WARNING(Loader, "Ignoring invalid module cache entry %s", path.c_str());
+        return false;
+    }
+
+    auto memory = std::make_shared<std::vector<u8>>(header.image_size);
+    if (file.ReadBytes(memory->data(), header.stored_size) != header.stored_size) {
+        return false;
+    }
+
+    for (size_t i = 0; i < header.segments.size(); ++i) {
+        codeset.segments[i].offset = header.segments[i].offset;
+        codeset.segments[i].addr = header.segments[i].addr;
+        codeset.segments[i].size = header.segments[i].size;
+        codeset.segments[i].content_hash = header.segments[i].content_hash;
+    }
+    codeset.memory = std::move(memory);
+
+    LOG_DEBUG(Loader, "Loaded module image from %s", path.c_str());
+    return true;
+}
+
+void Store(u64 key, VAddr load_base, const Kernel::CodeSet& codeset) {
+    if (!Settings::values.use_loader_cache) {
+        return;
+    }
+
+    const std::vector<u8>& image = *codeset.memory;
+    const auto last_non_zero =
+        std::find_if(image.rbegin(), image.rend(), [](u8 byte) { return byte != 0; });
+
+    CacheHeader header{};
+    header.magic = Common::MakeMagic('Y', 'M', 'C', '0');
+    header.version = CACHE_VERSION;
+    header.key = key;
+    header.load_base = load_base;
+    header.image_size = image.size();
+    header.stored_size = image.rend() - last_non_zero;
+    for (size_t i = 0; i < header.segments.size(); ++i) {
+        header.segments[i].offset = codeset.segments[i].offset;
+        header.segments[i].addr = codeset.segments[i].addr;
+        header.segments[i].size = codeset.segments[i].size;
+        header.segments[i].content_hash = codeset.segments[i].content_hash;
+    }
+
+    // Written under a temporary name first, so that a partly written entry is never loaded.
+    const std::string path = GetCachePath(key, load_base);
+    const std::string temp_path = path + ".tmp";
+    if (!FileUtil::CreateFullPath(path)) {
+        return;
+    }
+    {
+        FileUtil::IOFile file(temp_path, "wb");
+        if (!file.IsOpen() || file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
+            file.WriteBytes(image.data(), header.stored_size) != header.stored_size) {
+            LOG_ERROR(Loader, "Unable to write module cache entry %s", temp_path.c_str());
+            file.Close();
+            FileUtil::Delete(temp_path);
+            return;
+        }
+    }
+    if (!FileUtil::Rename(temp_path, path)) {
+        FileUtil::Delete(temp_path);
+    }
+}
+
+} // namespace Loader::ModuleCache
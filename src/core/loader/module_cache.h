@@ -0,0 +1,35 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include "common/common_types.h"
+#include "core/hle/kernel/process.h"
+
+/**
+ * On-disk cache of the program images built by the module loaders, so that a module loaded again
+ * at the same address is read back as it was left instead of being decompressed again. Entries are
+ * kept in the cache directory of the user path, and the cache is only used when
+ * Settings::values.use_loader_cache is set.
+ */
+namespace Loader::ModuleCache {
+
+/**
+ * Restores a program image from the cache.
+ * @param key Key identifying the contents of the module file.
+ * @param load_base Address the module is loaded at.
+ * @param codeset Code set to fill in with the segments and memory of the cached image.
+ * @returns Whether the image was found in the cache.
+ */
+bool Load(u64 key, VAddr load_base, Kernel::CodeSet& codeset);
+
+/**
+ * Saves the program image of a code set to the cache.
+ * @param key Key identifying the contents of the module file.
+ * @param load_base Address the module is loaded at.
+ * @param codeset Code set whose segments and memory are saved.
+ */
+void Store(u64 key, VAddr load_base, const Kernel::CodeSet& codeset);
+
+} // namespace Loader::ModuleCache
@@ -83,13 +83,7 @@ bool AppLoader_NRO::LoadNro(const std::string& path, VAddr load_base) {
         return {};
     }
 
-    // Build program image
     Kernel::SharedPtr<Kernel::CodeSet> codeset = Kernel::CodeSet::Create("");
-    std::vector<u8> program_image;
-    program_image.resize(PageAlignSize(nro_header.file_size));
-    file.Seek(0, SEEK_SET);
-    file.ReadBytes(program_image.data(), nro_header.file_size);
-
     for (int i = 0; i < nro_header.segments.size(); ++i) {
         codeset->segments[i].addr = nro_header.segments[i].offset;
         codeset->segments[i].offset = nro_header.segments[i].offset;
@@ -100,19 +94,33 @@ bool AppLoader_NRO::LoadNro(const std::string& path, VAddr load_base) {
     ModHeader mod_header{};
     // Default .bss to NRO header bss size if MOD0 section doesn't exist
     u32 bss_size{PageAlignSize(nro_header.bss_size)};
-    std::memcpy(&mod_header, program_image.data() + nro_header.module_header_offset,
-                sizeof(ModHeader));
-    const bool has_mod_header{mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
+    file.Seek(nro_header.module_header_offset, SEEK_SET);
+    const bool has_mod_header{file.ReadBytes(&mod_header, sizeof(ModHeader)) ==
+                                  sizeof(ModHeader) &&
+                              mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
     if (has_mod_header) {
-        // Resize program image to include .bss section and page align each section
+        // The MOD header has the last word on the size of .bss
         bss_size = PageAlignSize(mod_header.bss_end_offset - mod_header.bss_start_offset);
     }
     codeset->data.size += bss_size;
-    program_image.resize(static_cast<u32>(program_image.size()) + bss_size);
+
+    // Map the program image straight from the file, so that the pages the program never writes
+    // stay shared with the OS file cache, and the .bss pages only take memory once they are used.
+    const u32 image_size = PageAlignSize(nro_header.file_size);
+    auto mapping = std::make_shared<FileUtil::CopyOnWriteMapping>(
+        file, nro_header.file_size, image_size - nro_header.file_size + bss_size);
+    if (mapping->IsMapped()) {
+        codeset->mapping = std::move(mapping);
+    } else {
+        LOG_WARNING(Loader, "Failed to map %s, reading it into memory instead", path.c_str());
+        std::vector<u8> program_image(image_size + bss_size);
+        file.Seek(0, SEEK_SET);
+        file.ReadBytes(program_image.data(), nro_header.file_size);
+        codeset->memory = std::make_shared<std::vector<u8>>(std::move(program_image));
+    }
 
     // Load codeset for current process
     codeset->name = path;
-    codeset->memory = std::make_shared<std::vector<u8>>(std::move(program_image));
     Core::CurrentProcess()->LoadModule(codeset, load_base);
 
     return true;
@@ -2,16 +2,23 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cinttypes>
+#include <future>
+#include <limits>
 #include <vector>
 #include <lz4.h>
+#include "common/cityhash.h"
 #include "common/common_funcs.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
 #include "core/core.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/resource_limit.h"
+#include "core/loader/module_cache.h"
 #include "core/loader/nso.h"
 #include "core/memory.h"
 
@@ -38,6 +45,9 @@ struct NsoHeader {
 };
 static_assert(sizeof(NsoHeader) == 0x6c, "NsoHeader has incorrect size.");
 
+/// Size of the header in the file, which goes on past NsoHeader up to the segment hashes
+constexpr u64 NSO_HEADER_FULL_SIZE = 0x100;
+
 struct ModHeader {
     u32_le magic;
     u32_le dynamic_offset;
@@ -66,33 +76,25 @@ FileType AppLoader_NSO::IdentifyType(FileUtil::IOFile& file, const std::string&)
     return FileType::Error;
 }
 
-static std::vector<u8> ReadSegment(FileUtil::IOFile& file, const NsoSegmentHeader& header,
-                                   int compressed_size) {
-    std::vector<u8> compressed_data;
-    compressed_data.resize(compressed_size);
-
-    file.Seek(header.offset, SEEK_SET);
-    if (compressed_size != file.ReadBytes(compressed_data.data(), compressed_size)) {
-        LOG_CRITICAL(Loader, "Failed to read %d NSO LZ4 compressed bytes", compressed_size);
-        return {};
-    }
-
-    std::vector<u8> uncompressed_data;
-    uncompressed_data.resize(header.size);
-    const int bytes_uncompressed = LZ4_decompress_safe(
-        reinterpret_cast<const char*>(compressed_data.data()),
-        reinterpret_cast<char*>(uncompressed_data.data()), compressed_size, header.size);
-
-    ASSERT_MSG(bytes_uncompressed == header.size && bytes_uncompressed == uncompressed_data.size(),
-               "%d != %u != %zu", bytes_uncompressed, header.size, uncompressed_data.size());
-
-    return uncompressed_data;
+/**
+ * Decompresses a segment straight into its place in the program image.
+ * @returns Whether the segment decompressed to exactly the size given in its header.
+ */
+static bool DecompressSegment(const u8* compressed_data, u32 compressed_size, u8* output,
+                              u32 size) {
+    const int bytes_uncompressed =
+        LZ4_decompress_safe(reinterpret_cast<const char*>(compressed_data),
+                            reinterpret_cast<char*>(output), compressed_size, size);
+    return bytes_uncompressed == static_cast<int>(size);
 }
 
 static constexpr u32 PageAlignSize(u32 size) {
     return (size + Memory::PAGE_MASK) & ~Memory::PAGE_MASK;
 }
 
+/// Largest program image, including its .bss, whose page aligned size fits in 32 bits
+static constexpr u64 MaxImageSize = std::numeric_limits<u32>::max() - Memory::PAGE_MASK;
+
 VAddr AppLoader_NSO::LoadModule(const std::string& path, VAddr load_base) {
     FileUtil::IOFile file(path, "rb");
     if (!file.IsOpen()) {
@@ -109,33 +111,120 @@ VAddr AppLoader_NSO::LoadModule(const std::string& path, VAddr load_base) {
         return {};
     }
 
-    // Build program image
+    // The compressed segments are read from a mapping of the file, or from a single read of the
+    // whole file where it can't be mapped.
+    const FileUtil::MappedFile mapping(file, FileUtil::MappedFile::AccessPattern::Sequential);
+    std::vector<u8> file_data;
+    const u8* file_base = mapping.Data();
+    u64 file_size = mapping.Size();
+    if (!mapping.IsMapped()) {
+        file_data.resize(file.GetSize());
+        if (file.ReadAt(file_data.data(), file_data.size(), 0) != file_data.size()) {
+            LOG_CRITICAL(Loader, "%s: Failed to read NSO file", path.c_str());
+            return {};
+        }
+        file_base = file_data.data();
+        file_size = file_data.size();
+    }
+
+    // The full header includes the hashes of the uncompressed segments, so together with the size
+    // of the file it identifies the program image.
+    const u64 cache_key = Common::CityHash64WithSeed(
+        reinterpret_cast<const char*>(file_base),
+        static_cast<size_t>(std::min<u64>(file_size, NSO_HEADER_FULL_SIZE)), file_size);
     Kernel::SharedPtr<Kernel::CodeSet> codeset = Kernel::CodeSet::Create("");
+    if (ModuleCache::Load(cache_key, load_base, *codeset)) {
+        codeset->name = path;
+        const VAddr end = load_base + codeset->memory->size();
+        Core::CurrentProcess()->LoadModule(codeset, load_base);
+        return end;
+    }
+
+    // Lay the program image out from the segment headers, so that each segment can be
+    // decompressed straight into its final place. Each segment starts past the end of the one
+    // before it, so all of them end within the image.
+    u64 image_data_size = 0;
+    for (const NsoSegmentHeader& segment : nso_header.segments) {
+        if (segment.location < image_data_size) {
+            LOG_CRITICAL(Loader, "%s: NSO segments overlap", path.c_str());
+            return {};
+        }
+        image_data_size = u64(segment.location) + segment.size;
+    }
+    // The image, along with its .bss, has to be addressable with 32 bits once page aligned
+    if (image_data_size > MaxImageSize) {
+        LOG_CRITICAL(Loader, "%s: NSO segments are too large", path.c_str());
+        return {};
+    }
     std::vector<u8> program_image;
-    for (int i = 0; i < nso_header.segments.size(); ++i) {
-        std::vector<u8> data =
-            ReadSegment(file, nso_header.segments[i], nso_header.segments_compressed_size[i]);
-        program_image.resize(nso_header.segments[i].location);
-        program_image.insert(program_image.end(), data.begin(), data.end());
+    program_image.reserve(PageAlignSize(image_data_size) +
+                          PageAlignSize(nso_header.segments[2].bss_size));
+    program_image.resize(image_data_size);
+
+    for (size_t i = 0; i < nso_header.segments.size(); ++i) {
+        const u64 segment_end =
+            u64(nso_header.segments[i].offset) + nso_header.segments_compressed_size[i];
+        if (segment_end > file_size) {
+            LOG_CRITICAL(Loader, "%s: NSO segment %zu is past the end of the file", path.c_str(),
+                         i);
+            return {};
+        }
+    }
+
+    // The segments are independent of each other, so they are decompressed and hashed in
+    // parallel.
+    std::array<std::future<bool>, 3> segments_decompressed;
+    for (size_t i = 0; i < nso_header.segments.size(); ++i) {
+        segments_decompressed[i] = std::async(std::launch::async, [&, i] {
+            const NsoSegmentHeader& segment = nso_header.segments[i];
+            u8* const output = program_image.data() + segment.location;
+            if (!DecompressSegment(file_base + segment.offset,
+                                   nso_header.segments_compressed_size[i], output,
+                                   segment.size)) {
+                return false;
+            }
+            codeset->segments[i].content_hash = Common::ComputeHash64(output, segment.size);
+            return true;
+        });
+    }
+
+    bool decompressed = true;
+    for (size_t i = 0; i < nso_header.segments.size(); ++i) {
+        if (!segments_decompressed[i].get()) {
+            LOG_CRITICAL(Loader, "%s: Failed to decompress NSO segment %zu", path.c_str(), i);
+            decompressed = false;
+        }
         codeset->segments[i].addr = nso_header.segments[i].location;
         codeset->segments[i].offset = nso_header.segments[i].location;
-        codeset->segments[i].size = PageAlignSize(static_cast<u32>(data.size()));
+        codeset->segments[i].size = PageAlignSize(nso_header.segments[i].size);
     }
+    if (!decompressed) {
+        return {};
+    }
+    LOG_DEBUG(Loader, "%s: .text hash %016" PRIX64, path.c_str(), codeset->code.content_hash);
 
     // MOD header pointer is at .text offset + 4
-    u32 module_offset;
-    std::memcpy(&module_offset, program_image.data() + 4, sizeof(u32));
+    u32 module_offset = 0;
+    if (program_image.size() >= 8) {
+        std::memcpy(&module_offset, program_image.data() + 4, sizeof(u32));
+    }
 
     // Read MOD header
     ModHeader mod_header{};
     // Default .bss to size in segment header if MOD0 section doesn't exist
     u32 bss_size{PageAlignSize(nso_header.segments[2].bss_size)};
-    std::memcpy(&mod_header, program_image.data() + module_offset, sizeof(ModHeader));
+    if (u64(module_offset) + sizeof(ModHeader) <= program_image.size()) {
+        std::memcpy(&mod_header, program_image.data() + module_offset, sizeof(ModHeader));
+    }
     const bool has_mod_header{mod_header.magic == Common::MakeMagic('M', 'O', 'D', '0')};
     if (has_mod_header) {
         // Resize program image to include .bss section and page align each section
         bss_size = PageAlignSize(mod_header.bss_end_offset - mod_header.bss_start_offset);
     }
+    if (program_image.size() + bss_size > MaxImageSize) {
+        LOG_CRITICAL(Loader, "%s: NSO .bss is too large", path.c_str());
+        return {};
+    }
     codeset->data.size += bss_size;
     const u32 image_size{PageAlignSize(static_cast<u32>(program_image.size()) + bss_size)};
     program_image.resize(image_size);
@@ -143,6 +232,7 @@ VAddr AppLoader_NSO::LoadModule(const std::string& path, VAddr load_base) {
     // Load codeset for current process
     codeset->name = path;
     codeset->memory = std::make_shared<std::vector<u8>>(std::move(program_image));
+    ModuleCache::Store(cache_key, load_base, *codeset);
     Core::CurrentProcess()->LoadModule(codeset, load_base);
 
     return load_base + image_size;
@@ -6,18 +6,25 @@
 #include <array>
 #include <cinttypes>
 #include <cstring>
+#include <mutex>
+#include <vector>
+#include <boost/icl/interval_set.hpp>
 #include <boost/optional.hpp>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/memory_usage.h"
+#include "common/memory_util.h"
 #include "common/swap.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
-#include "core/hle/lock.h"
 #include "core/memory.h"
 #include "core/memory_setup.h"
+#include "core/settings.h"
+#include "video_core/gpu.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -27,6 +34,115 @@ static std::array<u8, Memory::VRAM_SIZE> vram;
 
 static PageTable* current_page_table = nullptr;
 
+/**
+ * Coalesced set of the guest address ranges that currently have surfaces cached by the
+ * rasterizer. Flushes and invalidations are clipped to it, so regions without any cached surface
+ * never reach the rasterizer.
+ */
+static boost::icl::interval_set<VAddr> rasterizer_cached_regions;
+/**
+ * Guest address ranges holding data the GPU wrote to surfaces that wasn't flushed back yet. The
+ * CPU writes to cached regions so that the rasterizer can reload them, but it only has to flush
+ * these ones before it reads them.
+ */
+static boost::icl::interval_set<VAddr> rasterizer_modified_regions;
+/// Guards the region sets, as the rasterizer marks regions from the GPU thread while the CPU
+/// thread flushes them.
+static std::mutex rasterizer_cache_mutex;
+
+/**
+ * Page type changes the rasterizer made on the GPU thread, in the order it made them. The page
+ * table and the VMAs are read without a lock by the CPU thread and the JIT, so they are only ever
+ * changed on the CPU thread, by page_type_change_event.
+ */
+struct PageTypeChange {
+    VAddr start;
+    u64 size;
+    bool cached;
+};
+static std::vector<PageTypeChange> pending_page_type_changes;
+static std::mutex pending_page_type_mutex;
+static CoreTiming::EventType* page_type_change_event = nullptr;
+
+/// Host memory is assumed to be committed in pages of this size
+constexpr size_t HOST_PAGE_SIZE = 0x1000;
+
+static Common::MemoryUsageCounter page_table_usage("Page tables");
+
+static_assert(static_cast<u8>(PageType::Unmapped) == 0,
+              "Freshly committed page table memory must read as unmapped");
+
+template <typename T>
+PageTableEntries<T>::PageTableEntries() {
+    constexpr size_t size_in_bytes = PAGE_TABLE_NUM_ENTRIES * sizeof(T);
+    entries = static_cast<T*>(ReserveMemoryRegion(size_in_bytes));
+    ASSERT_MSG(entries != nullptr, "Unable to reserve page table memory");
+    CommitMemoryRegion(entries, size_in_bytes);
+    written_host_pages.resize(size_in_bytes / HOST_PAGE_SIZE);
+}
+
+template <typename T>
+PageTableEntries<T>::~PageTableEntries() {
+    ReleaseMemoryRegion(entries, PAGE_TABLE_NUM_ENTRIES * sizeof(T));
+    page_table_usage.Subtract(committed_size);
+}
+
+template <typename T>
+void PageTableEntries<T>::Clear() {
+    constexpr size_t size_in_bytes = PAGE_TABLE_NUM_ENTRIES * sizeof(T);
+    DecommitMemoryRegion(entries, size_in_bytes);
+    CommitMemoryRegion(entries, size_in_bytes);
+
+    std::fill(written_host_pages.begin(), written_host_pages.end(), false);
+    page_table_usage.Subtract(committed_size);
+    committed_size = 0;
+}
+
+template <typename T>
+void PageTableEntries<T>::MarkWritten(size_t index) {
+    const size_t host_page = index * sizeof(T) / HOST_PAGE_SIZE;
+    if (!written_host_pages[host_page]) {
+        written_host_pages[host_page] = true;
+        committed_size += HOST_PAGE_SIZE;
+        page_table_usage.Add(HOST_PAGE_SIZE);
+    }
+}
+
+template class PageTableEntries<u8*>;
+template class PageTableEntries<PageType>;
+
+void SpecialRegionIndex::Rebuild(const SpecialRegionMap& regions) {
+    entries.clear();
+    entries.reserve(regions.iterative_size());
+
+    for (const auto& pair : regions) {
+        Entry entry{boost::icl::first(pair.first), boost::icl::last_next(pair.first), {}};
+        entry.handlers.reserve(pair.second.size());
+        for (const auto& region : pair.second) {
+            entry.handlers.push_back(region.handler);
+        }
+        entries.push_back(std::move(entry));
+    }
+}
+
+void SpecialRegionIndex::Clear() {
+    entries.clear();
+}
+
+const SpecialRegionIndex::Entry* SpecialRegionIndex::Find(VAddr addr) const {
+    auto it = std::upper_bound(entries.begin(), entries.end(), addr,
+                               [](VAddr addr, const Entry& entry) { return addr < entry.start; });
+    if (it == entries.begin()) {
+        return nullptr;
+    }
+
+    --it;
+    if (addr >= it->end) {
+        return nullptr;
+    }
+    return &*it;
+}
+
 void SetCurrentPageTable(PageTable* page_table) {
     current_page_table = page_table;
     if (Core::System::GetInstance().IsPoweredOn()) {
@@ -49,8 +165,16 @@ static void MapPages(PageTable& page_table, VAddr base, u64 size, u8* memory, Pa
     while (base != end) {
         ASSERT_MSG(base < PAGE_TABLE_NUM_ENTRIES, "out of range mapping at %016" PRIX64, base);
 
-        page_table.attributes[base] = type;
-        page_table.pointers[base] = memory;
+        // Skip entries that already hold the requested value, so that unmapping regions that were
+        // never mapped doesn't force the host to commit memory for them.
+        if (page_table.attributes[base] != type) {
+            page_table.attributes[base] = type;
+            page_table.attributes.MarkWritten(base);
+        }
+        if (page_table.pointers[base] != memory) {
+            page_table.pointers[base] = memory;
+            page_table.pointers.MarkWritten(base);
+        }
 
         base += 1;
         if (memory != nullptr)
@@ -72,6 +196,7 @@ void MapIoRegion(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::IODevice, mmio_handler};
     page_table.special_regions.add(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    page_table.special_region_index.Rebuild(page_table.special_regions);
 }
 
 void UnmapRegion(PageTable& page_table, VAddr base, u64 size) {
@@ -80,19 +205,24 @@ void UnmapRegion(PageTable& page_table, VAddr base, u64 size) {
     MapPages(page_table, base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Unmapped);
 
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
-    page_table.special_regions.erase(interval);
+    if (boost::icl::intersects(page_table.special_regions, interval)) {
+        page_table.special_regions.erase(interval);
+        page_table.special_region_index.Rebuild(page_table.special_regions);
+    }
 }
 
 void AddDebugHook(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer hook) {
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::DebugHook, hook};
     page_table.special_regions.add(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    page_table.special_region_index.Rebuild(page_table.special_regions);
 }
 
 void RemoveDebugHook(PageTable& page_table, VAddr base, u64 size, MemoryHookPointer hook) {
     auto interval = boost::icl::discrete_interval<VAddr>::closed(base, base + size - 1);
     SpecialRegion region{SpecialRegion::Type::DebugHook, hook};
     page_table.special_regions.subtract(std::make_pair(interval, std::set<SpecialRegion>{region}));
+    page_table.special_region_index.Rebuild(page_table.special_regions);
 }
 
 /**
@@ -111,9 +241,24 @@ static std::set<MemoryHookPointer> GetSpecialHandlers(const PageTable& page_tabl
     return result;
 }
 
-static std::set<MemoryHookPointer> GetSpecialHandlers(VAddr vaddr, u64 size) {
+/**
+ * Invokes `func` on each handler backing the given range of the current process until one of the
+ * calls returns true. Accesses that lie within a single region, which is the case for practically
+ * all of them, are served from the special region index without allocating.
+ * This function should only be called for virtual addreses with attribute `PageType::Special`.
+ * @returns Whether any of the handlers accepted the access.
+ */
+template <typename Func>
+static bool VisitSpecialHandlers(VAddr vaddr, u64 size, Func&& func) {
     const PageTable& page_table = Core::CurrentProcess()->vm_manager.page_table;
-    return GetSpecialHandlers(page_table, vaddr, size);
+
+    const auto* entry = page_table.special_region_index.Find(vaddr);
+    if (entry != nullptr && vaddr + size <= entry->end) {
+        return std::any_of(entry->handlers.begin(), entry->handlers.end(), func);
+    }
+
+    const auto handlers = GetSpecialHandlers(page_table, vaddr, size);
+    return std::any_of(handlers.begin(), handlers.end(), func);
 }
 
 /**
@@ -153,6 +298,52 @@ static u8* GetPointerFromVMA(VAddr vaddr) {
     return GetPointerFromVMA(*Core::CurrentProcess(), vaddr);
 }
 
+template <typename T>
+boost::optional<T> ReadMMIO(const MemoryHookPointer& handler, VAddr addr);
+
+template <>
+boost::optional<u8> ReadMMIO<u8>(const MemoryHookPointer& handler, VAddr addr) {
+    return handler->Read8(addr);
+}
+
+template <>
+boost::optional<u16> ReadMMIO<u16>(const MemoryHookPointer& handler, VAddr addr) {
+    return handler->Read16(addr);
+}
+
+template <>
+boost::optional<u32> ReadMMIO<u32>(const MemoryHookPointer& handler, VAddr addr) {
+    return handler->Read32(addr);
+}
+
+template <>
+boost::optional<u64> ReadMMIO<u64>(const MemoryHookPointer& handler, VAddr addr) {
+    return handler->Read64(addr);
+}
+
+template <typename T>
+bool WriteMMIO(const MemoryHookPointer& handler, VAddr addr, T data);
+
+template <>
+bool WriteMMIO<u8>(const MemoryHookPointer& handler, VAddr addr, u8 data) {
+    return handler->Write8(addr, data);
+}
+
+template <>
+bool WriteMMIO<u16>(const MemoryHookPointer& handler, VAddr addr, u16 data) {
+    return handler->Write16(addr, data);
+}
+
+template <>
+bool WriteMMIO<u32>(const MemoryHookPointer& handler, VAddr addr, u32 data) {
+    return handler->Write32(addr, data);
+}
+
+template <>
+bool WriteMMIO<u64>(const MemoryHookPointer& handler, VAddr addr, u64 data) {
+    return handler->Write64(addr, data);
+}
+
 template <typename T>
 T Read(const VAddr vaddr) {
     const u8* page_pointer = current_page_table->pointers[vaddr >> PAGE_BITS];
@@ -163,9 +354,6 @@ T Read(const VAddr vaddr) {
         return value;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
-
     PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
     switch (type) {
     case PageType::Unmapped:
@@ -181,6 +369,22 @@ T Read(const VAddr vaddr) {
         std::memcpy(&value, GetPointerFromVMA(vaddr), sizeof(T));
         return value;
     }
+    case PageType::Special: {
+        T value{};
+        const bool handled =
+            VisitSpecialHandlers(vaddr, sizeof(T), [&](const MemoryHookPointer& handler) {
+                const auto result = ReadMMIO<T>(handler, vaddr);
+                if (result) {
+                    value = *result;
+                }
+                return static_cast<bool>(result);
+            });
+
+        if (!handled) {
+            LOG_ERROR(HW_Memory, "unhandled MMIO Read%lu @ 0x%08X", sizeof(T) * 8, vaddr);
+        }
+        return value;
+    }
     default:
         UNREACHABLE();
     }
@@ -195,9 +399,6 @@ void Write(const VAddr vaddr, const T data) {
         return;
     }
 
-    // The memory access might do an MMIO or cached access, so we have to lock the HLE kernel state
-    std::lock_guard<std::recursive_mutex> lock(HLE::g_hle_lock);
-
     PageType type = current_page_table->attributes[vaddr >> PAGE_BITS];
     switch (type) {
     case PageType::Unmapped:
@@ -212,6 +413,18 @@ void Write(const VAddr vaddr, const T data) {
         std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
         break;
     }
+    case PageType::Special: {
+        const bool handled =
+            VisitSpecialHandlers(vaddr, sizeof(T), [&](const MemoryHookPointer& handler) {
+                return WriteMMIO<T>(handler, vaddr, data);
+            });
+
+        if (!handled) {
+            LOG_ERROR(HW_Memory, "unhandled MMIO Write%lu 0x%08X @ 0x%08X", sizeof(data) * 8,
+                      (u32)data, vaddr);
+        }
+        break;
+    }
     default:
         UNREACHABLE();
     }
@@ -255,6 +468,29 @@ u8* GetPointer(const VAddr vaddr) {
     return nullptr;
 }
 
+u8* GetContiguousPointer(const VAddr vaddr, const size_t size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    const VAddr first_page = vaddr >> PAGE_BITS;
+    const VAddr last_page = (vaddr + size - 1) >> PAGE_BITS;
+    if (last_page < first_page || last_page >= current_page_table->pointers.size()) {
+        return nullptr;
+    }
+
+    u8* const first_pointer = current_page_table->pointers[first_page];
+    for (VAddr page = first_page; page <= last_page; ++page) {
+        const u8* const expected_pointer = first_pointer + (page - first_page) * PAGE_SIZE;
+        if (current_page_table->attributes[page] != PageType::Memory ||
+            current_page_table->pointers[page] != expected_pointer) {
+            return nullptr;
+        }
+    }
+
+    return first_pointer + (vaddr & PAGE_MASK);
+}
+
 std::string ReadCString(VAddr vaddr, std::size_t max_length) {
     std::string string;
     string.reserve(max_length);
@@ -325,11 +561,8 @@ u8* GetPhysicalPointer(PAddr address) {
     return target_pointer;
 }
 
-void RasterizerMarkRegionCached(VAddr start, u64 size, bool cached) {
-    if (start == 0) {
-        return;
-    }
-
+/// Switches the pages of a region between the cached and uncached page types. CPU thread only.
+static void SetRegionPageTypes(VAddr start, u64 size, bool cached) {
     u64 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
     VAddr vaddr = start;
 
@@ -357,6 +590,9 @@ void RasterizerMarkRegionCached(VAddr start, u64 size, bool cached) {
                 // It is not necessary for a process to have this region mapped into its address
                 // space, for example, a system module need not have a VRAM mapping.
                 break;
+            case PageType::Memory:
+                // The region was mapped again before a change deferred from the GPU thread ran
+                break;
             case PageType::RasterizerCachedMemory: {
                 u8* pointer = GetPointerFromVMA(vaddr & ~PAGE_MASK);
                 if (pointer == nullptr) {
@@ -377,6 +613,79 @@ void RasterizerMarkRegionCached(VAddr start, u64 size, bool cached) {
     }
 }
 
+static void ApplyPageTypeChanges(u64 userdata, int cycles_late) {
+    std::vector<PageTypeChange> changes;
+    {
+        std::lock_guard<std::mutex> lock(pending_page_type_mutex);
+        changes.swap(pending_page_type_changes);
+    }
+    for (const PageTypeChange& change : changes) {
+        SetRegionPageTypes(change.start, change.size, change.cached);
+    }
+}
+
+void Init() {
+    pending_page_type_changes.clear();
+    page_type_change_event = CoreTiming::RegisterEvent("PageTypeChange", ApplyPageTypeChanges);
+}
+
+void RasterizerMarkRegionCached(VAddr start, u64 size, bool cached) {
+    if (start == 0) {
+        return;
+    }
+
+    const VAddr region_start = start & ~PAGE_MASK;
+    const VAddr region_end = (start + size + PAGE_MASK) & ~PAGE_MASK;
+    const auto region = boost::icl::discrete_interval<VAddr>::right_open(region_start, region_end);
+    {
+        std::lock_guard<std::mutex> lock(rasterizer_cache_mutex);
+        if (cached) {
+            rasterizer_cached_regions.add(region);
+        } else {
+            rasterizer_cached_regions.subtract(region);
+        }
+    }
+
+    // Until the event runs, CPU accesses of the region still take the path of its old page type.
+    // The region set above is already up to date, so flushes and invalidations find the surface.
+    if (page_type_change_event != nullptr && Core::System::GetInstance().GPU().IsGPUThread()) {
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> lock(pending_page_type_mutex);
+            schedule = pending_page_type_changes.empty();
+            pending_page_type_changes.push_back({start, size, cached});
+        }
+        if (schedule) {
+            CoreTiming::ScheduleEventThreadsafe(0, page_type_change_event, 0);
+        }
+        return;
+    }
+    SetRegionPageTypes(start, size, cached);
+}
+
+void RasterizerMarkRegionModified(VAddr start, u64 size, bool modified) {
+    const auto region = boost::icl::discrete_interval<VAddr>::right_open(start, start + size);
+    std::lock_guard<std::mutex> lock(rasterizer_cache_mutex);
+    if (modified) {
+        rasterizer_modified_regions.add(region);
+    } else {
+        rasterizer_modified_regions.subtract(region);
+    }
+}
+
+/**
+ * Returns whether a flush of the region can be skipped, because the GPU didn't write to any of
+ * it. When the GPU runs on its own thread, the modified regions only account for the commands it
+ * already ran, so a flush only waits for the pending ones when the user allowed it.
+ */
+static bool CanSkipFlush(const boost::icl::discrete_interval<VAddr>& region) {
+    if (Settings::values.use_asynchronous_gpu_emulation &&
+        !Settings::values.use_lazy_surface_flushes) {
+        return false;
+    }
+    return !boost::icl::intersects(rasterizer_modified_regions, region);
+}
+
 void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
     // Since pages are unmapped on shutdown after video core is shutdown, the renderer may be
     // null here
@@ -384,34 +693,43 @@ void RasterizerFlushVirtualRegion(VAddr start, u64 size, FlushMode mode) {
         return;
     }
 
-    VAddr end = start + size;
-
-    auto CheckRegion = [&](VAddr region_start, VAddr region_end) {
-        if (start >= region_end || end <= region_start) {
-            // No overlap with region
+    const auto region = boost::icl::discrete_interval<VAddr>::right_open(start, start + size);
+    boost::icl::interval_set<VAddr> overlapping_regions;
+    {
+        std::lock_guard<std::mutex> lock(rasterizer_cache_mutex);
+        if (!boost::icl::intersects(rasterizer_cached_regions, region)) {
+            // No surface overlaps the region, so there is nothing to flush or invalidate
             return;
         }
+        if (mode == FlushMode::Flush && CanSkipFlush(region)) {
+            // The surfaces overlapping the region hold the same data as memory
+            return;
+        }
+
+        // Take a copy of the overlapping extents, as flushing and invalidating can remove
+        // surfaces from the cache, which in turn modifies the cached region set.
+        overlapping_regions = rasterizer_cached_regions & region;
+    }
 
-        VAddr overlap_start = std::max(start, region_start);
-        VAddr overlap_end = std::min(end, region_end);
-        u64 overlap_size = overlap_end - overlap_start;
+    // The GPU runs the rasterizer on its own thread when emulated asynchronously, in order with
+    // the command lists submitted before.
+    auto& gpu = Core::System::GetInstance().GPU();
+    for (const auto& overlap : overlapping_regions) {
+        const VAddr overlap_start = boost::icl::first(overlap);
+        const u64 overlap_size = boost::icl::length(overlap);
 
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
         switch (mode) {
         case FlushMode::Flush:
-            rasterizer->FlushRegion(overlap_start, overlap_size);
+            gpu.FlushRegion(overlap_start, overlap_size);
             break;
         case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(overlap_start, overlap_size);
+            gpu.InvalidateRegion(overlap_start, overlap_size);
             break;
         case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(overlap_start, overlap_size);
+            gpu.FlushAndInvalidateRegion(overlap_start, overlap_size);
             break;
         }
-    };
-
-    CheckRegion(PROCESS_IMAGE_VADDR, PROCESS_IMAGE_VADDR_END);
-    CheckRegion(HEAP_VADDR, HEAP_VADDR_END);
+    }
 }
 
 u8 Read8(const VAddr addr) {
@@ -430,50 +748,101 @@ u64 Read64(const VAddr addr) {
     return Read<u64_le>(addr);
 }
 
-void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
-               const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
+/**
+ * Splits the range [addr, addr + size) into runs of consecutive pages that share the same page
+ * type and, for mapped pages, are backed by contiguous host memory. `func` is invoked once per run
+ * with the page type, the guest address the run starts at, a host pointer to the run (null for
+ * unmapped pages) and the size of the run in bytes.
+ */
+template <typename Func>
+static void WalkPageRuns(const Kernel::Process& process, const VAddr addr, const size_t size,
+                         Func&& func) {
+    const auto& page_table = process.vm_manager.page_table;
 
     size_t remaining_size = size;
-    size_t page_index = src_addr >> PAGE_BITS;
-    size_t page_offset = src_addr & PAGE_MASK;
+    size_t page_index = addr >> PAGE_BITS;
+    size_t page_offset = addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount =
-            std::min(static_cast<size_t>(PAGE_SIZE) - page_offset, remaining_size);
+        const PageType type = page_table.attributes[page_index];
         const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+        const size_t max_pages = (page_offset + remaining_size + PAGE_MASK) >> PAGE_BITS;
 
-        switch (page_table.attributes[page_index]) {
+        size_t num_pages = 1;
+        u8* host_ptr = nullptr;
+
+        switch (type) {
         case PageType::Unmapped: {
-            LOG_ERROR(HW_Memory, "unmapped ReadBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
-                      current_vaddr, src_addr, size);
-            std::memset(dest_buffer, 0, copy_amount);
+            while (num_pages < max_pages &&
+                   page_table.attributes[page_index + num_pages] == PageType::Unmapped) {
+                ++num_pages;
+            }
             break;
         }
         case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
+            u8* const run_base = page_table.pointers[page_index];
+            DEBUG_ASSERT(run_base);
 
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
-            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            while (num_pages < max_pages &&
+                   page_table.pointers[page_index + num_pages] ==
+                       run_base + num_pages * PAGE_SIZE) {
+                ++num_pages;
+            }
+            host_ptr = run_base + page_offset;
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
-            std::memcpy(dest_buffer, GetPointerFromVMA(process, current_vaddr), copy_amount);
+            // Cached pages have no pointer in the page table, so runs of them can't be extended
+            // past the end of the VMA that backs them.
+            const auto& vma = process.vm_manager.FindVMA(current_vaddr)->second;
+            const size_t vma_end_index = (vma.base + vma.size) >> PAGE_BITS;
+
+            while (num_pages < max_pages && page_index + num_pages < vma_end_index &&
+                   page_table.attributes[page_index + num_pages] ==
+                       PageType::RasterizerCachedMemory) {
+                ++num_pages;
+            }
+            host_ptr = GetPointerFromVMA(process, current_vaddr);
             break;
         }
         default:
             UNREACHABLE();
         }
 
-        page_index++;
+        const size_t run_size = std::min((num_pages << PAGE_BITS) - page_offset, remaining_size);
+        func(type, current_vaddr, host_ptr, run_size);
+
+        page_index += num_pages;
         page_offset = 0;
-        dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
-        remaining_size -= copy_amount;
+        remaining_size -= run_size;
     }
 }
 
+void ReadBlock(const Kernel::Process& process, const VAddr src_addr, void* dest_buffer,
+               const size_t size) {
+    const auto copy_run = [&](PageType type, VAddr current_vaddr, const u8* src_ptr,
+                              size_t copy_amount) {
+        switch (type) {
+        case PageType::Unmapped:
+            LOG_ERROR(HW_Memory, "unmapped ReadBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
+                      current_vaddr, src_addr, size);
+            std::memset(dest_buffer, 0, copy_amount);
+            break;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::Flush);
+            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            break;
+        default:
+            std::memcpy(dest_buffer, src_ptr, copy_amount);
+            break;
+        }
+
+        dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
+    };
+
+    WalkPageRuns(process, src_addr, size, copy_run);
+}
+
 void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
     ReadBlock(*Core::CurrentProcess(), src_addr, dest_buffer, size);
 }
@@ -496,45 +865,27 @@ void Write64(const VAddr addr, const u64 data) {
 
 void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const void* src_buffer,
                 const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
-    size_t remaining_size = size;
-    size_t page_index = dest_addr >> PAGE_BITS;
-    size_t page_offset = dest_addr & PAGE_MASK;
-
-    while (remaining_size > 0) {
-        const size_t copy_amount =
-            std::min(static_cast<size_t>(PAGE_SIZE) - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
-
-        switch (page_table.attributes[page_index]) {
-        case PageType::Unmapped: {
+    const auto copy_run = [&](PageType type, VAddr current_vaddr, u8* dest_ptr,
+                              size_t copy_amount) {
+        switch (type) {
+        case PageType::Unmapped:
             LOG_ERROR(HW_Memory,
                       "unmapped WriteBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, dest_addr, size);
             break;
-        }
-        case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::Invalidate);
             std::memcpy(dest_ptr, src_buffer, copy_amount);
             break;
-        }
-        case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
-            std::memcpy(GetPointerFromVMA(process, current_vaddr), src_buffer, copy_amount);
-            break;
-        }
         default:
-            UNREACHABLE();
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
+            break;
         }
 
-        page_index++;
-        page_offset = 0;
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
-        remaining_size -= copy_amount;
-    }
+    };
+
+    WalkPageRuns(process, dest_addr, size, copy_run);
 }
 
 void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size) {
@@ -542,87 +893,56 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
 }
 
 void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
-    size_t remaining_size = size;
-    size_t page_index = dest_addr >> PAGE_BITS;
-    size_t page_offset = dest_addr & PAGE_MASK;
-
-    static const std::array<u8, PAGE_SIZE> zeros = {};
-
-    while (remaining_size > 0) {
-        const size_t copy_amount =
-            std::min(static_cast<size_t>(PAGE_SIZE) - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
-
-        switch (page_table.attributes[page_index]) {
-        case PageType::Unmapped: {
+    const auto zero_run = [&](PageType type, VAddr current_vaddr, u8* dest_ptr,
+                              size_t copy_amount) {
+        switch (type) {
+        case PageType::Unmapped:
             LOG_ERROR(HW_Memory, "unmapped ZeroBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, dest_addr, size);
             break;
-        }
-        case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-
-            u8* dest_ptr = page_table.pointers[page_index] + page_offset;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::Invalidate);
             std::memset(dest_ptr, 0, copy_amount);
             break;
-        }
-        case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Invalidate);
-            std::memset(GetPointerFromVMA(process, current_vaddr), 0, copy_amount);
-            break;
-        }
         default:
-            UNREACHABLE();
+            std::memset(dest_ptr, 0, copy_amount);
+            break;
         }
+    };
 
-        page_index++;
-        page_offset = 0;
-        remaining_size -= copy_amount;
-    }
+    WalkPageRuns(process, dest_addr, size, zero_run);
 }
 
-void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr, const size_t size) {
-    auto& page_table = process.vm_manager.page_table;
-    size_t remaining_size = size;
-    size_t page_index = src_addr >> PAGE_BITS;
-    size_t page_offset = src_addr & PAGE_MASK;
-
-    while (remaining_size > 0) {
-        const size_t copy_amount =
-            std::min(static_cast<size_t>(PAGE_SIZE) - page_offset, remaining_size);
-        const VAddr current_vaddr = static_cast<VAddr>((page_index << PAGE_BITS) + page_offset);
+void ZeroBlock(const VAddr dest_addr, const size_t size) {
+    ZeroBlock(*Core::CurrentProcess(), dest_addr, size);
+}
 
-        switch (page_table.attributes[page_index]) {
-        case PageType::Unmapped: {
+void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr, const size_t size) {
+    const auto copy_run = [&](PageType type, VAddr current_vaddr, const u8* src_ptr,
+                              size_t copy_amount) {
+        switch (type) {
+        case PageType::Unmapped:
             LOG_ERROR(HW_Memory, "unmapped CopyBlock @ 0x%08X (start address = 0x%08X, size = %zu)",
                       current_vaddr, src_addr, size);
             ZeroBlock(process, dest_addr, copy_amount);
             break;
-        }
-        case PageType::Memory: {
-            DEBUG_ASSERT(page_table.pointers[page_index]);
-            const u8* src_ptr = page_table.pointers[page_index] + page_offset;
+        case PageType::RasterizerCachedMemory:
+            RasterizerFlushVirtualRegion(current_vaddr, copy_amount, FlushMode::Flush);
             WriteBlock(process, dest_addr, src_ptr, copy_amount);
             break;
-        }
-        case PageType::RasterizerCachedMemory: {
-            RasterizerFlushVirtualRegion(current_vaddr, static_cast<u32>(copy_amount),
-                                         FlushMode::Flush);
-            WriteBlock(process, dest_addr, GetPointerFromVMA(process, current_vaddr), copy_amount);
-            break;
-        }
         default:
-            UNREACHABLE();
+            WriteBlock(process, dest_addr, src_ptr, copy_amount);
+            break;
         }
 
-        page_index++;
-        page_offset = 0;
         dest_addr += static_cast<VAddr>(copy_amount);
-        src_addr += static_cast<VAddr>(copy_amount);
-        remaining_size -= copy_amount;
-    }
+    };
+
+    WalkPageRuns(process, src_addr, size, copy_run);
+}
+
+void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
+    CopyBlock(*Core::CurrentProcess(), dest_addr, src_addr, size);
 }
 
 boost::optional<PAddr> TryVirtualToPhysicalAddress(const VAddr addr) {
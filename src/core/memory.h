@@ -4,9 +4,9 @@
 
 #pragma once
 
-#include <array>
 #include <cstddef>
 #include <map>
+#include <set>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -60,6 +60,82 @@ struct SpecialRegion {
     }
 };
 
+using SpecialRegionMap = boost::icl::interval_map<VAddr, std::set<SpecialRegion>>;
+
+/**
+ * Flattened, address-sorted copy of a SpecialRegionMap. The regions change rarely but are queried
+ * on every access to a `Special` page, so the index is rebuilt after each change and lets lookups
+ * binary search a contiguous array instead of walking the interval map and building a new set of
+ * handlers every time.
+ */
+class SpecialRegionIndex final {
+public:
+    struct Entry {
+        VAddr start; ///< First address covered by the entry
+        VAddr end;   ///< One past the last address covered by the entry
+        /// Handlers of the entry, with debug hooks ordered before IO devices
+        std::vector<MemoryHookPointer> handlers;
+    };
+
+    /// Replaces the contents of the index with the given regions.
+    void Rebuild(const SpecialRegionMap& regions);
+
+    /// Removes all entries from the index.
+    void Clear();
+
+    /// Returns the entry covering the given address, or nullptr if there's none.
+    const Entry* Find(VAddr addr) const;
+
+private:
+    std::vector<Entry> entries;
+};
+
+/**
+ * Flat array holding one entry per page of the emulated address space. The host memory backing it
+ * is reserved up front and only committed by the host once an entry inside a host page is written,
+ * so sparsely mapped address spaces stay cheap while lookups remain a single indexed load. Entries
+ * start out zeroed, which corresponds to a null pointer and `PageType::Unmapped`.
+ */
+template <typename T>
+class PageTableEntries final : NonCopyable {
+public:
+    PageTableEntries();
+    ~PageTableEntries();
+
+    T& operator[](size_t index) {
+        return entries[index];
+    }
+
+    const T& operator[](size_t index) const {
+        return entries[index];
+    }
+
+    T* data() {
+        return entries;
+    }
+
+    const T* data() const {
+        return entries;
+    }
+
+    constexpr size_t size() const {
+        return PAGE_TABLE_NUM_ENTRIES;
+    }
+
+    /// Resets every entry to zero and hands the committed host memory back to the host.
+    void Clear();
+
+    /// Counts the host page holding an entry as committed after the entry was written, for the
+    /// memory usage statistics.
+    void MarkWritten(size_t index);
+
+private:
+    T* entries = nullptr;
+    /// Which host pages of the entries were written since they were last cleared
+    std::vector<bool> written_host_pages;
+    u64 committed_size = 0;
+};
+
 /**
  * A (reasonably) fast way of allowing switchable and remappable process address spaces. It loosely
  * mimics the way a real CPU page table works.
@@ -69,19 +145,22 @@ struct PageTable {
      * Array of memory pointers backing each page. An entry can only be non-null if the
      * corresponding entry in the `attributes` array is of type `Memory`.
      */
-    std::array<u8*, PAGE_TABLE_NUM_ENTRIES> pointers;
+    PageTableEntries<u8*> pointers;
 
     /**
      * Contains MMIO handlers that back memory regions whose entries in the `attribute` array is of
      * type `Special`.
      */
-    boost::icl::interval_map<VAddr, std::set<SpecialRegion>> special_regions;
+    SpecialRegionMap special_regions;
+
+    /// Lookup index of `special_regions`, kept in sync with it by the memory setup functions.
+    SpecialRegionIndex special_region_index;
 
     /**
      * Array of fine grained page attributes. If it is set to any value other than `Memory`, then
      * the corresponding entry in `pointers` MUST be set to null.
      */
-    std::array<PageType, PAGE_TABLE_NUM_ENTRIES> attributes;
+    PageTableEntries<PageType> attributes;
 };
 
 /// Physical memory regions as seen from the ARM11
@@ -215,11 +294,21 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, size_t size);
 void WriteBlock(const Kernel::Process& process, const VAddr dest_addr, const void* src_buffer,
                 size_t size);
 void WriteBlock(const VAddr dest_addr, const void* src_buffer, size_t size);
+void ZeroBlock(const Kernel::Process& process, const VAddr dest_addr, const size_t size);
 void ZeroBlock(const VAddr dest_addr, const size_t size);
+void CopyBlock(const Kernel::Process& process, VAddr dest_addr, VAddr src_addr, size_t size);
 void CopyBlock(VAddr dest_addr, VAddr src_addr, size_t size);
 
 u8* GetPointer(VAddr virtual_address);
 
+/**
+ * Gets a host pointer to a whole range of guest memory, for callers that want to access it in
+ * place. This only succeeds when every page of the range is plain memory and the pages are backed
+ * by consecutive host memory; otherwise it returns nullptr and the caller has to go through
+ * ReadBlock/WriteBlock instead.
+ */
+u8* GetContiguousPointer(VAddr virtual_address, size_t size);
+
 std::string ReadCString(VAddr virtual_address, std::size_t max_length);
 
 /**
@@ -255,11 +344,21 @@ enum class FlushMode {
     FlushAndInvalidate,
 };
 
+/// Registers the CoreTiming event that applies the page type changes made on the GPU thread.
+void Init();
+
 /**
- * Mark each page touching the region as cached.
+ * Mark each page touching the region as cached. The page table is only used by the CPU thread,
+ * so when called from the GPU thread the pages are switched on the CPU thread a little later.
  */
 void RasterizerMarkRegionCached(VAddr start, u64 size, bool cached);
 
+/**
+ * Records whether the region holds data written by the GPU that wasn't flushed back to memory yet.
+ * CPU reads of cached regions that hold no such data don't need to flush anything.
+ */
+void RasterizerMarkRegionModified(VAddr start, u64 size, bool modified);
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
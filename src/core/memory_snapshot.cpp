@@ -0,0 +1,126 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+#include "common/assert.h"
+#include "core/hle/kernel/vm_manager.h"
+#include "core/memory.h"
+#include "core/memory_snapshot.h"
+
+namespace Memory {
+
+static bool IsZeroPage(const u8* page) {
+    static const std::array<u8, PAGE_SIZE> zero_page{};
+    return std::memcmp(page, zero_page.data(), PAGE_SIZE) == 0;
+}
+
+static bool PageMatches(const u8* page, const std::vector<u8>& data) {
+    return data.empty() ? IsZeroPage(page) : std::memcmp(page, data.data(), PAGE_SIZE) == 0;
+}
+
+std::vector<SnapshotRegion> GetSnapshotRegions(const Kernel::VMManager& vm_manager) {
+    std::vector<SnapshotRegion> regions;
+    for (const auto& entry : vm_manager.vma_map) {
+        const Kernel::VirtualMemoryArea& vma = entry.second;
+        switch (vma.type) {
+        case Kernel::VMAType::AllocatedMemoryBlock:
+            regions.push_back({vma.base, vma.backing_block->data() + vma.offset, vma.size});
+            break;
+        case Kernel::VMAType::BackingMemory:
+            regions.push_back({vma.base, vma.backing_memory, vma.size});
+            break;
+        default:
+            break;
+        }
+    }
+    return regions;
+}
+
+MemorySnapshots::MemorySnapshots(size_t max_snapshots) : max_snapshots(max_snapshots) {
+    ASSERT(max_snapshots > 0);
+}
+
+u64 MemorySnapshots::Capture(const std::vector<SnapshotRegion>& regions) {
+    const u64 id = next_id++;
+    for (const SnapshotRegion& region : regions) {
+        DEBUG_ASSERT((region.base & PAGE_MASK) == 0 && (region.size & PAGE_MASK) == 0);
+        for (u64 offset = 0; offset < region.size; offset += PAGE_SIZE) {
+            const u8* page = region.memory + offset;
+            std::vector<PageVersion>& versions = pages[region.base + offset];
+            if (!versions.empty() && PageMatches(page, versions.back().data))
+                continue;
+
+            PageVersion version{id, {}};
+            if (!IsZeroPage(page))
+                version.data.assign(page, page + PAGE_SIZE);
+            versions.push_back(std::move(version));
+        }
+    }
+
+    if (next_id - oldest_id > max_snapshots) {
+        oldest_id = next_id - max_snapshots;
+        DropOldVersions();
+    }
+    return id;
+}
+
+bool MemorySnapshots::Restore(u64 id, const std::vector<SnapshotRegion>& regions) const {
+    if (!Contains(id))
+        return false;
+
+    for (const SnapshotRegion& region : regions) {
+        for (u64 offset = 0; offset < region.size; offset += PAGE_SIZE) {
+            const auto itr = pages.find(region.base + offset);
+            if (itr == pages.end())
+                continue;
+
+            // The contents as of the snapshot are in the last version taken no later than it
+            const std::vector<PageVersion>& versions = itr->second;
+            const auto version = std::upper_bound(
+                versions.begin(), versions.end(), id,
+                [](u64 value, const PageVersion& version) { return value < version.snapshot_id; });
+            if (version == versions.begin())
+                continue;
+
+            u8* page = region.memory + offset;
+            const std::vector<u8>& data = std::prev(version)->data;
+            if (data.empty()) {
+                std::memset(page, 0, PAGE_SIZE);
+            } else {
+                std::memcpy(page, data.data(), PAGE_SIZE);
+            }
+        }
+    }
+    return true;
+}
+
+bool MemorySnapshots::Contains(u64 id) const {
+    return id >= oldest_id && id < next_id;
+}
+
+size_t MemorySnapshots::GetStoredPageCount() const {
+    size_t count = 0;
+    for (const auto& entry : pages) {
+        count += std::count_if(entry.second.begin(), entry.second.end(),
+                               [](const PageVersion& version) { return !version.data.empty(); });
+    }
+    return count;
+}
+
+void MemorySnapshots::DropOldVersions() {
+    for (auto& entry : pages) {
+        std::vector<PageVersion>& versions = entry.second;
+        // The oldest snapshot kept still needs the last version taken no later than it
+        const auto first_needed = std::upper_bound(
+            versions.begin(), versions.end(), oldest_id,
+            [](u64 value, const PageVersion& version) { return value < version.snapshot_id; });
+        if (first_needed - versions.begin() > 1)
+            versions.erase(versions.begin(), std::prev(first_needed));
+    }
+}
+
+} // namespace Memory
@@ -0,0 +1,74 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Kernel {
+class VMManager;
+}
+
+namespace Memory {
+
+/// A range of guest memory and the host memory backing it. Both ends are page aligned.
+struct SnapshotRegion {
+    VAddr base;
+    u8* memory;
+    u64 size;
+};
+
+/// Returns the regions of the address space of a VMManager that are backed by host memory.
+std::vector<SnapshotRegion> GetSnapshotRegions(const Kernel::VMManager& vm_manager);
+
+/**
+ * Keeps the contents of guest memory at several points in time, e.g. for rewinding. Only the first
+ * snapshot stores every page; later ones only store the pages that changed since the snapshot
+ * before them, and pages full of zeroes aren't stored at all. Pages are compared with their
+ * previous contents rather than tracked through write faults, so writes made by the JIT directly
+ * through the page table are picked up as well.
+ */
+class MemorySnapshots final {
+public:
+    /// @param max_snapshots How many snapshots are kept before the oldest ones are dropped.
+    explicit MemorySnapshots(size_t max_snapshots);
+
+    /// Takes a snapshot of the contents of the regions and returns its id.
+    u64 Capture(const std::vector<SnapshotRegion>& regions);
+
+    /**
+     * Writes the contents the regions had when a snapshot was taken back into them. Pages that
+     * weren't mapped back then are left alone.
+     * @returns false if the snapshot has been dropped or was never taken.
+     */
+    bool Restore(u64 id, const std::vector<SnapshotRegion>& regions) const;
+
+    /// Returns whether a snapshot is still kept.
+    bool Contains(u64 id) const;
+
+    /// Number of page copies stored across all snapshots, not counting zero pages.
+    size_t GetStoredPageCount() const;
+
+private:
+    /// Contents of a page as of a snapshot, until a later snapshot saw it change
+    struct PageVersion {
+        u64 snapshot_id;
+        /// Empty if the page was all zeroes
+        std::vector<u8> data;
+    };
+
+    /// Drops the versions only the snapshots older than oldest_id still need.
+    void DropOldVersions();
+
+    /// Versions of every page that was ever captured, oldest first, by the address of the page
+    std::unordered_map<VAddr, std::vector<PageVersion>> pages;
+    size_t max_snapshots;
+    u64 next_id = 0;
+    u64 oldest_id = 0;
+};
+
+} // namespace Memory
@@ -0,0 +1,302 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <chrono>
+#include <sstream>
+#include <vector>
+#include "common/logging/log.h"
+#include "common/memory_usage.h"
+#include "common/thread.h"
+#include "common/thread_placement.h"
+#include "core/file_sys/cached_storage.h"
+#include "core/hle/service/ipc_recorder.h"
+#include "core/metrics_exporter.h"
+
+namespace Core {
+
+using namespace Service::Sockets;
+using DoubleSecs = std::chrono::duration<double>;
+
+namespace {
+
+constexpr u32 GUEST_SOCK_STREAM = 1;
+constexpr u32 GUEST_SOL_SOCKET = 0xFFFF;
+constexpr u32 GUEST_SO_REUSEADDR = 0x4;
+
+/// How often the serving thread checks whether it has to stop
+constexpr s32 STOP_POLL_INTERVAL_MS = 100;
+/// How long a client has to send its request and take the response
+constexpr s32 CONNECTION_TIMEOUT_MS = 1000;
+/// Longest request that is read, the rest of a longer one is ignored
+constexpr size_t MAX_REQUEST_SIZE = 4096;
+
+/// Escapes a string to be written between the quotes of a label value
+std::string EscapeLabel(const std::string& str) {
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (const char c : str) {
+        switch (c) {
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        default:
+            escaped += c;
+            break;
+        }
+    }
+    return escaped;
+}
+
+void WriteHeader(std::ostringstream& out, const char* name, const char* type, const char* help) {
+    out << "# HELP " << name << ' ' << help << "\n# TYPE " << name << ' ' << type << '\n';
+}
+
+/// Waits until the socket is ready for the events, returns false on errors and timeouts
+bool WaitFor(SocketHandle socket, s16 events) {
+    HostPollFD fd{socket, events, 0};
+    s32 ready = 0;
+    return Poll(&fd, 1, CONNECTION_TIMEOUT_MS, ready) == Errno::SUCCESS && ready > 0 &&
+           (fd.revents & events) != 0;
+}
+
+bool SendAll(SocketHandle socket, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t sent = 0;
+        const Errno error = Send(socket, 0, reinterpret_cast<const u8*>(data.data()) + offset,
+                                 data.size() - offset, sent, nullptr);
+        if (error == Errno::AGAIN) {
+            if (!WaitFor(socket, POLL_OUT)) {
+                return false;
+            }
+            continue;
+        }
+        if (error != Errno::SUCCESS) {
+            return false;
+        }
+        offset += sent;
+    }
+    return true;
+}
+
+} // Anonymous namespace
+
+MetricsExporter::MetricsExporter(PerfStats& perf_stats)
+    : perf_stats(perf_stats), previous_totals(perf_stats.GetTotals()) {
+    InitializeHostSockets();
+}
+
+MetricsExporter::~MetricsExporter() {
+    stop_requested = true;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (listen_socket != INVALID_SOCKET_HANDLE) {
+        CloseSocket(listen_socket);
+    }
+    ShutdownHostSockets();
+}
+
+bool MetricsExporter::Start(u16 port) {
+    SockAddrIn address{};
+    address.len = sizeof(SockAddrIn);
+    address.family = GUEST_AF_INET;
+    address.port = port;
+    address.address = {0, 0, 0, 0};
+
+    const int reuse_address = 1;
+    const bool listening =
+        CreateSocket(GUEST_AF_INET, GUEST_SOCK_STREAM, 0, listen_socket) == Errno::SUCCESS &&
+        SetSockOpt(listen_socket, GUEST_SOL_SOCKET, GUEST_SO_REUSEADDR,
+                   reinterpret_cast<const u8*>(&reuse_address),
+                   sizeof(reuse_address)) == Errno::SUCCESS &&
+        Bind(listen_socket, address) == Errno::SUCCESS &&
+        Listen(listen_socket, 8) == Errno::SUCCESS;
+    if (!listening) {
+        LOG_ERROR(Core, "Failed to listen on port %u for metrics scrapes", port);
+        return false;
+    }
+
+    LOG_INFO(Core, "Serving metrics at http://0.0.0.0:%u/metrics", port);
+    thread = std::thread([this] { ServeLoop(); });
+    return true;
+}
+
+void MetricsExporter::ServeLoop() {
+    Common::SetCurrentThreadName("Metrics exporter");
+    Common::SetCurrentThreadRole(Common::ThreadRole::Worker);
+
+    while (!stop_requested) {
+        HostPollFD fd{listen_socket, POLL_IN, 0};
+        s32 ready = 0;
+        if (Poll(&fd, 1, STOP_POLL_INTERVAL_MS, ready) != Errno::SUCCESS || ready == 0) {
+            continue;
+        }
+
+        SocketHandle connection;
+        SockAddrIn peer;
+        if (Accept(listen_socket, connection, peer) != Errno::SUCCESS) {
+            continue;
+        }
+        HandleConnection(connection);
+        CloseSocket(connection);
+    }
+}
+
+void MetricsExporter::HandleConnection(SocketHandle connection) {
+    // Only the request line matters, the headers are read to the blank line that ends them
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < MAX_REQUEST_SIZE) {
+        if (!WaitFor(connection, POLL_IN)) {
+            return;
+        }
+        std::array<u8, 512> buffer;
+        size_t received = 0;
+        const Errno error = Recv(connection, 0, buffer.data(), buffer.size(), received, nullptr);
+        if (error == Errno::AGAIN) {
+            continue;
+        }
+        if (error != Errno::SUCCESS || received == 0) {
+            return;
+        }
+        request.append(reinterpret_cast<const char*>(buffer.data()), received);
+    }
+
+    const bool is_scrape = request.compare(0, 13, "GET /metrics ") == 0;
+    const std::string body = is_scrape ? FormatMetrics() : "Metrics are served at /metrics\n";
+    std::ostringstream response;
+    response << (is_scrape ? "HTTP/1.0 200 OK\r\n" : "HTTP/1.0 404 Not Found\r\n")
+             << "Content-Type: text/plain; version=0.0.4\r\n"
+             << "Content-Length: " << body.size() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    SendAll(connection, response.str());
+}
+
+std::string MetricsExporter::FormatMetrics() {
+    const PerfStats::Totals totals = perf_stats.GetTotals();
+    const std::vector<u32> histogram = perf_stats.GetFrametimeHistogram();
+    const PerfStats::ShaderCounts shader_counts = perf_stats.GetShaderCounts();
+    const FileSys::StorageCacheStats storage_stats = FileSys::GetStorageCacheStats();
+
+    // The speed is taken between the ends of system frames, so that it doesn't depend on where
+    // in a frame the scrapes happen. It takes a frame before the previous scrape to start from.
+    const PerfStats::Clock::time_point now = PerfStats::Clock::now();
+    const double scrape_interval = DoubleSecs(now - previous_scrape).count();
+    const double frame_interval =
+        DoubleSecs(totals.last_frame_end - previous_totals.last_frame_end).count();
+    const double emulation_speed =
+        previous_totals.system_frames != 0 && frame_interval > 0.0
+            ? (totals.last_frame_system_us - previous_totals.last_frame_system_us) / 1e6 /
+                  frame_interval
+            : 0.0;
+    const double system_fps =
+        (totals.system_frames - previous_totals.system_frames) / scrape_interval;
+    const double game_fps = (totals.game_frames - previous_totals.game_frames) / scrape_interval;
+    previous_totals = totals;
+    previous_scrape = now;
+
+    std::ostringstream out;
+    out.precision(9);
+
+    WriteHeader(out, "yuzu_emulation_speed", "gauge",
+                "Emulated time per walltime since the previous scrape");
+    out << "yuzu_emulation_speed " << emulation_speed << '\n';
+    WriteHeader(out, "yuzu_system_fps", "gauge",
+                "System frames per second since the previous scrape");
+    out << "yuzu_system_fps " << system_fps << '\n';
+    WriteHeader(out, "yuzu_game_fps", "gauge", "Game frames per second since the previous scrape");
+    out << "yuzu_game_fps " << game_fps << '\n';
+
+    WriteHeader(out, "yuzu_system_frames_total", "counter", "System frames presented");
+    out << "yuzu_system_frames_total " << totals.system_frames << '\n';
+    WriteHeader(out, "yuzu_game_frames_total", "counter", "Frames submitted by the game");
+    out << "yuzu_game_frames_total " << totals.game_frames << '\n';
+    WriteHeader(out, "yuzu_emulated_seconds", "gauge",
+                "Emulated time at the end of the last system frame");
+    out << "yuzu_emulated_seconds " << totals.last_frame_system_us / 1e6 << '\n';
+
+    WriteHeader(out, "yuzu_frame_time_seconds", "histogram",
+                "Walltime of the system frames, excluding any waits");
+    u64 cumulative = 0;
+    const double bucket_width = DoubleSecs(PerfStats::FrametimeBucketWidth).count();
+    for (size_t i = 0; i + 1 < histogram.size(); ++i) {
+        cumulative += histogram[i];
+        out << "yuzu_frame_time_seconds_bucket{le=\"" << (i + 1) * bucket_width << "\"} "
+            << cumulative << '\n';
+    }
+    cumulative += histogram.empty() ? 0 : histogram.back();
+    out << "yuzu_frame_time_seconds_bucket{le=\"+Inf\"} " << cumulative << '\n';
+    out << "yuzu_frame_time_seconds_sum " << DoubleSecs(totals.frametime).count() << '\n';
+    out << "yuzu_frame_time_seconds_count " << cumulative << '\n';
+
+    WriteHeader(out, "yuzu_shader_builds_total", "counter",
+                "Shader programs built, from source or from the disk cache");
+    out << "yuzu_shader_builds_total{source=\"compiled\"} " << shader_counts.compiled << '\n';
+    out << "yuzu_shader_builds_total{source=\"disk_cache\"} " << shader_counts.loaded_from_disk
+        << '\n';
+
+    WriteHeader(out, "yuzu_storage_cache_reads_total", "counter",
+                "Blocks read through the storage block cache");
+    out << "yuzu_storage_cache_reads_total{result=\"hit\"} " << storage_stats.hits << '\n';
+    out << "yuzu_storage_cache_reads_total{result=\"miss\"} " << storage_stats.misses << '\n';
+    WriteHeader(out, "yuzu_storage_cache_read_ahead_blocks_total", "counter",
+                "Blocks read ahead of sequential misses");
+    out << "yuzu_storage_cache_read_ahead_blocks_total " << storage_stats.read_ahead_blocks
+        << '\n';
+    WriteHeader(out, "yuzu_storage_cache_evictions_total", "counter",
+                "Blocks evicted from the storage block cache");
+    out << "yuzu_storage_cache_evictions_total " << storage_stats.evictions << '\n';
+
+    WriteHeader(out, "yuzu_memory_bytes", "gauge",
+                "Host memory held by each part of the emulator, such as the caches");
+    for (const Common::MemoryUsageEntry& entry : Common::GetMemoryUsage()) {
+        out << "yuzu_memory_bytes{part=\"" << EscapeLabel(entry.name) << "\"} " << entry.bytes
+            << '\n';
+    }
+    WriteHeader(out, "yuzu_resident_memory_bytes", "gauge",
+                "Host memory resident for the process");
+    out << "yuzu_resident_memory_bytes " << Common::GetResidentMemory() << '\n';
+
+    // The commands are only counted while IPC recording is enabled
+    const std::vector<Service::IPCRecorder::CommandStats> ipc_stats =
+        Service::IPCRecorder::GetStats();
+    std::ostringstream calls;
+    std::ostringstream host_time;
+    std::ostringstream bytes;
+    calls.precision(9);
+    host_time.precision(9);
+    for (const Service::IPCRecorder::CommandStats& command : ipc_stats) {
+        std::ostringstream labels;
+        labels << "service=\"" << EscapeLabel(command.service_name) << "\",command=\""
+               << command.command_id << "\",function=\"" << EscapeLabel(command.function_name)
+               << '"';
+        calls << "yuzu_ipc_calls_total{" << labels.str() << "} " << command.num_calls << '\n';
+        host_time << "yuzu_ipc_host_seconds_total{" << labels.str() << "} "
+                  << DoubleSecs(command.host_time).count() << '\n';
+        bytes << "yuzu_ipc_bytes_total{" << labels.str() << ",direction=\"in\"} "
+              << command.bytes_in << '\n';
+        bytes << "yuzu_ipc_bytes_total{" << labels.str() << ",direction=\"out\"} "
+              << command.bytes_out << '\n';
+    }
+    WriteHeader(out, "yuzu_ipc_calls_total", "counter", "Requests handled by each HLE command");
+    out << calls.str();
+    WriteHeader(out, "yuzu_ipc_host_seconds_total", "counter",
+                "Host time spent handling each HLE command");
+    out << host_time.str();
+    WriteHeader(out, "yuzu_ipc_bytes_total", "counter",
+                "Bytes sent with the requests of each HLE command, and offered for the replies");
+    out << bytes.str();
+
+    return out.str();
+}
+
+} // namespace Core
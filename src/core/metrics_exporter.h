@@ -0,0 +1,54 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include "common/common_types.h"
+#include "core/hle/service/sockets/host_socket.h"
+#include "core/perf_stats.h"
+
+namespace Core {
+
+/**
+ * Serves the live statistics of the emulator at /metrics over HTTP, in the Prometheus text format,
+ * from a thread of its own. A scrape only copies the counters the emulator keeps anyway, holding
+ * their locks for a moment, so that monitoring doesn't slow emulation down. Enabled through
+ * Settings::values.metrics_export_port.
+ */
+class MetricsExporter final {
+public:
+    explicit MetricsExporter(PerfStats& perf_stats);
+    ~MetricsExporter();
+
+    /**
+     * Listens on the port of every interface, and starts serving the metrics.
+     * @returns false if the port couldn't be listened on
+     */
+    bool Start(u16 port);
+
+    /**
+     * Returns the metrics as they are served. The rates are taken over the time since the previous
+     * call, the counters since emulation started.
+     */
+    std::string FormatMetrics();
+
+private:
+    void ServeLoop();
+    void HandleConnection(Service::Sockets::SocketHandle connection);
+
+    PerfStats& perf_stats;
+
+    /// Totals at the previous scrape, which the rates are taken relative to
+    PerfStats::Totals previous_totals{};
+    PerfStats::Clock::time_point previous_scrape = PerfStats::Clock::now();
+
+    Service::Sockets::SocketHandle listen_socket = Service::Sockets::INVALID_SOCKET_HANDLE;
+    std::thread thread;
+    std::atomic<bool> stop_requested{false};
+};
+
+} // namespace Core
@@ -0,0 +1,133 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/movie.h"
+#include "core/settings.h"
+
+namespace Core {
+
+constexpr std::array<char, 4> MOVIE_MAGIC{{'Y', 'M', 'O', 'V'}};
+
+Movie Movie::s_instance;
+
+bool Movie::StartRecording(const std::string& path) {
+    if (mode != Mode::None) {
+        return false;
+    }
+    mode = Mode::Recording;
+    this->path = path;
+    entries.clear();
+    current_buttons = 0;
+    return true;
+}
+
+bool Movie::StartPlayback(const std::string& path) {
+    if (mode != Mode::None) {
+        return false;
+    }
+
+    FileUtil::IOFile file(path, "rb");
+    Header header{};
+    if (!file.IsOpen() || file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        LOG_ERROR(Core, "Failed to read the movie %s", path.c_str());
+        return false;
+    }
+    if (header.magic != MOVIE_MAGIC || header.version != CurrentVersion) {
+        LOG_ERROR(Core, "%s isn't a movie of a supported version", path.c_str());
+        return false;
+    }
+
+    std::vector<Entry> loaded_entries(header.num_entries);
+    if (file.ReadArray(loaded_entries.data(), loaded_entries.size()) != loaded_entries.size()) {
+        LOG_ERROR(Core, "The movie %s is truncated", path.c_str());
+        return false;
+    }
+
+    // The periodic updates have to happen at the ticks they were recorded at
+    if (Settings::values.pad_update_rate != header.pad_update_rate) {
+        LOG_INFO(Core, "Updating the pad at %u Hz, like the movie was recorded",
+                 header.pad_update_rate);
+        Settings::values.pad_update_rate = header.pad_update_rate;
+    }
+
+    mode = Mode::Playing;
+    this->path = path;
+    entries = std::move(loaded_entries);
+    next_entry = 0;
+    current_buttons = 0;
+    return true;
+}
+
+void Movie::Shutdown() {
+    if (mode == Mode::Recording && !WriteRecording()) {
+        LOG_ERROR(Core, "Failed to write the movie %s", path.c_str());
+    }
+    mode = Mode::None;
+    entries.clear();
+    next_entry = 0;
+}
+
+bool Movie::IsPlaybackFinished() const {
+    return mode == Mode::Playing && next_entry == entries.size();
+}
+
+u64 Movie::HandlePadState(u64 buttons, SampleKind kind) {
+    const u64 ticks = CoreTiming::GetTicks();
+
+    if (mode == Mode::Recording) {
+        if (kind == SampleKind::Change || buttons != current_buttons) {
+            Entry entry{};
+            entry.ticks = ticks;
+            entry.buttons = buttons;
+            entry.kind = kind;
+            entries.push_back(entry);
+            current_buttons = buttons;
+        }
+        return buttons;
+    }
+
+    if (mode == Mode::Playing) {
+        while (next_entry < entries.size() && entries[next_entry].ticks <= ticks) {
+            current_buttons = entries[next_entry].buttons;
+            ++next_entry;
+        }
+        return current_buttons;
+    }
+
+    return buttons;
+}
+
+std::vector<u64> Movie::GetChangeTicks() const {
+    std::vector<u64> ticks;
+    if (mode != Mode::Playing) {
+        return ticks;
+    }
+    for (const Entry& entry : entries) {
+        if (entry.kind == SampleKind::Change) {
+            ticks.push_back(entry.ticks);
+        }
+    }
+    return ticks;
+}
+
+bool Movie::WriteRecording() const {
+    FileUtil::IOFile file(path, "wb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    Header header{};
+    header.magic = MOVIE_MAGIC;
+    header.version = CurrentVersion;
+    header.pad_update_rate = Settings::values.pad_update_rate;
+    header.num_entries = entries.size();
+    return file.WriteBytes(&header, sizeof(header)) == sizeof(header) &&
+           file.WriteArray(entries.data(), entries.size()) == entries.size();
+}
+
+} // namespace Core
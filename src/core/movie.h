@@ -0,0 +1,111 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Records the controller state the guest is handed together with the CoreTiming tick it was
+ * sampled at, and plays such a recording back in place of the input devices. As long as guest
+ * time doesn't depend on the host, which rules out host timing, a played back movie hands the
+ * guest the same input at the same ticks on every run.
+ */
+class Movie {
+public:
+    /// Why HID sampled the pad
+    enum class SampleKind : u32 {
+        /// The periodic pad update, which runs at the same ticks in every run
+        Update = 0,
+        /// A button that reports its changes changed, which can happen at any tick
+        Change = 1,
+    };
+
+    static Movie& GetInstance() {
+        return s_instance;
+    }
+
+    /// Starts recording to a file, which is written on Shutdown. Returns false if a movie is
+    /// already being recorded or played back.
+    bool StartRecording(const std::string& path);
+
+    /**
+     * Loads a movie to be played back from the next sample on. This also sets the pad update
+     * rate to the one it was recorded with, so call it before the game is loaded.
+     * @returns false if the movie couldn't be loaded, or one is already being recorded or played
+     */
+    bool StartPlayback(const std::string& path);
+
+    /// Writes the movie being recorded, and stops recording or playing back.
+    void Shutdown();
+
+    bool IsRecording() const {
+        return mode == Mode::Recording;
+    }
+
+    bool IsPlayingBack() const {
+        return mode == Mode::Playing;
+    }
+
+    /// Whether every recorded sample has been played back.
+    bool IsPlaybackFinished() const;
+
+    /**
+     * Passes the pad state HID is about to hand to the guest through the movie, at the current
+     * tick. A new state is recorded while recording, and the recorded one is returned instead
+     * while playing back.
+     */
+    u64 HandlePadState(u64 buttons, SampleKind kind);
+
+    /// Ticks of the changes that HID has to sample the pad at on its own when playing back, to
+    /// be scheduled as they were recorded.
+    std::vector<u64> GetChangeTicks() const;
+
+private:
+    enum class Mode {
+        None,
+        Recording,
+        Playing,
+    };
+
+    struct Entry {
+        u64 ticks;
+        u64 buttons;
+        SampleKind kind;
+        INSERT_PADDING_WORDS(1);
+    };
+    static_assert(sizeof(Entry) == 24, "Movie::Entry has wrong size");
+
+    struct Header {
+        std::array<char, 4> magic;
+        u32 version;
+        u16 pad_update_rate;
+        INSERT_PADDING_BYTES(6);
+        u64 num_entries;
+    };
+    static_assert(sizeof(Header) == 24, "Movie::Header has wrong size");
+
+    static constexpr u32 CurrentVersion = 1;
+
+    bool WriteRecording() const;
+
+    static Movie s_instance;
+
+    Mode mode = Mode::None;
+    std::string path;
+    /// Recorded samples, in the order they were taken. Updates are only kept when they changed the
+    /// state, as the periodic updates happen at the same ticks in every run anyway.
+    std::vector<Entry> entries;
+    /// Index of the next entry to play back
+    size_t next_entry = 0;
+    u64 current_buttons = 0;
+};
+
+} // namespace Core
@@ -17,20 +17,84 @@ using std::chrono::microseconds;
 
 namespace Core {
 
+/// Innermost subsystem scope of each thread
+static thread_local PerfStats::SubsystemScope* current_subsystem_scope = nullptr;
+
+PerfStats::SubsystemScope::SubsystemScope(PerfStats& perf_stats, Subsystem subsystem)
+    : perf_stats(perf_stats), subsystem(subsystem), begin(Clock::now()),
+      parent(current_subsystem_scope) {
+    if (parent != nullptr) {
+        // The outer scope is paused until this one is destroyed
+        parent->Accumulate(begin);
+    }
+    current_subsystem_scope = this;
+}
+
+PerfStats::SubsystemScope::~SubsystemScope() {
+    const Clock::time_point now = Clock::now();
+    Accumulate(now);
+    current_subsystem_scope = parent;
+    if (parent != nullptr) {
+        parent->begin = now;
+    }
+}
+
+void PerfStats::SubsystemScope::Accumulate(Clock::time_point now) {
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - begin);
+    perf_stats.subsystem_time_ns[static_cast<size_t>(subsystem)].fetch_add(
+        elapsed.count(), std::memory_order_relaxed);
+    begin = now;
+}
+
+const char* PerfStats::GetSubsystemName(Subsystem subsystem) {
+    switch (subsystem) {
+    case Subsystem::CpuJit:
+        return "CPU JIT";
+    case Subsystem::HleServices:
+        return "HLE services";
+    case Subsystem::GpuCommands:
+        return "GPU commands";
+    case Subsystem::GlSubmission:
+        return "GL submission";
+    case Subsystem::PresentWait:
+        return "Present wait";
+    default:
+        return "Unknown";
+    }
+}
+
 void PerfStats::BeginSystemFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
     frame_begin = Clock::now();
 }
 
-void PerfStats::EndSystemFrame() {
+void PerfStats::EndSystemFrame(u64 current_system_time_us) {
     std::lock_guard<std::mutex> lock(object_mutex);
 
     auto frame_end = Clock::now();
     accumulated_frametime += frame_end - frame_begin;
     system_frames += 1;
 
+    totals.system_frames += 1;
+    totals.frametime += frame_end - frame_begin;
+    totals.last_frame_system_us = current_system_time_us;
+    totals.last_frame_end = frame_end;
+
+    frametime_history[frametime_history_index] = frame_end - frame_begin;
+    frametime_history_index = (frametime_history_index + 1) % frametime_history.size();
+
+    percentile_history[percentile_history_index] = frame_end - frame_begin;
+    percentile_history_index = (percentile_history_index + 1) % percentile_history.size();
+    percentile_history_size = std::min(percentile_history_size + 1, percentile_history.size());
+
+    const size_t bucket = static_cast<size_t>((frame_end - frame_begin) / FrametimeBucketWidth);
+    frametime_histogram[std::min(bucket, frametime_histogram.size() - 1)] += 1;
+
     previous_frame_length = frame_end - previous_frame_end;
+    if (frame_log_enabled) {
+        frame_log.push_back(frame_end - std::max(previous_frame_end, frame_log_begin));
+    }
     previous_frame_end = frame_end;
 }
 
@@ -38,6 +102,7 @@ void PerfStats::EndGameFrame() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
     game_frames += 1;
+    totals.game_frames += 1;
 }
 
 PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
@@ -57,6 +122,27 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
                         static_cast<double>(system_frames);
     results.emulation_speed = system_us_per_second / 1'000'000.0;
 
+    std::vector<Clock::duration> frametimes(percentile_history.begin(),
+                                            percentile_history.begin() + percentile_history_size);
+    const auto percentile = [&frametimes](double fraction) {
+        if (frametimes.empty()) {
+            return 0.0;
+        }
+        const auto nth = frametimes.begin() + static_cast<ptrdiff_t>(
+                                                   fraction * (frametimes.size() - 1) + 0.5);
+        std::nth_element(frametimes.begin(), nth, frametimes.end());
+        return duration_cast<DoubleSecs>(*nth).count();
+    };
+    results.frametime_p50 = percentile(0.50);
+    results.frametime_p95 = percentile(0.95);
+    results.frametime_p99 = percentile(0.99);
+
+    for (size_t i = 0; i < NumSubsystems; ++i) {
+        const s64 time_ns = subsystem_time_ns[i].exchange(0, std::memory_order_relaxed);
+        results.subsystem_frametime[i] =
+            static_cast<double>(time_ns) / 1'000'000'000.0 / static_cast<double>(system_frames);
+    }
+
     // Reset counters
     reset_point = now;
     reset_point_system_us = current_system_time_us;
@@ -67,6 +153,12 @@ PerfStats::Results PerfStats::GetAndResetStats(u64 current_system_time_us) {
     return results;
 }
 
+PerfStats::Totals PerfStats::GetTotals() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return totals;
+}
+
 double PerfStats::GetLastFrameTimeScale() {
     std::lock_guard<std::mutex> lock(object_mutex);
 
@@ -74,12 +166,81 @@ double PerfStats::GetLastFrameTimeScale() {
     return duration_cast<DoubleSecs>(previous_frame_length).count() / FRAME_LENGTH;
 }
 
+PerfStats::Clock::duration PerfStats::GetPredictedFrameTime() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    Clock::duration total = Clock::duration::zero();
+    for (const Clock::duration frametime : frametime_history) {
+        total += frametime;
+    }
+    return total / frametime_history.size();
+}
+
+void PerfStats::BeginFrameLog() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    frame_log_enabled = true;
+    frame_log_begin = Clock::now();
+    frame_log.clear();
+}
+
+std::vector<PerfStats::Clock::duration> PerfStats::GetFrameLog() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return frame_log;
+}
+
+size_t PerfStats::GetFrameLogSize() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return frame_log.size();
+}
+
+void PerfStats::AddShaderBuild(bool loaded_from_disk) {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    if (loaded_from_disk) {
+        shader_counts.loaded_from_disk += 1;
+    } else {
+        shader_counts.compiled += 1;
+    }
+}
+
+PerfStats::ShaderCounts PerfStats::GetShaderCounts() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return shader_counts;
+}
+
+std::vector<u32> PerfStats::GetFrametimeHistogram() {
+    std::lock_guard<std::mutex> lock(object_mutex);
+
+    return {frametime_histogram.begin(), frametime_histogram.end()};
+}
+
+/**
+ * Sleeps until the given point in time. The OS only wakes threads up with a coarse granularity, so
+ * the thread sleeps until shortly before it, and spins for the rest.
+ */
+static FrameLimiter::Clock::time_point SleepUntil(FrameLimiter::Clock::time_point deadline) {
+    constexpr auto SPIN_TIME = 2ms;
+
+    auto now = FrameLimiter::Clock::now();
+    if (deadline - now > SPIN_TIME) {
+        std::this_thread::sleep_for(deadline - now - SPIN_TIME);
+    }
+    while ((now = FrameLimiter::Clock::now()) < deadline) {
+        std::this_thread::yield();
+    }
+    return now;
+}
+
 void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
     // Max lag caused by slow frames. Can be adjusted to compensate for too many slow frames. Higher
     // values increase the time needed to recover and limit framerate again after spikes.
     constexpr microseconds MAX_LAG_TIME_US = 25ms;
 
-    if (!Settings::values.toggle_framelimit) {
+    if (!Settings::values.toggle_framelimit || Settings::values.use_fast_forward) {
         return;
     }
 
@@ -91,9 +252,7 @@ void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
         std::clamp(frame_limiting_delta_err, -MAX_LAG_TIME_US, MAX_LAG_TIME_US);
 
     if (frame_limiting_delta_err > microseconds::zero()) {
-        std::this_thread::sleep_for(frame_limiting_delta_err);
-
-        auto now_after_sleep = Clock::now();
+        auto now_after_sleep = SleepUntil(now + frame_limiting_delta_err);
         frame_limiting_delta_err -= duration_cast<microseconds>(now_after_sleep - now);
         now = now_after_sleep;
     }
@@ -102,4 +261,26 @@ void FrameLimiter::DoFrameLimiting(u64 current_system_time_us) {
     previous_walltime = now;
 }
 
+void FrameLimiter::DoFramePacing(Clock::duration predicted_frametime) {
+    if (Settings::values.frame_rate_target == 0 || Settings::values.use_fast_forward) {
+        return;
+    }
+    const Clock::duration interval =
+        duration_cast<Clock::duration>(DoubleSecs(1.0 / Settings::values.frame_rate_target));
+
+    // Frames that take longer than an interval are paced to a multiple of it, so that they are
+    // still spaced evenly instead of alternating between short and long ones.
+    const auto intervals = std::max<Clock::duration::rep>(
+        1, (predicted_frametime + interval - Clock::duration(1)) / interval);
+    const Clock::time_point deadline = previous_present + interval * intervals;
+
+    const auto now = Clock::now();
+    if (now >= deadline) {
+        // Behind the schedule, start a new one from this frame instead of catching up
+        previous_present = now;
+        return;
+    }
+    previous_present = SleepUntil(deadline);
+}
+
 } // namespace Core
@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
 #include <mutex>
+#include <vector>
 #include "common/common_types.h"
 
 namespace Core {
@@ -18,6 +21,44 @@ class PerfStats {
 public:
     using Clock = std::chrono::high_resolution_clock;
 
+    /// Parts of the emulator the walltime of system frames is broken down into
+    enum class Subsystem {
+        CpuJit,       ///< Guest code running on the CPU core
+        HleServices,  ///< Supervisor calls and the HLE services behind them
+        GpuCommands,  ///< Processing of GPU command lists
+        GlSubmission, ///< Draws, blits and uploads handed to OpenGL
+        PresentWait,  ///< Frame pacing, buffer swaps and frame limiting
+        Count,
+    };
+
+    static constexpr size_t NumSubsystems = static_cast<size_t>(Subsystem::Count);
+
+    /// Returns a short name for a subsystem, for the frontends and dumps
+    static const char* GetSubsystemName(Subsystem subsystem);
+
+    /**
+     * Counts the walltime until it is destroyed towards a subsystem. Scopes nest per thread, and
+     * only the innermost one counts, so time spent in a service called by guest code isn't counted
+     * as guest code as well. Scopes on the GPU thread overlap those of the CPU thread, so the
+     * breakdown may add up to more than the frame time then.
+     */
+    class SubsystemScope {
+    public:
+        SubsystemScope(PerfStats& perf_stats, Subsystem subsystem);
+        ~SubsystemScope();
+
+        SubsystemScope(const SubsystemScope&) = delete;
+        SubsystemScope& operator=(const SubsystemScope&) = delete;
+
+    private:
+        void Accumulate(Clock::time_point now);
+
+        PerfStats& perf_stats;
+        Subsystem subsystem;
+        Clock::time_point begin;
+        SubsystemScope* parent;
+    };
+
     struct Results {
         /// System FPS (LCD VBlanks) in Hz
         double system_fps;
@@ -27,20 +68,81 @@ public:
         double frametime;
         /// Ratio of walltime / emulated time elapsed
         double emulation_speed;
+        /// Percentiles of the walltime per system frame over the last frames, excluding any waits,
+        /// in seconds
+        double frametime_p50;
+        double frametime_p95;
+        double frametime_p99;
+        /// Walltime per system frame spent in each subsystem, in seconds
+        std::array<double, NumSubsystems> subsystem_frametime;
+    };
+
+    /// Counters that are never reset, so that any number of readers can take rates of them
+    struct Totals {
+        u64 system_frames;
+        u64 game_frames;
+        /// Walltime of all the system frames, excluding any waits
+        Clock::duration frametime;
+        /// Emulated time and walltime at the end of the last system frame
+        u64 last_frame_system_us;
+        Clock::time_point last_frame_end;
     };
 
     void BeginSystemFrame();
-    void EndSystemFrame();
+    /// @param current_system_time_us Emulated time at the end of the frame
+    void EndSystemFrame(u64 current_system_time_us);
     void EndGameFrame();
 
     Results GetAndResetStats(u64 current_system_time_us);
 
+    Totals GetTotals();
+
     /**
      * Gets the ratio between walltime and the emulated time of the previous system frame. This is
      * useful for scaling inputs or outputs moving between the two time domains.
      */
     double GetLastFrameTimeScale();
 
+    /**
+     * Predicts the walltime the next system frame takes, excluding any waits, from the average of
+     * the last few ones.
+     */
+    Clock::duration GetPredictedFrameTime();
+
+    /**
+     * Starts recording the length of every system frame, including any waits, replacing what was
+     * recorded before. Meant for benchmarks, the log grows with every frame.
+     */
+    void BeginFrameLog();
+
+    /// Returns the lengths of the system frames ended since BeginFrameLog was called
+    std::vector<Clock::duration> GetFrameLog();
+
+    /// Returns the number of system frames ended since BeginFrameLog was called
+    size_t GetFrameLogSize();
+
+    struct ShaderCounts {
+        /// Shader programs built from their source
+        u32 compiled;
+        /// Shader programs loaded from the disk cache as binaries
+        u32 loaded_from_disk;
+    };
+
+    /// Counts a shader program the renderer built, for the statistics of benchmarks
+    void AddShaderBuild(bool loaded_from_disk);
+
+    ShaderCounts GetShaderCounts();
+
+    /// Width of the buckets of the frame time histogram
+    static constexpr Clock::duration FrametimeBucketWidth = std::chrono::milliseconds(1);
+
+    /**
+     * Returns how many system frames took each length since emulation started, excluding any
+     * waits. Bucket i counts the frames of at least i and less than i + 1 bucket widths, the last
+     * bucket also counts all longer frames.
+     */
+    std::vector<u32> GetFrametimeHistogram();
+
 private:
     std::mutex object_mutex;
 
@@ -56,12 +158,42 @@ private:
     /// Cumulative number of game frames (GSP frame submissions) since last reset
     u32 game_frames = 0;
 
+    /// Durations (excluding v-sync/frame-limiting) of the last system frames, as a ring
+    std::array<Clock::duration, 16> frametime_history{};
+    /// Index in frametime_history of the next frame to be recorded
+    size_t frametime_history_index = 0;
+
+    /// Durations (excluding v-sync/frame-limiting) of the frames the percentiles are taken of
+    std::array<Clock::duration, 256> percentile_history{};
+    /// Number of frames recorded in percentile_history, until it is filled up
+    size_t percentile_history_size = 0;
+    /// Index in percentile_history of the next frame to be recorded
+    size_t percentile_history_index = 0;
+
+    /// Number of system frames per length, see GetFrametimeHistogram
+    std::array<u32, 100> frametime_histogram{};
+
+    /// Cumulative walltime in nanoseconds spent in each subsystem since last reset. These are
+    /// updated without taking the mutex, from whichever thread the scopes are on.
+    std::array<std::atomic<s64>, NumSubsystems> subsystem_time_ns{};
+
     /// Point when the previous system frame ended
     Clock::time_point previous_frame_end = reset_point;
     /// Point when the current system frame began
     Clock::time_point frame_begin = reset_point;
     /// Total visible duration (including frame-limiting, etc.) of the previous system frame
     Clock::duration previous_frame_length = Clock::duration::zero();
+
+    /// Whether system frame lengths are recorded into frame_log
+    bool frame_log_enabled = false;
+    /// Point when frame logging began, so that the first frame doesn't count the time before it
+    Clock::time_point frame_log_begin = reset_point;
+    /// Lengths of the system frames since frame logging began
+    std::vector<Clock::duration> frame_log;
+
+    ShaderCounts shader_counts{};
+
+    Totals totals{};
 };
 
 class FrameLimiter {
@@ -70,6 +202,12 @@ public:
 
     void DoFrameLimiting(u64 current_system_time_us);
 
+    /**
+     * Spaces the presented frames evenly at the target frame rate set in the settings, or at an
+     * integer fraction of it when the predicted frame time doesn't fit in a single interval.
+     */
+    void DoFramePacing(Clock::duration predicted_frametime);
+
 private:
     /// Emulated system time (in microseconds) at the last limiter invocation
     u64 previous_system_time_us = 0;
@@ -78,6 +216,9 @@ private:
 
     /// Accumulated difference between walltime and emulated time
     std::chrono::microseconds frame_limiting_delta_err{0};
+
+    /// Walltime the previous frame was paced to be presented at
+    Clock::time_point previous_present = Clock::now();
 };
 
 } // namespace Core
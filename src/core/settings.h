@@ -105,6 +105,21 @@ static const std::array<const char*, NumAnalogs> mapping = {{
 }};
 } // namespace NativeAnalog
 
+/// Graphics API the GPU is emulated with
+enum class RendererBackend : u32 {
+    OpenGL = 0,
+};
+
+/// How frames are handed from the GPU thread to the display
+enum class PresentMode : u32 {
+    /// Every frame is presented, and the CPU waits for the last one before finishing the next
+    Fifo = 0,
+    /// Frames still queued when a newer one is finished are dropped
+    Mailbox = 1,
+    /// Every frame is presented, and the CPU may finish up to two more in the meantime
+    Immediate = 2,
+};
+
 struct Values {
     // System
     bool use_docked_mode;
@@ -114,26 +129,58 @@ struct Values {
     std::array<std::string, NativeAnalog::NumAnalogs> analogs;
     std::string motion_device;
     std::string touch_device;
+    u16 pad_update_rate;
 
     // Core
     bool use_cpu_jit;
+    bool use_host_timing;
+    bool use_host_thread_placement;
 
     // Data Storage
     bool use_virtual_sd;
+    u32 storage_cache_size;
+    bool use_loader_cache;
 
     // Renderer
+    RendererBackend renderer_backend;
     float resolution_factor;
+    bool use_dynamic_resolution;
     bool toggle_framelimit;
+    bool use_fast_forward;
+    u16 fast_forward_present_interval;
+    u16 frame_rate_target;
+    bool use_asynchronous_gpu_emulation;
+    bool use_lazy_surface_flushes;
+    bool use_asynchronous_queries;
+    PresentMode present_mode;
+    bool use_variable_refresh;
+    bool use_asynchronous_texture_decoding;
+    bool use_gpu_texture_deswizzling;
+    bool use_texture_content_hashing;
+    u32 texture_cache_budget;
+    bool use_disk_shader_cache;
+    bool use_asynchronous_shaders;
 
     float bg_red;
     float bg_green;
     float bg_blue;
 
+    // Audio
+    std::string sink_id;
+    bool enable_audio_stretching;
+    std::string audio_device_id;
+
     std::string log_filter;
 
     // Debugging
     bool use_gdbstub;
     u16 gdbstub_port;
+    bool profile_guest_code;
+    bool profile_timing_events;
+    bool record_ipc_calls;
+    bool record_gpu_trace;
+    u32 memory_usage_log_interval;
+    u16 metrics_export_port;
 } extern values;
 
 void Apply();
@@ -89,6 +89,7 @@ TelemetrySession::TelemetrySession() {
         backend = std::make_unique<WebService::TelemetryJson>(
             Settings::values.telemetry_endpoint_url, Settings::values.yuzu_username,
             Settings::values.yuzu_token);
+        collect_performance = true;
     } else {
         backend = std::make_unique<Telemetry::NullVisitor>();
     }
@@ -155,6 +156,8 @@ TelemetrySession::TelemetrySession() {
 
     // Log user configuration information
     AddField(Telemetry::FieldType::UserConfig, "Core_UseCpuJit", Settings::values.use_cpu_jit);
+    AddField(Telemetry::FieldType::UserConfig, "Core_UseHostTiming",
+             Settings::values.use_host_timing);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_ResolutionFactor",
              Settings::values.resolution_factor);
     AddField(Telemetry::FieldType::UserConfig, "Renderer_ToggleFramelimit",
@@ -163,6 +166,27 @@ TelemetrySession::TelemetrySession() {
              Settings::values.use_docked_mode);
 }
 
+void TelemetrySession::AddPerformanceFields(u64 emulated_time_us) {
+    if (!collect_performance) {
+        return;
+    }
+
+    const auto session_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin_time);
+    if (session_time.count() > 0) {
+        AddField(Telemetry::FieldType::Performance, "Session_EmulationSpeed",
+                 static_cast<double>(emulated_time_us) * 100.0 / session_time.count());
+    }
+    AddField(Telemetry::FieldType::Performance, "Session_Frames", frames.load());
+    AddField(Telemetry::FieldType::Performance, "Session_StutterFrames", stutter_frames.load());
+    const auto shader_counts = System::GetInstance().perf_stats.GetShaderCounts();
+    AddField(Telemetry::FieldType::Performance, "Session_ShadersCompiled", shader_counts.compiled);
+    AddField(Telemetry::FieldType::Performance, "Session_ShadersLoadedFromDisk",
+             shader_counts.loaded_from_disk);
+    AddField(Telemetry::FieldType::Performance, "Session_ShaderBuildTime",
+             static_cast<double>(shader_build_time_us.load()) / 1000.0);
+}
+
 TelemetrySession::~TelemetrySession() {
     // Log one-time session end information
     const s64 shutdown_time{std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <future>
 #include <memory>
 #include "common/telemetry.h"
@@ -31,9 +33,49 @@ public:
         field_collection.AddField(type, name, std::move(value));
     }
 
+    /**
+     * Counts time spent building shaders towards the performance fields of the session. Like the
+     * other counters, this is lock-free and does nothing unless telemetry is enabled, so it can be
+     * called from the hot paths of any thread.
+     * @param time Time the renderer was blocked building a shader.
+     */
+    void AddShaderBuildTime(std::chrono::microseconds time) {
+        if (collect_performance) {
+            shader_build_time_us.fetch_add(time.count(), std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * Counts a presented frame towards the performance fields of the session.
+     * @param frame_time_scale Length of the frame relative to a Switch frame, as returned by
+     *                         PerfStats::GetLastFrameTimeScale. Frames twice as long or longer
+     *                         are counted as stutters.
+     */
+    void AddFrame(double frame_time_scale) {
+        if (collect_performance) {
+            frames.fetch_add(1, std::memory_order_relaxed);
+            if (frame_time_scale > 2.0) {
+                stutter_frames.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * Adds the performance counters aggregated over the session to the fields.
+     * @param emulated_time_us Emulated time that elapsed during the session.
+     */
+    void AddPerformanceFields(u64 emulated_time_us);
+
 private:
     Telemetry::FieldCollection field_collection; ///< Tracks all added fields for the session
     std::unique_ptr<Telemetry::VisitorInterface> backend; ///< Backend interface that logs fields
+
+    /// Whether the performance counters are collected, only when the fields are submitted
+    bool collect_performance = false;
+    std::chrono::steady_clock::time_point begin_time = std::chrono::steady_clock::now();
+    std::atomic<u64> shader_build_time_us{0};
+    std::atomic<u32> frames{0};
+    std::atomic<u32> stutter_frames{0};
 };
 
 /**
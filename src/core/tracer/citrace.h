@@ -18,7 +18,7 @@ struct CTHeader {
     }
 
     static u32 ExpectedVersion() {
-        return 1;
+        return 2;
     }
 
     char magic[4];
@@ -64,13 +64,22 @@ enum CTStreamElementType : u32 {
     FrameMarker = 0xE1,
     MemoryLoad = 0xE2,
     RegisterWrite = 0xE3,
+    MethodCall = 0xE4,
+    CommandList = 0xE5,
+    MemoryMappings = 0xE6,
 };
 
+/// The end of a frame, along with optional data describing how it was presented
+struct CTFrameMarker {
+    u32 file_offset;
+    u32 size;
+};
+
+/// Contents of guest memory as of this point of the stream, stored in the file at file_offset
 struct CTMemoryLoad {
     u32 file_offset;
     u32 size;
-    u32 physical_address;
-    u32 pad;
+    u64 address;
 };
 
 struct CTRegisterWrite {
@@ -87,12 +96,37 @@ struct CTRegisterWrite {
     u64 value;
 };
 
+/// A method called on the engine bound to a GPU subchannel, as processed from a command list
+struct CTMethodCall {
+    u32 subchannel;
+    u32 method;
+    u32 value;
+    u32 pad;
+};
+
+/// A command list submitted to the GPU, which is read from the memory loaded before it
+struct CTCommandList {
+    u64 gpu_address;
+    u32 size;
+    u32 pad;
+};
+
+/// The whole table of GPU memory mappings, replacing the previous one, stored at file_offset
+struct CTMemoryMappings {
+    u32 file_offset;
+    u32 size;
+};
+
 struct CTStreamElement {
     CTStreamElementType type;
 
     union {
+        CTFrameMarker frame_marker;
         CTMemoryLoad memory_load;
         CTRegisterWrite register_write;
+        CTMethodCall method_call;
+        CTCommandList command_list;
+        CTMemoryMappings memory_mappings;
     };
 };
 
@@ -4,6 +4,7 @@
 
 #include <cstring>
 #include "common/assert.h"
+#include "common/content_hash.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/tracer/recorder.h"
@@ -55,21 +56,29 @@ void Recorder::Finish(const std::string& filename) {
 
     // Iterate through stream elements, update relevant stream element data
     for (auto& stream_element : stream) {
+        u32* element_file_offset = nullptr;
         switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
+        case FrameMarker:
+            element_file_offset = &stream_element.data.frame_marker.file_offset;
+            break;
+        case MemoryLoad:
+            element_file_offset = &stream_element.data.memory_load.file_offset;
+            break;
+        case MemoryMappings:
+            element_file_offset = &stream_element.data.memory_mappings.file_offset;
             break;
-        }
-
         default:
             // Other commands don't use any extra data
             DEBUG_ASSERT(stream_element.extra_data.size() == 0);
             break;
         }
+        if (element_file_offset != nullptr) {
+            auto& file_offset = memory_regions[stream_element.hash];
+            if (!stream_element.uses_existing_data) {
+                file_offset = header.stream_offset;
+            }
+            *element_file_offset = file_offset;
+        }
         header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
     }
 
@@ -163,28 +172,21 @@ void Recorder::Finish(const std::string& filename) {
     }
 }
 
-void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+void Recorder::FrameFinished(const u8* data, u32 size) {
+    StreamElement element = {{FrameMarker}};
+    element.data.frame_marker.size = size;
+    SetExtraData(element, data, size);
+
+    stream.push_back(std::move(element));
 }
 
-void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
+void Recorder::MemoryAccessed(const u8* data, u32 size, VAddr address) {
     StreamElement element = {{MemoryLoad}};
     element.data.memory_load.size = size;
-    element.data.memory_load.physical_address = physical_address;
-
-    // Compute hash over given memory region to check if the contents are already stored internally
-    boost::crc_32_type result;
-    result.process_bytes(data, size);
-    element.hash = result.checksum();
-
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
-    }
+    element.data.memory_load.address = address;
+    SetExtraData(element, data, size);
 
-    stream.push_back(element);
+    stream.push_back(std::move(element));
 }
 
 template <typename T>
@@ -201,6 +203,42 @@ void Recorder::RegisterWritten(u32 physical_address, T value) {
     stream.push_back(element);
 }
 
+void Recorder::MethodCalled(u32 subchannel, u32 method, u32 value) {
+    StreamElement element = {{MethodCall}};
+    element.data.method_call.subchannel = subchannel;
+    element.data.method_call.method = method;
+    element.data.method_call.value = value;
+
+    stream.push_back(element);
+}
+
+void Recorder::CommandListSubmitted(u64 gpu_address, u32 size) {
+    StreamElement element = {{CommandList}};
+    element.data.command_list.gpu_address = gpu_address;
+    element.data.command_list.size = size;
+
+    stream.push_back(element);
+}
+
+void Recorder::MemoryMappingsChanged(const u8* data, u32 size) {
+    StreamElement element = {{MemoryMappings}};
+    element.data.memory_mappings.size = size;
+    SetExtraData(element, data, size);
+
+    stream.push_back(std::move(element));
+}
+
+void Recorder::SetExtraData(StreamElement& element, const u8* data, u32 size) {
+    // Compute hash over given memory region to check if the contents are already stored internally
+    element.hash = Common::ContentHash64(data, size);
+
+    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
+    if (!element.uses_existing_data) {
+        element.extra_data.assign(data, data + size);
+        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
+    }
+}
+
 template void Recorder::RegisterWritten(u32, u8);
 template void Recorder::RegisterWritten(u32, u16);
 template void Recorder::RegisterWritten(u32, u32);
@@ -7,7 +7,6 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include <boost/crc.hpp>
 #include "common/common_types.h"
 #include "core/tracer/citrace.h"
 
@@ -37,15 +36,18 @@ public:
     /// Finish recording of this Citrace and save it using the given filename.
     void Finish(const std::string& filename);
 
-    /// Mark end of a frame
-    void FrameFinished();
+    /**
+     * Mark end of a frame
+     * @param data Optional data describing how the frame was presented, stored along the marker.
+     */
+    void FrameFinished(const u8* data = nullptr, u32 size = 0);
 
     /**
      * Store a copy of the given memory range in the recording.
      * @note Use this whenever the GPU is about to access a particular memory region.
      * @note The implementation will make sure to minimize redundant memory updates.
      */
-    void MemoryAccessed(const u8* data, u32 size, u32 physical_address);
+    void MemoryAccessed(const u8* data, u32 size, VAddr address);
 
     /**
      * Record a register write.
@@ -54,6 +56,21 @@ public:
     template <typename T>
     void RegisterWritten(u32 physical_address, T value);
 
+    /**
+     * Record a GPU method call.
+     * @note Use this for every method processed from a command list, in the order it is processed.
+     */
+    void MethodCalled(u32 subchannel, u32 method, u32 value);
+
+    /**
+     * Record the submission of a command list.
+     * @note The memory the list is stored in has to be recorded with MemoryAccessed beforehand.
+     */
+    void CommandListSubmitted(u64 gpu_address, u32 size);
+
+    /// Record the table of GPU memory mappings, whenever it changed.
+    void MemoryMappingsChanged(const u8* data, u32 size);
+
 private:
     // Initial state of recording start
     InitialState initial_state;
@@ -68,20 +85,23 @@ private:
          */
         std::vector<u8> extra_data;
 
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
+        /// Hash of extra_data, to store data that is recorded several times only once
+        u64 hash;
 
         /// If true, refer to data already written to the output file instead of extra_data
         bool uses_existing_data;
     };
 
+    /// Sets the extra data of an element, unless the same data has been stored before.
+    void SetExtraData(StreamElement& element, const u8* data, u32 size);
+
     std::vector<StreamElement> stream;
 
     /**
      * Internal cache which maps hashes of memory contents to file offsets at which those memory
      * contents are stored.
      */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    std::unordered_map<u64 /*hash*/, u32 /*file_offset*/> memory_regions;
 };
 
 } // namespace CiTrace
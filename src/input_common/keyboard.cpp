@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
+#include <functional>
 #include <list>
 #include <mutex>
 #include "input_common/keyboard.h"
@@ -20,11 +21,22 @@ public:
         return status.load();
     }
 
+    bool SetStatusCallback(std::function<void(const bool&)> callback) override;
+
     friend class KeyButtonList;
 
 private:
+    /// Sets the status of the button, calling the callback if it changed.
+    void SetStatus(bool pressed) {
+        if (status.exchange(pressed) != pressed && callback) {
+            callback(pressed);
+        }
+    }
+
     std::shared_ptr<KeyButtonList> key_button_list;
     std::atomic<bool> status{false};
+    /// Guarded by the mutex of key_button_list, the key events come from the frontend thread
+    std::function<void(const bool&)> callback;
 };
 
 struct KeyButtonPair {
@@ -45,18 +57,23 @@ public:
             [key_button](const KeyButtonPair& pair) { return pair.key_button == key_button; });
     }
 
+    void SetKeyButtonCallback(KeyButton* key_button, std::function<void(const bool&)> callback) {
+        std::lock_guard<std::mutex> guard(mutex);
+        key_button->callback = std::move(callback);
+    }
+
     void ChangeKeyStatus(int key_code, bool pressed) {
         std::lock_guard<std::mutex> guard(mutex);
         for (const KeyButtonPair& pair : list) {
             if (pair.key_code == key_code)
-                pair.key_button->status.store(pressed);
+                pair.key_button->SetStatus(pressed);
         }
     }
 
     void ChangeAllKeyStatus(bool pressed) {
         std::lock_guard<std::mutex> guard(mutex);
         for (const KeyButtonPair& pair : list) {
-            pair.key_button->status.store(pressed);
+            pair.key_button->SetStatus(pressed);
         }
     }
 
@@ -71,6 +88,11 @@ KeyButton::~KeyButton() {
     key_button_list->RemoveKeyButton(this);
 }
 
+bool KeyButton::SetStatusCallback(std::function<void(const bool&)> callback) {
+    key_button_list->SetKeyButtonCallback(this, std::move(callback));
+    return true;
+}
+
 std::unique_ptr<Input::ButtonDevice> Keyboard::Create(const Common::ParamPackage& params) {
     int key_code = params.Get("code", 0);
     std::unique_ptr<KeyButton> button = std::make_unique<KeyButton>(key_button_list);
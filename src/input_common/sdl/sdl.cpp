@@ -2,15 +2,24 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <SDL.h>
+#include "common/common_types.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/param_package.h"
+#include "common/thread.h"
 #include "input_common/main.h"
 #include "input_common/sdl/sdl.h"
 
@@ -22,37 +31,89 @@ class SDLJoystick;
 class SDLButtonFactory;
 class SDLAnalogFactory;
 static std::unordered_map<int, std::weak_ptr<SDLJoystick>> joystick_list;
+static std::mutex joystick_list_mutex;
 static std::shared_ptr<SDLButtonFactory> button_factory;
 static std::shared_ptr<SDLAnalogFactory> analog_factory;
 
 static bool initialized = false;
 
+/// Thread that reads the state of the open joysticks from SDL
+static std::thread poll_thread;
+static Common::Event poll_thread_stop;
+/// How often the state of the joysticks is read
+constexpr std::chrono::milliseconds poll_interval{1};
+
+/// Most buttons, hats and axes of a joystick whose state is tracked
+constexpr int MaxButtons = 128;
+constexpr int MaxHats = 8;
+constexpr int MaxAxes = 16;
+
+/**
+ * A joystick opened through SDL. Only the poll thread talks to SDL about its state, and keeps a
+ * snapshot of it that the input devices read, so reading an input is a plain memory read.
+ *
+ * The snapshot is guarded by a sequence lock: the poll thread makes the sequence odd while it
+ * writes, and readers retry if the sequence was odd or changed while they read. Every value is
+ * atomic on its own, the sequence only makes reads of several values (e.g. both axes of a stick)
+ * consistent with each other.
+ */
 class SDLJoystick {
 public:
     explicit SDLJoystick(int joystick_index)
         : joystick{SDL_JoystickOpen(joystick_index), SDL_JoystickClose} {
         if (!joystick) {
             LOG_ERROR(Input, "failed to open joystick %d", joystick_index);
+            return;
         }
+        num_buttons = std::clamp(SDL_JoystickNumButtons(joystick.get()), 0, MaxButtons);
+        num_hats = std::clamp(SDL_JoystickNumHats(joystick.get()), 0, MaxHats);
+        num_axes = std::clamp(SDL_JoystickNumAxes(joystick.get()), 0, MaxAxes);
     }
 
-    bool GetButton(int button) const {
+    /// Reads the state of the joystick from SDL into the snapshot. Only one thread may call this.
+    void UpdateState() {
         if (!joystick)
-            return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetButton(joystick.get(), button) == 1;
+            return;
+
+        const u32 begin = sequence.load(std::memory_order_relaxed);
+        sequence.store(begin + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (int word = 0; word * 64 < num_buttons; ++word) {
+            u64 mask = 0;
+            for (int bit = 0; bit < 64 && word * 64 + bit < num_buttons; ++bit) {
+                if (SDL_JoystickGetButton(joystick.get(), word * 64 + bit) == 1)
+                    mask |= 1ULL << bit;
+            }
+            buttons[word].store(mask, std::memory_order_relaxed);
+        }
+        for (int hat = 0; hat < num_hats; ++hat) {
+            hats[hat].store(SDL_JoystickGetHat(joystick.get(), hat), std::memory_order_relaxed);
+        }
+        for (int axis = 0; axis < num_axes; ++axis) {
+            axes[axis].store(SDL_JoystickGetAxis(joystick.get(), axis), std::memory_order_relaxed);
+        }
+
+        sequence.store(begin + 2, std::memory_order_release);
+    }
+
+    bool GetButton(int button) const {
+        if (button < 0 || button >= num_buttons)
+            return false;
+        const u64 mask = buttons[button / 64].load(std::memory_order_relaxed);
+        return (mask >> (button % 64) & 1) != 0;
     }
 
     float GetAxis(int axis) const {
-        if (!joystick)
-            return {};
-        SDL_JoystickUpdate();
-        return SDL_JoystickGetAxis(joystick.get(), axis) / 32767.0f;
+        return ReadAxis(axis) / 32767.0f;
     }
 
     std::tuple<float, float> GetAnalog(int axis_x, int axis_y) const {
-        float x = GetAxis(axis_x);
-        float y = GetAxis(axis_y);
+        float x, y;
+        ReadConsistent([&] {
+            x = GetAxis(axis_x);
+            y = GetAxis(axis_y);
+        });
         y = -y; // 3DS uses an y-axis inverse from SDL
 
         // Make sure the coordinates are in the unit circle,
@@ -68,7 +129,9 @@ public:
     }
 
     bool GetHatDirection(int hat, Uint8 direction) const {
-        return (SDL_JoystickGetHat(joystick.get(), hat) & direction) != 0;
+        if (hat < 0 || hat >= num_hats)
+            return false;
+        return (hats[hat].load(std::memory_order_relaxed) & direction) != 0;
     }
 
     SDL_JoystickID GetJoystickID() const {
@@ -76,7 +139,38 @@ public:
     }
 
 private:
+    s16 ReadAxis(int axis) const {
+        if (axis < 0 || axis >= num_axes)
+            return 0;
+        return axes[axis].load(std::memory_order_relaxed);
+    }
+
+    /// Runs a function reading several values of the snapshot until it read them all from the
+    /// same update.
+    template <typename Func>
+    void ReadConsistent(Func&& read) const {
+        while (true) {
+            const u32 begin = sequence.load(std::memory_order_acquire);
+            if ((begin & 1) != 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            read();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == begin)
+                return;
+        }
+    }
+
     std::unique_ptr<SDL_Joystick, decltype(&SDL_JoystickClose)> joystick;
+    int num_buttons = 0;
+    int num_hats = 0;
+    int num_axes = 0;
+
+    std::atomic<u32> sequence{0};
+    std::array<std::atomic<u64>, MaxButtons / 64> buttons{};
+    std::array<std::atomic<Uint8>, MaxHats> hats{};
+    std::array<std::atomic<s16>, MaxAxes> axes{};
 };
 
 class SDLButton final : public Input::ButtonDevice {
@@ -145,14 +239,46 @@ private:
 };
 
 static std::shared_ptr<SDLJoystick> GetJoystick(int joystick_index) {
+    std::lock_guard<std::mutex> lock(joystick_list_mutex);
     std::shared_ptr<SDLJoystick> joystick = joystick_list[joystick_index].lock();
     if (!joystick) {
         joystick = std::make_shared<SDLJoystick>(joystick_index);
+        // The poll thread can't see the joystick yet, so it is safe to fill in its first state
+        SDL_JoystickUpdate();
+        joystick->UpdateState();
         joystick_list[joystick_index] = joystick;
     }
     return joystick;
 }
 
+static void PollThread() {
+    Common::SetCurrentThreadName("SDL joystick");
+
+    std::vector<std::shared_ptr<SDLJoystick>> joysticks;
+    auto next_poll = std::chrono::steady_clock::now();
+    while (true) {
+        next_poll += poll_interval;
+        if (poll_thread_stop.WaitUntil(next_poll))
+            return;
+
+        SDL_JoystickUpdate();
+        {
+            std::lock_guard<std::mutex> lock(joystick_list_mutex);
+            for (const auto& entry : joystick_list) {
+                if (auto joystick = entry.second.lock())
+                    joysticks.push_back(std::move(joystick));
+            }
+        }
+        for (const auto& joystick : joysticks) {
+            joystick->UpdateState();
+        }
+        joysticks.clear();
+
+        // Don't try to catch up after falling behind, e.g. while the host was suspended
+        next_poll = std::max(next_poll, std::chrono::steady_clock::now());
+    }
+}
+
 /// A button device factory that creates button devices from SDL joystick
 class SDLButtonFactory final : public Input::Factory<Input::ButtonDevice> {
 public:
@@ -240,6 +366,8 @@ void Init() {
         using namespace Input;
         RegisterFactory<ButtonDevice>("sdl", std::make_shared<SDLButtonFactory>());
         RegisterFactory<AnalogDevice>("sdl", std::make_shared<SDLAnalogFactory>());
+        poll_thread_stop.Reset();
+        poll_thread = std::thread(PollThread);
         initialized = true;
     }
 }
@@ -249,7 +377,10 @@ void Shutdown() {
         using namespace Input;
         UnregisterFactory<ButtonDevice>("sdl");
         UnregisterFactory<AnalogDevice>("sdl");
+        poll_thread_stop.Set();
+        poll_thread.join();
         SDL_QuitSubSystem(SDL_INIT_JOYSTICK);
+        initialized = false;
     }
 }
 
@@ -0,0 +1,32 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <vector>
+#include "common/color.h"
+
+namespace Color {
+
+TEST_CASE("ConvertRGBA8ToARGB32", "[common]") {
+    // Lengths around the vector widths, starting at odd offsets of the allocation
+    std::vector<u8> source(40 * 4 + 3);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<u8>(i * 37 + 11);
+    }
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t count = 0; count * 4 + offset <= source.size(); ++count) {
+            std::vector<u32> converted(count);
+            ConvertRGBA8ToARGB32(source.data() + offset, converted.data(), count);
+            for (size_t i = 0; i < count; ++i) {
+                const u8* bytes = source.data() + offset + i * 4;
+                const u32 expected = static_cast<u32>(bytes[3]) << 24 | bytes[0] << 16 |
+                                     bytes[1] << 8 | bytes[2];
+                REQUIRE(converted[i] == expected);
+            }
+        }
+    }
+}
+
+} // namespace Color
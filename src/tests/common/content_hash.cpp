@@ -0,0 +1,65 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <set>
+#include <vector>
+#include "common/content_hash.h"
+
+namespace Common {
+
+namespace {
+
+std::vector<u8> MakeInput(size_t size) {
+    std::vector<u8> input(size);
+    u32 state = 12345;
+    for (u8& byte : input) {
+        state = state * 1103515245 + 12345;
+        byte = static_cast<u8>(state >> 16);
+    }
+    return input;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ContentHash[Incremental]", "[common]") {
+    // Sizes around the stripe and block boundaries, split up in every way that matters
+    const std::vector<u8> input = MakeInput(4200);
+    for (const size_t size : {0, 1, 63, 64, 65, 127, 128, 129, 1023, 1024, 1025, 2100, 4200}) {
+        const u64 hash64 = ContentHash64(input.data(), size, 7);
+        const u128 hash128 = ContentHash128(input.data(), size, 7);
+        for (const size_t piece : {1, 3, 64, 100, 1024}) {
+            ContentHasher hasher(7);
+            for (size_t offset = 0; offset < size; offset += piece) {
+                hasher.Update(input.data() + offset, std::min(piece, size - offset));
+            }
+            REQUIRE(hasher.Digest64() == hash64);
+            REQUIRE(hasher.Digest128() == hash128);
+        }
+    }
+}
+
+TEST_CASE("ContentHash[Distinct]", "[common]") {
+    std::vector<u8> input = MakeInput(3000);
+    std::set<u64> hashes;
+    // Every length gives another hash, including the ones that only add zeroes to the tail
+    std::vector<u8> zeroes(200);
+    for (size_t size = 0; size <= zeroes.size(); ++size) {
+        hashes.insert(ContentHash64(zeroes.data(), size));
+    }
+    REQUIRE(hashes.size() == zeroes.size() + 1);
+
+    // Flipping any single bit changes the hash, as does changing the seed
+    const u64 base = ContentHash64(input.data(), input.size());
+    REQUIRE(ContentHash64(input.data(), input.size(), 1) != base);
+    for (size_t bit = 0; bit < input.size() * 8; bit += 7) {
+        input[bit / 8] ^= 1 << (bit % 8);
+        REQUIRE(ContentHash64(input.data(), input.size()) != base);
+        input[bit / 8] ^= 1 << (bit % 8);
+    }
+    REQUIRE(ContentHash64(input.data(), input.size()) == base);
+}
+
+} // namespace Common
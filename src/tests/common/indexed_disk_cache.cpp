@@ -0,0 +1,108 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "common/indexed_disk_cache.h"
+
+namespace Common {
+
+namespace {
+
+std::vector<u8> MakeValue(u64 key, size_t size) {
+    std::vector<u8> value(size);
+    for (size_t i = 0; i < size; ++i) {
+        value[i] = static_cast<u8>(key + i);
+    }
+    return value;
+}
+
+std::string GetTestPath() {
+    const std::string directory = FileUtil::GetCurrentDir() + "/yuzu_disk_cache_test/";
+    FileUtil::DeleteDirRecursively(directory);
+    FileUtil::CreateFullPath(directory);
+    return directory + "cache.bin";
+}
+
+} // Anonymous namespace
+
+TEST_CASE("IndexedDiskCache[Reopen]", "[common]") {
+    const std::string path = GetTestPath();
+    {
+        IndexedDiskCache cache;
+        REQUIRE(cache.Open(path, 1));
+        for (u64 key = 0; key < 16; ++key) {
+            const std::vector<u8> value = MakeValue(key, key * 3);
+            REQUIRE(cache.Write(key, value.data(), value.size()));
+        }
+        // Values written in this session are read back before the index exists
+        std::vector<u8> value;
+        REQUIRE(cache.Read(5, value));
+        REQUIRE(value == MakeValue(5, 15));
+    }
+
+    IndexedDiskCache cache;
+    REQUIRE(cache.Open(path, 1));
+    REQUIRE(cache.GetSize() == 16);
+    std::vector<u8> value;
+    for (u64 key = 0; key < 16; ++key) {
+        REQUIRE(cache.Read(key, value));
+        REQUIRE(value == MakeValue(key, key * 3));
+    }
+    REQUIRE(!cache.Read(16, value));
+
+    // Replaced values win over the ones in the index
+    const std::vector<u8> replaced = MakeValue(100, 7);
+    REQUIRE(cache.Write(3, replaced.data(), replaced.size()));
+    cache.Close();
+    REQUIRE(cache.Open(path, 1));
+    REQUIRE(cache.Read(3, value));
+    REQUIRE(value == replaced);
+
+    // Files of another tag are started over
+    cache.Close();
+    REQUIRE(cache.Open(path, 2));
+    REQUIRE(cache.GetSize() == 0);
+}
+
+TEST_CASE("IndexedDiskCache[Compaction]", "[common]") {
+    const std::string path = GetTestPath();
+    constexpr size_t value_size = 64 * 1024;
+    {
+        IndexedDiskCache cache;
+        REQUIRE(cache.Open(path, 1));
+        // Every value is written over 16 times, leaving most of the file stale
+        for (u64 round = 0; round < 16; ++round) {
+            for (u64 key = 0; key < 4; ++key) {
+                const std::vector<u8> value = MakeValue(key + round, value_size);
+                REQUIRE(cache.Write(key, value.data(), value.size()));
+            }
+        }
+    }
+    const u64 stale_size = FileUtil::GetSize(path);
+
+    {
+        // The values written while compacting make it to the compacted file as well
+        IndexedDiskCache cache;
+        REQUIRE(cache.Open(path, 1));
+        const std::vector<u8> value = MakeValue(50, 10);
+        REQUIRE(cache.Write(7, value.data(), value.size()));
+    }
+    REQUIRE(FileUtil::GetSize(path) < stale_size / 4);
+
+    IndexedDiskCache cache;
+    REQUIRE(cache.Open(path, 1));
+    REQUIRE(cache.GetSize() == 5);
+    std::vector<u8> value;
+    for (u64 key = 0; key < 4; ++key) {
+        REQUIRE(cache.Read(key, value));
+        REQUIRE(value == MakeValue(key + 15, value_size));
+    }
+    REQUIRE(cache.Read(7, value));
+    REQUIRE(value == MakeValue(50, 10));
+}
+
+} // namespace Common
@@ -0,0 +1,44 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include "common/memory_usage.h"
+
+namespace Common {
+
+namespace {
+
+bool IsListed(const char* name) {
+    const auto entries = GetMemoryUsage();
+    return std::any_of(entries.begin(), entries.end(), [name](const MemoryUsageEntry& entry) {
+        return std::strcmp(entry.name, name) == 0;
+    });
+}
+
+} // Anonymous namespace
+
+TEST_CASE("MemoryUsage[Counters]", "[common]") {
+    auto counter = std::make_unique<MemoryUsageCounter>("Test counter");
+    REQUIRE(IsListed("Test counter"));
+
+    counter->Add(3000);
+    counter->Subtract(1000);
+    REQUIRE(counter->Get() == 2000);
+    counter->Set(500);
+    REQUIRE(counter->Get() == 500);
+
+    const auto entries = GetMemoryUsage();
+    REQUIRE(std::is_sorted(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+        return std::strcmp(lhs.name, rhs.name) < 0;
+    }));
+
+    counter.reset();
+    REQUIRE(!IsListed("Test counter"));
+}
+
+} // namespace Common
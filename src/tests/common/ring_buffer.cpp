@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <array>
+#include <thread>
+#include <vector>
+#include "common/ring_buffer.h"
+
+namespace Common {
+
+TEST_CASE("RingBuffer[Wrap]", "[common]") {
+    RingBuffer<int, 2, 4> buffer;
+    REQUIRE(buffer.Size() == 0);
+
+    const std::array<int, 6> first{{0, 1, 2, 3, 4, 5}};
+    REQUIRE(buffer.Push(first.data(), 3) == 3);
+    REQUIRE(buffer.Size() == 3);
+
+    std::array<int, 4> popped{};
+    REQUIRE(buffer.Pop(popped.data(), 2) == 2);
+    REQUIRE(popped == (std::array<int, 4>{{0, 1, 2, 3}}));
+
+    // Only three of the four slots fit, and the write wraps around the end of the buffer
+    const std::array<int, 8> second{{6, 7, 8, 9, 10, 11, 12, 13}};
+    REQUIRE(buffer.Push(second.data(), 4) == 3);
+    REQUIRE(buffer.Size() == 4);
+
+    std::array<int, 10> rest{};
+    REQUIRE(buffer.Pop(rest.data(), 5) == 4);
+    REQUIRE(rest == (std::array<int, 10>{{4, 5, 6, 7, 8, 9, 10, 11, 0, 0}}));
+    REQUIRE(buffer.Size() == 0);
+    REQUIRE(buffer.Pop(rest.data(), 1) == 0);
+}
+
+TEST_CASE("RingBuffer[Threaded]", "[common]") {
+    constexpr int num_slots = 100000;
+    RingBuffer<int, 1, 64> buffer;
+
+    std::thread writer([&buffer] {
+        for (int value = 0; value < num_slots;) {
+            value += static_cast<int>(buffer.Push(&value, 1));
+        }
+    });
+
+    std::vector<int> values;
+    values.reserve(num_slots);
+    while (values.size() < num_slots) {
+        std::array<int, 16> chunk;
+        const size_t count = buffer.Pop(chunk.data(), chunk.size());
+        values.insert(values.end(), chunk.begin(), chunk.begin() + count);
+    }
+    writer.join();
+
+    for (int i = 0; i < num_slots; ++i) {
+        REQUIRE(values[i] == i);
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,59 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <vector>
+#include "common/swap.h"
+
+namespace Common {
+
+namespace {
+
+template <typename T, T (*Swap)(T)>
+void CheckSwapArray() {
+    // Lengths around the vector width, starting at odd offsets of the allocation
+    std::vector<T> source(80);
+    for (size_t i = 0; i < source.size(); ++i) {
+        source[i] = static_cast<T>(0x0123456789ABCDEF * (i + 1));
+    }
+    for (size_t offset = 0; offset < 3; ++offset) {
+        for (size_t count = 0; count + offset <= source.size(); ++count) {
+            std::vector<T> swapped(count);
+            SwapArray(swapped.data(), source.data() + offset, count);
+            std::vector<T> in_place(source.begin() + offset, source.begin() + offset + count);
+            SwapArray(in_place.data(), count);
+            for (size_t i = 0; i < count; ++i) {
+                REQUIRE(swapped[i] == Swap(source[offset + i]));
+            }
+            REQUIRE(in_place == swapped);
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SwapArray[Integers]", "[common]") {
+    CheckSwapArray<u16, swap16>();
+    CheckSwapArray<u32, swap32>();
+    CheckSwapArray<u64, swap64>();
+}
+
+TEST_CASE("SwapArray[Floats]", "[common]") {
+    std::vector<float> values{1.0f, -2.5f, 1e10f, 0.0f, 3.25f};
+    std::vector<float> swapped(values.size());
+    SwapArray(swapped.data(), values.data(), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        REQUIRE(swapf(swapped[i]) == values[i]);
+    }
+
+    ConvertBigEndianArray(swapped.data(), swapped.size());
+    ConvertBigEndianArray(swapped.data(), swapped.size());
+#if COMMON_LITTLE_ENDIAN
+    ConvertLittleEndianArray(swapped.data(), swapped.size());
+    REQUIRE(swapf(swapped[0]) == values[0]);
+#endif
+}
+
+} // namespace Common
@@ -0,0 +1,55 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <vector>
+#include "common/thread_placement.h"
+
+namespace Common {
+
+namespace {
+
+/// Cores that run two logical CPUs each, numbered the way most hosts do
+std::vector<HostCore> MakeSMTCores(u32 num_cores) {
+    std::vector<HostCore> cores(num_cores);
+    for (u32 i = 0; i < num_cores; ++i) {
+        cores[i].logical_cpus = {i, i + num_cores};
+    }
+    return cores;
+}
+
+const std::vector<u32>& CPUsOf(const ThreadPlacement& placement, ThreadRole role) {
+    return placement[static_cast<size_t>(role)];
+}
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadPlacement[CriticalRoles]", "[common]") {
+    const ThreadPlacement placement = PlanThreadPlacement(MakeSMTCores(6));
+
+    // Each critical role gets a whole physical core, SMT sibling included
+    REQUIRE(CPUsOf(placement, ThreadRole::CPU) == std::vector<u32>{0, 6});
+    REQUIRE(CPUsOf(placement, ThreadRole::GPU) == std::vector<u32>{1, 7});
+    REQUIRE(CPUsOf(placement, ThreadRole::Audio) == std::vector<u32>{2, 8});
+    REQUIRE(CPUsOf(placement, ThreadRole::Worker) == std::vector<u32>{3, 9, 4, 10, 5, 11});
+}
+
+TEST_CASE("ThreadPlacement[FewCores]", "[common]") {
+    SECTION("a core is always left for the workers") {
+        const ThreadPlacement placement = PlanThreadPlacement(MakeSMTCores(2));
+        REQUIRE(CPUsOf(placement, ThreadRole::CPU) == std::vector<u32>{0, 2});
+        REQUIRE(CPUsOf(placement, ThreadRole::GPU) == CPUsOf(placement, ThreadRole::Worker));
+        REQUIRE(CPUsOf(placement, ThreadRole::Audio) == CPUsOf(placement, ThreadRole::Worker));
+        REQUIRE(CPUsOf(placement, ThreadRole::Worker) == std::vector<u32>{1, 3});
+    }
+    SECTION("a single core is left to the OS") {
+        const ThreadPlacement placement = PlanThreadPlacement(MakeSMTCores(1));
+        for (const std::vector<u32>& cpus : placement) {
+            REQUIRE(cpus.empty());
+        }
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,64 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+#include "common/thread_pool.h"
+
+namespace Common {
+
+TEST_CASE("ThreadPool[Futures]", "[common]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.GetThreadCount() == 4);
+
+    // More tasks than fit in the shared queue, some of which submit tasks of their own
+    std::atomic<int> nested_count{0};
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < 4000; ++i) {
+        futures.push_back(pool.Submit([&pool, &nested_count, i] {
+            if (i % 10 == 0) {
+                pool.Submit([&nested_count] { ++nested_count; });
+            }
+            return i * 2;
+        }));
+    }
+    for (int i = 0; i < 4000; ++i) {
+        REQUIRE(futures[i].get() == i * 2);
+    }
+    pool.WaitIdle();
+    REQUIRE(nested_count == 400);
+
+    auto failing = pool.Submit([]() -> int { throw std::runtime_error("task failed"); });
+    REQUIRE_THROWS_AS(failing.get(), std::runtime_error);
+}
+
+TEST_CASE("ThreadPool[Cancellation]", "[common]") {
+    ThreadPool pool(1);
+    CancellationToken token;
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+
+    // The only worker is kept busy until the second task was cancelled
+    auto blocker = pool.Submit([released] { released.wait(); });
+    std::atomic<bool> ran{false};
+    auto cancelled = pool.Submit([&ran] { ran = true; }, token);
+    token.Cancel();
+    release.set_value();
+
+    blocker.get();
+    pool.WaitIdle();
+    REQUIRE(!ran);
+    try {
+        cancelled.get();
+        FAIL("Cancelled task reported a result");
+    } catch (const std::future_error& error) {
+        REQUIRE(error.code() == std::future_errc::broken_promise);
+    }
+}
+
+} // namespace Common
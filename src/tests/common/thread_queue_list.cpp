@@ -0,0 +1,34 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace Common {
+
+TEST_CASE("ThreadQueueList", "[common]") {
+    ThreadQueueList<int, 64> queue;
+    REQUIRE(queue.get_first() == 0);
+
+    queue.push_back(10, 1);
+    queue.push_back(5, 2);
+    queue.push_back(63, 3);
+    queue.push_back(5, 4);
+
+    // The lowest priority level is the best one, threads at one level are served in order.
+    REQUIRE(queue.get_first() == 2);
+    REQUIRE(queue.pop_first_better(5) == 0);
+    REQUIRE(queue.pop_first_better(6) == 2);
+
+    queue.remove(5, 4);
+    REQUIRE(queue.empty(5));
+    REQUIRE(queue.pop_first() == 1);
+
+    queue.move(3, 63, 0);
+    REQUIRE(queue.empty(63));
+    REQUIRE(queue.pop_first() == 3);
+    REQUIRE(queue.pop_first() == 0);
+}
+
+} // namespace Common
@@ -0,0 +1,108 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "common/threadsafe_queue.h"
+
+namespace Common {
+
+TEST_CASE("MPSCRingQueue[Bounded]", "[common]") {
+    MPSCRingQueue<int, 4> queue;
+    REQUIRE(queue.Empty());
+
+    for (int i = 0; i < 4; ++i) {
+        REQUIRE(queue.TryPush(i));
+    }
+    REQUIRE_FALSE(queue.TryPush(4));
+
+    int value = -1;
+    REQUIRE(queue.Pop(value));
+    REQUIRE(value == 0);
+    REQUIRE(queue.TryPush(4));
+
+    std::vector<int> popped;
+    REQUIRE(queue.PopAll([&popped](int v) { popped.push_back(v); }) == 4);
+    REQUIRE(popped == std::vector<int>{1, 2, 3, 4});
+    REQUIRE(queue.Empty());
+    REQUIRE_FALSE(queue.Pop(value));
+}
+
+TEST_CASE("MPSCRingQueue[MultipleWriters]", "[common]") {
+    constexpr int num_writers = 4;
+    constexpr int values_per_writer = 100000;
+    MPSCRingQueue<int, 256> queue;
+
+    std::vector<std::thread> writers;
+    for (int writer = 0; writer < num_writers; ++writer) {
+        writers.emplace_back([&queue, writer] {
+            for (int i = 0; i < values_per_writer; ++i) {
+                while (!queue.TryPush(writer * values_per_writer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Values from each writer must come out in the order that writer pushed them.
+    std::array<int, num_writers> next_value{};
+    int remaining = num_writers * values_per_writer;
+    while (remaining != 0) {
+        remaining -= static_cast<int>(queue.PopAll([&next_value](int v) {
+            const int writer = v / values_per_writer;
+            REQUIRE(v % values_per_writer == next_value[writer]);
+            ++next_value[writer];
+        }));
+    }
+
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("MPMCRingQueue[MultipleReaders]", "[common]") {
+    constexpr int num_threads = 4;
+    constexpr int values_per_writer = 100000;
+    MPMCRingQueue<int, 256> queue;
+    std::atomic<int> remaining{num_threads * values_per_writer};
+    // Every value is popped exactly once, whichever reader gets it.
+    std::vector<std::atomic<int>> pop_counts(num_threads * values_per_writer);
+
+    std::vector<std::thread> threads;
+    for (int writer = 0; writer < num_threads; ++writer) {
+        threads.emplace_back([&queue, writer] {
+            for (int i = 0; i < values_per_writer; ++i) {
+                while (!queue.TryPush(writer * values_per_writer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int reader = 0; reader < num_threads; ++reader) {
+        threads.emplace_back([&queue, &remaining, &pop_counts] {
+            int value;
+            while (remaining.load() > 0) {
+                if (queue.TryPop(value)) {
+                    ++pop_counts[value];
+                    --remaining;
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(queue.Empty());
+    for (const auto& count : pop_counts) {
+        REQUIRE(count.load() == 1);
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,64 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <catch.hpp>
+#include "common/vector_math.h"
+
+namespace Math {
+
+TEST_CASE("Vec4[Float]", "[common]") {
+    const Vec4<float> a(1.5f, -2.0f, 0.25f, 8.0f);
+    const Vec4<float> b(0.5f, 4.0f, -3.0f, 0.125f);
+
+    const Vec4<float> sum = a + b;
+    REQUIRE(sum.x == 2.0f);
+    REQUIRE(sum.y == 2.0f);
+    REQUIRE(sum.z == -2.75f);
+    REQUIRE(sum.w == 8.125f);
+
+    const Vec4<float> difference = a - b;
+    REQUIRE(difference.x == 1.0f);
+    REQUIRE(difference.y == -6.0f);
+    REQUIRE(difference.z == 3.25f);
+    REQUIRE(difference.w == 7.875f);
+
+    const Vec4<float> product = a * b;
+    REQUIRE(product.x == 0.75f);
+    REQUIRE(product.y == -8.0f);
+    REQUIRE(product.z == -0.75f);
+    REQUIRE(product.w == 1.0f);
+
+    const Vec4<float> scaled = a * 2.0f;
+    REQUIRE(scaled.x == 3.0f);
+    REQUIRE(scaled.y == -4.0f);
+    REQUIRE(scaled.z == 0.5f);
+    REQUIRE(scaled.w == 16.0f);
+
+    REQUIRE(Dot(a, b) == 0.75f - 8.0f - 0.75f + 1.0f);
+
+    const Vec4<float> halfway = Lerp(a, b, 0.5f);
+    REQUIRE(halfway.x == 1.0f);
+    REQUIRE(halfway.y == 1.0f);
+    REQUIRE(halfway.z == -1.375f);
+    REQUIRE(halfway.w == 4.0625f);
+}
+
+TEST_CASE("Vec4[U8]", "[common]") {
+    const Vec4<u8> begin(0, 255, 100, 20);
+    const Vec4<u8> end(255, 0, 200, 20);
+
+    const Vec4<float> scaled = begin * 0.5f;
+    REQUIRE(scaled.x == 0.0f);
+    REQUIRE(scaled.y == 127.5f);
+    REQUIRE(scaled.z == 50.0f);
+    REQUIRE(scaled.w == 10.0f);
+
+    const Vec4<float> quarter = Lerp(begin, end, 0.25f);
+    REQUIRE(quarter.x == 63.75f);
+    REQUIRE(quarter.y == 191.25f);
+    REQUIRE(quarter.z == 125.0f);
+    REQUIRE(quarter.w == 20.0f);
+}
+
+} // namespace Math
@@ -18,9 +18,10 @@ TestEnvironment::TestEnvironment(bool mutable_memory_)
     Core::CurrentProcess() = Kernel::Process::Create("");
     page_table = &Core::CurrentProcess()->vm_manager.page_table;
 
-    page_table->pointers.fill(nullptr);
+    page_table->pointers.Clear();
     page_table->special_regions.clear();
-    page_table->attributes.fill(Memory::PageType::Unmapped);
+    page_table->special_region_index.Clear();
+    page_table->attributes.Clear();
 
     Memory::MapIoRegion(*page_table, 0x00000000, 0x80000000, test_memory);
     Memory::MapIoRegion(*page_table, 0x80000000, 0x80000000, test_memory);
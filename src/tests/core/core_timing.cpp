@@ -4,12 +4,22 @@
 
 #include <catch.hpp>
 
+#include <algorithm>
 #include <array>
 #include <bitset>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <random>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include "common/chunk_file.h"
 #include "common/file_util.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "tests/test_utils.h"
 
 // Numbers are chosen randomly to make sure the correct one is given.
 static constexpr std::array<u64, 5> CB_IDS{{42, 144, 93, 1026, UINT64_C(0xFFFF7FFFF7FFFF)}};
@@ -138,6 +148,35 @@ void FifoCallback(u64 userdata, s64 cycles_late) {
 }
 } // namespace SharedSlotTest
 
+TEST_CASE("CoreTiming[UnscheduleByHandle]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+    CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", CallbackTemplate<2>);
+
+    // Only the event the handle refers to is removed, not the other one with the same userdata
+    const CoreTiming::EventHandle first_a = CoreTiming::ScheduleEvent(100, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(300, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(200, cb_b, CB_IDS[1]);
+    CoreTiming::UnscheduleEvent(first_a);
+
+    // The new event takes over the slot of the removed one, which the stale handle must not reach
+    const CoreTiming::EventHandle c = CoreTiming::ScheduleEvent(400, cb_c, CB_IDS[2]);
+    CoreTiming::UnscheduleEvent(first_a);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+    REQUIRE(200 == CoreTiming::GetDowncount());
+
+    AdvanceAndCheck(1, 100);
+    AdvanceAndCheck(0, 100);
+    AdvanceAndCheck(2, MAX_SLICE_LENGTH);
+
+    // Unscheduling an event that already fired does nothing
+    CoreTiming::UnscheduleEvent(c);
+}
+
 TEST_CASE("CoreTiming[SharedSlot]", "[core]") {
     using namespace SharedSlotTest;
 
@@ -235,3 +274,366 @@ TEST_CASE("CoreTiming[ChainScheduling]", "[core]") {
     REQUIRE(0 == reschedules);
     REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
 }
+
+TEST_CASE("CoreTiming[DistantEvents]", "[core]") {
+    using namespace SharedSlotTest;
+
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", FifoCallback<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", FifoCallback<1>);
+    CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", FifoCallback<2>);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Far enough apart to need cascading between the levels of the wheel, and past its range
+    constexpr s64 near_time = 5000000;
+    constexpr s64 far_time = s64(1) << 40;
+    CoreTiming::ScheduleEvent(far_time, cb_c, CB_IDS[2]);
+    CoreTiming::ScheduleEvent(near_time, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(near_time, cb_b, CB_IDS[1]);
+    REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
+
+    callbacks_ran_flags = 0;
+    counter = 0;
+    lateness = 0;
+    CoreTiming::AddTicks(near_time - 10);
+    CoreTiming::Advance();
+    REQUIRE(0 == callbacks_ran_flags.to_ullong());
+    REQUIRE(10 == CoreTiming::GetDowncount());
+
+    CoreTiming::AddTicks(CoreTiming::GetDowncount());
+    CoreTiming::Advance();
+    REQUIRE(0x3ULL == callbacks_ran_flags.to_ullong());
+
+    for (s64 remaining = far_time - near_time; remaining > 0;) {
+        REQUIRE(0x3ULL == callbacks_ran_flags.to_ullong());
+        const s64 step = std::min<s64>(remaining, s64(1) << 30);
+        CoreTiming::AddTicks(step);
+        CoreTiming::Advance();
+        remaining -= step;
+    }
+    REQUIRE(0x7ULL == callbacks_ran_flags.to_ullong());
+    REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
+}
+
+TEST_CASE("CoreTiming[SaveState]", "[core]") {
+    ScopeInit guard;
+
+    CoreTiming::EventType* cb_a = CoreTiming::RegisterEvent("callbackA", CallbackTemplate<0>);
+    CoreTiming::EventType* cb_b = CoreTiming::RegisterEvent("callbackB", CallbackTemplate<1>);
+    CoreTiming::EventType* cb_c = CoreTiming::RegisterEvent("callbackC", CallbackTemplate<2>);
+    CoreTiming::EventType* cb_d = CoreTiming::RegisterEvent("callbackD", CallbackTemplate<3>);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    CoreTiming::ScheduleEvent(1000, cb_a, CB_IDS[0]);
+    CoreTiming::ScheduleEvent(500, cb_b, CB_IDS[1]);
+    CoreTiming::ScheduleEvent(100, cb_d, CB_IDS[3]);
+
+    u8* ptr = nullptr;
+    PointerWrap measure(&ptr, PointerWrap::MODE_MEASURE);
+    CoreTiming::DoState(measure);
+    std::vector<u8> state(reinterpret_cast<size_t>(ptr));
+    ptr = state.data();
+    PointerWrap save(&ptr, PointerWrap::MODE_WRITE);
+    CoreTiming::DoState(save);
+
+    // Events scheduled after the state was saved are gone once it is loaded
+    CoreTiming::ScheduleEvent(50, cb_c, CB_IDS[2]);
+    ptr = state.data();
+    PointerWrap load(&ptr, PointerWrap::MODE_READ);
+    CoreTiming::DoState(load);
+    REQUIRE(PointerWrap::ERROR_NONE == load.error);
+
+    AdvanceAndCheck(3, 400);
+    AdvanceAndCheck(1, 500);
+    AdvanceAndCheck(0, MAX_SLICE_LENGTH);
+}
+
+namespace {
+
+using Tests::Report;
+
+/// The binary heap CoreTiming used to keep its events in, before the timing wheel. Serves as the
+/// reference for the order events have to fire in, and as a baseline for the benchmarks.
+class ReferenceQueue {
+public:
+    void Schedule(s64 time, u64 userdata) {
+        events.push_back({time, fifo_id++, userdata});
+        std::push_heap(events.begin(), events.end(), std::greater<Event>());
+    }
+
+    /// Fires every event due by target in order, calling func(queue, userdata, event time).
+    template <typename Func>
+    void Advance(s64 target, Func&& func) {
+        while (!events.empty() && events.front().time <= target) {
+            std::pop_heap(events.begin(), events.end(), std::greater<Event>());
+            const Event event = events.back();
+            events.pop_back();
+            func(*this, event.userdata, event.time);
+        }
+    }
+
+    /// Time of the earliest event, or the largest s64 if there is none.
+    s64 GetNextEventTime() const {
+        return events.empty() ? std::numeric_limits<s64>::max() : events.front().time;
+    }
+
+private:
+    struct Event {
+        s64 time;
+        u64 fifo_order;
+        u64 userdata;
+
+        bool operator>(const Event& other) const {
+            return std::tie(time, fifo_order) > std::tie(other.time, other.fifo_order);
+        }
+    };
+
+    std::vector<Event> events;
+    u64 fifo_id = 0;
+};
+
+/// Times one run of func and returns how long it took in nanoseconds.
+template <typename Func>
+double TimeRun(Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// Spread like the periodic events of a running game: from short CPU timeouts to vsync and beyond.
+constexpr std::array<s64, 6> PERIODS{{1000, 20000, 100000, 1019215, 16986931, 1019215872}};
+
+/// Runs CoreTiming forward a slice at a time, until count more events have fired.
+template <typename Counter>
+size_t RunUntilFired(const Counter& fired, u64 count) {
+    const u64 target = fired + count;
+    size_t advances = 0;
+    while (fired < target) {
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+        ++advances;
+    }
+    return advances;
+}
+
+} // Anonymous namespace
+
+namespace FifoOrderTest {
+static constexpr u64 MAX_EVENTS = 6000;
+static std::vector<u64> fired;
+static u64 next_id = 0;
+static CoreTiming::EventType* event_type = nullptr;
+
+/// Some events schedule another one when they fire, possibly due within the same Advance.
+static s64 GetChildDelay(u64 userdata) {
+    return userdata % 3 == 0 ? static_cast<s64>(userdata % 7) * 450 + 1 : 0;
+}
+
+static void Callback(u64 userdata, s64 cycles_late) {
+    fired.push_back(userdata);
+    const s64 delay = GetChildDelay(userdata);
+    if (delay != 0 && next_id < MAX_EVENTS) {
+        CoreTiming::ScheduleEvent(delay - cycles_late, event_type, next_id++);
+    }
+}
+} // namespace FifoOrderTest
+
+TEST_CASE("CoreTiming[FifoOrder]", "[core]") {
+    using namespace FifoOrderTest;
+
+    ScopeInit guard;
+    event_type = CoreTiming::RegisterEvent("callback", Callback);
+    fired.clear();
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<s64> time_distribution(0, 4000);
+    std::uniform_int_distribution<int> step_distribution(1, 3000);
+
+    // Enter slice 0
+    CoreTiming::Advance();
+
+    // Plenty of events share a time, which is where the order they were scheduled in decides
+    ReferenceQueue reference;
+    for (next_id = 0; next_id < 2000; ++next_id) {
+        const s64 time = time_distribution(rng);
+        const CoreTiming::EventHandle handle = CoreTiming::ScheduleEvent(time, event_type, next_id);
+        if (next_id % 10 == 9) {
+            CoreTiming::UnscheduleEvent(handle);
+        } else {
+            reference.Schedule(time, next_id);
+        }
+    }
+
+    // Slices end at random points past the events, so that they fire late as well
+    while (CoreTiming::GetTicks() < 40000) {
+        CoreTiming::AddTicks(step_distribution(rng));
+        CoreTiming::Advance();
+    }
+
+    std::vector<u64> expected;
+    u64 reference_next_id = 2000;
+    reference.Advance(CoreTiming::GetTicks(),
+                      [&](ReferenceQueue& queue, u64 userdata, s64 time) {
+                          expected.push_back(userdata);
+                          const s64 delay = GetChildDelay(userdata);
+                          if (delay != 0 && reference_next_id < MAX_EVENTS) {
+                              queue.Schedule(time + delay, reference_next_id++);
+                          }
+                      });
+
+    REQUIRE(reference.GetNextEventTime() > static_cast<s64>(CoreTiming::GetTicks()));
+    REQUIRE(fired.size() == expected.size());
+    REQUIRE(fired == expected);
+}
+
+namespace BenchmarkTest {
+static u64 fired = 0;
+static CoreTiming::EventType* periodic_type = nullptr;
+
+/// Periodic events carry their period as userdata, and schedule themselves again.
+static void PeriodicCallback(u64 userdata, s64 cycles_late) {
+    ++fired;
+    CoreTiming::ScheduleEvent(static_cast<s64>(userdata) - cycles_late, periodic_type, userdata);
+}
+
+static void CountingCallback(u64 userdata, s64 cycles_late) {
+    ++fired;
+}
+} // namespace BenchmarkTest
+
+TEST_CASE("CoreTiming periodic events", "[core][benchmark][!hide]") {
+    using namespace BenchmarkTest;
+
+    for (const size_t num_events : {10000, 100000, 1000000}) {
+        const u64 num_fires = num_events * 4;
+        const std::string suffix = ".events=" + std::to_string(num_events);
+
+        std::mt19937 rng(num_events);
+        std::vector<s64> first_times(num_events);
+        for (size_t i = 0; i < num_events; ++i) {
+            const s64 period = PERIODS[i % PERIODS.size()];
+            first_times[i] = std::uniform_int_distribution<s64>(1, period)(rng);
+        }
+
+        {
+            ScopeInit guard;
+            periodic_type = CoreTiming::RegisterEvent("periodic", PeriodicCallback);
+            fired = 0;
+
+            // Enter slice 0
+            CoreTiming::Advance();
+
+            const double schedule_ns = TimeRun([&] {
+                for (size_t i = 0; i < num_events; ++i) {
+                    CoreTiming::ScheduleEvent(first_times[i], periodic_type,
+                                              PERIODS[i % PERIODS.size()]);
+                }
+            });
+            size_t advances = 0;
+            const double fire_ns = TimeRun([&] { advances = RunUntilFired(fired, num_fires); });
+
+            Report("core_timing.wheel.schedule" + suffix, num_events, schedule_ns / num_events);
+            Report("core_timing.wheel.fire" + suffix, fired, fire_ns / fired);
+            Report("core_timing.wheel.advance" + suffix, advances, fire_ns / advances);
+        }
+
+        // The same events in the heap, which is advanced over the same slices as CoreTiming
+        ReferenceQueue reference;
+        const double schedule_ns = TimeRun([&] {
+            for (size_t i = 0; i < num_events; ++i) {
+                reference.Schedule(first_times[i], PERIODS[i % PERIODS.size()]);
+            }
+        });
+        u64 reference_fired = 0;
+        const double fire_ns = TimeRun([&] {
+            s64 time = 0;
+            while (reference_fired < num_fires) {
+                time = std::min<s64>(reference.GetNextEventTime(), time + MAX_SLICE_LENGTH);
+                reference.Advance(time, [&](ReferenceQueue& queue, u64 period, s64 event_time) {
+                    ++reference_fired;
+                    queue.Schedule(event_time + static_cast<s64>(period), period);
+                });
+            }
+        });
+
+        Report("core_timing.heap.schedule" + suffix, num_events, schedule_ns / num_events);
+        Report("core_timing.heap.fire" + suffix, reference_fired, fire_ns / reference_fired);
+    }
+}
+
+TEST_CASE("CoreTiming unscheduling", "[core][benchmark][!hide]") {
+    using namespace BenchmarkTest;
+
+    for (const size_t num_events : {10000, 100000, 1000000}) {
+        ScopeInit guard;
+        CoreTiming::EventType* event_type = CoreTiming::RegisterEvent("event", CountingCallback);
+        fired = 0;
+
+        // Enter slice 0
+        CoreTiming::Advance();
+
+        std::mt19937 rng(num_events);
+        std::uniform_int_distribution<s64> time_distribution(1, PERIODS.back());
+        std::vector<CoreTiming::EventHandle> handles(num_events);
+        for (size_t i = 0; i < num_events; ++i) {
+            handles[i] = CoreTiming::ScheduleEvent(time_distribution(rng), event_type, i);
+        }
+        std::shuffle(handles.begin(), handles.end(), rng);
+
+        const double unschedule_ns = TimeRun([&] {
+            for (const CoreTiming::EventHandle& handle : handles) {
+                CoreTiming::UnscheduleEvent(handle);
+            }
+        });
+
+        CoreTiming::AddTicks(CoreTiming::GetDowncount());
+        CoreTiming::Advance();
+        REQUIRE(MAX_SLICE_LENGTH == CoreTiming::GetDowncount());
+        Report("core_timing.wheel.unschedule.events=" + std::to_string(num_events), num_events,
+               unschedule_ns / num_events);
+    }
+}
+
+TEST_CASE("CoreTiming threadsafe events", "[core][benchmark][!hide]") {
+    using namespace BenchmarkTest;
+    constexpr u64 events_per_producer = 200000;
+
+    for (const size_t num_producers : {1, 2, 4}) {
+        ScopeInit guard;
+        CoreTiming::EventType* event_type = CoreTiming::RegisterEvent("event", CountingCallback);
+        fired = 0;
+
+        // Enter slice 0
+        CoreTiming::Advance();
+
+        // Producers post events due within a few slices, while the emu thread keeps advancing
+        size_t advances = 0;
+        const double total_ns = TimeRun([&] {
+            std::vector<std::thread> producers;
+            for (size_t i = 0; i < num_producers; ++i) {
+                producers.emplace_back([event_type, i] {
+                    for (u64 j = 0; j < events_per_producer; ++j) {
+                        CoreTiming::ScheduleEventThreadsafe(static_cast<s64>(j % 4) * 20000,
+                                                            event_type, i);
+                    }
+                });
+            }
+            advances = RunUntilFired(fired, events_per_producer * num_producers);
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+        });
+
+        const CoreTiming::ThreadsafeEventStats stats = CoreTiming::GetThreadsafeEventStats();
+        REQUIRE(stats.num_events == events_per_producer * num_producers);
+        const std::string suffix = ".producers=" + std::to_string(num_producers);
+        Report("core_timing.threadsafe.event" + suffix, fired, total_ns / fired);
+        Report("core_timing.threadsafe.advance" + suffix, advances, total_ns / advances);
+    }
+}
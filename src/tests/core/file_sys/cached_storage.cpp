@@ -0,0 +1,150 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+#include "core/file_sys/cached_storage.h"
+#include "core/settings.h"
+#include "tests/core/file_sys/memory_storage.h"
+#include "tests/test_utils.h"
+
+namespace FileSys {
+
+namespace {
+
+using Tests::MakePattern;
+
+/// Storage in host memory that counts the reads it receives.
+class CountingStorage final : public StorageBackend {
+public:
+    CountingStorage(std::vector<u8>& data, int& num_reads) : data(data), num_reads(num_reads) {}
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override {
+        ++num_reads;
+        if (offset >= data.size()) {
+            return MakeResult<size_t>(0);
+        }
+        const size_t read_length = std::min<size_t>(length, data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, read_length);
+        return MakeResult<size_t>(read_length);
+    }
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush,
+                            const u8* buffer) const override {
+        std::memcpy(data.data() + offset, buffer, length);
+        return MakeResult<size_t>(length);
+    }
+    void Flush() const override {}
+    bool SetSize(u64 size) const override {
+        data.resize(size);
+        return true;
+    }
+    u64 GetSize() const override {
+        return data.size();
+    }
+    bool Close() const override {
+        return true;
+    }
+
+private:
+    std::vector<u8>& data;
+    int& num_reads;
+};
+
+} // Anonymous namespace
+
+TEST_CASE("CachedStorage[Read]", "[core][file_sys]") {
+    Settings::values.storage_cache_size = 4;
+    std::vector<u8> data = MakePattern(0x34567);
+    int num_reads = 0;
+    CachedStorage storage(std::make_unique<CountingStorage>(data, num_reads), "read");
+
+    // A read spanning a block boundary, then the same read again from the cache.
+    std::vector<u8> buffer(0x2000);
+    for (int pass = 0; pass < 2; ++pass) {
+        const auto result = storage.Read(0xF000, buffer.size(), buffer.data());
+        REQUIRE(result.Succeeded());
+        REQUIRE(*result == buffer.size());
+        REQUIRE(std::equal(buffer.begin(), buffer.end(), data.begin() + 0xF000));
+    }
+    REQUIRE(num_reads == 2);
+
+    // Reads are clamped to the end of the storage.
+    const auto tail = storage.Read(data.size() - 0x10, buffer.size(), buffer.data());
+    REQUIRE(tail.Succeeded());
+    REQUIRE(*tail == 0x10);
+    REQUIRE(std::equal(buffer.begin(), buffer.begin() + 0x10, data.end() - 0x10));
+    REQUIRE(*storage.Read(data.size(), buffer.size(), buffer.data()) == 0);
+}
+
+TEST_CASE("CachedStorage[ReadAhead]", "[core][file_sys]") {
+    Settings::values.storage_cache_size = 4;
+    std::vector<u8> data = MakePattern(0x200000);
+    int num_reads = 0;
+    CachedStorage storage(std::make_unique<CountingStorage>(data, num_reads), "readahead");
+
+    const size_t chunk = 0x1000;
+    std::vector<u8> buffer(chunk);
+    for (size_t offset = 0; offset < 0x100000; offset += chunk) {
+        REQUIRE(*storage.Read(offset, chunk, buffer.data()) == chunk);
+        REQUIRE(std::equal(buffer.begin(), buffer.end(), data.begin() + offset));
+    }
+
+    // 16 blocks were read with far fewer requests to the wrapped storage.
+    REQUIRE(num_reads < 8);
+}
+
+TEST_CASE("CachedStorage[Write]", "[core][file_sys]") {
+    Settings::values.storage_cache_size = 4;
+    std::vector<u8> data = MakePattern(0x20000);
+    int num_reads = 0;
+    CachedStorage storage(std::make_unique<CountingStorage>(data, num_reads), "write");
+
+    std::vector<u8> buffer(0x100);
+    REQUIRE(*storage.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+
+    const std::vector<u8> written(0x100, 0xAB);
+    REQUIRE(*storage.Write(0x10080, written.size(), false, written.data()) == written.size());
+
+    REQUIRE(*storage.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+    REQUIRE(std::equal(buffer.begin(), buffer.end(), data.begin() + 0x10000));
+    REQUIRE(buffer[0x80] == 0xAB);
+}
+
+TEST_CASE("CachedStorage[SharedIdentity]", "[core][file_sys]") {
+    Settings::values.storage_cache_size = 4;
+    std::vector<u8> data = MakePattern(0x20000);
+    int num_reads = 0;
+    std::vector<u8> buffer(0x100);
+    {
+        CachedStorage first(std::make_unique<CountingStorage>(data, num_reads), "shared");
+        CachedStorage second(std::make_unique<CountingStorage>(data, num_reads), "shared");
+
+        // The blocks read through one instance are found by the other.
+        REQUIRE(*first.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+        REQUIRE(*second.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+        REQUIRE(num_reads == 1);
+
+        // A write through one instance isn't hidden from the other by its cached blocks.
+        const std::vector<u8> written(0x10, 0xCD);
+        REQUIRE(*second.Write(0x10000, written.size(), false, written.data()) == written.size());
+        REQUIRE(*first.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+        REQUIRE(buffer[0] == 0xCD);
+        REQUIRE(num_reads == 2);
+    }
+
+    // The blocks are still there when the storage is opened again.
+    CachedStorage reopened(std::make_unique<CountingStorage>(data, num_reads), "shared");
+    REQUIRE(*reopened.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+    REQUIRE(std::equal(buffer.begin(), buffer.end(), data.begin() + 0x10000));
+    REQUIRE(num_reads == 2);
+
+    // Until they are dropped for the identity.
+    InvalidateCachedStorage("shared");
+    REQUIRE(*reopened.Read(0x10000, buffer.size(), buffer.data()) == buffer.size());
+    REQUIRE(num_reads == 3);
+}
+
+} // namespace FileSys
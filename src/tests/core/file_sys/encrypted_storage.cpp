@@ -0,0 +1,83 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+#include "core/file_sys/encrypted_storage.h"
+#include "tests/core/file_sys/memory_storage.h"
+#include "tests/test_utils.h"
+
+namespace FileSys {
+
+namespace {
+
+using Tests::MakePattern;
+
+constexpr HW::AES::Key128 DATA_KEY{{0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+                                    0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f}};
+constexpr HW::AES::Key128 TWEAK_KEY{{0xf0, 0xe0, 0xd0, 0xc0, 0xb0, 0xa0, 0x90, 0x80, 0x70, 0x60,
+                                     0x50, 0x40, 0x30, 0x20, 0x10, 0x00}};
+
+/// Reads the storage in pieces of piece_length bytes.
+std::vector<u8> ReadInPieces(const StorageBackend& storage, size_t piece_length) {
+    std::vector<u8> result(static_cast<size_t>(storage.GetSize()));
+    for (size_t offset = 0; offset < result.size(); offset += piece_length) {
+        const ResultVal<size_t> read = storage.Read(offset, piece_length, result.data() + offset);
+        REQUIRE(read.Succeeded());
+        REQUIRE(*read == std::min(piece_length, result.size() - offset));
+    }
+    return result;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("AESCTRStorage", "[core][file_sys]") {
+    const HW::AES::Block iv{{0xf0, 0xf1, 0xf2, 0xf3, 0xf4, 0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+                             0xfb, 0xfc, 0xfd, 0xfe, 0xff}};
+    constexpr u64 stream_offset = 0x4000;
+    const std::vector<u8> plaintext = MakePattern(0x3000 + 7);
+
+    std::vector<u8> ciphertext(plaintext.size());
+    HW::AES::TransformCTR(HW::AES::AESEngine(DATA_KEY), iv, stream_offset, ciphertext.data(),
+                          plaintext.data(), plaintext.size());
+    const AESCTRStorage storage(std::make_unique<MemoryStorage>(ciphertext), DATA_KEY, iv,
+                                stream_offset);
+
+    REQUIRE(storage.GetSize() == plaintext.size());
+    REQUIRE(ReadInPieces(storage, 0x100000) == plaintext);
+    REQUIRE(ReadInPieces(storage, 13) == plaintext);
+}
+
+TEST_CASE("AESXTSStorage", "[core][file_sys]") {
+    constexpr size_t sector_size = 0x200;
+    constexpr u64 first_sector = 4;
+    const std::vector<u8> plaintext = MakePattern(sector_size * 9 + 0x40);
+
+    std::vector<u8> ciphertext(plaintext.size());
+    HW::AES::EncryptXTS(HW::AES::AESEngine(DATA_KEY), HW::AES::AESEngine(TWEAK_KEY), first_sector,
+                        sector_size, HW::AES::TweakByteOrder::Big, ciphertext.data(),
+                        plaintext.data(), plaintext.size());
+    const AESXTSStorage storage(std::make_unique<MemoryStorage>(ciphertext), DATA_KEY, TWEAK_KEY,
+                                sector_size, HW::AES::TweakByteOrder::Big, first_sector);
+
+    REQUIRE(storage.GetSize() == plaintext.size());
+    SECTION("whole sectors") {
+        REQUIRE(ReadInPieces(storage, sector_size * 4) == plaintext);
+    }
+    SECTION("parts of sectors") {
+        REQUIRE(ReadInPieces(storage, 0x90) == plaintext);
+    }
+    SECTION("a read past the end") {
+        std::vector<u8> tail(0x1000);
+        const ResultVal<size_t> read = storage.Read(sector_size * 8 + 3, tail.size(), tail.data());
+        REQUIRE(read.Succeeded());
+        REQUIRE(*read == sector_size + 0x40 - 3);
+        REQUIRE(std::equal(tail.begin(), tail.begin() + *read,
+                           plaintext.begin() + sector_size * 8 + 3));
+    }
+}
+
+} // namespace FileSys
@@ -0,0 +1,47 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "common/common_types.h"
+#include "core/file_sys/storage.h"
+
+namespace FileSys {
+
+/// Read-only storage in host memory.
+class MemoryStorage final : public StorageBackend {
+public:
+    explicit MemoryStorage(std::vector<u8> data) : data(std::move(data)) {}
+
+    ResultVal<size_t> Read(u64 offset, size_t length, u8* buffer) const override {
+        if (offset >= data.size()) {
+            return MakeResult<size_t>(0);
+        }
+        const size_t read_length = std::min<size_t>(length, data.size() - offset);
+        std::memcpy(buffer, data.data() + offset, read_length);
+        return MakeResult<size_t>(read_length);
+    }
+    ResultVal<size_t> Write(u64 offset, size_t length, bool flush,
+                            const u8* buffer) const override {
+        return MakeResult<size_t>(0);
+    }
+    void Flush() const override {}
+    bool SetSize(u64 size) const override {
+        return false;
+    }
+    u64 GetSize() const override {
+        return data.size();
+    }
+    bool Close() const override {
+        return true;
+    }
+
+private:
+    std::vector<u8> data;
+};
+
+} // namespace FileSys
@@ -0,0 +1,90 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/partition_filesystem.h"
+#include "core/file_sys/storage.h"
+#include "core/loader/loader.h"
+
+namespace FileSys {
+
+namespace {
+
+void Append32(std::vector<u8>& data, u32 value) {
+    for (int i = 0; i < 4; ++i) {
+        data.push_back(static_cast<u8>(value >> (i * 8)));
+    }
+}
+
+void AppendEntry(std::vector<u8>& data, u64 offset, u64 size, u32 strtab_offset) {
+    Append32(data, static_cast<u32>(offset));
+    Append32(data, static_cast<u32>(offset >> 32));
+    Append32(data, static_cast<u32>(size));
+    Append32(data, static_cast<u32>(size >> 32));
+    Append32(data, strtab_offset);
+    Append32(data, 0);
+}
+
+/// Builds a PFS0 holding "main" with the contents "code" and "npdm" with the contents "meta".
+std::vector<u8> BuildPFS0(u32 strtab_size = 0x10) {
+    std::vector<u8> data{'P', 'F', 'S', '0'};
+    Append32(data, 2);
+    Append32(data, strtab_size);
+    Append32(data, 0);
+    AppendEntry(data, 0, 4, 0);
+    AppendEntry(data, 4, 4, 5);
+    const std::string strtab("main\0npdm\0\0\0\0\0\0", 0x10);
+    data.insert(data.end(), strtab.begin(), strtab.end());
+    for (char c : std::string("codemeta")) {
+        data.push_back(static_cast<u8>(c));
+    }
+    return data;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("PartitionFilesystem[Memory]", "[core][file_sys]") {
+    const std::vector<u8> data = BuildPFS0();
+    PartitionFilesystem pfs;
+    REQUIRE(pfs.Load(data) == Loader::ResultStatus::Success);
+    REQUIRE(pfs.GetNumEntries() == 2);
+    REQUIRE(pfs.GetEntryName(1) == "npdm");
+    REQUIRE(pfs.GetFileOffset("npdm") == 0x10 + 2 * 0x18 + 0x10 + 4);
+    REQUIRE(pfs.GetFileSize("main") == 4);
+    REQUIRE(pfs.GetEntryName(2).empty());
+
+    // Loaded from memory, so there is no file to open the entries on.
+    REQUIRE(pfs.OpenEntry(0) == nullptr);
+
+    // A string table that runs past the end of the data.
+    REQUIRE(PartitionFilesystem().Load(BuildPFS0(0x1000)) == Loader::ResultStatus::Error);
+}
+
+TEST_CASE("PartitionFilesystem[File]", "[core][file_sys]") {
+    const std::string path = FileUtil::GetCurrentDir() + "/yuzu_pfs_test.bin";
+    const std::vector<u8> pfs_data = BuildPFS0();
+    std::string contents(0x20, 'x');
+    contents.append(pfs_data.begin(), pfs_data.end());
+    FileUtil::WriteStringToFile(false, contents, path.c_str());
+
+    {
+        PartitionFilesystem pfs;
+        REQUIRE(pfs.Load(path, 0x20) == Loader::ResultStatus::Success);
+        REQUIRE(pfs.GetEntryName(0) == "main");
+
+        const auto storage = pfs.OpenEntry(1);
+        REQUIRE(storage != nullptr);
+        REQUIRE(storage->GetSize() == 4);
+        std::string read(4, '\0');
+        REQUIRE(*storage->Read(0, read.size(), reinterpret_cast<u8*>(&read[0])) == 4);
+        REQUIRE(read == "meta");
+    }
+
+    FileUtil::Delete(path);
+}
+
+} // namespace FileSys
@@ -0,0 +1,153 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "core/file_sys/romfs_index.h"
+#include "core/file_sys/storage.h"
+#include "tests/core/file_sys/memory_storage.h"
+
+namespace FileSys {
+
+namespace {
+
+constexpr u32 EMPTY = 0xFFFFFFFF;
+
+void Append32(std::vector<u8>& table, u32 value) {
+    for (int i = 0; i < 4; ++i) {
+        table.push_back(static_cast<u8>(value >> (i * 8)));
+    }
+}
+
+void Append64(std::vector<u8>& table, u64 value) {
+    Append32(table, static_cast<u32>(value));
+    Append32(table, static_cast<u32>(value >> 32));
+}
+
+void AppendName(std::vector<u8>& table, const std::string& name) {
+    table.insert(table.end(), name.begin(), name.end());
+    table.resize((table.size() + 3) & ~size_t(3));
+}
+
+void AppendDirectory(std::vector<u8>& table, u32 sibling, u32 child_directory, u32 child_file,
+                     const std::string& name) {
+    for (u32 value : {u32(0), sibling, child_directory, child_file, EMPTY}) {
+        Append32(table, value);
+    }
+    Append32(table, static_cast<u32>(name.size()));
+    AppendName(table, name);
+}
+
+void AppendFile(std::vector<u8>& table, u32 sibling, u64 offset, u64 size,
+                const std::string& name) {
+    Append32(table, 0);
+    Append32(table, sibling);
+    Append64(table, offset);
+    Append64(table, size);
+    Append32(table, EMPTY);
+    Append32(table, static_cast<u32>(name.size()));
+    AppendName(table, name);
+}
+
+/// Builds an image from the given metadata tables, with the hash tables left empty, followed by
+/// data_size bytes of file data.
+std::vector<u8> BuildImage(const std::vector<u8>& directories, const std::vector<u8>& files,
+                           size_t data_size = 0) {
+    constexpr u64 header_size = 0x50;
+    const u64 directory_table_offset = header_size;
+    const u64 file_table_offset = directory_table_offset + directories.size();
+    const u64 data_offset = file_table_offset + files.size();
+
+    std::vector<u8> image;
+    for (u64 value : {header_size, header_size, u64(0), directory_table_offset,
+                      u64(directories.size()), header_size, u64(0), file_table_offset,
+                      u64(files.size()), data_offset}) {
+        Append64(image, value);
+    }
+    image.insert(image.end(), directories.begin(), directories.end());
+    image.insert(image.end(), files.begin(), files.end());
+    image.resize(image.size() + data_size);
+    return image;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("RomFSIndex::NormalizePath", "[core][file_sys]") {
+    REQUIRE(RomFSIndex::NormalizePath("") == "/");
+    REQUIRE(RomFSIndex::NormalizePath("/") == "/");
+    REQUIRE(RomFSIndex::NormalizePath("a") == "/a");
+    REQUIRE(RomFSIndex::NormalizePath("//a/./b/") == "/a/b");
+    REQUIRE(RomFSIndex::NormalizePath("\\a\\b") == "/a/b");
+}
+
+TEST_CASE("RomFSIndex[Lookup]", "[core][file_sys]") {
+    // "/" contains "sub/" and "a.bin", "/sub" contains "b.txt"
+    std::vector<u8> directories;
+    AppendDirectory(directories, EMPTY, 0x18, 0x00, "");
+    AppendDirectory(directories, EMPTY, EMPTY, 0x28, "sub");
+    std::vector<u8> files;
+    AppendFile(files, EMPTY, 0x10, 0x20, "a.bin");
+    AppendFile(files, EMPTY, 0x40, 0x8, "b.txt");
+    REQUIRE(files.size() == 0x28 + 0x28);
+
+    const std::vector<u8> image = BuildImage(directories, files, 0x48);
+    const u64 data_offset = 0x50 + directories.size() + files.size();
+    const RomFSIndex index(MemoryStorage{image});
+    REQUIRE(index.IsValid());
+
+    const RomFSIndex::Node* root = index.Find("/");
+    REQUIRE(root != nullptr);
+    REQUIRE(root->type == EntryType::Directory);
+    REQUIRE(root->num_children == 2);
+    const auto& children = index.GetChildren();
+    REQUIRE(children[root->first_child].name == "sub");
+    REQUIRE(children[root->first_child].type == EntryType::Directory);
+    REQUIRE(children[root->first_child + 1].name == "a.bin");
+    REQUIRE(children[root->first_child + 1].size == 0x20);
+
+    const RomFSIndex::Node* file = index.Find("sub//b.txt");
+    REQUIRE(file != nullptr);
+    REQUIRE(file->type == EntryType::File);
+    REQUIRE(file->offset == data_offset + 0x40);
+    REQUIRE(file->size == 0x8);
+
+    const RomFSIndex::Node* sub = index.Find("/sub/");
+    REQUIRE(sub != nullptr);
+    REQUIRE(sub->num_children == 1);
+    REQUIRE(children[sub->first_child].name == "b.txt");
+
+    REQUIRE(index.Find("/b.txt") == nullptr);
+    REQUIRE(index.Find("/sub/a.bin") == nullptr);
+}
+
+TEST_CASE("RomFSIndex[Malformed]", "[core][file_sys]") {
+    // A directory that is its own sibling must not hang the parser.
+    std::vector<u8> directories;
+    AppendDirectory(directories, EMPTY, 0x18, EMPTY, "");
+    AppendDirectory(directories, 0x18, EMPTY, EMPTY, "loop");
+    REQUIRE(!RomFSIndex(MemoryStorage{BuildImage(directories, {})}).IsValid());
+
+    // A file table that points past its end.
+    directories.clear();
+    AppendDirectory(directories, EMPTY, EMPTY, 0x100, "");
+    REQUIRE(!RomFSIndex(MemoryStorage{BuildImage(directories, {})}).IsValid());
+
+    // Files whose data goes past the end of the image, also once the range overflows.
+    directories.clear();
+    AppendDirectory(directories, EMPTY, EMPTY, 0x00, "");
+    std::vector<u8> files;
+    AppendFile(files, EMPTY, 0x10, 0x20, "a.bin");
+    REQUIRE(RomFSIndex(MemoryStorage{BuildImage(directories, files, 0x30)}).IsValid());
+    REQUIRE(!RomFSIndex(MemoryStorage{BuildImage(directories, files, 0x2F)}).IsValid());
+    files.clear();
+    AppendFile(files, EMPTY, 0x10, ~u64(0) - 0x8, "a.bin");
+    REQUIRE(!RomFSIndex(MemoryStorage{BuildImage(directories, files, 0x30)}).IsValid());
+
+    REQUIRE(!RomFSIndex(MemoryStorage{{}}).IsValid());
+}
+
+} // namespace FileSys
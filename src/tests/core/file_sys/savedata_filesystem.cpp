@@ -0,0 +1,102 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/file_sys/savedata_filesystem.h"
+
+namespace FileSys {
+
+namespace {
+
+std::string ReadHostFile(const std::string& path) {
+    std::string contents;
+    FileUtil::ReadFileToString(false, path.c_str(), contents);
+    return contents;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("SaveData_FileSystem[Commit]", "[core][file_sys]") {
+    const std::string directory = FileUtil::GetCurrentDir() + "/yuzu_savedata_test/";
+    FileUtil::DeleteDirRecursively(directory);
+    REQUIRE(FileUtil::CreateFullPath(directory));
+    FileUtil::WriteStringToFile(false, "original", (directory + "save.bin").c_str());
+
+    {
+        SaveData_FileSystem save(directory);
+        auto file = save.OpenFile("save.bin", static_cast<Mode>(3));
+        REQUIRE(file.Succeeded());
+
+        const std::string update = "updated!!";
+        REQUIRE(*(*file)->Write(0, update.size(), true,
+                                reinterpret_cast<const u8*>(update.data())) == update.size());
+        REQUIRE((*file)->GetSize() == update.size());
+
+        // Nothing reaches the host before the commit, even when the guest asks for a flush.
+        REQUIRE(ReadHostFile(directory + "save.bin") == "original");
+
+        REQUIRE(save.Commit().IsSuccess());
+        REQUIRE(ReadHostFile(directory + "save.bin") == update);
+        REQUIRE(!FileUtil::Exists(directory + "save.bin.tmp"));
+
+        // Changes made after the last commit are written back when the archive is closed.
+        REQUIRE(*(*file)->Write(0, 1, false, reinterpret_cast<const u8*>("U")) == 1);
+    }
+    REQUIRE(ReadHostFile(directory + "save.bin") == "Updated!!");
+
+    FileUtil::DeleteDirRecursively(directory);
+}
+
+TEST_CASE("SaveData_FileSystem[Write]", "[core][file_sys]") {
+    const std::string directory = FileUtil::GetCurrentDir() + "/yuzu_savedata_test/";
+    FileUtil::DeleteDirRecursively(directory);
+    REQUIRE(FileUtil::CreateFullPath(directory));
+    FileUtil::WriteStringToFile(false, "original", (directory + "save.bin").c_str());
+
+    {
+        SaveData_FileSystem save(directory);
+        auto file = save.OpenFile("save.bin", static_cast<Mode>(3));
+        REQUIRE(file.Succeeded());
+
+        // Files held in memory only grow up to the limit, whatever the offset.
+        constexpr u64 limit = SaveData_FileSystem::MAX_BUFFERED_FILE_SIZE;
+        const u8 byte = 'X';
+        REQUIRE((*file)->Write(limit, 1, false, &byte).Failed());
+        REQUIRE((*file)->Write(~u64(0), 1, false, &byte).Failed());
+        REQUIRE(!(*file)->SetSize(limit + 1));
+        REQUIRE((*file)->GetSize() == 8);
+        REQUIRE(*(*file)->Write(8, 1, false, &byte) == 1);
+        REQUIRE((*file)->GetSize() == 9);
+    }
+    REQUIRE(ReadHostFile(directory + "save.bin") == "originalX");
+
+    FileUtil::DeleteDirRecursively(directory);
+}
+
+TEST_CASE("SaveData_FileSystem[DeleteFile]", "[core][file_sys]") {
+    const std::string directory = FileUtil::GetCurrentDir() + "/yuzu_savedata_test/";
+    FileUtil::DeleteDirRecursively(directory);
+    REQUIRE(FileUtil::CreateFullPath(directory));
+    FileUtil::WriteStringToFile(false, "original", (directory + "save.bin").c_str());
+
+    SaveData_FileSystem save(directory);
+    REQUIRE(save.OpenFile("missing.bin", Mode::Read).Failed());
+
+    auto file = save.OpenFile("save.bin", static_cast<Mode>(3));
+    REQUIRE(file.Succeeded());
+    REQUIRE(*(*file)->Write(0, 1, false, reinterpret_cast<const u8*>("O")) == 1);
+
+    // A deleted file is not brought back by the commit.
+    REQUIRE(save.DeleteFile("save.bin").IsSuccess());
+    REQUIRE(save.Commit().IsSuccess());
+    REQUIRE(!FileUtil::Exists(directory + "save.bin"));
+    REQUIRE(save.GetEntryType("save.bin").Failed());
+
+    FileUtil::DeleteDirRecursively(directory);
+}
+
+} // namespace FileSys
@@ -0,0 +1,404 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "core/arm/arm_interface.h"
+#include "core/core.h"
+#include "core/core_timing.h"
+#include "core/hle/ipc.h"
+#include "core/hle/ipc_helpers.h"
+#include "core/hle/kernel/client_port.h"
+#include "core/hle/kernel/client_session.h"
+#include "core/hle/kernel/event.h"
+#include "core/hle/kernel/handle_table.h"
+#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/object_address_table.h"
+#include "core/hle/kernel/process.h"
+#include "core/hle/kernel/svc.h"
+#include "core/hle/kernel/thread.h"
+#include "core/hle/service/service.h"
+#include "core/memory.h"
+#include "tests/core/arm/arm_test_common.h"
+#include "tests/test_utils.h"
+
+namespace Kernel {
+
+namespace {
+
+using Tests::Report;
+using Tests::TimeCalls;
+
+constexpr u32 SYSTEM_MODE = 2;
+
+/// Page holding the entry point of the threads and the guest data the SVCs work on.
+constexpr VAddr DATA_VADDR = 0x10000000;
+constexpr VAddr HANDLES_VADDR = DATA_VADDR;
+constexpr VAddr MUTEX_VADDR = DATA_VADDR + 0x800;
+constexpr VAddr CONDITION_VARIABLE_VADDR = DATA_VADDR + 0x804;
+
+constexpr u32 SVC_SLEEP_THREAD = 0x0B;
+constexpr u32 SVC_WAIT_SYNCHRONIZATION = 0x18;
+constexpr u32 SVC_ARBITRATE_LOCK = 0x1A;
+constexpr u32 SVC_ARBITRATE_UNLOCK = 0x1B;
+constexpr u32 SVC_WAIT_PROCESS_WIDE_KEY_ATOMIC = 0x1C;
+constexpr u32 SVC_SIGNAL_PROCESS_WIDE_KEY = 0x1D;
+constexpr u32 SVC_SEND_SYNC_REQUEST = 0x21;
+
+/**
+ * CPU that doesn't execute any code. It only keeps the registers, so that the SVCs can take their
+ * arguments from them and the scheduler can switch the contexts of the threads on it.
+ */
+class StubCPU final : public ARM_Interface {
+public:
+    void Run() override {}
+    void Step() override {}
+    void MapBackingMemory(VAddr address, size_t size, u8* memory,
+                          Kernel::VMAPermission perms) override {}
+    void UnmapMemory(VAddr address, size_t size) override {}
+    void ClearInstructionCache() override {}
+    void InvalidateCacheRange(const Memory::PageTable* page_table, VAddr start,
+                              size_t length) override {}
+    void PageTableChanged() override {}
+
+    void SetPC(u64 addr) override {
+        context.pc = addr;
+    }
+    u64 GetPC() const override {
+        return context.pc;
+    }
+    u64 GetReg(int index) const override {
+        return context.cpu_registers[index];
+    }
+    void SetReg(int index, u64 value) override {
+        context.cpu_registers[index] = value;
+    }
+    u128 GetExtReg(int index) const override {
+        return context.fpu_registers[index];
+    }
+    void SetExtReg(int index, u128 value) override {
+        context.fpu_registers[index] = value;
+    }
+    u32 GetVFPReg(int index) const override {
+        return static_cast<u32>(context.fpu_registers[index][0]);
+    }
+    void SetVFPReg(int index, u32 value) override {
+        context.fpu_registers[index][0] = value;
+    }
+    u32 GetCPSR() const override {
+        return static_cast<u32>(context.cpsr);
+    }
+    void SetCPSR(u32 cpsr) override {
+        context.cpsr = cpsr;
+    }
+    VAddr GetTlsAddress() const override {
+        return context.tls_address;
+    }
+    void SetTlsAddress(VAddr address) override {
+        context.tls_address = address;
+    }
+
+    void SaveGeneralContext(ThreadContext& ctx) override {
+        ctx.cpu_registers = context.cpu_registers;
+        ctx.sp = context.sp;
+        ctx.pc = context.pc;
+        ctx.cpsr = context.cpsr;
+        ctx.tls_address = context.tls_address;
+    }
+    void LoadGeneralContext(const ThreadContext& ctx) override {
+        context.cpu_registers = ctx.cpu_registers;
+        context.sp = ctx.sp;
+        context.pc = ctx.pc;
+        context.cpsr = ctx.cpsr;
+        context.tls_address = ctx.tls_address;
+    }
+    void SaveVectorContext(ThreadContext& ctx) override {
+        ctx.fpu_registers = context.fpu_registers;
+        ctx.fpscr = context.fpscr;
+    }
+    void LoadVectorContext(const ThreadContext& ctx) override {
+        context.fpu_registers = ctx.fpu_registers;
+        context.fpscr = ctx.fpscr;
+    }
+
+    void PrepareReschedule() override {}
+
+private:
+    ThreadContext context{};
+};
+
+/**
+ * Kernel running on a StubCPU, in the process of a TestEnvironment. The benchmarks stand in for
+ * the guest code of the threads, and issue SVCs the way the CPU would.
+ */
+class KernelEnvironment final {
+public:
+    KernelEnvironment() : cpu(std::make_shared<StubCPU>()) {
+        Core::System::GetInstance().InitKernel(cpu, SYSTEM_MODE);
+
+        // The memory of the TestEnvironment isn't accepted as valid memory by the SVCs
+        auto& vm_manager = Core::CurrentProcess()->vm_manager;
+        auto block = std::make_shared<std::vector<u8>>(Memory::PAGE_SIZE);
+        REQUIRE(vm_manager
+                    .MapMemoryBlock(DATA_VADDR, std::move(block), 0, Memory::PAGE_SIZE,
+                                    MemoryState::Heap)
+                    .Succeeded());
+    }
+
+    ~KernelEnvironment() {
+        Core::System::GetInstance().ShutdownKernel();
+    }
+
+    /**
+     * Creates a thread that is ready to run, and switches to it if no other thread is running.
+     * @param priority Priority of the thread
+     * @return The thread, whose guest_handle is a handle to it
+     */
+    SharedPtr<Thread> CreateThread(u32 priority = THREADPRIO_DEFAULT) {
+        SharedPtr<Thread> thread =
+            Thread::Create("benchmark", DATA_VADDR, priority, 0, THREADPROCESSORID_0,
+                           DATA_VADDR + Memory::PAGE_SIZE, Core::CurrentProcess())
+                .Unwrap();
+        thread->guest_handle = g_handle_table.Create(thread).Unwrap();
+        thread->ResumeFromWait();
+        Reschedule();
+        return thread;
+    }
+
+    /**
+     * Issues an SVC from the current thread, and then reschedules like the CPU loop does after
+     * the SVC asked for it.
+     * @param immediate Number of the SVC
+     * @param args Values of the argument registers, starting with X0
+     * @return Value the SVC returned in X0
+     */
+    u64 CallSVC(u32 immediate, std::initializer_list<u64> args) {
+        int index = 0;
+        for (u64 arg : args) {
+            cpu->SetReg(index++, arg);
+        }
+        Kernel::CallSVC(immediate);
+        const u64 result = cpu->GetReg(0);
+        Reschedule();
+        return result;
+    }
+
+    /// Advances the emulated time like the CPU loop does while no thread is ready to run.
+    void IdleUntilThreadIsReady() {
+        while (GetCurrentThread() == nullptr) {
+            CoreTiming::Idle();
+            CoreTiming::Advance();
+            Reschedule();
+        }
+    }
+
+private:
+    void Reschedule() {
+        Core::System::GetInstance().Scheduler().Reschedule();
+    }
+
+    /// Declared first, so that the process outlives the kernel
+    ArmTests::TestEnvironment test_environment;
+    std::shared_ptr<StubCPU> cpu;
+};
+
+/// Service that replies to command 0 without doing anything.
+class BenchmarkService final : public Service::ServiceFramework<BenchmarkService> {
+public:
+    BenchmarkService() : ServiceFramework("benchmark") {
+        static const FunctionInfo functions[] = {
+            {0, &BenchmarkService::Ping, "Ping"},
+        };
+        RegisterHandlers(functions);
+    }
+
+private:
+    void Ping(HLERequestContext& ctx) {
+        IPC::ResponseBuilder rb{ctx, 2};
+        rb.Push(RESULT_SUCCESS);
+    }
+};
+
+} // Anonymous namespace
+
+TEST_CASE("Kernel::HandleTable create, get and close", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t handle_count = 1024;
+    constexpr size_t rounds = 1000;
+
+    HandleTable table;
+    const SharedPtr<Event> event = Event::Create(ResetType::OneShot, "benchmark");
+    std::vector<Handle> handles(handle_count);
+    double create_ns = 0;
+    double get_ns = 0;
+    double close_ns = 0;
+    size_t found = 0;
+
+    for (size_t round = 0; round < rounds; ++round) {
+        create_ns += TimeCalls(handle_count,
+                               [&](size_t i) { handles[i] = table.Create(event).Unwrap(); });
+        get_ns += TimeCalls(handle_count,
+                            [&](size_t i) { found += table.Get<Event>(handles[i]) != nullptr; });
+        close_ns += TimeCalls(handle_count, [&](size_t i) { table.Close(handles[i]); });
+    }
+
+    REQUIRE(found == handle_count * rounds);
+    REQUIRE(table.GetGeneric(handles[0]) == nullptr);
+    Report("handle_table.create", handle_count * rounds, create_ns / rounds);
+    Report("handle_table.get", handle_count * rounds, get_ns / rounds);
+    Report("handle_table.close", handle_count * rounds, close_ns / rounds);
+}
+
+TEST_CASE("Kernel::WaitSynchronization", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t iterations = 100000;
+
+    KernelEnvironment environment;
+    environment.CreateThread();
+
+    for (size_t handle_count : {1, 8, 64}) {
+        std::vector<SharedPtr<Event>> events;
+        std::vector<Handle> handles;
+        for (size_t i = 0; i < handle_count; ++i) {
+            events.push_back(Event::Create(ResetType::Sticky, "benchmark"));
+            handles.push_back(g_handle_table.Create(events.back()).Unwrap());
+        }
+        Memory::WriteBlock(HANDLES_VADDR, handles.data(), handles.size() * sizeof(Handle));
+
+        const auto wait = [&] {
+            return environment.CallSVC(SVC_WAIT_SYNCHRONIZATION,
+                                       {0, HANDLES_VADDR, handle_count, 0});
+        };
+        const std::string suffix = ".handles=" + std::to_string(handle_count);
+
+        // Without a signalled event, the wait times out right away
+        REQUIRE(wait() == RESULT_TIMEOUT.raw);
+        const double timeout_ns = TimeCalls(iterations, [&](size_t) { wait(); });
+        Report("wait_synchronization.timeout" + suffix, iterations, timeout_ns);
+
+        // Only the last event is signalled, so that all the handles are looked at
+        events.back()->Signal();
+        REQUIRE(wait() == RESULT_SUCCESS.raw);
+        const double signaled_ns = TimeCalls(iterations, [&](size_t) { wait(); });
+        Report("wait_synchronization.signaled" + suffix, iterations, signaled_ns);
+    }
+}
+
+TEST_CASE("Kernel::Scheduler context switch", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t iterations = 1000000;
+
+    KernelEnvironment environment;
+    const SharedPtr<Thread> first = environment.CreateThread();
+    const SharedPtr<Thread> second = environment.CreateThread();
+
+    // Threads of the same priority take turns when they yield
+    REQUIRE(GetCurrentThread() == first.get());
+    environment.CallSVC(SVC_SLEEP_THREAD, {0});
+    REQUIRE(GetCurrentThread() == second.get());
+
+    const double switch_ns = TimeCalls(
+        iterations, [&](size_t) { environment.CallSVC(SVC_SLEEP_THREAD, {0}); });
+    Report("scheduler.yield_switch", iterations, switch_ns);
+}
+
+TEST_CASE("Kernel::Mutex ping-pong", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t iterations = 100000;
+
+    KernelEnvironment environment;
+    const SharedPtr<Thread> first = environment.CreateThread();
+    const SharedPtr<Thread> second = environment.CreateThread();
+
+    // The first thread holds the mutex, and the second one waits for it
+    Memory::Write32(MUTEX_VADDR, first->guest_handle);
+    environment.CallSVC(SVC_SLEEP_THREAD, {0});
+    environment.CallSVC(SVC_ARBITRATE_LOCK,
+                        {first->guest_handle, MUTEX_VADDR, second->guest_handle});
+    const SharedPtr<Mutex> mutex = g_object_address_table.Get<Mutex>(MUTEX_VADDR);
+    REQUIRE(GetCurrentThread() == first.get());
+
+    // The running thread hands the mutex over to the waiting one, and then waits for it itself
+    const auto hand_over = [&](size_t) {
+        const Handle self = GetCurrentThread()->guest_handle;
+        environment.CallSVC(SVC_ARBITRATE_UNLOCK, {MUTEX_VADDR});
+        environment.CallSVC(SVC_ARBITRATE_LOCK, {mutex->GetOwnerHandle(), MUTEX_VADDR, self});
+    };
+
+    hand_over(0);
+    REQUIRE(GetCurrentThread() == second.get());
+    REQUIRE(mutex->GetOwnerHandle() == second->guest_handle);
+
+    const double hand_over_ns = TimeCalls(iterations, hand_over);
+    REQUIRE(mutex->GetOwnerHandle() == GetCurrentThread()->guest_handle);
+    Report("mutex.ping_pong", iterations, hand_over_ns);
+}
+
+TEST_CASE("Kernel::ConditionVariable ping-pong", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t iterations = 100000;
+
+    KernelEnvironment environment;
+    const SharedPtr<Thread> first = environment.CreateThread();
+    const SharedPtr<Thread> second = environment.CreateThread();
+
+    // The first thread waits on the condition variable, and the second one takes the mutex
+    environment.CallSVC(SVC_WAIT_PROCESS_WIDE_KEY_ATOMIC,
+                        {MUTEX_VADDR, CONDITION_VARIABLE_VADDR, first->guest_handle, ~0ULL});
+    REQUIRE(GetCurrentThread() == second.get());
+    environment.CallSVC(SVC_ARBITRATE_LOCK, {0, MUTEX_VADDR, second->guest_handle});
+    const SharedPtr<Mutex> mutex = g_object_address_table.Get<Mutex>(MUTEX_VADDR);
+
+    // The running thread holds the mutex. It signals the waiting thread and waits for a signal
+    // itself, which gives the mutex to the other thread.
+    const auto signal_and_wait = [&](size_t) {
+        const Handle self = GetCurrentThread()->guest_handle;
+        environment.CallSVC(SVC_SIGNAL_PROCESS_WIDE_KEY, {CONDITION_VARIABLE_VADDR, 1});
+        environment.CallSVC(SVC_WAIT_PROCESS_WIDE_KEY_ATOMIC,
+                            {MUTEX_VADDR, CONDITION_VARIABLE_VADDR, self, ~0ULL});
+    };
+
+    signal_and_wait(0);
+    REQUIRE(GetCurrentThread() == first.get());
+    REQUIRE(mutex->GetOwnerHandle() == first->guest_handle);
+
+    const double signal_and_wait_ns = TimeCalls(iterations, signal_and_wait);
+    REQUIRE(mutex->GetOwnerHandle() == GetCurrentThread()->guest_handle);
+    Report("condition_variable.ping_pong", iterations, signal_and_wait_ns);
+}
+
+TEST_CASE("Kernel::SendSyncRequest to an HLE service", "[core][kernel][benchmark][!hide]") {
+    constexpr size_t iterations = 100000;
+
+    KernelEnvironment environment;
+    const SharedPtr<Thread> thread = environment.CreateThread();
+    const auto service = std::make_shared<BenchmarkService>();
+    const SharedPtr<ClientSession> client = service->CreatePort()->Connect().Unwrap();
+    const Handle session = g_handle_table.Create(client).Unwrap();
+
+    // Request of command 0 without any arguments
+    constexpr std::array<u32, 8> request{{
+        static_cast<u32>(IPC::CommandType::Request), 8, 0, 0,
+        Common::MakeMagic('S', 'F', 'C', 'I'), 0, 0, 0,
+    }};
+    const VAddr command_buffer = thread->GetTLSAddress();
+
+    // The service replies right away, but the thread only resumes after the simulated IPC delay
+    const auto round_trip = [&](size_t) {
+        Memory::WriteBlock(command_buffer, request.data(), request.size() * sizeof(u32));
+        environment.CallSVC(SVC_SEND_SYNC_REQUEST, {session});
+        environment.IdleUntilThreadIsReady();
+    };
+
+    round_trip(0);
+    REQUIRE(Memory::Read32(command_buffer + 4 * sizeof(u32)) ==
+            Common::MakeMagic('S', 'F', 'C', 'O'));
+    REQUIRE(Memory::Read32(command_buffer + 6 * sizeof(u32)) == RESULT_SUCCESS.raw);
+
+    const double round_trip_ns = TimeCalls(iterations, round_trip);
+    Report("ipc.send_sync_request", iterations, round_trip_ns);
+}
+
+} // namespace Kernel
@@ -0,0 +1,126 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "core/hw/aes/aes.h"
+
+namespace HW::AES {
+
+namespace {
+
+std::vector<u8> FromHex(const std::string& hex) {
+    std::vector<u8> bytes(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        bytes[i] = static_cast<u8>(std::stoul(hex.substr(i * 2, 2), nullptr, 16));
+    }
+    return bytes;
+}
+
+template <typename T>
+T ArrayFromHex(const std::string& hex) {
+    const std::vector<u8> bytes = FromHex(hex);
+    T array{};
+    REQUIRE(bytes.size() == array.size());
+    std::copy(bytes.begin(), bytes.end(), array.begin());
+    return array;
+}
+
+} // Anonymous namespace
+
+TEST_CASE("AES::AESEngine", "[core][aes]") {
+    // FIPS-197, appendix C.1
+    const AESEngine engine(ArrayFromHex<Key128>("000102030405060708090a0b0c0d0e0f"));
+    const std::vector<u8> plaintext = FromHex("00112233445566778899aabbccddeeff");
+    const std::vector<u8> ciphertext = FromHex("69c4e0d86a7b0430d8cdb78070b4c55a");
+
+    std::vector<u8> blocks;
+    for (size_t i = 0; i < 7; ++i) {
+        blocks.insert(blocks.end(), plaintext.begin(), plaintext.end());
+    }
+    // Seven blocks exercise both the interleaved and the single block paths
+    engine.EncryptBlocks(blocks.data(), blocks.data(), 7);
+    for (size_t i = 0; i < 7; ++i) {
+        REQUIRE(std::equal(ciphertext.begin(), ciphertext.end(), blocks.begin() + i * 16));
+    }
+    engine.DecryptBlocks(blocks.data(), blocks.data(), 7);
+    for (size_t i = 0; i < 7; ++i) {
+        REQUIRE(std::equal(plaintext.begin(), plaintext.end(), blocks.begin() + i * 16));
+    }
+}
+
+TEST_CASE("AES::TransformCTR", "[core][aes]") {
+    // NIST SP 800-38A, F.5.1. The counter carries out of its lowest byte after the first block.
+    const AESEngine engine(ArrayFromHex<Key128>("2b7e151628aed2a6abf7158809cf4f3c"));
+    const Block iv = ArrayFromHex<Block>("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    const std::vector<u8> plaintext = FromHex(
+        "6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e51"
+        "30c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+    const std::vector<u8> ciphertext = FromHex(
+        "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff"
+        "5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee");
+
+    SECTION("whole stream") {
+        std::vector<u8> data(plaintext.size());
+        TransformCTR(engine, iv, 0, data.data(), plaintext.data(), plaintext.size());
+        REQUIRE(data == ciphertext);
+    }
+
+    SECTION("parts that don't fall on blocks") {
+        std::vector<u8> data = ciphertext;
+        constexpr std::array<size_t, 4> splits{{0, 5, 37, 64}};
+        for (size_t i = 0; i + 1 < splits.size(); ++i) {
+            TransformCTR(engine, iv, splits[i], data.data() + splits[i], data.data() + splits[i],
+                         splits[i + 1] - splits[i]);
+        }
+        REQUIRE(data == plaintext);
+    }
+}
+
+TEST_CASE("AES::EncryptXTS", "[core][aes]") {
+    SECTION("IEEE 1619 vector 2") {
+        const AESEngine data_engine(ArrayFromHex<Key128>("11111111111111111111111111111111"));
+        const AESEngine tweak_engine(ArrayFromHex<Key128>("22222222222222222222222222222222"));
+        const std::vector<u8> plaintext(32, 0x44);
+        const std::vector<u8> ciphertext = FromHex(
+            "c454185e6a16936e39334038acef838bfb186fff7480adc4289382ecd6d394f0");
+
+        std::vector<u8> data(plaintext.size());
+        EncryptXTS(data_engine, tweak_engine, 0x3333333333, 32, TweakByteOrder::Little,
+                   data.data(), plaintext.data(), plaintext.size());
+        REQUIRE(data == ciphertext);
+        DecryptXTS(data_engine, tweak_engine, 0x3333333333, 32, TweakByteOrder::Little,
+                   data.data(), data.data(), data.size());
+        REQUIRE(data == plaintext);
+    }
+
+    SECTION("sectors are independent of each other") {
+        const AESEngine data_engine(ArrayFromHex<Key128>("000102030405060708090a0b0c0d0e0f"));
+        const AESEngine tweak_engine(ArrayFromHex<Key128>("f0e0d0c0b0a090807060504030201000"));
+        std::vector<u8> plaintext(0x200 * 3 + 0x30);
+        for (size_t i = 0; i < plaintext.size(); ++i) {
+            plaintext[i] = static_cast<u8>(i * 7 + i / 251);
+        }
+
+        std::vector<u8> whole(plaintext.size());
+        EncryptXTS(data_engine, tweak_engine, 2, 0x200, TweakByteOrder::Big, whole.data(),
+                   plaintext.data(), plaintext.size());
+        REQUIRE(whole != plaintext);
+
+        std::vector<u8> last_sector(0x30);
+        EncryptXTS(data_engine, tweak_engine, 5, 0x200, TweakByteOrder::Big, last_sector.data(),
+                   plaintext.data() + 0x600, last_sector.size());
+        REQUIRE(std::equal(last_sector.begin(), last_sector.end(), whole.begin() + 0x600));
+
+        DecryptXTS(data_engine, tweak_engine, 2, 0x200, TweakByteOrder::Big, whole.data(),
+                   whole.data(), whole.size());
+        REQUIRE(whole == plaintext);
+    }
+}
+
+} // namespace HW::AES
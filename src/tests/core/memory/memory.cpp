@@ -2,10 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <memory>
+#include <vector>
 #include <catch.hpp>
+#include "core/core.h"
 #include "core/hle/kernel/memory.h"
 #include "core/hle/kernel/process.h"
 #include "core/memory.h"
+#include "core/memory_hook.h"
+#include "core/memory_setup.h"
+#include "tests/test_utils.h"
 
 TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory][!hide]") {
     SECTION("these regions should not be mapped on an empty process") {
@@ -54,3 +60,165 @@ TEST_CASE("Memory::IsValidVirtualAddress", "[core][memory][!hide]") {
         CHECK(Memory::IsValidVirtualAddress(*process, Memory::CONFIG_MEMORY_VADDR) == false);
     }
 }
+
+namespace {
+
+using Tests::TimeCalls;
+
+/// MMIO device that stores the last value written to it, used to drive the `Special` page path.
+class RegisterDevice final : public Memory::MemoryHook {
+public:
+    boost::optional<bool> IsValidAddress(VAddr addr) override {
+        return true;
+    }
+
+    boost::optional<u8> Read8(VAddr addr) override {
+        return static_cast<u8>(value);
+    }
+    boost::optional<u16> Read16(VAddr addr) override {
+        return static_cast<u16>(value);
+    }
+    boost::optional<u32> Read32(VAddr addr) override {
+        return static_cast<u32>(value);
+    }
+    boost::optional<u64> Read64(VAddr addr) override {
+        return value;
+    }
+
+    bool ReadBlock(VAddr src_addr, void* dest_buffer, size_t size) override {
+        return false;
+    }
+
+    bool Write8(VAddr addr, u8 data) override {
+        value = data;
+        return true;
+    }
+    bool Write16(VAddr addr, u16 data) override {
+        value = data;
+        return true;
+    }
+    bool Write32(VAddr addr, u32 data) override {
+        value = data;
+        return true;
+    }
+    bool Write64(VAddr addr, u64 data) override {
+        value = data;
+        return true;
+    }
+
+    bool WriteBlock(VAddr dest_addr, const void* src_buffer, size_t size) override {
+        return false;
+    }
+
+    u64 value = 0;
+};
+
+constexpr VAddr MEMORY_PAGE_VADDR = 0x10000000;
+constexpr VAddr DEVICE_PAGE_VADDR = 0x20000000;
+
+} // namespace
+
+TEST_CASE("Memory::Read/Write access paths", "[core][memory][benchmark][!hide]") {
+    auto process = Kernel::Process::Create("");
+    Core::CurrentProcess() = process;
+    auto& page_table = process->vm_manager.page_table;
+
+    std::vector<u8> backing(Memory::PAGE_SIZE);
+    auto device = std::make_shared<RegisterDevice>();
+    Memory::MapMemoryRegion(page_table, MEMORY_PAGE_VADDR, Memory::PAGE_SIZE, backing.data());
+    Memory::MapIoRegion(page_table, DEVICE_PAGE_VADDR, Memory::PAGE_SIZE, device);
+    Memory::SetCurrentPageTable(&page_table);
+
+    SECTION("MMIO accesses are dispatched to the region's handler") {
+        Memory::Write32(DEVICE_PAGE_VADDR, 0xDEADBEEF);
+        CHECK(device->value == 0xDEADBEEF);
+        CHECK(Memory::Read32(DEVICE_PAGE_VADDR + 4) == 0xDEADBEEF);
+        CHECK(Memory::Read8(DEVICE_PAGE_VADDR) == 0xEF);
+    }
+
+    SECTION("timings") {
+        constexpr size_t iterations = 1000000;
+        u64 sink = 0;
+
+        const double memory_read_ns = TimeCalls(iterations, [&](size_t i) {
+            sink += Memory::Read32(MEMORY_PAGE_VADDR + (i * 4 & Memory::PAGE_MASK));
+        });
+        const double memory_write_ns = TimeCalls(iterations, [&](size_t i) {
+            Memory::Write32(MEMORY_PAGE_VADDR + (i * 4 & Memory::PAGE_MASK), static_cast<u32>(i));
+        });
+        const double mmio_read_ns = TimeCalls(iterations, [&](size_t i) {
+            sink += Memory::Read32(DEVICE_PAGE_VADDR + (i * 4 & 0xFF));
+        });
+        const double mmio_write_ns = TimeCalls(iterations, [&](size_t i) {
+            Memory::Write32(DEVICE_PAGE_VADDR + (i * 4 & 0xFF), static_cast<u32>(i));
+        });
+
+        WARN("Memory Read32: " << memory_read_ns << " ns, Write32: " << memory_write_ns
+                               << " ns; MMIO Read32: " << mmio_read_ns
+                               << " ns, Write32: " << mmio_write_ns << " ns (checksum " << sink
+                               << ")");
+    }
+
+    Memory::UnmapRegion(page_table, DEVICE_PAGE_VADDR, Memory::PAGE_SIZE);
+    Memory::UnmapRegion(page_table, MEMORY_PAGE_VADDR, Memory::PAGE_SIZE);
+}
+
+TEST_CASE("Memory block and pointer access paths", "[core][memory][benchmark][!hide]") {
+    constexpr VAddr BLOCK_VADDR = 0x30000000;
+    constexpr size_t BLOCK_SIZE = 0x100000;
+
+    auto process = Kernel::Process::Create("");
+    Core::CurrentProcess() = process;
+    auto& vm_manager = process->vm_manager;
+
+    // Two adjacent blocks with distinct backing memory, so that accesses spanning the boundary
+    // cross from one VMA into the next.
+    for (VAddr base : {BLOCK_VADDR, BLOCK_VADDR + BLOCK_SIZE}) {
+        auto block = std::make_shared<std::vector<u8>>(BLOCK_SIZE);
+        REQUIRE(vm_manager
+                    .MapMemoryBlock(base, std::move(block), 0, BLOCK_SIZE,
+                                    Kernel::MemoryState::Heap)
+                    .Succeeded());
+    }
+    Memory::SetCurrentPageTable(&vm_manager.page_table);
+
+    constexpr VAddr BOUNDARY_VADDR = BLOCK_VADDR + BLOCK_SIZE;
+    constexpr size_t iterations = 1000000;
+    u64 sink = 0;
+
+    const auto offset = [](size_t i, size_t size) {
+        return BLOCK_VADDR + ((i * size) & (BLOCK_SIZE - 1));
+    };
+    const double read8_ns =
+        TimeCalls(iterations, [&](size_t i) { sink += Memory::Read8(offset(i, 1)); });
+    const double read16_ns =
+        TimeCalls(iterations, [&](size_t i) { sink += Memory::Read16(offset(i, 2)); });
+    const double read32_ns =
+        TimeCalls(iterations, [&](size_t i) { sink += Memory::Read32(offset(i, 4)); });
+    const double read64_ns =
+        TimeCalls(iterations, [&](size_t i) { sink += Memory::Read64(offset(i, 8)); });
+    const double get_pointer_ns = TimeCalls(iterations, [&](size_t i) {
+        sink += reinterpret_cast<uintptr_t>(Memory::GetPointer(offset(i, 8)));
+    });
+
+    WARN("Read8: " << read8_ns << " ns, Read16: " << read16_ns << " ns, Read32: " << read32_ns
+                   << " ns, Read64: " << read64_ns << " ns, GetPointer: " << get_pointer_ns
+                   << " ns");
+
+    std::vector<u8> buffer(0x10000);
+    for (size_t size : {0x10, 0x100, 0x1000, 0x10000}) {
+        const size_t block_iterations = iterations / (size / 0x10);
+        const double read_block_ns = TimeCalls(block_iterations, [&](size_t i) {
+            Memory::ReadBlock(BOUNDARY_VADDR - size / 2, buffer.data(), size);
+        });
+        const double copy_block_ns = TimeCalls(block_iterations, [&](size_t i) {
+            Memory::CopyBlock(BOUNDARY_VADDR, BOUNDARY_VADDR - size, size);
+        });
+        WARN("0x" << std::hex << size << std::dec << " bytes across VMAs - ReadBlock: "
+                  << read_block_ns << " ns, CopyBlock: " << copy_block_ns << " ns");
+    }
+
+    WARN("checksum " << sink);
+
+    vm_manager.UnmapRange(BLOCK_VADDR, 2 * BLOCK_SIZE);
+}
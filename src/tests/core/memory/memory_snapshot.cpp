@@ -0,0 +1,62 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch.hpp>
+#include "core/memory.h"
+#include "core/memory_snapshot.h"
+
+namespace Memory {
+
+TEST_CASE("MemorySnapshots[Incremental]", "[core][memory]") {
+    std::vector<u8> memory(4 * PAGE_SIZE);
+    const std::vector<SnapshotRegion> regions{{0x10000, memory.data(), memory.size()}};
+    MemorySnapshots snapshots(8);
+
+    memory[0] = 1;
+    memory[PAGE_SIZE] = 2;
+    const u64 first = snapshots.Capture(regions);
+    // The two pages full of zeroes aren't stored
+    REQUIRE(snapshots.GetStoredPageCount() == 2);
+
+    memory[PAGE_SIZE] = 3;
+    memory[2 * PAGE_SIZE] = 4;
+    const u64 second = snapshots.Capture(regions);
+    // Only the two pages that changed are stored again
+    REQUIRE(snapshots.GetStoredPageCount() == 4);
+
+    std::fill(memory.begin(), memory.end(), 0xFF);
+    REQUIRE(snapshots.Restore(first, regions));
+    REQUIRE(memory[0] == 1);
+    REQUIRE(memory[PAGE_SIZE] == 2);
+    REQUIRE(memory[2 * PAGE_SIZE] == 0);
+    REQUIRE(memory[3 * PAGE_SIZE + 5] == 0);
+
+    REQUIRE(snapshots.Restore(second, regions));
+    REQUIRE(memory[0] == 1);
+    REQUIRE(memory[PAGE_SIZE] == 3);
+    REQUIRE(memory[2 * PAGE_SIZE] == 4);
+}
+
+TEST_CASE("MemorySnapshots[DropOldest]", "[core][memory]") {
+    std::vector<u8> memory(PAGE_SIZE);
+    const std::vector<SnapshotRegion> regions{{0, memory.data(), memory.size()}};
+    MemorySnapshots snapshots(2);
+
+    std::vector<u64> ids;
+    for (u8 value = 1; value <= 4; ++value) {
+        memory[0] = value;
+        ids.push_back(snapshots.Capture(regions));
+    }
+
+    REQUIRE(!snapshots.Contains(ids[1]));
+    REQUIRE(!snapshots.Restore(ids[1], regions));
+    // Only the versions the two snapshots that are left need are kept
+    REQUIRE(snapshots.GetStoredPageCount() == 2);
+
+    REQUIRE(snapshots.Restore(ids[2], regions));
+    REQUIRE(memory[0] == 3);
+}
+
+} // namespace Memory
@@ -0,0 +1,89 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/core_timing.h"
+#include "core/movie.h"
+#include "core/settings.h"
+
+namespace Core {
+
+namespace {
+
+std::string GetTestPath() {
+    const std::string directory = FileUtil::GetCurrentDir() + "/yuzu_movie_test/";
+    FileUtil::DeleteDirRecursively(directory);
+    FileUtil::CreateFullPath(directory);
+    return directory + "input.ymv";
+}
+
+class ScopeInit final {
+public:
+    ScopeInit() {
+        CoreTiming::Init();
+    }
+    ~ScopeInit() {
+        Movie::GetInstance().Shutdown();
+        CoreTiming::Shutdown();
+    }
+};
+
+/// Runs the CPU for a number of ticks, with no events scheduled to interrupt it.
+void RunFor(u64 ticks) {
+    CoreTiming::AddTicks(ticks);
+    CoreTiming::Advance();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Movie[RecordAndPlayBack]", "[core]") {
+    const std::string path = GetTestPath();
+    Movie& movie = Movie::GetInstance();
+    Settings::values.pad_update_rate = 60;
+
+    {
+        ScopeInit guard;
+        REQUIRE(movie.StartRecording(path));
+        REQUIRE_FALSE(movie.StartPlayback(path));
+        REQUIRE(movie.HandlePadState(0, Movie::SampleKind::Update) == 0);
+        RunFor(1000);
+        REQUIRE(movie.HandlePadState(0b01, Movie::SampleKind::Change) == 0b01);
+        RunFor(1000);
+        REQUIRE(movie.HandlePadState(0b11, Movie::SampleKind::Update) == 0b11);
+        RunFor(1000);
+        REQUIRE(movie.HandlePadState(0b11, Movie::SampleKind::Update) == 0b11);
+    }
+
+    // The recording made at a different rate sets the rate it was made at
+    Settings::values.pad_update_rate = 100;
+    ScopeInit guard;
+    REQUIRE(movie.StartPlayback(path));
+    REQUIRE(Settings::values.pad_update_rate == 60);
+    REQUIRE(movie.IsPlayingBack());
+    REQUIRE(movie.GetChangeTicks() == std::vector<u64>{1000});
+
+    // The devices are ignored, and the recorded state holds until the tick it changed at
+    REQUIRE(movie.HandlePadState(0b100, Movie::SampleKind::Update) == 0);
+    RunFor(999);
+    REQUIRE(movie.HandlePadState(0b100, Movie::SampleKind::Update) == 0);
+    RunFor(1);
+    REQUIRE(movie.HandlePadState(0, Movie::SampleKind::Change) == 0b01);
+    REQUIRE_FALSE(movie.IsPlaybackFinished());
+    RunFor(1000);
+    REQUIRE(movie.HandlePadState(0, Movie::SampleKind::Update) == 0b11);
+    REQUIRE(movie.IsPlaybackFinished());
+}
+
+TEST_CASE("Movie[InvalidFile]", "[core]") {
+    const std::string path = GetTestPath();
+    FileUtil::WriteStringToFile(true, "not a movie, just some text", path.c_str());
+    REQUIRE_FALSE(Movie::GetInstance().StartPlayback(path));
+    REQUIRE_FALSE(Movie::GetInstance().StartPlayback(path + ".missing"));
+    REQUIRE_FALSE(Movie::GetInstance().IsPlayingBack());
+}
+
+} // namespace Core
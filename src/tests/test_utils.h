@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+
+namespace Tests {
+
+/// Fills a buffer with bytes that differ between neighbouring ones and don't repeat every 256.
+inline std::vector<u8> MakePattern(size_t size) {
+    std::vector<u8> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<u8>(i * 7 + i / 251);
+    }
+    return data;
+}
+
+/**
+ * Times `iterations` calls of `func`, which is passed the index of the call, and returns the
+ * average duration of a call in nanoseconds.
+ */
+template <typename Func>
+double TimeCalls(size_t iterations, Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i) {
+        func(i);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+/// Reports a result as a line of key=value pairs, so that scripts can collect and compare them.
+inline void Report(const std::string& name, size_t iterations, double ns_per_op) {
+    WARN("benchmark=" << name << " iterations=" << iterations << " ns_per_op=" << ns_per_op);
+}
+
+} // namespace Tests
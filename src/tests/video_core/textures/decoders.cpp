@@ -0,0 +1,198 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "tests/test_utils.h"
+#include "video_core/textures/decoders.h"
+#include "video_core/textures/texture.h"
+
+namespace Tegra::Texture {
+
+namespace {
+
+using Tests::MakePattern;
+using Tests::TimeCalls;
+
+constexpr std::array<TextureFormat, 6> FORMATS{{
+    TextureFormat::A8R8G8B8,
+    TextureFormat::B5G6R5,
+    TextureFormat::DXT1,
+    TextureFormat::DXT23,
+    TextureFormat::DXT45,
+    TextureFormat::ASTC_2D_4X4,
+}};
+
+constexpr std::array<u32, 6> BLOCK_HEIGHTS{{1, 2, 4, 8, 16, 32}};
+
+const char* GetFormatName(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::A8R8G8B8:
+        return "A8R8G8B8";
+    case TextureFormat::B5G6R5:
+        return "B5G6R5";
+    case TextureFormat::DXT1:
+        return "DXT1";
+    case TextureFormat::DXT23:
+        return "DXT23";
+    case TextureFormat::DXT45:
+        return "DXT45";
+    case TextureFormat::ASTC_2D_4X4:
+        return "ASTC_2D_4X4";
+    }
+    return "Unknown";
+}
+
+/// Compressed formats are swizzled a 4x4 tile at a time, which take the place of the pixels.
+u32 GetUnitsPerPixel(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::DXT1:
+    case TextureFormat::DXT23:
+    case TextureFormat::DXT45:
+    case TextureFormat::ASTC_2D_4X4:
+        return 4;
+    default:
+        return 1;
+    }
+}
+
+/// Unswizzles a texture one pixel at a time with GetSwizzleOffset.
+std::vector<u8> ReferenceUnswizzle(const std::vector<u8>& swizzled, TextureFormat format,
+                                   u32 width, u32 height, u32 block_height) {
+    const u32 bytes_per_pixel = BytesPerPixel(format);
+    const u32 units_width = width / GetUnitsPerPixel(format);
+    const u32 units_height = height / GetUnitsPerPixel(format);
+
+    std::vector<u8> unswizzled(units_width * units_height * bytes_per_pixel);
+    for (u32 y = 0; y < units_height; ++y) {
+        for (u32 x = 0; x < units_width; ++x) {
+            const u32 offset = GetSwizzleOffset(x, y, units_width, bytes_per_pixel, block_height);
+            if (offset + bytes_per_pixel > swizzled.size()) {
+                FAIL("Pixel " << x << "," << y << " is past the end of the swizzled data");
+            }
+            std::memcpy(&unswizzled[(x + y * units_width) * bytes_per_pixel], &swizzled[offset],
+                        bytes_per_pixel);
+        }
+    }
+    return unswizzled;
+}
+
+/// Swizzles a linear texture one pixel at a time with GetSwizzleOffset.
+std::vector<u8> ReferenceSwizzle(const std::vector<u8>& unswizzled, TextureFormat format,
+                                 u32 width, u32 height, u32 block_height) {
+    const u32 bytes_per_pixel = BytesPerPixel(format);
+    const u32 units_width = width / GetUnitsPerPixel(format);
+    const u32 units_height = height / GetUnitsPerPixel(format);
+
+    std::vector<u8> swizzled(GetTextureSwizzledSize(format, width, height, block_height));
+    for (u32 y = 0; y < units_height; ++y) {
+        for (u32 x = 0; x < units_width; ++x) {
+            const u32 offset = GetSwizzleOffset(x, y, units_width, bytes_per_pixel, block_height);
+            std::memcpy(&swizzled[offset], &unswizzled[(x + y * units_width) * bytes_per_pixel],
+                        bytes_per_pixel);
+        }
+    }
+    return swizzled;
+}
+
+/// Returns the offset of the first byte that differs between the buffers, or -1 if they match.
+s64 FindMismatch(const std::vector<u8>& actual, const std::vector<u8>& expected) {
+    if (actual.size() != expected.size()) {
+        return static_cast<s64>(std::min(actual.size(), expected.size()));
+    }
+    const auto mismatch = std::mismatch(actual.begin(), actual.end(), expected.begin());
+    return mismatch.first == actual.end() ? -1 : mismatch.first - actual.begin();
+}
+
+} // Anonymous namespace
+
+TEST_CASE("Tegra::Texture::UnswizzleTexture", "[video_core]") {
+    // The second size isn't made of whole GOBs nor whole blocks in any of the formats
+    constexpr std::array<std::pair<u32, u32>, 2> sizes{{{256, 256}, {72, 52}}};
+
+    for (const TextureFormat format : FORMATS) {
+        for (const u32 block_height : BLOCK_HEIGHTS) {
+            for (const auto& size : sizes) {
+                const u32 width = size.first;
+                const u32 height = size.second;
+                INFO(GetFormatName(format) << " " << width << "x" << height << ", block height "
+                                           << block_height);
+
+                std::vector<u8> swizzled =
+                    MakePattern(GetTextureSwizzledSize(format, width, height, block_height));
+                const std::vector<u8> expected =
+                    ReferenceUnswizzle(swizzled, format, width, height, block_height);
+                // Compressed textures come in a buffer sized as if each of their tiles was a
+                // pixel, of which only the start holds the tiles
+                std::vector<u8> unswizzled =
+                    UnswizzleTexture(swizzled.data(), format, width, height, block_height);
+                REQUIRE(unswizzled.size() >= expected.size());
+                unswizzled.resize(expected.size());
+                REQUIRE(FindMismatch(unswizzled, expected) == -1);
+
+                // Swizzling writes the pixels back where they came from, and leaves the padding
+                const u32 units = GetUnitsPerPixel(format);
+                const u32 bytes_per_pixel = BytesPerPixel(format);
+                std::vector<u8> linear = MakePattern(expected.size());
+                std::vector<u8> reswizzled(swizzled.size());
+                CopySwizzledData(width / units, height / units, bytes_per_pixel, bytes_per_pixel,
+                                 reswizzled.data(), linear.data(), false, block_height);
+                REQUIRE(FindMismatch(reswizzled, ReferenceSwizzle(linear, format, width, height,
+                                                                  block_height)) == -1);
+            }
+        }
+    }
+}
+
+TEST_CASE("Tegra::Texture::DecodeTexture", "[video_core]") {
+    // None of the formats is decoded yet, so the data is passed through as it is
+    const std::vector<u8> data = MakePattern(64 * 64 * 4);
+    for (const TextureFormat format : {TextureFormat::A8R8G8B8, TextureFormat::B5G6R5,
+                                       TextureFormat::DXT1, TextureFormat::DXT23,
+                                       TextureFormat::DXT45}) {
+        INFO(GetFormatName(format));
+        REQUIRE(DecodeTexture(data, format, 64, 64) == data);
+    }
+}
+
+TEST_CASE("Tegra::Texture::UnswizzleTexture timings", "[video_core][benchmark][!hide]") {
+    constexpr u32 width = 1280;
+    constexpr u32 height = 720;
+
+    for (const TextureFormat format : FORMATS) {
+        for (const u32 block_height : BLOCK_HEIGHTS) {
+            std::vector<u8> swizzled =
+                MakePattern(GetTextureSwizzledSize(format, width, height, block_height));
+            const u32 units = GetUnitsPerPixel(format);
+            const u32 bytes_per_pixel = BytesPerPixel(format);
+            const size_t linear_size = (width / units) * (height / units) * bytes_per_pixel;
+
+            // The reference copies a pixel at a time, the GOB path whole runs of 16 bytes. Both
+            // allocate only the unswizzled data, unlike UnswizzleTexture for compressed formats.
+            const double gob_ns = TimeCalls(20, [&](size_t) {
+                std::vector<u8> linear(linear_size);
+                CopySwizzledData(width / units, height / units, bytes_per_pixel, bytes_per_pixel,
+                                 swizzled.data(), linear.data(), true, block_height);
+            });
+            const double pixel_ns = TimeCalls(2, [&](size_t) {
+                ReferenceUnswizzle(swizzled, format, width, height, block_height);
+            });
+
+            for (const auto& result : {std::make_pair("gob", gob_ns),
+                                       std::make_pair("pixel", pixel_ns)}) {
+                WARN("benchmark=unswizzle format="
+                     << GetFormatName(format) << " block_height=" << block_height
+                     << " path=" << result.first
+                     << " gb_per_s=" << linear_size / result.second);
+            }
+        }
+    }
+}
+
+} // namespace Tegra::Texture
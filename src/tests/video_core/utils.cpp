@@ -0,0 +1,97 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <vector>
+#include <catch.hpp>
+#include "common/common_types.h"
+#include "tests/test_utils.h"
+#include "video_core/utils.h"
+
+namespace {
+
+using Tests::MakePattern;
+using Tests::TimeCalls;
+
+/// Offset of a pixel in a 128x128 Morton ordered image, one pixel at a time.
+u32 ReferenceMortonOffset(u32 x, u32 y, u32 width, u32 bytes_per_pixel) {
+    const u32 coarse_y = y & ~127;
+    return VideoCore::GetMortonOffset128(x, y, bytes_per_pixel) +
+           coarse_y * width * bytes_per_pixel;
+}
+
+template <u32 bytes_per_pixel, u32 gl_bytes_per_pixel>
+void CheckMortonCopy(u32 width, u32 height) {
+    // Images in Morton order are made of whole tiles
+    REQUIRE(width % 128 == 0);
+    REQUIRE(height % 128 == 0);
+    const size_t morton_size = width * height * bytes_per_pixel;
+    const size_t gl_size = width * height * gl_bytes_per_pixel;
+
+    SECTION("Morton to linear") {
+        std::vector<u8> morton = MakePattern(morton_size);
+        std::vector<u8> gl(gl_size);
+        VideoCore::MortonCopyPixels128<bytes_per_pixel, gl_bytes_per_pixel>(
+            width, height, morton.data(), gl.data(), true);
+
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                const u8* expected = &morton[ReferenceMortonOffset(x, y, width, bytes_per_pixel)];
+                const u8* actual = &gl[(x + y * width) * gl_bytes_per_pixel];
+                REQUIRE(std::memcmp(expected, actual, bytes_per_pixel) == 0);
+            }
+        }
+    }
+
+    SECTION("linear to Morton") {
+        std::vector<u8> morton(morton_size);
+        std::vector<u8> gl = MakePattern(gl_size);
+        VideoCore::MortonCopyPixels128<bytes_per_pixel, gl_bytes_per_pixel>(
+            width, height, morton.data(), gl.data(), false);
+
+        for (u32 y = 0; y < height; ++y) {
+            for (u32 x = 0; x < width; ++x) {
+                const u8* expected = &gl[(x + y * width) * gl_bytes_per_pixel];
+                const u8* actual = &morton[ReferenceMortonOffset(x, y, width, bytes_per_pixel)];
+                REQUIRE(std::memcmp(expected, actual, bytes_per_pixel) == 0);
+            }
+        }
+    }
+}
+
+} // Anonymous namespace
+
+TEST_CASE("VideoCore::MortonCopyPixels128", "[video_core]") {
+    SECTION("32-bit pixels over several tiles") {
+        CheckMortonCopy<4, 4>(256, 256);
+    }
+    SECTION("16-bit pixels over several tiles") {
+        CheckMortonCopy<2, 2>(128, 384);
+    }
+    SECTION("pixels that are padded in the linear image") {
+        CheckMortonCopy<2, 4>(384, 128);
+    }
+}
+
+TEST_CASE("VideoCore::MortonCopyPixels128 timings", "[video_core][benchmark][!hide]") {
+    constexpr u32 width = 1280;
+    constexpr u32 height = 768;
+    constexpr size_t iterations = 100;
+
+    std::vector<u8> morton = MakePattern(width * height * 4);
+    std::vector<u8> gl(width * height * 4);
+
+    const auto time_copies = [&](bool morton_to_gl) {
+        return TimeCalls(iterations, [&](size_t) {
+                   VideoCore::MortonCopyPixels128<4, 4>(width, height, morton.data(), gl.data(),
+                                                        morton_to_gl);
+               }) /
+               1e6;
+    };
+
+    const double load_ms = time_copies(true);
+    const double flush_ms = time_copies(false);
+    WARN("1280x768 ABGR8 Morton to linear: " << load_ms << " ms, linear to Morton: " << flush_ms
+                                             << " ms");
+}
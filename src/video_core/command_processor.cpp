@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <cinttypes>
 #include <cstddef>
 #include <memory>
 #include <utility>
@@ -10,12 +11,14 @@
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/memory.h"
-#include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/engines/fermi_2d.h"
+#include "video_core/engines/kepler_memory.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/engines/maxwell_compute.h"
+#include "video_core/engines/maxwell_dma.h"
 #include "video_core/gpu.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
@@ -31,9 +34,6 @@ enum class BufferMethods {
 };
 
 void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params) {
-    LOG_WARNING(HW_GPU, "Processing method %08X on subchannel %u value %08X remaining params %u",
-                method, subchannel, value, remaining_params);
-
     if (method == static_cast<u32>(BufferMethods::SetGraphMacroEntry)) {
         // Prepare to upload a new macro, reset the upload counter.
         LOG_DEBUG(HW_GPU, "Uploading GPU macro %08X", value);
@@ -59,7 +59,7 @@ void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params)
     if (method == static_cast<u32>(BufferMethods::BindObject)) {
         // Bind the current subchannel to the desired engine id.
         LOG_DEBUG(HW_GPU, "Binding subchannel %u to engine %u", subchannel, value);
-        ASSERT(bound_engines.find(subchannel) == bound_engines.end());
+        ASSERT(!bound_engines[subchannel]);
         bound_engines[subchannel] = static_cast<EngineID>(value);
         return;
     }
@@ -70,11 +70,10 @@ void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params)
         return;
     }
 
-    ASSERT(bound_engines.find(subchannel) != bound_engines.end());
-
-    const EngineID engine = bound_engines[subchannel];
+    const boost::optional<EngineID>& engine = bound_engines[subchannel];
+    ASSERT(engine);
 
-    switch (engine) {
+    switch (*engine) {
     case EngineID::FERMI_TWOD_A:
         fermi_2d->WriteReg(method, value);
         break;
@@ -84,60 +83,116 @@ void GPU::WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params)
     case EngineID::MAXWELL_COMPUTE_B:
         maxwell_compute->WriteReg(method, value);
         break;
+    case EngineID::MAXWELL_DMA_COPY_A:
+        maxwell_dma->WriteReg(method, value);
+        break;
+    case EngineID::KEPLER_INLINE_TO_MEMORY_B:
+        kepler_memory->WriteReg(method, value);
+        break;
     default:
         UNIMPLEMENTED();
     }
 }
 
+void GPU::WriteRegBatch(u32 method, u32 subchannel, const u32* values, u32 count,
+                        bool increasing) {
+    if (count == 0) {
+        return;
+    }
+
+    if (!increasing && method == static_cast<u32>(BufferMethods::SetGraphMacroCodeArg)) {
+        // The code words of a macro, which is complete once the run ends.
+        current_macro_code.insert(current_macro_code.end(), values, values + count);
+        maxwell_3d->SubmitMacroCode(current_macro_entry, std::move(current_macro_code));
+        current_macro_entry = InvalidGraphMacroEntry;
+        current_macro_code.clear();
+        return;
+    }
+
+    if (method >= static_cast<u32>(BufferMethods::CountBufferMethods)) {
+        if (bound_engines[subchannel] == EngineID::MAXWELL_B) {
+                maxwell_3d->WriteRegBatch(method, values, count, increasing);
+            return;
+        }
+        if (bound_engines[subchannel] == EngineID::KEPLER_INLINE_TO_MEMORY_B) {
+                kepler_memory->WriteRegBatch(method, values, count, increasing);
+            return;
+        }
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        WriteReg(increasing ? method + i : method, subchannel, values[i], count - i - 1);
+    }
+}
+
 void GPU::ProcessCommandList(GPUVAddr address, u32 size) {
-    // TODO(Subv): PhysicalToVirtualAddress is a misnomer, it converts a GPU VAddr into an
-    // application VAddr.
-    const VAddr head_address = memory_manager->PhysicalToVirtualAddress(address);
-    VAddr current_addr = head_address;
-    while (current_addr < head_address + size * sizeof(CommandHeader)) {
-        const CommandHeader header = {Memory::Read32(current_addr)};
-        current_addr += sizeof(u32);
+    Core::PerfStats::SubsystemScope perf_scope(Core::System::GetInstance().perf_stats,
+                                               Core::PerfStats::Subsystem::GpuCommands);
+
+    if (trace_recorder) {
+        TraceCommandList(address, size);
+    }
+
+    const size_t size_in_bytes = size * sizeof(CommandHeader);
+    const auto ranges = memory_manager->GetMappedRanges(address, size_in_bytes);
+
+    // The list is translated to host memory once, and parsed from there. It is read in place when
+    // it is contiguous in application memory and its pages are consecutive in host memory, and
+    // copied out a range at a time otherwise.
+    const u32* words = nullptr;
+    if (ranges.size() == 1) {
+        words = reinterpret_cast<const u32*>(
+            Memory::GetContiguousPointer(ranges[0].cpu_addr, size_in_bytes));
+    }
+    if (words == nullptr) {
+        command_list_buffer.resize(size);
+        u8* dest = reinterpret_cast<u8*>(command_list_buffer.data());
+        for (const auto& range : ranges) {
+            Memory::ReadBlock(range.cpu_addr, dest, range.size);
+            dest += range.size;
+        }
+        words = command_list_buffer.data();
+    }
+
+    u32 index = 0;
+    while (index < size) {
+        const CommandHeader header = {words[index++]};
+
+        if (header.mode == SubmissionMode::Inline) {
+            // The register value is stored in the bits 16-28 as an immediate
+            WriteReg(header.method, header.subchannel, header.inline_data, 0);
+            continue;
+        }
+
+        const u32 arg_count = header.arg_count;
+        if (arg_count > size - index) {
+            LOG_ERROR(HW_GPU, "Command list at %016" PRIX64 " ends in the middle of a method",
+                      address);
+            break;
+        }
+        const u32* args = words + index;
+        index += arg_count;
 
         switch (header.mode.Value()) {
         case SubmissionMode::IncreasingOld:
         case SubmissionMode::Increasing: {
             // Increase the method value with each argument.
-            for (unsigned i = 0; i < header.arg_count; ++i) {
-                WriteReg(header.method + i, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
-            }
+            WriteRegBatch(header.method, header.subchannel, args, arg_count, true);
             break;
         }
         case SubmissionMode::NonIncreasingOld:
         case SubmissionMode::NonIncreasing: {
             // Use the same method value for all arguments.
-            for (unsigned i = 0; i < header.arg_count; ++i) {
-                WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
-            }
+            WriteRegBatch(header.method, header.subchannel, args, arg_count, false);
             break;
         }
         case SubmissionMode::IncreaseOnce: {
-            ASSERT(header.arg_count.Value() >= 1);
+            ASSERT(arg_count >= 1);
 
             // Use the original method for the first argument and then the next method for all other
             // arguments.
-            WriteReg(header.method, header.subchannel, Memory::Read32(current_addr),
-                     header.arg_count - 1);
-            current_addr += sizeof(u32);
-
-            for (unsigned i = 1; i < header.arg_count; ++i) {
-                WriteReg(header.method + 1, header.subchannel, Memory::Read32(current_addr),
-                         header.arg_count - i - 1);
-                current_addr += sizeof(u32);
-            }
-            break;
-        }
-        case SubmissionMode::Inline: {
-            // The register value is stored in the bits 16-28 as an immediate
-            WriteReg(header.method, header.subchannel, header.inline_data, 0);
+            WriteReg(header.method, header.subchannel, args[0], arg_count - 1);
+            WriteRegBatch(header.method + 1, header.subchannel, args + 1, arg_count - 1, false);
             break;
         }
         default:
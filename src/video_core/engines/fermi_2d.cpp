@@ -2,12 +2,237 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/memory.h"
 #include "video_core/engines/fermi_2d.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/textures/decoders.h"
+#include "video_core/video_core.h"
 
 namespace Tegra {
 namespace Engines {
 
-void Fermi2D::WriteReg(u32 method, u32 value) {}
+Fermi2D::Fermi2D(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
+
+void Fermi2D::WriteReg(u32 method, u32 value) {
+    ASSERT_MSG(method < Regs::NUM_REGS,
+               "Invalid Fermi2D register, increase the size of the Regs structure");
+
+    regs.reg_array[method] = value;
+
+    switch (method) {
+    case FERMI2D_REG_INDEX(trigger): {
+        HandleSurfaceCopy();
+        break;
+    }
+    }
+}
+
+void Fermi2D::HandleSurfaceCopy() {
+    LOG_DEBUG(HW_GPU, "Requested a surface copy with operation %u",
+              static_cast<u32>(regs.operation));
+
+    if (regs.operation != Regs::Operation::SrcCopy) {
+        LOG_WARNING(HW_GPU, "Unimplemented surface copy operation %u, doing a raw copy",
+                    static_cast<u32>(regs.operation));
+    }
+
+    // Copies between surfaces that the rasterizer has cached are done on the host GPU, without
+    // going through guest memory.
+    if (VideoCore::g_renderer->Rasterizer()->AccelerateSurfaceCopy(regs.src, regs.dst)) {
+        return;
+    }
+
+    const u32 src_bytes_per_pixel = RenderTargetBytesPerPixel(regs.src.format);
+    const u32 dst_bytes_per_pixel = RenderTargetBytesPerPixel(regs.dst.format);
+    if (src_bytes_per_pixel == 0 || dst_bytes_per_pixel == 0) {
+        LOG_ERROR(HW_GPU, "Surface copy from format %u to format %u, skipping it",
+                  static_cast<u32>(regs.src.format), static_cast<u32>(regs.dst.format));
+        return;
+    }
+
+    const VAddr source_cpu = memory_manager.PhysicalToVirtualAddress(regs.src.Address());
+    const VAddr dest_cpu = memory_manager.PhysicalToVirtualAddress(regs.dst.Address());
+    const u32 width = std::min(regs.src.width, regs.dst.width);
+    const u32 rows = std::min(regs.src.height, regs.dst.height);
+
+    if (regs.src.linear && regs.dst.linear && regs.src.format == regs.dst.format) {
+        // Both surfaces are linear, so rows are copied one at a time to account for their
+        // pitches.
+        const u32 row_size = width * src_bytes_per_pixel;
+        for (u32 row = 0; row < rows; ++row) {
+            Memory::CopyBlock(dest_cpu + row * regs.dst.pitch, source_cpu + row * regs.src.pitch,
+                              row_size);
+        }
+        return;
+    }
+
+    // Otherwise the copied pixels are moved to the host, unswizzled and converted there, and
+    // swizzled again on their way to the destination.
+    const std::vector<u8> source = ReadSurface(regs.src, source_cpu);
+    const u32 src_row_size = regs.src.width * src_bytes_per_pixel;
+    std::vector<u8> region(static_cast<size_t>(width) * rows * dst_bytes_per_pixel);
+    u8* region_pixel = region.data();
+    for (u32 row = 0; row < rows; ++row) {
+        const u8* src_pixel = source.data() + static_cast<size_t>(row) * src_row_size;
+        if (regs.src.format == regs.dst.format) {
+            std::memcpy(region_pixel, src_pixel, width * dst_bytes_per_pixel);
+            region_pixel += width * dst_bytes_per_pixel;
+            continue;
+        }
+        for (u32 x = 0; x < width; ++x) {
+            EncodePixel(regs.dst.format, DecodePixel(regs.src.format, src_pixel), region_pixel);
+            src_pixel += src_bytes_per_pixel;
+            region_pixel += dst_bytes_per_pixel;
+        }
+    }
+
+    const u32 region_row_size = width * dst_bytes_per_pixel;
+    if (regs.dst.linear) {
+        for (u32 row = 0; row < rows; ++row) {
+            Memory::WriteBlock(dest_cpu + static_cast<u64>(row) * regs.dst.pitch,
+                               region.data() + static_cast<size_t>(row) * region_row_size,
+                               region_row_size);
+        }
+        return;
+    }
+
+    // The pixels of the destination outside of the copy are written back as they were.
+    std::vector<u8> dest = ReadSurface(regs.dst, dest_cpu);
+    const u32 dst_row_size = regs.dst.width * dst_bytes_per_pixel;
+    for (u32 row = 0; row < rows; ++row) {
+        std::memcpy(dest.data() + static_cast<size_t>(row) * dst_row_size,
+                    region.data() + static_cast<size_t>(row) * region_row_size, region_row_size);
+    }
+    WriteSurface(regs.dst, dest_cpu, dest);
+}
+
+std::vector<u8> Fermi2D::ReadSurface(const Regs::Surface& surface, VAddr address) {
+    const u32 bytes_per_pixel = RenderTargetBytesPerPixel(surface.format);
+    const u32 row_size = surface.width * bytes_per_pixel;
+    std::vector<u8> pixels(static_cast<size_t>(row_size) * surface.height);
+    if (surface.linear) {
+        for (u32 row = 0; row < surface.height; ++row) {
+            Memory::ReadBlock(address + static_cast<u64>(row) * surface.pitch,
+                              pixels.data() + static_cast<size_t>(row) * row_size, row_size);
+        }
+        return pixels;
+    }
+
+    std::vector<u8> swizzled(Texture::GetSwizzledSize(surface.width, surface.height,
+                                                      bytes_per_pixel, surface.BlockHeight()));
+    Memory::ReadBlock(address, swizzled.data(), swizzled.size());
+    Texture::CopySwizzledData(surface.width, surface.height, bytes_per_pixel, bytes_per_pixel,
+                              swizzled.data(), pixels.data(), true, surface.BlockHeight());
+    return pixels;
+}
+
+void Fermi2D::WriteSurface(const Regs::Surface& surface, VAddr address, std::vector<u8>& pixels) {
+    const u32 bytes_per_pixel = RenderTargetBytesPerPixel(surface.format);
+    std::vector<u8> swizzled(Texture::GetSwizzledSize(surface.width, surface.height,
+                                                      bytes_per_pixel, surface.BlockHeight()));
+    // The parts of the blocks outside of the surface are left as they were.
+    Memory::ReadBlock(address, swizzled.data(), swizzled.size());
+    Texture::CopySwizzledData(surface.width, surface.height, bytes_per_pixel, bytes_per_pixel,
+                              swizzled.data(), pixels.data(), false, surface.BlockHeight());
+    Memory::WriteBlock(address, swizzled.data(), swizzled.size());
+}
+
+/// Converts a 16-bit floating point value to a 32-bit one.
+static float HalfToFloat(u16 half) {
+    const u32 exponent = (half >> 10) & 0x1F;
+    const u32 mantissa = half & 0x3FF;
+    float value;
+    if (exponent == 0) {
+        value = std::ldexp(static_cast<float>(mantissa), -24);
+    } else if (exponent == 0x1F) {
+        value = mantissa != 0 ? NAN : INFINITY;
+    } else {
+        value = std::ldexp(static_cast<float>(mantissa | 0x400), static_cast<int>(exponent) - 25);
+    }
+    return (half & 0x8000) != 0 ? -value : value;
+}
+
+/// Converts a 32-bit floating point value to the nearest 16-bit one.
+static u16 FloatToHalf(float value) {
+    const u16 sign = std::signbit(value) ? 0x8000 : 0;
+    value = std::fabs(value);
+    if (std::isnan(value)) {
+        return sign | 0x7E00;
+    }
+    if (value < std::ldexp(1.0f, -14)) {
+        // Denormals, which round up to the smallest normal value when they have to.
+        return sign | static_cast<u16>(std::lround(std::ldexp(value, 24)));
+    }
+
+    int exponent;
+    const float fraction = std::frexp(value, &exponent);
+    u32 mantissa = static_cast<u32>(std::lround(std::ldexp(fraction, 11))) - 0x400;
+    int biased_exponent = exponent + 14;
+    if (mantissa == 0x400) {
+        mantissa = 0;
+        ++biased_exponent;
+    }
+    if (biased_exponent >= 0x1F) {
+        return sign | 0x7C00;
+    }
+    return sign | static_cast<u16>(biased_exponent << 10) | static_cast<u16>(mantissa);
+}
+
+/// Converts a value between 0 and 1 to an unsigned normalized integer of the given maximum.
+static u32 ToUnorm(float value, u32 max) {
+    return static_cast<u32>(std::lround(std::clamp(value, 0.0f, 1.0f) * max));
+}
+
+std::array<float, 4> Fermi2D::DecodePixel(RenderTargetFormat format, const u8* pixel) {
+    switch (format) {
+    case RenderTargetFormat::RGBA16_FLOAT: {
+        std::array<u16, 4> components;
+        std::memcpy(components.data(), pixel, sizeof(components));
+        return {HalfToFloat(components[0]), HalfToFloat(components[1]),
+                HalfToFloat(components[2]), HalfToFloat(components[3])};
+    }
+    case RenderTargetFormat::RGB10_A2_UNORM: {
+        u32 value;
+        std::memcpy(&value, pixel, sizeof(value));
+        return {(value & 0x3FF) / 1023.0f, ((value >> 10) & 0x3FF) / 1023.0f,
+                ((value >> 20) & 0x3FF) / 1023.0f, (value >> 30) / 3.0f};
+    }
+    default:
+        // sRGB surfaces are converted like UNORM ones, the copy keeps the encoded values.
+        return {pixel[0] / 255.0f, pixel[1] / 255.0f, pixel[2] / 255.0f, pixel[3] / 255.0f};
+    }
+}
+
+void Fermi2D::EncodePixel(RenderTargetFormat format, const std::array<float, 4>& color,
+                          u8* pixel) {
+    switch (format) {
+    case RenderTargetFormat::RGBA16_FLOAT: {
+        const std::array<u16, 4> components{FloatToHalf(color[0]), FloatToHalf(color[1]),
+                                            FloatToHalf(color[2]), FloatToHalf(color[3])};
+        std::memcpy(pixel, components.data(), sizeof(components));
+        break;
+    }
+    case RenderTargetFormat::RGB10_A2_UNORM: {
+        const u32 value = ToUnorm(color[0], 0x3FF) | (ToUnorm(color[1], 0x3FF) << 10) |
+                          (ToUnorm(color[2], 0x3FF) << 20) | (ToUnorm(color[3], 3) << 30);
+        std::memcpy(pixel, &value, sizeof(value));
+        break;
+    }
+    default:
+        for (size_t component = 0; component < color.size(); ++component) {
+            pixel[component] = static_cast<u8>(ToUnorm(color[component], 0xFF));
+        }
+        break;
+    }
+}
 
 } // namespace Engines
 } // namespace Tegra
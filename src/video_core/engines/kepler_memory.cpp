@@ -0,0 +1,141 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/memory.h"
+#include "video_core/engines/kepler_memory.h"
+#include "video_core/textures/decoders.h"
+
+namespace Tegra {
+namespace Engines {
+
+KeplerMemory::KeplerMemory(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
+
+void KeplerMemory::WriteReg(u32 method, u32 value) {
+    ASSERT_MSG(method < Regs::NUM_REGS,
+               "Invalid KeplerMemory register, increase the size of the Regs structure");
+
+    regs.reg_array[method] = value;
+
+    switch (method) {
+    case KEPLERMEMORY_REG_INDEX(exec): {
+        ProcessExec();
+        break;
+    }
+    case KEPLERMEMORY_REG_INDEX(data): {
+        ProcessData(&value, 1);
+        break;
+    }
+    }
+}
+
+void KeplerMemory::WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing) {
+    if (method == KEPLERMEMORY_REG_INDEX(data) && (!increasing || count == 1)) {
+        regs.data = values[count - 1];
+        ProcessData(values, count);
+        return;
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        WriteReg(increasing ? method + i : method, values[i]);
+    }
+}
+
+void KeplerMemory::ProcessExec() {
+    state.write_offset = 0;
+    state.drop_payload = false;
+    if (regs.exec.linear) {
+        // Linear destinations are written a line every pitch bytes, and have no position.
+        return;
+    }
+
+    // Blocks more than one slice deep lay out the slices of a block together, which isn't done.
+    if (regs.dest.block_depth != 0) {
+        LOG_ERROR(HW_GPU, "Unimplemented upload to blocks %u slices deep, dropping it",
+                  1u << regs.dest.block_depth);
+        state.drop_payload = true;
+        return;
+    }
+    if (static_cast<u64>(regs.dest.x) + regs.line_length_in > regs.dest.width ||
+        static_cast<u64>(regs.dest.y) + regs.line_count > regs.dest.height ||
+        regs.dest.z >= std::max(regs.dest.depth, 1u)) {
+        LOG_ERROR(HW_GPU,
+                  "Upload of %ux%u bytes at (%u, %u, %u) doesn't fit in the %ux%ux%u destination, "
+                  "dropping it",
+                  regs.line_length_in, regs.line_count, regs.dest.x, regs.dest.y, regs.dest.z,
+                  regs.dest.width, regs.dest.height, regs.dest.depth);
+        state.drop_payload = true;
+    }
+}
+
+void KeplerMemory::ProcessData(const u32* values, u32 count) {
+    // The payload is made of whole words, with any bytes past the end of the line left unwritten.
+    const u64 payload_size = static_cast<u64>(regs.line_length_in) * regs.line_count;
+    if (state.write_offset >= payload_size) {
+        LOG_ERROR(HW_GPU, "Inline data written past the end of the %" PRIu64 " byte payload",
+                  payload_size);
+        return;
+    }
+    const u64 size = std::min<u64>(count * sizeof(u32), payload_size - state.write_offset);
+    const u64 start = state.write_offset;
+    state.write_offset += static_cast<u32>(count * sizeof(u32));
+    if (state.drop_payload) {
+        return;
+    }
+
+    const u8* data = reinterpret_cast<const u8*>(values);
+    if (regs.exec.linear && regs.line_count == 1) {
+        WriteMemory(regs.dest.Address() + start, data, size);
+        return;
+    }
+
+    // Split the data at the ends of the lines, which aren't next to each other at the destination.
+    for (u64 offset = start; offset < start + size;) {
+        const u32 line = static_cast<u32>(offset / regs.line_length_in);
+        const u32 column = static_cast<u32>(offset % regs.line_length_in);
+        const u32 line_size =
+            static_cast<u32>(std::min<u64>(regs.line_length_in - column, start + size - offset));
+        if (regs.exec.linear) {
+            WriteMemory(regs.dest.Address() + static_cast<u64>(line) * regs.dest.pitch + column,
+                        data, line_size);
+        } else {
+            WriteBlockLinear(column, line, data, line_size);
+        }
+        data += line_size;
+        offset += line_size;
+    }
+}
+
+void KeplerMemory::WriteBlockLinear(u32 column, u32 line, const u8* data, u32 size) {
+    const u32 block_height = 1u << regs.dest.block_height;
+    const u64 slice_offset = static_cast<u64>(regs.dest.z) *
+                             Texture::GetSwizzledSize(regs.dest.width, regs.dest.height, 1,
+                                                      block_height);
+    const u32 y = regs.dest.y + line;
+
+    // Each 16 byte run of a GOB row is contiguous in memory.
+    for (u32 x = regs.dest.x + column; size > 0;) {
+        const u32 run = std::min(size, 16 - x % 16);
+        const u32 offset = Texture::GetSwizzleOffset(x, y, regs.dest.width, 1, block_height);
+        WriteMemory(regs.dest.Address() + slice_offset + offset, data, run);
+        data += run;
+        x += run;
+        size -= run;
+    }
+}
+
+void KeplerMemory::WriteMemory(GPUVAddr address, const u8* data, u64 size) {
+    // Memory::WriteBlock invalidates exactly the range written in the rasterizer cache, and
+    // const buffers written this way are picked up by the rasterizer at the next draw.
+    for (const auto& range : memory_manager.GetMappedRanges(address, size)) {
+        Memory::WriteBlock(range.cpu_addr, data, range.size);
+        data += range.size;
+    }
+}
+
+} // namespace Engines
+} // namespace Tegra
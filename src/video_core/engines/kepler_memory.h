@@ -0,0 +1,133 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include "common/assert.h"
+#include "common/bit_field.h"
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "video_core/gpu.h"
+#include "video_core/memory_manager.h"
+
+namespace Tegra {
+namespace Engines {
+
+#define KEPLERMEMORY_REG_INDEX(field_name)                                                         \
+    (offsetof(Tegra::Engines::KeplerMemory::Regs, field_name) / sizeof(u32))
+
+/// Inline-to-memory engine, which writes data embedded in the command lists to memory.
+class KeplerMemory final {
+public:
+    explicit KeplerMemory(MemoryManager& memory_manager);
+    ~KeplerMemory() = default;
+
+    /// Write the value to the register identified by method.
+    void WriteReg(u32 method, u32 value);
+
+    /**
+     * Writes a run of values from a command list. Runs of data words, which is how the payloads
+     * are pushed, are written to memory at once instead of a word at a time.
+     * @param method First register written.
+     * @param values Values of the run.
+     * @param count Number of values.
+     * @param increasing Whether each value goes to the register after the previous one, or all of
+     * them go to the same one.
+     */
+    void WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing);
+
+    struct Regs {
+        static constexpr size_t NUM_REGS = 0x7F;
+
+        union {
+            struct {
+                INSERT_PADDING_WORDS(0x60);
+
+                u32 line_length_in;
+                u32 line_count;
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+                    u32 pitch;
+                    union {
+                        BitField<0, 4, u32> block_width;
+                        BitField<4, 4, u32> block_height;
+                        BitField<8, 4, u32> block_depth;
+                    };
+                    u32 width;
+                    u32 height;
+                    u32 depth;
+                    u32 z;
+                    u32 x;
+                    u32 y;
+
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } dest;
+
+                struct {
+                    union {
+                        BitField<0, 1, u32> linear;
+                    };
+                } exec;
+
+                u32 data;
+
+                INSERT_PADDING_WORDS(0x11);
+            };
+            std::array<u32, NUM_REGS> reg_array;
+        };
+    } regs{};
+
+    struct {
+        /// Offset in the payload of the next data written, in bytes.
+        u32 write_offset = 0;
+        /// Whether the payload goes to a destination that can't be written, and is dropped.
+        bool drop_payload = false;
+    } state{};
+
+private:
+    MemoryManager& memory_manager;
+
+    /// Checks the destination of the payload that starts being written.
+    void ProcessExec();
+
+    /// Writes payload data words to the destination, after the data written so far.
+    void ProcessData(const u32* values, u32 count);
+
+    /**
+     * Writes part of a line of the payload to a block linear destination. The line is written at
+     * the position of the destination, which is in bytes.
+     * @param column Offset of the data in the line, in bytes.
+     * @param line Line of the payload.
+     * @param data Data to write.
+     * @param size Size of the data, which doesn't go past the end of the line.
+     */
+    void WriteBlockLinear(u32 column, u32 line, const u8* data, u32 size);
+
+    /// Writes data to the given GPU address.
+    void WriteMemory(GPUVAddr address, const u8* data, u64 size);
+};
+
+#define ASSERT_REG_POSITION(field_name, position)                                                  \
+    static_assert(offsetof(KeplerMemory::Regs, field_name) == position * 4,                        \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_REG_POSITION(line_length_in, 0x60);
+ASSERT_REG_POSITION(line_count, 0x61);
+ASSERT_REG_POSITION(dest, 0x62);
+ASSERT_REG_POSITION(exec, 0x6C);
+ASSERT_REG_POSITION(data, 0x6D);
+
+#undef ASSERT_REG_POSITION
+
+static_assert(sizeof(KeplerMemory::Regs) == KeplerMemory::Regs::NUM_REGS * sizeof(u32),
+              "KeplerMemory Regs has wrong size");
+
+} // namespace Engines
+} // namespace Tegra
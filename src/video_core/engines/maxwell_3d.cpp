@@ -2,9 +2,14 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cinttypes>
 #include "common/assert.h"
+#include "common/cityhash.h"
+#include "common/logging/log.h"
 #include "core/core.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/rasterizer_interface.h"
@@ -20,20 +25,64 @@ namespace Engines {
 constexpr u32 MacroRegistersStart = 0xE00;
 
 Maxwell3D::Maxwell3D(MemoryManager& memory_manager)
-    : memory_manager(memory_manager), macro_interpreter(*this) {}
+    : memory_manager(memory_manager), macro_interpreter(*this) {
+    const auto set_flag = [this](size_t first_reg, size_t size, DirtyFlag flag) {
+        std::fill_n(dirty_flag_table.begin() + first_reg, size / sizeof(u32), flag);
+    };
+    set_flag(MAXWELL3D_REG_INDEX(viewport), sizeof(regs.viewport), DirtyFlag::Viewport);
+    set_flag(MAXWELL3D_REG_INDEX(blend), sizeof(regs.blend), DirtyFlag::Blend);
+
+    dirty_flags.set();
+}
 
 void Maxwell3D::SubmitMacroCode(u32 entry, std::vector<u32> code) {
-    uploaded_macros[entry * 2 + MacroRegistersStart] = std::move(code);
+    const u32 method = entry * 2 + MacroRegistersStart;
+
+    const u64 hash = Common::CityHash64(reinterpret_cast<const char*>(code.data()),
+                                        code.size() * sizeof(u32));
+    LOG_DEBUG(HW_GPU, "Uploaded macro %08X, code hash %016" PRIX64, method, hash);
+
+    if (const HLEMacroFunction hle_macro = GetHLEMacro(hash)) {
+        hle_macros[method] = hle_macro;
+    } else {
+        hle_macros.erase(method);
+    }
+
+    auto cached = macro_cache.find(hash);
+    if (cached == macro_cache.end()) {
+        // Code that can't be decoded is cached as such, and left to the interpreter.
+        auto program = MacroInterpreter::Compile(code);
+        std::shared_ptr<const MacroInterpreter::Program> compiled;
+        if (program) {
+            compiled = std::make_shared<const MacroInterpreter::Program>(std::move(*program));
+        } else {
+            LOG_DEBUG(HW_GPU, "Macro %08X will be interpreted", method);
+        }
+        cached = macro_cache.emplace(hash, std::move(compiled)).first;
+    }
+
+    compiled_macros[method] = cached->second;
+    uploaded_macros[method] = std::move(code);
 }
 
-void Maxwell3D::CallMacroMethod(u32 method, std::vector<u32> parameters) {
+void Maxwell3D::CallMacroMethod(u32 method, const u32* parameters, size_t num_parameters) {
     auto macro_code = uploaded_macros.find(method);
     // The requested macro must have been uploaded already.
     ASSERT_MSG(macro_code != uploaded_macros.end(), "Macro %08X was not uploaded", method);
 
     // Reset the current macro and execute it.
     executing_macro = 0;
-    macro_interpreter.Execute(macro_code->second, std::move(parameters));
+    macro_running = true;
+    const auto hle_macro = hle_macros.find(method);
+    const auto compiled = compiled_macros.find(method);
+    if (hle_macro != hle_macros.end()) {
+        hle_macro->second(*this, parameters, num_parameters);
+    } else if (compiled != compiled_macros.end() && compiled->second != nullptr) {
+        macro_interpreter.Execute(*compiled->second, parameters, num_parameters);
+    } else {
+        macro_interpreter.Execute(macro_code->second, parameters, num_parameters);
+    }
+    macro_running = false;
 }
 
 void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
@@ -52,6 +101,7 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
     // uploaded to the GPU during initialization.
     if (method >= MacroRegistersStart) {
         // We're trying to execute a macro
+        ASSERT_MSG(!macro_running, "Macros calling other macros are not supported");
         if (executing_macro == 0) {
             // A macro call must begin by writing the macro method's register, not its argument.
             ASSERT_MSG((method % 2) == 0,
@@ -63,7 +113,8 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
 
         // Call the macro when there are no more parameters in the command buffer
         if (remaining_params == 0) {
-            CallMacroMethod(executing_macro, std::move(macro_params));
+            CallMacroMethod(executing_macro, macro_params.data(), macro_params.size());
+            macro_params.clear();
         }
         return;
     }
@@ -73,6 +124,7 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
     }
 
     regs.reg_array[method] = value;
+    dirty_flags.set(static_cast<size_t>(dirty_flag_table[method]));
 
     switch (method) {
     case MAXWELL3D_REG_INDEX(code_address.code_address_high):
@@ -126,6 +178,10 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
         DrawArrays();
         break;
     }
+    case MAXWELL3D_REG_INDEX(clear_buffers): {
+        ProcessClearBuffers();
+        break;
+    }
     case MAXWELL3D_REG_INDEX(query.query_get): {
         ProcessQueryGet();
         break;
@@ -134,24 +190,76 @@ void Maxwell3D::WriteReg(u32 method, u32 value, u32 remaining_params) {
         break;
     }
 
-    VideoCore::g_renderer->Rasterizer()->NotifyMaxwellRegisterChanged(method);
-
     if (debug_context) {
         debug_context->OnEvent(Tegra::DebugContext::Event::MaxwellCommandProcessed, nullptr);
     }
 }
 
+void Maxwell3D::WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing) {
+    if (count == 0) {
+        return;
+    }
+
+    // The debug context gets an event per register write, so it sees every value on its own.
+    if (Core::System::GetInstance().GetGPUDebugContext() == nullptr) {
+        if (!increasing && executing_macro != 0 && method == executing_macro + 1) {
+            // The parameters of the macro being called, which is run once the last one is in.
+            macro_params.insert(macro_params.end(), values, values + count);
+            CallMacroMethod(executing_macro, macro_params.data(), macro_params.size());
+            macro_params.clear();
+            return;
+        }
+
+        const u32 last_method = increasing ? method + count - 1 : method;
+        if (executing_macro == 0 && method >= MAXWELL3D_REG_INDEX(const_buffer.cb_data[0]) &&
+            last_method <= MAXWELL3D_REG_INDEX(const_buffer.cb_data[15])) {
+            ProcessCBDataBatch(values, count);
+            if (increasing) {
+                std::copy(values, values + count, regs.reg_array.begin() + method);
+            } else {
+                regs.reg_array[method] = values[count - 1];
+            }
+            return;
+        }
+    }
+
+    for (u32 i = 0; i < count; ++i) {
+        WriteReg(increasing ? method + i : method, values[i], count - i - 1);
+    }
+}
+
 void Maxwell3D::ProcessQueryGet() {
     GPUVAddr sequence_address = regs.query.QueryAddress();
     // Since the sequence address is given as a GPU VAddr, we have to convert it to an application
     // VAddr before writing.
     VAddr address = memory_manager.PhysicalToVirtualAddress(sequence_address);
 
-    switch (regs.query.query_get.mode) {
-    case Regs::QueryMode::Write: {
+    const auto& query_get = regs.query.query_get;
+    // Long reports are 16 bytes, the 64-bit value followed by a timestamp in nanoseconds
+    const bool long_report = query_get.short_query == 0;
+    const u64 timestamp = CoreTiming::GetGlobalTimeUs() * 1000;
+
+    switch (query_get.mode) {
+    case Regs::QueryMode::Write:
+    case Regs::QueryMode::Write2: {
+        if (query_get.select == Regs::QuerySelect::SamplesPassed &&
+            VideoCore::g_renderer->Rasterizer()->ReportSamplesPassed(address, long_report,
+                                                                     timestamp)) {
+            break;
+        }
+        if (query_get.select != Regs::QuerySelect::Zero) {
+            LOG_WARNING(HW_GPU, "Unimplemented query select %u, writing the sequence instead",
+                        static_cast<u32>(query_get.select.Value()));
+        }
+
         // Write the current query sequence to the sequence address.
-        u32 sequence = regs.query.query_sequence;
-        Memory::Write32(address, sequence);
+        const u32 sequence = regs.query.query_sequence;
+        if (long_report) {
+            Memory::Write64(address, sequence);
+            Memory::Write64(address + 8, timestamp);
+        } else {
+            Memory::Write32(address, sequence);
+        }
         break;
     }
     default:
@@ -165,6 +273,14 @@ void Maxwell3D::DrawArrays() {
               regs.vertex_buffer.count);
     ASSERT_MSG(!(regs.index_array.count && regs.vertex_buffer.count), "Both indexed and direct?");
 
+    if (regs.draw.instance_next) {
+        // Increment the current instance *before* drawing.
+        state.current_instance += 1;
+    } else if (!regs.draw.instance_cont) {
+        // Reset the current instance to 0.
+        state.current_instance = 0;
+    }
+
     auto debug_context = Core::System::GetInstance().GetGPUDebugContext();
 
     if (debug_context) {
@@ -179,6 +295,10 @@ void Maxwell3D::DrawArrays() {
     VideoCore::g_renderer->Rasterizer()->AccelerateDrawBatch(is_indexed);
 }
 
+void Maxwell3D::ProcessClearBuffers() {
+    VideoCore::g_renderer->Rasterizer()->Clear();
+}
+
 void Maxwell3D::ProcessCBBind(Regs::ShaderStage stage) {
     // Bind the buffer currently in CB_ADDRESS to the specified index in the desired shader stage.
     auto& shader = state.shader_stages[static_cast<size_t>(stage)];
@@ -209,14 +329,38 @@ void Maxwell3D::ProcessCBData(u32 value) {
     regs.const_buffer.cb_pos = regs.const_buffer.cb_pos + 4;
 }
 
-Texture::TICEntry Maxwell3D::GetTICEntry(u32 tic_index) const {
-    GPUVAddr tic_base_address = regs.tic.TICAddress();
+void Maxwell3D::ProcessCBDataBatch(const u32* values, u32 count) {
+    const GPUVAddr buffer_address = regs.const_buffer.BufferAddress();
+    ASSERT(buffer_address != 0);
+
+    // Don't allow writing past the end of the buffer.
+    ASSERT(regs.const_buffer.cb_pos + count * sizeof(u32) <= regs.const_buffer.cb_size);
+
+    // Consecutive GPU pages need not be mapped to consecutive application memory, so the values
+    // are written a contiguous range at a time.
+    const u8* data = reinterpret_cast<const u8*>(values);
+    const u64 size = count * sizeof(u32);
+    for (const auto& range :
+         memory_manager.GetMappedRanges(buffer_address + regs.const_buffer.cb_pos, size)) {
+        Memory::WriteBlock(range.cpu_addr, data, range.size);
+        data += range.size;
+    }
+    regs.const_buffer.cb_pos = static_cast<u32>(regs.const_buffer.cb_pos + size);
+}
 
-    GPUVAddr tic_address_gpu = tic_base_address + tic_index * sizeof(Texture::TICEntry);
-    VAddr tic_address_cpu = memory_manager.PhysicalToVirtualAddress(tic_address_gpu);
+VAddr Maxwell3D::GetTICEntryAddress(u32 tic_index) const {
+    const GPUVAddr tic_address_gpu = regs.tic.TICAddress() + tic_index * sizeof(Texture::TICEntry);
+    return memory_manager.PhysicalToVirtualAddress(tic_address_gpu);
+}
 
+VAddr Maxwell3D::GetTSCEntryAddress(u32 tsc_index) const {
+    const GPUVAddr tsc_address_gpu = regs.tsc.TSCAddress() + tsc_index * sizeof(Texture::TSCEntry);
+    return memory_manager.PhysicalToVirtualAddress(tsc_address_gpu);
+}
+
+Texture::TICEntry Maxwell3D::GetTICEntry(u32 tic_index) const {
     Texture::TICEntry tic_entry;
-    Memory::ReadBlock(tic_address_cpu, &tic_entry, sizeof(Texture::TICEntry));
+    Memory::ReadBlock(GetTICEntryAddress(tic_index), &tic_entry, sizeof(Texture::TICEntry));
 
     ASSERT_MSG(tic_entry.header_version == Texture::TICHeaderVersion::BlockLinear ||
                    tic_entry.header_version == Texture::TICHeaderVersion::Pitch,
@@ -240,62 +384,28 @@ Texture::TICEntry Maxwell3D::GetTICEntry(u32 tic_index) const {
 }
 
 Texture::TSCEntry Maxwell3D::GetTSCEntry(u32 tsc_index) const {
-    GPUVAddr tsc_base_address = regs.tsc.TSCAddress();
-
-    GPUVAddr tsc_address_gpu = tsc_base_address + tsc_index * sizeof(Texture::TSCEntry);
-    VAddr tsc_address_cpu = memory_manager.PhysicalToVirtualAddress(tsc_address_gpu);
-
     Texture::TSCEntry tsc_entry;
-    Memory::ReadBlock(tsc_address_cpu, &tsc_entry, sizeof(Texture::TSCEntry));
+    Memory::ReadBlock(GetTSCEntryAddress(tsc_index), &tsc_entry, sizeof(Texture::TSCEntry));
     return tsc_entry;
 }
 
-std::vector<Texture::FullTextureInfo> Maxwell3D::GetStageTextures(Regs::ShaderStage stage) const {
-    std::vector<Texture::FullTextureInfo> textures;
-
-    auto& fragment_shader = state.shader_stages[static_cast<size_t>(stage)];
-    auto& tex_info_buffer = fragment_shader.const_buffers[regs.tex_cb_index];
+Texture::TextureHandle Maxwell3D::GetStageTextureHandle(Regs::ShaderStage stage,
+                                                        size_t index) const {
+    auto& shader_stage = state.shader_stages[static_cast<size_t>(stage)];
+    auto& tex_info_buffer = shader_stage.const_buffers[regs.tex_cb_index];
     ASSERT(tex_info_buffer.enabled && tex_info_buffer.address != 0);
 
-    GPUVAddr tic_base_address = regs.tic.TICAddress();
-
-    GPUVAddr tex_info_buffer_end = tex_info_buffer.address + tex_info_buffer.size;
-
     // Offset into the texture constbuffer where the texture info begins.
     static constexpr size_t TextureInfoOffset = 0x20;
 
-    for (GPUVAddr current_texture = tex_info_buffer.address + TextureInfoOffset;
-         current_texture < tex_info_buffer_end; current_texture += sizeof(Texture::TextureHandle)) {
-
-        Texture::TextureHandle tex_handle{
-            Memory::Read32(memory_manager.PhysicalToVirtualAddress(current_texture))};
-
-        Texture::FullTextureInfo tex_info{};
-        // TODO(Subv): Use the shader to determine which textures are actually accessed.
-        tex_info.index = (current_texture - tex_info_buffer.address - TextureInfoOffset) /
-                         sizeof(Texture::TextureHandle);
-
-        // Load the TIC data.
-        if (tex_handle.tic_id != 0) {
-            tex_info.enabled = true;
-
-            auto tic_entry = GetTICEntry(tex_handle.tic_id);
-            // TODO(Subv): Workaround for BitField's move constructor being deleted.
-            std::memcpy(&tex_info.tic, &tic_entry, sizeof(tic_entry));
-        }
-
-        // Load the TSC data
-        if (tex_handle.tsc_id != 0) {
-            auto tsc_entry = GetTSCEntry(tex_handle.tsc_id);
-            // TODO(Subv): Workaround for BitField's move constructor being deleted.
-            std::memcpy(&tex_info.tsc, &tsc_entry, sizeof(tsc_entry));
-        }
-
-        if (tex_info.enabled)
-            textures.push_back(tex_info);
-    }
+    const GPUVAddr tex_info_address =
+        tex_info_buffer.address + TextureInfoOffset + index * sizeof(Texture::TextureHandle);
+    ASSERT(tex_info_address + sizeof(Texture::TextureHandle) <=
+           tex_info_buffer.address + tex_info_buffer.size);
 
-    return textures;
+    // Only the handle sampled by the shader is read, rather than every handle in the buffer.
+    return Texture::TextureHandle{
+        Memory::Read32(memory_manager.PhysicalToVirtualAddress(tex_info_address))};
 }
 
 u32 Maxwell3D::GetRegisterValue(u32 method) const {
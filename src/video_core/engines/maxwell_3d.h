@@ -5,6 +5,8 @@
 #pragma once
 
 #include <array>
+#include <bitset>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include "common/assert.h"
@@ -13,6 +15,7 @@
 #include "common/common_types.h"
 #include "common/math_util.h"
 #include "video_core/gpu.h"
+#include "video_core/macro_hle.h"
 #include "video_core/macro_interpreter.h"
 #include "video_core/memory_manager.h"
 #include "video_core/textures/texture.h"
@@ -46,6 +49,14 @@ public:
         enum class QueryMode : u32 {
             Write = 0,
             Sync = 1,
+            // Writes the report like Write, the difference with it is unknown
+            Write2 = 2,
+        };
+
+        /// Counter that a query reports.
+        enum class QuerySelect : u32 {
+            Zero = 0,
+            SamplesPassed = 21,
         };
 
         enum class ShaderProgram : u32 {
@@ -358,7 +369,16 @@ public:
                     u32 count;
                 } vertex_buffer;
 
-                INSERT_PADDING_WORDS(0x99);
+                INSERT_PADDING_WORDS(1);
+
+                float clear_color[4];
+                float clear_depth;
+
+                INSERT_PADDING_WORDS(0x3);
+
+                s32 clear_stencil;
+
+                INSERT_PADDING_WORDS(0x8F);
 
                 struct {
                     u32 address_high;
@@ -429,6 +449,10 @@ public:
                     union {
                         u32 vertex_begin_gl;
                         BitField<0, 16, PrimitiveTopology> topology;
+                        /// The draw is the next instance of the previous one.
+                        BitField<26, 1, u32> instance_next;
+                        /// The draw continues the instance of the previous one.
+                        BitField<27, 1, u32> instance_cont;
                     };
                 } draw;
 
@@ -466,7 +490,34 @@ public:
                     }
                 } index_array;
 
-                INSERT_PADDING_WORDS(0xC7);
+                INSERT_PADDING_WORDS(0x27);
+
+                struct {
+                    u32 is_instanced[NumVertexArrays];
+
+                    /// Returns whether the vertex array specified by index is supposed to be
+                    /// accessed per instance or not.
+                    bool IsInstancingEnabled(u32 index) const {
+                        return is_instanced[index] != 0;
+                    }
+                } instanced_arrays;
+
+                INSERT_PADDING_WORDS(0x34);
+
+                union {
+                    u32 raw;
+                    BitField<0, 1, u32> Z;
+                    BitField<1, 1, u32> S;
+                    BitField<2, 1, u32> R;
+                    BitField<3, 1, u32> G;
+                    BitField<4, 1, u32> B;
+                    BitField<5, 1, u32> A;
+                    /// Render target the color channels are cleared in.
+                    BitField<6, 4, u32> RT;
+                    BitField<10, 11, u32> layer;
+                } clear_buffers;
+
+                INSERT_PADDING_WORDS(0x4B);
 
                 struct {
                     u32 query_address_high;
@@ -477,6 +528,8 @@ public:
                         BitField<0, 2, QueryMode> mode;
                         BitField<4, 1, u32> fence;
                         BitField<12, 4, u32> unit;
+                        BitField<23, 5, QuerySelect> select;
+                        BitField<28, 1, u32> short_query;
                     } query_get;
 
                     GPUVAddr QueryAddress() const {
@@ -595,49 +648,113 @@ public:
         };
 
         std::array<ShaderStageInfo, Regs::MaxShaderStage> shader_stages;
+
+        /// Instance of the current draw. Guest instanced draws are issued as one draw per
+        /// instance, each one flagged as the next instance of the previous draw.
+        u32 current_instance = 0;
     };
 
     State state{};
     MemoryManager& memory_manager;
 
+    /// Groups of registers that the rasterizer derives host state from.
+    enum class DirtyFlag : u8 {
+        /// Registers that no host state is derived from.
+        None,
+        Viewport,
+        Blend,
+        NumFlags,
+    };
+
+    /// Returns whether a register of the group has been written since the flag was last cleared.
+    bool IsDirty(DirtyFlag flag) const {
+        return dirty_flags[static_cast<size_t>(flag)];
+    }
+
+    /// Clears the flag of a group, once the host state derived from it is in sync.
+    void ClearDirty(DirtyFlag flag) {
+        dirty_flags.reset(static_cast<size_t>(flag));
+    }
+
     /// Reads a register value located at the input method address
     u32 GetRegisterValue(u32 method) const;
 
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value, u32 remaining_params);
 
+    /**
+     * Writes a run of values from a command list, as if by a WriteReg call per value. Runs of
+     * const buffer data and of macro parameters are handled as a whole.
+     * @param method Register the first value is written to.
+     * @param values Values to write.
+     * @param count Number of values in the run, none of which remain after it.
+     * @param increasing Whether each value goes to the register after the previous one, instead of
+     * all of them going to the same register.
+     */
+    void WriteRegBatch(u32 method, const u32* values, u32 count, bool increasing);
+
     /// Uploads the code for a GPU macro program associated with the specified entry.
     void SubmitMacroCode(u32 entry, std::vector<u32> code);
 
-    /// Returns a list of enabled textures for the specified shader stage.
-    std::vector<Texture::FullTextureInfo> GetStageTextures(Regs::ShaderStage stage) const;
+    /**
+     * Returns the texture handle of a shader stage bound to a texture handle slot.
+     * @param stage The shader stage.
+     * @param index Index of the texture handle in the texture const buffer, as sampled by the
+     * shader.
+     * @returns The handle, whose TIC and TSC indices are 0 when it refers to no entry.
+     */
+    Texture::TextureHandle GetStageTextureHandle(Regs::ShaderStage stage, size_t index) const;
+
+    /// Returns the address in application memory of a specific TIC entry of the TIC buffer.
+    VAddr GetTICEntryAddress(u32 tic_index) const;
+
+    /// Returns the address in application memory of a specific TSC entry of the TSC buffer.
+    VAddr GetTSCEntryAddress(u32 tsc_index) const;
+
+    /// Retrieves information about a specific TIC entry from the TIC buffer.
+    Texture::TICEntry GetTICEntry(u32 tic_index) const;
+
+    /// Retrieves information about a specific TSC entry from the TSC buffer.
+    Texture::TSCEntry GetTSCEntry(u32 tsc_index) const;
 
     /// Returns whether the specified shader stage is enabled or not.
     bool IsShaderStageEnabled(Regs::ShaderStage stage) const;
 
 private:
+    /// Group of every register, built from the register offsets.
+    std::array<DirtyFlag, Regs::NUM_REGS> dirty_flag_table{};
+    /// Groups written since they were last synced. Everything starts out dirty.
+    std::bitset<static_cast<size_t>(DirtyFlag::NumFlags)> dirty_flags;
+
     std::unordered_map<u32, std::vector<u32>> uploaded_macros;
 
+    /// Native implementations of the uploaded macros that have one.
+    std::unordered_map<u32, HLEMacroFunction> hle_macros;
+
+    /// Decoded programs of the uploaded macros, for those that could be decoded.
+    std::unordered_map<u32, std::shared_ptr<const MacroInterpreter::Program>> compiled_macros;
+    /// Decoded programs by the hash of the code they were decoded from. Games upload the same
+    /// macros again, and those are only decoded once.
+    std::unordered_map<u64, std::shared_ptr<const MacroInterpreter::Program>> macro_cache;
+
     /// Macro method that is currently being executed / being fed parameters.
     u32 executing_macro = 0;
-    /// Parameters that have been submitted to the macro call so far.
+    /// Parameters that have been submitted to the macro call so far. The buffer is reused by
+    /// every call, so that calls don't allocate.
     std::vector<u32> macro_params;
+    /// Whether a macro is running, as the parameter buffer can't take another call meanwhile.
+    bool macro_running = false;
 
     /// Interpreter for the macro codes uploaded to the GPU.
     MacroInterpreter macro_interpreter;
 
-    /// Retrieves information about a specific TIC entry from the TIC buffer.
-    Texture::TICEntry GetTICEntry(u32 tic_index) const;
-
-    /// Retrieves information about a specific TSC entry from the TSC buffer.
-    Texture::TSCEntry GetTSCEntry(u32 tsc_index) const;
-
     /**
      * Call a macro on this engine.
      * @param method Method to call
-     * @param parameters Arguments to the method call
+     * @param parameters Arguments to the method call, which are only read during the call
+     * @param num_parameters Number of arguments
      */
-    void CallMacroMethod(u32 method, std::vector<u32> parameters);
+    void CallMacroMethod(u32 method, const u32* parameters, size_t num_parameters);
 
     /// Handles a write to the QUERY_GET register.
     void ProcessQueryGet();
@@ -645,11 +762,17 @@ private:
     /// Handles a write to the CB_DATA[i] register.
     void ProcessCBData(u32 value);
 
+    /// Handles a run of writes to the CB_DATA[i] registers, uploading the values in one go.
+    void ProcessCBDataBatch(const u32* values, u32 count);
+
     /// Handles a write to the CB_BIND register.
     void ProcessCBBind(Regs::ShaderStage stage);
 
     /// Handles a write to the VERTEX_END_GL register, triggering a draw.
     void DrawArrays();
+
+    /// Handles a write to the CLEAR_BUFFERS register.
+    void ProcessClearBuffers();
 };
 
 #define ASSERT_REG_POSITION(field_name, position)                                                  \
@@ -660,6 +783,9 @@ ASSERT_REG_POSITION(rt, 0x200);
 ASSERT_REG_POSITION(viewport_transform[0], 0x280);
 ASSERT_REG_POSITION(viewport, 0x300);
 ASSERT_REG_POSITION(vertex_buffer, 0x35D);
+ASSERT_REG_POSITION(clear_color[0], 0x360);
+ASSERT_REG_POSITION(clear_depth, 0x364);
+ASSERT_REG_POSITION(clear_stencil, 0x368);
 ASSERT_REG_POSITION(zeta, 0x3F8);
 ASSERT_REG_POSITION(vertex_attrib_format[0], 0x458);
 ASSERT_REG_POSITION(rt_control, 0x487);
@@ -668,6 +794,8 @@ ASSERT_REG_POSITION(tic, 0x55D);
 ASSERT_REG_POSITION(code_address, 0x582);
 ASSERT_REG_POSITION(draw, 0x585);
 ASSERT_REG_POSITION(index_array, 0x5F2);
+ASSERT_REG_POSITION(instanced_arrays, 0x620);
+ASSERT_REG_POSITION(clear_buffers, 0x674);
 ASSERT_REG_POSITION(query, 0x6C0);
 ASSERT_REG_POSITION(vertex_array[0], 0x700);
 ASSERT_REG_POSITION(blend, 0x780);
@@ -2,12 +2,53 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/memory.h"
 #include "video_core/engines/maxwell_compute.h"
 
 namespace Tegra {
 namespace Engines {
 
-void MaxwellCompute::WriteReg(u32 method, u32 value) {}
+MaxwellCompute::MaxwellCompute(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
+
+void MaxwellCompute::WriteReg(u32 method, u32 value) {
+    ASSERT_MSG(method < Regs::NUM_REGS,
+               "Invalid MaxwellCompute register, increase the size of the Regs structure");
+
+    regs.reg_array[method] = value;
+
+    switch (method) {
+    case MAXWELLCOMPUTE_REG_INDEX(launch): {
+        ProcessLaunch();
+        break;
+    }
+    }
+}
+
+void MaxwellCompute::ProcessLaunch() {
+    const VAddr launch_desc_address =
+        memory_manager.PhysicalToVirtualAddress(regs.launch_desc_loc.Address());
+
+    LaunchParams launch_description;
+    Memory::ReadBlock(launch_desc_address, &launch_description, sizeof(LaunchParams));
+
+    const GPUVAddr program_address = regs.code_loc.Address() + launch_description.program_start;
+
+    LOG_DEBUG(HW_GPU,
+              "Skipped compute dispatch of program %016" PRIX64 " with %ux%ux%u groups of "
+              "%ux%ux%u threads",
+              program_address, launch_description.grid_dim_x.Value(),
+              launch_description.grid_dim_y.Value(), launch_description.grid_dim_z.Value(),
+              launch_description.block_dim_x.Value(), launch_description.block_dim_y.Value(),
+              launch_description.block_dim_z.Value());
+
+    if (!reported_skipped_dispatch) {
+        LOG_WARNING(HW_GPU, "Compute dispatches aren't run, the work they do will be missing");
+        reported_skipped_dispatch = true;
+    }
+}
 
 } // namespace Engines
 } // namespace Tegra
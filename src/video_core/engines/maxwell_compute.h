@@ -4,19 +4,171 @@
 
 #pragma once
 
+#include <array>
+#include "common/assert.h"
+#include "common/bit_field.h"
+#include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "video_core/gpu.h"
+#include "video_core/memory_manager.h"
 
 namespace Tegra {
 namespace Engines {
 
+#define MAXWELLCOMPUTE_REG_INDEX(field_name)                                                       \
+    (offsetof(Tegra::Engines::MaxwellCompute::Regs, field_name) / sizeof(u32))
+
+/**
+ * Compute engine. Launches are decoded, but their programs aren't run: the shader decompiler only
+ * translates the graphics stages, and has none of the thread ids, shared memory, barriers and
+ * global memory accesses that compute programs are made of, which a GL compute path would first
+ * need. Skipped dispatches are logged at debug level, after a single warning.
+ */
 class MaxwellCompute final {
 public:
-    MaxwellCompute() = default;
+    explicit MaxwellCompute(MemoryManager& memory_manager);
     ~MaxwellCompute() = default;
 
     /// Write the value to the register identified by method.
     void WriteReg(u32 method, u32 value);
+
+    struct Regs {
+        static constexpr size_t NUM_REGS = 0xCF8;
+
+        union {
+            struct {
+                INSERT_PADDING_WORDS(0xAD);
+
+                struct {
+                    u32 address;
+
+                    GPUVAddr Address() const {
+                        // The descriptor is 256 byte aligned, and its address is given shifted.
+                        return static_cast<GPUVAddr>(address) << 8;
+                    }
+                } launch_desc_loc;
+
+                INSERT_PADDING_WORDS(0x1);
+
+                u32 launch;
+
+                INSERT_PADDING_WORDS(0x4D2);
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } code_loc;
+
+                INSERT_PADDING_WORDS(0x774);
+            };
+            std::array<u32, NUM_REGS> reg_array;
+        };
+    } regs{};
+
+    /// Launch descriptor of a dispatch, read from memory when the dispatch is launched.
+    struct LaunchParams {
+        static constexpr size_t NumConstBuffers = 8;
+
+        INSERT_PADDING_WORDS(0x8);
+
+        /// Offset of the program from the code address.
+        u32 program_start;
+
+        INSERT_PADDING_WORDS(0x2);
+
+        BitField<30, 1, u32> linked_tsc;
+
+        BitField<0, 31, u32> grid_dim_x;
+        union {
+            BitField<0, 16, u32> grid_dim_y;
+            BitField<16, 16, u32> grid_dim_z;
+        };
+
+        INSERT_PADDING_WORDS(0x3);
+
+        BitField<0, 18, u32> shared_alloc;
+
+        BitField<16, 16, u32> block_dim_x;
+        union {
+            BitField<0, 16, u32> block_dim_y;
+            BitField<16, 16, u32> block_dim_z;
+        };
+
+        union {
+            BitField<0, 8, u32> const_buffer_enable_mask;
+            BitField<29, 2, u32> cache_layout;
+        } memory_config;
+
+        INSERT_PADDING_WORDS(0x8);
+
+        struct {
+            u32 address_low;
+            union {
+                BitField<0, 8, u32> address_high;
+                BitField<15, 17, u32> size;
+            };
+
+            GPUVAddr Address() const {
+                return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                             address_low);
+            }
+        } const_buffer_config[NumConstBuffers];
+
+        union {
+            BitField<0, 20, u32> local_pos_alloc;
+            BitField<27, 5, u32> barrier_alloc;
+        };
+
+        union {
+            BitField<0, 20, u32> local_neg_alloc;
+            BitField<24, 5, u32> gpr_alloc;
+        };
+
+        INSERT_PADDING_WORDS(0x11);
+    };
+    static_assert(sizeof(LaunchParams) == 0x40 * sizeof(u32), "LaunchParams has wrong size");
+
+private:
+    MemoryManager& memory_manager;
+
+    /// Whether the warning about the dispatches being skipped was logged already.
+    bool reported_skipped_dispatch = false;
+
+    /// Handles a write to the LAUNCH register, decoding the launch descriptor of the dispatch.
+    void ProcessLaunch();
 };
 
+#define ASSERT_REG_POSITION(field_name, position)                                                  \
+    static_assert(offsetof(MaxwellCompute::Regs, field_name) == position * 4,                      \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_REG_POSITION(launch_desc_loc, 0xAD);
+ASSERT_REG_POSITION(launch, 0xAF);
+ASSERT_REG_POSITION(code_loc, 0x582);
+
+#undef ASSERT_REG_POSITION
+
+#define ASSERT_LAUNCH_PARAM_POSITION(field_name, position)                                         \
+    static_assert(offsetof(MaxwellCompute::LaunchParams, field_name) == position * 4,              \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_LAUNCH_PARAM_POSITION(program_start, 0x8);
+ASSERT_LAUNCH_PARAM_POSITION(grid_dim_x, 0xC);
+ASSERT_LAUNCH_PARAM_POSITION(shared_alloc, 0x11);
+ASSERT_LAUNCH_PARAM_POSITION(block_dim_x, 0x12);
+ASSERT_LAUNCH_PARAM_POSITION(memory_config, 0x14);
+ASSERT_LAUNCH_PARAM_POSITION(const_buffer_config, 0x1D);
+ASSERT_LAUNCH_PARAM_POSITION(gpr_alloc, 0x2E);
+
+#undef ASSERT_LAUNCH_PARAM_POSITION
+
+static_assert(sizeof(MaxwellCompute::Regs) == MaxwellCompute::Regs::NUM_REGS * sizeof(u32),
+              "MaxwellCompute Regs has wrong size");
+
 } // namespace Engines
 } // namespace Tegra
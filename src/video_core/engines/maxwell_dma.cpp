@@ -0,0 +1,294 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/core_timing.h"
+#include "core/memory.h"
+#include "video_core/engines/maxwell_dma.h"
+#include "video_core/textures/decoders.h"
+
+namespace Tegra {
+namespace Engines {
+
+MaxwellDMA::MaxwellDMA(MemoryManager& memory_manager) : memory_manager(memory_manager) {}
+
+void MaxwellDMA::WriteReg(u32 method, u32 value) {
+    ASSERT_MSG(method < Regs::NUM_REGS,
+               "Invalid MaxwellDMA register, increase the size of the Regs structure");
+
+    regs.reg_array[method] = value;
+
+    switch (method) {
+    case MAXWELLDMA_REG_INDEX(exec): {
+        HandleCopy();
+        break;
+    }
+    }
+}
+
+void MaxwellDMA::HandleCopy() {
+    const GPUVAddr source = regs.src_address.Address();
+    const GPUVAddr dest = regs.dst_address.Address();
+
+    const VAddr source_cpu = memory_manager.PhysicalToVirtualAddress(source);
+    const VAddr dest_cpu = memory_manager.PhysicalToVirtualAddress(dest);
+
+    // The copy mode only tells whether the copy may overlap the work before it, and the copies
+    // are done in order here. The copies go through the Memory block functions, which flush the
+    // rasterizer's surfaces overlapping the source before reading it, and invalidate those
+    // overlapping the destination.
+
+    if (regs.exec.enable_swizzle) {
+        if (regs.exec.is_src_linear && regs.exec.is_dst_linear) {
+            CopyRemapped(source_cpu, dest_cpu);
+        } else {
+            LOG_ERROR(HW_GPU, "Unimplemented remapped copy of block linear memory, skipping it");
+        }
+    } else if (!regs.exec.enable_2d) {
+        // When the enable_2d bit is disabled, the copy is performed as if we were copying a 1D
+        // resource.
+        Memory::CopyBlock(dest_cpu, source_cpu, regs.x_count);
+    } else if (regs.exec.is_src_linear && regs.exec.is_dst_linear) {
+        if (regs.src_pitch == regs.x_count && regs.dst_pitch == regs.x_count) {
+            // Tightly packed rows are a single block copy.
+            const size_t copy_size = static_cast<size_t>(regs.x_count) * regs.y_count;
+            Memory::CopyBlock(dest_cpu, source_cpu, copy_size);
+        } else {
+            for (u32 row = 0; row < regs.y_count; ++row) {
+                Memory::CopyBlock(dest_cpu + static_cast<u64>(row) * regs.dst_pitch,
+                                  source_cpu + static_cast<u64>(row) * regs.src_pitch,
+                                  regs.x_count);
+            }
+        }
+    } else {
+        CopyBlockLinear(source_cpu, dest_cpu);
+    }
+
+    // The query is released even when the copy was skipped, so that the guest waiting for it
+    // doesn't hang.
+    ReleaseQuery();
+}
+
+/// Reads rows that are pitch bytes apart in memory into a buffer of tightly packed rows.
+static void ReadRows(VAddr address, u32 pitch, u32 row_size, u32 rows, u8* buffer) {
+    if (pitch == row_size) {
+        Memory::ReadBlock(address, buffer, static_cast<size_t>(row_size) * rows);
+        return;
+    }
+    for (u32 row = 0; row < rows; ++row) {
+        Memory::ReadBlock(address + static_cast<u64>(row) * pitch,
+                          buffer + static_cast<size_t>(row) * row_size, row_size);
+    }
+}
+
+/// Writes a buffer of tightly packed rows to rows that are pitch bytes apart in memory.
+static void WriteRows(VAddr address, u32 pitch, u32 row_size, u32 rows, const u8* buffer) {
+    if (pitch == row_size) {
+        Memory::WriteBlock(address, buffer, static_cast<size_t>(row_size) * rows);
+        return;
+    }
+    for (u32 row = 0; row < rows; ++row) {
+        Memory::WriteBlock(address + static_cast<u64>(row) * pitch,
+                           buffer + static_cast<size_t>(row) * row_size, row_size);
+    }
+}
+
+/// Returns the size of a slice of a block linear image, treated as bytes.
+static u32 GetSliceSize(const MaxwellDMA::Regs::Parameters& params) {
+    return Texture::GetSwizzledSize(params.size_x, params.size_y, 1, params.BlockHeight());
+}
+
+/// Checks that a region of width bytes by height rows at the position of a block linear image
+/// fits in it, and that the layout of the image is supported.
+static bool IsRegionSupported(const MaxwellDMA::Regs::Parameters& params, u32 width, u32 height) {
+    // Blocks more than one slice deep lay out the slices of a block together.
+    if (params.block_depth != 0 && params.size_z > 1) {
+        LOG_ERROR(HW_GPU, "Unimplemented copy with blocks %u slices deep, skipping it",
+                  1u << params.block_depth);
+        return false;
+    }
+    if (static_cast<u64>(params.pos_x) + width > params.size_x ||
+        static_cast<u64>(params.pos_y) + height > params.size_y ||
+        params.pos_z >= std::max(params.size_z, 1u)) {
+        LOG_ERROR(HW_GPU,
+                  "Copy of %ux%u bytes at (%u, %u, %u) doesn't fit in the %ux%ux%u image, "
+                  "skipping it",
+                  width, height, static_cast<u32>(params.pos_x), static_cast<u32>(params.pos_y),
+                  params.pos_z, params.size_x, params.size_y, params.size_z);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Copies a region of width bytes by height rows, at the position of a block linear image, to or
+ * from a buffer of tightly packed rows.
+ * @param params Parameters of the image.
+ * @param swizzled The slice of the image the region is in.
+ * @param linear The buffer of packed rows.
+ * @param unswizzle Whether to copy from the image to the buffer, or the other way.
+ */
+static void CopyRegion(const MaxwellDMA::Regs::Parameters& params, u32 width, u32 height,
+                       u8* swizzled, u8* linear, bool unswizzle) {
+    const u32 block_height = params.BlockHeight();
+    if (params.pos_x == 0 && params.pos_y == 0 && width == params.size_x &&
+        height == params.size_y) {
+        // The decoders move the whole image 16 bytes at a time.
+        Texture::CopySwizzledData(width, height, 1, 1, swizzled, linear, unswizzle, block_height);
+        return;
+    }
+
+    // Each run of 16 bytes of a GOB row is contiguous.
+    for (u32 row = 0; row < height; ++row) {
+        u8* const line = linear + static_cast<size_t>(row) * width;
+        for (u32 x = 0; x < width;) {
+            const u32 image_x = params.pos_x + x;
+            const u32 run = std::min(width - x, 16 - image_x % 16);
+            u8* const block_data =
+                swizzled + Texture::GetSwizzleOffset(image_x, params.pos_y + row, params.size_x,
+                                                     1, block_height);
+            if (unswizzle) {
+                std::memcpy(line + x, block_data, run);
+            } else {
+                std::memcpy(block_data, line + x, run);
+            }
+            x += run;
+        }
+    }
+}
+
+void MaxwellDMA::CopyBlockLinear(VAddr source, VAddr dest) {
+    // Copies of block linear memory treat the images as bytes.
+    const u32 width = regs.x_count;
+    const u32 height = regs.y_count;
+    const Regs::Parameters& src_params = regs.src_params;
+    const Regs::Parameters& dst_params = regs.dst_params;
+    if ((!regs.exec.is_src_linear && !IsRegionSupported(src_params, width, height)) ||
+        (!regs.exec.is_dst_linear && !IsRegionSupported(dst_params, width, height))) {
+        return;
+    }
+
+    if (!regs.exec.is_src_linear && !regs.exec.is_dst_linear) {
+        const bool same_layout = src_params.block_height == dst_params.block_height &&
+                                 src_params.size_x == dst_params.size_x &&
+                                 src_params.size_y == dst_params.size_y;
+        const bool whole_slice = src_params.pos_x == 0 && src_params.pos_y == 0 &&
+                                 dst_params.pos_x == 0 && dst_params.pos_y == 0 &&
+                                 width == src_params.size_x && height == src_params.size_y;
+        if (same_layout && whole_slice) {
+            // Whole slices with the same layout on both sides are a single block copy.
+            const u32 slice_size = GetSliceSize(src_params);
+            Memory::CopyBlock(dest + static_cast<u64>(dst_params.pos_z) * slice_size,
+                              source + static_cast<u64>(src_params.pos_z) * slice_size,
+                              slice_size);
+            return;
+        }
+    }
+
+    // The region goes through a buffer of packed rows, and the slices of the block linear images
+    // it is in are staged whole. The parts of the destination slice outside of the region are
+    // written back as they were.
+    linear_buffer.resize(static_cast<size_t>(width) * height);
+    if (regs.exec.is_src_linear) {
+        ReadRows(source, regs.src_pitch, width, height, linear_buffer.data());
+    } else {
+        const u32 slice_size = GetSliceSize(src_params);
+        swizzled_buffer.resize(slice_size);
+        Memory::ReadBlock(source + static_cast<u64>(src_params.pos_z) * slice_size,
+                          swizzled_buffer.data(), slice_size);
+        CopyRegion(src_params, width, height, swizzled_buffer.data(), linear_buffer.data(), true);
+    }
+
+    if (regs.exec.is_dst_linear) {
+        WriteRows(dest, regs.dst_pitch, width, height, linear_buffer.data());
+    } else {
+        const u32 slice_size = GetSliceSize(dst_params);
+        const VAddr slice = dest + static_cast<u64>(dst_params.pos_z) * slice_size;
+        swizzled_buffer.resize(slice_size);
+        Memory::ReadBlock(slice, swizzled_buffer.data(), slice_size);
+        CopyRegion(dst_params, width, height, swizzled_buffer.data(), linear_buffer.data(), false);
+        Memory::WriteBlock(slice, swizzled_buffer.data(), slice_size);
+    }
+}
+
+void MaxwellDMA::CopyRemapped(VAddr source, VAddr dest) {
+    // The counts are in elements, each made of up to 4 components on both sides.
+    const auto& remap = regs.remap;
+    const u32 component_size = remap.ComponentSize();
+    const u32 src_element_size = remap.SrcElementSize();
+    const u32 dst_element_size = remap.DstElementSize();
+    const u32 num_src_components = remap.num_src_components_minus_one + 1;
+    const u32 num_dst_components = remap.num_dst_components_minus_one + 1;
+    const u32 rows = regs.exec.enable_2d ? regs.y_count : 1;
+    const u32 src_row_size = regs.x_count * src_element_size;
+    const u32 dst_row_size = regs.x_count * dst_element_size;
+    const u32 src_pitch = regs.exec.enable_2d ? regs.src_pitch : src_row_size;
+    const u32 dst_pitch = regs.exec.enable_2d ? regs.dst_pitch : dst_row_size;
+
+    linear_buffer.resize(static_cast<size_t>(src_row_size) * rows);
+    remapped_buffer.resize(static_cast<size_t>(dst_row_size) * rows);
+    ReadRows(source, src_pitch, src_row_size, rows, linear_buffer.data());
+    // The components that aren't written keep what the destination held.
+    ReadRows(dest, dst_pitch, dst_row_size, rows, remapped_buffer.data());
+
+    const std::array<Regs::RemapSource, 4> sources{remap.dst_x, remap.dst_y, remap.dst_z,
+                                                   remap.dst_w};
+    const size_t num_elements = static_cast<size_t>(regs.x_count) * rows;
+    for (size_t element = 0; element < num_elements; ++element) {
+        const u8* const src = linear_buffer.data() + element * src_element_size;
+        u8* dst = remapped_buffer.data() + element * dst_element_size;
+        for (u32 component = 0; component < num_dst_components; ++component) {
+            const Regs::RemapSource remap_source = sources[component];
+            const u32 src_component = static_cast<u32>(remap_source);
+            switch (remap_source) {
+            case Regs::RemapSource::ConstA:
+                std::memcpy(dst, &remap.const_a, component_size);
+                break;
+            case Regs::RemapSource::ConstB:
+                std::memcpy(dst, &remap.const_b, component_size);
+                break;
+            case Regs::RemapSource::NoWrite:
+                break;
+            default:
+                if (src_component < num_src_components) {
+                    std::memcpy(dst, src + src_component * component_size, component_size);
+                }
+                break;
+            }
+            dst += component_size;
+        }
+    }
+
+    WriteRows(dest, dst_pitch, dst_row_size, rows, remapped_buffer.data());
+}
+
+void MaxwellDMA::ReleaseQuery() {
+    // Interrupts aren't delivered, the guest finds out the copy is done from the query instead.
+    if (regs.exec.query_mode == Regs::QueryMode::None) {
+        return;
+    }
+
+    const VAddr address = memory_manager.PhysicalToVirtualAddress(regs.query_address.Address());
+    switch (regs.exec.query_mode) {
+    case Regs::QueryMode::Short:
+        Memory::Write32(address, regs.query_payload);
+        break;
+    case Regs::QueryMode::Long:
+        // Long queries are 16 bytes, the payload followed by a timestamp in nanoseconds
+        Memory::Write64(address, regs.query_payload);
+        Memory::Write64(address + 8, CoreTiming::GetGlobalTimeUs() * 1000);
+        break;
+    default:
+        LOG_ERROR(HW_GPU, "Unimplemented query mode %u",
+                  static_cast<u32>(regs.exec.query_mode.Value()));
+        break;
+    }
+}
+
+} // namespace Engines
+} // namespace Tegra
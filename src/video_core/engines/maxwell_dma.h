@@ -0,0 +1,229 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <vector>
+#include "common/assert.h"
+#include "common/bit_field.h"
+#include "common/common_funcs.h"
+#include "common/common_types.h"
+#include "video_core/gpu.h"
+#include "video_core/memory_manager.h"
+
+namespace Tegra {
+namespace Engines {
+
+#define MAXWELLDMA_REG_INDEX(field_name)                                                           \
+    (offsetof(Tegra::Engines::MaxwellDMA::Regs, field_name) / sizeof(u32))
+
+class MaxwellDMA final {
+public:
+    explicit MaxwellDMA(MemoryManager& memory_manager);
+    ~MaxwellDMA() = default;
+
+    /// Write the value to the register identified by method.
+    void WriteReg(u32 method, u32 value);
+
+    struct Regs {
+        static constexpr size_t NUM_REGS = 0x1D6;
+
+        struct Parameters {
+            union {
+                BitField<0, 4, u32> block_depth;
+                BitField<4, 4, u32> block_height;
+                BitField<8, 4, u32> block_width;
+            };
+            u32 size_x;
+            u32 size_y;
+            u32 size_z;
+            u32 pos_z;
+            union {
+                BitField<0, 16, u32> pos_x;
+                BitField<16, 16, u32> pos_y;
+            };
+
+            u32 BlockHeight() const {
+                // The block height is stored in log2 format.
+                return 1 << block_height;
+            }
+        };
+        static_assert(sizeof(Parameters) == 24, "Parameters has wrong size");
+
+        enum class CopyMode : u32 {
+            None = 0,
+            Unk1 = 1,
+            Unk2 = 2,
+        };
+
+        enum class QueryMode : u32 {
+            None = 0,
+            Short = 1,
+            Long = 2,
+        };
+
+        enum class QueryIntr : u32 {
+            None = 0,
+            Block = 1,
+            NonBlock = 2,
+        };
+
+        /// Where each component of a remapped element is taken from.
+        enum class RemapSource : u32 {
+            SrcX = 0,
+            SrcY = 1,
+            SrcZ = 2,
+            SrcW = 3,
+            ConstA = 4,
+            ConstB = 5,
+            NoWrite = 6,
+        };
+
+        union {
+            struct {
+                INSERT_PADDING_WORDS(0x90);
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } query_address;
+
+                u32 query_payload;
+
+                INSERT_PADDING_WORDS(0x2D);
+
+                struct {
+                    union {
+                        BitField<0, 2, CopyMode> copy_mode;
+                        BitField<2, 1, u32> flush;
+
+                        BitField<3, 2, QueryMode> query_mode;
+                        BitField<5, 2, QueryIntr> query_intr;
+
+                        BitField<7, 1, u32> is_src_linear;
+                        BitField<8, 1, u32> is_dst_linear;
+
+                        BitField<9, 1, u32> enable_2d;
+                        BitField<10, 1, u32> enable_swizzle;
+                    };
+                } exec;
+
+                INSERT_PADDING_WORDS(0x3F);
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } src_address;
+
+                struct {
+                    u32 address_high;
+                    u32 address_low;
+
+                    GPUVAddr Address() const {
+                        return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) |
+                                                     address_low);
+                    }
+                } dst_address;
+
+                u32 src_pitch;
+                u32 dst_pitch;
+                u32 x_count;
+                u32 y_count;
+
+                INSERT_PADDING_WORDS(0xB8);
+
+                struct {
+                    u32 const_a;
+                    u32 const_b;
+                    union {
+                        BitField<0, 3, RemapSource> dst_x;
+                        BitField<4, 3, RemapSource> dst_y;
+                        BitField<8, 3, RemapSource> dst_z;
+                        BitField<12, 3, RemapSource> dst_w;
+                        BitField<16, 2, u32> component_size_minus_one;
+                        BitField<20, 2, u32> num_src_components_minus_one;
+                        BitField<24, 2, u32> num_dst_components_minus_one;
+                    };
+
+                    u32 ComponentSize() const {
+                        return component_size_minus_one + 1;
+                    }
+                    u32 SrcElementSize() const {
+                        return ComponentSize() * (num_src_components_minus_one + 1);
+                    }
+                    u32 DstElementSize() const {
+                        return ComponentSize() * (num_dst_components_minus_one + 1);
+                    }
+                } remap;
+
+                Parameters dst_params;
+
+                INSERT_PADDING_WORDS(1);
+
+                Parameters src_params;
+
+                INSERT_PADDING_WORDS(0x6);
+            };
+            std::array<u32, NUM_REGS> reg_array;
+        };
+    } regs{};
+
+private:
+    MemoryManager& memory_manager;
+
+    /// Staging buffers for copies that don't go straight from memory to memory, reused by every
+    /// copy.
+    std::vector<u8> swizzled_buffer;
+    std::vector<u8> linear_buffer;
+    std::vector<u8> remapped_buffer;
+
+    /// Performs the copy from the source buffer to the destination buffer as configured in the
+    /// registers.
+    void HandleCopy();
+
+    /// Copies between linear memory and block linear memory, or between two block linear images.
+    void CopyBlockLinear(VAddr source, VAddr dest);
+
+    /// Copies between linear memory, rearranging the components of each element.
+    void CopyRemapped(VAddr source, VAddr dest);
+
+    /// Writes the query payload to the query address, if the copy asked for it.
+    void ReleaseQuery();
+};
+
+#define ASSERT_REG_POSITION(field_name, position)                                                  \
+    static_assert(offsetof(MaxwellDMA::Regs, field_name) == position * 4,                          \
+                  "Field " #field_name " has invalid position")
+
+ASSERT_REG_POSITION(query_address, 0x90);
+ASSERT_REG_POSITION(query_payload, 0x92);
+ASSERT_REG_POSITION(exec, 0xC0);
+ASSERT_REG_POSITION(src_address, 0x100);
+ASSERT_REG_POSITION(dst_address, 0x102);
+ASSERT_REG_POSITION(src_pitch, 0x104);
+ASSERT_REG_POSITION(dst_pitch, 0x105);
+ASSERT_REG_POSITION(x_count, 0x106);
+ASSERT_REG_POSITION(y_count, 0x107);
+ASSERT_REG_POSITION(remap, 0x1C0);
+ASSERT_REG_POSITION(dst_params, 0x1C3);
+ASSERT_REG_POSITION(src_params, 0x1CA);
+
+#undef ASSERT_REG_POSITION
+
+static_assert(sizeof(MaxwellDMA::Regs) == MaxwellDMA::Regs::NUM_REGS * sizeof(u32),
+              "MaxwellDMA Regs has wrong size");
+
+} // namespace Engines
+} // namespace Tegra
@@ -2,24 +2,230 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <type_traits>
+#include <utility>
+#include "common/assert.h"
+#include "common/content_hash.h"
+#include "core/memory.h"
+#include "core/tracer/recorder.h"
 #include "video_core/engines/fermi_2d.h"
+#include "video_core/engines/kepler_memory.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/engines/maxwell_compute.h"
+#include "video_core/engines/maxwell_dma.h"
 #include "video_core/gpu.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
 namespace Tegra {
 
+u32 RenderTargetBytesPerPixel(RenderTargetFormat format) {
+    ASSERT(format != RenderTargetFormat::NONE);
+
+    switch (format) {
+    case RenderTargetFormat::RGBA16_FLOAT:
+        return 8;
+    case RenderTargetFormat::RGB10_A2_UNORM:
+    case RenderTargetFormat::RGBA8_UNORM:
+    case RenderTargetFormat::RGBA8_SRGB:
+        return 4;
+    default:
+        UNIMPLEMENTED_MSG("Unimplemented render target format %u", static_cast<u32>(format));
+        return 0;
+    }
+}
+
 GPU::GPU() {
     memory_manager = std::make_unique<MemoryManager>();
     maxwell_3d = std::make_unique<Engines::Maxwell3D>(*memory_manager);
-    fermi_2d = std::make_unique<Engines::Fermi2D>();
-    maxwell_compute = std::make_unique<Engines::MaxwellCompute>();
+    fermi_2d = std::make_unique<Engines::Fermi2D>(*memory_manager);
+    maxwell_compute = std::make_unique<Engines::MaxwellCompute>(*memory_manager);
+    maxwell_dma = std::make_unique<Engines::MaxwellDMA>(*memory_manager);
+    kepler_memory = std::make_unique<Engines::KeplerMemory>(*memory_manager);
 }
 
-GPU::~GPU() = default;
+GPU::~GPU() {
+    StopThread();
+}
 
 const Tegra::Engines::Maxwell3D& GPU::Get3DEngine() const {
     return *maxwell_3d;
 }
 
+void GPU::StartThread(RendererBase& renderer, EmuWindow& emu_window) {
+    gpu_thread =
+        std::make_unique<VideoCommon::GPUThread::ThreadManager>(renderer, emu_window, *this);
+}
+
+void GPU::StopThread() {
+    gpu_thread.reset();
+}
+
+bool GPU::IsGPUThread() const {
+    return gpu_thread != nullptr && gpu_thread->IsGPUThread();
+}
+
+void GPU::StartTrace() {
+    // The 3D engine registers are the starting point the command lists are replayed from.
+    CiTrace::Recorder::InitialState initial_state;
+    initial_state.gpu_registers.assign(maxwell_3d->regs.reg_array.begin(),
+                                       maxwell_3d->regs.reg_array.end());
+    trace_recorder = std::make_unique<CiTrace::Recorder>(initial_state);
+    traced_mappings = false;
+    traced_page_hashes.clear();
+}
+
+void GPU::FinishTrace(const std::string& filename) {
+    if (trace_recorder == nullptr) {
+        return;
+    }
+    trace_recorder->Finish(filename);
+    trace_recorder.reset();
+    traced_page_hashes.clear();
+}
+
+void GPU::TraceCommandList(GPUVAddr address, u32 size) {
+    const u64 generation = memory_manager->GetMappingGeneration();
+    const std::vector<MemoryManager::Mapping> mappings = memory_manager->GetMappings();
+    if (!traced_mappings || generation != traced_mapping_generation) {
+        trace_recorder->MemoryMappingsChanged(
+            reinterpret_cast<const u8*>(mappings.data()),
+            static_cast<u32>(mappings.size() * sizeof(MemoryManager::Mapping)));
+        traced_mappings = true;
+        traced_mapping_generation = generation;
+    }
+
+    // Changed pages are recorded in runs that are consecutive in host memory
+    VAddr run_addr = 0;
+    const u8* run_pointer = nullptr;
+    u64 run_size = 0;
+    const auto flush_run = [&] {
+        if (run_size != 0) {
+            trace_recorder->MemoryAccessed(run_pointer, static_cast<u32>(run_size), run_addr);
+        }
+        run_size = 0;
+    };
+
+    for (const MemoryManager::Mapping& mapping : mappings) {
+        const VAddr end = mapping.cpu_addr + mapping.size;
+        for (VAddr page = mapping.cpu_addr & ~Memory::PAGE_MASK; page < end;
+             page += Memory::PAGE_SIZE) {
+            const u8* pointer = Memory::GetPointer(page);
+            if (pointer == nullptr) {
+                continue;
+            }
+            const u64 hash = Common::ContentHash64(pointer, Memory::PAGE_SIZE);
+            const auto [it, inserted] = traced_page_hashes.emplace(page, hash);
+            if (!inserted) {
+                if (it->second == hash) {
+                    continue;
+                }
+                it->second = hash;
+            }
+            if (run_size == 0 || page != run_addr + run_size ||
+                pointer != run_pointer + run_size) {
+                flush_run();
+                run_addr = page;
+                run_pointer = pointer;
+            }
+            run_size += Memory::PAGE_SIZE;
+        }
+    }
+    flush_run();
+
+    trace_recorder->CommandListSubmitted(address, size);
+}
+
+bool GPU::IsAsynchronous() const {
+    // Work started on the GPU thread, such as the renderer flushing a framebuffer, runs directly.
+    return gpu_thread != nullptr && !gpu_thread->IsGPUThread();
+}
+
+void GPU::PushCommandList(GPUVAddr address, u32 size) {
+    if (IsAsynchronous()) {
+        gpu_thread->SubmitList(address, size);
+    } else {
+        ProcessCommandList(address, size);
+    }
+}
+
+void GPU::SwapBuffers(const std::vector<FramebufferConfig>& layers) {
+    if (IsAsynchronous()) {
+        gpu_thread->SwapBuffers(layers);
+        return;
+    }
+
+    if (trace_recorder) {
+        static_assert(std::is_trivially_copyable_v<FramebufferConfig>,
+                      "FramebufferConfig is recorded as is");
+        trace_recorder->FrameFinished(reinterpret_cast<const u8*>(layers.data()),
+                                      static_cast<u32>(layers.size() * sizeof(FramebufferConfig)));
+    }
+    VideoCore::g_renderer->SwapBuffers(layers);
+}
+
+void GPU::LoadDiskResources(const DiskResourceLoadCallback& callback) {
+    if (IsAsynchronous()) {
+        gpu_thread->LoadDiskResources(callback);
+    } else {
+        VideoCore::g_renderer->Rasterizer()->LoadDiskResources(callback);
+    }
+}
+
+bool GPU::RequestSurfaceCapture(VAddr addr, SurfaceCaptureCallback callback) {
+    // The rasterizer takes the request under a lock of its own, so it isn't queued to the thread
+    if (VideoCore::g_renderer == nullptr || VideoCore::g_renderer->Rasterizer() == nullptr) {
+        return false;
+    }
+    return VideoCore::g_renderer->Rasterizer()->RequestSurfaceCapture(addr, std::move(callback));
+}
+
+void GPU::IncrementSyncPoint(u32 syncpoint_id) {
+    ASSERT(syncpoint_id < MaxSyncPoints);
+    if (IsAsynchronous()) {
+        gpu_thread->IncrementSyncPoint(syncpoint_id);
+        return;
+    }
+
+    syncpoints[syncpoint_id].fetch_add(1, std::memory_order_release);
+    if (syncpoint_callback) {
+        syncpoint_callback(syncpoint_id);
+    }
+}
+
+u32 GPU::GetSyncPointValue(u32 syncpoint_id) const {
+    ASSERT(syncpoint_id < MaxSyncPoints);
+    return syncpoints[syncpoint_id].load(std::memory_order_acquire);
+}
+
+void GPU::SetSyncPointCallback(std::function<void(u32 syncpoint_id)> callback) {
+    syncpoint_callback = std::move(callback);
+}
+
+void GPU::FlushRegion(VAddr addr, u64 size) {
+    if (IsAsynchronous()) {
+        gpu_thread->FlushRegion(addr, size);
+    } else {
+        VideoCore::g_renderer->Rasterizer()->FlushRegion(addr, size);
+    }
+}
+
+void GPU::InvalidateRegion(VAddr addr, u64 size) {
+    if (IsAsynchronous()) {
+        gpu_thread->InvalidateRegion(addr, size);
+    } else {
+        VideoCore::g_renderer->Rasterizer()->InvalidateRegion(addr, size);
+    }
+}
+
+void GPU::FlushAndInvalidateRegion(VAddr addr, u64 size) {
+    if (IsAsynchronous()) {
+        gpu_thread->FlushAndInvalidateRegion(addr, size);
+    } else {
+        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(addr, size);
+    }
+}
+
 } // namespace Tegra
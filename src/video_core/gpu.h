@@ -4,13 +4,29 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/hle/service/nvflinger/buffer_queue.h"
 #include "video_core/memory_manager.h"
 
+class EmuWindow;
+class RendererBase;
+
+namespace CiTrace {
+class Recorder;
+} // namespace CiTrace
+
+namespace VideoCommon::GPUThread {
+class ThreadManager;
+} // namespace VideoCommon::GPUThread
+
 namespace Tegra {
 
 enum class RenderTargetFormat : u32 {
@@ -21,6 +37,9 @@ enum class RenderTargetFormat : u32 {
     RGBA8_SRGB = 0xD6,
 };
 
+/// Returns the number of bytes per pixel of each rendertarget format.
+u32 RenderTargetBytesPerPixel(RenderTargetFormat format);
+
 class DebugContext;
 
 /**
@@ -56,8 +75,10 @@ struct FramebufferConfig {
 
 namespace Engines {
 class Fermi2D;
+class KeplerMemory;
 class Maxwell3D;
 class MaxwellCompute;
+class MaxwellDMA;
 } // namespace Engines
 
 enum class EngineID {
@@ -68,6 +89,21 @@ enum class EngineID {
     MAXWELL_DMA_COPY_A = 0xB0B5,
 };
 
+/// Number of syncpoints the host1x exposes, which the command lists increment as they retire
+constexpr u32 MaxSyncPoints = 192;
+
+/// Told how many of the resources loaded from disk have been loaded so far, and how many there are
+using DiskResourceLoadCallback = std::function<void(size_t value, size_t total)>;
+
+/// Contents of a surface copied out of the renderer, as RGBA8 rows from the top of the surface.
+/// Empty when the renderer has no color surface cached at the requested address.
+struct SurfaceCapture {
+    u32 width = 0;
+    u32 height = 0;
+    std::vector<u8> rgba8;
+};
+using SurfaceCaptureCallback = std::function<void(SurfaceCapture capture)>;
+
 class GPU final {
 public:
     GPU();
@@ -76,6 +112,57 @@ public:
     /// Processes a command list stored at the specified address in GPU memory.
     void ProcessCommandList(GPUVAddr address, u32 size);
 
+    /**
+     * Moves the processing of command lists and all the work of the renderer to a thread of its
+     * own. The calls below are then queued to it in order, instead of being run on the caller.
+     */
+    void StartThread(RendererBase& renderer, EmuWindow& emu_window);
+    /// Waits for the GPU thread to finish the queued work, and stops it.
+    void StopThread();
+    /// Returns whether the calling thread is the GPU thread started by StartThread.
+    bool IsGPUThread() const;
+
+    /// Queues a command list for processing, as submitted through a GPFIFO.
+    void PushCommandList(GPUVAddr address, u32 size);
+    /**
+     * Presents a frame composed of the given layers, drawn from the first one to the last, or
+     * only polls the window events when there are none.
+     */
+    void SwapBuffers(const std::vector<FramebufferConfig>& layers);
+
+    /// Builds the shaders kept in the disk cache of the renderer, before the guest starts.
+    void LoadDiskResources(const DiskResourceLoadCallback& callback);
+
+    /**
+     * Starts recording every command list and presented frame as a CiTrace, along with the GPU
+     * memory mappings and the contents of the mapped memory, for the trace to be replayed without
+     * the rest of the system.
+     */
+    void StartTrace();
+    /// Stops recording, and writes the trace recorded so far to the given file.
+    void FinishTrace(const std::string& filename);
+
+    /// Increments a syncpoint once the command lists pushed before have been processed.
+    void IncrementSyncPoint(u32 syncpoint_id);
+    /// Returns the value a syncpoint has been incremented to so far. Can be called from any thread.
+    u32 GetSyncPointValue(u32 syncpoint_id) const;
+    /// Sets the function called whenever a syncpoint is incremented, on the thread the GPU runs on.
+    void SetSyncPointCallback(std::function<void(u32 syncpoint_id)> callback);
+
+    /// Writes back the surfaces cached for the region, for the CPU to read the memory.
+    void FlushRegion(VAddr addr, u64 size);
+    /// Drops the surfaces cached for the region, after the CPU has written the memory.
+    void InvalidateRegion(VAddr addr, u64 size);
+    void FlushAndInvalidateRegion(VAddr addr, u64 size);
+
+    /**
+     * Requests a copy of the surface the renderer caches at addr, for inspecting it while the
+     * GPU runs. Can be called from any thread. The callback is called on the thread the GPU runs
+     * on once the copy has completed, usually a frame or two later.
+     * @returns Whether the renderer can capture surfaces, if not the callback is never called
+     */
+    bool RequestSurfaceCapture(VAddr addr, SurfaceCaptureCallback callback);
+
     /// Returns a reference to the Maxwell3D GPU engine.
     const Engines::Maxwell3D& Get3DEngine() const;
 
@@ -88,11 +175,35 @@ public:
 private:
     static constexpr u32 InvalidGraphMacroEntry = 0xFFFFFFFF;
 
+    /// Returns whether calls have to be queued to the GPU thread rather than run directly.
+    bool IsAsynchronous() const;
+
     /// Writes a single register in the engine bound to the specified subchannel
     void WriteReg(u32 method, u32 subchannel, u32 value, u32 remaining_params);
 
+    /**
+     * Writes a run of values from a command list to the engine bound to the specified subchannel,
+     * to consecutive registers or all to the same one. Engines that can take the run as a whole
+     * are handed it in one call.
+     */
+    void WriteRegBatch(u32 method, u32 subchannel, const u32* values, u32 count, bool increasing);
+
+    /**
+     * Records a command list that is about to be processed, after the mappings and the pages of
+     * mapped memory that changed since the previous one. Every page of mapped memory is hashed to
+     * find the changed ones, which is slow, but finds the writes of the JIT as well.
+     */
+    void TraceCommandList(GPUVAddr address, u32 size);
+
+    /// Number of subchannels engines can be bound to, as addressed by a command header.
+    static constexpr size_t NUM_SUBCHANNELS = 8;
+
     /// Mapping of command subchannels to their bound engine ids.
-    std::unordered_map<u32, EngineID> bound_engines;
+    std::array<boost::optional<EngineID>, NUM_SUBCHANNELS> bound_engines{};
+
+    /// Only written by the thread the GPU runs on, and read by the CPU thread.
+    std::array<std::atomic<u32>, MaxSyncPoints> syncpoints{};
+    std::function<void(u32 syncpoint_id)> syncpoint_callback;
 
     /// 3D engine
     std::unique_ptr<Engines::Maxwell3D> maxwell_3d;
@@ -100,11 +211,29 @@ private:
     std::unique_ptr<Engines::Fermi2D> fermi_2d;
     /// Compute engine
     std::unique_ptr<Engines::MaxwellCompute> maxwell_compute;
+    /// DMA engine
+    std::unique_ptr<Engines::MaxwellDMA> maxwell_dma;
+    /// Inline memory engine
+    std::unique_ptr<Engines::KeplerMemory> kepler_memory;
 
     /// Entry of the macro that is currently being uploaded
     u32 current_macro_entry = InvalidGraphMacroEntry;
     /// Code being uploaded for the current macro
     std::vector<u32> current_macro_code;
+
+    /// Copy of the command list being processed, for lists that can't be read in place
+    std::vector<u32> command_list_buffer;
+
+    /// Recorder of the command lists, only set while a trace is being recorded
+    std::unique_ptr<CiTrace::Recorder> trace_recorder;
+    /// Generation of the memory mappings that were recorded last
+    u64 traced_mapping_generation = 0;
+    bool traced_mappings = false;
+    /// Hashes of the pages of application memory as they were recorded last, by their address
+    std::unordered_map<VAddr, u64> traced_page_hashes;
+
+    /// Thread the GPU runs on, when it runs asynchronously
+    std::unique_ptr<VideoCommon::GPUThread::ThreadManager> gpu_thread;
 };
 
 } // namespace Tegra
@@ -0,0 +1,153 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/microprofile.h"
+#include "common/thread_placement.h"
+#include "core/frontend/emu_window.h"
+#include "core/settings.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+
+namespace VideoCommon::GPUThread {
+
+ThreadManager::ThreadManager(RendererBase& renderer, EmuWindow& emu_window, Tegra::GPU& gpu)
+    : renderer(renderer), emu_window(emu_window), gpu(gpu) {
+    // The GL context can only be current on one thread at a time.
+    emu_window.DoneCurrent();
+    thread = std::thread(&ThreadManager::RunThread, this);
+}
+
+ThreadManager::~ThreadManager() {
+    WaitIdle();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    commands_available.notify_one();
+    thread.join();
+
+    // Hand the context back to the thread that shuts the renderer down.
+    emu_window.MakeCurrent();
+}
+
+void ThreadManager::SubmitList(Tegra::GPUVAddr address, u32 size) {
+    PushCommand(SubmitListCommand{address, size});
+}
+
+void ThreadManager::SwapBuffers(const std::vector<Tegra::FramebufferConfig>& layers) {
+    SwapBuffersCommand command{layers};
+
+    // Frame limiting happens as the frame is presented, on the GPU thread. Waiting for the
+    // previous frame here paces the CPU thread to it as well. The other modes let the CPU thread
+    // get two frames ahead, which is enough for it not to wait on the display.
+    if (Settings::values.present_mode == Settings::PresentMode::Fifo) {
+        WaitForFence(last_swap_fence);
+    } else {
+        WaitForFence(previous_swap_fence);
+    }
+    previous_swap_fence = last_swap_fence;
+    queued_swaps.fetch_add(1, std::memory_order_relaxed);
+    last_swap_fence = PushCommand(std::move(command));
+}
+
+void ThreadManager::FlushRegion(VAddr addr, u64 size) {
+    WaitForFence(PushCommand(FlushRegionCommand{addr, size}));
+}
+
+void ThreadManager::InvalidateRegion(VAddr addr, u64 size) {
+    PushCommand(InvalidateRegionCommand{addr, size});
+}
+
+void ThreadManager::FlushAndInvalidateRegion(VAddr addr, u64 size) {
+    WaitForFence(PushCommand(FlushAndInvalidateRegionCommand{addr, size}));
+}
+
+void ThreadManager::IncrementSyncPoint(u32 syncpoint_id) {
+    PushCommand(IncrementSyncPointCommand{syncpoint_id});
+}
+
+void ThreadManager::LoadDiskResources(const Tegra::DiskResourceLoadCallback& callback) {
+    WaitForFence(PushCommand(LoadDiskResourcesCommand{callback}));
+}
+
+void ThreadManager::WaitIdle() {
+    WaitForFence(last_fence);
+}
+
+u64 ThreadManager::PushCommand(CommandData&& command) {
+    const u64 fence = ++last_fence;
+    queue.Push(CommandDataContainer{std::move(command), fence});
+    {
+        // Taking the lock keeps the notification from slipping in between the GPU thread
+        // checking the queue and going to sleep.
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    commands_available.notify_one();
+    return fence;
+}
+
+void ThreadManager::WaitForFence(u64 fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    fence_signaled.wait(lock, [this, fence] { return signaled_fence >= fence; });
+}
+
+void ThreadManager::RunThread() {
+    MicroProfileOnThreadCreate("GpuThread");
+    Common::SetCurrentThreadRole(Common::ThreadRole::GPU);
+    emu_window.MakeCurrent();
+
+    CommandDataContainer command;
+    while (true) {
+        if (!queue.Pop(command)) {
+            std::unique_lock<std::mutex> lock(mutex);
+            commands_available.wait(lock, [this] { return !queue.Empty() || !running; });
+            if (queue.Empty() && !running) {
+                break;
+            }
+            continue;
+        }
+
+        ExecuteCommand(command.data);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            signaled_fence.store(command.fence, std::memory_order_release);
+        }
+        fence_signaled.notify_all();
+    }
+
+    emu_window.DoneCurrent();
+}
+
+void ThreadManager::ExecuteCommand(CommandData& command) {
+    if (const auto submit = std::get_if<SubmitListCommand>(&command)) {
+        gpu.ProcessCommandList(submit->address, submit->size);
+    } else if (const auto swap = std::get_if<SwapBuffersCommand>(&command)) {
+        // Called on the GPU thread, this presents the frame directly. In mailbox mode, a frame
+        // with a newer one queued behind it is dropped, and only ends the frame.
+        const bool newer_frame_queued = queued_swaps.fetch_sub(1, std::memory_order_relaxed) > 1;
+        if (newer_frame_queued && Settings::values.present_mode == Settings::PresentMode::Mailbox) {
+            gpu.SwapBuffers({});
+        } else {
+            gpu.SwapBuffers(swap->layers);
+        }
+    } else if (const auto flush = std::get_if<FlushRegionCommand>(&command)) {
+        renderer.Rasterizer()->FlushRegion(flush->addr, flush->size);
+    } else if (const auto invalidate = std::get_if<InvalidateRegionCommand>(&command)) {
+        renderer.Rasterizer()->InvalidateRegion(invalidate->addr, invalidate->size);
+    } else if (const auto flush_invalidate =
+                   std::get_if<FlushAndInvalidateRegionCommand>(&command)) {
+        renderer.Rasterizer()->FlushAndInvalidateRegion(flush_invalidate->addr,
+                                                        flush_invalidate->size);
+    } else if (const auto increment = std::get_if<IncrementSyncPointCommand>(&command)) {
+        gpu.IncrementSyncPoint(increment->syncpoint_id);
+    } else if (const auto load = std::get_if<LoadDiskResourcesCommand>(&command)) {
+        renderer.Rasterizer()->LoadDiskResources(load->callback);
+    }
+}
+
+} // namespace VideoCommon::GPUThread
@@ -0,0 +1,132 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <variant>
+#include <vector>
+#include "common/common_types.h"
+#include "common/threadsafe_queue.h"
+#include "video_core/gpu.h"
+
+class EmuWindow;
+class RendererBase;
+
+namespace VideoCommon::GPUThread {
+
+/// Command to process a command list, as given by a GPFIFO entry
+struct SubmitListCommand final {
+    Tegra::GPUVAddr address;
+    u32 size;
+};
+
+/// Command to present a frame
+struct SwapBuffersCommand final {
+    std::vector<Tegra::FramebufferConfig> layers;
+};
+
+/// Commands to write back or drop the surfaces the rasterizer caches for a guest memory region
+struct FlushRegionCommand final {
+    VAddr addr;
+    u64 size;
+};
+struct InvalidateRegionCommand final {
+    VAddr addr;
+    u64 size;
+};
+struct FlushAndInvalidateRegionCommand final {
+    VAddr addr;
+    u64 size;
+};
+
+/// Command to increment a syncpoint, once the command lists before it have been processed
+struct IncrementSyncPointCommand final {
+    u32 syncpoint_id;
+};
+
+/// Command to load the resources the rasterizer keeps on disk
+struct LoadDiskResourcesCommand final {
+    Tegra::DiskResourceLoadCallback callback;
+};
+
+using CommandData =
+    std::variant<SubmitListCommand, SwapBuffersCommand, FlushRegionCommand, InvalidateRegionCommand,
+                 FlushAndInvalidateRegionCommand, IncrementSyncPointCommand,
+                 LoadDiskResourcesCommand>;
+
+struct CommandDataContainer {
+    CommandData data;
+    /// Signaled once the command has been processed
+    u64 fence;
+};
+
+/**
+ * Runs the GPU, and with it all the work of the renderer, on a thread of its own. The CPU thread
+ * queues commands without waiting for them, and only blocks when it needs their results: when
+ * guest memory written by the GPU is read back, or when the GPU has to be idle.
+ */
+class ThreadManager final {
+public:
+    ThreadManager(RendererBase& renderer, EmuWindow& emu_window, Tegra::GPU& gpu);
+    ~ThreadManager();
+
+    void SubmitList(Tegra::GPUVAddr address, u32 size);
+    void SwapBuffers(const std::vector<Tegra::FramebufferConfig>& layers);
+
+    /// Writes back the surfaces of a region, and waits for it so that the memory is up to date.
+    void FlushRegion(VAddr addr, u64 size);
+    /// Drops the surfaces of a region. Later commands see the change, so there is no wait.
+    void InvalidateRegion(VAddr addr, u64 size);
+    void FlushAndInvalidateRegion(VAddr addr, u64 size);
+
+    void IncrementSyncPoint(u32 syncpoint_id);
+
+    /// Loads the disk resources of the rasterizer, and waits for them. The callback is called on
+    /// the GPU thread.
+    void LoadDiskResources(const Tegra::DiskResourceLoadCallback& callback);
+
+    /// Waits until every command queued so far has been processed.
+    void WaitIdle();
+
+    /// Returns whether the calling thread is the GPU thread.
+    bool IsGPUThread() const {
+        return std::this_thread::get_id() == thread.get_id();
+    }
+
+private:
+    /// Queues a command and returns the fence signaled once it has been processed.
+    u64 PushCommand(CommandData&& command);
+    void WaitForFence(u64 fence);
+
+    void RunThread();
+    void ExecuteCommand(CommandData& command);
+
+    RendererBase& renderer;
+    EmuWindow& emu_window;
+    Tegra::GPU& gpu;
+
+    /// Only ever pushed to by the CPU thread and popped by the GPU thread.
+    Common::SPSCQueue<CommandDataContainer> queue;
+    u64 last_fence = 0;
+    /// Fences of the last two frames queued, which the CPU waits for depending on the present mode
+    u64 last_swap_fence = 0;
+    u64 previous_swap_fence = 0;
+    /// Frames queued and not yet presented
+    std::atomic<u32> queued_swaps{0};
+    std::atomic<u64> signaled_fence{0};
+    std::atomic<bool> running{true};
+
+    /// Wakes the GPU thread up when commands are queued, and the CPU thread when fences signal.
+    std::mutex mutex;
+    std::condition_variable commands_available;
+    std::condition_variable fence_signaled;
+
+    std::thread thread;
+};
+
+} // namespace VideoCommon::GPUThread
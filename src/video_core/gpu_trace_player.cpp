@@ -0,0 +1,191 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include "common/alignment.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/hle/kernel/process.h"
+#include "core/memory.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/gpu.h"
+#include "video_core/gpu_trace_player.h"
+
+namespace Tegra {
+
+GPUTracePlayer::GPUTracePlayer(GPU& gpu) : gpu(gpu) {}
+GPUTracePlayer::~GPUTracePlayer() = default;
+
+bool GPUTracePlayer::Load(const std::string& filename, Kernel::Process& process) {
+    FileUtil::IOFile trace_file(filename, "rb");
+    file.resize(trace_file.GetSize());
+    if (!trace_file.IsOpen() || trace_file.ReadBytes(file.data(), file.size()) != file.size()) {
+        LOG_ERROR(HW_GPU, "Failed to read GPU trace %s", filename.c_str());
+        return false;
+    }
+
+    CiTrace::CTHeader header;
+    if (file.size() < sizeof(header)) {
+        LOG_ERROR(HW_GPU, "GPU trace %s is truncated", filename.c_str());
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, CiTrace::CTHeader::ExpectedMagicWord(), 4) != 0 ||
+        header.version != CiTrace::CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "%s isn't a GPU trace of version %u", filename.c_str(),
+                  CiTrace::CTHeader::ExpectedVersion());
+        return false;
+    }
+
+    const u64 stream_size = u64(header.stream_size) * sizeof(CiTrace::CTStreamElement);
+    if (header.stream_offset + stream_size > file.size()) {
+        LOG_ERROR(HW_GPU, "GPU trace %s is truncated", filename.c_str());
+        return false;
+    }
+    stream.resize(header.stream_size);
+    std::memcpy(stream.data(), file.data() + header.stream_offset, stream_size);
+    position = 0;
+
+    // The 3D engine registers the trace started from
+    const auto& initial = header.initial_state_offsets;
+    auto& reg_array = gpu.Maxwell3D().regs.reg_array;
+    const u32 num_regs = std::min<u32>(initial.gpu_registers_size, reg_array.size());
+    const u8* registers = GetData(initial.gpu_registers, num_regs * sizeof(u32));
+    if (registers != nullptr) {
+        std::memcpy(reg_array.data(), registers, num_regs * sizeof(u32));
+    }
+
+    for (const CiTrace::CTStreamElement& element : stream) {
+        const u8* data = file.data();
+        switch (element.type) {
+        case CiTrace::FrameMarker:
+            data = GetData(element.frame_marker.file_offset, element.frame_marker.size);
+            break;
+        case CiTrace::MemoryLoad:
+            data = GetData(element.memory_load.file_offset, element.memory_load.size);
+            break;
+        case CiTrace::MemoryMappings:
+            data = GetData(element.memory_mappings.file_offset, element.memory_mappings.size);
+            break;
+        default:
+            break;
+        }
+        if (data == nullptr) {
+            LOG_ERROR(HW_GPU, "GPU trace %s refers to data past its end", filename.c_str());
+            return false;
+        }
+    }
+
+    return MapProcessMemory(process);
+}
+
+bool GPUTracePlayer::PlayFrame() {
+    while (position < stream.size()) {
+        const CiTrace::CTStreamElement& element = stream[position++];
+        switch (element.type) {
+        case CiTrace::MemoryLoad: {
+            const auto& load = element.memory_load;
+            Memory::WriteBlock(load.address, GetData(load.file_offset, load.size), load.size);
+            break;
+        }
+        case CiTrace::MemoryMappings: {
+            const auto& mappings_element = element.memory_mappings;
+            ApplyMappings(GetData(mappings_element.file_offset, mappings_element.size),
+                          mappings_element.size);
+            break;
+        }
+        case CiTrace::CommandList:
+            gpu.PushCommandList(element.command_list.gpu_address, element.command_list.size);
+            break;
+        case CiTrace::FrameMarker: {
+            const auto& marker = element.frame_marker;
+            std::vector<FramebufferConfig> layers(marker.size / sizeof(FramebufferConfig));
+            std::memcpy(layers.data(), GetData(marker.file_offset, marker.size),
+                        layers.size() * sizeof(FramebufferConfig));
+            gpu.SwapBuffers(layers);
+            return true;
+        }
+        default:
+            // Method calls and register writes are covered by the command lists
+            break;
+        }
+    }
+    return false;
+}
+
+const u8* GPUTracePlayer::GetData(u32 file_offset, u32 size) const {
+    if (u64(file_offset) + size > file.size()) {
+        return nullptr;
+    }
+    return file.data() + file_offset;
+}
+
+bool GPUTracePlayer::MapProcessMemory(Kernel::Process& process) const {
+    std::vector<std::pair<VAddr, VAddr>> regions;
+    const auto add_region = [&regions](VAddr address, u64 size) {
+        regions.emplace_back(address & ~Memory::PAGE_MASK,
+                             Common::AlignUp(address + size, Memory::PAGE_SIZE));
+    };
+    for (const CiTrace::CTStreamElement& element : stream) {
+        if (element.type == CiTrace::MemoryLoad) {
+            add_region(element.memory_load.address, element.memory_load.size);
+        } else if (element.type == CiTrace::MemoryMappings) {
+            const auto& mappings_element = element.memory_mappings;
+            std::vector<MemoryManager::Mapping> recorded(mappings_element.size /
+                                                         sizeof(MemoryManager::Mapping));
+            std::memcpy(recorded.data(),
+                        GetData(mappings_element.file_offset, mappings_element.size),
+                        recorded.size() * sizeof(MemoryManager::Mapping));
+            for (const MemoryManager::Mapping& mapping : recorded) {
+                add_region(mapping.cpu_addr, mapping.size);
+            }
+        }
+    }
+
+    // Regions that overlap or touch are merged, to be mapped as one block
+    std::sort(regions.begin(), regions.end());
+    std::vector<std::pair<VAddr, VAddr>> merged;
+    for (const auto& region : regions) {
+        if (!merged.empty() && region.first <= merged.back().second) {
+            merged.back().second = std::max(merged.back().second, region.second);
+        } else {
+            merged.push_back(region);
+        }
+    }
+
+    for (const auto& [start, end] : merged) {
+        const u64 size = end - start;
+        const auto result = process.vm_manager.MapMemoryBlock(
+            start, std::make_shared<std::vector<u8>>(size), 0, size, Kernel::MemoryState::Heap);
+        if (result.Failed()) {
+            LOG_ERROR(HW_GPU, "Failed to map the memory of the GPU trace at 0x%016" PRIX64, start);
+            return false;
+        }
+    }
+    return true;
+}
+
+void GPUTracePlayer::ApplyMappings(const u8* data, u32 size) {
+    std::vector<MemoryManager::Mapping> recorded(size / sizeof(MemoryManager::Mapping));
+    std::memcpy(recorded.data(), data, recorded.size() * sizeof(MemoryManager::Mapping));
+
+    MemoryManager& memory_manager = *gpu.memory_manager;
+    for (const MemoryManager::Mapping& mapping : mappings) {
+        if (std::find(recorded.begin(), recorded.end(), mapping) == recorded.end()) {
+            memory_manager.UnmapBuffer(mapping.gpu_addr);
+        }
+    }
+    for (const MemoryManager::Mapping& mapping : recorded) {
+        if (std::find(mappings.begin(), mappings.end(), mapping) == mappings.end()) {
+            memory_manager.MapBufferAt(mapping.cpu_addr, mapping.gpu_addr, mapping.size);
+        }
+    }
+    mappings = std::move(recorded);
+}
+
+} // namespace Tegra
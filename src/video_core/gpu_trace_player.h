@@ -0,0 +1,66 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "common/common_types.h"
+#include "core/tracer/citrace.h"
+#include "video_core/memory_manager.h"
+
+namespace Kernel {
+class Process;
+} // namespace Kernel
+
+namespace Tegra {
+
+class GPU;
+
+/**
+ * Replays a CiTrace recorded by GPU::StartTrace on a GPU, without the CPU or the kernel running.
+ * The memory mappings, memory contents and command lists are fed to the GPU in the order they
+ * were recorded in, and the recorded frames are presented, so that the renderer can be benchmarked
+ * and bisected with the same input every time.
+ */
+class GPUTracePlayer final {
+public:
+    explicit GPUTracePlayer(GPU& gpu);
+    ~GPUTracePlayer();
+
+    /**
+     * Reads a trace, and maps memory into the process for all the application memory the trace
+     * uses. The process has to be the current one while the trace is replayed.
+     * @returns false if the file can't be read, or isn't a trace of the expected version.
+     */
+    bool Load(const std::string& filename, Kernel::Process& process);
+
+    /**
+     * Replays the trace up to and including the next frame that was presented.
+     * @returns false once the whole trace has been replayed.
+     */
+    bool PlayFrame();
+
+private:
+    /// Returns the extra data of an element in the file, or nullptr if it's out of its bounds.
+    const u8* GetData(u32 file_offset, u32 size) const;
+
+    /// Maps memory into the process for every page the trace loads or maps to the GPU.
+    bool MapProcessMemory(Kernel::Process& process) const;
+
+    /// Replaces the GPU memory mappings with the recorded ones.
+    void ApplyMappings(const u8* data, u32 size);
+
+    GPU& gpu;
+
+    std::vector<u8> file;
+    std::vector<CiTrace::CTStreamElement> stream;
+    /// Index of the next element of the stream to be replayed
+    size_t position = 0;
+
+    /// Mappings the GPU memory manager has been given so far
+    std::vector<MemoryManager::Mapping> mappings;
+};
+
+} // namespace Tegra
@@ -0,0 +1,26 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <unordered_map>
+#include "video_core/macro_hle.h"
+
+namespace Tegra {
+
+namespace {
+
+/**
+ * Native implementations by the hash of the macro code they replace. The hash of every uploaded
+ * macro is logged at debug level, which is how the macros worth replacing are identified. An
+ * implementation only belongs here once it has been checked against the code it replaces.
+ */
+const std::unordered_map<u64, HLEMacroFunction> hle_macros{};
+
+} // Anonymous namespace
+
+HLEMacroFunction GetHLEMacro(u64 code_hash) {
+    const auto macro = hle_macros.find(code_hash);
+    return macro != hle_macros.end() ? macro->second : nullptr;
+}
+
+} // namespace Tegra
@@ -0,0 +1,29 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace Tegra {
+namespace Engines {
+class Maxwell3D;
+}
+
+/**
+ * Native implementation of a well-known macro. It has to leave the engine in the same state as
+ * running the macro code with the same parameters would.
+ */
+using HLEMacroFunction = void (*)(Engines::Maxwell3D& maxwell3d, const u32* parameters,
+                                  size_t num_parameters);
+
+/**
+ * Looks up the native implementation of a macro.
+ * @param code_hash CityHash64 of the macro code, as uploaded.
+ * @returns The implementation, or nullptr when the macro has to be run from its code.
+ */
+HLEMacroFunction GetHLEMacro(u64 code_hash);
+
+} // namespace Tegra
@@ -11,10 +11,13 @@ namespace Tegra {
 
 MacroInterpreter::MacroInterpreter(Engines::Maxwell3D& maxwell3d) : maxwell3d(maxwell3d) {}
 
-void MacroInterpreter::Execute(const std::vector<u32>& code, std::vector<u32> parameters) {
+void MacroInterpreter::Execute(const std::vector<u32>& code, const u32* parameters,
+                               size_t num_parameters) {
     Reset();
+    ASSERT(num_parameters >= 1);
     registers[1] = parameters[0];
-    this->parameters = std::move(parameters);
+    this->parameters = parameters;
+    this->num_parameters = num_parameters;
 
     // Execute the code until we hit an exit condition.
     bool keep_executing = true;
@@ -23,7 +26,87 @@ void MacroInterpreter::Execute(const std::vector<u32>& code, std::vector<u32> pa
     }
 
     // Assert the the macro used all the input parameters
-    ASSERT(next_parameter_index == this->parameters.size());
+    ASSERT(next_parameter_index == num_parameters);
+}
+
+boost::optional<MacroInterpreter::Program> MacroInterpreter::Compile(
+    const std::vector<u32>& code) {
+    Program program;
+    program.instructions.reserve(code.size());
+
+    for (size_t index = 0; index < code.size(); ++index) {
+        const Opcode opcode{code[index]};
+
+        DecodedInstruction instruction{};
+        instruction.operation = opcode.operation;
+        instruction.result_operation = opcode.result_operation;
+        instruction.alu_operation = opcode.alu_operation;
+        instruction.branch_condition = opcode.branch_condition;
+        instruction.branch_annul = opcode.branch_annul != 0;
+        instruction.is_exit = opcode.is_exit != 0;
+        instruction.dst = static_cast<u8>(opcode.dst.Value());
+        instruction.src_a = static_cast<u8>(opcode.src_a.Value());
+        instruction.src_b = static_cast<u8>(opcode.src_b.Value());
+        instruction.bf_src_bit = static_cast<u8>(opcode.bf_src_bit.Value());
+        instruction.bf_dst_bit = static_cast<u8>(opcode.bf_dst_bit.Value());
+        instruction.immediate = opcode.immediate;
+        instruction.bitfield_mask = opcode.GetBitfieldMask();
+
+        switch (instruction.operation) {
+        case Operation::ALU:
+            switch (instruction.alu_operation) {
+            case ALUOperation::Add:
+            case ALUOperation::Subtract:
+            case ALUOperation::Xor:
+            case ALUOperation::Or:
+            case ALUOperation::And:
+            case ALUOperation::AndNot:
+            case ALUOperation::Nand:
+                break;
+            default:
+                return boost::none;
+            }
+            break;
+        case Operation::AddImmediate:
+        case Operation::ExtractInsert:
+        case Operation::ExtractShiftLeftImmediate:
+        case Operation::ExtractShiftLeftRegister:
+        case Operation::Read:
+            break;
+        case Operation::Branch: {
+            const s64 target = static_cast<s64>(index) + instruction.immediate;
+            if (target < 0 || target >= static_cast<s64>(code.size())) {
+                return boost::none;
+            }
+            instruction.branch_target = static_cast<u32>(target);
+            break;
+        }
+        default:
+            return boost::none;
+        }
+
+        program.instructions.push_back(instruction);
+    }
+
+    return program;
+}
+
+void MacroInterpreter::Execute(const Program& program, const u32* parameters,
+                               size_t num_parameters) {
+    Reset();
+    ASSERT(num_parameters >= 1);
+    registers[1] = parameters[0];
+    this->parameters = parameters;
+    this->num_parameters = num_parameters;
+
+    // The program counter of decoded programs counts instructions rather than bytes.
+    bool keep_executing = true;
+    while (keep_executing) {
+        keep_executing = StepDecoded(program, false);
+    }
+
+    // Assert the the macro used all the input parameters
+    ASSERT(next_parameter_index == num_parameters);
 }
 
 void MacroInterpreter::Reset() {
@@ -31,7 +114,8 @@ void MacroInterpreter::Reset() {
     pc = 0;
     delayed_pc = boost::none;
     method_address.raw = 0;
-    parameters.clear();
+    parameters = nullptr;
+    num_parameters = 0;
     // The next parameter index starts at 1, because $r1 already has the value of the first
     // parameter.
     next_parameter_index = 1;
@@ -128,6 +212,92 @@ bool MacroInterpreter::Step(const std::vector<u32>& code, bool is_delay_slot) {
     return true;
 }
 
+bool MacroInterpreter::StepDecoded(const Program& program, bool is_delay_slot) {
+    ASSERT(pc < program.instructions.size());
+    const DecodedInstruction& instruction = program.instructions[pc];
+    ++pc;
+
+    // Update the program counter if we were delayed
+    if (delayed_pc != boost::none) {
+        ASSERT(is_delay_slot);
+        pc = *delayed_pc;
+        delayed_pc = boost::none;
+    }
+
+    switch (instruction.operation) {
+    case Operation::ALU: {
+        const u32 result = GetALUResult(instruction.alu_operation, GetRegister(instruction.src_a),
+                                        GetRegister(instruction.src_b));
+        ProcessResult(instruction.result_operation, instruction.dst, result);
+        break;
+    }
+    case Operation::AddImmediate: {
+        ProcessResult(instruction.result_operation, instruction.dst,
+                      GetRegister(instruction.src_a) + instruction.immediate);
+        break;
+    }
+    case Operation::ExtractInsert: {
+        u32 dst = GetRegister(instruction.src_a);
+        u32 src = GetRegister(instruction.src_b);
+
+        src = (src >> instruction.bf_src_bit) & instruction.bitfield_mask;
+        dst &= ~(instruction.bitfield_mask << instruction.bf_dst_bit);
+        dst |= src << instruction.bf_dst_bit;
+        ProcessResult(instruction.result_operation, instruction.dst, dst);
+        break;
+    }
+    case Operation::ExtractShiftLeftImmediate: {
+        const u32 dst = GetRegister(instruction.src_a);
+        const u32 src = GetRegister(instruction.src_b);
+
+        const u32 result = ((src >> dst) & instruction.bitfield_mask) << instruction.bf_dst_bit;
+
+        ProcessResult(instruction.result_operation, instruction.dst, result);
+        break;
+    }
+    case Operation::ExtractShiftLeftRegister: {
+        const u32 dst = GetRegister(instruction.src_a);
+        const u32 src = GetRegister(instruction.src_b);
+
+        const u32 result = ((src >> instruction.bf_src_bit) & instruction.bitfield_mask) << dst;
+
+        ProcessResult(instruction.result_operation, instruction.dst, result);
+        break;
+    }
+    case Operation::Read: {
+        const u32 result = Read(GetRegister(instruction.src_a) + instruction.immediate);
+        ProcessResult(instruction.result_operation, instruction.dst, result);
+        break;
+    }
+    case Operation::Branch: {
+        ASSERT_MSG(!is_delay_slot, "Executing a branch in a delay slot is not valid");
+        const u32 value = GetRegister(instruction.src_a);
+        if (EvaluateBranchCondition(instruction.branch_condition, value)) {
+            // Ignore the delay slot if the branch has the annul bit.
+            if (instruction.branch_annul) {
+                pc = instruction.branch_target;
+                return true;
+            }
+
+            delayed_pc = instruction.branch_target;
+            // Execute one more instruction due to the delay slot.
+            return StepDecoded(program, true);
+        }
+        break;
+    }
+    default:
+        UNREACHABLE();
+    }
+
+    if (instruction.is_exit) {
+        // Exit has a delay slot, execute the next instruction
+        StepDecoded(program, true);
+        return false;
+    }
+
+    return true;
+}
+
 MacroInterpreter::Opcode MacroInterpreter::GetOpcode(const std::vector<u32>& code) const {
     ASSERT((pc % sizeof(u32)) == 0);
     ASSERT(pc < code.size() * sizeof(u32));
@@ -206,7 +376,7 @@ void MacroInterpreter::ProcessResult(ResultOperation operation, u32 reg, u32 res
 }
 
 u32 MacroInterpreter::FetchParameter() {
-    ASSERT(next_parameter_index < parameters.size());
+    ASSERT(next_parameter_index < num_parameters);
     return parameters[next_parameter_index++];
 }
 
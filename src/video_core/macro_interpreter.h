@@ -22,9 +22,10 @@ public:
     /**
      * Executes the macro code with the specified input parameters.
      * @param code The macro byte code to execute
-     * @param parameters The parameters of the macro
+     * @param parameters The parameters of the macro, which are only read during the call
+     * @param num_parameters The number of parameters
      */
-    void Execute(const std::vector<u32>& code, std::vector<u32> parameters);
+    void Execute(const std::vector<u32>& code, const u32* parameters, size_t num_parameters);
 
 private:
     enum class Operation : u32 {
@@ -99,6 +100,55 @@ private:
         BitField<12, 6, u32> increment;
     };
 
+    /// An instruction with its fields extracted from the opcode, and its branch target resolved.
+    struct DecodedInstruction {
+        Operation operation;
+        ResultOperation result_operation;
+        ALUOperation alu_operation;
+        BranchCondition branch_condition;
+        bool branch_annul;
+        bool is_exit;
+        u8 dst;
+        u8 src_a;
+        u8 src_b;
+        u8 bf_src_bit;
+        u8 bf_dst_bit;
+        s32 immediate;
+        u32 bitfield_mask;
+        /// Index of the instruction a branch goes to.
+        u32 branch_target;
+    };
+
+public:
+    /**
+     * Macro code decoded ahead of time, so that calls to the macro run through it without
+     * decoding instructions again.
+     */
+    class Program final {
+    private:
+        friend class MacroInterpreter;
+        std::vector<DecodedInstruction> instructions;
+    };
+
+    /**
+     * Decodes macro code into a program.
+     * @param code The macro byte code to decode.
+     * @returns The program, or none if the code uses operations the decoded form doesn't support
+     * or branches out of the code. Those are left to the interpreter.
+     */
+    static boost::optional<Program> Compile(const std::vector<u32>& code);
+
+    /**
+     * Executes a decoded macro program with the specified input parameters. This behaves exactly
+     * like executing the code the program was decoded from.
+     * @param program The program to execute
+     * @param parameters The parameters of the macro, which are only read during the call
+     * @param num_parameters The number of parameters
+     */
+    void Execute(const Program& program, const u32* parameters, size_t num_parameters);
+
+private:
+
     /// Resets the execution engine state, zeroing registers, etc.
     void Reset();
 
@@ -111,6 +161,9 @@ private:
      */
     bool Step(const std::vector<u32>& code, bool is_delay_slot);
 
+    /// Executes a single instruction of a decoded program, the same way Step does.
+    bool StepDecoded(const Program& program, bool is_delay_slot);
+
     /// Calculates the result of an ALU operation. src_a OP src_b;
     u32 GetALUResult(ALUOperation operation, u32 src_a, u32 src_b) const;
 
@@ -156,8 +209,9 @@ private:
     /// Method address to use for the next Send instruction.
     MethodAddress method_address = {};
 
-    /// Input parameters of the current macro.
-    std::vector<u32> parameters;
+    /// Input parameters of the current macro, owned by the caller.
+    const u32* parameters = nullptr;
+    size_t num_parameters = 0;
     /// Index of the next parameter that will be fetched by the 'parm' instruction.
     u32 next_parameter_index = 0;
 };
@@ -2,50 +2,75 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cinttypes>
+#include <iterator>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "video_core/memory_manager.h"
 
 namespace Tegra {
 
+namespace {
+
+/// Page-aligned range that covers all the pages a range touches
+struct PageRange {
+    PAddr start;
+    u64 size;
+};
+
+PageRange GetPageRange(PAddr paddr, u64 size) {
+    const PAddr start = paddr & ~Memory::PAGE_MASK;
+    return {start, Common::AlignUp(paddr + size, Memory::PAGE_SIZE) - start};
+}
+
+} // Anonymous namespace
+
+MemoryManager::MemoryManager() {
+    free_ranges.emplace(0, MAX_ADDRESS);
+    free_ranges_by_size.emplace(MAX_ADDRESS, 0);
+}
+
 PAddr MemoryManager::AllocateSpace(u64 size, u64 align) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     boost::optional<PAddr> paddr = FindFreeBlock(size, align);
     ASSERT(paddr);
 
-    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
-        PageSlot(*paddr + offset) = static_cast<u64>(PageStatus::Allocated);
-    }
-
+    const PageRange range = GetPageRange(*paddr, size);
+    ReserveRange(range.start, range.size);
+    SetPageStatus(range.start, range.size, PageStatus::Allocated);
     return *paddr;
 }
 
 PAddr MemoryManager::AllocateSpace(PAddr paddr, u64 size, u64 align) {
-    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
-        if (IsPageMapped(paddr + offset)) {
-            return AllocateSpace(size, align);
-        }
-    }
-
-    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
-        PageSlot(paddr + offset) = static_cast<u64>(PageStatus::Allocated);
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const PageRange range = GetPageRange(paddr, size);
+    if (!IsRangeFree(range.start, range.size)) {
+        return AllocateSpace(size, align);
     }
 
+    ReserveRange(range.start, range.size);
+    SetPageStatus(range.start, range.size, PageStatus::Allocated);
     return paddr;
 }
 
 PAddr MemoryManager::MapBufferEx(VAddr vaddr, u64 size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     vaddr &= ~Memory::PAGE_MASK;
 
     boost::optional<PAddr> paddr = FindFreeBlock(size);
     ASSERT(paddr);
 
-    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
-        PageSlot(*paddr + offset) = vaddr + offset;
-    }
-
+    const PageRange range = GetPageRange(*paddr, size);
+    ReserveRange(range.start, range.size);
+    MapPages(*paddr, size, vaddr);
+    mapped_buffers[*paddr] = {size, false};
+    ++mapping_generation;
     return *paddr;
 }
 
 PAddr MemoryManager::MapBufferEx(VAddr vaddr, PAddr paddr, u64 size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     vaddr &= ~Memory::PAGE_MASK;
     paddr &= ~Memory::PAGE_MASK;
 
@@ -55,45 +80,112 @@ PAddr MemoryManager::MapBufferEx(VAddr vaddr, PAddr paddr, u64 size) {
         }
     }
 
+    MapPages(paddr, size, vaddr);
+    mapped_buffers[paddr] = {size, true};
+    ++mapping_generation;
+    return paddr;
+}
+
+void MemoryManager::MapBufferAt(VAddr vaddr, PAddr paddr, u64 size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    vaddr &= ~Memory::PAGE_MASK;
+    paddr &= ~Memory::PAGE_MASK;
+
     for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
-        PageSlot(paddr + offset) = vaddr + offset;
+        const VAddr status = PageSlot(paddr + offset);
+        if (status == static_cast<u64>(PageStatus::Unmapped)) {
+            ReserveRange(paddr + offset, Memory::PAGE_SIZE);
+        } else {
+            ASSERT_MSG(status == static_cast<u64>(PageStatus::Allocated),
+                       "GPU page 0x%016" PRIX64 " is already mapped", paddr + offset);
+        }
     }
 
-    return paddr;
+    MapPages(paddr, size, vaddr);
+    mapped_buffers[paddr] = {size, true};
+    ++mapping_generation;
+}
+
+std::vector<MemoryManager::MappedRange> MemoryManager::UnmapBuffer(PAddr paddr) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    const auto it = mapped_buffers.find(paddr);
+    ASSERT_MSG(it != mapped_buffers.end(), "No buffer is mapped at 0x%016" PRIX64, paddr);
+    const MappedBuffer buffer = it->second;
+    mapped_buffers.erase(it);
+    ++mapping_generation;
+
+    std::vector<MappedRange> ranges = GetMappedRanges(paddr, buffer.size);
+
+    const PageRange range = GetPageRange(paddr, buffer.size);
+    if (buffer.in_allocated_space) {
+        SetPageStatus(range.start, range.size, PageStatus::Allocated);
+    } else {
+        SetPageStatus(range.start, range.size, PageStatus::Unmapped);
+        ReleaseRange(range.start, range.size);
+    }
+    return ranges;
 }
 
 boost::optional<PAddr> MemoryManager::FindFreeBlock(u64 size, u64 align) {
-    PAddr paddr{};
-    u64 free_space{};
-    align = (align + Memory::PAGE_MASK) & ~Memory::PAGE_MASK;
-
-    while (paddr + free_space < MAX_ADDRESS) {
-        if (!IsPageMapped(paddr + free_space)) {
-            free_space += Memory::PAGE_SIZE;
-            if (free_space >= size) {
-                return paddr;
-            }
-        } else {
-            paddr += free_space + Memory::PAGE_SIZE;
-            free_space = 0;
-            const u64 remainder{paddr % align};
-            if (!remainder) {
-                paddr = (paddr - remainder) + align;
-            }
+    align = Common::AlignUp(align, Memory::PAGE_SIZE);
+    size = Common::AlignUp(size, Memory::PAGE_SIZE);
+
+    // The smallest free range that is large enough is the first one by size. Larger ones only
+    // have to be tried when aligning the start leaves too little of it.
+    for (auto it = free_ranges_by_size.lower_bound({size, 0}); it != free_ranges_by_size.end();
+         ++it) {
+        const auto [free_size, free_start] = *it;
+        const PAddr paddr = Common::AlignUp(free_start, align);
+        if (paddr + size <= free_start + free_size) {
+            return paddr;
         }
     }
-
     return {};
 }
 
 VAddr MemoryManager::PhysicalToVirtualAddress(PAddr paddr) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
     VAddr base_addr = PageSlot(paddr);
     ASSERT(base_addr != static_cast<u64>(PageStatus::Unmapped));
     return base_addr + (paddr & Memory::PAGE_MASK);
 }
 
-bool MemoryManager::IsPageMapped(PAddr paddr) {
-    return PageSlot(paddr) != static_cast<u64>(PageStatus::Unmapped);
+std::vector<MemoryManager::MappedRange> MemoryManager::GetMappedRanges(PAddr paddr, u64 size) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<MappedRange> ranges;
+    while (size > 0) {
+        const u64 page_offset = paddr & Memory::PAGE_MASK;
+        const u64 chunk_size = std::min(size, Memory::PAGE_SIZE - page_offset);
+
+        const VAddr base_addr = PageSlot(paddr);
+        ASSERT(base_addr != static_cast<u64>(PageStatus::Unmapped));
+        const VAddr cpu_addr = base_addr + page_offset;
+
+        if (!ranges.empty() && ranges.back().cpu_addr + ranges.back().size == cpu_addr) {
+            ranges.back().size += chunk_size;
+        } else {
+            ranges.push_back({cpu_addr, chunk_size});
+        }
+
+        paddr += chunk_size;
+        size -= chunk_size;
+    }
+    return ranges;
+}
+
+std::vector<MemoryManager::Mapping> MemoryManager::GetMappings() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<Mapping> mappings;
+    mappings.reserve(mapped_buffers.size());
+    for (const auto& [gpu_addr, buffer] : mapped_buffers) {
+        mappings.push_back({gpu_addr, PageSlot(gpu_addr), buffer.size});
+    }
+    return mappings;
+}
+
+u64 MemoryManager::GetMappingGeneration() {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    return mapping_generation;
 }
 
 VAddr& MemoryManager::PageSlot(PAddr paddr) {
@@ -107,4 +199,67 @@ VAddr& MemoryManager::PageSlot(PAddr paddr) {
     return (*block)[(paddr >> Memory::PAGE_BITS) & PAGE_BLOCK_MASK];
 }
 
+bool MemoryManager::IsRangeFree(PAddr paddr, u64 size) const {
+    auto it = free_ranges.upper_bound(paddr);
+    if (it == free_ranges.begin()) {
+        return false;
+    }
+    --it;
+    return paddr + size <= it->first + it->second;
+}
+
+void MemoryManager::ReserveRange(PAddr paddr, u64 size) {
+    auto it = free_ranges.upper_bound(paddr);
+    ASSERT(it != free_ranges.begin());
+    --it;
+    const auto [free_start, free_size] = *it;
+    ASSERT(paddr + size <= free_start + free_size);
+
+    free_ranges.erase(it);
+    free_ranges_by_size.erase({free_size, free_start});
+
+    // Whatever is left of the free range before and after the reserved one stays free
+    if (paddr > free_start) {
+        free_ranges.emplace(free_start, paddr - free_start);
+        free_ranges_by_size.emplace(paddr - free_start, free_start);
+    }
+    const PAddr free_end = free_start + free_size;
+    if (paddr + size < free_end) {
+        free_ranges.emplace(paddr + size, free_end - (paddr + size));
+        free_ranges_by_size.emplace(free_end - (paddr + size), paddr + size);
+    }
+}
+
+void MemoryManager::ReleaseRange(PAddr paddr, u64 size) {
+    auto next = free_ranges.lower_bound(paddr);
+    if (next != free_ranges.end() && next->first == paddr + size) {
+        size += next->second;
+        free_ranges_by_size.erase({next->second, next->first});
+        next = free_ranges.erase(next);
+    }
+    if (next != free_ranges.begin()) {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == paddr) {
+            paddr = previous->first;
+            size += previous->second;
+            free_ranges_by_size.erase({previous->second, previous->first});
+            free_ranges.erase(previous);
+        }
+    }
+    free_ranges.emplace(paddr, size);
+    free_ranges_by_size.emplace(size, paddr);
+}
+
+void MemoryManager::MapPages(PAddr paddr, u64 size, VAddr vaddr) {
+    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
+        PageSlot(paddr + offset) = vaddr + offset;
+    }
+}
+
+void MemoryManager::SetPageStatus(PAddr paddr, u64 size, PageStatus status) {
+    for (u64 offset = 0; offset < size; offset += Memory::PAGE_SIZE) {
+        PageSlot(paddr + offset) = static_cast<u64>(status);
+    }
+}
+
 } // namespace Tegra
@@ -5,7 +5,13 @@
 #pragma once
 
 #include <array>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "core/memory.h"
 
@@ -16,24 +22,91 @@ using GPUVAddr = u64;
 
 class MemoryManager final {
 public:
-    MemoryManager() = default;
+    MemoryManager();
+
+    /// Range of application memory that a range of GPU memory is mapped to
+    struct MappedRange {
+        VAddr cpu_addr;
+        u64 size;
+    };
 
     PAddr AllocateSpace(u64 size, u64 align);
     PAddr AllocateSpace(PAddr paddr, u64 size, u64 align);
     PAddr MapBufferEx(VAddr vaddr, u64 size);
     PAddr MapBufferEx(VAddr vaddr, PAddr paddr, u64 size);
+
+    /**
+     * Unmaps a buffer mapped with MapBufferEx. Its pages go back to the space they were allocated
+     * from when it was mapped at a fixed address, and are freed otherwise.
+     * @param paddr GPU address the buffer was mapped at.
+     * @returns The ranges of application memory the buffer was mapped to, in order.
+     */
+    std::vector<MappedRange> UnmapBuffer(PAddr paddr);
+
     VAddr PhysicalToVirtualAddress(PAddr paddr);
 
-private:
-    boost::optional<PAddr> FindFreeBlock(u64 size, u64 align = 1);
-    bool IsPageMapped(PAddr paddr);
-    VAddr& PageSlot(PAddr paddr);
+    /**
+     * Translates a range of GPU memory to application memory. Consecutive GPU pages are merged
+     * into one range when they are mapped to consecutive application memory, so that the memory
+     * can be accessed a range at a time instead of a page at a time.
+     * @param paddr GPU address of the start of the range.
+     * @param size Size of the range in bytes.
+     * @returns The ranges of application memory, in order.
+     */
+    std::vector<MappedRange> GetMappedRanges(PAddr paddr, u64 size);
+
+    /// A buffer mapped with MapBufferEx, to consecutive application memory
+    struct Mapping {
+        PAddr gpu_addr;
+        VAddr cpu_addr;
+        u64 size;
+
+        bool operator==(const Mapping& other) const {
+            return gpu_addr == other.gpu_addr && cpu_addr == other.cpu_addr &&
+                   size == other.size;
+        }
+    };
+
+    /// Returns all the buffers that are mapped, ordered by their GPU address.
+    std::vector<Mapping> GetMappings();
+
+    /// Returns a number that changes whenever a buffer is mapped or unmapped.
+    u64 GetMappingGeneration();
 
+    /**
+     * Maps a buffer at exactly the given GPU address, taking the space it needs if it isn't
+     * allocated yet. This is for rebuilding recorded mappings, the space stays allocated when the
+     * buffer is unmapped.
+     */
+    void MapBufferAt(VAddr vaddr, PAddr paddr, u64 size);
+
+private:
     enum class PageStatus : u64 {
         Unmapped = 0xFFFFFFFFFFFFFFFFULL,
         Allocated = 0xFFFFFFFFFFFFFFFEULL,
     };
 
+    struct MappedBuffer {
+        u64 size;
+        /// Whether the buffer was mapped at a fixed address, in space allocated beforehand
+        bool in_allocated_space;
+    };
+
+    boost::optional<PAddr> FindFreeBlock(u64 size, u64 align = 1);
+    VAddr& PageSlot(PAddr paddr);
+
+    /// Returns whether the pages of a range are all free.
+    bool IsRangeFree(PAddr paddr, u64 size) const;
+    /// Takes the pages of a range, which have to be free, out of the free ranges.
+    void ReserveRange(PAddr paddr, u64 size);
+    /// Gives the pages of a range back to the free ranges, merged with the ones next to them.
+    void ReleaseRange(PAddr paddr, u64 size);
+
+    /// Maps the pages of a range to consecutive pages of application memory.
+    void MapPages(PAddr paddr, u64 size, VAddr vaddr);
+    /// Sets the pages of a range to a status, without mapping them.
+    void SetPageStatus(PAddr paddr, u64 size, PageStatus status);
+
     static constexpr u64 MAX_ADDRESS{0x10000000000ULL};
     static constexpr u64 PAGE_TABLE_BITS{14};
     static constexpr u64 PAGE_TABLE_SIZE{1 << PAGE_TABLE_BITS};
@@ -44,6 +117,19 @@ private:
 
     using PageBlock = std::array<VAddr, PAGE_BLOCK_SIZE>;
     std::array<std::unique_ptr<PageBlock>, PAGE_TABLE_SIZE> page_table{};
+
+    /// Page-aligned ranges that are neither allocated nor mapped, by their start. They are also
+    /// kept by their size, so that the smallest one a block fits in is found in logarithmic time.
+    std::map<PAddr, u64> free_ranges;
+    std::set<std::pair<u64, PAddr>> free_ranges_by_size;
+
+    /// Buffers mapped with MapBufferEx, by the GPU address they were mapped at.
+    std::map<PAddr, MappedBuffer> mapped_buffers;
+    u64 mapping_generation = 0;
+
+    /// Maps are made from the CPU thread and looked up by the GPU thread, when it has one. Mapping
+    /// falls back to allocating anew, which takes the lock again.
+    std::recursive_mutex mutex;
 };
 
 } // namespace Tegra
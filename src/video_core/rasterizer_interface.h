@@ -5,6 +5,7 @@
 #pragma once
 
 #include "common/common_types.h"
+#include "video_core/engines/fermi_2d.h"
 #include "video_core/gpu.h"
 
 struct ScreenInfo;
@@ -18,8 +19,8 @@ public:
     /// Draw the current batch of vertex arrays
     virtual void DrawArrays() = 0;
 
-    /// Notify rasterizer that the specified Maxwell register has been changed
-    virtual void NotifyMaxwellRegisterChanged(u32 method) = 0;
+    /// Clear the current framebuffer, as selected by the CLEAR_BUFFERS register
+    virtual void Clear() = 0;
 
     /// Notify rasterizer that all caches should be flushed to Switch memory
     virtual void FlushAll() = 0;
@@ -34,6 +35,24 @@ public:
     /// and invalidated
     virtual void FlushAndInvalidateRegion(VAddr addr, u64 size) = 0;
 
+    /// Notify rasterizer that a frame has been presented
+    virtual void TickFrame() {}
+
+    /// Attempt to report the number of samples that passed the depth and stencil tests so far to
+    /// guest memory, as a 32-bit value or as a 16 byte report with a timestamp
+    virtual bool ReportSamplesPassed(VAddr addr, bool long_report, u64 timestamp) {
+        return false;
+    }
+
+    /// Load the resources the rasterizer keeps on disk, such as its shaders
+    virtual void LoadDiskResources(const Tegra::DiskResourceLoadCallback& callback) {}
+
+    /// Attempt to queue an asynchronous copy of the surface cached at addr. Unlike the other
+    /// calls, this can be made from any thread.
+    virtual bool RequestSurfaceCapture(VAddr addr, Tegra::SurfaceCaptureCallback callback) {
+        return false;
+    }
+
     /// Attempt to use a faster method to perform a display transfer with is_texture_copy = 0
     virtual bool AccelerateDisplayTransfer(const void* config) {
         return false;
@@ -49,6 +68,12 @@ public:
         return false;
     }
 
+    /// Attempt to use a faster method to perform a surface copy of the 2D engine
+    virtual bool AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                                       const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
+        return false;
+    }
+
     /// Attempt to use a faster method to display the framebuffer to screen
     virtual bool AccelerateDisplay(const Tegra::FramebufferConfig& framebuffer,
                                    VAddr framebuffer_addr, u32 pixel_stride,
@@ -5,7 +5,7 @@
 #pragma once
 
 #include <memory>
-#include <boost/optional.hpp>
+#include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "video_core/gpu.h"
@@ -20,8 +20,8 @@ public:
 
     virtual ~RendererBase() {}
 
-    /// Swap buffers (render frame)
-    virtual void SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) = 0;
+    /// Swap buffers (render frame), drawing the layers from the first one to the last
+    virtual void SwapBuffers(const std::vector<Tegra::FramebufferConfig>& layers) = 0;
 
     /**
      * Set the emulator window to use for renderer
@@ -0,0 +1,720 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/renderer_opengl/gl_astc_decoder.h"
+#include "video_core/renderer_opengl/gl_state.h"
+
+namespace {
+
+// Each invocation decodes one texel, from the block header, the endpoints of its partition, and
+// the weights of the grid points around it. That repeats the header decode for every texel of a
+// block, but keeps the decode of a block in parallel, with no shared memory. The source is split in
+// parts, as MSVC limits the length of string literals.
+constexpr const char* DECODER_SOURCE = R"(
+#version 430 core
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(std430, binding = 0) readonly buffer Blocks {
+    uvec4 blocks[];
+};
+layout(std430, binding = 1) writeonly buffer Texels {
+    uint texels[];
+};
+
+uniform uvec2 image_size;
+uniform uvec2 block_size;
+
+// Magenta, which the spec mandates for blocks that aren't valid LDR blocks
+const uint ERROR_COLOR = 0xFFFF00FFu;
+
+// Bits of each value, and whether the values are bits with a trit (1) or quint (2) each, for the
+// 21 integer sequence encodings, from 2 up to 256 levels.
+const uint ISE_BITS[21] = uint[](1, 0, 2, 0, 1, 3, 1, 2, 4, 2, 3, 5, 3, 4, 6, 4, 5, 7, 5, 6, 8);
+const uint ISE_KIND[21] = uint[](0, 1, 0, 2, 1, 0, 2, 1, 0, 2, 1, 0, 2, 1, 0, 2, 1, 0, 2, 1, 0);
+
+uint GetBits(uvec4 data, uint start, uint count) {
+    if (count == 0u) {
+        return 0u;
+    }
+    uint word = start >> 5u;
+    uint shift = start & 31u;
+    uint value = data[word] >> shift;
+    if (shift + count > 32u && word < 3u) {
+        value |= data[word + 1u] << (32u - shift);
+    }
+    return value & ((1u << count) - 1u);
+}
+
+// Reads bits of an integer sequence, where the bits past its end read as zeros.
+uint GetSequenceBits(uvec4 data, uint start, uint count, uint end) {
+    if (start >= end) {
+        return 0u;
+    }
+    return GetBits(data, start, min(count, end - start));
+}
+
+uint GetSequenceSize(uint quant, uint count) {
+    uint size = ISE_BITS[quant] * count;
+    if (ISE_KIND[quant] == 1u) {
+        size += (8u * count + 4u) / 5u;
+    } else if (ISE_KIND[quant] == 2u) {
+        size += (7u * count + 2u) / 3u;
+    }
+    return size;
+}
+
+uint DecodeTrit(uint bits, uint index) {
+    uint t[5];
+    uint c;
+    if (((bits >> 2u) & 7u) == 7u) {
+        c = (((bits >> 5u) & 7u) << 2u) | (bits & 3u);
+        t[4] = 2u;
+        t[3] = 2u;
+    } else {
+        c = bits & 0x1Fu;
+        if (((bits >> 5u) & 3u) == 3u) {
+            t[4] = 2u;
+            t[3] = (bits >> 7u) & 1u;
+        } else {
+            t[4] = (bits >> 7u) & 1u;
+            t[3] = (bits >> 5u) & 3u;
+        }
+    }
+    if ((c & 3u) == 3u) {
+        t[2] = 2u;
+        t[1] = (c >> 4u) & 1u;
+        t[0] = (((c >> 3u) & 1u) << 1u) | ((c >> 2u) & ~(c >> 3u) & 1u);
+    } else if (((c >> 2u) & 3u) == 3u) {
+        t[2] = 2u;
+        t[1] = 2u;
+        t[0] = c & 3u;
+    } else {
+        t[2] = (c >> 4u) & 1u;
+        t[1] = (c >> 2u) & 3u;
+        t[0] = (c & 2u) | (c & ~(c >> 1u) & 1u);
+    }
+    return t[index];
+}
+
+uint DecodeQuint(uint bits, uint index) {
+    uint q[3];
+    if (((bits >> 1u) & 3u) == 3u && ((bits >> 5u) & 3u) == 0u) {
+        q[2] = ((bits & 1u) << 2u) | (((bits >> 4u) & ~bits & 1u) << 1u) |
+               ((bits >> 3u) & ~bits & 1u);
+        q[1] = 4u;
+        q[0] = 4u;
+    } else {
+        uint c;
+        if (((bits >> 1u) & 3u) == 3u) {
+            q[2] = 4u;
+            c = (((bits >> 3u) & 3u) << 3u) | ((~bits >> 4u) & 6u) | (bits & 1u);
+        } else {
+            q[2] = (bits >> 5u) & 3u;
+            c = bits & 0x1Fu;
+        }
+        if ((c & 7u) == 5u) {
+            q[1] = 4u;
+            q[0] = (c >> 3u) & 3u;
+        } else {
+            q[1] = (c >> 3u) & 3u;
+            q[0] = c & 7u;
+        }
+    }
+    return q[index];
+}
+
+// Returns the bits and the trit or quint of a value of an integer sequence.
+uvec2 DecodeSequenceValue(uvec4 data, uint start, uint end, uint quant, uint index) {
+    uint n = ISE_BITS[quant];
+    if (ISE_KIND[quant] == 0u) {
+        return uvec2(GetSequenceBits(data, start + index * n, n, end), 0u);
+    }
+    if (ISE_KIND[quant] == 1u) {
+        // Groups of five values share eight bits of trits, spread between their bits
+        uint base = start + (index / 5u) * (5u * n + 8u);
+        uint bits = GetSequenceBits(data, base + n, 2u, end) |
+                      (GetSequenceBits(data, base + 2u * n + 2u, 2u, end) << 2u) |
+                      (GetSequenceBits(data, base + 3u * n + 4u, 1u, end) << 4u) |
+                      (GetSequenceBits(data, base + 4u * n + 5u, 2u, end) << 5u) |
+                      (GetSequenceBits(data, base + 5u * n + 7u, 1u, end) << 7u);
+        uint offsets[5] = uint[](0u, n + 2u, 2u * n + 4u, 3u * n + 5u, 4u * n + 7u);
+        uint value_index = index % 5u;
+        return uvec2(GetSequenceBits(data, base + offsets[value_index], n, end),
+                     DecodeTrit(bits, value_index));
+    }
+    // Groups of three values share seven bits of quints
+    uint base = start + (index / 3u) * (3u * n + 7u);
+    uint bits = GetSequenceBits(data, base + n, 3u, end) |
+                  (GetSequenceBits(data, base + 2u * n + 3u, 2u, end) << 3u) |
+                  (GetSequenceBits(data, base + 3u * n + 5u, 2u, end) << 5u);
+    uint offsets[3] = uint[](0u, n + 3u, 2u * n + 5u);
+    uint value_index = index % 3u;
+    return uvec2(GetSequenceBits(data, base + offsets[value_index], n, end),
+                 DecodeQuint(bits, value_index));
+}
+
+uint Replicate(uint value, uint num_bits, uint to_bits) {
+    if (num_bits == 0u) {
+        return 0u;
+    }
+    uint result = 0u;
+    uint length = 0u;
+    while (length < to_bits) {
+        uint count = min(num_bits, to_bits - length);
+        result = (result << count) | (value >> (num_bits - count));
+        length += count;
+    }
+    return result;
+}
+
+)"
+R"(uint UnquantizeColor(uint quant, uvec2 value) {
+    uint n = ISE_BITS[quant];
+    if (ISE_KIND[quant] == 0u) {
+        return Replicate(value.x, n, 8u);
+    }
+    uint a = (value.x & 1u) != 0u ? 0x1FFu : 0u;
+    uint b = value.x >> 1u;
+    uint scale;
+    uint offset;
+    if (ISE_KIND[quant] == 1u) {
+        switch (n) {
+        case 1u:
+            scale = 204u;
+            offset = 0u;
+            break;
+        case 2u:
+            scale = 93u;
+            offset = (b << 8u) | (b << 4u) | (b << 2u) | (b << 1u);
+            break;
+        case 3u:
+            scale = 44u;
+            offset = (b << 7u) | (b << 2u) | b;
+            break;
+        case 4u:
+            scale = 22u;
+            offset = (b << 6u) | b;
+            break;
+        case 5u:
+            scale = 11u;
+            offset = (b << 5u) | (b >> 2u);
+            break;
+        default:
+            scale = 5u;
+            offset = (b << 4u) | (b >> 4u);
+            break;
+        }
+    } else {
+        switch (n) {
+        case 1u:
+            scale = 113u;
+            offset = 0u;
+            break;
+        case 2u:
+            scale = 54u;
+            offset = (b << 8u) | (b << 3u) | (b << 2u);
+            break;
+        case 3u:
+            scale = 26u;
+            offset = (b << 7u) | (b << 1u) | (b >> 1u);
+            break;
+        case 4u:
+            scale = 13u;
+            offset = (b << 6u) | (b >> 1u);
+            break;
+        default:
+            scale = 6u;
+            offset = (b << 5u) | (b >> 3u);
+            break;
+        }
+    }
+    uint result = (value.y * scale + offset) ^ a;
+    return (a & 0x80u) | (result >> 2u);
+}
+
+uint UnquantizeWeight(uint quant, uvec2 value) {
+    uint n = ISE_BITS[quant];
+    uint result;
+    if (ISE_KIND[quant] == 0u) {
+        result = Replicate(value.x, n, 6u);
+    } else if (n == 0u) {
+        uint trits[3] = uint[](0u, 32u, 63u);
+        uint quints[5] = uint[](0u, 16u, 32u, 47u, 63u);
+        result = ISE_KIND[quant] == 1u ? trits[value.y] : quints[value.y];
+    } else {
+        uint a = (value.x & 1u) != 0u ? 0x7Fu : 0u;
+        uint b = value.x >> 1u;
+        uint scale;
+        uint offset = 0u;
+        if (ISE_KIND[quant] == 1u) {
+            if (n == 1u) {
+                scale = 50u;
+            } else if (n == 2u) {
+                scale = 23u;
+                offset = (b << 6u) | (b << 2u) | b;
+            } else {
+                scale = 11u;
+                offset = (b << 5u) | b;
+            }
+        } else {
+            if (n == 1u) {
+                scale = 28u;
+            } else {
+                scale = 13u;
+                offset = (b << 6u) | (b << 1u);
+            }
+        }
+        result = (a & 0x20u) | (((value.y * scale + offset) ^ a) >> 2u);
+    }
+    return result > 32u ? result + 1u : result;
+}
+
+void BitTransferSigned(inout int a, inout int b) {
+    b >>= 1;
+    b |= a & 0x80;
+    a >>= 1;
+    a &= 0x3F;
+    if ((a & 0x20) != 0) {
+        a -= 0x40;
+    }
+}
+
+ivec4 BlueContract(int r, int g, int b, int a) {
+    return ivec4((r + b) >> 1, (g + b) >> 1, b, a);
+}
+
+// Decodes the endpoints of the LDR color endpoint modes, returns false for the HDR ones.
+bool DecodeEndpoints(uint mode, int v[8], out ivec4 e0, out ivec4 e1) {
+    switch (mode) {
+    case 0u:
+        e0 = ivec4(v[0], v[0], v[0], 0xFF);
+        e1 = ivec4(v[1], v[1], v[1], 0xFF);
+        return true;
+    case 1u: {
+        int l0 = (v[0] >> 2) | (v[1] & 0xC0);
+        int l1 = min(l0 + (v[1] & 0x3F), 0xFF);
+        e0 = ivec4(l0, l0, l0, 0xFF);
+        e1 = ivec4(l1, l1, l1, 0xFF);
+        return true;
+    }
+    case 4u:
+        e0 = ivec4(v[0], v[0], v[0], v[2]);
+        e1 = ivec4(v[1], v[1], v[1], v[3]);
+        return true;
+    case 5u:
+        BitTransferSigned(v[1], v[0]);
+        BitTransferSigned(v[3], v[2]);
+        e0 = clamp(ivec4(v[0], v[0], v[0], v[2]), 0, 0xFF);
+        e1 = clamp(ivec4(v[0] + v[1], v[0] + v[1], v[0] + v[1], v[2] + v[3]), 0, 0xFF);
+        return true;
+    case 6u:
+        e0 = ivec4((v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, 0xFF);
+        e1 = ivec4(v[0], v[1], v[2], 0xFF);
+        return true;
+    case 8u:
+        if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
+            e0 = ivec4(v[0], v[2], v[4], 0xFF);
+            e1 = ivec4(v[1], v[3], v[5], 0xFF);
+        } else {
+            e0 = BlueContract(v[1], v[3], v[5], 0xFF);
+            e1 = BlueContract(v[0], v[2], v[4], 0xFF);
+        }
+        return true;
+    case 9u:
+        BitTransferSigned(v[1], v[0]);
+        BitTransferSigned(v[3], v[2]);
+        BitTransferSigned(v[5], v[4]);
+        if (v[1] + v[3] + v[5] >= 0) {
+            e0 = ivec4(v[0], v[2], v[4], 0xFF);
+            e1 = ivec4(v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF);
+        } else {
+            e0 = BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], 0xFF);
+            e1 = BlueContract(v[0], v[2], v[4], 0xFF);
+        }
+        e0 = clamp(e0, 0, 0xFF);
+        e1 = clamp(e1, 0, 0xFF);
+        return true;
+    case 10u:
+        e0 = ivec4((v[0] * v[3]) >> 8, (v[1] * v[3]) >> 8, (v[2] * v[3]) >> 8, v[4]);
+        e1 = ivec4(v[0], v[1], v[2], v[5]);
+        return true;
+    case 12u:
+        if (v[1] + v[3] + v[5] >= v[0] + v[2] + v[4]) {
+            e0 = ivec4(v[0], v[2], v[4], v[6]);
+            e1 = ivec4(v[1], v[3], v[5], v[7]);
+        } else {
+            e0 = BlueContract(v[1], v[3], v[5], v[7]);
+            e1 = BlueContract(v[0], v[2], v[4], v[6]);
+        }
+        return true;
+    case 13u:
+        BitTransferSigned(v[1], v[0]);
+        BitTransferSigned(v[3], v[2]);
+        BitTransferSigned(v[5], v[4]);
+        BitTransferSigned(v[7], v[6]);
+        if (v[1] + v[3] + v[5] >= 0) {
+            e0 = ivec4(v[0], v[2], v[4], v[6]);
+            e1 = ivec4(v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+        } else {
+            e0 = BlueContract(v[0] + v[1], v[2] + v[3], v[4] + v[5], v[6] + v[7]);
+            e1 = BlueContract(v[0], v[2], v[4], v[6]);
+        }
+        e0 = clamp(e0, 0, 0xFF);
+        e1 = clamp(e1, 0, 0xFF);
+        return true;
+    default:
+        e0 = ivec4(0);
+        e1 = ivec4(0);
+        return false;
+    }
+}
+
+)"
+R"(uint Hash52(uint value) {
+    value ^= value >> 15u;
+    value *= 0xEEDE0891u;
+    value ^= value >> 5u;
+    value += value << 16u;
+    value ^= value >> 7u;
+    value ^= value >> 3u;
+    value ^= value << 6u;
+    value ^= value >> 17u;
+    return value;
+}
+
+uint SelectPartition(uint seed, uint x, uint y, uint partition_count, bool small_block) {
+    if (small_block) {
+        x <<= 1u;
+        y <<= 1u;
+    }
+    seed += (partition_count - 1u) * 1024u;
+    uint rnum = Hash52(seed);
+    uint seeds[8];
+    for (uint i = 0u; i < 8u; ++i) {
+        uint s = (rnum >> (4u * i)) & 0xFu;
+        seeds[i] = s * s;
+    }
+    uint sh1;
+    uint sh2;
+    if ((seed & 1u) != 0u) {
+        sh1 = (seed & 2u) != 0u ? 4u : 5u;
+        sh2 = partition_count == 3u ? 6u : 5u;
+    } else {
+        sh1 = partition_count == 3u ? 6u : 5u;
+        sh2 = (seed & 2u) != 0u ? 4u : 5u;
+    }
+    uint a = ((seeds[0] >> sh1) * x + (seeds[1] >> sh2) * y + (rnum >> 14u)) & 0x3Fu;
+    uint b = ((seeds[2] >> sh1) * x + (seeds[3] >> sh2) * y + (rnum >> 10u)) & 0x3Fu;
+    uint c = ((seeds[4] >> sh1) * x + (seeds[5] >> sh2) * y + (rnum >> 6u)) & 0x3Fu;
+    uint d = ((seeds[6] >> sh1) * x + (seeds[7] >> sh2) * y + (rnum >> 2u)) & 0x3Fu;
+    if (partition_count < 4u) {
+        d = 0u;
+    }
+    if (partition_count < 3u) {
+        c = 0u;
+    }
+    if (a >= b && a >= c && a >= d) {
+        return 0u;
+    }
+    if (b >= c && b >= d) {
+        return 1u;
+    }
+    return c >= d ? 2u : 3u;
+}
+
+// Decodes the size of the weight grid and the quantization of the weights of a block.
+bool DecodeBlockMode(uint mode, out uint grid_width, out uint grid_height, out bool dual_plane,
+                     out uint quant) {
+    uint range = (mode >> 4u) & 1u;
+    uint high_precision = (mode >> 9u) & 1u;
+    uint dual = (mode >> 10u) & 1u;
+    uint a = (mode >> 5u) & 3u;
+    grid_width = 0u;
+    grid_height = 0u;
+    dual_plane = false;
+    quant = 0u;
+
+    if ((mode & 3u) != 0u) {
+        range |= (mode & 3u) << 1u;
+        uint b = (mode >> 7u) & 3u;
+        switch ((mode >> 2u) & 3u) {
+        case 0u:
+            grid_width = b + 4u;
+            grid_height = a + 2u;
+            break;
+        case 1u:
+            grid_width = b + 8u;
+            grid_height = a + 2u;
+            break;
+        case 2u:
+            grid_width = a + 2u;
+            grid_height = b + 8u;
+            break;
+        default:
+            b &= 1u;
+            if ((mode & 0x100u) != 0u) {
+                grid_width = b + 2u;
+                grid_height = a + 2u;
+            } else {
+                grid_width = a + 2u;
+                grid_height = b + 6u;
+            }
+            break;
+        }
+    } else {
+        range |= ((mode >> 2u) & 3u) << 1u;
+        if (((mode >> 2u) & 3u) == 0u) {
+            return false;
+        }
+        uint b = (mode >> 9u) & 3u;
+        switch ((mode >> 7u) & 3u) {
+        case 0u:
+            grid_width = 12u;
+            grid_height = a + 2u;
+            break;
+        case 1u:
+            grid_width = a + 2u;
+            grid_height = 12u;
+            break;
+        case 2u:
+            grid_width = a + 6u;
+            grid_height = b + 6u;
+            dual = 0u;
+            high_precision = 0u;
+            break;
+        default:
+            if (a == 0u) {
+                grid_width = 6u;
+                grid_height = 10u;
+            } else if (a == 1u) {
+                grid_width = 10u;
+                grid_height = 6u;
+            } else {
+                return false;
+            }
+            break;
+        }
+    }
+    dual_plane = dual != 0u;
+    quant = range - 2u + 6u * high_precision;
+    return true;
+}
+
+uint PackColor(uvec4 color) {
+    return color.r | (color.g << 8u) | (color.b << 16u) | (color.a << 24u);
+}
+
+)"
+R"(uint DecodeTexel(uvec4 data, uvec2 texel) {
+    uint mode = GetBits(data, 0u, 11u);
+    if ((mode & 0x1FFu) == 0x1FCu) {
+        // Void extent blocks hold a single 16-bit color. HDR ones are an error, and so are the
+        // ones with an extent that is neither all ones nor a valid rectangle.
+        uint min_s = GetBits(data, 12u, 13u);
+        uint max_s = GetBits(data, 25u, 13u);
+        uint min_t = GetBits(data, 38u, 13u);
+        uint max_t = GetBits(data, 51u, 13u);
+        bool all_ones = (min_s & max_s & min_t & max_t) == 0x1FFFu;
+        if ((mode & 0x200u) != 0u ||
+            (!all_ones && (min_s >= max_s || min_t >= max_t))) {
+            return ERROR_COLOR;
+        }
+        return PackColor(uvec4(GetBits(data, 72u, 8u), GetBits(data, 88u, 8u),
+                               GetBits(data, 104u, 8u), GetBits(data, 120u, 8u)));
+    }
+
+    uint grid_width;
+    uint grid_height;
+    bool dual_plane;
+    uint weight_quant;
+    if (!DecodeBlockMode(mode, grid_width, grid_height, dual_plane, weight_quant)) {
+        return ERROR_COLOR;
+    }
+    uint num_planes = dual_plane ? 2u : 1u;
+    uint num_weights = grid_width * grid_height * num_planes;
+    if (grid_width > block_size.x || grid_height > block_size.y || num_weights > 64u) {
+        return ERROR_COLOR;
+    }
+    uint weight_bits = GetSequenceSize(weight_quant, num_weights);
+    if (weight_bits < 24u || weight_bits > 96u) {
+        return ERROR_COLOR;
+    }
+
+    uint num_partitions = GetBits(data, 11u, 2u) + 1u;
+    if (num_partitions == 4u && dual_plane) {
+        return ERROR_COLOR;
+    }
+
+    // What isn't taken by the weights at the end of the block holds the color endpoint modes that
+    // don't fit with the partitions, the component of the second plane, and the endpoints.
+    uint colors_end = 128u - weight_bits;
+    uint colors_start;
+    uint modes[4];
+    if (num_partitions == 1u) {
+        modes[0] = GetBits(data, 13u, 4u);
+        colors_start = 17u;
+    } else {
+        colors_start = 29u;
+        uint encoded_modes = GetBits(data, 23u, 6u);
+        if ((encoded_modes & 3u) == 0u) {
+            for (uint i = 0u; i < num_partitions; ++i) {
+                modes[i] = encoded_modes >> 2u;
+            }
+        } else {
+            uint extra_bits = 3u * num_partitions - 4u;
+            colors_end -= extra_bits;
+            encoded_modes |= GetBits(data, colors_end, extra_bits) << 6u;
+            uint base_class = (encoded_modes & 3u) - 1u;
+            for (uint i = 0u; i < num_partitions; ++i) {
+                uint high = ((encoded_modes >> (2u + i)) & 1u) + base_class;
+                uint low = (encoded_modes >> (2u + num_partitions + 2u * i)) & 3u;
+                modes[i] = (high << 2u) | low;
+            }
+        }
+    }
+    uint plane2_component = 4u;
+    if (dual_plane) {
+        colors_end -= 2u;
+        plane2_component = GetBits(data, colors_end, 2u);
+    }
+
+    uint num_colors = 0u;
+    for (uint i = 0u; i < num_partitions; ++i) {
+        num_colors += ((modes[i] >> 2u) + 1u) * 2u;
+    }
+    if (num_colors > 18u || colors_end < colors_start) {
+        return ERROR_COLOR;
+    }
+
+    // Endpoints take the most levels that fit, and no fewer than 6
+    uint color_quant = 20u;
+    while (GetSequenceSize(color_quant, num_colors) > colors_end - colors_start) {
+        if (color_quant == 4u) {
+            return ERROR_COLOR;
+        }
+        --color_quant;
+    }
+
+    uint partition_index = 0u;
+    if (num_partitions > 1u) {
+        bool small_block = block_size.x * block_size.y < 31u;
+        partition_index = SelectPartition(GetBits(data, 13u, 10u), texel.x, texel.y, num_partitions,
+                                    small_block);
+    }
+    uint first_color = 0u;
+    for (uint i = 0u; i < partition_index; ++i) {
+        first_color += ((modes[i] >> 2u) + 1u) * 2u;
+    }
+    uint mode_colors = ((modes[partition_index] >> 2u) + 1u) * 2u;
+    uint sequence_end = colors_start + GetSequenceSize(color_quant, num_colors);
+    int v[8];
+    for (uint i = 0u; i < 8u; ++i) {
+        v[i] = 0;
+        if (i < mode_colors) {
+            uvec2 value =
+                DecodeSequenceValue(data, colors_start, sequence_end, color_quant, first_color + i);
+            v[i] = int(UnquantizeColor(color_quant, value));
+        }
+    }
+    ivec4 e0;
+    ivec4 e1;
+    if (!DecodeEndpoints(modes[partition_index], v, e0, e1)) {
+        return ERROR_COLOR;
+    }
+
+    // Weights are stored from the last bit of the block down, and are interpolated bilinearly from
+    // the weight grid to the texels of the block
+    uvec4 reversed = uvec4(bitfieldReverse(data.w), bitfieldReverse(data.z),
+                           bitfieldReverse(data.y), bitfieldReverse(data.x));
+    uint ds = (1024u + block_size.x / 2u) / (block_size.x - 1u);
+    uint dt = (1024u + block_size.y / 2u) / (block_size.y - 1u);
+    uint gs = (ds * texel.x * (grid_width - 1u) + 32u) >> 6u;
+    uint gt = (dt * texel.y * (grid_height - 1u) + 32u) >> 6u;
+    uint fs = gs & 0xFu;
+    uint ft = gt & 0xFu;
+    uint w11 = (fs * ft + 8u) >> 4u;
+    uvec4 factors = uvec4(16u - fs - ft + w11, fs - w11, ft - w11, w11);
+    uint v0 = (gs >> 4u) + (gt >> 4u) * grid_width;
+    uvec4 indices = uvec4(v0, v0 + 1u, v0 + grid_width, v0 + grid_width + 1u);
+
+    uint weights[2];
+    for (uint plane = 0u; plane < num_planes; ++plane) {
+        uint sum = 8u;
+        for (uint i = 0u; i < 4u; ++i) {
+            if (factors[i] == 0u) {
+                continue;
+            }
+            uvec2 value = DecodeSequenceValue(reversed, 0u, weight_bits, weight_quant,
+                                              indices[i] * num_planes + plane);
+            sum += UnquantizeWeight(weight_quant, value) * factors[i];
+        }
+        weights[plane] = sum >> 4u;
+    }
+
+    uvec4 color;
+    for (uint i = 0u; i < 4u; ++i) {
+        uint weight = i == plane2_component ? weights[1] : weights[0];
+        uint c0 = uint(e0[i]) * 257u;
+        uint c1 = uint(e1[i]) * 257u;
+        color[i] = ((c0 * (64u - weight) + c1 * weight + 32u) / 64u) >> 8u;
+    }
+    return PackColor(color);
+}
+
+void main() {
+    uvec2 coord = gl_GlobalInvocationID.xy;
+    if (coord.x >= image_size.x || coord.y >= image_size.y) {
+        return;
+    }
+    uvec2 block = coord / block_size;
+    uint blocks_per_row = (image_size.x + block_size.x - 1u) / block_size.x;
+    texels[coord.y * image_size.x + coord.x] =
+        DecodeTexel(blocks[block.y * blocks_per_row + block.x], coord % block_size);
+}
+)";
+
+} // Anonymous namespace
+
+ASTCDecoderOpenGL::ASTCDecoderOpenGL() {
+    if (!GLAD_GL_ARB_compute_shader || !GLAD_GL_ARB_shader_storage_buffer_object) {
+        return;
+    }
+
+    OGLShader compute_shader;
+    compute_shader.Create(DECODER_SOURCE, GL_COMPUTE_SHADER);
+    decoder_shader.Create(false, compute_shader.handle);
+
+    image_size_u_id = glGetUniformLocation(decoder_shader.handle, "image_size");
+    block_size_u_id = glGetUniformLocation(decoder_shader.handle, "block_size");
+
+    block_buffer.Create();
+    texel_buffer.Create();
+}
+
+void ASTCDecoderOpenGL::Decode(const u8* data, u32 width, u32 height, u32 block_width,
+                               u32 block_height) {
+    constexpr u32 BYTES_PER_BLOCK = 16;
+    const u32 blocks_per_row = (width + block_width - 1) / block_width;
+    const u32 block_rows = (height + block_height - 1) / block_height;
+
+    OpenGLState state = OpenGLState::GetCurState();
+    state.draw.shader_program = decoder_shader.handle;
+    state.Apply();
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, block_buffer.handle);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, blocks_per_row * block_rows * BYTES_PER_BLOCK, data,
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, texel_buffer.handle);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, width * height * sizeof(u32), nullptr, GL_STREAM_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, block_buffer.handle);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, texel_buffer.handle);
+
+    glUniform2ui(image_size_u_id, width, height);
+    glUniform2ui(block_size_u_id, block_width, block_height);
+    glDispatchCompute((width + 7) / 8, (height + 7) / 8, 1);
+    glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, texel_buffer.handle);
+}
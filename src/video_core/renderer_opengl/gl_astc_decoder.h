@@ -0,0 +1,43 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Decodes ASTC textures to RGBA8 with a compute shader. Hosts generally can't sample ASTC, and
+ * decoding it on the CPU would take far too long, as every texel of a block takes a few hundred
+ * operations to decode.
+ */
+class ASTCDecoderOpenGL final {
+public:
+    ASTCDecoderOpenGL();
+
+    /// Returns whether the host can run the decoder.
+    bool IsSupported() const {
+        return decoder_shader.handle != 0;
+    }
+
+    /**
+     * Decodes an image made of rows of ASTC blocks into a buffer of RGBA8 texels, which is left
+     * bound to GL_PIXEL_UNPACK_BUFFER to upload the texture from. Changes the current program and
+     * the SSBOs bound to binding points 0 and 1.
+     * @param data ASTC blocks of the image, a row of blocks after the other
+     * @param width Width of the image in texels, which is also the row length of the result
+     * @param height Height of the image in texels
+     * @param block_width Width of the blocks in texels
+     * @param block_height Height of the blocks in texels
+     */
+    void Decode(const u8* data, u32 width, u32 height, u32 block_width, u32 block_height);
+
+private:
+    OGLProgram decoder_shader;
+    OGLBuffer block_buffer;
+    OGLBuffer texel_buffer;
+    GLint image_size_u_id;
+    GLint block_size_u_id;
+};
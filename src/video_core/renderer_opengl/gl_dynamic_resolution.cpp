@@ -0,0 +1,124 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <glad/glad.h>
+#include "common/logging/log.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_dynamic_resolution.h"
+
+/// GPU time a frame may take, that of the 60 Hz the guest presents at
+constexpr u64 FRAME_BUDGET_NS = 1000000000 / 60;
+/// Frames averaged before the scale is reconsidered
+constexpr u32 MEASURED_FRAMES = 30;
+/// Frames ignored after a change of scale
+constexpr u32 SETTLING_FRAMES = 10;
+/// Share of the budget above which the scale goes down
+constexpr double DOWNSCALE_LOAD = 0.9;
+/// Share of the budget the next scale is expected to take, below which the scale goes up. It is
+/// lower than DOWNSCALE_LOAD, so that the scale doesn't go back and forth between two values.
+constexpr double UPSCALE_LOAD = 0.7;
+
+DynamicResolutionOpenGL::DynamicResolutionOpenGL() = default;
+
+DynamicResolutionOpenGL::~DynamicResolutionOpenGL() = default;
+
+void DynamicResolutionOpenGL::BeginDraw() {
+    if (!free_queries.empty()) {
+        active_query = std::move(free_queries.back());
+        free_queries.pop_back();
+    } else {
+        active_query.Create();
+    }
+    glBeginQuery(GL_TIME_ELAPSED, active_query.handle);
+}
+
+void DynamicResolutionOpenGL::EndDraw() {
+    glEndQuery(GL_TIME_ELAPSED);
+    pending_queries.push_back({std::move(active_query), current_frame});
+}
+
+u16 DynamicResolutionOpenGL::EndFrame(u16 max_scale) {
+    ++current_frame;
+
+    // Handheld, the console renders at 720p instead of the 1080p it renders at docked
+    const u16 mode_scale = Settings::values.use_docked_mode
+                               ? max_scale
+                               : static_cast<u16>(std::max(1, max_scale * 2 / 3));
+    if (mode_scale != upper_scale || scale == 0) {
+        upper_scale = mode_scale;
+        scale = upper_scale;
+        measured_time_ns = 0;
+        measured_frames = 0;
+        settling_frames = SETTLING_FRAMES;
+    }
+
+    CollectResults();
+    return scale;
+}
+
+void DynamicResolutionOpenGL::CollectResults() {
+    while (!pending_queries.empty()) {
+        PendingQuery& pending = pending_queries.front();
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(pending.query.handle, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_FALSE) {
+            return;
+        }
+
+        // Every frame before the one of this draw has all its draws collected
+        while (collected_frame < pending.frame) {
+            FinishFrame(collected_time_ns);
+            collected_time_ns = 0;
+            ++collected_frame;
+        }
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(pending.query.handle, GL_QUERY_RESULT, &elapsed_ns);
+        collected_time_ns += elapsed_ns;
+
+        free_queries.push_back(std::move(pending.query));
+        pending_queries.pop_front();
+    }
+
+    // With no draws pending, the frames that have ended are complete
+    while (collected_frame < current_frame) {
+        FinishFrame(collected_time_ns);
+        collected_time_ns = 0;
+        ++collected_frame;
+    }
+}
+
+void DynamicResolutionOpenGL::FinishFrame(u64 gpu_time_ns) {
+    if (settling_frames > 0) {
+        --settling_frames;
+        return;
+    }
+
+    measured_time_ns += gpu_time_ns;
+    if (++measured_frames < MEASURED_FRAMES) {
+        return;
+    }
+    const double load =
+        static_cast<double>(measured_time_ns) / measured_frames / FRAME_BUDGET_NS;
+    measured_time_ns = 0;
+    measured_frames = 0;
+
+    // Drawing is mostly bound by the pixels it fills, which go with the square of the scale
+    const double upscaled_load = load * (scale + 1) * (scale + 1) / (scale * scale);
+    u16 new_scale = scale;
+    if (load > DOWNSCALE_LOAD && scale > 1) {
+        new_scale = scale - 1;
+    } else if (upscaled_load < UPSCALE_LOAD && scale < upper_scale) {
+        new_scale = scale + 1;
+    }
+    if (new_scale == scale) {
+        return;
+    }
+
+    LOG_DEBUG(Render_OpenGL, "Frames took %.0f%% of the budget, rendering at %ux instead of %ux",
+              load * 100.0, new_scale, scale);
+    scale = new_scale;
+    settling_frames = SETTLING_FRAMES;
+}
@@ -0,0 +1,70 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Picks the scale framebuffer surfaces are rendered at from how long the host GPU takes to draw a
+ * frame. Draws are timed with GL time elapsed queries, whose results are only read once the driver
+ * has them. Timing the draws rather than the whole frame leaves out the time the host GPU waits
+ * for work, so that frames held back by the CPU don't lower the scale.
+ */
+class DynamicResolutionOpenGL final {
+public:
+    DynamicResolutionOpenGL();
+    ~DynamicResolutionOpenGL();
+
+    /// Starts timing the GPU work of a draw, until EndDraw. Draws can't be nested.
+    void BeginDraw();
+    void EndDraw();
+
+    /**
+     * Ends the frame, collects the draw timings the host GPU has finished by now, and returns the
+     * scale to render the next frame at.
+     * @param max_scale Scale of the settings, which the dynamic scale never goes above
+     */
+    u16 EndFrame(u16 max_scale);
+
+private:
+    struct PendingQuery {
+        OGLQuery query;
+        /// Frame the timed draw belongs to
+        u64 frame;
+    };
+
+    /// Collects the results of the oldest queries, as long as the driver has them.
+    void CollectResults();
+
+    /// Adds the GPU time of a finished frame, and reconsiders the scale every few frames.
+    void FinishFrame(u64 gpu_time_ns);
+
+    /// Query timing the draw in progress
+    OGLQuery active_query;
+    /// Queries of the draws whose results haven't been read yet, oldest first
+    std::deque<PendingQuery> pending_queries;
+    /// Queries whose results have been read, to reuse for the next draws
+    std::vector<OGLQuery> free_queries;
+
+    /// Frame the draws are timed for
+    u64 current_frame = 0;
+    /// Oldest frame whose timings are still being collected, and its GPU time so far
+    u64 collected_frame = 0;
+    u64 collected_time_ns = 0;
+
+    /// GPU time of the frames finished since the scale was last reconsidered
+    u64 measured_time_ns = 0;
+    u32 measured_frames = 0;
+    /// Frames to ignore after a change, while the surfaces are recreated at the new scale
+    u32 settling_frames = 0;
+
+    /// Highest scale allowed for the current mode of the console
+    u16 upper_scale = 1;
+    /// Scale the frames are rendered at, 0 until the first frame ends
+    u16 scale = 0;
+};
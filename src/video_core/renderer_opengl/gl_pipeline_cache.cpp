@@ -0,0 +1,73 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <cstring>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/string_util.h"
+#include "core/core.h"
+#include "core/hle/kernel/process.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_pipeline_cache.h"
+
+namespace GLShader {
+
+void PipelineCache::Open(u64 title_id) {
+    if (opened) {
+        return;
+    }
+    opened = true;
+    if (!Settings::values.use_disk_shader_cache) {
+        return;
+    }
+
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Unable to create the shader cache directory %s", dir.c_str());
+        return;
+    }
+    const std::string path =
+        Common::StringFromFormat("%spipelines_%016" PRIX64 ".bin", dir.c_str(), title_id);
+    // The layout of the states may change with any build, like the decompiled programs
+    const u64 build_hash = Common::ComputeHash64(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+    if (!states_file.Open(path, build_hash)) {
+        return;
+    }
+    enabled = true;
+
+    std::vector<u8> data;
+    for (const u64 state_hash : states_file.GetKeys()) {
+        PipelineState state;
+        if (!states_file.Read(state_hash, data) || data.size() != sizeof(state.state)) {
+            continue;
+        }
+        std::memcpy(&state.state, data.data(), sizeof(state.state));
+        if (state.Hash() == state_hash) {
+            state_hashes.insert(state_hash);
+            states.push_back(state);
+        }
+    }
+    LOG_INFO(Render_OpenGL, "Loaded %zu pipeline states for title %016" PRIX64, states.size(),
+             title_id);
+}
+
+void PipelineCache::Record(const PipelineState& state) {
+    if (!opened) {
+        Open(Core::CurrentProcess()->program_id);
+    }
+    if (!enabled) {
+        return;
+    }
+    const u64 state_hash = state.Hash();
+    if (!state_hashes.insert(state_hash).second) {
+        return;
+    }
+    states.push_back(state);
+    states_file.Write(state_hash, reinterpret_cast<const u8*>(&state.state), sizeof(state.state));
+}
+
+} // namespace GLShader
@@ -0,0 +1,86 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <unordered_set>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/indexed_disk_cache.h"
+
+namespace GLShader {
+
+/// Fixed function state of a draw that drivers may build variants of its programs for.
+struct PipelineStateData {
+    struct VertexAttrib {
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLuint offset;
+    };
+
+    /// Disk cache keys of the vertex and fragment programs
+    u64 vs_disk_key;
+    u64 fs_disk_key;
+    GLenum primitive_mode;
+    /// Internal format of the color target, 0 when there is none
+    GLint color_format;
+
+    bool blend_enabled;
+    GLenum blend_rgb_equation;
+    GLenum blend_a_equation;
+    GLenum blend_src_rgb_func;
+    GLenum blend_dst_rgb_func;
+    GLenum blend_src_a_func;
+    GLenum blend_dst_a_func;
+
+    bool cull_enabled;
+    GLenum cull_mode;
+    GLenum front_face;
+
+    bool depth_test_enabled;
+    GLenum depth_test_func;
+    GLboolean depth_write_mask;
+
+    GLsizei vertex_stride;
+    std::array<VertexAttrib, 16> vertex_attribs;
+};
+
+using PipelineState = Common::HashableStruct<PipelineStateData>;
+
+/**
+ * Records the pipeline states each title draws with, in a file of its own next to the shader
+ * disk cache. At boot the states are drawn with off-screen once their programs are built, so that
+ * the driver builds the variants of the programs it needs for them before the guest first uses
+ * them. The states are stored raw, so like the decompiled programs they are only used by the build
+ * that recorded them. Only used when Settings::values.use_disk_shader_cache is set.
+ */
+class PipelineCache final : NonCopyable {
+public:
+    /// Opens the file of a title and reads back its states. Does nothing if it was already opened.
+    void Open(u64 title_id);
+
+    /// Returns every state recorded for the title.
+    const std::vector<PipelineState>& GetStates() const {
+        return states;
+    }
+
+    /// Stores the state of a draw, if it's the first draw with it. Opens the file of the running
+    /// title if needed.
+    void Record(const PipelineState& state);
+
+private:
+    bool opened = false;
+    bool enabled = false;
+
+    Common::IndexedDiskCache states_file;
+    std::vector<PipelineState> states;
+    /// Hashes of the states stored, to skip the draws with a state that already is
+    std::unordered_set<u64> state_hashes;
+};
+
+} // namespace GLShader
@@ -0,0 +1,78 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/renderer_opengl/gl_profiler_timer.h"
+
+OGLProfilerTimer::OGLProfilerTimer() : gl_thread(std::this_thread::get_id()) {
+    glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+    Common::SetProfilerGpuTimer(this);
+}
+
+OGLProfilerTimer::~OGLProfilerTimer() {
+    Common::SetProfilerGpuTimer(nullptr);
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+void OGLProfilerTimer::Collect() {
+    gl_thread = std::this_thread::get_id();
+
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        for (const u32 key : deferred_keys) {
+            glQueryCounter(queries[key], GL_TIMESTAMP);
+            pending_keys.push_back(key);
+        }
+        deferred_keys.clear();
+    }
+
+    // Queries finish in order, so collecting stops at the first one that isn't done yet
+    while (!pending_keys.empty()) {
+        const u32 key = pending_keys.front();
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries[key], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != GL_TRUE) {
+            break;
+        }
+        GLuint64 result = 0;
+        glGetQueryObjectui64v(queries[key], GL_QUERY_RESULT, &result);
+        results[key].store(result, std::memory_order_relaxed);
+        last_result = result;
+        pending_keys.pop_front();
+    }
+
+    GLint64 gpu_tick = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpu_tick);
+    reference_cpu_tick = MP_TICK();
+    reference_gpu_tick = gpu_tick;
+}
+
+u32 OGLProfilerTimer::InsertTimestamp() {
+    const u32 key = next_key.fetch_add(1, std::memory_order_relaxed) % NumQueries;
+    if (std::this_thread::get_id() != gl_thread.load()) {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        deferred_keys.push_back(key);
+        return key;
+    }
+
+    // Until the result is in, the key reads as the latest result instead of one from a round ago
+    results[key].store(last_result, std::memory_order_relaxed);
+    glQueryCounter(queries[key], GL_TIMESTAMP);
+    pending_keys.push_back(key);
+    return key;
+}
+
+u64 OGLProfilerTimer::GetTimestamp(u32 key) {
+    return results[key % NumQueries].load(std::memory_order_relaxed);
+}
+
+u64 OGLProfilerTimer::GetTicksPerSecond() {
+    // GL timestamps are in nanoseconds
+    return 1000000000;
+}
+
+bool OGLProfilerTimer::GetTickReference(s64* cpu_tick, s64* gpu_tick) {
+    *gpu_tick = reference_gpu_tick;
+    *cpu_tick = reference_cpu_tick;
+    return *gpu_tick != 0;
+}
@@ -0,0 +1,61 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/microprofile.h"
+
+/**
+ * Takes the timestamps of the profiler's GPU scopes with GL timestamp queries. Results are
+ * collected once a frame on the thread the renderer runs on, only once the driver has them, so
+ * that profiling never stalls the pipeline. Timestamps requested from other threads, such as the
+ * frame flips of the profiler, are taken the next time the results are collected.
+ */
+class OGLProfilerTimer final : public Common::ProfilerGpuTimer {
+public:
+    /// Creates the queries and sets up the timer for the profiler, the GL context has to be current
+    OGLProfilerTimer();
+    ~OGLProfilerTimer() override;
+
+    /// Takes the pending timestamps, and collects the results the driver has by now. Must be
+    /// called on the thread the renderer runs on, which is then the one queries are made from.
+    void Collect();
+
+    u32 InsertTimestamp() override;
+    u64 GetTimestamp(u32 key) override;
+    u64 GetTicksPerSecond() override;
+    bool GetTickReference(s64* cpu_tick, s64* gpu_tick) override;
+
+private:
+    /// Keys are reused once they have gone round, long after MicroProfile read their results
+    static constexpr u32 NumQueries = 8 << 10;
+
+    std::array<GLuint, NumQueries> queries{};
+    std::array<std::atomic<u64>, NumQueries> results{};
+    std::atomic<u32> next_key{0};
+
+    /// Thread the queries are made from
+    std::atomic<std::thread::id> gl_thread;
+
+    /// Keys whose queries have been made, oldest first, only used on the GL thread
+    std::deque<u32> pending_keys;
+    /// Most recent result that has been collected
+    u64 last_result = 0;
+
+    /// Keys requested from other threads, to be queried on the GL thread
+    std::mutex deferred_mutex;
+    std::vector<u32> deferred_keys;
+
+    /// CPU and GPU ticks taken together, when the results were collected last
+    std::atomic<s64> reference_cpu_tick{0};
+    std::atomic<s64> reference_gpu_tick{0};
+};
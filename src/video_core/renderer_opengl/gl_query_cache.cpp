@@ -0,0 +1,86 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <utility>
+#include <glad/glad.h>
+#include "core/memory.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_query_cache.h"
+
+QueryCacheOpenGL::QueryCacheOpenGL() = default;
+
+QueryCacheOpenGL::~QueryCacheOpenGL() {
+    if (active_query.handle != 0) {
+        glEndQuery(GL_SAMPLES_PASSED);
+    }
+}
+
+void QueryCacheOpenGL::ReportSamplesPassed(VAddr addr, bool long_report, u64 timestamp) {
+    PendingReport report{};
+    report.addr = addr;
+    report.long_report = long_report;
+    report.timestamp = timestamp;
+    if (active_query.handle != 0) {
+        glEndQuery(GL_SAMPLES_PASSED);
+        report.query = std::move(active_query);
+    }
+
+    if (free_queries.empty()) {
+        active_query.Create();
+    } else {
+        active_query = std::move(free_queries.back());
+        free_queries.pop_back();
+    }
+    glBeginQuery(GL_SAMPLES_PASSED, active_query.handle);
+
+    pending_reports.push_back(std::move(report));
+    if (!Settings::values.use_asynchronous_queries) {
+        // Stall until the host GPU catches up, so the guest always reads the exact count
+        while (!pending_reports.empty()) {
+            ResolveOldestReport();
+        }
+        return;
+    }
+
+    // The guest may read the report before the host GPU is done, in which case it sees the count
+    // of the frames that were already resolved, which is usually a good enough estimate for culling
+    WriteReport(addr, long_report, resolved_samples, timestamp);
+    Poll();
+}
+
+void QueryCacheOpenGL::Poll() {
+    while (!pending_reports.empty()) {
+        const GLuint query = pending_reports.front().query.handle;
+        if (query != 0) {
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available == GL_FALSE) {
+                // Queries complete in order, so none of the later ones is available either
+                return;
+            }
+        }
+        ResolveOldestReport();
+    }
+}
+
+void QueryCacheOpenGL::WriteReport(VAddr addr, bool long_report, u64 value, u64 timestamp) {
+    if (long_report) {
+        Memory::Write64(addr, value);
+        Memory::Write64(addr + 8, timestamp);
+    } else {
+        Memory::Write32(addr, static_cast<u32>(value));
+    }
+}
+
+void QueryCacheOpenGL::ResolveOldestReport() {
+    PendingReport& report = pending_reports.front();
+    if (report.query.handle != 0) {
+        GLuint64 samples = 0;
+        glGetQueryObjectui64v(report.query.handle, GL_QUERY_RESULT, &samples);
+        resolved_samples += samples;
+        free_queries.push_back(std::move(report.query));
+    }
+    WriteReport(report.addr, report.long_report, resolved_samples, report.timestamp);
+    pending_reports.pop_front();
+}
@@ -0,0 +1,59 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+
+/**
+ * Counts the samples that pass the depth and stencil tests with GL queries, and writes the guest's
+ * samples passed reports once the host GPU is done counting them. Counting starts at the first
+ * report, and from then on each report ends the query that counted the samples since the previous
+ * one and begins the next.
+ */
+class QueryCacheOpenGL final {
+public:
+    QueryCacheOpenGL();
+    ~QueryCacheOpenGL();
+
+    /**
+     * Reports the number of samples that passed so far to guest memory. The report is written once
+     * the host GPU has counted them. Until then, with asynchronous queries, the guest reads the
+     * count of the last report that was resolved.
+     * @param addr Address of the report in guest memory
+     * @param long_report Whether to write the 16 byte report with a timestamp, or only 32 bits
+     * @param timestamp Timestamp of long reports, in nanoseconds
+     */
+    void ReportSamplesPassed(VAddr addr, bool long_report, u64 timestamp);
+
+    /// Writes the reports whose samples the host GPU is done counting.
+    void Poll();
+
+private:
+    struct PendingReport {
+        /// Query counting the samples since the previous report, none for the first report
+        OGLQuery query;
+        VAddr addr;
+        bool long_report;
+        u64 timestamp;
+    };
+
+    /// Writes a report of the given value to guest memory.
+    static void WriteReport(VAddr addr, bool long_report, u64 value, u64 timestamp);
+
+    /// Waits for the samples of the oldest pending report to be counted, and writes it.
+    void ResolveOldestReport();
+
+    /// Query counting the samples since the last report
+    OGLQuery active_query;
+    /// Reports waiting on the host GPU, oldest first
+    std::deque<PendingReport> pending_reports;
+    /// Queries of resolved reports, to reuse for the next ones
+    std::vector<OGLQuery> free_queries;
+    /// Samples counted up to the last resolved report
+    u64 resolved_samples = 0;
+};
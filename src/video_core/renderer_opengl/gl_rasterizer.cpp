@@ -3,6 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <limits>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -28,12 +33,30 @@ using Maxwell = Tegra::Engines::Maxwell3D::Regs;
 using PixelFormat = SurfaceParams::PixelFormat;
 using SurfaceType = SurfaceParams::SurfaceType;
 
+namespace {
+
+/// Writes the indices of the two triangles making up each of quad_count quads.
+template <typename T>
+void ConvertQuadIndices(const u8* quads, size_t quad_count, u8* triangles) {
+    for (size_t quad = 0; quad < quad_count; ++quad) {
+        std::array<T, 4> vertices;
+        std::memcpy(vertices.data(), quads + quad * sizeof(vertices), sizeof(vertices));
+        const std::array<T, 6> indices{vertices[0], vertices[1], vertices[2],
+                                       vertices[0], vertices[2], vertices[3]};
+        std::memcpy(triangles + quad * sizeof(indices), indices.data(), sizeof(indices));
+    }
+}
+
+} // Anonymous namespace
+
 MICROPROFILE_DEFINE(OpenGL_VAO, "OpenGL", "Vertex Array Setup", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_VS, "OpenGL", "Vertex Shader Setup", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_FS, "OpenGL", "Fragment Shader Setup", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_Drawing, "OpenGL", "Drawing", MP_RGB(128, 128, 192));
 MICROPROFILE_DEFINE(OpenGL_Blits, "OpenGL", "Blits", MP_RGB(100, 100, 255));
 MICROPROFILE_DEFINE(OpenGL_CacheManagement, "OpenGL", "Cache Mgmt", MP_RGB(100, 255, 100));
+MICROPROFILE_DEFINE_GPU(GPU_Drawing, "Drawing", MP_RGB(128, 128, 192));
+MICROPROFILE_DEFINE_GPU(GPU_Blits, "Blits", MP_RGB(100, 100, 255));
 
 RasterizerOpenGL::RasterizerOpenGL() {
     has_ARB_buffer_storage = false;
@@ -76,25 +99,20 @@ RasterizerOpenGL::RasterizerOpenGL() {
     // Clipping plane 0 is always enabled for PICA fixed clip plane z <= 0
     state.clip_distance[0] = true;
 
-    // Generate VBO, VAO and UBO
-    vertex_buffer = OGLStreamBuffer::MakeBuffer(GLAD_GL_ARB_buffer_storage, GL_ARRAY_BUFFER);
-    vertex_buffer->Create(VERTEX_BUFFER_SIZE, VERTEX_BUFFER_SIZE / 2);
+    // Generate VAO and UBO
     sw_vao.Create();
     uniform_buffer.Create();
 
     state.draw.vertex_array = sw_vao.handle;
-    state.draw.vertex_buffer = vertex_buffer->GetHandle();
     state.draw.uniform_buffer = uniform_buffer.handle;
     state.Apply();
 
-    // Create render framebuffer
-    framebuffer.Create();
-
     hw_vao.Create();
     hw_vao_enabled_attributes.fill(false);
 
     stream_buffer = OGLStreamBuffer::MakeBuffer(has_ARB_buffer_storage, GL_ARRAY_BUFFER);
-    stream_buffer->Create(STREAM_BUFFER_SIZE, STREAM_BUFFER_SIZE / 2);
+    // Finely subdivided, so that wrapping around only waits for the draws of the oldest region.
+    stream_buffer->Create(STREAM_BUFFER_SIZE, STREAM_BUFFER_SIZE / 16);
     state.draw.vertex_buffer = stream_buffer->GetHandle();
 
     shader_program_manager = std::make_unique<GLShader::ProgramManager>();
@@ -102,8 +120,6 @@ RasterizerOpenGL::RasterizerOpenGL() {
     state.draw.vertex_array = hw_vao.handle;
     state.Apply();
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, stream_buffer->GetHandle());
-
     for (unsigned index = 0; index < uniform_buffers.size(); ++index) {
         auto& buffer = uniform_buffers[index];
         buffer.Create();
@@ -121,6 +137,9 @@ RasterizerOpenGL::RasterizerOpenGL() {
 }
 
 RasterizerOpenGL::~RasterizerOpenGL() {
+    // Release the pages of the cached descriptors, so that their memory no longer notifies us
+    InvalidateDescriptors(0, std::numeric_limits<VAddr>::max());
+
     if (stream_buffer != nullptr) {
         state.draw.vertex_buffer = stream_buffer->GetHandle();
         state.Apply();
@@ -128,20 +147,36 @@ RasterizerOpenGL::~RasterizerOpenGL() {
     }
 }
 
-void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset) {
+void RasterizerOpenGL::SetupVertexArray() {
     MICROPROFILE_SCOPE(OpenGL_VAO);
     const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
     const auto& memory_manager = Core::System().GetInstance().GPU().memory_manager;
 
-    state.draw.vertex_array = hw_vao.handle;
-    state.draw.vertex_buffer = stream_buffer->GetHandle();
-    state.Apply();
-
     // TODO(bunnei): Add support for 1+ vertex arrays
     const auto& vertex_array{regs.vertex_array[0]};
     const auto& vertex_array_limit{regs.vertex_array_limit[0]};
     ASSERT_MSG(vertex_array.enable, "vertex array 0 is disabled?");
-    ASSERT_MSG(!vertex_array.divisor, "vertex array 0 divisor is unimplemented!");
+
+    // The vertex array is read from a buffer of its own, which is only uploaded again when the
+    // guest changes the data.
+    const u64 data_size{vertex_array_limit.LimitAddress() - vertex_array.StartAddress() + 1};
+    const VAddr data_addr{memory_manager->PhysicalToVirtualAddress(vertex_array.StartAddress())};
+    res_cache.FlushRegion(data_addr, data_size, nullptr);
+
+    // Dropped before any buffer of this draw is bound, as deleting a bound buffer unbinds it.
+    if (guest_buffer_cache.size() >= MaxCachedGuestBuffers) {
+        guest_buffer_cache.clear();
+    }
+    if (quad_index_cache.size() >= MaxCachedGuestBuffers) {
+        quad_index_cache.clear();
+    }
+
+    state.draw.vertex_array = hw_vao.handle;
+    state.draw.vertex_buffer = GetCachedGuestBuffer(data_addr, data_size);
+    state.Apply();
+    // Instanced arrays are fetched once every divisor instances, counting from the base instance.
+    const GLuint divisor =
+        regs.instanced_arrays.IsInstancingEnabled(0) ? std::max(vertex_array.divisor, 1u) : 0;
     for (unsigned index = 1; index < Maxwell::NumVertexArrays; ++index) {
         ASSERT_MSG(!regs.vertex_array[index].enable, "vertex array %d is unimplemented!", index);
     }
@@ -158,19 +193,111 @@ void RasterizerOpenGL::SetupVertexArray(u8* array_ptr, GLintptr buffer_offset) {
 
         glVertexAttribPointer(index, attrib.ComponentCount(), MaxwellToGL::VertexType(attrib),
                               attrib.IsNormalized() ? GL_TRUE : GL_FALSE, vertex_array.stride,
-                              reinterpret_cast<GLvoid*>(buffer_offset + attrib.offset));
+                              reinterpret_cast<GLvoid*>(attrib.offset.Value()));
+        glVertexAttribDivisor(index, divisor);
         glEnableVertexAttribArray(index);
         hw_vao_enabled_attributes[index] = true;
     }
 
-    // Copy vertex array data
-    const u64 data_size{vertex_array_limit.LimitAddress() - vertex_array.StartAddress() + 1};
-    const VAddr data_addr{memory_manager->PhysicalToVirtualAddress(vertex_array.StartAddress())};
-    res_cache.FlushRegion(data_addr, data_size, nullptr);
-    Memory::ReadBlock(data_addr, array_ptr, data_size);
+    // The uniform data is still copied out of the stream buffer, bound as the array buffer.
+    state.draw.vertex_buffer = stream_buffer->GetHandle();
+    state.Apply();
+}
+
+const u8* RasterizerOpenGL::ReadGuestBuffer(VAddr addr, u64 size) {
+    const u8* data = Memory::GetContiguousPointer(addr, size);
+    if (data == nullptr) {
+        guest_buffer_scratch.resize(size);
+        Memory::ReadBlock(addr, guest_buffer_scratch.data(), size);
+        data = guest_buffer_scratch.data();
+    }
+    return data;
+}
+
+GLuint RasterizerOpenGL::GetCachedGuestBuffer(VAddr addr, u64 size) {
+    const u8* data = ReadGuestBuffer(addr, size);
+    const u64 hash = Common::ComputeHash64(data, size);
+
+    auto [iter, inserted] = guest_buffer_cache.try_emplace(addr);
+    CachedGuestBuffer& cached = iter->second;
+    if (inserted) {
+        cached.buffer.Create();
+    } else if (cached.size == size && cached.hash == hash) {
+        return cached.buffer.handle;
+    }
+
+    // Bound to the copy target, so that neither the array nor the element buffer bindings change.
+    // Respecifying the store lets the driver keep the old one around for draws still using it.
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cached.buffer.handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, size, data, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    cached.size = size;
+    cached.hash = hash;
+    return cached.buffer.handle;
+}
+
+GLuint RasterizerOpenGL::GetCachedQuadIndexBuffer(VAddr addr, u32 count, u32 index_size) {
+    const u64 size = static_cast<u64>(count) * index_size;
+    const u8* data = ReadGuestBuffer(addr, size);
+    const u64 hash = Common::ComputeHash64(data, size);
+
+    auto [iter, inserted] = quad_index_cache.try_emplace(addr);
+    CachedQuadIndexBuffer& cached = iter->second;
+    if (inserted) {
+        cached.buffer.Create();
+    } else if (cached.size == size && cached.hash == hash && cached.index_size == index_size) {
+        return cached.buffer.handle;
+    }
+
+    const size_t quad_count = count / 4;
+    quad_index_scratch.resize(quad_count * 6 * index_size);
+    switch (index_size) {
+    case 1:
+        ConvertQuadIndices<u8>(data, quad_count, quad_index_scratch.data());
+        break;
+    case 2:
+        ConvertQuadIndices<u16>(data, quad_count, quad_index_scratch.data());
+        break;
+    case 4:
+        ConvertQuadIndices<u32>(data, quad_count, quad_index_scratch.data());
+        break;
+    default:
+        UNREACHABLE();
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cached.buffer.handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, quad_index_scratch.size(), quad_index_scratch.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    cached.size = size;
+    cached.hash = hash;
+    cached.index_size = index_size;
+    return cached.buffer.handle;
+}
 
-    array_ptr += data_size;
-    buffer_offset += data_size;
+GLuint RasterizerOpenGL::GetQuadArrayIndexBuffer(u32 quad_count) {
+    if (quad_array_buffer.handle == 0) {
+        quad_array_buffer.Create();
+    }
+    if (quad_count <= quad_array_count) {
+        return quad_array_buffer.handle;
+    }
+
+    // The indices of fewer quads are a prefix of these, so the buffer only ever grows.
+    std::vector<u32> indices(quad_count * 6);
+    for (u32 quad = 0; quad < quad_count; ++quad) {
+        const u32 first = quad * 4;
+        const std::array<u32, 6> triangles{first, first + 1, first + 2,
+                                           first, first + 2, first + 3};
+        std::copy(triangles.begin(), triangles.end(), indices.begin() + quad * 6);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, quad_array_buffer.handle);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(u32), indices.data(),
+                 GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    quad_array_count = quad_count;
+    return quad_array_buffer.handle;
 }
 
 void RasterizerOpenGL::SetupShaders(u8* buffer_ptr, GLintptr buffer_offset, size_t ptr_pos) {
@@ -243,11 +370,18 @@ void RasterizerOpenGL::SetupShaders(u8* buffer_ptr, GLintptr buffer_offset, size
 
         GLuint gl_stage_program = shader_program_manager->GetCurrentProgramStage(
             static_cast<Maxwell::ShaderStage>(stage));
+        if (gl_stage_program == 0) {
+            // Still being built in the background, and the draw is skipped until it's done
+            continue;
+        }
 
         // Configure the const buffers for this shader stage.
         current_constbuffer_bindpoint =
             SetupConstBuffers(static_cast<Maxwell::ShaderStage>(stage), gl_stage_program,
                               current_constbuffer_bindpoint, shader_resources.const_buffer_entries);
+
+        // Sync and bind the texture surfaces the shader samples
+        SetupTextures(static_cast<Maxwell::ShaderStage>(stage), shader_resources.texture_samplers);
     }
 
     shader_program_manager->UseTrivialGeometryShader();
@@ -264,7 +398,14 @@ void RasterizerOpenGL::DrawArrays() {
         return;
 
     MICROPROFILE_SCOPE(OpenGL_Drawing);
-    const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
+    MICROPROFILE_SCOPEGPU(GPU_Drawing);
+    Core::PerfStats::SubsystemScope perf_scope(Core::System::GetInstance().perf_stats,
+                                               Core::PerfStats::Subsystem::GlSubmission);
+    auto& maxwell3d = Core::System().GetInstance().GPU().Maxwell3D();
+    const auto& regs = maxwell3d.regs;
+
+    // Write the reports the host GPU finished counting since the last draw
+    query_cache.Poll();
 
     // TODO(bunnei): Implement these
     const bool has_stencil = false;
@@ -307,15 +448,29 @@ void RasterizerOpenGL::DrawArrays() {
     // Bind the framebuffer surfaces
     BindFramebufferSurfaces(color_surface, depth_surface, has_stencil);
 
-    // Sync the viewport
-    SyncViewport(surfaces_rect, res_scale);
+    // Only the state derived from register groups written since the last draw is synced again
+    using DirtyFlag = Tegra::Engines::Maxwell3D::DirtyFlag;
+
+    // Sync the viewport, which also depends on the framebuffer surfaces
+    if (maxwell3d.IsDirty(DirtyFlag::Viewport) || res_scale != viewport_res_scale ||
+        surfaces_rect.left != viewport_surfaces_rect.left ||
+        surfaces_rect.top != viewport_surfaces_rect.top ||
+        surfaces_rect.right != viewport_surfaces_rect.right ||
+        surfaces_rect.bottom != viewport_surfaces_rect.bottom) {
+        SyncViewport(surfaces_rect, res_scale);
+        viewport_surfaces_rect = surfaces_rect;
+        viewport_res_scale = res_scale;
+        maxwell3d.ClearDirty(DirtyFlag::Viewport);
+    }
+
+    if (maxwell3d.IsDirty(DirtyFlag::Blend)) {
+        SyncBlendFuncs();
+        maxwell3d.ClearDirty(DirtyFlag::Blend);
+    }
 
     // TODO(bunnei): Sync framebuffer_scale uniform here
     // TODO(bunnei): Sync scissorbox uniform(s) here
 
-    // Sync and bind the texture surfaces
-    BindTextures();
-
     // Viewport can have negative offsets or larger dimensions than our framebuffer sub-rect. Enable
     // scissor test to prevent drawing outside of the framebuffer region
     state.scissor.enabled = true;
@@ -327,22 +482,13 @@ void RasterizerOpenGL::DrawArrays() {
 
     // Draw the vertex batch
     const bool is_indexed = accelerate_draw == AccelDraw::Indexed;
-    const u64 index_buffer_size{regs.index_array.count * regs.index_array.FormatSizeInBytes()};
-    const unsigned vertex_num{is_indexed ? regs.index_array.count : regs.vertex_buffer.count};
-
-    // TODO(bunnei): Add support for 1+ vertex arrays
-    vs_input_size = vertex_num * regs.vertex_array[0].stride;
 
     state.draw.vertex_buffer = stream_buffer->GetHandle();
     state.Apply();
 
-    size_t buffer_size = static_cast<size_t>(vs_input_size);
-    if (is_indexed) {
-        buffer_size = Common::AlignUp(buffer_size, 4) + index_buffer_size;
-    }
-
-    // Uniform space for the 5 shader stages
-    buffer_size += sizeof(GLShader::MaxwellUniformData) * Maxwell::MaxShaderStage;
+    // Vertex and index data live in buffers of their own, which leaves the uniform space for the
+    // 5 shader stages in the stream buffer.
+    const size_t buffer_size = sizeof(GLShader::MaxwellUniformData) * Maxwell::MaxShaderStage;
 
     size_t ptr_pos = 0;
     u8* buffer_ptr;
@@ -350,21 +496,36 @@ void RasterizerOpenGL::DrawArrays() {
     std::tie(buffer_ptr, buffer_offset) =
         stream_buffer->Map(static_cast<GLsizeiptr>(buffer_size), 4);
 
-    SetupVertexArray(buffer_ptr, buffer_offset);
-    ptr_pos += vs_input_size;
+    SetupVertexArray();
 
-    // If indexed mode, copy the index buffer
-    GLintptr index_buffer_offset = 0;
-    if (is_indexed) {
-        ptr_pos = Common::AlignUp(ptr_pos, 4);
+    // Quads are drawn as two triangles each, through an index buffer holding those triangles.
+    const bool is_quads = regs.draw.topology == Maxwell::PrimitiveTopology::Quads;
 
+    // If indexed mode, bind the index buffer. The element buffer binding is part of the VAO.
+    GLsizei index_count = 0;
+    GLenum index_type = GL_UNSIGNED_INT;
+    if (is_indexed) {
         const auto& memory_manager = Core::System().GetInstance().GPU().memory_manager;
+        const u32 index_size{regs.index_array.FormatSizeInBytes()};
         const VAddr index_data_addr{
             memory_manager->PhysicalToVirtualAddress(regs.index_array.StartAddress())};
-        Memory::ReadBlock(index_data_addr, &buffer_ptr[ptr_pos], index_buffer_size);
-
-        index_buffer_offset = buffer_offset + static_cast<GLintptr>(ptr_pos);
-        ptr_pos += index_buffer_size;
+        index_type = MaxwellToGL::IndexFormat(regs.index_array.format);
+        if (is_quads) {
+            index_count = static_cast<GLsizei>(regs.index_array.count / 4 * 6);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                         GetCachedQuadIndexBuffer(index_data_addr, regs.index_array.count,
+                                                  index_size));
+        } else {
+            index_count = static_cast<GLsizei>(regs.index_array.count);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                         GetCachedGuestBuffer(index_data_addr,
+                                              static_cast<u64>(regs.index_array.count) *
+                                                  index_size));
+        }
+    } else if (is_quads) {
+        index_count = static_cast<GLsizei>(regs.vertex_buffer.count / 4 * 6);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                     GetQuadArrayIndexBuffer(regs.vertex_buffer.count / 4));
     }
 
     SetupShaders(buffer_ptr, buffer_offset, ptr_pos);
@@ -374,16 +535,53 @@ void RasterizerOpenGL::DrawArrays() {
     shader_program_manager->ApplyTo(state);
     state.Apply();
 
-    const GLenum primitive_mode{MaxwellToGL::PrimitiveTopology(regs.draw.topology)};
-    if (is_indexed) {
-        const GLint index_min{static_cast<GLint>(regs.index_array.first)};
-        const GLint index_max{static_cast<GLint>(regs.index_array.first + regs.index_array.count)};
-        glDrawRangeElementsBaseVertex(primitive_mode, index_min, index_max, regs.index_array.count,
-                                      MaxwellToGL::IndexFormat(regs.index_array.format),
-                                      reinterpret_cast<const void*>(index_buffer_offset),
-                                      -index_min);
-    } else {
-        glDrawArrays(primitive_mode, 0, regs.vertex_buffer.count);
+    // The draw is skipped while its shaders are built in the background, leaving its targets as
+    // they were. Drawing with a shader of a previous draw could be worse than drawing nothing.
+    const bool draw_enabled = shader_program_manager->IsCurrentProgramReady();
+    const bool timed_draw = draw_enabled && Settings::values.use_dynamic_resolution;
+
+    if (timed_draw) {
+        dynamic_resolution.BeginDraw();
+    }
+    if (draw_enabled) {
+        const GLenum primitive_mode{is_quads ? GL_TRIANGLES
+                                             : MaxwellToGL::PrimitiveTopology(regs.draw.topology)};
+        if (Settings::values.use_disk_shader_cache) {
+            RecordPipelineState(color_surface, primitive_mode);
+        }
+        // Each guest draw is a single instance. It is drawn as the current instance, so that the
+        // instanced arrays fetch the elements of that instance.
+        const GLuint base_instance{maxwell3d.state.current_instance};
+        if (is_indexed) {
+            const GLint index_min{static_cast<GLint>(regs.index_array.first)};
+            const GLint index_max{
+                static_cast<GLint>(regs.index_array.first + regs.index_array.count)};
+            if (base_instance == 0) {
+                glDrawRangeElementsBaseVertex(primitive_mode, index_min, index_max, index_count,
+                                              index_type, nullptr, -index_min);
+            } else {
+                glDrawElementsInstancedBaseVertexBaseInstance(primitive_mode, index_count,
+                                                              index_type, nullptr, 1, -index_min,
+                                                              base_instance);
+            }
+        } else if (is_quads) {
+            if (base_instance == 0) {
+                glDrawRangeElements(primitive_mode, 0, regs.vertex_buffer.count, index_count,
+                                    index_type, nullptr);
+            } else {
+                glDrawElementsInstancedBaseInstance(primitive_mode, index_count, index_type,
+                                                    nullptr, 1, base_instance);
+            }
+        } else if (base_instance == 0) {
+            glDrawArrays(primitive_mode, 0, regs.vertex_buffer.count);
+        } else {
+            glDrawArraysInstancedBaseInstance(primitive_mode, 0, regs.vertex_buffer.count, 1,
+                                              base_instance);
+        }
+    }
+
+    if (timed_draw) {
+        dynamic_resolution.EndDraw();
     }
 
     // Disable scissor test
@@ -402,75 +600,184 @@ void RasterizerOpenGL::DrawArrays() {
         draw_rect.left / res_scale, draw_rect.top / res_scale, draw_rect.right / res_scale,
         draw_rect.bottom / res_scale};
 
-    if (color_surface != nullptr && write_color_fb) {
+    if (color_surface != nullptr && write_color_fb && draw_enabled) {
         auto interval = color_surface->GetSubRectInterval(draw_rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
                                    color_surface);
     }
-    if (depth_surface != nullptr && write_depth_fb) {
+    if (depth_surface != nullptr && write_depth_fb && draw_enabled) {
         auto interval = depth_surface->GetSubRectInterval(draw_rect_unscaled);
         res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
                                    depth_surface);
     }
 }
 
-void RasterizerOpenGL::BindTextures() {
-    using Regs = Tegra::Engines::Maxwell3D::Regs;
+void RasterizerOpenGL::Clear() {
+    MICROPROFILE_SCOPE(OpenGL_Drawing);
+    MICROPROFILE_SCOPEGPU(GPU_Drawing);
+    const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
+    const auto& clear = regs.clear_buffers;
+
+    // TODO: Implement depth and stencil buffers, and render targets other than the first
+    if (clear.Z || clear.S) {
+        LOG_WARNING(Render_OpenGL, "Clearing the depth and stencil buffers is unimplemented");
+    }
+    if (clear.RT != 0) {
+        LOG_WARNING(Render_OpenGL, "Clearing render target %u is unimplemented",
+                    static_cast<u32>(clear.RT));
+        return;
+    }
+    if (!clear.R && !clear.G && !clear.B && !clear.A) {
+        return;
+    }
+
+    // A clear of every channel overwrites the whole render target, so what guest memory holds
+    // there doesn't have to be loaded into the surface first.
+    const bool overwrite_color_fb = clear.R && clear.G && clear.B && clear.A;
+    const MathUtil::Rectangle<s32> clear_rect{0, static_cast<s32>(regs.rt[0].height),
+                                              static_cast<s32>(regs.rt[0].width), 0};
+
+    Surface color_surface;
+    Surface depth_surface;
+    MathUtil::Rectangle<u32> surfaces_rect;
+    std::tie(color_surface, depth_surface, surfaces_rect) =
+        res_cache.GetFramebufferSurfaces(true, false, clear_rect, overwrite_color_fb);
+    if (color_surface == nullptr) {
+        return;
+    }
+
+    BindFramebufferSurfaces(color_surface, nullptr, false);
+
+    // The surface can be larger than the render target, which only covers surfaces_rect of it
+    const auto color_mask = state.color_mask;
+    state.color_mask.red_enabled = clear.R ? GL_TRUE : GL_FALSE;
+    state.color_mask.green_enabled = clear.G ? GL_TRUE : GL_FALSE;
+    state.color_mask.blue_enabled = clear.B ? GL_TRUE : GL_FALSE;
+    state.color_mask.alpha_enabled = clear.A ? GL_TRUE : GL_FALSE;
+    state.scissor.enabled = true;
+    state.scissor.x = surfaces_rect.left;
+    state.scissor.y = surfaces_rect.bottom;
+    state.scissor.width = surfaces_rect.GetWidth();
+    state.scissor.height = surfaces_rect.GetHeight();
+    state.Apply();
+
+    glClearBufferfv(GL_COLOR, 0, regs.clear_color);
+
+    state.color_mask = color_mask;
+    state.scissor.enabled = false;
+    state.Apply();
+
+    // Mark the framebuffer surface as dirty, the cleared data only lives on the host GPU
+    const u16 res_scale = color_surface->res_scale;
+    const MathUtil::Rectangle<u32> clear_rect_unscaled{
+        surfaces_rect.left / res_scale, surfaces_rect.top / res_scale,
+        surfaces_rect.right / res_scale, surfaces_rect.bottom / res_scale};
+    const auto interval = color_surface->GetSubRectInterval(clear_rect_unscaled);
+    res_cache.InvalidateRegion(boost::icl::first(interval), boost::icl::length(interval),
+                               color_surface);
+}
+
+void RasterizerOpenGL::SetupTextures(Maxwell::ShaderStage stage,
+                                     const std::vector<GLShader::SamplerEntry>& entries) {
     auto& maxwell3d = Core::System::GetInstance().GPU().Get3DEngine();
 
-    // Each Maxwell shader stage can have an arbitrary number of textures, but we're limited to a
-    // certain number in OpenGL. We try to only use the minimum amount of host textures by not
-    // keeping a 1:1 relation between guest texture ids and host texture ids, ie, guest texture id 8
-    // can be host texture id 0 if it's the only texture used in the guest shader program.
-    u32 host_texture_index = 0;
-    for (u32 stage = 0; stage < Regs::MaxShaderStage; ++stage) {
-        ASSERT(host_texture_index < texture_samplers.size());
-        const auto textures = maxwell3d.GetStageTextures(static_cast<Regs::ShaderStage>(stage));
-        for (unsigned texture_index = 0; texture_index < textures.size(); ++texture_index) {
-            const auto& texture = textures[texture_index];
-
-            if (texture.enabled) {
-                texture_samplers[host_texture_index].SyncWithConfig(texture.tsc);
-                Surface surface = res_cache.GetTextureSurface(texture);
-                if (surface != nullptr) {
-                    state.texture_units[host_texture_index].texture_2d = surface->texture.handle;
-                } else {
-                    // Can occur when texture addr is null or its memory is unmapped/invalid
-                    state.texture_units[texture_index].texture_2d = 0;
-                }
-
-                ++host_texture_index;
-            } else {
-                state.texture_units[texture_index].texture_2d = 0;
-            }
+    // The shaders sample tex[index], which is bound to the texture unit of the same index. The
+    // other units are left unbound, as they are after every draw.
+    for (const auto& entry : entries) {
+        const u32 unit = entry.index;
+        ASSERT(unit < texture_samplers.size());
+
+        const Tegra::Texture::TextureHandle handle = maxwell3d.GetStageTextureHandle(stage, unit);
+        if (handle.tic_id == 0) {
+            state.texture_units[unit].texture_2d = 0;
+            continue;
         }
+
+        Tegra::Texture::FullTextureInfo texture{};
+        texture.index = unit;
+        texture.enabled = true;
+        // TODO(Subv): Workaround for BitField's move constructor being deleted.
+        std::memcpy(&texture.tic, &GetCachedTICEntry(handle.tic_id), sizeof(texture.tic));
+
+        if (handle.tsc_id != 0) {
+            state.texture_units[unit].sampler = GetCachedSampler(handle.tsc_id).sampler.handle;
+        } else {
+            // Without a TSC entry, the unit's own sampler is used with the default config.
+            texture_samplers[unit].SyncWithConfig(texture.tsc);
+            state.texture_units[unit].sampler = texture_samplers[unit].sampler.handle;
+        }
+
+        Surface surface = res_cache.GetTextureSurface(texture);
+        // Can be null when texture addr is null or its memory is unmapped/invalid
+        state.texture_units[unit].texture_2d = surface != nullptr ? surface->texture.handle : 0;
     }
 }
 
-void RasterizerOpenGL::NotifyMaxwellRegisterChanged(u32 method) {
-    const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
-    switch (method) {
-    case MAXWELL3D_REG_INDEX(blend.separate_alpha):
-        ASSERT_MSG(false, "unimplemented");
-        break;
-    case MAXWELL3D_REG_INDEX(blend.equation_rgb):
-        state.blend.rgb_equation = MaxwellToGL::BlendEquation(regs.blend.equation_rgb);
-        break;
-    case MAXWELL3D_REG_INDEX(blend.factor_source_rgb):
-        state.blend.src_rgb_func = MaxwellToGL::BlendFunc(regs.blend.factor_source_rgb);
-        break;
-    case MAXWELL3D_REG_INDEX(blend.factor_dest_rgb):
-        state.blend.dst_rgb_func = MaxwellToGL::BlendFunc(regs.blend.factor_dest_rgb);
-        break;
-    case MAXWELL3D_REG_INDEX(blend.equation_a):
-        state.blend.a_equation = MaxwellToGL::BlendEquation(regs.blend.equation_a);
-        break;
-    case MAXWELL3D_REG_INDEX(blend.factor_source_a):
-        state.blend.src_a_func = MaxwellToGL::BlendFunc(regs.blend.factor_source_a);
-        break;
-    case MAXWELL3D_REG_INDEX(blend.factor_dest_a):
-        state.blend.dst_a_func = MaxwellToGL::BlendFunc(regs.blend.factor_dest_a);
-        break;
+const Tegra::Texture::TICEntry& RasterizerOpenGL::GetCachedTICEntry(u32 tic_index) {
+    const auto& maxwell3d = Core::System::GetInstance().GPU().Get3DEngine();
+    const VAddr addr = maxwell3d.GetTICEntryAddress(tic_index);
+
+    CachedTICEntry& cached = tic_cache[tic_index];
+    if (cached.valid && cached.addr == addr) {
+        return cached.tic;
+    }
+
+    // The TIC buffer was moved since the entry was read.
+    if (cached.valid) {
+        res_cache.UpdatePagesCachedCount(cached.addr, sizeof(Tegra::Texture::TICEntry), -1);
+    }
+
+    const auto tic_entry = maxwell3d.GetTICEntry(tic_index);
+    // TODO(Subv): Workaround for BitField's move constructor being deleted.
+    std::memcpy(&cached.tic, &tic_entry, sizeof(tic_entry));
+    cached.addr = addr;
+    cached.valid = true;
+    res_cache.UpdatePagesCachedCount(addr, sizeof(Tegra::Texture::TICEntry), 1);
+    return cached.tic;
+}
+
+const RasterizerOpenGL::SamplerInfo& RasterizerOpenGL::GetCachedSampler(u32 tsc_index) {
+    const auto& maxwell3d = Core::System::GetInstance().GPU().Get3DEngine();
+    const VAddr addr = maxwell3d.GetTSCEntryAddress(tsc_index);
+
+    auto [iter, inserted] = tsc_cache.try_emplace(tsc_index);
+    CachedTSCEntry& cached = iter->second;
+    if (inserted) {
+        cached.sampler.Create();
+    } else if (cached.valid && cached.addr == addr) {
+        return cached.sampler;
+    }
+
+    // The TSC buffer was moved since the entry was read.
+    if (cached.valid) {
+        res_cache.UpdatePagesCachedCount(cached.addr, sizeof(Tegra::Texture::TSCEntry), -1);
+    }
+
+    cached.sampler.SyncWithConfig(maxwell3d.GetTSCEntry(tsc_index));
+    cached.addr = addr;
+    cached.valid = true;
+    res_cache.UpdatePagesCachedCount(addr, sizeof(Tegra::Texture::TSCEntry), 1);
+    return cached.sampler;
+}
+
+void RasterizerOpenGL::InvalidateDescriptors(VAddr addr, u64 size) {
+    const auto overlaps = [addr, size](VAddr entry_addr, u64 entry_size) {
+        return entry_addr < addr + size && addr < entry_addr + entry_size;
+    };
+
+    for (auto& pair : tic_cache) {
+        CachedTICEntry& cached = pair.second;
+        if (cached.valid && overlaps(cached.addr, sizeof(Tegra::Texture::TICEntry))) {
+            cached.valid = false;
+            res_cache.UpdatePagesCachedCount(cached.addr, sizeof(Tegra::Texture::TICEntry), -1);
+        }
+    }
+    for (auto& pair : tsc_cache) {
+        CachedTSCEntry& cached = pair.second;
+        if (cached.valid && overlaps(cached.addr, sizeof(Tegra::Texture::TSCEntry))) {
+            cached.valid = false;
+            res_cache.UpdatePagesCachedCount(cached.addr, sizeof(Tegra::Texture::TSCEntry), -1);
+        }
     }
 }
 
@@ -487,12 +794,192 @@ void RasterizerOpenGL::FlushRegion(VAddr addr, u64 size) {
 void RasterizerOpenGL::InvalidateRegion(VAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.InvalidateRegion(addr, size, nullptr);
+    InvalidateDescriptors(addr, size);
 }
 
 void RasterizerOpenGL::FlushAndInvalidateRegion(VAddr addr, u64 size) {
     MICROPROFILE_SCOPE(OpenGL_CacheManagement);
     res_cache.FlushRegion(addr, size);
     res_cache.InvalidateRegion(addr, size, nullptr);
+    InvalidateDescriptors(addr, size);
+}
+
+void RasterizerOpenGL::TickFrame() {
+    MICROPROFILE_SCOPE(OpenGL_CacheManagement);
+    res_cache.TickFrame();
+    query_cache.Poll();
+
+    if (Settings::values.use_dynamic_resolution) {
+        res_cache.SetDynamicResolutionScale(
+            dynamic_resolution.EndFrame(RasterizerCacheOpenGL::GetResolutionScaleFactor()));
+    } else {
+        res_cache.SetDynamicResolutionScale(0);
+    }
+}
+
+bool RasterizerOpenGL::ReportSamplesPassed(VAddr addr, bool long_report, u64 timestamp) {
+    query_cache.ReportSamplesPassed(addr, long_report, timestamp);
+    return true;
+}
+
+void RasterizerOpenGL::LoadDiskResources(const Tegra::DiskResourceLoadCallback& callback) {
+    shader_program_manager->LoadDiskCache(callback);
+    pipeline_cache.Open(Core::CurrentProcess()->program_id);
+    WarmUpPipelines();
+}
+
+void RasterizerOpenGL::RecordPipelineState(const Surface& color_surface, GLenum primitive_mode) {
+    // The warm-up draws need a target of the same format
+    const GLint color_format =
+        color_surface != nullptr ? color_surface->GetRenderTargetFormat() : 0;
+    if (color_format == 0) {
+        return;
+    }
+    const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
+
+    // The fields are set one by one, as assigning whole structs could copy over the zeroed padding
+    GLShader::PipelineState pipeline;
+    GLShader::PipelineStateData& data = pipeline.state;
+    std::tie(data.vs_disk_key, data.fs_disk_key) = shader_program_manager->GetCurrentDiskKeys();
+    data.primitive_mode = primitive_mode;
+    data.color_format = color_format;
+
+    data.blend_enabled = state.blend.enabled;
+    data.blend_rgb_equation = state.blend.rgb_equation;
+    data.blend_a_equation = state.blend.a_equation;
+    data.blend_src_rgb_func = state.blend.src_rgb_func;
+    data.blend_dst_rgb_func = state.blend.dst_rgb_func;
+    data.blend_src_a_func = state.blend.src_a_func;
+    data.blend_dst_a_func = state.blend.dst_a_func;
+
+    data.cull_enabled = state.cull.enabled;
+    data.cull_mode = state.cull.mode;
+    data.front_face = state.cull.front_face;
+
+    data.depth_test_enabled = state.depth.test_enabled;
+    data.depth_test_func = state.depth.test_func;
+    data.depth_write_mask = state.depth.write_mask;
+
+    // Same vertex formats as SetupVertexArray
+    data.vertex_stride = regs.vertex_array[0].stride;
+    for (unsigned index = 0; index < data.vertex_attribs.size(); ++index) {
+        const auto& attrib = regs.vertex_attrib_format[index];
+        auto& stored_attrib = data.vertex_attribs[index];
+        stored_attrib.size = static_cast<GLint>(attrib.ComponentCount());
+        stored_attrib.type = MaxwellToGL::VertexType(attrib);
+        stored_attrib.normalized = attrib.IsNormalized() ? GL_TRUE : GL_FALSE;
+        stored_attrib.offset = attrib.offset.Value();
+    }
+
+    pipeline_cache.Record(pipeline);
+}
+
+void RasterizerOpenGL::WarmUpPipelines() {
+    const std::vector<GLShader::PipelineState>& pipelines = pipeline_cache.GetStates();
+    // The targets are allocated with glTexStorage2D, as it takes any color format as is
+    if (pipelines.empty() || !GLAD_GL_ARB_texture_storage) {
+        return;
+    }
+    const auto warm_up_begin = std::chrono::steady_clock::now();
+
+    // The draws go to tiny targets of their own, with vertices from a buffer of zeros
+    constexpr GLsizei target_size = 4;
+    constexpr GLsizei vertex_count = 3;
+    OGLFramebuffer framebuffer;
+    framebuffer.Create();
+    std::unordered_map<GLint, OGLTexture> targets;
+    OGLVertexArray vertex_array;
+    vertex_array.Create();
+    OGLBuffer vertex_buffer;
+    vertex_buffer.Create();
+
+    OpenGLState warm_up_state = state;
+    warm_up_state.draw.read_framebuffer = framebuffer.handle;
+    warm_up_state.draw.draw_framebuffer = framebuffer.handle;
+    warm_up_state.draw.vertex_array = vertex_array.handle;
+    warm_up_state.draw.vertex_buffer = vertex_buffer.handle;
+    warm_up_state.scissor.enabled = false;
+    warm_up_state.viewport.x = 0;
+    warm_up_state.viewport.y = 0;
+    warm_up_state.viewport.width = target_size;
+    warm_up_state.viewport.height = target_size;
+    warm_up_state.Apply();
+
+    size_t drawn = 0;
+    size_t vertex_buffer_size = 0;
+    for (const GLShader::PipelineState& pipeline : pipelines) {
+        const GLShader::PipelineStateData& data = pipeline.state;
+        if (!shader_program_manager->UseStoredPrograms(data.vs_disk_key, data.fs_disk_key)) {
+            continue;
+        }
+
+        auto [target_iter, new_target] = targets.try_emplace(data.color_format);
+        if (new_target) {
+            target_iter->second.Create();
+            warm_up_state.texture_units[0].texture_2d = target_iter->second.handle;
+            warm_up_state.Apply();
+            glActiveTexture(GL_TEXTURE0);
+            glTexStorage2D(GL_TEXTURE_2D, 1, static_cast<GLenum>(data.color_format), target_size,
+                           target_size);
+            warm_up_state.texture_units[0].texture_2d = 0;
+        }
+
+        warm_up_state.blend.enabled = data.blend_enabled;
+        warm_up_state.blend.rgb_equation = data.blend_rgb_equation;
+        warm_up_state.blend.a_equation = data.blend_a_equation;
+        warm_up_state.blend.src_rgb_func = data.blend_src_rgb_func;
+        warm_up_state.blend.dst_rgb_func = data.blend_dst_rgb_func;
+        warm_up_state.blend.src_a_func = data.blend_src_a_func;
+        warm_up_state.blend.dst_a_func = data.blend_dst_a_func;
+        warm_up_state.cull.enabled = data.cull_enabled;
+        warm_up_state.cull.mode = data.cull_mode;
+        warm_up_state.cull.front_face = data.front_face;
+        warm_up_state.depth.test_enabled = data.depth_test_enabled;
+        warm_up_state.depth.test_func = data.depth_test_func;
+        warm_up_state.depth.write_mask = data.depth_write_mask;
+        shader_program_manager->ApplyTo(warm_up_state);
+        warm_up_state.Apply();
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               target_iter->second.handle, 0);
+
+        // The buffer holds every attribute of the vertices drawn, of up to four 32-bit components
+        size_t required_size = static_cast<size_t>(data.vertex_stride) * (vertex_count - 1);
+        size_t last_vertex_size = data.vertex_stride;
+        for (const auto& attrib : data.vertex_attribs) {
+            last_vertex_size = std::max<size_t>(last_vertex_size, attrib.offset + 4 * sizeof(u32));
+        }
+        required_size += last_vertex_size;
+        if (required_size > vertex_buffer_size) {
+            const std::vector<u8> zeros(required_size);
+            glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(zeros.size()), zeros.data(),
+                         GL_STATIC_DRAW);
+            vertex_buffer_size = required_size;
+        }
+        for (GLuint index = 0; index < data.vertex_attribs.size(); ++index) {
+            const auto& attrib = data.vertex_attribs[index];
+            glVertexAttribPointer(index, attrib.size, attrib.type, attrib.normalized,
+                                  data.vertex_stride, reinterpret_cast<GLvoid*>(attrib.offset));
+            glEnableVertexAttribArray(index);
+        }
+
+        glDrawArrays(data.primitive_mode, 0, vertex_count);
+        ++drawn;
+    }
+    // Drivers may build the variants as late as the draws run, which has to be before boot ends
+    glFinish();
+
+    // The objects of the warm-up are released on return, once the rasterizer's state is bound
+    state.Apply();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - warm_up_begin);
+    LOG_INFO(Render_OpenGL, "Warmed up %zu of %zu pipeline states in %lld ms", drawn,
+             pipelines.size(), static_cast<long long>(elapsed.count()));
+}
+
+bool RasterizerOpenGL::RequestSurfaceCapture(VAddr addr, Tegra::SurfaceCaptureCallback callback) {
+    res_cache.RequestSurfaceCapture(addr, std::move(callback));
+    return true;
 }
 
 bool RasterizerOpenGL::AccelerateDisplayTransfer(const void* config) {
@@ -511,6 +998,74 @@ bool RasterizerOpenGL::AccelerateFill(const void* config) {
     return true;
 }
 
+namespace {
+
+/// Returns whether the rasterizer cache can describe surfaces of a rendertarget format.
+bool IsSurfaceCopyFormatSupported(Tegra::RenderTargetFormat format) {
+    // TODO(Subv): Implement more render targets
+    return format == Tegra::RenderTargetFormat::RGBA8_UNORM;
+}
+
+SurfaceParams GetSurfaceCopyParams(const Tegra::Engines::Fermi2D::Regs::Surface& config) {
+    const auto& memory_manager = Core::System::GetInstance().GPU().memory_manager;
+
+    SurfaceParams params;
+    params.addr = memory_manager->PhysicalToVirtualAddress(config.Address());
+    params.width = config.width;
+    params.height = config.height;
+    params.is_tiled = config.linear == 0;
+    params.pixel_format = SurfaceParams::PixelFormatFromRenderTargetFormat(config.format);
+    params.component_type = SurfaceParams::ComponentTypeFromRenderTarget(config.format);
+    if (params.is_tiled) {
+        params.block_height = config.BlockHeight();
+    } else {
+        params.stride = static_cast<u32>(params.PixelsInBytes(config.pitch));
+    }
+    params.UpdateParams();
+    return params;
+}
+
+} // Anonymous namespace
+
+bool RasterizerOpenGL::AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                                             const Tegra::Engines::Fermi2D::Regs::Surface& dst) {
+    MICROPROFILE_SCOPE(OpenGL_Blits);
+    MICROPROFILE_SCOPEGPU(GPU_Blits);
+    Core::PerfStats::SubsystemScope perf_scope(Core::System::GetInstance().perf_stats,
+                                               Core::PerfStats::Subsystem::GlSubmission);
+
+    if (!IsSurfaceCopyFormatSupported(src.format) || !IsSurfaceCopyFormatSupported(dst.format)) {
+        return false;
+    }
+
+    const SurfaceParams src_params = GetSurfaceCopyParams(src);
+    Surface src_surface;
+    MathUtil::Rectangle<u32> src_rect;
+    std::tie(src_surface, src_rect) =
+        res_cache.GetSurfaceSubRect(src_params, ScaleMatch::Ignore, true);
+    if (src_surface == nullptr) {
+        return false;
+    }
+
+    SurfaceParams dst_params = GetSurfaceCopyParams(dst);
+    dst_params.res_scale = src_surface->res_scale;
+    Surface dst_surface;
+    MathUtil::Rectangle<u32> dst_rect;
+    std::tie(dst_surface, dst_rect) =
+        res_cache.GetSurfaceSubRect(dst_params, ScaleMatch::Upscale, false);
+    if (dst_surface == nullptr) {
+        return false;
+    }
+
+    if (!res_cache.BlitSurfaces(src_surface, src_rect, dst_surface, dst_rect)) {
+        return false;
+    }
+
+    // The copy only exists on the host GPU, which the destination surface now owns.
+    res_cache.InvalidateRegion(dst_params.addr, dst_params.size, dst_surface);
+    return true;
+}
+
 bool RasterizerOpenGL::AccelerateDisplay(const Tegra::FramebufferConfig& framebuffer,
                                          VAddr framebuffer_addr, u32 pixel_stride,
                                          ScreenInfo& screen_info) {
@@ -620,12 +1175,10 @@ u32 RasterizerOpenGL::SetupConstBuffers(Maxwell::ShaderStage stage, GLuint progr
         buffer_draw_state.bindpoint = current_bindpoint + bindpoint;
 
         VAddr addr = gpu.memory_manager->PhysicalToVirtualAddress(buffer.address);
-        std::vector<u8> data(used_buffer.GetSize() * sizeof(float));
-        Memory::ReadBlock(addr, data.data(), data.size());
-
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer_draw_state.ssbo);
-        glBufferData(GL_SHADER_STORAGE_BUFFER, data.size(), data.data(), GL_DYNAMIC_DRAW);
-        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        auto& uploaded =
+            uploaded_const_buffers[static_cast<size_t>(stage)][used_buffer.GetIndex()];
+        UploadConstBuffer(uploaded, buffer_draw_state.ssbo, addr,
+                          used_buffer.GetSize() * sizeof(float));
 
         // Now configure the bindpoint of the buffer inside the shader
         std::string buffer_name = used_buffer.GetName();
@@ -640,30 +1193,50 @@ u32 RasterizerOpenGL::SetupConstBuffers(Maxwell::ShaderStage stage, GLuint progr
     return current_bindpoint + entries.size();
 }
 
+void RasterizerOpenGL::UploadConstBuffer(UploadedConstBuffer& uploaded, GLuint ssbo, VAddr addr,
+                                         size_t size) {
+    // The buffer is compared in place when possible, and copied out of guest memory otherwise.
+    const u8* data = Memory::GetContiguousPointer(addr, size);
+    if (data == nullptr) {
+        const_buffer_scratch.resize(size);
+        Memory::ReadBlock(addr, const_buffer_scratch.data(), size);
+        data = const_buffer_scratch.data();
+    }
+
+    if (uploaded.addr != addr || uploaded.data.size() != size) {
+        uploaded.addr = addr;
+        uploaded.data.assign(data, data + size);
+
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, size, data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        return;
+    }
+
+    // Most draws leave the buffer as it was, and the others tend to change a small part of it.
+    // Only the range between the first and the last changed byte is uploaded.
+    const auto first = std::mismatch(uploaded.data.begin(), uploaded.data.end(), data);
+    if (first.first == uploaded.data.end()) {
+        return;
+    }
+    const auto last = std::mismatch(uploaded.data.rbegin(), uploaded.data.rend(),
+                                    std::reverse_iterator<const u8*>(data + size));
+    const size_t offset = first.first - uploaded.data.begin();
+    const size_t length = (uploaded.data.rend() - last.first) - offset;
+    std::copy(data + offset, data + offset + length, uploaded.data.begin() + offset);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, length, data + offset);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 void RasterizerOpenGL::BindFramebufferSurfaces(const Surface& color_surface,
                                                const Surface& depth_surface, bool has_stencil) {
-    state.draw.draw_framebuffer = framebuffer.handle;
+    // Each combination of surfaces has a framebuffer of its own, only set up when first used, so
+    // that the driver doesn't have to validate new attachments on every draw.
+    state.draw.draw_framebuffer =
+        res_cache.GetFramebuffer(color_surface, depth_surface, has_stencil);
     state.Apply();
-
-    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                           color_surface != nullptr ? color_surface->texture.handle : 0, 0);
-    if (depth_surface != nullptr) {
-        if (has_stencil) {
-            // attach both depth and stencil
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                                   depth_surface->texture.handle, 0);
-        } else {
-            // attach depth
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                                   depth_surface->texture.handle, 0);
-            // clear stencil attachment
-            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
-        }
-    } else {
-        // clear both depth and stencil attachment
-        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
-                               0);
-    }
 }
 
 void RasterizerOpenGL::SyncViewport(const MathUtil::Rectangle<u32>& surfaces_rect, u16 res_scale) {
@@ -701,7 +1274,28 @@ void RasterizerOpenGL::SyncBlendEnabled() {
 }
 
 void RasterizerOpenGL::SyncBlendFuncs() {
-    UNREACHABLE();
+    using Blend = Tegra::Engines::Maxwell3D::Regs::Blend;
+    const auto& blend = Core::System::GetInstance().GPU().Maxwell3D().regs.blend;
+    ASSERT_MSG(blend.separate_alpha == 0, "unimplemented");
+
+    // Zero isn't a valid equation or factor. It is what the registers hold until the guest writes
+    // them, and the current host state is kept for those.
+    const auto sync_equation = [](GLenum& host, Blend::Equation equation) {
+        if (static_cast<u32>(equation) != 0) {
+            host = MaxwellToGL::BlendEquation(equation);
+        }
+    };
+    const auto sync_factor = [](GLenum& host, Blend::Factor factor) {
+        if (static_cast<u32>(factor) != 0) {
+            host = MaxwellToGL::BlendFunc(factor);
+        }
+    };
+    sync_equation(state.blend.rgb_equation, blend.equation_rgb);
+    sync_factor(state.blend.src_rgb_func, blend.factor_source_rgb);
+    sync_factor(state.blend.dst_rgb_func, blend.factor_dest_rgb);
+    sync_equation(state.blend.a_equation, blend.equation_a);
+    sync_factor(state.blend.src_a_func, blend.factor_source_a);
+    sync_factor(state.blend.dst_a_func, blend.factor_dest_a);
 }
 
 void RasterizerOpenGL::SyncBlendColor() {
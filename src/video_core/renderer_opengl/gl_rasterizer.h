@@ -17,6 +17,9 @@
 #include "common/vector_math.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_opengl/gl_dynamic_resolution.h"
+#include "video_core/renderer_opengl/gl_pipeline_cache.h"
+#include "video_core/renderer_opengl/gl_query_cache.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
@@ -32,14 +35,20 @@ public:
     ~RasterizerOpenGL() override;
 
     void DrawArrays() override;
-    void NotifyMaxwellRegisterChanged(u32 method) override;
+    void Clear() override;
     void FlushAll() override;
     void FlushRegion(VAddr addr, u64 size) override;
     void InvalidateRegion(VAddr addr, u64 size) override;
     void FlushAndInvalidateRegion(VAddr addr, u64 size) override;
+    void TickFrame() override;
+    bool ReportSamplesPassed(VAddr addr, bool long_report, u64 timestamp) override;
+    void LoadDiskResources(const Tegra::DiskResourceLoadCallback& callback) override;
+    bool RequestSurfaceCapture(VAddr addr, Tegra::SurfaceCaptureCallback callback) override;
     bool AccelerateDisplayTransfer(const void* config) override;
     bool AccelerateTextureCopy(const void* config) override;
     bool AccelerateFill(const void* config) override;
+    bool AccelerateSurfaceCopy(const Tegra::Engines::Fermi2D::Regs::Surface& src,
+                               const Tegra::Engines::Fermi2D::Regs::Surface& dst) override;
     bool AccelerateDisplay(const Tegra::FramebufferConfig& framebuffer, VAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
     bool AccelerateDrawBatch(bool is_indexed) override;
@@ -84,8 +93,13 @@ private:
     void BindFramebufferSurfaces(const Surface& color_surface, const Surface& depth_surface,
                                  bool has_stencil);
 
-    /// Binds the required textures to OpenGL before drawing a batch.
-    void BindTextures();
+    /**
+     * Binds the textures sampled by a shader stage to OpenGL before drawing a batch.
+     * @param stage The shader stage to bind textures for.
+     * @param entries The texture samplers used by the shader of the stage.
+     */
+    void SetupTextures(Tegra::Engines::Maxwell3D::Regs::ShaderStage stage,
+                       const std::vector<GLShader::SamplerEntry>& entries);
 
     /*
      * Configures the current constbuffers to use for the draw command.
@@ -126,6 +140,13 @@ private:
     /// Syncs the blend color to match the guest state
     void SyncBlendColor();
 
+    /// Records the pipeline state of a draw, for it to be warmed up in later sessions
+    void RecordPipelineState(const Surface& color_surface, GLenum primitive_mode);
+
+    /// Draws off-screen with each pipeline state recorded for the title whose programs are built,
+    /// so that the driver builds the variants of the programs for them ahead of the guest's draws
+    void WarmUpPipelines();
+
     bool has_ARB_buffer_storage;
     bool has_ARB_direct_state_access;
     bool has_ARB_separate_shader_objects;
@@ -133,7 +154,77 @@ private:
 
     OpenGLState state;
 
+    /// Texture descriptor read from the TIC buffer, kept until the guest writes to its memory
+    struct CachedTICEntry {
+        VAddr addr = 0;
+        bool valid = false;
+        Tegra::Texture::TICEntry tic;
+    };
+
+    /// Sampler descriptor read from the TSC buffer, and the sampler object configured from it.
+    /// The sampler object outlives the descriptor, so that it is only reconfigured afterwards.
+    struct CachedTSCEntry {
+        VAddr addr = 0;
+        bool valid = false;
+        SamplerInfo sampler;
+    };
+
+    /// Returns the TIC entry of the specified index, reading it from memory when not cached.
+    const Tegra::Texture::TICEntry& GetCachedTICEntry(u32 tic_index);
+
+    /// Returns the sampler for the TSC entry of the specified index, reading the entry from memory
+    /// and configuring the sampler when not cached.
+    const SamplerInfo& GetCachedSampler(u32 tsc_index);
+
+    /// Drops the texture descriptors read from the specified region of memory.
+    void InvalidateDescriptors(VAddr addr, u64 size);
+
+    /// Contents last uploaded to a const buffer SSBO, and the address they were read from
+    struct UploadedConstBuffer {
+        VAddr addr = 0;
+        std::vector<u8> data;
+    };
+
+    /// Uploads the part of a const buffer that changed since it was last uploaded to the SSBO.
+    void UploadConstBuffer(UploadedConstBuffer& uploaded, GLuint ssbo, VAddr addr, size_t size);
+
+    /// Vertex or index data of a guest memory range, and the hash of what was last uploaded
+    struct CachedGuestBuffer {
+        OGLBuffer buffer;
+        u64 size = 0;
+        u64 hash = 0;
+    };
+
+    /// Returns a buffer object holding the data of a guest memory range. The data is only uploaded
+    /// again when it changed since the last draw that used the range.
+    GLuint GetCachedGuestBuffer(VAddr addr, u64 size);
+
+    /// Guest quad indices, converted to the indices of two triangles per quad
+    struct CachedQuadIndexBuffer {
+        OGLBuffer buffer;
+        u64 size = 0;
+        u64 hash = 0;
+        u32 index_size = 0;
+    };
+
+    /// Returns a buffer object holding the triangle indices of the guest quad indices of a memory
+    /// range. The indices are only converted again when they changed since they were last used.
+    GLuint GetCachedQuadIndexBuffer(VAddr addr, u32 count, u32 index_size);
+
+    /// Returns a buffer object holding the 32-bit triangle indices of quad_count sequential quads.
+    GLuint GetQuadArrayIndexBuffer(u32 quad_count);
+
+    /// Returns the data of a guest memory range, in place when possible and copied otherwise.
+    const u8* ReadGuestBuffer(VAddr addr, u64 size);
+
+    /// Framebuffer region and scale the viewport was last synced for
+    MathUtil::Rectangle<u32> viewport_surfaces_rect{};
+    u16 viewport_res_scale = 0;
+
     RasterizerCacheOpenGL res_cache;
+    QueryCacheOpenGL query_cache;
+    GLShader::PipelineCache pipeline_cache;
+    DynamicResolutionOpenGL dynamic_resolution;
 
     std::unique_ptr<GLShader::ProgramManager> shader_program_manager;
     OGLVertexArray sw_vao;
@@ -141,21 +232,36 @@ private:
     std::array<bool, 16> hw_vao_enabled_attributes;
 
     std::array<SamplerInfo, GLShader::NumTextureSamplers> texture_samplers;
+    std::unordered_map<u32, CachedTICEntry> tic_cache;
+    std::unordered_map<u32, CachedTSCEntry> tsc_cache;
     std::array<std::array<OGLBuffer, Tegra::Engines::Maxwell3D::Regs::MaxConstBuffers>,
                Tegra::Engines::Maxwell3D::Regs::MaxShaderStage>
         ssbos;
+    std::array<std::array<UploadedConstBuffer, Tegra::Engines::Maxwell3D::Regs::MaxConstBuffers>,
+               Tegra::Engines::Maxwell3D::Regs::MaxShaderStage>
+        uploaded_const_buffers;
+    /// Holds const buffers that can't be read in place, reused so that draws don't allocate
+    std::vector<u8> const_buffer_scratch;
+
+    /// Guest buffers are dropped all at once past this count, as the ranges used by streamed
+    /// vertex data keep moving.
+    static constexpr size_t MaxCachedGuestBuffers = 1024;
+    std::unordered_map<VAddr, CachedGuestBuffer> guest_buffer_cache;
+    std::unordered_map<VAddr, CachedQuadIndexBuffer> quad_index_cache;
+    /// Holds vertex and index data that can't be hashed in place
+    std::vector<u8> guest_buffer_scratch;
+    /// Holds the triangle indices of quads while they are uploaded
+    std::vector<u8> quad_index_scratch;
+    /// Triangle indices of sequential quads, shared by the non-indexed quad draws
+    OGLBuffer quad_array_buffer;
+    u32 quad_array_count = 0;
 
-    static constexpr size_t VERTEX_BUFFER_SIZE = 128 * 1024 * 1024;
-    std::unique_ptr<OGLStreamBuffer> vertex_buffer;
     OGLBuffer uniform_buffer;
-    OGLFramebuffer framebuffer;
 
     static constexpr size_t STREAM_BUFFER_SIZE = 4 * 1024 * 1024;
     std::unique_ptr<OGLStreamBuffer> stream_buffer;
 
-    GLsizeiptr vs_input_size;
-
-    void SetupVertexArray(u8* array_ptr, GLintptr buffer_offset);
+    void SetupVertexArray();
 
     std::array<OGLBuffer, Tegra::Engines::Maxwell3D::Regs::MaxShaderStage> uniform_buffers;
 
@@ -4,6 +4,7 @@
 
 #include <algorithm>
 #include <atomic>
+#include <cinttypes>
 #include <cstring>
 #include <iterator>
 #include <memory>
@@ -16,8 +17,10 @@
 #include "common/alignment.h"
 #include "common/bit_field.h"
 #include "common/color.h"
+#include "common/content_hash.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
+#include "common/memory_usage.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
 #include "common/vector_math.h"
@@ -38,6 +41,9 @@ using SurfaceType = SurfaceParams::SurfaceType;
 using PixelFormat = SurfaceParams::PixelFormat;
 using ComponentType = SurfaceParams::ComponentType;
 
+static Common::MemoryUsageCounter texture_usage("Texture cache");
+static Common::MemoryUsageCounter staging_buffer_usage("Texture cache staging buffers");
+
 struct FormatTuple {
     GLint internal_format;
     GLenum format;
@@ -54,6 +60,8 @@ static constexpr std::array<FormatTuple, SurfaceParams::MaxPixelFormat> tex_form
     {GL_COMPRESSED_RGB_S3TC_DXT1_EXT, GL_RGB, GL_UNSIGNED_INT_8_8_8_8, true, 16},   // DXT1
     {GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, true, 16}, // DXT23
     {GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, true, 16}, // DXT45
+    // ASTC is decoded to RGBA8 by the ASTC decoder, so the texture is an uncompressed one
+    {GL_RGBA8, GL_RGBA, GL_UNSIGNED_INT_8_8_8_8_REV, false, 1}, // ASTC_2D_4X4
 }};
 
 static const FormatTuple& GetFormatTuple(PixelFormat pixel_format, ComponentType component_type) {
@@ -77,7 +85,7 @@ constexpr auto RangeFromInterval(Map& map, const Interval& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
-static u16 GetResolutionScaleFactor() {
+u16 RasterizerCacheOpenGL::GetResolutionScaleFactor() {
     return static_cast<u16>(!Settings::values.resolution_factor
                                 ? VideoCore::g_emu_window->GetFramebufferLayout().GetScalingRatio()
                                 : Settings::values.resolution_factor);
@@ -98,8 +106,8 @@ void MortonCopy(u32 stride, u32 block_height, u32 height, u8* gl_buffer, VAddr b
         // TODO(bunnei): Assumes the default rendering GOB size of 16 (128 lines). We should check
         // the configuration for this and perform more generic un/swizzle
         LOG_WARNING(Render_OpenGL, "need to use correct swizzle/GOB parameters!");
-        VideoCore::MortonCopyPixels128(stride, height, bytes_per_pixel, gl_bytes_per_pixel,
-                                       Memory::GetPointer(base), gl_buffer, morton_to_gl);
+        VideoCore::MortonCopyPixels128<bytes_per_pixel, gl_bytes_per_pixel>(
+            stride, height, Memory::GetPointer(base), gl_buffer, morton_to_gl);
     }
 }
 
@@ -108,7 +116,7 @@ static constexpr std::array<void (*)(u32, u32, u32, u8*, VAddr, VAddr, VAddr),
     morton_to_gl_fns = {
         MortonCopy<true, PixelFormat::ABGR8>, MortonCopy<true, PixelFormat::B5G6R5>,
         MortonCopy<true, PixelFormat::DXT1>,  MortonCopy<true, PixelFormat::DXT23>,
-        MortonCopy<true, PixelFormat::DXT45>,
+        MortonCopy<true, PixelFormat::DXT45>, MortonCopy<true, PixelFormat::ASTC_2D_4X4>,
 };
 
 static constexpr std::array<void (*)(u32, u32, u32, u8*, VAddr, VAddr, VAddr),
@@ -120,6 +128,8 @@ static constexpr std::array<void (*)(u32, u32, u32, u8*, VAddr, VAddr, VAddr),
         nullptr,
         nullptr,
         nullptr,
+        // ASTC surfaces are never flushed, as the GPU can't render to them
+        nullptr,
 };
 
 // Allocate an uninitialized texture of appropriate size and format for the surface
@@ -209,6 +219,45 @@ static bool BlitTextures(GLuint src_tex, const MathUtil::Rectangle<u32>& src_rec
     return true;
 }
 
+/**
+ * Copies a rectangle between the textures of two surfaces of the same format texel for texel,
+ * which unlike a blit doesn't attach them to framebuffers. Returns false if the copy can't be
+ * done that way and has to be blitted instead.
+ */
+static bool CopyTextures(const CachedSurface& src_surface, const MathUtil::Rectangle<u32>& src_rect,
+                         const CachedSurface& dst_surface,
+                         const MathUtil::Rectangle<u32>& dst_rect) {
+    // Blits of mirrored rectangles flip the image, which a copy can't do
+    const auto is_upright = [](const MathUtil::Rectangle<u32>& rect) {
+        return rect.right >= rect.left && rect.top >= rect.bottom;
+    };
+    if (!GLAD_GL_ARB_copy_image || src_surface.pixel_format != dst_surface.pixel_format ||
+        src_surface.component_type != dst_surface.component_type ||
+        src_rect.GetWidth() != dst_rect.GetWidth() ||
+        src_rect.GetHeight() != dst_rect.GetHeight() || !is_upright(src_rect) ||
+        !is_upright(dst_rect)) {
+        return false;
+    }
+
+    // Compressed textures are copied in whole blocks
+    if (GetFormatTuple(src_surface.pixel_format, src_surface.component_type).compressed) {
+        const auto is_block_aligned = [](const MathUtil::Rectangle<u32>& rect) {
+            return (rect.left | rect.bottom | rect.GetWidth() | rect.GetHeight()) % 4 == 0;
+        };
+        if (!is_block_aligned(src_rect) || !is_block_aligned(dst_rect)) {
+            return false;
+        }
+    }
+
+    glCopyImageSubData(src_surface.texture.handle, GL_TEXTURE_2D, 0,
+                       static_cast<GLint>(src_rect.left), static_cast<GLint>(src_rect.bottom), 0,
+                       dst_surface.texture.handle, GL_TEXTURE_2D, 0,
+                       static_cast<GLint>(dst_rect.left), static_cast<GLint>(dst_rect.bottom), 0,
+                       static_cast<GLsizei>(src_rect.GetWidth()),
+                       static_cast<GLsizei>(src_rect.GetHeight()), 1);
+    return true;
+}
+
 static bool FillSurface(const Surface& surface, const u8* fill_data,
                         const MathUtil::Rectangle<u32>& fill_rect, GLuint draw_fb_handle) {
     UNREACHABLE();
@@ -342,6 +391,14 @@ bool SurfaceParams::CanTexCopy(const SurfaceParams& texcopy_params) const {
     return FromInterval(texcopy_params.GetInterval()).GetInterval() == texcopy_params.GetInterval();
 }
 
+GLint CachedSurface::GetRenderTargetFormat() const {
+    if (type != SurfaceType::ColorTexture) {
+        return 0;
+    }
+    const FormatTuple& tuple = GetFormatTuple(pixel_format, component_type);
+    return tuple.compressed ? 0 : tuple.internal_format;
+}
+
 bool CachedSurface::CanFill(const SurfaceParams& dest_surface,
                             SurfaceInterval fill_interval) const {
     if (type == SurfaceType::Fill && IsRegionValid(fill_interval) &&
@@ -431,6 +488,10 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
 
     ASSERT(src_surface != dst_surface);
 
+    FinishSurfaceDecode(src_surface);
+    FinishSurfaceDecode(dst_surface);
+    dst_surface->content_hash = boost::none;
+
     // This is only called when CanCopy is true, no need to run checks here
     if (src_surface->type == SurfaceType::Fill) {
         // FillSurface needs a 4 bytes buffer
@@ -447,9 +508,13 @@ void RasterizerCacheOpenGL::CopySurface(const Surface& src_surface, const Surfac
         return;
     }
     if (src_surface->CanSubRect(subrect_params)) {
-        BlitTextures(src_surface->texture.handle, src_surface->GetScaledSubRect(subrect_params),
-                     dst_surface->texture.handle, dst_surface->GetScaledSubRect(subrect_params),
-                     src_surface->type, read_framebuffer.handle, draw_framebuffer.handle);
+        const auto src_rect = src_surface->GetScaledSubRect(subrect_params);
+        const auto dst_rect = dst_surface->GetScaledSubRect(subrect_params);
+        if (!CopyTextures(*src_surface, src_rect, *dst_surface, dst_rect)) {
+            BlitTextures(src_surface->texture.handle, src_rect, dst_surface->texture.handle,
+                         dst_rect, src_surface->type, read_framebuffer.handle,
+                         draw_framebuffer.handle);
+        }
         return;
     }
     UNREACHABLE();
@@ -491,6 +556,7 @@ void CachedSurface::FlushGLBuffer(VAddr flush_start, VAddr flush_end) {
         return;
 
     ASSERT(gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format));
+    keep_gl_buffer = true;
 
     // TODO: Should probably be done in ::Memory:: and check for other regions too
     // same as loadglbuffer()
@@ -528,15 +594,30 @@ void CachedSurface::FlushGLBuffer(VAddr flush_start, VAddr flush_end) {
     }
 }
 
+/// Returns the unscaled texture of a surface, allocating it the first time it's used
+static GLuint GetUnscaledTexture(CachedSurface& surface, const FormatTuple& tuple) {
+    if (surface.unscaled_texture.handle == 0) {
+        surface.unscaled_texture.Create();
+        AllocateSurfaceTexture(surface.unscaled_texture.handle, tuple, surface.width,
+                               surface.height);
+    }
+    return surface.unscaled_texture.handle;
+}
+
 MICROPROFILE_DEFINE(OpenGL_TextureUL, "OpenGL", "Texture Upload", MP_RGB(128, 64, 192));
+MICROPROFILE_DEFINE_GPU(GPU_TextureUL, "Texture Upload", MP_RGB(128, 64, 192));
 void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                                    GLuint draw_fb_handle) {
+                                    GLuint draw_fb_handle, bool from_unpack_buffer) {
     if (type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureUL);
+    MICROPROFILE_SCOPEGPU(GPU_TextureUL);
 
-    ASSERT(gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format));
+    // Offsets into the unpack buffer are passed as pointers
+    const u8* const source = from_unpack_buffer ? nullptr : gl_buffer.get();
+    ASSERT(from_unpack_buffer ||
+           gl_buffer_size == width * height * GetGLBytesPerPixel(pixel_format));
 
     // Load data from memory to the surface
     GLint x0 = static_cast<GLint>(rect.left);
@@ -546,16 +627,24 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
     const FormatTuple& tuple = GetFormatTuple(pixel_format, component_type);
     GLuint target_tex = texture.handle;
 
-    // If not 1x scale, create 1x texture that we will blit from to replace texture subrect in
-    // surface
-    OGLTexture unscaled_tex;
+    // If not 1x scale, load the unscaled texture, and blit from it to replace the texture subrect
+    // in the surface. Compressed data replaces the whole texture it's loaded to, so it gets a 1x
+    // texture of the size of the rect instead.
+    MathUtil::Rectangle<u32> unscaled_rect = rect;
+    OGLTexture compressed_unscaled_tex;
     if (res_scale != 1) {
-        x0 = 0;
-        y0 = 0;
-
-        unscaled_tex.Create();
-        AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth(), rect.GetHeight());
-        target_tex = unscaled_tex.handle;
+        if (tuple.compressed) {
+            x0 = 0;
+            y0 = 0;
+            unscaled_rect = {0, rect.GetHeight(), rect.GetWidth(), 0};
+
+            compressed_unscaled_tex.Create();
+            AllocateSurfaceTexture(compressed_unscaled_tex.handle, tuple, rect.GetWidth(),
+                                   rect.GetHeight());
+            target_tex = compressed_unscaled_tex.handle;
+        } else {
+            target_tex = GetUnscaledTexture(*this, tuple);
+        }
     }
 
     OpenGLState cur_state = OpenGLState::GetCurState();
@@ -575,11 +664,11 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
                                static_cast<GLsizei>(rect.GetHeight()), 0,
                                rect.GetWidth() * rect.GetHeight() *
                                    GetGLBytesPerPixel(pixel_format) / tuple.compression_factor,
-                               &gl_buffer[buffer_offset]);
+                               source + buffer_offset);
     } else {
         glTexSubImage2D(GL_TEXTURE_2D, 0, x0, y0, static_cast<GLsizei>(rect.GetWidth()),
                         static_cast<GLsizei>(rect.GetHeight()), tuple.format, tuple.type,
-                        &gl_buffer[buffer_offset]);
+                        source + buffer_offset);
     }
 
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
@@ -594,23 +683,25 @@ void CachedSurface::UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
 
-        BlitTextures(unscaled_tex.handle, {0, rect.GetHeight(), rect.GetWidth(), 0}, texture.handle,
-                     scaled_rect, type, read_fb_handle, draw_fb_handle);
+        BlitTextures(target_tex, unscaled_rect, texture.handle, scaled_rect, type, read_fb_handle,
+                     draw_fb_handle);
     }
 }
 
 MICROPROFILE_DEFINE(OpenGL_TextureDL, "OpenGL", "Texture Download", MP_RGB(128, 192, 64));
 void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                                      GLuint draw_fb_handle) {
+                                      GLuint draw_fb_handle, bool to_pack_buffer) {
     if (type == SurfaceType::Fill)
         return;
 
     MICROPROFILE_SCOPE(OpenGL_TextureDL);
 
-    if (gl_buffer == nullptr) {
+    if (gl_buffer == nullptr && !to_pack_buffer) {
         gl_buffer_size = width * height * GetGLBytesPerPixel(pixel_format);
         gl_buffer.reset(new u8[gl_buffer_size]);
     }
+    // Offsets into the pack buffer are passed as pointers
+    u8* const destination = to_pack_buffer ? nullptr : gl_buffer.get();
 
     OpenGLState state = OpenGLState::GetCurState();
     OpenGLState prev_state = state;
@@ -623,7 +714,8 @@ void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLui
     glPixelStorei(GL_PACK_ROW_LENGTH, static_cast<GLint>(stride));
     size_t buffer_offset = (rect.bottom * stride + rect.left) * GetGLBytesPerPixel(pixel_format);
 
-    // If not 1x scale, blit scaled texture to a new 1x texture and use that to flush
+    // If not 1x scale, blit the scaled texture down to the unscaled one and flush from that
+    GLuint source_tex = texture.handle;
     if (res_scale != 1) {
         auto scaled_rect = rect;
         scaled_rect.left *= res_scale;
@@ -631,43 +723,33 @@ void CachedSurface::DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLui
         scaled_rect.right *= res_scale;
         scaled_rect.bottom *= res_scale;
 
-        OGLTexture unscaled_tex;
-        unscaled_tex.Create();
-
-        MathUtil::Rectangle<u32> unscaled_tex_rect{0, rect.GetHeight(), rect.GetWidth(), 0};
-        AllocateSurfaceTexture(unscaled_tex.handle, tuple, rect.GetWidth(), rect.GetHeight());
-        BlitTextures(texture.handle, scaled_rect, unscaled_tex.handle, unscaled_tex_rect, type,
-                     read_fb_handle, draw_fb_handle);
+        source_tex = GetUnscaledTexture(*this, tuple);
+        BlitTextures(texture.handle, scaled_rect, source_tex, rect, type, read_fb_handle,
+                     draw_fb_handle);
+    }
 
-        state.texture_units[0].texture_2d = unscaled_tex.handle;
-        state.Apply();
+    state.ResetTexture(source_tex);
+    state.draw.read_framebuffer = read_fb_handle;
+    state.Apply();
 
-        glActiveTexture(GL_TEXTURE0);
-        glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+    if (type == SurfaceType::ColorTexture) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, source_tex,
+                               0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0,
+                               0);
+    } else if (type == SurfaceType::Depth) {
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, source_tex,
+                               0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
     } else {
-        state.ResetTexture(texture.handle);
-        state.draw.read_framebuffer = read_fb_handle;
-        state.Apply();
-
-        if (type == SurfaceType::ColorTexture) {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                                   0, 0);
-        } else if (type == SurfaceType::Depth) {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
-        } else {
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
-            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
-                                   texture.handle, 0);
-        }
-        glReadPixels(static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom),
-                     static_cast<GLsizei>(rect.GetWidth()), static_cast<GLsizei>(rect.GetHeight()),
-                     tuple.format, tuple.type, &gl_buffer[buffer_offset]);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D,
+                               source_tex, 0);
     }
+    glReadPixels(static_cast<GLint>(rect.left), static_cast<GLint>(rect.bottom),
+                 static_cast<GLsizei>(rect.GetWidth()), static_cast<GLsizei>(rect.GetHeight()),
+                 tuple.format, tuple.type, destination + buffer_offset);
 
     glPixelStorei(GL_PACK_ROW_LENGTH, 0);
 }
@@ -688,7 +770,7 @@ constexpr MatchFlags operator|(MatchFlags lhs, MatchFlags rhs) {
 
 /// Get the best surface match (and its match type) for the given flags
 template <MatchFlags find_flags>
-Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params,
+Surface FindMatch(SurfaceIndex& surface_cache, const SurfaceParams& params,
                   ScaleMatch match_scale_type,
                   boost::optional<SurfaceInterval> validate_interval = boost::none) {
     Surface match_surface = nullptr;
@@ -696,81 +778,79 @@ Surface FindMatch(const SurfaceCache& surface_cache, const SurfaceParams& params
     u32 match_scale = 0;
     SurfaceInterval match_interval{};
 
-    for (auto& pair : RangeFromInterval(surface_cache, params.GetInterval())) {
-        for (auto& surface : pair.second) {
-            bool res_scale_matched = match_scale_type == ScaleMatch::Exact
-                                         ? (params.res_scale == surface->res_scale)
-                                         : (params.res_scale <= surface->res_scale);
-            // validity will be checked in GetCopyableInterval
-            bool is_valid =
-                find_flags & MatchFlags::Copy
-                    ? true
-                    : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
-
-            if (!(find_flags & MatchFlags::Invalid) && !is_valid)
-                continue;
-
-            auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
-                if (!(find_flags & check_type))
-                    return;
-
-                bool matched;
-                SurfaceInterval surface_interval;
-                std::tie(matched, surface_interval) = match_fn();
-                if (!matched)
-                    return;
-
-                if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
-                    surface->type != SurfaceType::Fill)
-                    return;
-
-                // Found a match, update only if this is better than the previous one
-                auto UpdateMatch = [&] {
-                    match_surface = surface;
-                    match_valid = is_valid;
-                    match_scale = surface->res_scale;
-                    match_interval = surface_interval;
-                };
+    surface_cache.ForEachInInterval(params.GetInterval(), [&](const Surface& surface) {
+        bool res_scale_matched = match_scale_type == ScaleMatch::Exact
+                                     ? (params.res_scale == surface->res_scale)
+                                     : (params.res_scale <= surface->res_scale);
+        // validity will be checked in GetCopyableInterval
+        bool is_valid =
+            find_flags & MatchFlags::Copy
+                ? true
+                : surface->IsRegionValid(validate_interval.value_or(params.GetInterval()));
+
+        if (!(find_flags & MatchFlags::Invalid) && !is_valid)
+            return;
+
+        auto IsMatch_Helper = [&](auto check_type, auto match_fn) {
+            if (!(find_flags & check_type))
+                return;
+
+            bool matched;
+            SurfaceInterval surface_interval;
+            std::tie(matched, surface_interval) = match_fn();
+            if (!matched)
+                return;
+
+            if (!res_scale_matched && match_scale_type != ScaleMatch::Ignore &&
+                surface->type != SurfaceType::Fill)
+                return;
+
+            // Found a match, update only if this is better than the previous one
+            auto UpdateMatch = [&] {
+                match_surface = surface;
+                match_valid = is_valid;
+                match_scale = surface->res_scale;
+                match_interval = surface_interval;
+            };
 
-                if (surface->res_scale > match_scale) {
-                    UpdateMatch();
-                    return;
-                } else if (surface->res_scale < match_scale) {
-                    return;
-                }
+            if (surface->res_scale > match_scale) {
+                UpdateMatch();
+                return;
+            } else if (surface->res_scale < match_scale) {
+                return;
+            }
 
-                if (is_valid && !match_valid) {
-                    UpdateMatch();
-                    return;
-                } else if (is_valid != match_valid) {
-                    return;
-                }
+            if (is_valid && !match_valid) {
+                UpdateMatch();
+                return;
+            } else if (is_valid != match_valid) {
+                return;
+            }
 
-                if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
-                    UpdateMatch();
-                }
-            };
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
-                return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
-                return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
-                auto copy_interval =
-                    params.FromInterval(*validate_interval).GetCopyableInterval(surface);
-                bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
-                               surface->CanCopy(params, copy_interval);
-                return std::make_pair(matched, copy_interval);
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
-                return std::make_pair(surface->CanExpand(params), surface->GetInterval());
-            });
-            IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
-                return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
-            });
-        }
-    }
+            if (boost::icl::length(surface_interval) > boost::icl::length(match_interval)) {
+                UpdateMatch();
+            }
+        };
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Exact>{}, [&] {
+            return std::make_pair(surface->ExactMatch(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::SubRect>{}, [&] {
+            return std::make_pair(surface->CanSubRect(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Copy>{}, [&] {
+            auto copy_interval =
+                params.FromInterval(*validate_interval).GetCopyableInterval(surface);
+            bool matched = boost::icl::length(copy_interval & *validate_interval) != 0 &&
+                           surface->CanCopy(params, copy_interval);
+            return std::make_pair(matched, copy_interval);
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::Expand>{}, [&] {
+            return std::make_pair(surface->CanExpand(params), surface->GetInterval());
+        });
+        IsMatch_Helper(std::integral_constant<MatchFlags, MatchFlags::TexCopy>{}, [&] {
+            return std::make_pair(surface->CanTexCopy(params), surface->GetInterval());
+        });
+    });
     return match_surface;
 }
 
@@ -823,12 +903,69 @@ void main() {
     ASSERT(d24s8_abgr_tbo_size_u_id != -1);
     d24s8_abgr_viewport_u_id = glGetUniformLocation(d24s8_abgr_shader.handle, "viewport");
     ASSERT(d24s8_abgr_viewport_u_id != -1);
+
+    if (GLAD_GL_ARB_compute_shader) {
+        // Each invocation moves one word of a row. Rows are made of 16 byte runs that are stored
+        // contiguously within the 64 byte wide, 8 row high GOBs, which are stacked block_height
+        // high into blocks.
+        const char* cs_source = R"(
+#version 430 core
+layout(local_size_x = 64) in;
+
+layout(std430, binding = 0) readonly buffer SwizzledData {
+    uint swizzled_data[];
+};
+layout(std430, binding = 1) writeonly buffer LinearData {
+    uint linear_data[];
+};
+
+uniform uint width_bytes;
+uniform uint height;
+uniform uint block_height;
+
+void main() {
+    uint x = gl_GlobalInvocationID.x * 4;
+    uint y = gl_GlobalInvocationID.y;
+    if (x >= width_bytes || y >= height) {
+        return;
+    }
+
+    uint block_size = 512 * block_height;
+    uint block_rows = 8 * block_height;
+    uint width_in_gobs = (width_bytes + 63) / 64;
+    uint offset = (y / block_rows) * width_in_gobs * block_size + (x / 64) * block_size +
+                  ((y % block_rows) / 8) * 512 + ((x % 64) / 32) * 256 + ((y % 8) / 2) * 64 +
+                  ((x % 32) / 16) * 32 + (y % 2) * 16 + (x % 16);
+    linear_data[(y * width_bytes + x) / 4] = swizzled_data[offset / 4];
+}
+)";
+        OGLShader compute_shader;
+        compute_shader.Create(cs_source, GL_COMPUTE_SHADER);
+        deswizzle_shader.Create(false, compute_shader.handle);
+
+        deswizzle_width_bytes_u_id = glGetUniformLocation(deswizzle_shader.handle, "width_bytes");
+        deswizzle_height_u_id = glGetUniformLocation(deswizzle_shader.handle, "height");
+        deswizzle_block_height_u_id =
+            glGetUniformLocation(deswizzle_shader.handle, "block_height");
+
+        deswizzle_input_buffer.Create();
+        deswizzle_output_buffer.Create();
+    }
 }
 
 RasterizerCacheOpenGL::~RasterizerCacheOpenGL() {
     FlushAll();
-    while (!surface_cache.empty())
-        UnregisterSurface(*surface_cache.begin()->second.begin());
+    while (!surface_cache.Empty())
+        UnregisterSurface(surface_cache.Front());
+
+    // Every request gets its callback, so that the viewer doesn't wait for captures forever
+    for (PendingSurfaceCapture& capture : pending_captures) {
+        capture.callback({});
+    }
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    for (SurfaceCaptureRequest& request : capture_requests) {
+        request.callback({});
+    }
 }
 
 bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
@@ -838,6 +975,13 @@ bool RasterizerCacheOpenGL::BlitSurfaces(const Surface& src_surface,
     if (!SurfaceParams::CheckFormatsBlittable(src_surface->pixel_format, dst_surface->pixel_format))
         return false;
 
+    FinishSurfaceDecode(src_surface);
+    FinishSurfaceDecode(dst_surface);
+    dst_surface->readback_fence.Release();
+
+    if (CopyTextures(*src_surface, src_rect, *dst_surface, dst_rect)) {
+        return true;
+    }
     return BlitTextures(src_surface->texture.handle, src_rect, dst_surface->texture.handle,
                         dst_rect, src_surface->type, read_framebuffer.handle,
                         draw_framebuffer.handle);
@@ -937,6 +1081,7 @@ Surface RasterizerCacheOpenGL::GetSurface(const SurfaceParams& params, ScaleMatc
         ValidateSurface(surface, params.addr, params.size);
     }
 
+    surface->last_used_frame = current_frame;
     return surface;
 }
 
@@ -1016,12 +1161,23 @@ SurfaceRect_Tuple RasterizerCacheOpenGL::GetSurfaceSubRect(const SurfaceParams&
         ValidateSurface(surface, aligned_params.addr, aligned_params.size);
     }
 
+    surface->last_used_frame = current_frame;
     return std::make_tuple(surface, surface->GetScaledSubRect(params));
 }
 
 Surface RasterizerCacheOpenGL::GetTextureSurface(const Tegra::Texture::FullTextureInfo& config) {
     auto& gpu = Core::System::GetInstance().GPU();
 
+    UploadDecodedSurfaces();
+
+    // TODO: Surfaces hold a single 2D level, so only the base level of a mip chain and the first
+    // layer of an array are cached and sampled. Caching the whole chain as one surface needs
+    // the surface intervals to span every level, and the shaders to declare array samplers.
+    if (config.tic.MipLevels() > 1 || config.tic.Depth() > 1) {
+        NGLOG_TRACE(Render_OpenGL, "Sampling level 0 of {} and layer 0 of {} at address {:016X}",
+                    config.tic.MipLevels(), config.tic.Depth(), config.tic.Address());
+    }
+
     SurfaceParams params;
     params.addr = gpu.memory_manager->PhysicalToVirtualAddress(config.tic.Address());
     params.width = config.tic.Width();
@@ -1062,11 +1218,17 @@ Surface RasterizerCacheOpenGL::GetTextureSurface(const Tegra::Texture::FullTextu
         return tmp_surface;
     }
 
-    return GetSurface(params, ScaleMatch::Ignore, true);
+    // Sampled textures can be shown with their previous contents while they are decoded.
+    Surface surface = GetSurface(params, ScaleMatch::Ignore, false);
+    if (surface != nullptr) {
+        ValidateSurface(surface, params.addr, params.size, true);
+    }
+    return surface;
 }
 
 SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
-    bool using_color_fb, bool using_depth_fb, const MathUtil::Rectangle<s32>& viewport) {
+    bool using_color_fb, bool using_depth_fb, const MathUtil::Rectangle<s32>& viewport,
+    bool overwrite_color_fb) {
     const auto& regs = Core::System().GetInstance().GPU().Maxwell3D().regs;
     const auto& memory_manager = Core::System().GetInstance().GPU().memory_manager;
     const auto& config = regs.rt[0];
@@ -1074,15 +1236,16 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
     // TODO(bunnei): This is hard corded to use just the first render buffer
     LOG_WARNING(Render_OpenGL, "hard-coded for render target 0!");
 
-    // update resolution_scale_factor and reset cache if changed
-    // TODO (bunnei): This code was ported as-is from Citra, and is technically not thread-safe. We
-    // need to fix this before making the renderer multi-threaded.
-    static u16 resolution_scale_factor = GetResolutionScaleFactor();
-    if (resolution_scale_factor != GetResolutionScaleFactor()) {
-        resolution_scale_factor = GetResolutionScaleFactor();
-        FlushAll();
-        while (!surface_cache.empty())
-            UnregisterSurface(*surface_cache.begin()->second.begin());
+    // Surfaces are recreated at the new scale when it changes
+    const u16 target_scale = dynamic_resolution_scale != 0 ? dynamic_resolution_scale
+                                                           : GetResolutionScaleFactor();
+    if (resolution_scale_factor != target_scale) {
+        if (resolution_scale_factor != 0) {
+            FlushAll();
+            while (!surface_cache.Empty())
+                UnregisterSurface(surface_cache.Front());
+        }
+        resolution_scale_factor = target_scale;
     }
 
     MathUtil::Rectangle<u32> viewport_clamped{
@@ -1150,7 +1313,17 @@ SurfaceSurfaceRect_Tuple RasterizerCacheOpenGL::GetFramebufferSurfaces(
         fb_rect = depth_rect;
     }
 
-    if (color_surface != nullptr) {
+    if (color_surface != nullptr && overwrite_color_fb) {
+        // Nothing in the viewport is read before it is overwritten. A decode of the whole surface
+        // is still needed for the rest of it, unless the viewport covers it all.
+        color_surface->last_used_frame = current_frame;
+        if (color_vp_interval == color_surface->GetInterval()) {
+            color_surface->pending_decode = nullptr;
+        } else {
+            FinishSurfaceDecode(color_surface);
+        }
+        color_surface->invalid_regions.erase(color_vp_interval);
+    } else if (color_surface != nullptr) {
         ValidateSurface(color_surface, boost::icl::first(color_vp_interval),
                         boost::icl::length(color_vp_interval));
     }
@@ -1202,6 +1375,7 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
 
     BlitSurfaces(src_surface, src_surface->GetScaledRect(), dest_surface,
                  dest_surface->GetScaledSubRect(*src_surface));
+    dest_surface->content_hash = boost::none;
 
     dest_surface->invalid_regions -= src_surface->GetInterval();
     dest_surface->invalid_regions += src_surface->invalid_regions;
@@ -1217,7 +1391,29 @@ void RasterizerCacheOpenGL::DuplicateSurface(const Surface& src_surface,
     }
 }
 
-void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, VAddr addr, u64 size) {
+/// Hashes the guest memory a load of the whole surface reads, if it is mapped.
+static boost::optional<u64> HashSurfaceMemory(const CachedSurface& surface) {
+    const u8* const data = Memory::GetPointer(surface.addr);
+    if (data == nullptr) {
+        return boost::none;
+    }
+
+    u64 size = surface.size;
+    if (surface.is_tiled) {
+        size = Tegra::Texture::GetTextureSwizzledSize(
+            SurfaceParams::TextureFormatFromPixelFormat(surface.pixel_format), surface.stride,
+            surface.height, surface.block_height);
+    }
+    return Common::ContentHash64(data, size);
+}
+
+void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, VAddr addr, u64 size,
+                                            bool allow_deferred_load) {
+    surface->last_used_frame = current_frame;
+    if (!allow_deferred_load) {
+        FinishSurfaceDecode(surface);
+    }
+
     if (size == 0)
         return;
 
@@ -1247,15 +1443,334 @@ void RasterizerCacheOpenGL::ValidateSurface(const Surface& surface, VAddr addr,
             continue;
         }
 
-        // Load data from Switch memory
+        // Load data from Switch memory. ASTC blocks are only decoded a whole surface at a time.
+        if (SurfaceParams::IsFormatASTC(surface->pixel_format)) {
+            params = surface->FromInterval(surface->GetInterval());
+        }
         FlushRegion(params.addr, params.size);
-        surface->LoadGLBuffer(params.addr, params.end);
-        surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                 draw_framebuffer.handle);
+
+        boost::optional<u64> content_hash;
+        if (Settings::values.use_texture_content_hashing &&
+            params.GetInterval() == surface->GetInterval()) {
+            content_hash = HashSurfaceMemory(*surface);
+            if (content_hash && content_hash == surface->content_hash) {
+                // The guest rewrote the data the texture already holds
+                surface->invalid_regions.erase(params.GetInterval());
+                continue;
+            }
+        }
+
+        bool deferred = false;
+        if (SurfaceParams::IsFormatASTC(surface->pixel_format)) {
+            DecodeASTCSurface(surface);
+        } else if (!DeswizzleSurfaceOnGPU(surface, params)) {
+            deferred = allow_deferred_load && QueueSurfaceDecode(surface, params);
+            if (!deferred) {
+                surface->LoadGLBuffer(params.addr, params.end);
+                surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
+                                         draw_framebuffer.handle);
+                surface->ReleaseGLBuffer();
+            }
+        }
+        // A deferred decode is dropped if the surface is invalidated before it is uploaded, which
+        // would leave the texture out of date with the hash.
+        surface->content_hash = deferred ? boost::none : content_hash;
         surface->invalid_regions.erase(params.GetInterval());
     }
 }
 
+bool RasterizerCacheOpenGL::QueueSurfaceDecode(const Surface& surface,
+                                               const SurfaceParams& params) {
+    // Only unswizzling whole surfaces takes long enough to be worth moving off this thread.
+    if (!Settings::values.use_asynchronous_texture_decoding || !surface->is_tiled ||
+        params.GetInterval() != surface->GetInterval()) {
+        return false;
+    }
+
+    auto job = std::make_shared<SurfaceDecoder::Job>();
+    job->format = SurfaceParams::TextureFormatFromPixelFormat(surface->pixel_format);
+    job->width = surface->stride;
+    job->height = surface->height;
+    job->block_height = surface->block_height;
+    job->swizzled_data.resize(Tegra::Texture::GetTextureSwizzledSize(
+        job->format, job->width, job->height, job->block_height));
+    Memory::ReadBlock(surface->addr, job->swizzled_data.data(), job->swizzled_data.size());
+
+    surface->pending_decode = job;
+    decoding_surfaces.push_back(surface);
+    surface_decoder.Queue(std::move(job));
+    return true;
+}
+
+/// Applies the state from before a compute dispatch that used SSBO binding points 0 and 1.
+static void RestoreComputeState(const OpenGLState& prev_state) {
+    prev_state.Apply();
+    // The const buffer SSBO bindings aren't tracked per binding point by the state, so the ones
+    // the dispatch replaced are bound again.
+    for (const auto& stage : prev_state.draw.const_buffers) {
+        for (const auto& buffer : stage) {
+            if (buffer.enabled && buffer.bindpoint <= 1) {
+                glBindBufferBase(GL_SHADER_STORAGE_BUFFER, buffer.bindpoint, buffer.ssbo);
+            }
+        }
+    }
+}
+
+bool RasterizerCacheOpenGL::DeswizzleSurfaceOnGPU(const Surface& surface,
+                                                  const SurfaceParams& params) {
+    if (!Settings::values.use_gpu_texture_deswizzling || deswizzle_shader.handle == 0 ||
+        !surface->is_tiled || params.GetInterval() != surface->GetInterval()) {
+        return false;
+    }
+
+    // Compressed formats are swizzled a 4x4 tile at a time, and stay compressed in the texture.
+    const auto format = SurfaceParams::TextureFormatFromPixelFormat(surface->pixel_format);
+    const FormatTuple& tuple = GetFormatTuple(surface->pixel_format, surface->component_type);
+    const u32 width_units = tuple.compressed ? surface->stride / 4 : surface->stride;
+    const u32 width_bytes = width_units * Tegra::Texture::BytesPerPixel(format);
+    const u32 rows = tuple.compressed ? surface->height / 4 : surface->height;
+    if (width_bytes % 4 != 0) {
+        return false;
+    }
+
+    const u32 swizzled_size = Tegra::Texture::GetTextureSwizzledSize(
+        format, surface->stride, surface->height, surface->block_height);
+    const u8* const swizzled_data = Memory::GetPointer(surface->addr);
+    if (swizzled_data == nullptr) {
+        return false;
+    }
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ RestoreComputeState(prev_state); });
+
+    OpenGLState state = OpenGLState::GetCurState();
+    state.draw.shader_program = deswizzle_shader.handle;
+    state.Apply();
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, deswizzle_input_buffer.handle);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, swizzled_size, swizzled_data, GL_STREAM_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, deswizzle_output_buffer.handle);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, width_bytes * rows, nullptr, GL_STREAM_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, deswizzle_input_buffer.handle);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, deswizzle_output_buffer.handle);
+
+    glUniform1ui(deswizzle_width_bytes_u_id, width_bytes);
+    glUniform1ui(deswizzle_height_u_id, rows);
+    glUniform1ui(deswizzle_block_height_u_id, surface->block_height);
+    glDispatchCompute((width_bytes / 4 + 63) / 64, rows, 1);
+    glMemoryBarrier(GL_PIXEL_BUFFER_BARRIER_BIT);
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, deswizzle_output_buffer.handle);
+    surface->UploadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
+                             draw_framebuffer.handle, true);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+bool RasterizerCacheOpenGL::DecodeASTCSurface(const Surface& surface) {
+    if (!astc_decoder.IsSupported()) {
+        LOG_ERROR(Render_OpenGL, "ASTC textures can't be decoded without compute shaders");
+        return false;
+    }
+
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ RestoreComputeState(prev_state); });
+
+    // The blocks are unswizzled on the CPU, as they are a sixteenth of the size of the texels
+    surface->LoadGLBuffer(surface->addr, surface->end);
+    astc_decoder.Decode(surface->gl_buffer.get(), surface->stride, surface->height, 4, 4);
+    surface->ReleaseGLBuffer();
+
+    surface->UploadGLTexture(surface->GetRect(), read_framebuffer.handle, draw_framebuffer.handle,
+                             true);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    return true;
+}
+
+void RasterizerCacheOpenGL::UploadDecodedSurfaces() {
+    const auto finished = std::remove_if(
+        decoding_surfaces.begin(), decoding_surfaces.end(), [this](const Surface& surface) {
+            // Decodes are dropped when their surface is invalidated, or when it goes away.
+            if (surface->pending_decode == nullptr || !surface->registered) {
+                surface->pending_decode = nullptr;
+                return true;
+            }
+            if (!surface->pending_decode->done.load(std::memory_order_acquire)) {
+                return false;
+            }
+            UploadDecodedSurface(surface);
+            return true;
+        });
+    decoding_surfaces.erase(finished, decoding_surfaces.end());
+}
+
+void RasterizerCacheOpenGL::FinishSurfaceDecode(const Surface& surface) {
+    if (surface->pending_decode == nullptr) {
+        return;
+    }
+    surface_decoder.Wait(*surface->pending_decode);
+    UploadDecodedSurface(surface);
+}
+
+void RasterizerCacheOpenGL::UploadDecodedSurface(const Surface& surface) {
+    const std::shared_ptr<SurfaceDecoder::Job> job = std::move(surface->pending_decode);
+    surface->pending_decode = nullptr;
+
+    if (surface->gl_buffer == nullptr) {
+        surface->gl_buffer_size = surface->width * surface->height *
+                                  CachedSurface::GetGLBytesPerPixel(surface->pixel_format);
+        surface->gl_buffer.reset(new u8[surface->gl_buffer_size]);
+    }
+    std::memcpy(surface->gl_buffer.get(), job->decoded_data.data(),
+                std::min(surface->gl_buffer_size, job->decoded_data.size()));
+    surface->UploadGLTexture(surface->GetRect(), read_framebuffer.handle,
+                             draw_framebuffer.handle);
+    surface->ReleaseGLBuffer();
+}
+
+void RasterizerCacheOpenGL::QueueSurfaceReadbacks() {
+    // Collected first, since dirty_regions holds a surface once for each region it owns
+    SurfaceSet readback_surfaces;
+    for (const auto& pair : dirty_regions) {
+        const Surface& surface = pair.second;
+        if (surface->type != SurfaceType::Fill && surface->readback_fence.handle == 0 &&
+            surface->last_flushed_frame != 0 && surface->last_flushed_frame + 1 >= current_frame) {
+            readback_surfaces.insert(surface);
+        }
+    }
+
+    for (const Surface& surface : readback_surfaces) {
+        FinishSurfaceDecode(surface);
+        if (surface->readback_buffer.handle == 0) {
+            surface->readback_buffer.Create();
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, surface->readback_buffer.handle);
+            glBufferData(GL_PIXEL_PACK_BUFFER,
+                         surface->width * surface->height *
+                             CachedSurface::GetGLBytesPerPixel(surface->pixel_format),
+                         nullptr, GL_STREAM_READ);
+        } else {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, surface->readback_buffer.handle);
+        }
+        surface->DownloadGLTexture(surface->GetRect(), read_framebuffer.handle,
+                                   draw_framebuffer.handle, true);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        surface->readback_fence.Create();
+    }
+}
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceReadback, "OpenGL", "Surface Readback Copy",
+                    MP_RGB(128, 192, 128));
+bool RasterizerCacheOpenGL::CopySurfaceReadback(const Surface& surface) {
+    if (surface->readback_fence.handle == 0) {
+        return false;
+    }
+    MICROPROFILE_SCOPE(OpenGL_SurfaceReadback);
+
+    // Usually long complete by the time the surface is flushed
+    const GLenum result = glClientWaitSync(surface->readback_fence.handle,
+                                           GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+    surface->readback_fence.Release();
+    if (result == GL_WAIT_FAILED) {
+        return false;
+    }
+
+    const size_t size =
+        surface->width * surface->height * CachedSurface::GetGLBytesPerPixel(surface->pixel_format);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, surface->readback_buffer.handle);
+    const void* const data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+    if (data != nullptr) {
+        if (surface->gl_buffer == nullptr) {
+            surface->gl_buffer_size = size;
+            surface->gl_buffer.reset(new u8[size]);
+        }
+        std::memcpy(surface->gl_buffer.get(), data, size);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return data != nullptr;
+}
+
+void RasterizerCacheOpenGL::RequestSurfaceCapture(VAddr addr,
+                                                  Tegra::SurfaceCaptureCallback callback) {
+    std::lock_guard<std::mutex> lock(capture_mutex);
+    capture_requests.push_back({addr, std::move(callback)});
+}
+
+void RasterizerCacheOpenGL::ProcessSurfaceCaptures() {
+    for (auto it = pending_captures.begin(); it != pending_captures.end();) {
+        const GLenum result = glClientWaitSync(it->fence.handle, 0, 0);
+        if (result == GL_TIMEOUT_EXPIRED) {
+            ++it;
+            continue;
+        }
+
+        Tegra::SurfaceCapture capture;
+        if (result != GL_WAIT_FAILED) {
+            const size_t size = it->width * it->height * 4;
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, it->buffer.handle);
+            const void* const data =
+                glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+            if (data != nullptr) {
+                capture.width = it->width;
+                capture.height = it->height;
+                capture.rgba8.resize(size);
+                std::memcpy(capture.rgba8.data(), data, size);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+        it->callback(std::move(capture));
+        it = pending_captures.erase(it);
+    }
+
+    std::vector<SurfaceCaptureRequest> requests;
+    {
+        std::lock_guard<std::mutex> lock(capture_mutex);
+        requests.swap(capture_requests);
+    }
+    for (SurfaceCaptureRequest& request : requests) {
+        // Of the surfaces starting at the address, the one drawn to or sampled last is shown
+        Surface surface;
+        surface_cache.ForEachInInterval(
+            SurfaceInterval(request.addr, request.addr + 1), [&](const Surface& candidate) {
+                if (candidate->addr == request.addr &&
+                    candidate->type == SurfaceType::ColorTexture &&
+                    (surface == nullptr || candidate->last_used_frame > surface->last_used_frame)) {
+                    surface = candidate;
+                }
+            });
+        if (surface == nullptr) {
+            request.callback({});
+            continue;
+        }
+        FinishSurfaceDecode(surface);
+
+        PendingSurfaceCapture capture;
+        capture.width = surface->GetScaledWidth();
+        capture.height = surface->GetScaledHeight();
+        capture.callback = std::move(request.callback);
+        capture.buffer.Create();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.buffer.handle);
+        glBufferData(GL_PIXEL_PACK_BUFFER, capture.width * capture.height * 4, nullptr,
+                     GL_STREAM_READ);
+
+        OpenGLState state = OpenGLState::GetCurState();
+        const OpenGLState prev_state = state;
+        state.texture_units[0].texture_2d = surface->texture.handle;
+        state.Apply();
+        glActiveTexture(GL_TEXTURE0);
+
+        // The driver converts and decompresses the texture to RGBA8 in the copy
+        glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        prev_state.Apply();
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        capture.fence.Create();
+        pending_captures.push_back(std::move(capture));
+    }
+}
+
 void RasterizerCacheOpenGL::FlushRegion(VAddr addr, u64 size, Surface flush_surface) {
     if (size == 0)
         return;
@@ -1277,15 +1792,28 @@ void RasterizerCacheOpenGL::FlushRegion(VAddr addr, u64 size, Surface flush_surf
         ASSERT(surface->IsRegionValid(interval));
 
         if (surface->type != SurfaceType::Fill) {
-            SurfaceParams params = surface->FromInterval(interval);
-            surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
-                                       draw_framebuffer.handle);
+            FinishSurfaceDecode(surface);
+            surface->last_flushed_frame = current_frame;
+            if (!CopySurfaceReadback(surface)) {
+                if (surface->gl_buffer == nullptr && surface->is_tiled) {
+                    // Tiled flushes write back the whole surface, so the staging copy released
+                    // after upload is restored from the guest memory first
+                    surface->LoadGLBuffer(surface->addr, surface->end);
+                }
+                SurfaceParams params = surface->FromInterval(interval);
+                surface->DownloadGLTexture(surface->GetSubRect(params), read_framebuffer.handle,
+                                           draw_framebuffer.handle);
+            }
         }
         surface->FlushGLBuffer(boost::icl::first(interval), boost::icl::last_next(interval));
         flushed_intervals += interval;
     }
     // Reset dirty regions
     dirty_regions -= flushed_intervals;
+    for (const auto& interval : flushed_intervals) {
+        Memory::RasterizerMarkRegionModified(boost::icl::first(interval),
+                                             boost::icl::length(interval), false);
+    }
 }
 
 void RasterizerCacheOpenGL::FlushAll() {
@@ -1303,36 +1831,42 @@ void RasterizerCacheOpenGL::InvalidateRegion(VAddr addr, u64 size, const Surface
         // Surfaces can't have a gap
         ASSERT(region_owner->width == region_owner->stride);
         region_owner->invalid_regions.erase(invalid_interval);
+        region_owner->content_hash = boost::none;
+        // The GPU wrote to the surface, a decode finishing later must not overwrite that.
+        region_owner->pending_decode = nullptr;
+        region_owner->readback_fence.Release();
     }
 
-    for (auto& pair : RangeFromInterval(surface_cache, invalid_interval)) {
-        for (auto& cached_surface : pair.second) {
-            if (cached_surface == region_owner)
-                continue;
+    surface_cache.ForEachInInterval(invalid_interval, [&](const Surface& cached_surface) {
+        if (cached_surface == region_owner)
+            return;
 
-            // If cpu is invalidating this region we want to remove it
-            // to (likely) mark the memory pages as uncached
-            if (region_owner == nullptr && size <= 8) {
-                FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
-                remove_surfaces.emplace(cached_surface);
-                continue;
-            }
+        // If cpu is invalidating this region we want to remove it
+        // to (likely) mark the memory pages as uncached
+        if (region_owner == nullptr && size <= 8) {
+            FlushRegion(cached_surface->addr, cached_surface->size, cached_surface);
+            remove_surfaces.emplace(cached_surface);
+            return;
+        }
 
-            const auto interval = cached_surface->GetInterval() & invalid_interval;
-            cached_surface->invalid_regions.insert(interval);
+        const auto interval = cached_surface->GetInterval() & invalid_interval;
+        cached_surface->invalid_regions.insert(interval);
+        // The surface is loaded again when next used, which replaces any pending decode.
+        cached_surface->pending_decode = nullptr;
+        cached_surface->readback_fence.Release();
 
-            // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
-            if (cached_surface->type == SurfaceType::Fill &&
-                cached_surface->IsSurfaceFullyInvalid()) {
-                remove_surfaces.emplace(cached_surface);
-            }
+        // Remove only "empty" fill surfaces to avoid destroying and recreating OGL textures
+        if (cached_surface->type == SurfaceType::Fill &&
+            cached_surface->IsSurfaceFullyInvalid()) {
+            remove_surfaces.emplace(cached_surface);
         }
-    }
+    });
 
     if (region_owner != nullptr)
         dirty_regions.set({invalid_interval, region_owner});
     else
         dirty_regions.erase(invalid_interval);
+    Memory::RasterizerMarkRegionModified(addr, size, region_owner != nullptr);
 
     for (auto& remove_surface : remove_surfaces) {
         if (remove_surface == region_owner) {
@@ -1367,12 +1901,34 @@ Surface RasterizerCacheOpenGL::CreateSurface(const SurfaceParams& params) {
     return surface;
 }
 
+void SurfaceIndex::Add(const Surface& surface) {
+    const u64 first_bucket = surface->addr >> BUCKET_BITS;
+    const u64 last_bucket = (surface->end - 1) >> BUCKET_BITS;
+    for (u64 bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+        buckets[bucket].push_back(surface);
+    }
+}
+
+void SurfaceIndex::Remove(const Surface& surface) {
+    const u64 first_bucket = surface->addr >> BUCKET_BITS;
+    const u64 last_bucket = (surface->end - 1) >> BUCKET_BITS;
+    for (u64 bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+        const auto it = buckets.find(bucket);
+        ASSERT(it != buckets.end());
+        auto& surfaces = it->second;
+        surfaces.erase(std::find(surfaces.begin(), surfaces.end(), surface));
+        if (surfaces.empty()) {
+            buckets.erase(it);
+        }
+    }
+}
+
 void RasterizerCacheOpenGL::RegisterSurface(const Surface& surface) {
     if (surface->registered) {
         return;
     }
     surface->registered = true;
-    surface_cache.add({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Add(surface);
     UpdatePagesCachedCount(surface->addr, surface->size, 1);
 }
 
@@ -1382,7 +1938,116 @@ void RasterizerCacheOpenGL::UnregisterSurface(const Surface& surface) {
     }
     surface->registered = false;
     UpdatePagesCachedCount(surface->addr, surface->size, -1);
-    surface_cache.subtract({surface->GetInterval(), SurfaceSet{surface}});
+    surface_cache.Remove(surface);
+
+    // The texture may be deleted from now on, and its name reused by another one
+    const GLuint texture = surface->texture.handle;
+    for (auto it = framebuffer_cache.begin(); it != framebuffer_cache.end();) {
+        if (std::get<0>(it->first) == texture || std::get<1>(it->first) == texture) {
+            it = framebuffer_cache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+GLuint RasterizerCacheOpenGL::GetFramebuffer(const Surface& color_surface,
+                                             const Surface& depth_surface, bool has_stencil) {
+    const GLuint color_texture = color_surface != nullptr ? color_surface->texture.handle : 0;
+    const GLuint depth_texture = depth_surface != nullptr ? depth_surface->texture.handle : 0;
+    const FramebufferCacheKey key{color_texture, depth_texture, depth_texture != 0 && has_stencil};
+
+    auto [it, is_new] = framebuffer_cache.emplace(key, OGLFramebuffer{});
+    OGLFramebuffer& framebuffer = it->second;
+    if (!is_new) {
+        return framebuffer.handle;
+    }
+
+    framebuffer.Create();
+    OpenGLState prev_state = OpenGLState::GetCurState();
+    SCOPE_EXIT({ prev_state.Apply(); });
+    OpenGLState state = prev_state;
+    state.draw.draw_framebuffer = framebuffer.handle;
+    state.Apply();
+
+    glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, color_texture,
+                           0);
+    if (depth_texture != 0) {
+        glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER,
+                               has_stencil ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT,
+                               GL_TEXTURE_2D, depth_texture, 0);
+    }
+    return framebuffer.handle;
+}
+
+/// Returns the bytes of memory used by the texture and the staging buffer of a surface
+static u64 GetSurfaceMemoryUsage(const CachedSurface& surface) {
+    u64 texture_size = 0;
+    if (surface.type != SurfaceType::Fill) {
+        const u64 pixels = static_cast<u64>(surface.GetScaledWidth()) * surface.GetScaledHeight();
+        texture_size = pixels * CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+        if (surface.type == SurfaceType::ColorTexture) {
+            texture_size /=
+                GetFormatTuple(surface.pixel_format, surface.component_type).compression_factor;
+        }
+    }
+    const u64 unscaled_size = static_cast<u64>(surface.width) * surface.height *
+                              CachedSurface::GetGLBytesPerPixel(surface.pixel_format);
+    const u64 readback_size = surface.readback_buffer.handle != 0 ? unscaled_size : 0;
+    const u64 unscaled_texture_size = surface.unscaled_texture.handle != 0 ? unscaled_size : 0;
+    return texture_size + surface.gl_buffer_size + readback_size + unscaled_texture_size;
+}
+
+void RasterizerCacheOpenGL::TickFrame() {
+    QueueSurfaceReadbacks();
+    ProcessSurfaceCaptures();
+
+    memory_usage = 0;
+    u64 staging_buffer_size = 0;
+    surface_cache.ForEach([this, &staging_buffer_size](const Surface& surface) {
+        memory_usage += GetSurfaceMemoryUsage(*surface);
+        staging_buffer_size += surface->gl_buffer_size;
+    });
+    MICROPROFILE_META_CPU("Texture cache KiB", static_cast<int>(memory_usage / 1024));
+    texture_usage.Set(memory_usage - staging_buffer_size);
+    staging_buffer_usage.Set(staging_buffer_size);
+
+    const u64 budget = static_cast<u64>(Settings::values.texture_cache_budget) * 1024 * 1024;
+    if (budget != 0 && memory_usage > budget) {
+        // Only surfaces that can be loaded back from Switch memory as they are are evicted, and
+        // never the ones used this frame.
+        surface_cache.ForEach([this](const Surface& surface) {
+            if (surface->last_used_frame == current_frame || surface->pending_decode != nullptr) {
+                return;
+            }
+            for (const auto& pair : RangeFromInterval(dirty_regions, surface->GetInterval())) {
+                if (pair.second == surface) {
+                    return;
+                }
+            }
+            eviction_candidates.push_back(surface);
+        });
+        std::sort(eviction_candidates.begin(), eviction_candidates.end(),
+                  [](const Surface& lhs, const Surface& rhs) {
+                      return lhs->last_used_frame < rhs->last_used_frame;
+                  });
+
+        for (const Surface& surface : eviction_candidates) {
+            if (memory_usage <= budget) {
+                break;
+            }
+            memory_usage -= GetSurfaceMemoryUsage(*surface);
+            UnregisterSurface(surface);
+        }
+        eviction_candidates.clear();
+
+        if (memory_usage > budget) {
+            LOG_DEBUG(Render_OpenGL, "Texture cache uses %" PRIu64 " KiB, over its budget",
+                      memory_usage / 1024);
+        }
+    }
+
+    ++current_frame;
 }
 
 void RasterizerCacheOpenGL::UpdatePagesCachedCount(VAddr addr, u64 size, int delta) {
@@ -5,9 +5,13 @@
 #pragma once
 
 #include <array>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <tuple>
+#include <unordered_map>
+#include <vector>
 #ifdef __GNUC__
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-local-typedefs"
@@ -17,13 +21,16 @@
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
+#include <boost/optional.hpp>
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/math_util.h"
 #include "video_core/gpu.h"
+#include "video_core/renderer_opengl/gl_astc_decoder.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_surface_decoder.h"
 #include "video_core/textures/texture.h"
 
 struct CachedSurface;
@@ -32,11 +39,9 @@ using SurfaceSet = std::set<Surface>;
 
 using SurfaceRegions = boost::icl::interval_set<VAddr>;
 using SurfaceMap = boost::icl::interval_map<VAddr, Surface>;
-using SurfaceCache = boost::icl::interval_map<VAddr, SurfaceSet>;
 
-using SurfaceInterval = SurfaceCache::interval_type;
-static_assert(std::is_same<SurfaceRegions::interval_type, SurfaceCache::interval_type>() &&
-                  std::is_same<SurfaceMap::interval_type, SurfaceCache::interval_type>(),
+using SurfaceInterval = SurfaceRegions::interval_type;
+static_assert(std::is_same<SurfaceMap::interval_type, SurfaceRegions::interval_type>(),
               "incorrect interval types");
 
 using SurfaceRect_Tuple = std::tuple<Surface, MathUtil::Rectangle<u32>>;
@@ -57,6 +62,7 @@ struct SurfaceParams {
         DXT1 = 2,
         DXT23 = 3,
         DXT45 = 4,
+        ASTC_2D_4X4 = 5,
 
         Max,
         Invalid = 255,
@@ -91,6 +97,7 @@ struct SurfaceParams {
             64,  // DXT1
             128, // DXT23
             128, // DXT45
+            128, // ASTC_2D_4X4
         };
 
         ASSERT(static_cast<size_t>(format) < bpp_table.size());
@@ -133,6 +140,8 @@ struct SurfaceParams {
             return PixelFormat::DXT23;
         case Tegra::Texture::TextureFormat::DXT45:
             return PixelFormat::DXT45;
+        case Tegra::Texture::TextureFormat::ASTC_2D_4X4:
+            return PixelFormat::ASTC_2D_4X4;
         default:
             NGLOG_CRITICAL(HW_GPU, "Unimplemented format={}", static_cast<u32>(format));
             UNREACHABLE();
@@ -152,6 +161,8 @@ struct SurfaceParams {
             return Tegra::Texture::TextureFormat::DXT23;
         case PixelFormat::DXT45:
             return Tegra::Texture::TextureFormat::DXT45;
+        case PixelFormat::ASTC_2D_4X4:
+            return Tegra::Texture::TextureFormat::ASTC_2D_4X4;
         default:
             UNREACHABLE();
         }
@@ -191,6 +202,11 @@ struct SurfaceParams {
         }
     }
 
+    /// Returns whether the format is an ASTC one, which the cache decodes to RGBA8 on load.
+    static bool IsFormatASTC(PixelFormat format) {
+        return format == PixelFormat::ASTC_2D_4X4;
+    }
+
     static bool CheckFormatsBlittable(PixelFormat pixel_format_a, PixelFormat pixel_format_b) {
         SurfaceType a_type = GetFormatType(pixel_format_a);
         SurfaceType b_type = GetFormatType(pixel_format_b);
@@ -305,6 +321,9 @@ struct CachedSurface : SurfaceParams {
         return (invalid_regions & GetInterval()) == SurfaceRegions(GetInterval());
     }
 
+    /// Returns the internal format of the texture, or 0 if it can't be rendered to.
+    GLint GetRenderTargetFormat() const;
+
     bool registered = false;
     SurfaceRegions invalid_regions;
 
@@ -312,6 +331,9 @@ struct CachedSurface : SurfaceParams {
     std::array<u8, 4> fill_data;
 
     OGLTexture texture;
+    /// Unscaled copy of the texture of a surface with a res_scale other than 1, which loads and
+    /// flushes go through. Created by the first of them, and kept for the ones after.
+    OGLTexture unscaled_texture;
 
     static constexpr unsigned int GetGLBytesPerPixel(PixelFormat format) {
         if (format == PixelFormat::Invalid)
@@ -323,15 +345,131 @@ struct CachedSurface : SurfaceParams {
     std::unique_ptr<u8[]> gl_buffer;
     size_t gl_buffer_size = 0;
 
+    /// Set once the surface has been flushed. Surfaces flushed once tend to be flushed again, so
+    /// only those keep gl_buffer between uses instead of releasing it once uploaded.
+    bool keep_gl_buffer = false;
+
+    /// Frees gl_buffer, unless the surface keeps it
+    void ReleaseGLBuffer() {
+        if (!keep_gl_buffer) {
+            gl_buffer.reset();
+            gl_buffer_size = 0;
+        }
+    }
+
+    /// Hash of the guest memory the whole texture was last loaded from, if nothing wrote to the
+    /// texture since. A reload of the same data is skipped when content hashing is enabled.
+    boost::optional<u64> content_hash;
+
+    /// Decode of the contents of the surface still running on a worker thread, if any. The
+    /// texture keeps its previous contents until the result is uploaded.
+    std::shared_ptr<SurfaceDecoder::Job> pending_decode;
+
+    /// Last SurfaceIndex lookup that visited the surface, so that each lookup visits it once
+    u64 index_visit = 0;
+
+    /// Frame the surface was last looked up in, to evict the least recently used ones first
+    u64 last_used_frame = 0;
+
+    /// Frame the surface was last flushed in. Surfaces flushed in a frame tend to be flushed in
+    /// the next one too, so their texture is read back ahead of time at the end of the frame.
+    u64 last_flushed_frame = 0;
+
+    /// Pixel buffer the texture is read back into ahead of a flush, and the fence signaled once
+    /// the read back completes. The fence is released whenever the texture is written.
+    OGLBuffer readback_buffer;
+    OGLSync readback_fence;
+
     // Read/Write data in Switch memory to/from gl_buffer
     void LoadGLBuffer(VAddr load_start, VAddr load_end);
     void FlushGLBuffer(VAddr flush_start, VAddr flush_end);
 
-    // Upload/Download data in gl_buffer in/to this surface's texture
+    // Upload/Download data in gl_buffer in/to this surface's texture. With from_unpack_buffer
+    // set, the data is uploaded from the bound pixel unpack buffer instead of gl_buffer, and
+    // likewise downloaded to the bound pixel pack buffer with to_pack_buffer set.
     void UploadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                         GLuint draw_fb_handle);
+                         GLuint draw_fb_handle, bool from_unpack_buffer = false);
     void DownloadGLTexture(const MathUtil::Rectangle<u32>& rect, GLuint read_fb_handle,
-                           GLuint draw_fb_handle);
+                           GLuint draw_fb_handle, bool to_pack_buffer = false);
+};
+
+/**
+ * Index of the registered surfaces by the regions of memory they cover. Memory is split in
+ * buckets, and each surface is listed in every bucket it overlaps, so that a lookup is a few hash
+ * table probes and doesn't allocate.
+ */
+class SurfaceIndex {
+public:
+    void Add(const Surface& surface);
+    void Remove(const Surface& surface);
+
+    bool Empty() const {
+        return buckets.empty();
+    }
+
+    /// Calls func once for each surface in the index. func must not change the index.
+    template <typename Func>
+    void ForEach(Func&& func) {
+        const u64 visit = ++visit_count;
+        for (const auto& bucket : buckets) {
+            for (const Surface& surface : bucket.second) {
+                if (surface->index_visit != visit) {
+                    surface->index_visit = visit;
+                    func(surface);
+                }
+            }
+        }
+    }
+
+    /// Returns any of the surfaces in the index, which must not be empty.
+    const Surface& Front() const {
+        return buckets.begin()->second.front();
+    }
+
+    /// Calls func once for each surface overlapping interval. func must neither change the index
+    /// nor look surfaces up in it.
+    template <typename Func>
+    void ForEachInInterval(const SurfaceInterval& interval, Func&& func) {
+        const VAddr start = boost::icl::first(interval);
+        const VAddr end = boost::icl::last_next(interval);
+        if (start >= end) {
+            return;
+        }
+
+        const u64 visit = ++visit_count;
+        const auto visit_bucket = [&](const std::vector<Surface>& surfaces) {
+            for (const Surface& surface : surfaces) {
+                if (surface->index_visit == visit || surface->addr >= end ||
+                    surface->end <= start) {
+                    continue;
+                }
+                surface->index_visit = visit;
+                func(surface);
+            }
+        };
+
+        const u64 first_bucket = start >> BUCKET_BITS;
+        const u64 last_bucket = (end - 1) >> BUCKET_BITS;
+        if (last_bucket - first_bucket >= buckets.size()) {
+            // Huge regions span more buckets than there are in use
+            for (const auto& bucket : buckets) {
+                visit_bucket(bucket.second);
+            }
+            return;
+        }
+        for (u64 bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+            const auto it = buckets.find(bucket);
+            if (it != buckets.end()) {
+                visit_bucket(it->second);
+            }
+        }
+    }
+
+private:
+    static constexpr u64 BUCKET_BITS = 16;
+
+    std::unordered_map<u64, std::vector<Surface>> buckets;
+    u64 visit_count = 0;
 };
 
 class RasterizerCacheOpenGL : NonCopyable {
@@ -362,9 +500,17 @@ public:
     /// Get a surface based on the texture configuration
     Surface GetTextureSurface(const Tegra::Texture::FullTextureInfo& config);
 
-    /// Get the color and depth surfaces based on the framebuffer configuration
+    /// Get the color and depth surfaces based on the framebuffer configuration. With
+    /// overwrite_color_fb set, the caller is about to overwrite the viewport of the color surface
+    /// entirely, so it is made valid without loading its contents from Switch memory.
     SurfaceSurfaceRect_Tuple GetFramebufferSurfaces(bool using_color_fb, bool using_depth_fb,
-                                                    const MathUtil::Rectangle<s32>& viewport);
+                                                    const MathUtil::Rectangle<s32>& viewport,
+                                                    bool overwrite_color_fb = false);
+
+    /// Returns a framebuffer with the surfaces attached. Each combination of surfaces gets a
+    /// framebuffer of its own, which is kept until one of them is removed from the cache.
+    GLuint GetFramebuffer(const Surface& color_surface, const Surface& depth_surface,
+                          bool has_stencil);
 
     /// Get a surface that matches the fill config
     Surface GetFillSurface(const void* config);
@@ -381,11 +527,69 @@ public:
     /// Flush all cached resources tracked by this cache manager
     void FlushAll();
 
+    /// Accounts for the memory used by the surfaces, and evicts the least recently used clean
+    /// surfaces while it's over Settings::values.texture_cache_budget. Called once per frame,
+    /// this also starts the read backs of the surfaces likely to be flushed in the next one.
+    void TickFrame();
+
+    /// Queues a copy of the color surface cached at addr into a pixel buffer, for the surface
+    /// viewer. Can be called from any thread, the copies are started by TickFrame and handed to
+    /// their callbacks in a later one once they have completed.
+    void RequestSurfaceCapture(VAddr addr, Tegra::SurfaceCaptureCallback callback);
+
+    /// Returns the scale of the resolution factor in the settings.
+    static u16 GetResolutionScaleFactor();
+
+    /// Renders framebuffers at a scale picked at run time instead of that of the settings, or at
+    /// that of the settings again with 0. Changing the scale drops every cached surface.
+    void SetDynamicResolutionScale(u16 scale) {
+        dynamic_resolution_scale = scale;
+    }
+
+    /// Increase/decrease the number of cached resources in pages touching the specified region.
+    /// Memory writes to pages with cached resources invalidate the region with the rasterizer.
+    void UpdatePagesCachedCount(VAddr addr, u64 size, int delta);
+
 private:
     void DuplicateSurface(const Surface& src_surface, const Surface& dest_surface);
 
-    /// Update surface's texture for given region when necessary
-    void ValidateSurface(const Surface& surface, VAddr addr, u64 size);
+    /// Update surface's texture for given region when necessary. When allow_deferred_load is set,
+    /// a load from Switch memory may be decoded in the background instead.
+    void ValidateSurface(const Surface& surface, VAddr addr, u64 size,
+                         bool allow_deferred_load = false);
+
+    /// Queues the load of a whole surface from Switch memory to the surface decoder, when enabled
+    /// and worth it. Returns whether it was queued.
+    bool QueueSurfaceDecode(const Surface& surface, const SurfaceParams& params);
+
+    /// Unswizzles the whole of a tiled surface with a compute shader, when enabled, and uploads
+    /// it from the result. Returns whether it was loaded.
+    bool DeswizzleSurfaceOnGPU(const Surface& surface, const SurfaceParams& params);
+
+    /// Decodes the whole of an ASTC surface with the ASTC decoder, and uploads it from the result.
+    /// Returns whether the host can decode it.
+    bool DecodeASTCSurface(const Surface& surface);
+
+    /// Uploads the surfaces whose decodes have finished
+    void UploadDecodedSurfaces();
+
+    /// Waits for the pending decode of a surface and uploads it, so that its texture can be used
+    /// for anything other than sampling.
+    void FinishSurfaceDecode(const Surface& surface);
+
+    void UploadDecodedSurface(const Surface& surface);
+
+    /// Reads the textures of the dirty surfaces flushed in the last frame back into their pixel
+    /// buffers, so that flushing them again only has to copy the data instead of stalling.
+    void QueueSurfaceReadbacks();
+
+    /// Copies the read back of a surface to its gl_buffer, waiting for it to complete. Returns
+    /// whether the surface had a read back of its current contents.
+    bool CopySurfaceReadback(const Surface& surface);
+
+    /// Hands the surface captures that have completed to their callbacks, and starts the copies
+    /// of the newly requested ones.
+    void ProcessSurfaceCaptures();
 
     /// Create a new surface
     Surface CreateSurface(const SurfaceParams& params);
@@ -396,21 +600,62 @@ private:
     /// Remove surface from the cache
     void UnregisterSurface(const Surface& surface);
 
-    /// Increase/decrease the number of surface in pages touching the specified region
-    void UpdatePagesCachedCount(VAddr addr, u64 size, int delta);
-
-    SurfaceCache surface_cache;
+    SurfaceIndex surface_cache;
     PageMap cached_pages;
     SurfaceMap dirty_regions;
     SurfaceSet remove_surfaces;
 
+    /// Scale the cached framebuffers are rendered at, 0 until the first framebuffer
+    u16 resolution_scale_factor = 0;
+    /// Scale set by the dynamic resolution, 0 to follow the settings
+    u16 dynamic_resolution_scale = 0;
+
+    u64 current_frame = 1;
+    /// Bytes of GL textures and staging buffers used by the surfaces, as of the last frame
+    u64 memory_usage = 0;
+    /// Reused for the eviction candidates, so that evicting doesn't allocate every frame
+    std::vector<Surface> eviction_candidates;
+
+    SurfaceDecoder surface_decoder;
+    /// Surfaces queued to the surface decoder, whose results haven't been uploaded yet
+    std::vector<Surface> decoding_surfaces;
+
     OGLFramebuffer read_framebuffer;
     OGLFramebuffer draw_framebuffer;
 
+    /// Color texture, depth texture and whether the depth texture has stencil
+    using FramebufferCacheKey = std::tuple<GLuint, GLuint, bool>;
+    std::map<FramebufferCacheKey, OGLFramebuffer> framebuffer_cache;
+
     OGLVertexArray attributeless_vao;
     OGLBuffer d24s8_abgr_buffer;
     GLsizeiptr d24s8_abgr_buffer_size;
     OGLProgram d24s8_abgr_shader;
     GLint d24s8_abgr_tbo_size_u_id;
     GLint d24s8_abgr_viewport_u_id;
+
+    OGLProgram deswizzle_shader;
+    OGLBuffer deswizzle_input_buffer;
+    OGLBuffer deswizzle_output_buffer;
+    GLint deswizzle_width_bytes_u_id;
+    GLint deswizzle_height_u_id;
+    GLint deswizzle_block_height_u_id;
+
+    ASTCDecoderOpenGL astc_decoder;
+
+    struct SurfaceCaptureRequest {
+        VAddr addr;
+        Tegra::SurfaceCaptureCallback callback;
+    };
+    struct PendingSurfaceCapture {
+        OGLBuffer buffer;
+        OGLSync fence;
+        u32 width;
+        u32 height;
+        Tegra::SurfaceCaptureCallback callback;
+    };
+    /// Guards capture_requests, which are pushed by the surface viewer on the GUI thread
+    std::mutex capture_mutex;
+    std::vector<SurfaceCaptureRequest> capture_requests;
+    std::vector<PendingSurfaceCapture> pending_captures;
 };
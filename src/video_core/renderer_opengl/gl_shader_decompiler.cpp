@@ -2,10 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <map>
 #include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 #include "common/assert.h"
 #include "common/common_types.h"
 #include "video_core/engines/shader_bytecode.h"
@@ -108,21 +111,134 @@ private:
     }
 };
 
-class ShaderWriter {
+/**
+ * Finds the instructions whose results are never used, so that no GLSL is generated for them.
+ * Only programs running straight through to an EXIT are analyzed, which is all the control flow
+ * the decompiler handles so far. Any instruction it doesn't know leaves the program as it is.
+ */
+class DeadCodeAnalyzer {
 public:
-    void AddLine(std::string_view text) {
-        DEBUG_ASSERT(scope >= 0);
-        if (!text.empty()) {
-            AppendIndentation();
+    DeadCodeAnalyzer(const ProgramCode& program_code, u32 main_offset,
+                     Maxwell3D::Regs::ShaderStage stage) {
+        std::vector<std::pair<u32, RegisterUsage>> instructions;
+        for (u32 offset = main_offset;; ++offset) {
+            if (offset == PROGRAM_END)
+                return;
+
+            const Instruction instr = {program_code[offset]};
+            RegisterUsage usage;
+            if (!GetRegisterUsage(instr, usage))
+                return;
+            instructions.emplace_back(offset, std::move(usage));
+            if (instr.opcode.EffectiveOpCode() == OpCode::Id::EXIT)
+                break;
+        }
+
+        // GPRs 0-3 are output color for the fragment shader, which is read once it exits
+        std::set<u64> live_registers;
+        if (stage == Maxwell3D::Regs::ShaderStage::Fragment) {
+            live_registers = {0, 1, 2, 3};
+        }
+
+        for (auto it = instructions.rbegin(); it != instructions.rend(); ++it) {
+            const auto& [offset, usage] = *it;
+            const bool is_used =
+                usage.has_side_effects ||
+                std::any_of(usage.writes.begin(), usage.writes.end(),
+                            [&](u64 reg) { return live_registers.count(reg) != 0; });
+            if (!is_used) {
+                dead_instructions.insert(offset);
+                continue;
+            }
+            for (const u64 reg : usage.writes) {
+                live_registers.erase(reg);
+            }
+            live_registers.insert(usage.reads.begin(), usage.reads.end());
+        }
+    }
+
+    std::set<u32> GetDeadInstructions() {
+        return std::move(dead_instructions);
+    }
+
+private:
+    struct RegisterUsage {
+        std::vector<u64> reads;
+        std::vector<u64> writes;
+        bool has_side_effects = false;
+    };
+
+    /// Gets the registers an instruction reads and writes, as GLSLGenerator compiles it.
+    /// Returns false for instructions that aren't handled here.
+    static bool GetRegisterUsage(const Instruction& instr, RegisterUsage& usage) {
+        switch (OpCode::GetInfo(instr.opcode).type) {
+        case OpCode::Type::Arithmetic:
+            usage.writes = {instr.gpr0.Value()};
+            usage.reads = {instr.gpr8.Value()};
+            if (instr.opcode.EffectiveOpCode() != OpCode::Id::FMUL32_IMM && !instr.is_b_imm &&
+                instr.is_b_gpr) {
+                usage.reads.push_back(instr.gpr20.Value());
+            }
+            return true;
+        case OpCode::Type::Ffma:
+            usage.writes = {instr.gpr0.Value()};
+            usage.reads = {instr.gpr8.Value(), instr.gpr39.Value()};
+            if (instr.opcode.EffectiveOpCode() == OpCode::Id::FFMA_RR) {
+                usage.reads.push_back(instr.gpr20.Value());
+            }
+            return true;
+        default:
+            break;
+        }
+
+        switch (instr.opcode.EffectiveOpCode()) {
+        case OpCode::Id::LD_A:
+        case OpCode::Id::IPA:
+            usage.writes = {instr.gpr0.Value()};
+            return true;
+        case OpCode::Id::ST_A:
+            usage.reads = {instr.gpr0.Value()};
+            usage.has_side_effects = true;
+            return true;
+        case OpCode::Id::TEXS:
+            usage.reads = {instr.gpr8.Value(), instr.gpr20.Value()};
+            for (u64 elem = 0; elem < instr.attribute.fmt20.size; ++elem) {
+                usage.writes.push_back(instr.gpr0.Value() + elem);
+            }
+            return true;
+        case OpCode::Id::EXIT:
+            usage.has_side_effects = true;
+            return true;
+        default:
+            return false;
         }
-        shader_source += text;
-        AddNewLine();
     }
 
-    void AddLine(char character) {
+    std::set<u32> dead_instructions;
+};
+
+/**
+ * Writes GLSL into a single buffer. Lines are given as a list of pieces, which are strings,
+ * characters or unsigned integers, and appended in place without building the line as a string
+ * of its own first.
+ */
+class ShaderWriter {
+public:
+    ShaderWriter() {
+        shader_source.reserve(16 * 1024);
+    }
+
+    template <typename... Pieces>
+    void AddLine(const Pieces&... pieces) {
         DEBUG_ASSERT(scope >= 0);
+        const size_t line_start = shader_source.size();
         AppendIndentation();
-        shader_source += character;
+        const size_t text_start = shader_source.size();
+        (Append(pieces), ...);
+        // Empty lines aren't indented
+        if (shader_source.size() == text_start) {
+            shader_source.resize(line_start);
+        }
         AddNewLine();
     }
 
@@ -142,15 +258,38 @@ private:
         shader_source.append(static_cast<size_t>(scope) * 4, ' ');
     }
 
+    void Append(std::string_view text) {
+        shader_source += text;
+    }
+
+    void Append(char character) {
+        shader_source += character;
+    }
+
+    void Append(u64 value) {
+        std::array<char, 20> digits;
+        auto it = digits.end();
+        do {
+            *--it = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        shader_source.append(it, digits.end());
+    }
+
+    void Append(u32 value) {
+        Append(static_cast<u64>(value));
+    }
+
     std::string shader_source;
 };
 
 class GLSLGenerator {
 public:
-    GLSLGenerator(const std::set<Subroutine>& subroutines, const ProgramCode& program_code,
-                  u32 main_offset, Maxwell3D::Regs::ShaderStage stage)
-        : subroutines(subroutines), program_code(program_code), main_offset(main_offset),
-          stage(stage) {
+    GLSLGenerator(const std::set<Subroutine>& subroutines, const std::set<u32>& dead_instructions,
+                  const ProgramCode& program_code, u32 main_offset,
+                  Maxwell3D::Regs::ShaderStage stage)
+        : subroutines(subroutines), dead_instructions(dead_instructions),
+          program_code(program_code), main_offset(main_offset), stage(stage) {
 
         Generate();
     }
@@ -161,7 +300,7 @@ public:
 
     /// Returns entries in the shader that are useful for external functions
     ShaderEntries GetEntries() const {
-        return {GetConstBuffersDeclarations()};
+        return {GetConstBuffersDeclarations(), GetSamplersDeclarations()};
     }
 
 private:
@@ -236,11 +375,12 @@ private:
     }
 
     /// Generates code representing a texture sampler.
-    std::string GetSampler(const Sampler& sampler) const {
+    std::string GetSampler(const Sampler& sampler) {
         // TODO(Subv): Support more than just texture sampler 0
         ASSERT_MSG(sampler.index == Sampler::Index::Sampler_0, "unsupported");
         const unsigned index{static_cast<unsigned>(sampler.index.Value()) -
                              static_cast<unsigned>(Sampler::Index::Sampler_0)};
+        declr_samplers.insert(index);
         return "tex[" + std::to_string(index) + "]";
     }
 
@@ -249,13 +389,14 @@ private:
      * @param subroutine the subroutine to call.
      */
     void CallSubroutine(const Subroutine& subroutine) {
+        const std::string name = subroutine.GetName();
         if (subroutine.exit_method == ExitMethod::AlwaysEnd) {
-            shader.AddLine(subroutine.GetName() + "();");
+            shader.AddLine(name, "();");
             shader.AddLine("return true;");
         } else if (subroutine.exit_method == ExitMethod::Conditional) {
-            shader.AddLine("if (" + subroutine.GetName() + "()) { return true; }");
+            shader.AddLine("if (", name, "()) { return true; }");
         } else {
-            shader.AddLine(subroutine.GetName() + "();");
+            shader.AddLine(name, "();");
         }
     }
 
@@ -266,14 +407,15 @@ private:
      */
     void SetDest(u64 elem, const std::string& reg, const std::string& value,
                  u64 dest_num_components, u64 value_num_components, bool is_abs = false) {
-        std::string swizzle = ".";
-        swizzle += "xyzw"[elem];
+        const char swizzle[] = {'.', "xyzw"[elem], '\0'};
+        const std::string_view dest_swizzle = dest_num_components != 1 ? swizzle : "";
+        const std::string_view src_swizzle = value_num_components != 1 ? swizzle : "";
 
-        std::string dest = reg + (dest_num_components != 1 ? swizzle : "");
-        std::string src = "(" + value + ")" + (value_num_components != 1 ? swizzle : "");
-        src = is_abs ? "abs(" + src + ")" : src;
-
-        shader.AddLine(dest + " = " + src + ";");
+        if (is_abs) {
+            shader.AddLine(reg, dest_swizzle, " = abs((", value, ')', src_swizzle, ");");
+        } else {
+            shader.AddLine(reg, dest_swizzle, " = (", value, ')', src_swizzle, ';');
+        }
     }
 
     /**
@@ -285,7 +427,13 @@ private:
     u32 CompileInstr(u32 offset) {
         const Instruction instr = {program_code[offset]};
 
-        shader.AddLine("// " + std::to_string(offset) + ": " + OpCode::GetInfo(instr.opcode).name);
+        // Nothing uses the results of dead instructions, and even the registers they write to
+        // are left undeclared when no other instruction uses them.
+        if (dead_instructions.count(offset) != 0) {
+            return offset + 1;
+        }
+
+        shader.AddLine("// ", offset, ": ", OpCode::GetInfo(instr.opcode).name);
 
         switch (OpCode::GetInfo(instr.opcode).type) {
         case OpCode::Type::Arithmetic: {
@@ -427,12 +575,12 @@ private:
                 const std::string op_a = GetRegister(instr.gpr8);
                 const std::string op_b = GetRegister(instr.gpr20);
                 const std::string sampler = GetSampler(instr.sampler);
-                const std::string coord = "vec2 coords = vec2(" + op_a + ", " + op_b + ");";
+
                 // Add an extra scope and declare the texture coords inside to prevent overwriting
                 // them in case they are used as outputs of the texs instruction.
                 shader.AddLine("{");
                 ++shader.scope;
-                shader.AddLine(coord);
+                shader.AddLine("vec2 coords = vec2(", op_a, ", ", op_b, ");");
                 const std::string texture = "texture(" + sampler + ", coords)";
                 for (unsigned elem = 0; elem < instr.attribute.fmt20.size; ++elem) {
                     SetDest(elem, GetRegister(instr.gpr0, elem), texture, 1, 4);
@@ -497,7 +645,7 @@ private:
     void Generate() {
         // Add declarations for all subroutines
         for (const auto& subroutine : subroutines) {
-            shader.AddLine("bool " + subroutine.GetName() + "();");
+            shader.AddLine("bool ", subroutine.GetName(), "();");
         }
         shader.AddNewLine();
 
@@ -512,7 +660,7 @@ private:
         for (const auto& subroutine : subroutines) {
             std::set<u32> labels = subroutine.labels;
 
-            shader.AddLine("bool " + subroutine.GetName() + "() {");
+            shader.AddLine("bool ", subroutine.GetName(), "() {");
             ++shader.scope;
 
             if (labels.empty()) {
@@ -521,14 +669,14 @@ private:
                 }
             } else {
                 labels.insert(subroutine.begin);
-                shader.AddLine("uint jmp_to = " + std::to_string(subroutine.begin) + "u;");
+                shader.AddLine("uint jmp_to = ", subroutine.begin, "u;");
                 shader.AddLine("while (true) {");
                 ++shader.scope;
 
                 shader.AddLine("switch (jmp_to) {");
 
                 for (auto label : labels) {
-                    shader.AddLine("case " + std::to_string(label) + "u: {");
+                    shader.AddLine("case ", label, "u: {");
                     ++shader.scope;
 
                     auto next_it = labels.lower_bound(label + 1);
@@ -537,7 +685,7 @@ private:
                     u32 compile_end = CompileRange(label, next_label);
                     if (compile_end > next_label && compile_end != PROGRAM_END) {
                         // This happens only when there is a label inside a IF/LOOP block
-                        shader.AddLine("{ jmp_to = " + std::to_string(compile_end) + "u; break; }");
+                        shader.AddLine("{ jmp_to = ", compile_end, "u; break; }");
                         labels.emplace(compile_end);
                     }
 
@@ -571,36 +719,45 @@ private:
         return result;
     }
 
+    /// Returns a list of the texture samplers used by the shader
+    std::vector<SamplerEntry> GetSamplersDeclarations() const {
+        std::vector<SamplerEntry> result;
+        for (const unsigned index : declr_samplers) {
+            result.push_back({index});
+        }
+        return result;
+    }
+
     /// Add declarations for registers
     void GenerateDeclarations() {
         for (const auto& reg : declr_register) {
-            declarations.AddLine("float " + reg + " = 0.0;");
+            declarations.AddLine("float ", reg, " = 0.0;");
         }
         declarations.AddNewLine();
 
         for (const auto& index : declr_input_attribute) {
             // TODO(bunnei): Use proper number of elements for these
-            declarations.AddLine("layout(location = " +
-                                 std::to_string(static_cast<u32>(index) -
-                                                static_cast<u32>(Attribute::Index::Attribute_0)) +
-                                 ") in vec4 " + GetInputAttribute(index) + ";");
+            declarations.AddLine("layout(location = ",
+                                 static_cast<u32>(index) -
+                                     static_cast<u32>(Attribute::Index::Attribute_0),
+                                 ") in vec4 ", GetInputAttribute(index), ';');
         }
         declarations.AddNewLine();
 
         for (const auto& index : declr_output_attribute) {
             // TODO(bunnei): Use proper number of elements for these
-            declarations.AddLine("layout(location = " +
-                                 std::to_string(static_cast<u32>(index) -
-                                                static_cast<u32>(Attribute::Index::Attribute_0)) +
-                                 ") out vec4 " + GetOutputAttribute(index) + ";");
+            declarations.AddLine("layout(location = ",
+                                 static_cast<u32>(index) -
+                                     static_cast<u32>(Attribute::Index::Attribute_0),
+                                 ") out vec4 ", GetOutputAttribute(index), ';');
         }
         declarations.AddNewLine();
 
         unsigned const_buffer_layout = 0;
         for (const auto& entry : GetConstBuffersDeclarations()) {
-            declarations.AddLine("layout(std430) buffer " + entry.GetName());
+            declarations.AddLine("layout(std430) buffer ", entry.GetName());
             declarations.AddLine('{');
-            declarations.AddLine("    float c" + std::to_string(entry.GetIndex()) + "[];");
+            declarations.AddLine("    float c", entry.GetIndex(), "[];");
             declarations.AddLine("};");
             declarations.AddNewLine();
             ++const_buffer_layout;
@@ -609,6 +766,7 @@ private:
 
 private:
     const std::set<Subroutine>& subroutines;
+    const std::set<u32>& dead_instructions;
     const ProgramCode& program_code;
     const u32 main_offset;
     Maxwell3D::Regs::ShaderStage stage;
@@ -621,6 +779,7 @@ private:
     std::set<Attribute::Index> declr_input_attribute;
     std::set<Attribute::Index> declr_output_attribute;
     std::array<ConstBufferEntry, Maxwell3D::Regs::MaxConstBuffers> declr_const_buffers;
+    std::set<unsigned> declr_samplers;
 }; // namespace Decompiler
 
 std::string GetCommonDeclarations() {
@@ -631,7 +790,9 @@ boost::optional<ProgramResult> DecompileProgram(const ProgramCode& program_code,
                                                 Maxwell3D::Regs::ShaderStage stage) {
     try {
         auto subroutines = ControlFlowAnalyzer(program_code, main_offset).GetSubroutines();
-        GLSLGenerator generator(subroutines, program_code, main_offset, stage);
+        const auto dead_instructions =
+            DeadCodeAnalyzer(program_code, main_offset, stage).GetDeadInstructions();
+        GLSLGenerator generator(subroutines, dead_instructions, program_code, main_offset, stage);
         return ProgramResult{generator.GetShaderCode(), generator.GetEntries()};
     } catch (const DecompileFail& exception) {
         NGLOG_ERROR(HW_GPU, "Shader decompilation failed: {}", exception.what());
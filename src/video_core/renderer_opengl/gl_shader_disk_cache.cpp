@@ -0,0 +1,237 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cinttypes>
+#include <cstring>
+#include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/memory_usage.h"
+#include "common/scm_rev.h"
+#include "common/string_util.h"
+#include "core/settings.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
+
+namespace GLShader {
+
+namespace {
+
+Common::MemoryUsageCounter shader_cache_usage("Shader cache");
+
+void WriteU32(std::vector<u8>& data, u32 value) {
+    const size_t offset = data.size();
+    data.resize(offset + sizeof(value));
+    std::memcpy(&data[offset], &value, sizeof(value));
+}
+
+bool ReadU32(const u8*& data, const u8* end, u32& value) {
+    if (static_cast<size_t>(end - data) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+/// Stores the shader type of a program and its entries, followed by its GLSL
+std::vector<u8> SerializeProgram(GLenum type, const ProgramResult& program) {
+    const ShaderEntries& entries = program.second;
+    std::vector<u8> data;
+    WriteU32(data, type);
+    WriteU32(data, static_cast<u32>(entries.const_buffer_entries.size()));
+    for (const ConstBufferEntry& entry : entries.const_buffer_entries) {
+        WriteU32(data, entry.GetIndex());
+        WriteU32(data, entry.GetSize());
+        WriteU32(data, static_cast<u32>(entry.GetStage()));
+    }
+    WriteU32(data, static_cast<u32>(entries.texture_samplers.size()));
+    for (const SamplerEntry& entry : entries.texture_samplers) {
+        WriteU32(data, entry.index);
+    }
+    data.insert(data.end(), program.first.begin(), program.first.end());
+    return data;
+}
+
+bool DeserializeProgram(const u8* data, u32 size, GLenum& type, ProgramResult& program) {
+    const u8* const end = data + size;
+    ShaderEntries& entries = program.second;
+
+    u32 stored_type;
+    if (!ReadU32(data, end, stored_type)) {
+        return false;
+    }
+    type = stored_type;
+
+    u32 num_const_buffers;
+    if (!ReadU32(data, end, num_const_buffers)) {
+        return false;
+    }
+    for (u32 i = 0; i < num_const_buffers; ++i) {
+        u32 index, buffer_size, stage;
+        if (!ReadU32(data, end, index) || !ReadU32(data, end, buffer_size) ||
+            !ReadU32(data, end, stage) || buffer_size == 0) {
+            return false;
+        }
+        ConstBufferEntry entry;
+        entry.MarkAsUsed(index, buffer_size - 1,
+                         static_cast<Tegra::Engines::Maxwell3D::Regs::ShaderStage>(stage));
+        entries.const_buffer_entries.push_back(entry);
+    }
+
+    u32 num_samplers;
+    if (!ReadU32(data, end, num_samplers)) {
+        return false;
+    }
+    for (u32 i = 0; i < num_samplers; ++i) {
+        u32 index;
+        if (!ReadU32(data, end, index)) {
+            return false;
+        }
+        entries.texture_samplers.push_back({index});
+    }
+
+    program.first.assign(reinterpret_cast<const char*>(data), end - data);
+    return true;
+}
+
+/// Binaries are kept across builds, so their keys use CityHash, which never changes.
+u64 GetSourceHash(const std::string& source) {
+    return Common::CityHash64(source.data(), source.size());
+}
+
+/// Decompiled programs are only used by the build that made them, as the decompiler changes.
+u64 GetBuildHash() {
+    return Common::ComputeHash64(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+}
+
+/// Binaries only work with the driver that made them, so each driver gets a file of its own.
+u64 GetDriverHash() {
+    std::string driver;
+    for (const GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* const string = glGetString(name);
+        if (string != nullptr) {
+            driver += reinterpret_cast<const char*>(string);
+        }
+    }
+    return Common::CityHash64(driver.data(), driver.size());
+}
+
+} // Anonymous namespace
+
+ShaderDiskCache::~ShaderDiskCache() {
+    shader_cache_usage.Subtract(programs_size);
+}
+
+void ShaderDiskCache::Open() {
+    if (!Settings::values.use_disk_shader_cache) {
+        return;
+    }
+
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Unable to create the shader cache directory %s", dir.c_str());
+        return;
+    }
+    enabled = true;
+
+    if (programs_file.Open(dir + "glsl.bin", GetBuildHash())) {
+        std::vector<u8> data;
+        for (const u64 config_hash : programs_file.GetKeys()) {
+            StoredProgram stored;
+            if (programs_file.Read(config_hash, data) &&
+                DeserializeProgram(data.data(), static_cast<u32>(data.size()), stored.type,
+                                   stored.program)) {
+                programs_size += stored.program.first.size();
+                shader_cache_usage.Add(stored.program.first.size());
+                programs.emplace(config_hash, std::move(stored));
+            }
+        }
+    }
+
+    GLint num_binary_formats = 0;
+    if (GLAD_GL_ARB_get_program_binary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+    }
+    if (num_binary_formats > 0) {
+        const u64 driver_hash = GetDriverHash();
+        const std::string path =
+            Common::StringFromFormat("%sprograms_%016" PRIX64 ".bin", dir.c_str(), driver_hash);
+        binaries_enabled = binaries_file.Open(path, driver_hash);
+    }
+
+    LOG_INFO(Render_OpenGL, "Loaded %zu shaders and found %zu program binaries in the disk cache",
+             programs.size(), binaries_file.GetSize());
+}
+
+const ProgramResult* ShaderDiskCache::FindProgram(u64 config_hash) const {
+    const auto it = programs.find(config_hash);
+    return it != programs.end() ? &it->second.program : nullptr;
+}
+
+std::vector<const ProgramResult*> ShaderDiskCache::GetPrograms(GLenum type) const {
+    std::vector<const ProgramResult*> result;
+    for (const auto& entry : programs) {
+        if (entry.second.type == type) {
+            result.push_back(&entry.second.program);
+        }
+    }
+    return result;
+}
+
+void ShaderDiskCache::SaveProgram(u64 config_hash, GLenum type, const ProgramResult& program) {
+    if (!enabled || !programs.emplace(config_hash, StoredProgram{type, program}).second) {
+        return;
+    }
+    programs_size += program.first.size();
+    shader_cache_usage.Add(program.first.size());
+    const std::vector<u8> data = SerializeProgram(type, program);
+    programs_file.Write(config_hash, data.data(), data.size());
+}
+
+bool ShaderDiskCache::LoadProgramBinary(const std::string& source, OGLProgram& program) const {
+    std::vector<u8> data;
+    if (!binaries_enabled || !binaries_file.Read(GetSourceHash(source), data) ||
+        data.size() <= sizeof(GLenum)) {
+        return false;
+    }
+    GLenum format;
+    std::memcpy(&format, data.data(), sizeof(format));
+
+    program.handle = glCreateProgram();
+    glProgramParameteri(program.handle, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glProgramBinary(program.handle, format, data.data() + sizeof(format),
+                    static_cast<GLsizei>(data.size() - sizeof(format)));
+
+    // Drivers reject the binaries of older versions of themselves, which are then built again.
+    GLint result = GL_FALSE;
+    glGetProgramiv(program.handle, GL_LINK_STATUS, &result);
+    if (result != GL_TRUE) {
+        LOG_DEBUG(Render_OpenGL, "Discarding a stale program binary");
+        program.Release();
+        return false;
+    }
+    return true;
+}
+
+void ShaderDiskCache::SaveProgramBinary(const std::string& source, GLuint program) {
+    if (!binaries_enabled) {
+        return;
+    }
+    const u64 source_hash = GetSourceHash(source);
+
+    GLint binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0) {
+        return;
+    }
+    std::vector<u8> data(sizeof(GLenum) + binary_length);
+    GLenum format;
+    glGetProgramBinary(program, binary_length, nullptr, &format, data.data() + sizeof(format));
+    std::memcpy(data.data(), &format, sizeof(format));
+
+    binaries_file.Write(source_hash, data.data(), data.size());
+}
+
+} // namespace GLShader
@@ -0,0 +1,63 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_types.h"
+#include "common/indexed_disk_cache.h"
+#include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+
+namespace GLShader {
+
+/**
+ * On-disk cache of the shaders built for the guest programs, so that they don't have to be
+ * decompiled and compiled again in later sessions. The decompiled GLSL and its entries are kept
+ * by the hash of the shader config, which includes the hash of the guest program code, and the
+ * linked program binaries by the hash of their GLSL, in a file of their own for each driver.
+ * The programs are read back when the cache is opened, while binaries are only read once their
+ * GLSL is built. Both are only used when Settings::values.use_disk_shader_cache is set.
+ */
+class ShaderDiskCache final : NonCopyable {
+public:
+    struct StoredProgram {
+        GLenum type;
+        ProgramResult program;
+    };
+
+    ~ShaderDiskCache();
+
+    /// Opens the cache files and reads back the programs. Needs a current GL context.
+    void Open();
+
+    /// Returns the decompiled program stored for a config hash, or nullptr if there is none.
+    const ProgramResult* FindProgram(u64 config_hash) const;
+    /// Returns every decompiled program stored for a shader type, to be built ahead of time.
+    std::vector<const ProgramResult*> GetPrograms(GLenum type) const;
+    void SaveProgram(u64 config_hash, GLenum type, const ProgramResult& program);
+
+    /**
+     * Creates a separable program from the binary stored for its GLSL.
+     * @returns Whether program was created. The GLSL has to be compiled otherwise.
+     */
+    bool LoadProgramBinary(const std::string& source, OGLProgram& program) const;
+    void SaveProgramBinary(const std::string& source, GLuint program);
+
+private:
+    bool enabled = false;
+    bool binaries_enabled = false;
+
+    Common::IndexedDiskCache programs_file;
+    /// Binary format followed by the binary, by the hash of the GLSL they were linked from
+    Common::IndexedDiskCache binaries_file;
+    std::unordered_map<u64, StoredProgram> programs;
+    /// Size of the GLSL kept in programs, for the memory usage statistics
+    u64 programs_size = 0;
+};
+
+} // namespace GLShader
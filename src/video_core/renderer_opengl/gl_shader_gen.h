@@ -11,6 +11,7 @@
 #include <vector>
 #include "common/common_types.h"
 #include "common/hash.h"
+#include "video_core/engines/maxwell_3d.h"
 
 namespace GLShader {
 
@@ -41,6 +42,10 @@ public:
         return max_offset + 1;
     }
 
+    Maxwell::ShaderStage GetStage() const {
+        return stage;
+    }
+
     std::string GetName() const {
         return BufferBaseNames[static_cast<size_t>(stage)] + std::to_string(index);
     }
@@ -56,8 +61,15 @@ private:
     Maxwell::ShaderStage stage;
 };
 
+struct SamplerEntry {
+    /// Index of the texture handle in the texture const buffer. The shader samples the texture
+    /// through tex[index].
+    unsigned index;
+};
+
 struct ShaderEntries {
     std::vector<ConstBufferEntry> const_buffer_entries;
+    std::vector<SamplerEntry> texture_samplers;
 };
 
 using ProgramResult = std::pair<std::string, ShaderEntries>;
@@ -68,16 +80,16 @@ struct ShaderSetup {
     ProgramCode program_code;
     bool program_code_hash_dirty = true;
 
-    u64 GetProgramCodeHash() {
+    u128 GetProgramCodeHash() {
         if (program_code_hash_dirty) {
-            program_code_hash = Common::ComputeHash64(&program_code, sizeof(program_code));
+            program_code_hash = Common::ComputeHash128(&program_code, sizeof(program_code));
             program_code_hash_dirty = false;
         }
         return program_code_hash;
     }
 
 private:
-    u64 program_code_hash{};
+    u128 program_code_hash{};
 };
 
 struct MaxwellShaderConfigCommon {
@@ -85,7 +97,7 @@ struct MaxwellShaderConfigCommon {
         program_hash = setup.GetProgramCodeHash();
     }
 
-    u64 program_hash;
+    u128 program_hash;
 };
 
 struct MaxwellVSConfig : Common::HashableStruct<MaxwellShaderConfigCommon> {
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <vector>
 #include "core/core.h"
 #include "core/hle/kernel/process.h"
 #include "video_core/engines/maxwell_3d.h"
@@ -61,4 +62,28 @@ void MaxwellUniformData::SetFromRegs(const Maxwell3D::State::ShaderStageInfo& sh
     viewport_flip[1] = regs.viewport_transform[0].scale_y < 0.0 ? -1.0 : 1.0;
 }
 
+void ProgramManager::LoadDiskCache(const Tegra::DiskResourceLoadCallback& callback) {
+    std::vector<OGLShaderStage*> stages;
+    for (const ProgramResult* program : disk_cache.GetPrograms(GL_VERTEX_SHADER)) {
+        if (OGLShaderStage* stage = vertex_shaders.Preload(*program)) {
+            stages.push_back(stage);
+        }
+    }
+    for (const ProgramResult* program : disk_cache.GetPrograms(GL_FRAGMENT_SHADER)) {
+        if (OGLShaderStage* stage = fragment_shaders.Preload(*program)) {
+            stages.push_back(stage);
+        }
+    }
+
+    for (size_t i = 0; i < stages.size(); ++i) {
+        stages[i]->Wait(disk_cache);
+        if (callback) {
+            callback(i + 1, stages.size());
+        }
+    }
+    if (!stages.empty()) {
+        LOG_INFO(Render_OpenGL, "Built %zu shaders from the disk cache", stages.size());
+    }
+}
+
 } // namespace GLShader
@@ -4,12 +4,19 @@
 
 #pragma once
 
+#include <chrono>
 #include <tuple>
 #include <unordered_map>
-#include <boost/functional/hash.hpp>
+#include <utility>
 #include <glad/glad.h>
+#include "common/scope_exit.h"
+#include "core/core.h"
+#include "core/settings.h"
+#include "video_core/gpu.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
+#include "video_core/renderer_opengl/gl_shader_disk_cache.h"
 #include "video_core/renderer_opengl/gl_shader_gen.h"
+#include "video_core/renderer_opengl/gl_shader_util.h"
 #include "video_core/renderer_opengl/maxwell_to_gl.h"
 
 namespace GLShader {
@@ -40,14 +47,54 @@ class OGLShaderStage {
 public:
     OGLShaderStage() = default;
 
-    void Create(const ProgramResult& program_result, GLenum type) {
+    /// Builds the program of the stage. With asynchronous set, the driver builds it in the
+    /// background, and IsReady tells when it's done.
+    void Create(const ProgramResult& program_result, GLenum type, ShaderDiskCache& disk_cache,
+                bool asynchronous) {
+        const auto build_begin = std::chrono::steady_clock::now();
+        SCOPE_EXIT({ CountBuildTime(build_begin); });
+
+        entries = program_result.second;
+        const bool loaded = disk_cache.LoadProgramBinary(program_result.first, program);
+        Core::System::GetInstance().perf_stats.AddShaderBuild(loaded);
+        if (loaded) {
+            SetBindings();
+            return;
+        }
+        if (asynchronous) {
+            program.handle = QueueSeparableProgram(program_result.first.c_str(), type);
+            pending_source = program_result.first;
+            return;
+        }
+
         OGLShader shader;
         shader.Create(program_result.first.c_str(), type);
         program.Create(true, shader.handle);
-        Impl::SetShaderUniformBlockBindings(program.handle);
-        Impl::SetShaderSamplerBindings(program.handle);
-        entries = program_result.second;
+        disk_cache.SaveProgramBinary(program_result.first, program.handle);
+        SetBindings();
     }
+
+    /// Returns whether the program can be used, finishing it once the driver has built it
+    bool IsReady(ShaderDiskCache& disk_cache) {
+        if (pending_source.empty()) {
+            return true;
+        }
+        GLint complete = GL_FALSE;
+        glGetProgramiv(program.handle, GL_COMPLETION_STATUS_ARB, &complete);
+        if (complete != GL_TRUE) {
+            return false;
+        }
+        Finish(disk_cache);
+        return true;
+    }
+
+    /// Waits for the driver to build the program, if it's still being built in the background
+    void Wait(ShaderDiskCache& disk_cache) {
+        if (!pending_source.empty()) {
+            Finish(disk_cache);
+        }
+    }
+
     GLuint GetHandle() const {
         return program.handle;
     }
@@ -57,8 +104,32 @@ public:
     }
 
 private:
+    void Finish(ShaderDiskCache& disk_cache) {
+        const auto build_begin = std::chrono::steady_clock::now();
+        SCOPE_EXIT({ CountBuildTime(build_begin); });
+
+        if (FinishProgram(program.handle)) {
+            disk_cache.SaveProgramBinary(pending_source, program.handle);
+        }
+        pending_source.clear();
+        SetBindings();
+    }
+
+    void SetBindings() {
+        Impl::SetShaderUniformBlockBindings(program.handle);
+        Impl::SetShaderSamplerBindings(program.handle);
+    }
+
+    /// Counts the time since build_begin towards the shader build time of the telemetry session
+    static void CountBuildTime(std::chrono::steady_clock::time_point build_begin) {
+        Core::Telemetry().AddShaderBuildTime(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - build_begin));
+    }
+
     OGLProgram program;
     ShaderEntries entries;
+    /// GLSL of a program still being built in the background, for its binary to be saved
+    std::string pending_source;
 };
 
 // TODO(wwylele): beautify this doc
@@ -70,30 +141,89 @@ template <typename KeyConfigType,
           GLenum ShaderType>
 class ShaderCache {
 public:
-    ShaderCache() = default;
+    ShaderCache(ShaderDiskCache& disk_cache, bool asynchronous)
+        : disk_cache(disk_cache), asynchronous(asynchronous) {}
 
     using Result = std::pair<GLuint, ShaderEntries>;
 
+    /// Returns the key of the program of a config in the disk cache.
+    static u64 GetDiskKey(const KeyConfigType& key) {
+        // The stage is mixed in, as vertex and fragment configs of the same code hash alike
+        return key.Hash() ^ ShaderType;
+    }
+
+    /// Returns the program for a config and its entries. The handle is 0 while the program is
+    /// still being built in the background.
     Result Get(const KeyConfigType& key, const ShaderSetup& setup) {
         auto map_it = shader_map.find(key);
         if (map_it == shader_map.end()) {
-            ProgramResult program = CodeGenerator(setup, key);
+            const u64 disk_key = GetDiskKey(key);
+            ProgramResult program;
+            if (const ProgramResult* stored_program = disk_cache.FindProgram(disk_key)) {
+                program = *stored_program;
+            } else {
+                program = CodeGenerator(setup, key);
+                disk_cache.SaveProgram(disk_key, ShaderType, program);
+            }
 
-            auto [iter, new_shader] = shader_cache.emplace(program.first, OGLShaderStage{});
+            const u128 source_hash =
+                Common::ComputeHash128(program.first.data(), program.first.size());
+            auto [iter, new_shader] = shader_cache.emplace(source_hash, OGLShaderStage{});
             OGLShaderStage& cached_shader = iter->second;
             if (new_shader) {
-                cached_shader.Create(program, ShaderType);
+                cached_shader.Create(program, ShaderType, disk_cache, asynchronous);
             }
             shader_map[key] = &cached_shader;
-            return {cached_shader.GetHandle(), program.second};
+            return {cached_shader.IsReady(disk_cache) ? cached_shader.GetHandle() : 0,
+                    program.second};
         } else {
-            return {map_it->second->GetHandle(), map_it->second->GetEntries()};
+            OGLShaderStage& cached_shader = *map_it->second;
+            return {cached_shader.IsReady(disk_cache) ? cached_shader.GetHandle() : 0,
+                    cached_shader.GetEntries()};
+        }
+    }
+
+    /**
+     * Starts building a program stored in the disk cache ahead of its first use, in the
+     * background when the driver supports it.
+     * @returns The stage being built, or nullptr if the cache already had it
+     */
+    OGLShaderStage* Preload(const ProgramResult& program) {
+        const u128 source_hash = Common::ComputeHash128(program.first.data(), program.first.size());
+        auto [iter, new_shader] = shader_cache.emplace(source_hash, OGLShaderStage{});
+        if (!new_shader) {
+            return nullptr;
+        }
+        iter->second.Create(program, ShaderType, disk_cache, true);
+        return &iter->second;
+    }
+
+    /// Returns the program stored in the disk cache for a key, or 0 if it isn't built.
+    GLuint GetStoredProgram(u64 disk_key) {
+        const ProgramResult* program = disk_cache.FindProgram(disk_key);
+        if (program == nullptr) {
+            return 0;
+        }
+        const auto iter = shader_cache.find(
+            Common::ComputeHash128(program->first.data(), program->first.size()));
+        if (iter == shader_cache.end() || !iter->second.IsReady(disk_cache)) {
+            return 0;
         }
+        return iter->second.GetHandle();
     }
 
 private:
+    ShaderDiskCache& disk_cache;
+    bool asynchronous;
+    struct SourceHashHash {
+        size_t operator()(const u128& hash) const {
+            return static_cast<size_t>(hash[0]);
+        }
+    };
+
     std::unordered_map<KeyConfigType, OGLShaderStage*> shader_map;
-    std::unordered_map<std::string, OGLShaderStage> shader_cache;
+    /// Stages by the 128-bit hash of their GLSL, which isn't kept in memory
+    std::unordered_map<u128, OGLShaderStage, SourceHashHash> shader_cache;
 };
 
 using VertexShaders = ShaderCache<MaxwellVSConfig, &GenerateVertexShader, GL_VERTEX_SHADER>;
@@ -102,14 +232,34 @@ using FragmentShaders = ShaderCache<MaxwellFSConfig, &GenerateFragmentShader, GL
 
 class ProgramManager {
 public:
-    ProgramManager() {
+    ProgramManager()
+        : asynchronous_shaders(Settings::values.use_asynchronous_shaders &&
+                               (GLAD_GL_ARB_parallel_shader_compile ||
+                                GLAD_GL_KHR_parallel_shader_compile)) {
+        disk_cache.Open();
         pipeline.Create();
+        if (asynchronous_shaders) {
+            // Lets the driver pick how many threads build programs in the background
+            if (GLAD_GL_KHR_parallel_shader_compile) {
+                glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+            } else {
+                glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+            }
+        }
     }
 
+    /**
+     * Builds every program stored in the disk cache, so that the guest doesn't wait for them when
+     * it first uses them. The driver builds them all at once, and callback is told how many of
+     * them are done as they finish.
+     */
+    void LoadDiskCache(const Tegra::DiskResourceLoadCallback& callback);
+
     ShaderEntries UseProgrammableVertexShader(const MaxwellVSConfig& config,
                                               const ShaderSetup setup) {
         ShaderEntries result;
         std::tie(current.vs, result) = vertex_shaders.Get(config, setup);
+        current_vs_disk_key = VertexShaders::GetDiskKey(config);
         return result;
     }
 
@@ -117,9 +267,27 @@ public:
                                                 const ShaderSetup setup) {
         ShaderEntries result;
         std::tie(current.fs, result) = fragment_shaders.Get(config, setup);
+        current_fs_disk_key = FragmentShaders::GetDiskKey(config);
         return result;
     }
 
+    /**
+     * Uses the programs stored in the disk cache for a pair of keys, to draw with them ahead of
+     * their first use.
+     * @returns Whether both programs are built
+     */
+    bool UseStoredPrograms(u64 vs_disk_key, u64 fs_disk_key) {
+        current.vs = vertex_shaders.GetStoredProgram(vs_disk_key);
+        current.gs = 0;
+        current.fs = fragment_shaders.GetStoredProgram(fs_disk_key);
+        return IsCurrentProgramReady();
+    }
+
+    /// Returns the disk cache keys of the vertex and fragment programs used
+    std::pair<u64, u64> GetCurrentDiskKeys() const {
+        return {current_vs_disk_key, current_fs_disk_key};
+    }
+
     GLuint GetCurrentProgramStage(Maxwell3D::Regs::ShaderStage stage) {
         switch (stage) {
         case Maxwell3D::Regs::ShaderStage::Vertex:
@@ -135,15 +303,27 @@ public:
         current.gs = 0;
     }
 
+    /// Returns whether the programs used have all been built. Draws using a program still being
+    /// built in the background are skipped.
+    bool IsCurrentProgramReady() const {
+        return current.vs != 0 && current.fs != 0;
+    }
+
     void ApplyTo(OpenGLState& state) {
-        // Workaround for AMD bug
-        glUseProgramStages(pipeline.handle,
-                           GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT | GL_FRAGMENT_SHADER_BIT,
-                           0);
-
-        glUseProgramStages(pipeline.handle, GL_VERTEX_SHADER_BIT, current.vs);
-        glUseProgramStages(pipeline.handle, GL_GEOMETRY_SHADER_BIT, current.gs);
-        glUseProgramStages(pipeline.handle, GL_FRAGMENT_SHADER_BIT, current.fs);
+        // Each stage is a separable program of its own, so switching programs only changes the
+        // stages of the pipeline, and only when they differ from the ones it already uses.
+        if (current != applied) {
+            // Workaround for AMD bug
+            glUseProgramStages(pipeline.handle,
+                               GL_VERTEX_SHADER_BIT | GL_GEOMETRY_SHADER_BIT |
+                                   GL_FRAGMENT_SHADER_BIT,
+                               0);
+
+            glUseProgramStages(pipeline.handle, GL_VERTEX_SHADER_BIT, current.vs);
+            glUseProgramStages(pipeline.handle, GL_GEOMETRY_SHADER_BIT, current.gs);
+            glUseProgramStages(pipeline.handle, GL_FRAGMENT_SHADER_BIT, current.fs);
+            applied = current;
+        }
         state.draw.shader_program = 0;
         state.draw.program_pipeline = pipeline.handle;
     }
@@ -154,21 +334,19 @@ private:
         bool operator==(const ShaderTuple& rhs) const {
             return std::tie(vs, gs, fs) == std::tie(rhs.vs, rhs.gs, rhs.fs);
         }
-        struct Hash {
-            std::size_t operator()(const ShaderTuple& tuple) const {
-                std::size_t hash = 0;
-                boost::hash_combine(hash, tuple.vs);
-                boost::hash_combine(hash, tuple.gs);
-                boost::hash_combine(hash, tuple.fs);
-                return hash;
-            }
-        };
+        bool operator!=(const ShaderTuple& rhs) const {
+            return !operator==(rhs);
+        }
     };
     ShaderTuple current;
-    VertexShaders vertex_shaders;
-    FragmentShaders fragment_shaders;
-
-    std::unordered_map<ShaderTuple, OGLProgram, ShaderTuple::Hash> program_cache;
+    /// Stages the pipeline was last set up with
+    ShaderTuple applied;
+    u64 current_vs_disk_key = 0;
+    u64 current_fs_disk_key = 0;
+    bool asynchronous_shaders;
+    ShaderDiskCache disk_cache;
+    VertexShaders vertex_shaders{disk_cache, asynchronous_shaders};
+    FragmentShaders fragment_shaders{disk_cache, asynchronous_shaders};
     OGLPipeline pipeline;
 };
 
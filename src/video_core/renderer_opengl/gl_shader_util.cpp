@@ -22,6 +22,9 @@ GLuint LoadShader(const char* source, GLenum type) {
     case GL_FRAGMENT_SHADER:
         debug_type = "fragment";
         break;
+    case GL_COMPUTE_SHADER:
+        debug_type = "compute";
+        break;
     default:
         UNREACHABLE();
     }
@@ -47,4 +50,41 @@ GLuint LoadShader(const char* source, GLenum type) {
     return shader_id;
 }
 
+GLuint QueueSeparableProgram(const char* source, GLenum type) {
+    const GLuint shader_id = glCreateShader(type);
+    glShaderSource(shader_id, 1, &source, nullptr);
+    glCompileShader(shader_id);
+
+    const GLuint program_id = glCreateProgram();
+    glProgramParameteri(program_id, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    if (GLAD_GL_ARB_get_program_binary) {
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program_id, shader_id);
+    glLinkProgram(program_id);
+
+    // Only flagged for deletion while attached, the shader goes away with the program.
+    glDeleteShader(shader_id);
+    return program_id;
+}
+
+bool FinishProgram(GLuint program_id) {
+    GLint result = GL_FALSE;
+    GLint info_log_length;
+    glGetProgramiv(program_id, GL_LINK_STATUS, &result);
+    glGetProgramiv(program_id, GL_INFO_LOG_LENGTH, &info_log_length);
+
+    // The program log includes the errors of the shader it was linked from
+    if (info_log_length > 1) {
+        std::string program_error(info_log_length, ' ');
+        glGetProgramInfoLog(program_id, info_log_length, nullptr, &program_error[0]);
+        if (result == GL_TRUE) {
+            NGLOG_DEBUG(Render_OpenGL, "{}", program_error);
+        } else {
+            NGLOG_ERROR(Render_OpenGL, "Error building shader:\n{}", program_error);
+        }
+    }
+    return result == GL_TRUE;
+}
+
 } // namespace GLShader
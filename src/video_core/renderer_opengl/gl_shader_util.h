@@ -18,6 +18,20 @@ namespace GLShader {
  */
 GLuint LoadShader(const char* source, GLenum type);
 
+/**
+ * Starts compiling and linking a separable program made of a single GLSL shader, without waiting
+ * for either. Meant for drivers that build programs in the background: the program can be used
+ * once its GL_COMPLETION_STATUS_ARB is set, and FinishProgram is called then.
+ * @returns Handle of the newly created OpenGL program object
+ */
+GLuint QueueSeparableProgram(const char* source, GLenum type);
+
+/**
+ * Checks the link status of a program from QueueSeparableProgram, logging any errors.
+ * @returns Whether the program linked
+ */
+bool FinishProgram(GLuint program_id);
+
 /**
  * Utility function to create and compile an OpenGL GLSL shader program (vertex + fragment shader)
  * @param separable_program whether to create a separable program
@@ -35,6 +49,10 @@ GLuint LoadProgram(bool separable_program, T... shaders) {
 
     if (separable_program) {
         glProgramParameteri(program_id, GL_PROGRAM_SEPARABLE, GL_TRUE);
+        // Separable programs are built for the guest shaders, whose binaries are kept on disk
+        if (GLAD_GL_ARB_get_program_binary) {
+            glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
     }
 
     glLinkProgram(program_id);
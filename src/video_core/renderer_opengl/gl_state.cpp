@@ -2,7 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <iterator>
+#include <type_traits>
 #include <glad/glad.h>
 #include "common/logging/log.h"
 #include "video_core/renderer_opengl/gl_state.h"
@@ -192,13 +194,17 @@ void OpenGLState::Apply() const {
     }
 
     // Textures
-    for (size_t i = 0; i < std::size(texture_units); ++i) {
-        if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
-            glActiveTexture(TextureUnits::MaxwellTexture(i).Enum());
-            glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
-        }
-        if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
-            glBindSampler(i, texture_units[i].sampler);
+    if (GLAD_GL_ARB_multi_bind) {
+        ApplyTextureUnitsMultiBind();
+    } else {
+        for (size_t i = 0; i < std::size(texture_units); ++i) {
+            if (texture_units[i].texture_2d != cur_state.texture_units[i].texture_2d) {
+                glActiveTexture(TextureUnits::MaxwellTexture(i).Enum());
+                glBindTexture(GL_TEXTURE_2D, texture_units[i].texture_2d);
+            }
+            if (texture_units[i].sampler != cur_state.texture_units[i].sampler) {
+                glBindSampler(i, texture_units[i].sampler);
+            }
         }
     }
 
@@ -325,6 +331,39 @@ void OpenGLState::Apply() const {
     cur_state = *this;
 }
 
+void OpenGLState::ApplyTextureUnitsMultiBind() const {
+    constexpr size_t num_units = std::extent_v<decltype(texture_units)>;
+    std::array<GLuint, num_units> textures;
+    std::array<GLuint, num_units> samplers;
+    // Range of the units whose bindings changed, which are then rebound with one call each
+    size_t first_texture = num_units, last_texture = 0;
+    size_t first_sampler = num_units, last_sampler = 0;
+
+    for (size_t i = 0; i < num_units; ++i) {
+        textures[i] = texture_units[i].texture_2d;
+        samplers[i] = texture_units[i].sampler;
+        if (textures[i] != cur_state.texture_units[i].texture_2d) {
+            first_texture = std::min(first_texture, i);
+            last_texture = i;
+        }
+        if (samplers[i] != cur_state.texture_units[i].sampler) {
+            first_sampler = std::min(first_sampler, i);
+            last_sampler = i;
+        }
+    }
+
+    if (first_texture != num_units) {
+        glBindTextures(static_cast<GLuint>(first_texture),
+                       static_cast<GLsizei>(last_texture - first_texture + 1),
+                       &textures[first_texture]);
+    }
+    if (first_sampler != num_units) {
+        glBindSamplers(static_cast<GLuint>(first_sampler),
+                       static_cast<GLsizei>(last_sampler - first_sampler + 1),
+                       &samplers[first_sampler]);
+    }
+}
+
 OpenGLState& OpenGLState::ResetTexture(GLuint handle) {
     for (auto& unit : texture_units) {
         if (unit.texture_2d == handle) {
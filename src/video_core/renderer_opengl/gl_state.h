@@ -168,5 +168,9 @@ public:
     OpenGLState& ResetFramebuffer(GLuint handle);
 
 private:
+    /// Binds the textures and samplers of the units that changed with ARB_multi_bind, which
+    /// neither needs nor changes the active texture unit.
+    void ApplyTextureUnitsMultiBind() const;
+
     static OpenGLState cur_state;
 };
@@ -6,9 +6,14 @@
 #include <vector>
 #include "common/alignment.h"
 #include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "video_core/renderer_opengl/gl_state.h"
 #include "video_core/renderer_opengl/gl_stream_buffer.h"
 
+MICROPROFILE_DEFINE(OpenGL_StreamBufferStall, "OpenGL", "Stream Buffer Stall",
+                    MP_RGB(128, 128, 192));
+
 class OrphanBuffer : public OGLStreamBuffer {
 public:
     explicit OrphanBuffer(GLenum target) : OGLStreamBuffer(target) {}
@@ -44,6 +49,10 @@ private:
     std::deque<Fence> tail;
 
     u8* mapped_ptr;
+
+    /// Maps since the buffer last wrapped around, and how many of them waited on the GPU
+    u32 map_count = 0;
+    u32 stall_count = 0;
 };
 
 OGLStreamBuffer::OGLStreamBuffer(GLenum target) {
@@ -114,11 +123,12 @@ void StorageBuffer::Create(size_t size, size_t sync_subdivide) {
     gl_buffer.Create();
     glBindBuffer(gl_target, gl_buffer.handle);
 
-    glBufferStorage(gl_target, static_cast<GLsizeiptr>(buffer_size), nullptr,
-                    GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT);
+    // The mapping is coherent, so the GPU sees what is written without explicit flushes. Regions
+    // are only written again once the fence placed after their last use has signaled.
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(gl_target, static_cast<GLsizeiptr>(buffer_size), nullptr, flags);
     mapped_ptr = reinterpret_cast<u8*>(
-        glMapBufferRange(gl_target, 0, static_cast<GLsizeiptr>(buffer_size),
-                         GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_FLUSH_EXPLICIT_BIT));
+        glMapBufferRange(gl_target, 0, static_cast<GLsizeiptr>(buffer_size), flags));
 }
 
 void StorageBuffer::Release() {
@@ -154,6 +164,11 @@ std::pair<u8*, GLintptr> StorageBuffer::Map(size_t size, size_t alignment) {
         std::swap(tail, head);
         buffer_pos = 0;
         effective_offset = 0;
+
+        LOG_DEBUG(Render_OpenGL, "Stream buffer wrapped around, %u of %u maps stalled",
+                  stall_count, map_count);
+        map_count = 0;
+        stall_count = 0;
     }
 
     while (!tail.empty() && buffer_pos + size > tail.front().offset) {
@@ -162,9 +177,16 @@ std::pair<u8*, GLintptr> StorageBuffer::Map(size_t size, size_t alignment) {
     }
 
     if (sync.handle != 0) {
-        glClientWaitSync(sync.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        // Regions are usually long done with by the time they come around again, which is
+        // checked without waiting first.
+        if (glClientWaitSync(sync.handle, 0, 0) == GL_TIMEOUT_EXPIRED) {
+            MICROPROFILE_SCOPE(OpenGL_StreamBufferStall);
+            ++stall_count;
+            glClientWaitSync(sync.handle, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        }
         sync.Release();
     }
+    ++map_count;
 
     if (head.empty() || effective_offset > head.back().offset) {
         head.emplace_back();
@@ -176,7 +198,5 @@ std::pair<u8*, GLintptr> StorageBuffer::Map(size_t size, size_t alignment) {
 }
 
 void StorageBuffer::Unmap() {
-    glFlushMappedBufferRange(gl_target, static_cast<GLintptr>(buffer_pos),
-                             static_cast<GLsizeiptr>(mapped_size));
     buffer_pos += mapped_size;
 }
@@ -0,0 +1,80 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/microprofile.h"
+#include "common/thread_placement.h"
+#include "video_core/renderer_opengl/gl_surface_decoder.h"
+#include "video_core/textures/decoders.h"
+
+MICROPROFILE_DEFINE(OpenGL_SurfaceDecode, "OpenGL", "Surface Decode", MP_RGB(128, 64, 192));
+
+SurfaceDecoder::SurfaceDecoder() {
+    // Leaves cores for the CPU and GPU threads
+    const unsigned num_workers = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+    for (unsigned i = 0; i < num_workers; ++i) {
+        workers.emplace_back(&SurfaceDecoder::RunWorker, this);
+    }
+}
+
+SurfaceDecoder::~SurfaceDecoder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    jobs_available.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void SurfaceDecoder::Queue(std::shared_ptr<Job> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    jobs_available.notify_one();
+}
+
+void SurfaceDecoder::Wait(const Job& job) {
+    if (job.done.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    job_done.wait(lock, [&job] { return job.done.load(std::memory_order_acquire); });
+}
+
+void SurfaceDecoder::RunWorker() {
+    MicroProfileOnThreadCreate("SurfaceDecoder");
+    Common::SetCurrentThreadRole(Common::ThreadRole::Worker);
+
+    while (true) {
+        std::shared_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobs_available.wait(lock, [this] { return !jobs.empty() || !running; });
+            if (!running) {
+                // Jobs left in the queue belong to surfaces that are being destroyed.
+                break;
+            }
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        {
+            MICROPROFILE_SCOPE(OpenGL_SurfaceDecode);
+            job->decoded_data =
+                Tegra::Texture::UnswizzleTexture(job->swizzled_data.data(), job->format,
+                                                 job->width, job->height, job->block_height);
+            job->swizzled_data = {};
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job->done.store(true, std::memory_order_release);
+        }
+        job_done.notify_all();
+    }
+}
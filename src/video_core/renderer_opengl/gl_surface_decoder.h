@@ -0,0 +1,56 @@
+// Copyright 2018 yuzu Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/textures/texture.h"
+
+/**
+ * Unswizzles surfaces on worker threads, so that loading them doesn't hold up the render thread.
+ * The swizzled data is copied out of guest memory before it is queued, as the guest can change or
+ * unmap it while the job runs.
+ */
+class SurfaceDecoder final : NonCopyable {
+public:
+    struct Job {
+        std::vector<u8> swizzled_data;
+        Tegra::Texture::TextureFormat format;
+        u32 width;
+        u32 height;
+        u32 block_height;
+
+        /// Written by the worker thread, and only read once done is set
+        std::vector<u8> decoded_data;
+        std::atomic<bool> done{false};
+    };
+
+    SurfaceDecoder();
+    ~SurfaceDecoder();
+
+    /// Queues a job to be decoded by the next available worker thread.
+    void Queue(std::shared_ptr<Job> job);
+
+    /// Waits until a queued job has been decoded.
+    void Wait(const Job& job);
+
+private:
+    void RunWorker();
+
+    std::deque<std::shared_ptr<Job>> jobs;
+    bool running = true;
+
+    std::mutex mutex;
+    std::condition_variable jobs_available;
+    std::condition_variable job_done;
+
+    std::vector<std::thread> workers;
+};
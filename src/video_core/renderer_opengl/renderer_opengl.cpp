@@ -11,6 +11,7 @@
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/logging/log.h"
+#include "common/microprofile.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 #include "core/frontend/emu_window.h"
@@ -19,6 +20,7 @@
 #include "core/memory.h"
 #include "core/settings.h"
 #include "core/tracer/recorder.h"
+#include "video_core/renderer_opengl/gl_profiler_timer.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/utils.h"
 #include "video_core/video_core.h"
@@ -99,33 +101,65 @@ RendererOpenGL::RendererOpenGL() = default;
 RendererOpenGL::~RendererOpenGL() = default;
 
 /// Swap buffers (render frame)
-void RendererOpenGL::SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) {
-    Core::System::GetInstance().perf_stats.EndSystemFrame();
+void RendererOpenGL::SwapBuffers(const std::vector<Tegra::FramebufferConfig>& layers) {
+    Core::System::GetInstance().perf_stats.EndSystemFrame(CoreTiming::GetGlobalTimeUs());
+    Core::Telemetry().AddFrame(Core::System::GetInstance().perf_stats.GetLastFrameTimeScale());
 
     // Maintain the rasterizer's state as a priority
     OpenGLState prev_state = OpenGLState::GetCurState();
     state.Apply();
 
-    if (framebuffer != boost::none) {
-        // If framebuffer is provided, reload it from memory to a texture
-        if (screen_info.texture.width != (GLsizei)framebuffer->width ||
-            screen_info.texture.height != (GLsizei)framebuffer->height ||
-            screen_info.texture.pixel_format != framebuffer->pixel_format) {
-            // Reallocate texture if the framebuffer size has changed.
-            // This is expected to not happen very often and hence should not be a
-            // performance problem.
-            ConfigureFramebufferTexture(screen_info.texture, *framebuffer);
+    // While fast forwarding, most frames are only emulated and never reach the screen
+    ++frame_count;
+    const u16 present_interval = std::max<u16>(1, Settings::values.fast_forward_present_interval);
+    const bool skip_present =
+        Settings::values.use_fast_forward && frame_count % present_interval != 0;
+
+    if (!layers.empty() && !skip_present) {
+        while (screen_infos.size() < layers.size()) {
+            screen_infos.emplace_back();
+            CreateScreenTexture(screen_infos.back());
+        }
+
+        // If layers are provided, reload their framebuffers from memory to textures
+        for (size_t i = 0; i < layers.size(); ++i) {
+            const Tegra::FramebufferConfig& framebuffer = layers[i];
+            ScreenInfo& screen_info = screen_infos[i];
+            if (screen_info.texture.width != (GLsizei)framebuffer.width ||
+                screen_info.texture.height != (GLsizei)framebuffer.height ||
+                screen_info.texture.pixel_format != framebuffer.pixel_format) {
+                // Reallocate texture if the framebuffer size has changed.
+                // This is expected to not happen very often and hence should not be a
+                // performance problem.
+                ConfigureFramebufferTexture(screen_info.texture, framebuffer);
+            }
+            LoadFBToScreenInfo(framebuffer, screen_info);
         }
 
-        // Load the framebuffer from memory, draw it to the screen, and swap buffers
-        LoadFBToScreenInfo(*framebuffer, screen_info);
-        DrawScreen();
+        // Draw the layers to the screen, and swap buffers at the paced time
+        DrawScreen(layers.size());
+        auto& system = Core::System::GetInstance();
+        Core::PerfStats::SubsystemScope perf_scope(system.perf_stats,
+                                                   Core::PerfStats::Subsystem::PresentWait);
+        system.frame_limiter.DoFramePacing(system.perf_stats.GetPredictedFrameTime());
         render_window->SwapBuffers();
     }
 
     render_window->PollEvents();
 
-    Core::System::GetInstance().frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
+    // Results of the GPU scopes are picked up here, when the driver has them
+    profiler_timer->Collect();
+
+    if (rasterizer != nullptr) {
+        rasterizer->TickFrame();
+    }
+
+    {
+        auto& system = Core::System::GetInstance();
+        Core::PerfStats::SubsystemScope perf_scope(system.perf_stats,
+                                                   Core::PerfStats::Subsystem::PresentWait);
+        system.frame_limiter.DoFrameLimiting(CoreTiming::GetGlobalTimeUs());
+    }
     Core::System::GetInstance().perf_stats.BeginSystemFrame();
 
     // Restore the rasterizer state
@@ -143,7 +177,7 @@ void RendererOpenGL::LoadFBToScreenInfo(const Tegra::FramebufferConfig& framebuf
     const VAddr framebuffer_addr{framebuffer.address + framebuffer.offset};
 
     // Framebuffer orientation handling
-    framebuffer_transform_flags = framebuffer.transform_flags;
+    screen_info.transform_flags = framebuffer.transform_flags;
 
     // Ensure no bad interactions with GL_UNPACK_ALIGNMENT, which by default
     // only allows rows to have a memory alignement of 4.
@@ -157,15 +191,21 @@ void RendererOpenGL::LoadFBToScreenInfo(const Tegra::FramebufferConfig& framebuf
 
         Rasterizer()->FlushRegion(framebuffer_addr, size_in_bytes);
 
-        VideoCore::MortonCopyPixels128(framebuffer.width, framebuffer.height, bytes_per_pixel, 4,
-                                       Memory::GetPointer(framebuffer_addr),
-                                       gl_framebuffer_data.data(), true);
+        // The unswizzled rows are packed, at the width of the framebuffer
+        const size_t upload_size = framebuffer.width * framebuffer.height * 4;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, framebuffer_upload_buffer->GetHandle());
+        const auto [upload_data, upload_offset] = framebuffer_upload_buffer->Map(upload_size, 4);
+        // ABGR8 is the only framebuffer format, and is uploaded as is
+        ASSERT(bytes_per_pixel == 4);
+        VideoCore::MortonCopyPixels128<4, 4>(framebuffer.width, framebuffer.height,
+                                             Memory::GetPointer(framebuffer_addr), upload_data,
+                                             true);
+        framebuffer_upload_buffer->Unmap();
 
         state.texture_units[0].texture_2d = screen_info.texture.resource.handle;
         state.Apply();
 
         glActiveTexture(GL_TEXTURE0);
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(framebuffer.stride));
 
         // Update existing texture
         // TODO: Test what happens on hardware when you change the framebuffer dimensions so that
@@ -174,9 +214,8 @@ void RendererOpenGL::LoadFBToScreenInfo(const Tegra::FramebufferConfig& framebuf
         //       framebuffer sizes. We should make sure that this cannot happen.
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, framebuffer.width, framebuffer.height,
                         screen_info.texture.gl_format, screen_info.texture.gl_type,
-                        gl_framebuffer_data.data());
-
-        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+                        reinterpret_cast<const void*>(upload_offset));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
         state.texture_units[0].texture_2d = 0;
         state.Apply();
@@ -238,6 +277,17 @@ void RendererOpenGL::InitOpenGLObjects() {
     glEnableVertexAttribArray(attrib_position);
     glEnableVertexAttribArray(attrib_tex_coord);
 
+    // Layers over the bottom one are blended with what is under them by their alpha
+    state.blend.rgb_equation = GL_FUNC_ADD;
+    state.blend.a_equation = GL_FUNC_ADD;
+    state.blend.src_rgb_func = GL_SRC_ALPHA;
+    state.blend.dst_rgb_func = GL_ONE_MINUS_SRC_ALPHA;
+    state.blend.src_a_func = GL_ONE;
+    state.blend.dst_a_func = GL_ONE_MINUS_SRC_ALPHA;
+    state.Apply();
+}
+
+void RendererOpenGL::CreateScreenTexture(ScreenInfo& screen_info) {
     // Allocate textures for the screen
     screen_info.texture.resource.Create();
 
@@ -268,6 +318,7 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
 
     texture.width = framebuffer.width;
     texture.height = framebuffer.height;
+    texture.pixel_format = framebuffer.pixel_format;
 
     GLint internal_format;
     switch (framebuffer.pixel_format) {
@@ -276,12 +327,26 @@ void RendererOpenGL::ConfigureFramebufferTexture(TextureInfo& texture,
         internal_format = GL_RGBA;
         texture.gl_format = GL_RGBA;
         texture.gl_type = GL_UNSIGNED_INT_8_8_8_8;
-        gl_framebuffer_data.resize(texture.width * texture.height * 4);
         break;
     default:
         UNREACHABLE();
     }
 
+    // The upload buffer is shared by the layers, and only grows for larger frames
+    const size_t frame_size = texture.width * texture.height * 4;
+    if (frame_size > framebuffer_upload_size) {
+        // The old buffer is unmapped from its target as it's released
+        if (framebuffer_upload_buffer != nullptr) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, framebuffer_upload_buffer->GetHandle());
+            framebuffer_upload_buffer.reset();
+        }
+        framebuffer_upload_buffer =
+            OGLStreamBuffer::MakeBuffer(GLAD_GL_ARB_buffer_storage, GL_PIXEL_UNPACK_BUFFER);
+        framebuffer_upload_buffer->Create(frame_size * 3, frame_size);
+        framebuffer_upload_size = frame_size;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
     state.texture_units[0].texture_2d = texture.resource.handle;
     state.Apply();
 
@@ -298,15 +363,16 @@ void RendererOpenGL::DrawScreenTriangles(const ScreenInfo& screen_info, float x,
     const auto& texcoords = screen_info.display_texcoords;
     auto left = texcoords.left;
     auto right = texcoords.right;
-    if (framebuffer_transform_flags != Tegra::FramebufferConfig::TransformFlags::Unset)
-        if (framebuffer_transform_flags == Tegra::FramebufferConfig::TransformFlags::FlipV) {
+    const auto transform_flags = screen_info.transform_flags;
+    if (transform_flags != Tegra::FramebufferConfig::TransformFlags::Unset)
+        if (transform_flags == Tegra::FramebufferConfig::TransformFlags::FlipV) {
             // Flip the framebuffer vertically
             left = texcoords.right;
             right = texcoords.left;
         } else {
             // Other transformations are unsupported
             LOG_CRITICAL(Render_OpenGL, "Unsupported framebuffer_transform_flags=%d",
-                         framebuffer_transform_flags);
+                         transform_flags);
             UNIMPLEMENTED();
         }
 
@@ -327,10 +393,13 @@ void RendererOpenGL::DrawScreenTriangles(const ScreenInfo& screen_info, float x,
     state.Apply();
 }
 
+MICROPROFILE_DEFINE_GPU(GPU_Present, "Present", MP_RGB(128, 128, 128));
+
 /**
  * Draws the emulated screens to the emulator window.
  */
-void RendererOpenGL::DrawScreen() {
+void RendererOpenGL::DrawScreen(size_t num_layers) {
+    MICROPROFILE_SCOPEGPU(GPU_Present);
     const auto& layout = render_window->GetFramebufferLayout();
     const auto& screen = layout.screen;
 
@@ -346,8 +415,15 @@ void RendererOpenGL::DrawScreen() {
     glActiveTexture(GL_TEXTURE0);
     glUniform1i(uniform_color_texture, 0);
 
-    DrawScreenTriangles(screen_info, (float)screen.left, (float)screen.top,
-                        (float)screen.GetWidth(), (float)screen.GetHeight());
+    // All the layers are drawn in this one pass, straight from their textures. The bottom one is
+    // opaque, and the ones over it are blended in order.
+    for (size_t i = 0; i < num_layers; ++i) {
+        state.blend.enabled = i > 0;
+        DrawScreenTriangles(screen_infos[i], (float)screen.left, (float)screen.top,
+                            (float)screen.GetWidth(), (float)screen.GetHeight());
+    }
+    state.blend.enabled = false;
+    state.Apply();
 
     m_current_frame++;
 }
@@ -443,6 +519,7 @@ bool RendererOpenGL::Init() {
     }
 
     InitOpenGLObjects();
+    profiler_timer = std::make_unique<OGLProfilerTimer>();
 
     RefreshRasterizerSetting();
 
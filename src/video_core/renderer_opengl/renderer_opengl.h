@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 #include <glad/glad.h>
 #include "common/common_types.h"
@@ -11,8 +12,10 @@
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/gl_resource_manager.h"
 #include "video_core/renderer_opengl/gl_state.h"
+#include "video_core/renderer_opengl/gl_stream_buffer.h"
 
 class EmuWindow;
+class OGLProfilerTimer;
 
 /// Structure used for storing information about the textures for the Switch screen
 struct TextureInfo {
@@ -24,10 +27,11 @@ struct TextureInfo {
     Tegra::FramebufferConfig::PixelFormat pixel_format;
 };
 
-/// Structure used for storing information about the display target for the Switch screen
+/// Structure used for storing information about the display target for a layer of the screen
 struct ScreenInfo {
     GLuint display_texture;
     MathUtil::Rectangle<float> display_texcoords;
+    Tegra::FramebufferConfig::TransformFlags transform_flags;
     TextureInfo texture;
 };
 
@@ -37,7 +41,7 @@ public:
     ~RendererOpenGL() override;
 
     /// Swap buffers (render frame)
-    void SwapBuffers(boost::optional<const Tegra::FramebufferConfig&> framebuffer) override;
+    void SwapBuffers(const std::vector<Tegra::FramebufferConfig>& layers) override;
 
     /**
      * Set the emulator window to use for renderer
@@ -55,7 +59,8 @@ private:
     void InitOpenGLObjects();
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const Tegra::FramebufferConfig& framebuffer);
-    void DrawScreen();
+    void CreateScreenTexture(ScreenInfo& screen_info);
+    void DrawScreen(size_t num_layers);
     void DrawScreenTriangles(const ScreenInfo& screen_info, float x, float y, float w, float h);
     void UpdateFramerate();
 
@@ -74,11 +79,21 @@ private:
     OGLBuffer vertex_buffer;
     OGLProgram shader;
 
-    /// Display information for Switch screen
-    ScreenInfo screen_info;
+    /// Display information for each layer of the Switch screen, from the bottom one up. It only
+    /// grows, so the textures of the layers are kept when fewer of them are drawn.
+    std::vector<ScreenInfo> screen_infos;
 
-    /// OpenGL framebuffer data
-    std::vector<u8> gl_framebuffer_data;
+    /// Framebuffers loaded from emulated memory are unswizzled straight into this buffer, and
+    /// uploaded from it. It holds a few of the largest frames, so that loading one doesn't wait
+    /// on the last.
+    std::unique_ptr<OGLStreamBuffer> framebuffer_upload_buffer;
+    size_t framebuffer_upload_size = 0;
+
+    /// Frames swapped so far, to pick the ones presented while fast forwarding
+    u64 frame_count = 0;
+
+    /// Takes the timestamps of the GPU scopes of the profiler
+    std::unique_ptr<OGLProfilerTimer> profiler_timer;
 
     // Shader uniform location indices
     GLuint uniform_modelview_matrix;
@@ -87,7 +102,4 @@ private:
     // Shader attribute input indices
     GLuint attrib_position;
     GLuint attrib_tex_coord;
-
-    /// Used for transforming the framebuffer orientation
-    Tegra::FramebufferConfig::TransformFlags framebuffer_transform_flags;
 };
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <cstring>
 #include "common/assert.h"
 #include "video_core/textures/decoders.h"
@@ -10,12 +11,9 @@
 namespace Tegra {
 namespace Texture {
 
-/**
- * Calculates the offset of an (x, y) position within a swizzled texture.
- * Taken from the Tegra X1 TRM.
- */
-static u32 GetSwizzleOffset(u32 x, u32 y, u32 image_width, u32 bytes_per_pixel, u32 block_height) {
-    u32 image_width_in_gobs = image_width * bytes_per_pixel / 64;
+u32 GetSwizzleOffset(u32 x, u32 y, u32 image_width, u32 bytes_per_pixel, u32 block_height) {
+    // Rows are padded to whole GOBs, like GetSwizzledSize assumes
+    u32 image_width_in_gobs = (image_width * bytes_per_pixel + 63) / 64;
     u32 GOB_address = 0 + (y / (8 * block_height)) * 512 * block_height * image_width_in_gobs +
                       (x * bytes_per_pixel / 64) * 512 * block_height +
                       (y % (8 * block_height) / 8) * 512;
@@ -26,9 +24,74 @@ static u32 GetSwizzleOffset(u32 x, u32 y, u32 image_width, u32 bytes_per_pixel,
     return address;
 }
 
-static void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_per_pixel,
-                             u8* swizzled_data, u8* unswizzled_data, bool unswizzle,
-                             u32 block_height) {
+/**
+ * Copies data between a swizzled and a linear buffer a GOB at a time, for pixels that keep their
+ * size. Each row of a GOB is made of 4 runs of 16 bytes, which are copied with single 16 byte
+ * copies that compile to one vector load and store. Blocks are block_height GOBs high.
+ */
+template <u32 block_height>
+static void CopySwizzledGobs(u32 width_bytes, u32 height, u8* swizzled_data, u8* unswizzled_data,
+                             bool unswizzle) {
+    constexpr u32 gob_size = 512;
+    constexpr u32 block_size = gob_size * block_height;
+    constexpr u32 block_rows = 8 * block_height;
+    const u32 width_in_gobs = (width_bytes + 63) / 64;
+
+    for (u32 block_y = 0; block_y < height; block_y += block_rows) {
+        u8* block_row = swizzled_data + (block_y / block_rows) * width_in_gobs * block_size;
+        for (u32 gob_x = 0; gob_x < width_bytes; gob_x += 64) {
+            u8* const block = block_row + (gob_x / 64) * block_size;
+            const u32 gob_bytes = std::min(64u, width_bytes - gob_x);
+            for (u32 gob_y = 0; gob_y < block_height; ++gob_y) {
+                u8* const gob = block + gob_y * gob_size;
+                const u32 first_row = block_y + gob_y * 8;
+                const u32 rows = std::min(8u, height > first_row ? height - first_row : 0u);
+                for (u32 line = 0; line < rows; ++line) {
+                    u8* const linear = unswizzled_data + (first_row + line) * width_bytes + gob_x;
+                    for (u32 run = 0; run * 16 < gob_bytes; ++run) {
+                        u8* const swizzled = gob + (run / 2) * 256 + (line / 2) * 64 +
+                                             (run % 2) * 32 + (line % 2) * 16;
+                        u8* const dst = unswizzle ? linear + run * 16 : swizzled;
+                        const u8* const src = unswizzle ? swizzled : linear + run * 16;
+                        if (gob_bytes - run * 16 >= 16) {
+                            std::memcpy(dst, src, 16);
+                        } else {
+                            std::memcpy(dst, src, gob_bytes - run * 16);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_per_pixel,
+                      u8* swizzled_data, u8* unswizzled_data, bool unswizzle, u32 block_height) {
+    // The swizzle only moves bytes around, so pixels that keep their size are copied as bytes.
+    if (bytes_per_pixel == out_bytes_per_pixel) {
+        const u32 width_bytes = width * bytes_per_pixel;
+        switch (block_height) {
+        case 1:
+            return CopySwizzledGobs<1>(width_bytes, height, swizzled_data, unswizzled_data,
+                                       unswizzle);
+        case 2:
+            return CopySwizzledGobs<2>(width_bytes, height, swizzled_data, unswizzled_data,
+                                       unswizzle);
+        case 4:
+            return CopySwizzledGobs<4>(width_bytes, height, swizzled_data, unswizzled_data,
+                                       unswizzle);
+        case 8:
+            return CopySwizzledGobs<8>(width_bytes, height, swizzled_data, unswizzled_data,
+                                       unswizzle);
+        case 16:
+            return CopySwizzledGobs<16>(width_bytes, height, swizzled_data, unswizzled_data,
+                                        unswizzle);
+        case 32:
+            return CopySwizzledGobs<32>(width_bytes, height, swizzled_data, unswizzled_data,
+                                        unswizzle);
+        }
+    }
+
     u8* data_ptrs[2];
     for (unsigned y = 0; y < height; ++y) {
         for (unsigned x = 0; x < width; ++x) {
@@ -43,6 +106,13 @@ static void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out
     }
 }
 
+u32 GetSwizzledSize(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height) {
+    // Surfaces are made of whole blocks, each 64 bytes wide and 8 * block_height rows high.
+    const u32 width_in_gobs = (width * bytes_per_pixel + 63) / 64;
+    const u32 rows_in_blocks = (height + 8 * block_height - 1) / (8 * block_height);
+    return width_in_gobs * rows_in_blocks * 512 * block_height;
+}
+
 u32 BytesPerPixel(TextureFormat format) {
     switch (format) {
     case TextureFormat::DXT1:
@@ -50,6 +120,7 @@ u32 BytesPerPixel(TextureFormat format) {
         return 8;
     case TextureFormat::DXT23:
     case TextureFormat::DXT45:
+    case TextureFormat::ASTC_2D_4X4:
         // In this case a 'pixel' actually refers to a 4x4 tile.
         return 16;
     case TextureFormat::A8R8G8B8:
@@ -62,9 +133,25 @@ u32 BytesPerPixel(TextureFormat format) {
     }
 }
 
+u32 GetTextureSwizzledSize(TextureFormat format, u32 width, u32 height, u32 block_height) {
+    switch (format) {
+    case TextureFormat::DXT1:
+    case TextureFormat::DXT23:
+    case TextureFormat::DXT45:
+    case TextureFormat::ASTC_2D_4X4:
+        return GetSwizzledSize(width / 4, height / 4, BytesPerPixel(format), block_height);
+    default:
+        return GetSwizzledSize(width, height, BytesPerPixel(format), block_height);
+    }
+}
+
 std::vector<u8> UnswizzleTexture(VAddr address, TextureFormat format, u32 width, u32 height,
                                  u32 block_height) {
-    u8* data = Memory::GetPointer(address);
+    return UnswizzleTexture(Memory::GetPointer(address), format, width, height, block_height);
+}
+
+std::vector<u8> UnswizzleTexture(u8* data, TextureFormat format, u32 width, u32 height,
+                                 u32 block_height) {
     u32 bytes_per_pixel = BytesPerPixel(format);
 
     std::vector<u8> unswizzled_data(width * height * bytes_per_pixel);
@@ -73,7 +160,9 @@ std::vector<u8> UnswizzleTexture(VAddr address, TextureFormat format, u32 width,
     case TextureFormat::DXT1:
     case TextureFormat::DXT23:
     case TextureFormat::DXT45:
-        // In the DXT formats, each 4x4 tile is swizzled instead of just individual pixel values.
+    case TextureFormat::ASTC_2D_4X4:
+        // In the DXT and ASTC formats, each 4x4 tile is swizzled instead of just individual pixel
+        // values.
         CopySwizzledData(width / 4, height / 4, bytes_per_pixel, bytes_per_pixel, data,
                          unswizzled_data.data(), true, block_height);
         break;
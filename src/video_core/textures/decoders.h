@@ -11,12 +11,56 @@
 namespace Tegra {
 namespace Texture {
 
+/**
+ * Calculates the offset of an (x, y) position within a swizzled (block linear) texture, as given
+ * by the Tegra X1 TRM. Copying one pixel at a time with it is the reference implementation that
+ * the faster copies have to match.
+ * @param x Column of the pixel.
+ * @param y Row of the pixel.
+ * @param image_width Width of the image in pixels.
+ * @param bytes_per_pixel Size of the pixels.
+ * @param block_height Height of the blocks, in GOBs.
+ * @return Offset of the first byte of the pixel.
+ */
+u32 GetSwizzleOffset(u32 x, u32 y, u32 image_width, u32 bytes_per_pixel, u32 block_height);
+
+/**
+ * Copies data between a swizzled (block linear) buffer and a linear one.
+ * @param width Width of the image in pixels.
+ * @param height Height of the image in pixels.
+ * @param bytes_per_pixel Size of the pixels in the swizzled buffer.
+ * @param out_bytes_per_pixel Size of the pixels in the linear buffer.
+ * @param swizzled_data The swizzled buffer.
+ * @param unswizzled_data The linear buffer.
+ * @param unswizzle Whether to copy from the swizzled buffer to the linear one, or the other way.
+ * @param block_height Height of the blocks of the swizzled buffer, in GOBs.
+ */
+void CopySwizzledData(u32 width, u32 height, u32 bytes_per_pixel, u32 out_bytes_per_pixel,
+                      u8* swizzled_data, u8* unswizzled_data, bool unswizzle, u32 block_height);
+
+/**
+ * Returns the size in bytes of a swizzled (block linear) image, which is made of whole blocks.
+ */
+u32 GetSwizzledSize(u32 width, u32 height, u32 bytes_per_pixel, u32 block_height);
+
+/**
+ * Returns the size in bytes of the swizzled data of a texture, as read by UnswizzleTexture.
+ */
+u32 GetTextureSwizzledSize(TextureFormat format, u32 width, u32 height,
+                           u32 block_height = TICEntry::DefaultBlockHeight);
+
 /**
  * Unswizzles a swizzled texture without changing its format.
  */
 std::vector<u8> UnswizzleTexture(VAddr address, TextureFormat format, u32 width, u32 height,
                                  u32 block_height = TICEntry::DefaultBlockHeight);
 
+/**
+ * Unswizzles a swizzled texture held in host memory without changing its format.
+ */
+std::vector<u8> UnswizzleTexture(u8* data, TextureFormat format, u32 width, u32 height,
+                                 u32 block_height = TICEntry::DefaultBlockHeight);
+
 /**
  * Decodes an unswizzled texture into a A8R8G8B8 texture.
  */
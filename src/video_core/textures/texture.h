@@ -19,6 +19,7 @@ enum class TextureFormat : u32 {
     DXT1 = 0x24,
     DXT23 = 0x25,
     DXT45 = 0x26,
+    ASTC_2D_4X4 = 0x40,
 };
 
 enum class TextureType : u32 {
@@ -79,13 +80,20 @@ struct TICEntry {
 
         // High 16 bits of the pitch value
         BitField<0, 16, u32> pitch_high;
+
+        // Index of the smallest level of the mip chain that follows the base level in memory
+        BitField<28, 4, u32> max_mip_level;
     };
     union {
         BitField<0, 16, u32> width_minus_1;
         BitField<23, 4, TextureType> texture_type;
     };
-    u16 height_minus_1;
-    INSERT_PADDING_BYTES(10);
+    union {
+        BitField<0, 16, u32> height_minus_1;
+        // Layers of array textures, or depth of 3D textures
+        BitField<16, 15, u32> depth_minus_1;
+    };
+    INSERT_PADDING_BYTES(8);
 
     GPUVAddr Address() const {
         return static_cast<GPUVAddr>((static_cast<GPUVAddr>(address_high) << 32) | address_low);
@@ -106,6 +114,15 @@ struct TICEntry {
         return height_minus_1 + 1;
     }
 
+    u32 Depth() const {
+        return depth_minus_1 + 1;
+    }
+
+    /// Number of levels in the mip chain, including the base level
+    u32 MipLevels() const {
+        return max_mip_level + 1;
+    }
+
     u32 BlockHeight() const {
         ASSERT(header_version == TICHeaderVersion::BlockLinear ||
                header_version == TICHeaderVersion::BlockLinearColorKey);
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstring>
 #include "common/common_types.h"
 
 namespace VideoCore {
@@ -142,21 +144,49 @@ static inline u32 GetMortonOffset128(u32 x, u32 y, u32 bytes_per_pixel) {
     return (i + offset) * bytes_per_pixel;
 }
 
-static inline void MortonCopyPixels128(u32 width, u32 height, u32 bytes_per_pixel,
-                                       u32 gl_bytes_per_pixel, u8* morton_data, u8* gl_data,
-                                       bool morton_to_gl) {
-    u8* data_ptrs[2];
-    for (unsigned y = 0; y < height; ++y) {
-        for (unsigned x = 0; x < width; ++x) {
-            const u32 coarse_y = y & ~127;
-            u32 morton_offset =
-                GetMortonOffset128(x, y, bytes_per_pixel) + coarse_y * width * bytes_per_pixel;
-            u32 gl_pixel_index = (x + y * width) * gl_bytes_per_pixel;
-
-            data_ptrs[morton_to_gl] = morton_data + morton_offset;
-            data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
-
-            memcpy(data_ptrs[0], data_ptrs[1], bytes_per_pixel);
+/**
+ * Copies an image between 128x128 Morton order and linear rows. Every four horizontally adjacent
+ * pixels starting at a multiple of four are contiguous in Morton order, so each row is walked in
+ * runs of four pixels with a single Morton offset lookup per run. The pixel sizes are template
+ * parameters so that each run is a fixed-size copy, which compiles to a vector load and store.
+ */
+template <u32 bytes_per_pixel, u32 gl_bytes_per_pixel>
+void MortonCopyPixels128(u32 width, u32 height, u8* morton_data, u8* gl_data, bool morton_to_gl) {
+    constexpr u32 run_length = 4;
+
+    const auto copy = [morton_to_gl](u8* morton, u8* gl, size_t size) {
+        if (morton_to_gl) {
+            std::memcpy(gl, morton, size);
+        } else {
+            std::memcpy(morton, gl, size);
+        }
+    };
+
+    for (u32 y = 0; y < height; ++y) {
+        // Offset in pixels of the row within its row of tiles, and of the row of tiles
+        const u32 row_offset = MortonInterleave128(0, y) + (y & ~127) * width;
+        u8* const gl_row = gl_data + y * width * gl_bytes_per_pixel;
+
+        u32 x = 0;
+        for (; x + run_length <= width; x += run_length) {
+            const u32 run_offset = row_offset + MortonInterleave128(x, 0) + (x & ~127) * 128;
+            u8* const morton_run = morton_data + run_offset * bytes_per_pixel;
+            u8* const gl_run = gl_row + x * gl_bytes_per_pixel;
+            if constexpr (bytes_per_pixel == gl_bytes_per_pixel) {
+                copy(morton_run, gl_run, run_length * bytes_per_pixel);
+            } else {
+                for (u32 i = 0; i < run_length; ++i) {
+                    copy(morton_run + i * bytes_per_pixel, gl_run + i * gl_bytes_per_pixel,
+                         bytes_per_pixel);
+                }
+            }
+        }
+
+        // The pixels past the last whole run are copied one at a time
+        for (; x < width; ++x) {
+            const u32 offset = row_offset + MortonInterleave128(x, 0) + (x & ~127) * 128;
+            copy(morton_data + offset * bytes_per_pixel, gl_row + x * gl_bytes_per_pixel,
+                 bytes_per_pixel);
         }
     }
 }
@@ -4,6 +4,7 @@
 
 #include <memory>
 #include "common/logging/log.h"
+#include "core/settings.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
 #include "video_core/video_core.h"
@@ -18,10 +19,23 @@ std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 
 std::atomic<bool> g_toggle_framelimit_enabled;
 
+/// Creates the renderer of the backend chosen in the settings. Backends other than OpenGL
+/// implement RendererBase and RasterizerInterface the same way, and are only added here.
+static std::unique_ptr<RendererBase> CreateRenderer(Settings::RendererBackend backend) {
+    switch (backend) {
+    case Settings::RendererBackend::OpenGL:
+        return std::make_unique<RendererOpenGL>();
+    default:
+        LOG_ERROR(Render, "Unknown renderer backend %u, falling back to OpenGL",
+                  static_cast<u32>(backend));
+        return std::make_unique<RendererOpenGL>();
+    }
+}
+
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
     g_emu_window = emu_window;
-    g_renderer = std::make_unique<RendererOpenGL>();
+    g_renderer = CreateRenderer(Settings::values.renderer_backend);
     g_renderer->SetWindow(g_emu_window);
     if (g_renderer->Init()) {
         LOG_DEBUG(Render, "initialized OK");
@@ -15,8 +15,6 @@ class RendererBase;
 
 namespace VideoCore {
 
-enum class Renderer { Software, OpenGL };
-
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
 extern EmuWindow* g_emu_window;                  ///< Emu window
 
@@ -7,6 +7,7 @@
 #include "common/microprofile.h"
 #include "common/scm_rev.h"
 #include "common/string_util.h"
+#include "common/thread_placement.h"
 #include "core/core.h"
 #include "core/frontend/framebuffer_layout.h"
 #include "core/settings.h"
@@ -21,8 +22,11 @@ void EmuThread::run() {
     render_window->MakeCurrent();
 
     MicroProfileOnThreadCreate("EmuThread");
+    Common::SetCurrentThreadRole(Common::ThreadRole::CPU);
 
-    stop_run = false;
+    Core::System::GetInstance().GPU().LoadDiskResources([this](size_t value, size_t total) {
+        emit LoadProgress(static_cast<int>(value), static_cast<int>(total));
+    });
 
     // holds whether the cpu was running during the last iteration,
     // so that the DebugModeLeft signal can be emitted before the
@@ -42,19 +46,17 @@ void EmuThread::run() {
             was_active = running || exec_step;
             if (!was_active && !stop_run)
                 emit DebugModeEntered();
-        } else if (exec_step) {
+        } else if (exec_step.exchange(false)) {
             if (!was_active)
                 emit DebugModeLeft();
 
-            exec_step = false;
             Core::System::GetInstance().SingleStep();
             emit DebugModeEntered();
             yieldCurrentThread();
 
             was_active = false;
         } else {
-            std::unique_lock<std::mutex> lock(running_mutex);
-            running_cv.wait(lock, [this] { return IsRunning() || exec_step || stop_run; });
+            command_event.Wait();
         }
     }
 
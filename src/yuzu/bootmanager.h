@@ -5,8 +5,6 @@
 #pragma once
 
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
 #include <QGLWidget>
 #include <QThread>
 #include "common/thread.h"
@@ -38,7 +36,7 @@ public:
      */
     void ExecStep() {
         exec_step = true;
-        running_cv.notify_all();
+        command_event.Set();
     }
 
     /**
@@ -47,10 +45,8 @@ public:
      * @note This function is thread-safe
      */
     void SetRunning(bool running) {
-        std::unique_lock<std::mutex> lock(running_mutex);
         this->running = running;
-        lock.unlock();
-        running_cv.notify_all();
+        command_event.Set();
     }
 
     /**
@@ -63,7 +59,9 @@ public:
     }
 
     /**
-     * Requests for the emulation thread to stop running
+     * Requests for the emulation thread to stop running. This doesn't wait for the system to be
+     * shut down, the thread emits finished() once it is done.
+     * @note This function is thread-safe
      */
     void RequestStop() {
         stop_run = true;
@@ -71,11 +69,11 @@ public:
     }
 
 private:
-    bool exec_step = false;
-    bool running = false;
+    std::atomic<bool> exec_step{false};
+    std::atomic<bool> running{false};
     std::atomic<bool> stop_run{false};
-    std::mutex running_mutex;
-    std::condition_variable running_cv;
+    /// Wakes the paused emulation thread after any of the above changed
+    Common::Event command_event;
 
     GRenderWindow* render_window;
 
@@ -99,6 +97,9 @@ signals:
     void DebugModeLeft();
 
     void ErrorThrown(Core::System::ResultStatus, std::string);
+
+    /// Emitted as the shaders kept on disk are built, before the CPU starts
+    void LoadProgress(int value, int total);
 };
 
 class GRenderWindow : public QWidget, public EmuWindow {
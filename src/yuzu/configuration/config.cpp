@@ -73,24 +73,69 @@ void Config::ReadValues() {
             .toStdString();
     Settings::values.touch_device =
         qt_config->value("touch_device", "engine:emu_window").toString().toStdString();
+    Settings::values.pad_update_rate =
+        static_cast<u16>(qt_config->value("pad_update_rate", 1000).toUInt());
 
     qt_config->endGroup();
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = qt_config->value("use_cpu_jit", true).toBool();
+    Settings::values.use_host_timing = qt_config->value("use_host_timing", false).toBool();
+    Settings::values.use_host_thread_placement =
+        qt_config->value("use_host_thread_placement", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    Settings::values.renderer_backend =
+        static_cast<Settings::RendererBackend>(qt_config->value("renderer_backend", 0).toUInt());
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
+    Settings::values.use_dynamic_resolution =
+        qt_config->value("use_dynamic_resolution", false).toBool();
     Settings::values.toggle_framelimit = qt_config->value("toggle_framelimit", true).toBool();
+    Settings::values.use_fast_forward = qt_config->value("use_fast_forward", false).toBool();
+    Settings::values.fast_forward_present_interval =
+        static_cast<u16>(qt_config->value("fast_forward_present_interval", 4).toUInt());
+    Settings::values.frame_rate_target =
+        static_cast<u16>(qt_config->value("frame_rate_target", 0).toUInt());
+    Settings::values.use_asynchronous_gpu_emulation =
+        qt_config->value("use_asynchronous_gpu_emulation", false).toBool();
+    Settings::values.use_lazy_surface_flushes =
+        qt_config->value("use_lazy_surface_flushes", false).toBool();
+    Settings::values.use_asynchronous_queries =
+        qt_config->value("use_asynchronous_queries", false).toBool();
+    Settings::values.present_mode =
+        static_cast<Settings::PresentMode>(qt_config->value("present_mode", 0).toUInt());
+    Settings::values.use_variable_refresh =
+        qt_config->value("use_variable_refresh", false).toBool();
+    Settings::values.use_asynchronous_texture_decoding =
+        qt_config->value("use_asynchronous_texture_decoding", false).toBool();
+    Settings::values.use_gpu_texture_deswizzling =
+        qt_config->value("use_gpu_texture_deswizzling", false).toBool();
+    Settings::values.use_texture_content_hashing =
+        qt_config->value("use_texture_content_hashing", false).toBool();
+    Settings::values.texture_cache_budget = qt_config->value("texture_cache_budget", 2048).toUInt();
+    Settings::values.use_disk_shader_cache =
+        qt_config->value("use_disk_shader_cache", true).toBool();
+    Settings::values.use_asynchronous_shaders =
+        qt_config->value("use_asynchronous_shaders", false).toBool();
 
     Settings::values.bg_red = qt_config->value("bg_red", 0.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 0.0).toFloat();
     Settings::values.bg_blue = qt_config->value("bg_blue", 0.0).toFloat();
     qt_config->endGroup();
 
+    qt_config->beginGroup("Audio");
+    Settings::values.sink_id = qt_config->value("output_engine", "auto").toString().toStdString();
+    Settings::values.enable_audio_stretching =
+        qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.audio_device_id =
+        qt_config->value("output_device", "auto").toString().toStdString();
+    qt_config->endGroup();
+
     qt_config->beginGroup("Data Storage");
     Settings::values.use_virtual_sd = qt_config->value("use_virtual_sd", true).toBool();
+    Settings::values.storage_cache_size = qt_config->value("storage_cache_size", 32).toUInt();
+    Settings::values.use_loader_cache = qt_config->value("use_loader_cache", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -104,6 +149,15 @@ void Config::ReadValues() {
     qt_config->beginGroup("Debugging");
     Settings::values.use_gdbstub = qt_config->value("use_gdbstub", false).toBool();
     Settings::values.gdbstub_port = qt_config->value("gdbstub_port", 24689).toInt();
+    Settings::values.profile_guest_code = qt_config->value("profile_guest_code", false).toBool();
+    Settings::values.profile_timing_events =
+        qt_config->value("profile_timing_events", false).toBool();
+    Settings::values.record_ipc_calls = qt_config->value("record_ipc_calls", false).toBool();
+    Settings::values.record_gpu_trace = qt_config->value("record_gpu_trace", false).toBool();
+    Settings::values.memory_usage_log_interval =
+        qt_config->value("memory_usage_log_interval", 0).toUInt();
+    Settings::values.metrics_export_port =
+        static_cast<u16>(qt_config->value("metrics_export_port", 0).toUInt());
     qt_config->endGroup();
 
     qt_config->beginGroup("UI");
@@ -173,15 +227,39 @@ void Config::SaveValues() {
     }
     qt_config->setValue("motion_device", QString::fromStdString(Settings::values.motion_device));
     qt_config->setValue("touch_device", QString::fromStdString(Settings::values.touch_device));
+    qt_config->setValue("pad_update_rate", Settings::values.pad_update_rate);
     qt_config->endGroup();
 
     qt_config->beginGroup("Core");
     qt_config->setValue("use_cpu_jit", Settings::values.use_cpu_jit);
+    qt_config->setValue("use_host_timing", Settings::values.use_host_timing);
+    qt_config->setValue("use_host_thread_placement", Settings::values.use_host_thread_placement);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
+    qt_config->setValue("renderer_backend", static_cast<u32>(Settings::values.renderer_backend));
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
+    qt_config->setValue("use_dynamic_resolution", Settings::values.use_dynamic_resolution);
     qt_config->setValue("toggle_framelimit", Settings::values.toggle_framelimit);
+    qt_config->setValue("use_fast_forward", Settings::values.use_fast_forward);
+    qt_config->setValue("fast_forward_present_interval",
+                        Settings::values.fast_forward_present_interval);
+    qt_config->setValue("frame_rate_target", Settings::values.frame_rate_target);
+    qt_config->setValue("use_asynchronous_gpu_emulation",
+                        Settings::values.use_asynchronous_gpu_emulation);
+    qt_config->setValue("use_lazy_surface_flushes", Settings::values.use_lazy_surface_flushes);
+    qt_config->setValue("use_asynchronous_queries", Settings::values.use_asynchronous_queries);
+    qt_config->setValue("present_mode", static_cast<u32>(Settings::values.present_mode));
+    qt_config->setValue("use_variable_refresh", Settings::values.use_variable_refresh);
+    qt_config->setValue("use_asynchronous_texture_decoding",
+                        Settings::values.use_asynchronous_texture_decoding);
+    qt_config->setValue("use_gpu_texture_deswizzling",
+                        Settings::values.use_gpu_texture_deswizzling);
+    qt_config->setValue("use_texture_content_hashing",
+                        Settings::values.use_texture_content_hashing);
+    qt_config->setValue("texture_cache_budget", Settings::values.texture_cache_budget);
+    qt_config->setValue("use_disk_shader_cache", Settings::values.use_disk_shader_cache);
+    qt_config->setValue("use_asynchronous_shaders", Settings::values.use_asynchronous_shaders);
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red", (double)Settings::values.bg_red);
@@ -189,8 +267,16 @@ void Config::SaveValues() {
     qt_config->setValue("bg_blue", (double)Settings::values.bg_blue);
     qt_config->endGroup();
 
+    qt_config->beginGroup("Audio");
+    qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
+    qt_config->setValue("enable_audio_stretching", Settings::values.enable_audio_stretching);
+    qt_config->setValue("output_device", QString::fromStdString(Settings::values.audio_device_id));
+    qt_config->endGroup();
+
     qt_config->beginGroup("Data Storage");
     qt_config->setValue("use_virtual_sd", Settings::values.use_virtual_sd);
+    qt_config->setValue("storage_cache_size", Settings::values.storage_cache_size);
+    qt_config->setValue("use_loader_cache", Settings::values.use_loader_cache);
     qt_config->endGroup();
 
     qt_config->beginGroup("System");
@@ -204,6 +290,12 @@ void Config::SaveValues() {
     qt_config->beginGroup("Debugging");
     qt_config->setValue("use_gdbstub", Settings::values.use_gdbstub);
     qt_config->setValue("gdbstub_port", Settings::values.gdbstub_port);
+    qt_config->setValue("profile_guest_code", Settings::values.profile_guest_code);
+    qt_config->setValue("profile_timing_events", Settings::values.profile_timing_events);
+    qt_config->setValue("record_ipc_calls", Settings::values.record_ipc_calls);
+    qt_config->setValue("record_gpu_trace", Settings::values.record_gpu_trace);
+    qt_config->setValue("memory_usage_log_interval", Settings::values.memory_usage_log_interval);
+    qt_config->setValue("metrics_export_port", Settings::values.metrics_export_port);
     qt_config->endGroup();
 
     qt_config->beginGroup("UI");
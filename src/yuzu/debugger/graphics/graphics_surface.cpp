@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <QBoxLayout>
 #include <QComboBox>
 #include <QDebug>
@@ -11,6 +12,8 @@
 #include <QPushButton>
 #include <QScrollArea>
 #include <QSpinBox>
+#include <QTimer>
+#include "common/color.h"
 #include "core/core.h"
 #include "video_core/engines/maxwell_3d.h"
 #include "video_core/gpu.h"
@@ -55,7 +58,8 @@ void SurfacePicture::mouseMoveEvent(QMouseEvent* event) {
 GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Tegra::DebugContext> debug_context,
                                              QWidget* parent)
     : BreakPointObserverDock(debug_context, tr("Maxwell Surface Viewer"), parent),
-      surface_source(Source::RenderTarget0) {
+      surface_source(Source::RenderTarget0), capture_receiver(std::make_shared<CaptureReceiver>()) {
+    capture_receiver->widget = this;
     setObjectName("MaxwellSurface");
 
     surface_source_list = new QComboBox;
@@ -168,6 +172,17 @@ GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Tegra::DebugContext
             SLOT(OnSurfacePickerYChanged(int)));
     connect(save_surface, SIGNAL(clicked()), this, SLOT(SaveSurface()));
 
+    // While the GPU runs, the shown surface is captured again every so often
+    refresh_timer = new QTimer(this);
+    connect(refresh_timer, &QTimer::timeout, this, [this] {
+        const auto context = context_weak.lock();
+        if (isVisible() && !capture_pending && Core::System::GetInstance().IsPoweredOn() &&
+            (context == nullptr || !context->at_breakpoint)) {
+            emit Update();
+        }
+    });
+    refresh_timer->start(500);
+
     auto main_widget = new QWidget;
     auto main_layout = new QVBoxLayout;
     {
@@ -229,22 +244,29 @@ GraphicsSurfaceWidget::GraphicsSurfaceWidget(std::shared_ptr<Tegra::DebugContext
     main_widget->setLayout(main_layout);
     setWidget(main_widget);
 
-    // Load current data - TODO: Make sure this works when emulation is not running
     if (debug_context && debug_context->at_breakpoint) {
         emit Update();
-        widget()->setEnabled(debug_context->at_breakpoint);
-    } else {
-        widget()->setEnabled(false);
     }
 }
 
+GraphicsSurfaceWidget::~GraphicsSurfaceWidget() {
+    std::lock_guard<std::mutex> lock(capture_receiver->mutex);
+    capture_receiver->widget = nullptr;
+}
+
 void GraphicsSurfaceWidget::OnBreakPointHit(Tegra::DebugContext::Event event, void* data) {
     emit Update();
-    widget()->setEnabled(true);
 }
 
-void GraphicsSurfaceWidget::OnResumed() {
-    widget()->setEnabled(false);
+void GraphicsSurfaceWidget::OnResumed() {}
+
+void GraphicsSurfaceWidget::OnSurfaceCaptured(QImage image) {
+    capture_pending = false;
+    if (image.isNull()) {
+        ClearSurface(tr("(no surface cached at this address yet)"));
+        return;
+    }
+    ShowSurface(image);
 }
 
 void GraphicsSurfaceWidget::OnSurfaceSourceChanged(int new_value) {
@@ -318,10 +340,11 @@ void GraphicsSurfaceWidget::Pick(int x, int y) {
 }
 
 void GraphicsSurfaceWidget::OnUpdate() {
+    if (!Core::System::GetInstance().IsPoweredOn()) {
+        return;
+    }
     auto& gpu = Core::System::GetInstance().GPU();
 
-    QPixmap pixmap;
-
     switch (surface_source) {
     case Source::RenderTarget0:
     case Source::RenderTarget1:
@@ -364,40 +387,72 @@ void GraphicsSurfaceWidget::OnUpdate() {
     surface_format_control->setCurrentIndex(static_cast<int>(surface_format));
 
     if (surface_address == 0) {
-        surface_picture_label->hide();
-        surface_info_label->setText(tr("(invalid surface address)"));
-        surface_info_label->setAlignment(Qt::AlignCenter);
-        surface_picker_x_control->setEnabled(false);
-        surface_picker_y_control->setEnabled(false);
-        save_surface->setEnabled(false);
+        ClearSurface(tr("(invalid surface address)"));
         return;
     }
 
     // TODO: Implement a good way to visualize alpha components!
 
-    QImage decoded_image(surface_width, surface_height, QImage::Format_ARGB32);
     VAddr address = gpu.memory_manager->PhysicalToVirtualAddress(surface_address);
 
+    // Only stopped at a breakpoint is the memory safe to decode here. Otherwise the renderer
+    // copies its cached surface out on the GPU, so inspecting it doesn't stall the emulation.
+    const auto context = context_weak.lock();
+    if (context == nullptr || !context->at_breakpoint) {
+        if (capture_pending) {
+            return;
+        }
+        const std::shared_ptr<CaptureReceiver> receiver = capture_receiver;
+        const auto on_captured = [receiver](Tegra::SurfaceCapture capture) {
+            // Called on the GPU thread, which also does the conversion
+            QImage image;
+            if (!capture.rgba8.empty()) {
+                image = QImage(capture.width, capture.height, QImage::Format_ARGB32);
+                for (u32 y = 0; y < capture.height; ++y) {
+                    Color::ConvertRGBA8ToARGB32(capture.rgba8.data() + y * capture.width * 4,
+                                                reinterpret_cast<u32*>(image.scanLine(y)),
+                                                capture.width);
+                }
+            }
+            std::lock_guard<std::mutex> lock(receiver->mutex);
+            if (receiver->widget != nullptr) {
+                QMetaObject::invokeMethod(receiver->widget, "OnSurfaceCaptured",
+                                          Qt::QueuedConnection, Q_ARG(QImage, image));
+            }
+        };
+        capture_pending = gpu.RequestSurfaceCapture(address, on_captured);
+        if (!capture_pending) {
+            ClearSurface(tr("(the renderer can't capture surfaces while running)"));
+        }
+        return;
+    }
+
+    QImage decoded_image(surface_width, surface_height, QImage::Format_ARGB32);
+
     auto unswizzled_data =
         Tegra::Texture::UnswizzleTexture(address, surface_format, surface_width, surface_height);
 
     auto texture_data = Tegra::Texture::DecodeTexture(unswizzled_data, surface_format,
                                                       surface_width, surface_height);
 
-    surface_picture_label->show();
-
-    for (unsigned int y = 0; y < surface_height; ++y) {
-        for (unsigned int x = 0; x < surface_width; ++x) {
-            Math::Vec4<u8> color;
-            color[0] = texture_data[x + y * surface_width + 0];
-            color[1] = texture_data[x + y * surface_width + 1];
-            color[2] = texture_data[x + y * surface_width + 2];
-            color[3] = texture_data[x + y * surface_width + 3];
-            decoded_image.setPixel(x, y, qRgba(color.r(), color.g(), color.b(), color.a()));
-        }
+    // Formats that aren't decoded yet come back with fewer than 4 bytes per pixel, so only the rows
+    // that are fully there are shown
+    const size_t row_bytes = surface_width * 4;
+    const unsigned int decoded_rows =
+        row_bytes == 0 ? 0 : std::min<size_t>(surface_height, texture_data.size() / row_bytes);
+    decoded_image.fill(0);
+    for (unsigned int y = 0; y < decoded_rows; ++y) {
+        Color::ConvertRGBA8ToARGB32(texture_data.data() + y * row_bytes,
+                                    reinterpret_cast<u32*>(decoded_image.scanLine(y)),
+                                    surface_width);
     }
 
-    pixmap = QPixmap::fromImage(decoded_image);
+    ShowSurface(decoded_image);
+}
+
+void GraphicsSurfaceWidget::ShowSurface(const QImage& image) {
+    const QPixmap pixmap = QPixmap::fromImage(image);
+    surface_picture_label->show();
     surface_picture_label->setPixmap(pixmap);
     surface_picture_label->resize(pixmap.size());
 
@@ -410,6 +465,15 @@ void GraphicsSurfaceWidget::OnUpdate() {
     save_surface->setEnabled(true);
 }
 
+void GraphicsSurfaceWidget::ClearSurface(const QString& message) {
+    surface_picture_label->hide();
+    surface_info_label->setText(message);
+    surface_info_label->setAlignment(Qt::AlignCenter);
+    surface_picker_x_control->setEnabled(false);
+    surface_picker_y_control->setEnabled(false);
+    save_surface->setEnabled(false);
+}
+
 void GraphicsSurfaceWidget::SaveSurface() {
     QString png_filter = tr("Portable Network Graphic (*.png)");
     QString bin_filter = tr("Binary data (*.bin)");
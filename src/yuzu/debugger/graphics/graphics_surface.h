@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <QImage>
 #include <QLabel>
 #include <QPushButton>
 #include "video_core/memory_manager.h"
@@ -12,6 +15,7 @@
 
 class QComboBox;
 class QSpinBox;
+class QTimer;
 class CSpinBox;
 
 class GraphicsSurfaceWidget;
@@ -53,6 +57,7 @@ class GraphicsSurfaceWidget : public BreakPointObserverDock {
 public:
     explicit GraphicsSurfaceWidget(std::shared_ptr<Tegra::DebugContext> debug_context,
                                    QWidget* parent = nullptr);
+    ~GraphicsSurfaceWidget() override;
     void Pick(int x, int y);
 
 public slots:
@@ -68,6 +73,7 @@ public slots:
 private slots:
     void OnBreakPointHit(Tegra::DebugContext::Event event, void* data) override;
     void OnResumed() override;
+    void OnSurfaceCaptured(QImage image);
 
     void SaveSurface();
 
@@ -75,6 +81,15 @@ signals:
     void Update();
 
 private:
+    void ShowSurface(const QImage& image);
+    void ClearSurface(const QString& message);
+
+    /// Shared with the capture callbacks, which run on the GPU thread and can outlive the widget
+    struct CaptureReceiver {
+        std::mutex mutex;
+        GraphicsSurfaceWidget* widget = nullptr;
+    };
+
     QComboBox* surface_source_list;
     CSpinBox* surface_address_control;
     QSpinBox* surface_width_control;
@@ -94,4 +109,8 @@ private:
     Tegra::Texture::TextureFormat surface_format;
     int surface_picker_x = 0;
     int surface_picker_y = 0;
+
+    QTimer* refresh_timer;
+    std::shared_ptr<CaptureReceiver> capture_receiver;
+    bool capture_pending = false;
 };
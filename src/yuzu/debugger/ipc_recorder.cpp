@@ -0,0 +1,160 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <QCheckBox>
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include "core/hle/service/ipc_recorder.h"
+#include "core/settings.h"
+#include "yuzu/debugger/ipc_recorder.h"
+
+namespace {
+
+enum Column {
+    COLUMN_SERVICE,
+    COLUMN_COMMAND,
+    COLUMN_FUNCTION,
+    COLUMN_CALLS,
+    COLUMN_TOTAL_TIME,
+    COLUMN_MEAN_TIME,
+    COLUMN_P99_TIME,
+    COLUMN_MAX_TIME,
+    COLUMN_BYTES_IN,
+    COLUMN_BYTES_OUT,
+    COLUMN_COUNT,
+};
+
+using Service::IPCRecorder::CommandStats;
+
+qulonglong ToMicroseconds(std::chrono::nanoseconds time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time).count();
+}
+
+/// The host time 99% of the calls stayed under, as the upper bound of its histogram bucket.
+qulonglong P99Microseconds(const CommandStats& stats) {
+    const qulonglong max_us = ToMicroseconds(stats.max_host_time);
+    const u64 target = (stats.num_calls * 99 + 99) / 100;
+    u64 count = 0;
+    for (size_t bucket = 0; bucket < stats.latency.size() - 1; ++bucket) {
+        count += stats.latency[bucket];
+        if (count >= target) {
+            const qulonglong upper_bound = bucket == 0 ? 0 : (qulonglong(1) << bucket) - 1;
+            return std::min(upper_bound, max_us);
+        }
+    }
+    return max_us;
+}
+
+} // Anonymous namespace
+
+IPCRecorderWidget::IPCRecorderWidget(QWidget* parent)
+    : QDockWidget(tr("IPC Statistics"), parent) {
+    setObjectName("IPCRecorderWidget");
+
+    record_checkbox = new QCheckBox(tr("Record"));
+    QPushButton* reset_button = new QPushButton(tr("Reset"));
+    QPushButton* save_button = new QPushButton(tr("Save CSV..."));
+
+    tree = new QTreeWidget;
+    tree->setColumnCount(COLUMN_COUNT);
+    tree->setHeaderLabels({tr("Service"), tr("Command"), tr("Function"), tr("Calls"),
+                           tr("Total (us)"), tr("Mean (us)"), tr("P99 (us)"), tr("Max (us)"),
+                           tr("Bytes in"), tr("Bytes out")});
+    tree->setRootIsDecorated(false);
+    tree->setSortingEnabled(true);
+    tree->sortByColumn(COLUMN_TOTAL_TIME, Qt::DescendingOrder);
+    tree->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QHBoxLayout* controls_layout = new QHBoxLayout;
+    controls_layout->addWidget(record_checkbox);
+    controls_layout->addStretch();
+    controls_layout->addWidget(reset_button);
+    controls_layout->addWidget(save_button);
+
+    QWidget* main_widget = new QWidget;
+    QVBoxLayout* main_layout = new QVBoxLayout;
+    main_layout->addLayout(controls_layout);
+    main_layout->addWidget(tree);
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+
+    connect(record_checkbox, &QCheckBox::toggled,
+            [](bool checked) { Service::IPCRecorder::SetEnabled(checked); });
+    connect(reset_button, &QPushButton::clicked, this, &IPCRecorderWidget::OnReset);
+    connect(save_button, &QPushButton::clicked, this, &IPCRecorderWidget::OnSaveCSV);
+    connect(&update_timer, &QTimer::timeout, this, &IPCRecorderWidget::Refresh);
+
+    setEnabled(false);
+}
+
+void IPCRecorderWidget::OnEmulationStarting(EmuThread* emu_thread) {
+    record_checkbox->setChecked(Settings::values.record_ipc_calls);
+    tree->clear();
+    setEnabled(true);
+}
+
+void IPCRecorderWidget::OnEmulationStopping() {
+    setEnabled(false);
+}
+
+void IPCRecorderWidget::showEvent(QShowEvent* ev) {
+    update_timer.start(1000);
+    Refresh();
+    QDockWidget::showEvent(ev);
+}
+
+void IPCRecorderWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void IPCRecorderWidget::Refresh() {
+    if (!isEnabled()) {
+        return;
+    }
+
+    tree->setSortingEnabled(false);
+    tree->clear();
+    for (const CommandStats& stats : Service::IPCRecorder::GetStats()) {
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(COLUMN_SERVICE, QString::fromStdString(stats.service_name));
+        item->setData(COLUMN_COMMAND, Qt::DisplayRole, stats.command_id);
+        item->setText(COLUMN_FUNCTION, QString::fromStdString(stats.function_name));
+        item->setData(COLUMN_CALLS, Qt::DisplayRole, qulonglong(stats.num_calls));
+        item->setData(COLUMN_TOTAL_TIME, Qt::DisplayRole, ToMicroseconds(stats.host_time));
+        item->setData(COLUMN_MEAN_TIME, Qt::DisplayRole,
+                      ToMicroseconds(stats.host_time / stats.num_calls));
+        item->setData(COLUMN_P99_TIME, Qt::DisplayRole, P99Microseconds(stats));
+        item->setData(COLUMN_MAX_TIME, Qt::DisplayRole, ToMicroseconds(stats.max_host_time));
+        item->setData(COLUMN_BYTES_IN, Qt::DisplayRole, qulonglong(stats.bytes_in));
+        item->setData(COLUMN_BYTES_OUT, Qt::DisplayRole, qulonglong(stats.bytes_out));
+        tree->addTopLevelItem(item);
+    }
+    tree->setSortingEnabled(true);
+}
+
+void IPCRecorderWidget::OnReset() {
+    Service::IPCRecorder::Reset();
+    Refresh();
+}
+
+void IPCRecorderWidget::OnSaveCSV() {
+    const QString filename = QFileDialog::getSaveFileName(
+        this, tr("Save IPC Statistics"), "ipc_calls.csv", tr("CSV files (*.csv)"));
+    if (filename.isEmpty()) {
+        // If the user canceled the dialog, don't save anything.
+        return;
+    }
+
+    if (!Service::IPCRecorder::WriteCSV(filename.toStdString())) {
+        QMessageBox::critical(this, tr("Save IPC Statistics"),
+                              tr("Could not write to %1.").arg(filename));
+    }
+}
@@ -0,0 +1,39 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class EmuThread;
+class QCheckBox;
+class QTreeWidget;
+
+/// Shows the per-command statistics collected by Service::IPCRecorder.
+class IPCRecorderWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit IPCRecorderWidget(QWidget* parent = nullptr);
+
+public slots:
+    void OnEmulationStarting(EmuThread* emu_thread);
+    void OnEmulationStopping();
+
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private:
+    void Refresh();
+    void OnReset();
+    void OnSaveCSV();
+
+    QCheckBox* record_checkbox;
+    QTreeWidget* tree;
+    /// Refreshes the statistics periodically. To save resources, it only runs while the widget is
+    /// visible.
+    QTimer update_timer;
+};
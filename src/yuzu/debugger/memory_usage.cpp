@@ -0,0 +1,85 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include "common/memory_usage.h"
+#include "yuzu/debugger/memory_usage.h"
+
+namespace {
+
+enum Column {
+    COLUMN_NAME,
+    COLUMN_SIZE,
+    COLUMN_COUNT,
+};
+
+qulonglong ToKiB(u64 bytes) {
+    return bytes / 1024;
+}
+
+} // Anonymous namespace
+
+MemoryUsageWidget::MemoryUsageWidget(QWidget* parent) : QDockWidget(tr("Memory Usage"), parent) {
+    setObjectName("MemoryUsageWidget");
+
+    resident_label = new QLabel;
+    QPushButton* log_button = new QPushButton(tr("Write to Log"));
+
+    tree = new QTreeWidget;
+    tree->setColumnCount(COLUMN_COUNT);
+    tree->setHeaderLabels({tr("Counter"), tr("Size (KiB)")});
+    tree->setRootIsDecorated(false);
+    tree->setSortingEnabled(true);
+    tree->sortByColumn(COLUMN_SIZE, Qt::DescendingOrder);
+    tree->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    QHBoxLayout* controls_layout = new QHBoxLayout;
+    controls_layout->addWidget(resident_label);
+    controls_layout->addStretch();
+    controls_layout->addWidget(log_button);
+
+    QWidget* main_widget = new QWidget;
+    QVBoxLayout* main_layout = new QVBoxLayout;
+    main_layout->addLayout(controls_layout);
+    main_layout->addWidget(tree);
+    main_widget->setLayout(main_layout);
+    setWidget(main_widget);
+
+    connect(log_button, &QPushButton::clicked, [] { Common::LogMemoryUsage(); });
+    connect(&update_timer, &QTimer::timeout, this, &MemoryUsageWidget::Refresh);
+}
+
+void MemoryUsageWidget::showEvent(QShowEvent* ev) {
+    update_timer.start(1000);
+    Refresh();
+    QDockWidget::showEvent(ev);
+}
+
+void MemoryUsageWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void MemoryUsageWidget::Refresh() {
+    u64 accounted = 0;
+    tree->setSortingEnabled(false);
+    tree->clear();
+    for (const Common::MemoryUsageEntry& entry : Common::GetMemoryUsage()) {
+        QTreeWidgetItem* item = new QTreeWidgetItem;
+        item->setText(COLUMN_NAME, QString::fromUtf8(entry.name));
+        item->setData(COLUMN_SIZE, Qt::DisplayRole, ToKiB(entry.bytes));
+        tree->addTopLevelItem(item);
+        accounted += entry.bytes;
+    }
+    tree->setSortingEnabled(true);
+
+    resident_label->setText(tr("Resident: %1 KiB, accounted for: %2 KiB")
+                                .arg(ToKiB(Common::GetResidentMemory()))
+                                .arg(ToKiB(accounted)));
+}
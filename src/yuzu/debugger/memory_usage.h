@@ -0,0 +1,32 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <QDockWidget>
+#include <QTimer>
+
+class QLabel;
+class QTreeWidget;
+
+/// Shows the host memory counted by each Common::MemoryUsageCounter.
+class MemoryUsageWidget : public QDockWidget {
+    Q_OBJECT
+
+public:
+    explicit MemoryUsageWidget(QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
+private:
+    void Refresh();
+
+    QLabel* resident_label;
+    QTreeWidget* tree;
+    /// Refreshes the counters periodically. To save resources, it only runs while the widget is
+    /// visible.
+    QTimer update_timer;
+};
@@ -6,12 +6,8 @@
 #include "yuzu/util/util.h"
 
 #include "core/core.h"
-#include "core/hle/kernel/condition_variable.h"
-#include "core/hle/kernel/event.h"
-#include "core/hle/kernel/mutex.h"
+#include "core/hle/kernel/snapshot.h"
 #include "core/hle/kernel/thread.h"
-#include "core/hle/kernel/timer.h"
-#include "core/hle/kernel/wait_object.h"
 
 WaitTreeItem::~WaitTreeItem() {}
 
@@ -50,12 +46,14 @@ std::size_t WaitTreeItem::Row() const {
     return row;
 }
 
-std::vector<std::unique_ptr<WaitTreeThread>> WaitTreeItem::MakeThreadItemList() {
-    const auto& threads = Core::System::GetInstance().Scheduler().GetThreadList();
+std::vector<std::unique_ptr<WaitTreeThread>> WaitTreeItem::MakeThreadItemList(
+    const Kernel::KernelSnapshot& snapshot) {
+    const auto& threads = snapshot.thread_list;
     std::vector<std::unique_ptr<WaitTreeThread>> item_list;
     item_list.reserve(threads.size());
     for (std::size_t i = 0; i < threads.size(); ++i) {
-        item_list.push_back(std::make_unique<WaitTreeThread>(*threads[i]));
+        item_list.push_back(
+            std::make_unique<WaitTreeThread>(snapshot.threads.at(threads[i]), snapshot));
         item_list.back()->row = i;
     }
     return item_list;
@@ -67,7 +65,9 @@ QString WaitTreeText::GetText() const {
     return text;
 }
 
-WaitTreeWaitObject::WaitTreeWaitObject(const Kernel::WaitObject& o) : object(o) {}
+WaitTreeWaitObject::WaitTreeWaitObject(const Kernel::WaitObjectSnapshot& o,
+                                       const Kernel::KernelSnapshot& snapshot)
+    : object(o), snapshot(snapshot) {}
 
 bool WaitTreeExpandableItem::IsExpandable() const {
     return true;
@@ -75,37 +75,37 @@ bool WaitTreeExpandableItem::IsExpandable() const {
 
 QString WaitTreeWaitObject::GetText() const {
     return tr("[%1]%2 %3")
-        .arg(object.GetObjectId())
-        .arg(QString::fromStdString(object.GetTypeName()),
-             QString::fromStdString(object.GetName()));
+        .arg(object.object_id)
+        .arg(QString::fromStdString(object.type_name), QString::fromStdString(object.name));
 }
 
-std::unique_ptr<WaitTreeWaitObject> WaitTreeWaitObject::make(const Kernel::WaitObject& object) {
-    switch (object.GetHandleType()) {
+std::unique_ptr<WaitTreeWaitObject> WaitTreeWaitObject::make(
+    u32 object_id, const Kernel::KernelSnapshot& snapshot) {
+    const Kernel::WaitObjectSnapshot& object = snapshot.objects.at(object_id);
+    switch (object.handle_type) {
     case Kernel::HandleType::Event:
-        return std::make_unique<WaitTreeEvent>(static_cast<const Kernel::Event&>(object));
+        return std::make_unique<WaitTreeEvent>(object, snapshot);
     case Kernel::HandleType::Mutex:
-        return std::make_unique<WaitTreeMutex>(static_cast<const Kernel::Mutex&>(object));
+        return std::make_unique<WaitTreeMutex>(object, snapshot);
     case Kernel::HandleType::ConditionVariable:
-        return std::make_unique<WaitTreeConditionVariable>(
-            static_cast<const Kernel::ConditionVariable&>(object));
+        return std::make_unique<WaitTreeConditionVariable>(object, snapshot);
     case Kernel::HandleType::Timer:
-        return std::make_unique<WaitTreeTimer>(static_cast<const Kernel::Timer&>(object));
+        return std::make_unique<WaitTreeTimer>(object, snapshot);
     case Kernel::HandleType::Thread:
-        return std::make_unique<WaitTreeThread>(static_cast<const Kernel::Thread&>(object));
+        return std::make_unique<WaitTreeThread>(snapshot.threads.at(object_id), snapshot);
     default:
-        return std::make_unique<WaitTreeWaitObject>(object);
+        return std::make_unique<WaitTreeWaitObject>(object, snapshot);
     }
 }
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeWaitObject::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list;
 
-    const auto& threads = object.GetWaitingThreads();
+    const auto& threads = object.waiting_threads;
     if (threads.empty()) {
         list.push_back(std::make_unique<WaitTreeText>(tr("waited by no thread")));
     } else {
-        list.push_back(std::make_unique<WaitTreeThreadList>(threads));
+        list.push_back(std::make_unique<WaitTreeThreadList>(threads, snapshot));
     }
     return list;
 }
@@ -121,9 +121,9 @@ QString WaitTreeWaitObject::GetResetTypeQString(Kernel::ResetType reset_type) {
     }
 }
 
-WaitTreeObjectList::WaitTreeObjectList(
-    const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& list, bool w_all)
-    : object_list(list), wait_all(w_all) {}
+WaitTreeObjectList::WaitTreeObjectList(const std::vector<u32>& list, bool w_all,
+                                       const Kernel::KernelSnapshot& snapshot)
+    : object_list(list), wait_all(w_all), snapshot(snapshot) {}
 
 QString WaitTreeObjectList::GetText() const {
     if (wait_all)
@@ -134,14 +134,15 @@ QString WaitTreeObjectList::GetText() const {
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeObjectList::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(object_list.size());
     std::transform(object_list.begin(), object_list.end(), list.begin(),
-                   [](const auto& t) { return WaitTreeWaitObject::make(*t); });
+                   [this](u32 id) { return WaitTreeWaitObject::make(id, snapshot); });
     return list;
 }
 
-WaitTreeThread::WaitTreeThread(const Kernel::Thread& thread) : WaitTreeWaitObject(thread) {}
+WaitTreeThread::WaitTreeThread(const Kernel::ThreadSnapshot& thread,
+                               const Kernel::KernelSnapshot& snapshot)
+    : WaitTreeWaitObject(snapshot.objects.at(thread.object_id), snapshot), thread(thread) {}
 
 QString WaitTreeThread::GetText() const {
-    const auto& thread = static_cast<const Kernel::Thread&>(object);
     QString status;
     switch (thread.status) {
     case THREADSTATUS_RUNNING:
@@ -168,13 +169,12 @@ QString WaitTreeThread::GetText() const {
         break;
     }
     QString pc_info = tr(" PC = 0x%1 LR = 0x%2")
-                          .arg(thread.context.pc, 8, 16, QLatin1Char('0'))
-                          .arg(thread.context.cpu_registers[30], 8, 16, QLatin1Char('0'));
+                          .arg(thread.pc, 8, 16, QLatin1Char('0'))
+                          .arg(thread.lr, 8, 16, QLatin1Char('0'));
     return WaitTreeWaitObject::GetText() + pc_info + " (" + status + ") ";
 }
 
 QColor WaitTreeThread::GetColor() const {
-    const auto& thread = static_cast<const Kernel::Thread&>(object);
     switch (thread.status) {
     case THREADSTATUS_RUNNING:
         return QColor(Qt::GlobalColor::darkGreen);
@@ -199,8 +199,6 @@ QColor WaitTreeThread::GetColor() const {
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThread::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(WaitTreeWaitObject::GetChildren());
 
-    const auto& thread = static_cast<const Kernel::Thread&>(object);
-
     QString processor;
     switch (thread.processor_id) {
     case ThreadProcessorId::THREADPROCESSORID_DEFAULT:
@@ -218,7 +216,7 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThread::GetChildren() const {
     }
 
     list.push_back(std::make_unique<WaitTreeText>(tr("processor = %1").arg(processor)));
-    list.push_back(std::make_unique<WaitTreeText>(tr("thread id = %1").arg(thread.GetThreadId())));
+    list.push_back(std::make_unique<WaitTreeText>(tr("thread id = %1").arg(thread.thread_id)));
     list.push_back(std::make_unique<WaitTreeText>(tr("priority = %1(current) / %2(normal)")
                                                       .arg(thread.current_priority)
                                                       .arg(thread.nominal_priority)));
@@ -228,74 +226,77 @@ std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThread::GetChildren() const {
     if (thread.held_mutexes.empty()) {
         list.push_back(std::make_unique<WaitTreeText>(tr("not holding mutex")));
     } else {
-        list.push_back(std::make_unique<WaitTreeMutexList>(thread.held_mutexes));
+        list.push_back(std::make_unique<WaitTreeMutexList>(thread.held_mutexes, snapshot));
     }
     if (thread.status == THREADSTATUS_WAIT_SYNCH_ANY ||
         thread.status == THREADSTATUS_WAIT_SYNCH_ALL) {
-        list.push_back(std::make_unique<WaitTreeObjectList>(thread.wait_objects,
-                                                            thread.IsSleepingOnWaitAll()));
+        list.push_back(
+            std::make_unique<WaitTreeObjectList>(thread.wait_objects, thread.wait_all, snapshot));
     }
 
     return list;
 }
 
-WaitTreeEvent::WaitTreeEvent(const Kernel::Event& object) : WaitTreeWaitObject(object) {}
+WaitTreeEvent::WaitTreeEvent(const Kernel::WaitObjectSnapshot& object,
+                             const Kernel::KernelSnapshot& snapshot)
+    : WaitTreeWaitObject(object, snapshot) {}
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeEvent::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(WaitTreeWaitObject::GetChildren());
 
     list.push_back(std::make_unique<WaitTreeText>(
-        tr("reset type = %1")
-            .arg(GetResetTypeQString(static_cast<const Kernel::Event&>(object).reset_type))));
+        tr("reset type = %1").arg(GetResetTypeQString(object.reset_type))));
     return list;
 }
 
-WaitTreeMutex::WaitTreeMutex(const Kernel::Mutex& object) : WaitTreeWaitObject(object) {}
+WaitTreeMutex::WaitTreeMutex(const Kernel::WaitObjectSnapshot& object,
+                             const Kernel::KernelSnapshot& snapshot)
+    : WaitTreeWaitObject(object, snapshot) {}
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeMutex::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(WaitTreeWaitObject::GetChildren());
 
-    const auto& mutex = static_cast<const Kernel::Mutex&>(object);
-    if (mutex.GetHasWaiters()) {
+    if (object.holding_thread != 0) {
         list.push_back(std::make_unique<WaitTreeText>(tr("locked by thread:")));
-        list.push_back(std::make_unique<WaitTreeThread>(*mutex.GetHoldingThread()));
+        list.push_back(std::make_unique<WaitTreeThread>(
+            snapshot.threads.at(object.holding_thread), snapshot));
     } else {
         list.push_back(std::make_unique<WaitTreeText>(tr("free")));
     }
     return list;
 }
 
-WaitTreeConditionVariable::WaitTreeConditionVariable(const Kernel::ConditionVariable& object)
-    : WaitTreeWaitObject(object) {}
+WaitTreeConditionVariable::WaitTreeConditionVariable(const Kernel::WaitObjectSnapshot& object,
+                                                     const Kernel::KernelSnapshot& snapshot)
+    : WaitTreeWaitObject(object, snapshot) {}
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeConditionVariable::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(WaitTreeWaitObject::GetChildren());
 
-    const auto& condition_variable = static_cast<const Kernel::ConditionVariable&>(object);
     list.push_back(std::make_unique<WaitTreeText>(
-        tr("available count = %1").arg(condition_variable.GetAvailableCount())));
+        tr("available count = %1").arg(object.available_count)));
     return list;
 }
 
-WaitTreeTimer::WaitTreeTimer(const Kernel::Timer& object) : WaitTreeWaitObject(object) {}
+WaitTreeTimer::WaitTreeTimer(const Kernel::WaitObjectSnapshot& object,
+                             const Kernel::KernelSnapshot& snapshot)
+    : WaitTreeWaitObject(object, snapshot) {}
 
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeTimer::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(WaitTreeWaitObject::GetChildren());
 
-    const auto& timer = static_cast<const Kernel::Timer&>(object);
-
     list.push_back(std::make_unique<WaitTreeText>(
-        tr("reset type = %1").arg(GetResetTypeQString(timer.reset_type))));
+        tr("reset type = %1").arg(GetResetTypeQString(object.reset_type))));
     list.push_back(
-        std::make_unique<WaitTreeText>(tr("initial delay = %1").arg(timer.initial_delay)));
+        std::make_unique<WaitTreeText>(tr("initial delay = %1").arg(object.initial_delay)));
     list.push_back(
-        std::make_unique<WaitTreeText>(tr("interval delay = %1").arg(timer.interval_delay)));
+        std::make_unique<WaitTreeText>(tr("interval delay = %1").arg(object.interval_delay)));
     return list;
 }
 
-WaitTreeMutexList::WaitTreeMutexList(
-    const boost::container::flat_set<Kernel::SharedPtr<Kernel::Mutex>>& list)
-    : mutex_list(list) {}
+WaitTreeMutexList::WaitTreeMutexList(const std::vector<u32>& list,
+                                     const Kernel::KernelSnapshot& snapshot)
+    : mutex_list(list), snapshot(snapshot) {}
 
 QString WaitTreeMutexList::GetText() const {
     return tr("holding mutexes");
@@ -304,12 +305,15 @@ QString WaitTreeMutexList::GetText() const {
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeMutexList::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(mutex_list.size());
     std::transform(mutex_list.begin(), mutex_list.end(), list.begin(),
-                   [](const auto& t) { return std::make_unique<WaitTreeMutex>(*t); });
+                   [this](u32 id) {
+                       return std::make_unique<WaitTreeMutex>(snapshot.objects.at(id), snapshot);
+                   });
     return list;
 }
 
-WaitTreeThreadList::WaitTreeThreadList(const std::vector<Kernel::SharedPtr<Kernel::Thread>>& list)
-    : thread_list(list) {}
+WaitTreeThreadList::WaitTreeThreadList(const std::vector<u32>& list,
+                                       const Kernel::KernelSnapshot& snapshot)
+    : thread_list(list), snapshot(snapshot) {}
 
 QString WaitTreeThreadList::GetText() const {
     return tr("waited by thread");
@@ -318,7 +322,9 @@ QString WaitTreeThreadList::GetText() const {
 std::vector<std::unique_ptr<WaitTreeItem>> WaitTreeThreadList::GetChildren() const {
     std::vector<std::unique_ptr<WaitTreeItem>> list(thread_list.size());
     std::transform(thread_list.begin(), thread_list.end(), list.begin(),
-                   [](const auto& t) { return std::make_unique<WaitTreeThread>(*t); });
+                   [this](u32 id) {
+                       return std::make_unique<WaitTreeThread>(snapshot.threads.at(id), snapshot);
+                   });
     return list;
 }
 
@@ -376,11 +382,23 @@ QVariant WaitTreeModel::data(const QModelIndex& index, int role) const {
 }
 
 void WaitTreeModel::ClearItems() {
+    beginResetModel();
+    thread_items.clear();
+    snapshot = nullptr;
+    endResetModel();
+}
+
+void WaitTreeModel::InitItems(std::shared_ptr<const Kernel::KernelSnapshot> new_snapshot) {
+    beginResetModel();
+    // The old items refer to the old snapshot, so they have to go first
     thread_items.clear();
+    snapshot = std::move(new_snapshot);
+    thread_items = WaitTreeItem::MakeThreadItemList(*snapshot);
+    endResetModel();
 }
 
-void WaitTreeModel::InitItems() {
-    thread_items = WaitTreeItem::MakeThreadItemList();
+const std::shared_ptr<const Kernel::KernelSnapshot>& WaitTreeModel::GetSnapshot() const {
+    return snapshot;
 }
 
 WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), parent) {
@@ -389,30 +407,90 @@ WaitTreeWidget::WaitTreeWidget(QWidget* parent) : QDockWidget(tr("Wait Tree"), p
     view->setHeaderHidden(true);
     setWidget(view);
     setEnabled(false);
+
+    connect(&update_timer, &QTimer::timeout, this, &WaitTreeWidget::Refresh);
+}
+
+void WaitTreeWidget::showEvent(QShowEvent* ev) {
+    update_timer.start(1000);
+    Kernel::RequestSnapshot();
+    QDockWidget::showEvent(ev);
+}
+
+void WaitTreeWidget::hideEvent(QHideEvent* ev) {
+    update_timer.stop();
+    QDockWidget::hideEvent(ev);
+}
+
+void WaitTreeWidget::Refresh() {
+    if (model == nullptr || debug_mode)
+        return;
+
+    auto snapshot = Kernel::GetLatestSnapshot();
+    if (snapshot != nullptr && snapshot != model->GetSnapshot()) {
+        ShowSnapshot(std::move(snapshot));
+    }
+    Kernel::RequestSnapshot();
+}
+
+void WaitTreeWidget::ShowSnapshot(std::shared_ptr<const Kernel::KernelSnapshot> snapshot) {
+    // Rows are expanded again by position, as a new snapshot has all new items
+    std::vector<std::vector<int>> expanded_rows;
+    std::vector<int> path;
+    CollectExpandedRows(QModelIndex(), path, expanded_rows);
+
+    model->InitItems(std::move(snapshot));
+    setEnabled(true);
+
+    for (const auto& rows : expanded_rows) {
+        QModelIndex index;
+        for (const int row : rows) {
+            index = model->index(row, 0, index);
+            if (!index.isValid())
+                break;
+        }
+        if (index.isValid())
+            view->expand(index);
+    }
+}
+
+void WaitTreeWidget::CollectExpandedRows(const QModelIndex& parent, std::vector<int>& path,
+                                         std::vector<std::vector<int>>& expanded_rows) const {
+    const int row_count = model->rowCount(parent);
+    for (int row = 0; row < row_count; ++row) {
+        const QModelIndex index = model->index(row, 0, parent);
+        if (!view->isExpanded(index))
+            continue;
+        path.push_back(row);
+        expanded_rows.push_back(path);
+        CollectExpandedRows(index, path, expanded_rows);
+        path.pop_back();
+    }
 }
 
 void WaitTreeWidget::OnDebugModeEntered() {
     if (!Core::System::GetInstance().IsPoweredOn())
         return;
-    model->InitItems();
-    view->setModel(model);
-    setEnabled(true);
+    // The emulation thread is blocked until this returns, so the kernel can be read directly
+    debug_mode = true;
+    ShowSnapshot(Kernel::CaptureSnapshot());
 }
 
 void WaitTreeWidget::OnDebugModeLeft() {
-    setEnabled(false);
-    view->setModel(nullptr);
-    model->ClearItems();
+    debug_mode = false;
 }
 
 void WaitTreeWidget::OnEmulationStarting(EmuThread* emu_thread) {
     model = new WaitTreeModel(this);
     view->setModel(model);
     setEnabled(false);
+    debug_mode = false;
+    Kernel::RequestSnapshot();
 }
 
 void WaitTreeWidget::OnEmulationStopping() {
     view->setModel(nullptr);
     delete model;
+    model = nullptr;
     setEnabled(false);
 }
@@ -4,26 +4,28 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
 #include <QAbstractItemModel>
 #include <QDockWidget>
+#include <QTimer>
 #include <QTreeView>
-#include <boost/container/flat_set.hpp>
-#include "core/core.h"
 #include "core/hle/kernel/kernel.h"
 
 class EmuThread;
 
 namespace Kernel {
-class WaitObject;
-class Event;
-class Mutex;
-class ConditionVariable;
-class Thread;
-class Timer;
+struct KernelSnapshot;
+struct ThreadSnapshot;
+struct WaitObjectSnapshot;
 } // namespace Kernel
 
 class WaitTreeThread;
 
+/**
+ * Items of the wait tree show a Kernel::KernelSnapshot, which stays alive as long as the model
+ * that shows it, so that the tree can be refreshed while emulation is running.
+ */
 class WaitTreeItem : public QObject {
     Q_OBJECT
 public:
@@ -36,7 +38,8 @@ public:
     WaitTreeItem* Parent() const;
     const std::vector<std::unique_ptr<WaitTreeItem>>& Children() const;
     std::size_t Row() const;
-    static std::vector<std::unique_ptr<WaitTreeThread>> MakeThreadItemList();
+    static std::vector<std::unique_ptr<WaitTreeThread>> MakeThreadItemList(
+        const Kernel::KernelSnapshot& snapshot);
 
 private:
     std::size_t row;
@@ -64,13 +67,16 @@ public:
 class WaitTreeWaitObject : public WaitTreeExpandableItem {
     Q_OBJECT
 public:
-    explicit WaitTreeWaitObject(const Kernel::WaitObject& object);
-    static std::unique_ptr<WaitTreeWaitObject> make(const Kernel::WaitObject& object);
+    WaitTreeWaitObject(const Kernel::WaitObjectSnapshot& object,
+                       const Kernel::KernelSnapshot& snapshot);
+    static std::unique_ptr<WaitTreeWaitObject> make(u32 object_id,
+                                                    const Kernel::KernelSnapshot& snapshot);
     QString GetText() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 protected:
-    const Kernel::WaitObject& object;
+    const Kernel::WaitObjectSnapshot& object;
+    const Kernel::KernelSnapshot& snapshot;
 
     static QString GetResetTypeQString(Kernel::ResetType reset_type);
 };
@@ -78,75 +84,84 @@ protected:
 class WaitTreeObjectList : public WaitTreeExpandableItem {
     Q_OBJECT
 public:
-    WaitTreeObjectList(const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& list,
-                       bool wait_all);
+    WaitTreeObjectList(const std::vector<u32>& list, bool wait_all,
+                       const Kernel::KernelSnapshot& snapshot);
     QString GetText() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 private:
-    const std::vector<Kernel::SharedPtr<Kernel::WaitObject>>& object_list;
+    const std::vector<u32>& object_list;
     bool wait_all;
+    const Kernel::KernelSnapshot& snapshot;
 };
 
 class WaitTreeThread : public WaitTreeWaitObject {
     Q_OBJECT
 public:
-    explicit WaitTreeThread(const Kernel::Thread& thread);
+    WaitTreeThread(const Kernel::ThreadSnapshot& thread, const Kernel::KernelSnapshot& snapshot);
     QString GetText() const override;
     QColor GetColor() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
+
+private:
+    const Kernel::ThreadSnapshot& thread;
 };
 
 class WaitTreeEvent : public WaitTreeWaitObject {
     Q_OBJECT
 public:
-    explicit WaitTreeEvent(const Kernel::Event& object);
+    WaitTreeEvent(const Kernel::WaitObjectSnapshot& object,
+                  const Kernel::KernelSnapshot& snapshot);
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 };
 
 class WaitTreeMutex : public WaitTreeWaitObject {
     Q_OBJECT
 public:
-    explicit WaitTreeMutex(const Kernel::Mutex& object);
+    WaitTreeMutex(const Kernel::WaitObjectSnapshot& object,
+                  const Kernel::KernelSnapshot& snapshot);
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 };
 
 class WaitTreeConditionVariable : public WaitTreeWaitObject {
     Q_OBJECT
 public:
-    explicit WaitTreeConditionVariable(const Kernel::ConditionVariable& object);
+    WaitTreeConditionVariable(const Kernel::WaitObjectSnapshot& object,
+                              const Kernel::KernelSnapshot& snapshot);
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 };
 
 class WaitTreeTimer : public WaitTreeWaitObject {
     Q_OBJECT
 public:
-    explicit WaitTreeTimer(const Kernel::Timer& object);
+    WaitTreeTimer(const Kernel::WaitObjectSnapshot& object,
+                  const Kernel::KernelSnapshot& snapshot);
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 };
 
 class WaitTreeMutexList : public WaitTreeExpandableItem {
     Q_OBJECT
 public:
-    explicit WaitTreeMutexList(
-        const boost::container::flat_set<Kernel::SharedPtr<Kernel::Mutex>>& list);
+    WaitTreeMutexList(const std::vector<u32>& list, const Kernel::KernelSnapshot& snapshot);
 
     QString GetText() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 private:
-    const boost::container::flat_set<Kernel::SharedPtr<Kernel::Mutex>>& mutex_list;
+    const std::vector<u32>& mutex_list;
+    const Kernel::KernelSnapshot& snapshot;
 };
 
 class WaitTreeThreadList : public WaitTreeExpandableItem {
     Q_OBJECT
 public:
-    explicit WaitTreeThreadList(const std::vector<Kernel::SharedPtr<Kernel::Thread>>& list);
+    WaitTreeThreadList(const std::vector<u32>& list, const Kernel::KernelSnapshot& snapshot);
     QString GetText() const override;
     std::vector<std::unique_ptr<WaitTreeItem>> GetChildren() const override;
 
 private:
-    const std::vector<Kernel::SharedPtr<Kernel::Thread>>& thread_list;
+    const std::vector<u32>& thread_list;
+    const Kernel::KernelSnapshot& snapshot;
 };
 
 class WaitTreeModel : public QAbstractItemModel {
@@ -162,10 +177,14 @@ public:
     int columnCount(const QModelIndex& parent) const override;
 
     void ClearItems();
-    void InitItems();
+    void InitItems(std::shared_ptr<const Kernel::KernelSnapshot> snapshot);
+
+    /// The snapshot that is shown, nullptr if there is none
+    const std::shared_ptr<const Kernel::KernelSnapshot>& GetSnapshot() const;
 
 private:
     std::vector<std::unique_ptr<WaitTreeThread>> thread_items;
+    std::shared_ptr<const Kernel::KernelSnapshot> snapshot;
 };
 
 class WaitTreeWidget : public QDockWidget {
@@ -181,7 +200,21 @@ public slots:
     void OnEmulationStarting(EmuThread* emu_thread);
     void OnEmulationStopping();
 
+protected:
+    void showEvent(QShowEvent* ev) override;
+    void hideEvent(QHideEvent* ev) override;
+
 private:
+    /// Shows the latest snapshot taken by the emulation thread, and asks it for the next one
+    void Refresh();
+    /// Replaces the shown snapshot, keeping the expanded rows expanded
+    void ShowSnapshot(std::shared_ptr<const Kernel::KernelSnapshot> snapshot);
+    void CollectExpandedRows(const QModelIndex& parent, std::vector<int>& path,
+                             std::vector<std::vector<int>>& expanded_rows) const;
+
     QTreeView* view;
-    WaitTreeModel* model;
+    WaitTreeModel* model = nullptr;
+    QTimer update_timer;
+    /// While emulation is paused, the tree shows a snapshot taken on entering debug mode
+    bool debug_mode = false;
 };
@@ -2,15 +2,25 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <thread>
 #include <QApplication>
+#include <QDateTime>
 #include <QFileInfo>
 #include <QHeaderView>
 #include <QKeyEvent>
 #include <QMenu>
 #include <QThreadPool>
 #include "common/common_paths.h"
+#include "common/file_util.h"
+#include "common/hash.h"
+#include "common/indexed_disk_cache.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_pool.h"
 #include "core/loader/loader.h"
 #include "game_list.h"
 #include "game_list_p.h"
@@ -370,9 +380,101 @@ void GameList::RefreshGameDirectory() {
     }
 }
 
-void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion) {
-    const auto callback = [this, recursion](unsigned* num_entries_out, const std::string& directory,
-                                            const std::string& virtual_name) -> bool {
+namespace {
+
+/// Version of the format of the game list cache. The cache is started over when it changes.
+constexpr u64 GAME_LIST_CACHE_VERSION = 1;
+
+/// What the game list shows of a file, as kept in the game list cache by the hash of its path
+struct GameMetadata {
+    std::string path;
+    u64 modification_time = 0;
+    u64 size = 0;
+    /// FileType::Error for files none of the loaders can open, so that they aren't retried
+    Loader::FileType file_type = Loader::FileType::Error;
+    u64 program_id = 0;
+    std::string title;
+    std::vector<u8> icon;
+};
+
+void WriteU64(std::vector<u8>& data, u64 value) {
+    const size_t offset = data.size();
+    data.resize(offset + sizeof(value));
+    std::memcpy(&data[offset], &value, sizeof(value));
+}
+
+void WriteBlob(std::vector<u8>& data, const void* blob, size_t size) {
+    WriteU64(data, size);
+    const size_t offset = data.size();
+    data.resize(offset + size);
+    std::memcpy(data.data() + offset, blob, size);
+}
+
+bool ReadU64(const u8*& data, const u8* end, u64& value) {
+    if (static_cast<size_t>(end - data) < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return true;
+}
+
+template <typename Container>
+bool ReadBlob(const u8*& data, const u8* end, Container& blob) {
+    u64 size;
+    if (!ReadU64(data, end, size) || static_cast<u64>(end - data) < size) {
+        return false;
+    }
+    blob.assign(data, data + size);
+    data += size;
+    return true;
+}
+
+std::vector<u8> SerializeMetadata(const GameMetadata& metadata) {
+    std::vector<u8> data;
+    WriteBlob(data, metadata.path.data(), metadata.path.size());
+    WriteU64(data, metadata.modification_time);
+    WriteU64(data, metadata.size);
+    WriteU64(data, static_cast<u64>(metadata.file_type));
+    WriteU64(data, metadata.program_id);
+    WriteBlob(data, metadata.title.data(), metadata.title.size());
+    WriteBlob(data, metadata.icon.data(), metadata.icon.size());
+    return data;
+}
+
+bool DeserializeMetadata(const std::vector<u8>& data, GameMetadata& metadata) {
+    const u8* read = data.data();
+    const u8* const end = read + data.size();
+    u64 file_type;
+    if (!ReadBlob(read, end, metadata.path) || !ReadU64(read, end, metadata.modification_time) ||
+        !ReadU64(read, end, metadata.size) || !ReadU64(read, end, file_type) ||
+        !ReadU64(read, end, metadata.program_id) || !ReadBlob(read, end, metadata.title) ||
+        !ReadBlob(read, end, metadata.icon)) {
+        return false;
+    }
+    metadata.file_type = static_cast<Loader::FileType>(file_type);
+    return true;
+}
+
+/// Opens a file with its loader to fill in the rest of its metadata.
+void ProbeGameFile(GameMetadata& metadata) {
+    std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(metadata.path);
+    if (!loader) {
+        return;
+    }
+    metadata.file_type = loader->GetFileType();
+    loader->ReadIcon(metadata.icon);
+    loader->ReadProgramId(metadata.program_id);
+    loader->ReadTitle(metadata.title);
+}
+
+} // Anonymous namespace
+
+void GameListWorker::FindGameFiles(const std::string& dir_path, unsigned int recursion,
+                                   std::vector<std::string>& files) {
+    const auto callback = [this, recursion, &files](unsigned* num_entries_out,
+                                                    const std::string& directory,
+                                                    const std::string& virtual_name) -> bool {
         std::string physical_name = directory + DIR_SEP + virtual_name;
 
         if (stop_processing)
@@ -380,25 +482,10 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
 
         bool is_dir = FileUtil::IsDirectory(physical_name);
         if (!is_dir && HasSupportedFileExtension(physical_name)) {
-            std::unique_ptr<Loader::AppLoader> loader = Loader::GetLoader(physical_name);
-            if (!loader)
-                return true;
-
-            std::vector<u8> smdh;
-            loader->ReadIcon(smdh);
-
-            u64 program_id = 0;
-            loader->ReadProgramId(program_id);
-
-            emit EntryReady({
-                new GameListItemPath(QString::fromStdString(physical_name), smdh, program_id),
-                new GameListItem(
-                    QString::fromStdString(Loader::GetFileTypeString(loader->GetFileType()))),
-                new GameListItemSize(FileUtil::GetSize(physical_name)),
-            });
+            files.push_back(std::move(physical_name));
         } else if (is_dir && recursion > 0) {
             watch_list.append(QString::fromStdString(physical_name));
-            AddFstEntriesToGameList(physical_name, recursion - 1);
+            FindGameFiles(physical_name, recursion - 1, files);
         }
 
         return true;
@@ -410,7 +497,80 @@ void GameListWorker::AddFstEntriesToGameList(const std::string& dir_path, unsign
 void GameListWorker::run() {
     stop_processing = false;
     watch_list.append(dir_path);
-    AddFstEntriesToGameList(dir_path.toStdString(), deep_scan ? 256 : 0);
+    std::vector<std::string> files;
+    FindGameFiles(dir_path.toStdString(), deep_scan ? 256 : 0, files);
+
+    // A cancelled worker may still be finishing while the next one starts, and the cache file can
+    // only be open once.
+    static std::mutex cache_mutex;
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    Common::IndexedDiskCache cache;
+    const std::string cache_dir = FileUtil::GetUserPath(D_CACHE_IDX);
+    if (!FileUtil::CreateFullPath(cache_dir) ||
+        !cache.Open(cache_dir + "game_list.bin", GAME_LIST_CACHE_VERSION)) {
+        LOG_WARNING(Frontend, "Unable to open the game list cache in %s", cache_dir.c_str());
+    }
+
+    const auto emit_entry = [this](const GameMetadata& metadata) {
+        if (metadata.file_type == Loader::FileType::Error) {
+            return;
+        }
+        auto* path_item = new GameListItemPath(QString::fromStdString(metadata.path),
+                                               metadata.icon, metadata.program_id);
+        if (!metadata.title.empty()) {
+            path_item->setData(QString::fromStdString(metadata.title), GameListItemPath::TitleRole);
+        }
+        emit EntryReady({
+            path_item,
+            new GameListItem(QString::fromStdString(Loader::GetFileTypeString(metadata.file_type))),
+            new GameListItemSize(metadata.size),
+        });
+    };
+
+    // Opening files mostly waits for the disk or the network, so more threads than cores help
+    Common::ThreadPool pool(std::max(std::thread::hardware_concurrency(), 8u), "GameList");
+    Common::CancellationToken token;
+    std::vector<std::future<GameMetadata>> probes;
+    std::vector<u8> data;
+    for (const std::string& path : files) {
+        if (stop_processing) {
+            break;
+        }
+
+        const QFileInfo info(QString::fromStdString(path));
+        GameMetadata metadata;
+        metadata.path = path;
+        metadata.modification_time = static_cast<u64>(info.lastModified().toMSecsSinceEpoch());
+        metadata.size = static_cast<u64>(info.size());
+
+        GameMetadata cached;
+        const u64 key = Common::ComputeHash64(path.data(), path.size());
+        if (cache.Read(key, data) && DeserializeMetadata(data, cached) && cached.path == path &&
+            cached.modification_time == metadata.modification_time &&
+            cached.size == metadata.size) {
+            emit_entry(cached);
+            continue;
+        }
+        probes.push_back(pool.Submit(
+            [metadata{std::move(metadata)}]() mutable {
+                ProbeGameFile(metadata);
+                return metadata;
+            },
+            token));
+    }
+
+    for (auto& probe : probes) {
+        if (stop_processing) {
+            token.Cancel();
+            break;
+        }
+        const GameMetadata metadata = probe.get();
+        const std::vector<u8> serialized = SerializeMetadata(metadata);
+        cache.Write(Common::ComputeHash64(metadata.path.data(), metadata.path.size()),
+                    serialized.data(), serialized.size());
+        emit_entry(metadata);
+    }
+
     emit Finished(watch_list);
 }
 
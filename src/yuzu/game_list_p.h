@@ -5,6 +5,8 @@
 #pragma once
 
 #include <atomic>
+#include <string>
+#include <vector>
 #include <QImage>
 #include <QRunnable>
 #include <QStandardItem>
@@ -105,6 +107,10 @@ public:
 /**
  * Asynchronous worker object for populating the game list.
  * Communicates with other threads through Qt's signal/slot system.
+ *
+ * What the list shows of each file is kept in a cache in the user's cache directory, by path,
+ * size and modification time, so that only new and changed files are opened with their loader.
+ * Those are opened on a thread pool, as reading them may be slow on network shares.
  */
 class GameListWorker : public QObject, public QRunnable {
     Q_OBJECT
@@ -139,5 +145,7 @@ private:
     bool deep_scan;
     std::atomic_bool stop_processing;
 
-    void AddFstEntriesToGameList(const std::string& dir_path, unsigned int recursion = 0);
+    /// Adds the files with a supported extension to files, and the directories to watch_list.
+    void FindGameFiles(const std::string& dir_path, unsigned int recursion,
+                       std::vector<std::string>& files);
 };
@@ -6,6 +6,7 @@
 #include <clocale>
 #include <memory>
 #include <thread>
+#include <utility>
 #include <glad/glad.h>
 #define QT_NO_OPENGL
 #include <QDesktopWidget>
@@ -32,6 +33,8 @@
 #include "yuzu/configuration/configure_dialog.h"
 #include "yuzu/debugger/graphics/graphics_breakpoints.h"
 #include "yuzu/debugger/graphics/graphics_surface.h"
+#include "yuzu/debugger/ipc_recorder.h"
+#include "yuzu/debugger/memory_usage.h"
 #include "yuzu/debugger/profiler.h"
 #include "yuzu/debugger/registers.h"
 #include "yuzu/debugger/wait_tree.h"
@@ -149,13 +152,24 @@ void GMainWindow::InitializeWidgets() {
     emu_frametime_label->setToolTip(
         tr("Time taken to emulate a Switch frame, not counting framelimiting or v-sync. For "
            "full-speed emulation this should be at most 16.67 ms."));
+    // The tooltip of this one shows the percentiles and the breakdown, and is set on each update
+    emu_frametime_p99_label = new QLabel();
 
-    for (auto& label : {emu_speed_label, game_fps_label, emu_frametime_label}) {
+    for (auto& label :
+         {emu_speed_label, game_fps_label, emu_frametime_label, emu_frametime_p99_label}) {
         label->setVisible(false);
         label->setFrameStyle(QFrame::NoFrame);
         label->setContentsMargins(4, 0, 4, 0);
         statusBar()->addPermanentWidget(label, 0);
     }
+
+    load_progress_bar = new QProgressBar();
+    load_progress_bar->setVisible(false);
+    load_progress_bar->setFormat(tr("Building shaders: %v / %m"));
+    load_progress_bar->setToolTip(
+        tr("Shaders kept from previous sessions are built before the game starts, so that it "
+           "doesn't stutter when it first uses them."));
+    statusBar()->addPermanentWidget(load_progress_bar, 0);
     statusBar()->setVisible(true);
     setStyleSheet("QStatusBar::item{border: none;}");
 }
@@ -196,6 +210,20 @@ void GMainWindow::InitializeDebugWidgets() {
             &WaitTreeWidget::OnEmulationStarting);
     connect(this, &GMainWindow::EmulationStopping, waitTreeWidget,
             &WaitTreeWidget::OnEmulationStopping);
+
+    ipcRecorderWidget = new IPCRecorderWidget(this);
+    addDockWidget(Qt::LeftDockWidgetArea, ipcRecorderWidget);
+    ipcRecorderWidget->hide();
+    debug_menu->addAction(ipcRecorderWidget->toggleViewAction());
+    connect(this, &GMainWindow::EmulationStarting, ipcRecorderWidget,
+            &IPCRecorderWidget::OnEmulationStarting);
+    connect(this, &GMainWindow::EmulationStopping, ipcRecorderWidget,
+            &IPCRecorderWidget::OnEmulationStopping);
+
+    memoryUsageWidget = new MemoryUsageWidget(this);
+    addDockWidget(Qt::LeftDockWidgetArea, memoryUsageWidget);
+    memoryUsageWidget->hide();
+    debug_menu->addAction(memoryUsageWidget->toggleViewAction());
 }
 
 void GMainWindow::InitializeRecentFileMenuActions() {
@@ -216,6 +244,8 @@ void GMainWindow::InitializeHotkeys() {
     RegisterHotkey("Main Window", "Fullscreen", QKeySequence::FullScreen);
     RegisterHotkey("Main Window", "Exit Fullscreen", QKeySequence(Qt::Key_Escape),
                    Qt::ApplicationShortcut);
+    RegisterHotkey("Main Window", "Toggle Fast Forward", QKeySequence(Qt::CTRL + Qt::Key_F),
+                   Qt::ApplicationShortcut);
     LoadHotkeys();
 
     connect(GetHotkey("Main Window", "Load File", this), &QShortcut::activated, this,
@@ -232,6 +262,8 @@ void GMainWindow::InitializeHotkeys() {
             ToggleFullscreen();
         }
     });
+    connect(GetHotkey("Main Window", "Toggle Fast Forward", this), &QShortcut::activated, this,
+            [] { Settings::values.use_fast_forward = !Settings::values.use_fast_forward; });
 }
 
 void GMainWindow::SetDefaultUIGeometry() {
@@ -336,10 +368,6 @@ void GMainWindow::OnDisplayTitleBars(bool show) {
 }
 
 bool GMainWindow::LoadROM(const QString& filename) {
-    // Shutdown previous session if the emu thread is still active...
-    if (emu_thread != nullptr)
-        ShutdownGame();
-
     render_window->InitRenderTarget();
     render_window->MakeCurrent();
 
@@ -421,6 +449,16 @@ bool GMainWindow::LoadROM(const QString& filename) {
 }
 
 void GMainWindow::BootGame(const QString& filename) {
+    // Shutdown previous session if the emu thread is still active...
+    if (emu_thread != nullptr)
+        ShutdownGame();
+
+    // ...and boot the new one once the shutdown running in the background is done
+    if (stopping_emu_thread != nullptr) {
+        pending_boot_filename = filename;
+        return;
+    }
+
     NGLOG_INFO(Frontend, "yuzu starting...");
     StoreRecentFile(filename); // Put the filename on top of the list
 
@@ -429,6 +467,7 @@ void GMainWindow::BootGame(const QString& filename) {
 
     // Create and start the emulation thread
     emu_thread = std::make_unique<EmuThread>(render_window);
+    connect(emu_thread.get(), &EmuThread::LoadProgress, this, &GMainWindow::OnLoadProgress);
     emit EmulationStarting(emu_thread.get());
     render_window->moveContext();
     emu_thread->start();
@@ -467,9 +506,12 @@ void GMainWindow::ShutdownGame() {
 
     emit EmulationStopping();
 
-    // Wait for emulation thread to complete and delete it
-    emu_thread->wait();
-    emu_thread = nullptr;
+    // The emulation thread shuts the system down in the background, so that the UI stays
+    // responsive. Only its finished signal is of interest anymore, the debugger widgets mustn't
+    // look at the system while it's being torn down.
+    emu_thread->disconnect();
+    connect(emu_thread.get(), &QThread::finished, this, &GMainWindow::OnEmulationThreadFinished);
+    stopping_emu_thread = std::move(emu_thread);
 
     // The emulation is stopped, so closing the window or not does not matter anymore
     disconnect(render_window, &GRenderWindow::Closed, this, &GMainWindow::OnStopGame);
@@ -489,10 +531,22 @@ void GMainWindow::ShutdownGame() {
     emu_speed_label->setVisible(false);
     game_fps_label->setVisible(false);
     emu_frametime_label->setVisible(false);
+    emu_frametime_p99_label->setVisible(false);
+    load_progress_bar->setVisible(false);
 
     emulation_running = false;
 }
 
+void GMainWindow::OnEmulationThreadFinished() {
+    // The thread may still be returning from run when the queued signal arrives
+    stopping_emu_thread->wait();
+    stopping_emu_thread = nullptr;
+
+    if (!pending_boot_filename.isEmpty()) {
+        BootGame(std::exchange(pending_boot_filename, QString()));
+    }
+}
+
 void GMainWindow::StoreRecentFile(const QString& filename) {
     UISettings::values.recent_files.prepend(filename);
     UISettings::values.recent_files.removeDuplicates();
@@ -699,10 +753,33 @@ void GMainWindow::UpdateStatusBar() {
     emu_speed_label->setText(tr("Speed: %1%").arg(results.emulation_speed * 100.0, 0, 'f', 0));
     game_fps_label->setText(tr("Game: %1 FPS").arg(results.game_fps, 0, 'f', 0));
     emu_frametime_label->setText(tr("Frame: %1 ms").arg(results.frametime * 1000.0, 0, 'f', 2));
+    emu_frametime_p99_label->setText(
+        tr("p99: %1 ms").arg(results.frametime_p99 * 1000.0, 0, 'f', 2));
+
+    QString breakdown =
+        tr("Frame time percentiles over the last frames, not counting framelimiting or v-sync:\n"
+           "p50 %1 ms, p95 %2 ms, p99 %3 ms\n\nTime spent per frame:")
+            .arg(results.frametime_p50 * 1000.0, 0, 'f', 2)
+            .arg(results.frametime_p95 * 1000.0, 0, 'f', 2)
+            .arg(results.frametime_p99 * 1000.0, 0, 'f', 2);
+    for (size_t i = 0; i < Core::PerfStats::NumSubsystems; ++i) {
+        const auto subsystem = static_cast<Core::PerfStats::Subsystem>(i);
+        breakdown += tr("\n%1: %2 ms")
+                         .arg(QString::fromUtf8(Core::PerfStats::GetSubsystemName(subsystem)))
+                         .arg(results.subsystem_frametime[i] * 1000.0, 0, 'f', 2);
+    }
+    emu_frametime_p99_label->setToolTip(breakdown);
 
     emu_speed_label->setVisible(true);
     game_fps_label->setVisible(true);
     emu_frametime_label->setVisible(true);
+    emu_frametime_p99_label->setVisible(true);
+}
+
+void GMainWindow::OnLoadProgress(int value, int total) {
+    load_progress_bar->setMaximum(total);
+    load_progress_bar->setValue(value);
+    load_progress_bar->setVisible(value < total);
 }
 
 void GMainWindow::OnCoreError(Core::System::ResultStatus result, std::string details) {
@@ -808,6 +885,13 @@ void GMainWindow::closeEvent(QCloseEvent* event) {
     if (emu_thread != nullptr)
         ShutdownGame();
 
+    // ...and wait for the shutdown to finish, as the application is about to exit
+    pending_boot_filename.clear();
+    if (stopping_emu_thread != nullptr) {
+        stopping_emu_thread->wait();
+        stopping_emu_thread = nullptr;
+    }
+
     render_window->close();
 
     QWidget::closeEvent(event);
@@ -17,8 +17,11 @@ class GImageInfo;
 class GraphicsBreakPointsWidget;
 class GraphicsSurfaceWidget;
 class GRenderWindow;
+class IPCRecorderWidget;
+class MemoryUsageWidget;
 class MicroProfileDialog;
 class ProfilerWidget;
+class QProgressBar;
 class RegistersWidget;
 class WaitTreeWidget;
 
@@ -135,6 +138,9 @@ private slots:
     void HideFullscreen();
     void ToggleWindowMode();
     void OnCoreError(Core::System::ResultStatus, std::string);
+    void OnLoadProgress(int value, int total);
+    /// Deletes the emulation thread once it shut the system down, and boots any pending game
+    void OnEmulationThreadFinished();
 
 private:
     void UpdateStatusBar();
@@ -151,6 +157,8 @@ private:
     QLabel* emu_speed_label = nullptr;
     QLabel* game_fps_label = nullptr;
     QLabel* emu_frametime_label = nullptr;
+    QLabel* emu_frametime_p99_label = nullptr;
+    QProgressBar* load_progress_bar = nullptr;
     QTimer status_bar_update_timer;
 
     std::unique_ptr<Config> config;
@@ -158,6 +166,10 @@ private:
     // Whether emulation is currently running in yuzu.
     bool emulation_running = false;
     std::unique_ptr<EmuThread> emu_thread;
+    /// Emulation thread that is shutting the system down in the background
+    std::unique_ptr<EmuThread> stopping_emu_thread;
+    /// Game that is booted once stopping_emu_thread is done
+    QString pending_boot_filename;
 
     // Debugger panes
     ProfilerWidget* profilerWidget;
@@ -166,6 +178,8 @@ private:
     GraphicsBreakPointsWidget* graphicsBreakpointsWidget;
     GraphicsSurfaceWidget* graphicsSurfaceWidget;
     WaitTreeWidget* waitTreeWidget;
+    IPCRecorderWidget* ipcRecorderWidget;
+    MemoryUsageWidget* memoryUsageWidget;
 
     QAction* actions_recent_files[max_recent_files_item];
 
@@ -0,0 +1,193 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "core/core.h"
+#include "yuzu_cmd/benchmark.h"
+
+using DoubleMs = std::chrono::duration<double, std::milli>;
+using DoubleSecs = std::chrono::duration<double>;
+
+std::string EscapeJson(const std::string& str) {
+    std::string escaped;
+    for (const char c : str) {
+        switch (c) {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", c);
+                escaped += code;
+            } else {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+namespace {
+
+/// Returns the most memory the process had resident at any point, in bytes
+u64 GetPeakResidentMemory() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+#ifdef __APPLE__
+    return static_cast<u64>(usage.ru_maxrss);
+#else
+    // Linux and the BSDs report it in kilobytes
+    return static_cast<u64>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/// Returns the time of the frame a given fraction of the frames took at most, by nearest rank
+double Percentile(const std::vector<double>& sorted_times, double fraction) {
+    if (sorted_times.empty()) {
+        return 0.0;
+    }
+    const size_t rank = static_cast<size_t>(std::ceil(fraction * sorted_times.size()));
+    return sorted_times[std::clamp<size_t>(rank, 1, sorted_times.size()) - 1];
+}
+
+#if MICROPROFILE_ENABLED
+/// Writes the time spent in every profiled scope since the benchmark started
+void WriteProfile(std::ostringstream& out) {
+    std::lock_guard<std::recursive_mutex> lock(MicroProfileGetMutex());
+    const MicroProfile& profile = *MicroProfileGet();
+    const double ms_per_tick = 1000.0 / static_cast<double>(MicroProfileTicksPerSecondCpu());
+
+    bool first = true;
+    for (u32 i = 0; i < profile.nTotalTimers; ++i) {
+        const MicroProfileTimer& timer = profile.Aggregate[i];
+        if (timer.nCount == 0) {
+            continue;
+        }
+        out << (first ? "\n" : ",\n") << "    {\"group\": \""
+            << EscapeJson(profile.GroupInfo[profile.TimerToGroup[i]].pName) << "\", \"name\": \""
+            << EscapeJson(profile.TimerInfo[i].pName)
+            << "\", \"total_ms\": " << timer.nTicks * ms_per_tick
+            << ", \"count\": " << timer.nCount << "}";
+        first = false;
+    }
+    if (!first) {
+        out << "\n  ";
+    }
+}
+#endif
+
+} // Anonymous namespace
+
+Benchmark::Benchmark(Config config, std::string title)
+    : config(std::move(config)), title(std::move(title)) {}
+
+void Benchmark::Start() {
+    Core::PerfStats& perf_stats = Core::System::GetInstance().perf_stats;
+    perf_stats.BeginFrameLog();
+    start_shader_counts = perf_stats.GetShaderCounts();
+    start_time = Core::PerfStats::Clock::now();
+
+    // Keeps the totals of every scope from the next frame on, instead of the last few frames
+    MicroProfileSetForceEnable(true);
+    MicroProfileSetEnableAllGroups(true);
+    MicroProfileSetAggregateFrames(0);
+}
+
+bool Benchmark::IsDone() const {
+    if (config.frames != 0 &&
+        Core::System::GetInstance().perf_stats.GetFrameLogSize() >= config.frames) {
+        return true;
+    }
+    return config.seconds > 0.0 &&
+           DoubleSecs(Core::PerfStats::Clock::now() - start_time).count() >= config.seconds;
+}
+
+bool Benchmark::WriteReport() const {
+    const std::string report = MakeReport();
+    if (config.output_path.empty()) {
+        std::cout << report;
+        return true;
+    }
+    if (FileUtil::WriteStringToFile(true, report, config.output_path.c_str()) != report.size()) {
+        LOG_ERROR(Frontend, "Failed to write the benchmark report to %s",
+                  config.output_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string Benchmark::MakeReport() const {
+    Core::PerfStats& perf_stats = Core::System::GetInstance().perf_stats;
+    const double elapsed = DoubleSecs(Core::PerfStats::Clock::now() - start_time).count();
+
+    std::vector<double> frame_times;
+    for (const Core::PerfStats::Clock::duration frame : perf_stats.GetFrameLog()) {
+        frame_times.push_back(DoubleMs(frame).count());
+    }
+    std::sort(frame_times.begin(), frame_times.end());
+    const double average =
+        frame_times.empty() ? 0.0
+                            : std::accumulate(frame_times.begin(), frame_times.end(), 0.0) /
+                                  frame_times.size();
+
+    const Core::PerfStats::ShaderCounts shader_counts = perf_stats.GetShaderCounts();
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"title\": \"" << EscapeJson(title) << "\",\n";
+    out << "  \"frames\": " << frame_times.size() << ",\n";
+    out << "  \"seconds\": " << elapsed << ",\n";
+    out << "  \"frame_time_ms\": {\"average\": " << average
+        << ", \"p50\": " << Percentile(frame_times, 0.50)
+        << ", \"p90\": " << Percentile(frame_times, 0.90)
+        << ", \"p99\": " << Percentile(frame_times, 0.99)
+        << ", \"max\": " << (frame_times.empty() ? 0.0 : frame_times.back()) << "},\n";
+    out << "  \"shaders\": {\"compiled\": "
+        << shader_counts.compiled - start_shader_counts.compiled << ", \"loaded_from_disk\": "
+        << shader_counts.loaded_from_disk - start_shader_counts.loaded_from_disk << "},\n";
+    out << "  \"peak_rss_bytes\": " << GetPeakResidentMemory() << ",\n";
+    out << "  \"profile\": [";
+#if MICROPROFILE_ENABLED
+    WriteProfile(out);
+#endif
+    out << "]\n";
+    out << "}\n";
+    return out.str();
+}
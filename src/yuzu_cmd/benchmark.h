@@ -0,0 +1,49 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include "common/common_types.h"
+#include "core/perf_stats.h"
+
+/// Escapes a string to be written between the quotes of a JSON string
+std::string EscapeJson(const std::string& str);
+
+/**
+ * Measures how fast a game runs for a given number of frames or seconds, and reports the frame
+ * times, the time spent in the profiled scopes, the shaders that were built and the peak memory
+ * use as JSON, so that runs can be compared by scripts.
+ */
+class Benchmark {
+public:
+    struct Config {
+        /// Number of system frames to run for, or 0 for no limit
+        u32 frames = 0;
+        /// Walltime to run for in seconds, or 0 for no limit
+        double seconds = 0.0;
+        /// File to write the report to, stdout when empty
+        std::string output_path;
+    };
+
+    Benchmark(Config config, std::string title);
+
+    /// Starts measuring. Call once the game was loaded, so that loading isn't measured.
+    void Start();
+
+    /// Whether the benchmark ran for the configured number of frames or seconds
+    bool IsDone() const;
+
+    /// Writes the report, returns false if the output file couldn't be written
+    bool WriteReport() const;
+
+private:
+    std::string MakeReport() const;
+
+    Config config;
+    std::string title;
+    Core::PerfStats::Clock::time_point start_time;
+    Core::PerfStats::ShaderCounts start_shader_counts{};
+};
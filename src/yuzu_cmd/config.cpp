@@ -88,23 +88,70 @@ void Config::ReadValues() {
         "Controls", "motion_device", "engine:motion_emu,update_period:100,sensitivity:0.01");
     Settings::values.touch_device =
         sdl2_config->Get("Controls", "touch_device", "engine:emu_window");
+    Settings::values.pad_update_rate =
+        static_cast<u16>(sdl2_config->GetInteger("Controls", "pad_update_rate", 1000));
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.use_host_timing = sdl2_config->GetBoolean("Core", "use_host_timing", false);
+    Settings::values.use_host_thread_placement =
+        sdl2_config->GetBoolean("Core", "use_host_thread_placement", false);
 
     // Renderer
+    Settings::values.renderer_backend = static_cast<Settings::RendererBackend>(
+        sdl2_config->GetInteger("Renderer", "renderer_backend", 0));
     Settings::values.resolution_factor =
         (float)sdl2_config->GetReal("Renderer", "resolution_factor", 1.0);
+    Settings::values.use_dynamic_resolution =
+        sdl2_config->GetBoolean("Renderer", "use_dynamic_resolution", false);
     Settings::values.toggle_framelimit =
         sdl2_config->GetBoolean("Renderer", "toggle_framelimit", true);
+    Settings::values.use_fast_forward =
+        sdl2_config->GetBoolean("Renderer", "use_fast_forward", false);
+    Settings::values.fast_forward_present_interval = static_cast<u16>(
+        sdl2_config->GetInteger("Renderer", "fast_forward_present_interval", 4));
+    Settings::values.frame_rate_target =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_rate_target", 0));
+    Settings::values.use_asynchronous_gpu_emulation =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_gpu_emulation", false);
+    Settings::values.use_lazy_surface_flushes =
+        sdl2_config->GetBoolean("Renderer", "use_lazy_surface_flushes", false);
+    Settings::values.use_asynchronous_queries =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_queries", false);
+    Settings::values.present_mode = static_cast<Settings::PresentMode>(
+        sdl2_config->GetInteger("Renderer", "present_mode", 0));
+    Settings::values.use_variable_refresh =
+        sdl2_config->GetBoolean("Renderer", "use_variable_refresh", false);
+    Settings::values.use_asynchronous_texture_decoding =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_texture_decoding", false);
+    Settings::values.use_gpu_texture_deswizzling =
+        sdl2_config->GetBoolean("Renderer", "use_gpu_texture_deswizzling", false);
+    Settings::values.use_texture_content_hashing =
+        sdl2_config->GetBoolean("Renderer", "use_texture_content_hashing", false);
+    Settings::values.texture_cache_budget =
+        static_cast<u32>(sdl2_config->GetInteger("Renderer", "texture_cache_budget", 2048));
+    Settings::values.use_disk_shader_cache =
+        sdl2_config->GetBoolean("Renderer", "use_disk_shader_cache", true);
+    Settings::values.use_asynchronous_shaders =
+        sdl2_config->GetBoolean("Renderer", "use_asynchronous_shaders", false);
 
     Settings::values.bg_red = (float)sdl2_config->GetReal("Renderer", "bg_red", 0.0);
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 0.0);
     Settings::values.bg_blue = (float)sdl2_config->GetReal("Renderer", "bg_blue", 0.0);
 
+    // Audio
+    Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
+    Settings::values.enable_audio_stretching =
+        sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.audio_device_id = sdl2_config->Get("Audio", "output_device", "auto");
+
     // Data Storage
     Settings::values.use_virtual_sd =
         sdl2_config->GetBoolean("Data Storage", "use_virtual_sd", true);
+    Settings::values.storage_cache_size =
+        static_cast<u32>(sdl2_config->GetInteger("Data Storage", "storage_cache_size", 32));
+    Settings::values.use_loader_cache =
+        sdl2_config->GetBoolean("Data Storage", "use_loader_cache", false);
 
     // System
     Settings::values.use_docked_mode = sdl2_config->GetBoolean("System", "use_docked_mode", true);
@@ -116,6 +163,18 @@ void Config::ReadValues() {
     Settings::values.use_gdbstub = sdl2_config->GetBoolean("Debugging", "use_gdbstub", false);
     Settings::values.gdbstub_port =
         static_cast<u16>(sdl2_config->GetInteger("Debugging", "gdbstub_port", 24689));
+    Settings::values.profile_guest_code =
+        sdl2_config->GetBoolean("Debugging", "profile_guest_code", false);
+    Settings::values.profile_timing_events =
+        sdl2_config->GetBoolean("Debugging", "profile_timing_events", false);
+    Settings::values.record_ipc_calls =
+        sdl2_config->GetBoolean("Debugging", "record_ipc_calls", false);
+    Settings::values.record_gpu_trace =
+        sdl2_config->GetBoolean("Debugging", "record_gpu_trace", false);
+    Settings::values.memory_usage_log_interval = static_cast<u32>(
+        sdl2_config->GetInteger("Debugging", "memory_usage_log_interval", 0));
+    Settings::values.metrics_export_port =
+        static_cast<u16>(sdl2_config->GetInteger("Debugging", "metrics_export_port", 0));
 }
 
 void Config::Reload() {
@@ -75,12 +75,31 @@ motion_device=
 #  - "emu_window" (default) for emulating touch input from mouse input to the emulation window. No parameters required
 touch_device=
 
+# How many times per second the controller state is written for the guest, between 1 and 1000.
+# Keys also update it as soon as they are pressed or released.
+# 1000 (default)
+pad_update_rate=
+
 [Core]
 # Whether to use the Just-In-Time (JIT) compiler for CPU emulation
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to keep emulated time in step with the host clock, so that events fire in real time
+# 0 (default): Off, 1: On
+use_host_timing =
+
+# Whether to give the CPU, GPU and audio threads physical cores of their own, performance cores
+# first, and run the background workers on the other cores at a lower priority. Takes effect for
+# the threads started after it is changed.
+# 0 (default): Off, 1: On
+use_host_thread_placement =
+
 [Renderer]
+# Which graphics API the GPU is emulated with
+# 0 (default): OpenGL
+renderer_backend =
+
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
 use_hw_renderer =
@@ -94,10 +113,71 @@ use_shader_jit =
 # factor for the Switch resolution
 resolution_factor =
 
+# Whether to lower the resolution below the scale factor when the host GPU can't keep up, and raise
+# it back once it can. Handheld, the resolution stays within two thirds of the scale factor.
+# 0 (default): Off, 1: On
+use_dynamic_resolution =
+
 # Whether to enable V-Sync (caps the framerate at 60FPS) or not.
 # 0 (default): Off, 1: On
 use_vsync =
 
+# Whether to process GPU command lists on a separate thread, so that they run alongside guest code
+# 0 (default): Off, 1: On
+use_asynchronous_gpu_emulation =
+
+# Whether CPU reads of memory that only holds surfaces the GPU didn't write to skip waiting for the
+# GPU thread. Faster with asynchronous GPU emulation, but such reads may miss GPU writes that are
+# still pending if the game doesn't wait for the GPU before reading.
+# 0 (default): Off, 1: On
+use_lazy_surface_flushes =
+
+# Whether the GPU may answer occlusion queries before the host GPU is done counting. The game then
+# reads the result of an earlier query instead of waiting, which avoids a stall every frame.
+# 0 (default): Off, 1: On
+use_asynchronous_queries =
+
+# How frames are presented with asynchronous GPU emulation. Mailbox and immediate let the emulation
+# run ahead of the display instead of waiting for each frame to be shown.
+# 0 (default): FIFO, 1: Mailbox (drops frames the display can't keep up with), 2: Immediate
+present_mode =
+
+# Whether to present frames as soon as the emulated application queues them, instead of at the
+# next emulated vsync. Meant for variable refresh rate displays.
+# 0 (default): Off, 1: On
+use_variable_refresh =
+
+# Rate in frames per second the presented frames are evenly spaced at, for displays whose refresh
+# rate isn't a multiple of the emulated one. 0 (default): Follow the emulated vsync
+frame_rate_target =
+
+# Whether to decode textures on worker threads. Textures show their previous contents until they
+# are decoded, which saves stutter at the cost of accuracy.
+# 0 (default): Off, 1: On
+use_asynchronous_texture_decoding =
+
+# Whether to unswizzle textures with compute shaders instead of on the CPU. Needs OpenGL 4.3.
+# 0 (default): Off, 1: On
+use_gpu_texture_deswizzling =
+
+# Whether to hash the memory of textures when they are loaded, and skip the reload when the game
+# rewrites the same data. Saves decoding and uploading textures that are re-uploaded every frame.
+# 0 (default): Off, 1: On
+use_texture_content_hashing =
+
+# Memory in MiB the texture cache may use for textures before the least recently used ones are
+# evicted. 0: No limit, Defaults to 2048
+texture_cache_budget =
+
+# Whether to keep the shaders built for games on disk, so that they load faster next time
+# 0: No, 1 (default): Yes
+use_disk_shader_cache =
+
+# Whether to let the driver build shaders in the background, skipping the draws that use them
+# until they're ready. Saves stutter at the cost of missing graphics for a few frames.
+# 0 (default): Off, 1: On
+use_asynchronous_shaders =
+
 # The clear color for the renderer. What shows up on the sides of the bottom screen.
 # Must be in range of 0.0-1.0. Defaults to 1.0 for all.
 bg_red =
@@ -128,6 +208,15 @@ custom_bottom_bottom =
 # 0: Off, 1 (default): On
 toggle_framelimit =
 
+# Whether to run as fast as possible, presenting only some of the frames and dropping the audio that
+# can't be played in time.
+# 0 (default): Off, 1: On
+use_fast_forward =
+
+# While fast forwarding, one out of this many frames is presented
+# 4 (default)
+fast_forward_present_interval =
+
 # Swaps the prominent screen with the other screen.
 # For example, if Single Screen is chosen, setting this to 1 will display the bottom screen instead of the top screen.
 # 0 (default): Top Screen is prominent, 1: Bottom Screen is prominent
@@ -153,6 +242,14 @@ output_device =
 # 1 (default): Yes, 0: No
 use_virtual_sd =
 
+# Size in MiB of the cache for blocks read from files, shared by all the open files.
+# 0: Disabled, 32 (default)
+storage_cache_size =
+
+# Whether to keep the program images of loaded modules on disk, to load them faster next time.
+# 0 (default): No, 1: Yes
+use_loader_cache =
+
 [System]
 # Whether the system is docked
 # 1 (default): Yes, 0: No
@@ -171,6 +268,32 @@ log_filter = *:Trace
 # Port for listening to GDB connections.
 use_gdbstub=false
 gdbstub_port=24689
+# Whether to sample guest code execution. The profile is written to the log directory in the
+# folded stack format on shutdown.
+# 0 (default): Off, 1: On
+profile_guest_code =
+# Whether to collect call counts, host time and lateness for each CoreTiming event type. They are
+# written to the log on shutdown.
+# 0 (default): Off, 1: On
+profile_timing_events =
+# Whether to collect call counts, host time and payload sizes for each HLE service command. They
+# are written to the log directory as CSV on shutdown.
+# 0 (default): Off, 1: On
+record_ipc_calls =
+
+# Whether to record every GPU command list, along with the memory it uses and the presented frames,
+# as a CiTrace file in the log directory. The trace is written on shutdown, and can be replayed
+# with yuzu-cmd --gpu-trace. Recording slows down emulation a lot.
+# 0 (default): Off, 1: On
+record_gpu_trace =
+# Interval in seconds at which the host memory used by each part of the emulator is written to the
+# log, along with the resident memory of the process.
+# 0 (default): Never
+memory_usage_log_interval =
+# Port on which the live statistics are served over HTTP at /metrics, in the Prometheus text format,
+# on every interface.
+# 0 (default): Off
+metrics_export_port =
 
 [WebService]
 # Whether or not to enable telemetry
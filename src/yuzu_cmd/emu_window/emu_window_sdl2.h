@@ -12,7 +12,9 @@ struct SDL_Window;
 
 class EmuWindow_SDL2 : public EmuWindow {
 public:
-    EmuWindow_SDL2();
+    /// With offscreen set, the window is hidden and buffer swaps don't wait for v-sync, so that
+    /// benchmarks aren't limited by the display
+    explicit EmuWindow_SDL2(bool offscreen = false);
     ~EmuWindow_SDL2();
 
     /// Swap buffers to display the next frame
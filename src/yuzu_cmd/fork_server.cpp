@@ -0,0 +1,189 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <utility>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+#include "yuzu_cmd/fork_server.h"
+
+namespace {
+
+/// Longest request line a client may send
+constexpr size_t MAX_REQUEST_LENGTH = 4096;
+
+bool ReadLine(int fd, std::string& line) {
+    line.clear();
+    char c;
+    while (line.size() < MAX_REQUEST_LENGTH) {
+        const ssize_t result = read(fd, &c, 1);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return false;
+        }
+        if (c == '\n') {
+            return true;
+        }
+        line.push_back(c);
+    }
+    return false;
+}
+
+void WriteAll(int fd, const std::string& str) {
+    size_t written = 0;
+    while (written < str.size()) {
+        const ssize_t result = write(fd, str.data() + written, str.size() - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return;
+        }
+        written += static_cast<size_t>(result);
+    }
+}
+
+/// Parses a request line of space separated --name=value options, or returns an error message.
+std::string ParseRequest(const std::string& line, ForkServer::Request& request) {
+    std::istringstream stream(line);
+    std::string option;
+    while (stream >> option) {
+        const size_t equals = option.find('=');
+        if (option.compare(0, 2, "--") != 0 || equals == std::string::npos) {
+            return "expected --name=value, got " + option;
+        }
+        const std::string name = option.substr(2, equals - 2);
+        const std::string value = option.substr(equals + 1);
+        char* end;
+        if (name == "benchmark-frames") {
+            request.benchmark_config.frames = std::strtoul(value.c_str(), &end, 0);
+            request.benchmark_mode = true;
+        } else if (name == "benchmark-seconds") {
+            request.benchmark_config.seconds = std::strtod(value.c_str(), &end);
+            request.benchmark_mode = true;
+        } else if (name == "benchmark-output") {
+            request.benchmark_config.output_path = value;
+            end = nullptr;
+        } else if (name == "movie-record") {
+            request.movie_record_path = value;
+            end = nullptr;
+        } else if (name == "movie-play") {
+            request.movie_play_path = value;
+            end = nullptr;
+        } else {
+            return "unknown option " + name;
+        }
+        if (end != nullptr && (end == value.c_str() || *end != '\0')) {
+            return "invalid number " + value;
+        }
+    }
+
+    if (request.benchmark_mode && request.benchmark_config.frames == 0 &&
+        request.benchmark_config.seconds <= 0.0) {
+        return "the benchmark needs a number of frames or seconds to run for";
+    }
+    if (!request.movie_record_path.empty() && !request.movie_play_path.empty()) {
+        return "a movie can't be recorded and played back at the same time";
+    }
+    return {};
+}
+
+} // Anonymous namespace
+
+ForkServer::ForkServer(std::string socket_path) : socket_path(std::move(socket_path)) {}
+
+ForkServer::~ForkServer() {
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        if (!is_child) {
+            unlink(socket_path.c_str());
+        }
+    }
+}
+
+bool ForkServer::Serve(Request& request) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+        LOG_CRITICAL(Frontend, "The socket path %s is too long", socket_path.c_str());
+        return false;
+    }
+    std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+    // A socket left behind by a server that was killed would make binding fail
+    unlink(socket_path.c_str());
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 ||
+        bind(listen_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0) {
+        LOG_CRITICAL(Frontend, "Failed to listen on %s: %s", socket_path.c_str(),
+                     std::strerror(errno));
+        return false;
+    }
+    LOG_INFO(Frontend, "Serving runs of the booted system on %s", socket_path.c_str());
+
+    while (true) {
+        // Children that finished since the last connection are reaped here, which is enough to
+        // keep zombies from piling up
+        while (waitpid(-1, nullptr, WNOHANG) > 0) {
+        }
+
+        const int connection = accept(listen_fd, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_CRITICAL(Frontend, "Failed to accept a connection: %s", std::strerror(errno));
+            return false;
+        }
+
+        std::string line;
+        Request parsed;
+        std::string error;
+        if (!ReadLine(connection, line)) {
+            error = "expected a line of options";
+        } else {
+            error = ParseRequest(line, parsed);
+        }
+        if (!error.empty()) {
+            LOG_ERROR(Frontend, "Rejected a request: %s", error.c_str());
+            WriteAll(connection, "error: " + error + "\n");
+            close(connection);
+            continue;
+        }
+
+        // The child only gets the thread that forks it, the log writer is started in both
+        Log::StopLogThread();
+        const pid_t pid = fork();
+        Log::StartLogThread();
+
+        if (pid == 0) {
+            is_child = true;
+            close(listen_fd);
+            listen_fd = -1;
+            dup2(connection, STDOUT_FILENO);
+            close(connection);
+            request = std::move(parsed);
+            return true;
+        }
+
+        if (pid < 0) {
+            LOG_ERROR(Frontend, "Failed to fork: %s", std::strerror(errno));
+            WriteAll(connection, "error: fork failed\n");
+        } else {
+            LOG_INFO(Frontend, "Forked %d for the request \"%s\"", static_cast<int>(pid),
+                     line.c_str());
+        }
+        close(connection);
+    }
+}
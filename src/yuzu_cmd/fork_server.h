@@ -0,0 +1,45 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include "yuzu_cmd/benchmark.h"
+
+/**
+ * Serves runs of a system that was booted once, so that a test farm doesn't pay for loading the
+ * game on every run: for every connection to a Unix socket the booted process forks, and the
+ * copy-on-write child runs what the client asked for while the server waits for the next
+ * connection. Only available on POSIX hosts.
+ *
+ * A client sends a single line of options, out of --benchmark-frames, --benchmark-seconds,
+ * --benchmark-output, --movie-record and --movie-play. The child's stdout is the connection, so a
+ * benchmark report without an output file is sent back, and the connection closes when it exits.
+ */
+class ForkServer {
+public:
+    /// What a client asked a child to run
+    struct Request {
+        bool benchmark_mode = false;
+        Benchmark::Config benchmark_config;
+        std::string movie_record_path;
+        std::string movie_play_path;
+    };
+
+    explicit ForkServer(std::string socket_path);
+    ~ForkServer();
+
+    /**
+     * Listens on the socket and forks for every valid request. Nothing may run on other threads
+     * than the calling one, as a forked child only has the thread that forked it.
+     * @param request Filled with the request in the child
+     * @returns true in a child, which runs the request, and false if the server failed
+     */
+    bool Serve(Request& request);
+
+private:
+    std::string socket_path;
+    int listen_fd = -1;
+    bool is_child = false;
+};
@@ -0,0 +1,193 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <glad/glad.h>
+#include "common/common_paths.h"
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/frontend/emu_window.h"
+#include "video_core/engines/maxwell_3d.h"
+#include "video_core/renderer_opengl/gl_shader_gen.h"
+#include "yuzu_cmd/benchmark.h"
+#include "yuzu_cmd/shader_benchmark.h"
+
+using DoubleMs = std::chrono::duration<double, std::milli>;
+using Clock = std::chrono::steady_clock;
+using Maxwell = Tegra::Engines::Maxwell3D::Regs;
+
+namespace {
+
+struct ShaderResult {
+    std::string name;
+    Maxwell::ShaderStage stage;
+    double decompile_ms = 0.0;
+    size_t glsl_size = 0;
+    bool compiled = false;
+    double compile_ms = 0.0;
+    double link_ms = 0.0;
+};
+
+/// Dumps don't record the stage, so it's taken from the file name: fragment shaders are named
+/// after it ("fs", "frag" or "fragment"), and everything else is decompiled as a vertex shader.
+Maxwell::ShaderStage GetStageFromName(std::string name) {
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (name.compare(0, 2, "fs") == 0 || name.find("frag") != std::string::npos) {
+        return Maxwell::ShaderStage::Fragment;
+    }
+    return Maxwell::ShaderStage::Vertex;
+}
+
+/// Reads a shader binary, padding it with zeroes or cutting it to the size of a program
+bool ReadProgramCode(const std::string& path, GLShader::ProgramCode& program_code) {
+    FileUtil::IOFile file(path, "rb");
+    if (!file.IsOpen()) {
+        return false;
+    }
+    program_code.fill(0);
+    if (file.GetSize() > sizeof(program_code)) {
+        LOG_WARNING(Frontend, "%s is larger than a program, only its start is decompiled",
+                    path.c_str());
+    }
+    file.ReadArray(program_code.data(), program_code.size());
+    return true;
+}
+
+/// Compiles and links the GLSL into a separable program like the rasterizer does, timing both
+void CompileProgram(const std::string& glsl, ShaderResult& result) {
+    const GLenum type = result.stage == Maxwell::ShaderStage::Fragment ? GL_FRAGMENT_SHADER
+                                                                         : GL_VERTEX_SHADER;
+    const char* source = glsl.c_str();
+
+    // Querying the status waits for drivers that build in the background to finish
+    const Clock::time_point compile_start = Clock::now();
+    const GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    GLint compile_status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
+    result.compile_ms = DoubleMs(Clock::now() - compile_start).count();
+
+    if (compile_status != GL_TRUE) {
+        LOG_WARNING(Frontend, "%s failed to compile", result.name.c_str());
+        glDeleteShader(shader);
+        return;
+    }
+
+    const Clock::time_point link_start = Clock::now();
+    const GLuint program = glCreateProgram();
+    glProgramParameteri(program, GL_PROGRAM_SEPARABLE, GL_TRUE);
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    GLint link_status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    result.link_ms = DoubleMs(Clock::now() - link_start).count();
+
+    if (link_status != GL_TRUE) {
+        LOG_WARNING(Frontend, "%s failed to link", result.name.c_str());
+    }
+    result.compiled = link_status == GL_TRUE;
+
+    glDetachShader(program, shader);
+    glDeleteProgram(program);
+    glDeleteShader(shader);
+}
+
+} // Anonymous namespace
+
+ShaderBenchmark::ShaderBenchmark(Config config) : config(std::move(config)) {}
+
+bool ShaderBenchmark::Run(EmuWindow* window) const {
+    std::vector<std::string> names;
+    const bool scanned = FileUtil::ForeachDirectoryEntry(
+        nullptr, config.directory,
+        [&names](unsigned*, const std::string& directory, const std::string& virtual_name) {
+            if (!FileUtil::IsDirectory(directory + DIR_SEP + virtual_name)) {
+                names.push_back(virtual_name);
+            }
+            return true;
+        });
+    if (!scanned) {
+        LOG_CRITICAL(Frontend, "Failed to read the shaders in %s", config.directory.c_str());
+        return false;
+    }
+    // Keeps the reports of two runs in the same order
+    std::sort(names.begin(), names.end());
+
+    if (config.compile) {
+        window->MakeCurrent();
+    }
+
+    std::vector<ShaderResult> results;
+    for (const std::string& name : names) {
+        GLShader::ProgramCode program_code;
+        if (!ReadProgramCode(config.directory + DIR_SEP + name, program_code)) {
+            LOG_ERROR(Frontend, "Failed to read the shader %s", name.c_str());
+            continue;
+        }
+
+        ShaderResult result{name, GetStageFromName(name)};
+        GLShader::ShaderSetup setup{std::move(program_code)};
+
+        // The whole source is generated as the rasterizer does, which is what the driver gets
+        const Clock::time_point start = Clock::now();
+        const GLShader::ProgramResult program =
+            result.stage == Maxwell::ShaderStage::Fragment
+                ? GLShader::GenerateFragmentShader(setup, GLShader::MaxwellFSConfig{setup})
+                : GLShader::GenerateVertexShader(setup, GLShader::MaxwellVSConfig{setup});
+        result.decompile_ms = DoubleMs(Clock::now() - start).count();
+        result.glsl_size = program.first.size();
+
+        if (config.compile) {
+            CompileProgram(program.first, result);
+        }
+        results.push_back(std::move(result));
+    }
+
+    if (config.compile) {
+        window->DoneCurrent();
+    }
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"directory\": \"" << EscapeJson(config.directory) << "\",\n";
+    out << "  \"shaders\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const ShaderResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << EscapeJson(result.name)
+            << "\", \"stage\": \""
+            << (result.stage == Maxwell::ShaderStage::Fragment ? "fragment" : "vertex")
+            << "\", \"decompile_ms\": " << result.decompile_ms
+            << ", \"glsl_bytes\": " << result.glsl_size;
+        if (config.compile) {
+            out << ", \"compiled\": " << (result.compiled ? "true" : "false")
+                << ", \"compile_ms\": " << result.compile_ms << ", \"link_ms\": " << result.link_ms;
+        }
+        out << "}";
+    }
+    out << (results.empty() ? "]\n" : "\n  ]\n");
+    out << "}\n";
+
+    const std::string report = out.str();
+    if (config.output_path.empty()) {
+        std::cout << report;
+        return true;
+    }
+    if (FileUtil::WriteStringToFile(true, report, config.output_path.c_str()) != report.size()) {
+        LOG_ERROR(Frontend, "Failed to write the shader benchmark report to %s",
+                  config.output_path.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+// Copyright 2018 yuzu emulator team
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+
+class EmuWindow;
+
+/**
+ * Runs the shader decompiler over a directory of dumped Maxwell shader binaries, and reports how
+ * long each shader took to decompile, the size of the GLSL and, optionally, how long the driver
+ * took to compile and link it, as JSON.
+ */
+class ShaderBenchmark {
+public:
+    struct Config {
+        /// Directory holding the shader binaries, one shader per file
+        std::string directory;
+        /// Whether to also build the GLSL with the driver, which needs a GL context
+        bool compile = false;
+        /// File to write the report to, stdout when empty
+        std::string output_path;
+    };
+
+    explicit ShaderBenchmark(Config config);
+
+    /**
+     * Decompiles, and compiles if configured to, every shader in the directory, then writes the
+     * report.
+     * @param window Window whose GL context the shaders are compiled in, can be null when the
+     * shaders aren't compiled
+     * @returns false if the directory couldn't be read or the report couldn't be written
+     */
+    bool Run(EmuWindow* window) const;
+
+private:
+    Config config;
+};
@@ -30,12 +30,19 @@
 #include "common/scm_rev.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/thread_placement.h"
 #include "core/core.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/loader/loader.h"
+#include "core/movie.h"
 #include "core/settings.h"
+#include "yuzu_cmd/benchmark.h"
 #include "yuzu_cmd/config.h"
 #include "yuzu_cmd/emu_window/emu_window_sdl2.h"
+#include "yuzu_cmd/shader_benchmark.h"
+#ifndef _WIN32
+#include "yuzu_cmd/fork_server.h"
+#endif
 
 #ifdef _WIN32
 extern "C" {
@@ -49,9 +56,62 @@ __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 static void PrintHelp(const char* argv0) {
     std::cout << "Usage: " << argv0
               << " [options] <filename>\n"
+                 "       "
+              << argv0
+              << " [options] --gpu-trace=FILE\n"
+                 "       "
+              << argv0
+              << " [options] --shader-benchmark=DIR\n"
                  "-g, --gdbport=NUMBER  Enable gdb stub on port NUMBER\n"
                  "-h, --help            Display this help and exit\n"
-                 "-v, --version         Output version information and exit\n";
+                 "-v, --version         Output version information and exit\n"
+                 "--gpu-trace=FILE      Replay a GPU trace recorded with record_gpu_trace\n"
+                 "--benchmark-frames=NUMBER\n"
+                 "                      Run NUMBER frames offscreen without frame limiting,\n"
+                 "                      then report the performance as JSON and exit\n"
+                 "--benchmark-seconds=NUMBER\n"
+                 "                      Like --benchmark-frames, for NUMBER seconds\n"
+                 "--benchmark-output=FILE\n"
+                 "                      Write the benchmark report to FILE instead of stdout\n"
+                 "--shader-benchmark=DIR\n"
+                 "                      Decompile every dumped shader binary in DIR, then report\n"
+                 "                      the timings as JSON and exit. Files named after the\n"
+                 "                      fragment stage (fs*, *frag*) are fragment shaders, the\n"
+                 "                      others vertex shaders.\n"
+                 "--shader-benchmark-compile\n"
+                 "                      Also compile and link the shaders with the GL driver\n"
+                 "--movie-record=FILE   Record the controller input to FILE\n"
+                 "--movie-play=FILE     Play back the controller input recorded to FILE\n"
+                 "--fork-server=SOCKET  Boot the game, then fork a copy of the booted system to\n"
+                 "                      run each line of options sent to the Unix socket SOCKET.\n"
+                 "                      The --benchmark-* and --movie-* options are accepted.\n";
+}
+
+/**
+ * Applies the settings of a run, and starts recording or playing back a movie.
+ * @returns false if the movie couldn't be played back
+ */
+static bool ApplyRunSettings(bool benchmark_mode, const std::string& movie_record_path,
+                             const std::string& movie_play_path) {
+    if (benchmark_mode) {
+        // Frames are measured as fast as the host can run them
+        Settings::values.toggle_framelimit = false;
+        Settings::values.frame_rate_target = 0;
+    }
+    Core::Movie& movie{Core::Movie::GetInstance()};
+    if (!movie_record_path.empty() || !movie_play_path.empty()) {
+        // The input is only replayed at the same point of the game when guest time doesn't
+        // depend on how fast the host runs
+        Settings::values.use_host_timing = false;
+        if (!movie_record_path.empty()) {
+            movie.StartRecording(movie_record_path);
+        } else if (!movie.StartPlayback(movie_play_path)) {
+            LOG_CRITICAL(Frontend, "Failed to load the movie %s", movie_play_path.c_str());
+            return false;
+        }
+    }
+    Settings::Apply();
+    return true;
 }
 
 static void PrintVersion() {
@@ -75,11 +135,27 @@ int main(int argc, char** argv) {
     }
 #endif
     std::string filepath;
+    std::string gpu_trace_path;
+    bool benchmark_mode = false;
+    Benchmark::Config benchmark_config;
+    ShaderBenchmark::Config shader_benchmark_config;
+    std::string movie_record_path;
+    std::string movie_play_path;
+    std::string fork_server_path;
 
     static struct option long_options[] = {
         {"gdbport", required_argument, 0, 'g'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
+        {"gpu-trace", required_argument, 0, 'T'},
+        {"benchmark-frames", required_argument, 0, 'F'},
+        {"benchmark-seconds", required_argument, 0, 'S'},
+        {"benchmark-output", required_argument, 0, 'O'},
+        {"shader-benchmark", required_argument, 0, 'D'},
+        {"shader-benchmark-compile", no_argument, 0, 'C'},
+        {"movie-record", required_argument, 0, 'R'},
+        {"movie-play", required_argument, 0, 'P'},
+        {"fork-server", required_argument, 0, 'K'},
         {0, 0, 0, 0},
     };
 
@@ -104,6 +180,44 @@ int main(int argc, char** argv) {
             case 'v':
                 PrintVersion();
                 return 0;
+            case 'F':
+            case 'S':
+                errno = 0;
+                if (arg == 'F') {
+                    benchmark_config.frames = strtoul(optarg, &endarg, 0);
+                } else {
+                    benchmark_config.seconds = strtod(optarg, &endarg);
+                }
+                benchmark_mode = true;
+                if (endarg == optarg)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror(arg == 'F' ? "--benchmark-frames" : "--benchmark-seconds");
+                    exit(1);
+                }
+                break;
+            case 'O':
+                benchmark_config.output_path = optarg;
+                shader_benchmark_config.output_path = optarg;
+                break;
+            case 'D':
+                shader_benchmark_config.directory = optarg;
+                break;
+            case 'C':
+                shader_benchmark_config.compile = true;
+                break;
+            case 'T':
+                gpu_trace_path = optarg;
+                break;
+            case 'R':
+                movie_record_path = optarg;
+                break;
+            case 'P':
+                movie_play_path = optarg;
+                break;
+            case 'K':
+                fork_server_path = optarg;
+                break;
             }
         } else {
 #ifdef _WIN32
@@ -125,25 +239,70 @@ int main(int argc, char** argv) {
     MicroProfileOnThreadCreate("EmuThread");
     SCOPE_EXIT({ MicroProfileShutdown(); });
 
-    if (filepath.empty()) {
+    if (filepath.empty() && gpu_trace_path.empty() && shader_benchmark_config.directory.empty()) {
         LOG_CRITICAL(Frontend, "Failed to load ROM: No ROM specified");
         return -1;
     }
 
+    if (benchmark_mode && benchmark_config.frames == 0 && benchmark_config.seconds <= 0.0) {
+        LOG_CRITICAL(Frontend, "The benchmark needs a number of frames or seconds to run for");
+        return -1;
+    }
+
+    if (!movie_record_path.empty() && !movie_play_path.empty()) {
+        LOG_CRITICAL(Frontend, "A movie can't be recorded and played back at the same time");
+        return -1;
+    }
+
+    if (!fork_server_path.empty()) {
+#ifdef _WIN32
+        LOG_CRITICAL(Frontend, "The fork server is only available on POSIX hosts");
+        return -1;
+#endif
+        if (filepath.empty() || !gpu_trace_path.empty() ||
+            !shader_benchmark_config.directory.empty()) {
+            LOG_CRITICAL(Frontend, "The fork server only serves runs of a game");
+            return -1;
+        }
+        if (!movie_record_path.empty() || !movie_play_path.empty()) {
+            LOG_CRITICAL(Frontend, "Movies are recorded and played back by each fork server run");
+            return -1;
+        }
+        // The server thread of the stub wouldn't survive the fork
+        use_gdbstub = false;
+    }
+
     log_filter.ParseFilterString(Settings::values.log_filter);
 
+    if (!shader_benchmark_config.directory.empty()) {
+        // Only the driver needs a window, for its GL context
+        std::unique_ptr<EmuWindow_SDL2> emu_window;
+        if (shader_benchmark_config.compile) {
+            emu_window = std::make_unique<EmuWindow_SDL2>(true);
+        }
+        return ShaderBenchmark(shader_benchmark_config).Run(emu_window.get()) ? 0 : -1;
+    }
+
     // Apply the command line arguments
     Settings::values.gdbstub_port = gdb_port;
     Settings::values.use_gdbstub = use_gdbstub;
-    Settings::Apply();
+    if (!ApplyRunSettings(benchmark_mode, movie_record_path, movie_play_path)) {
+        return -1;
+    }
 
-    std::unique_ptr<EmuWindow_SDL2> emu_window{std::make_unique<EmuWindow_SDL2>()};
+    // The fork server boots without a window, every run creates its own along with its GL context
+    std::unique_ptr<EmuWindow_SDL2> emu_window;
+    if (fork_server_path.empty()) {
+        emu_window = std::make_unique<EmuWindow_SDL2>(benchmark_mode);
+    }
 
     Core::System& system{Core::System::GetInstance()};
 
     SCOPE_EXIT({ system.Shutdown(); });
 
-    const Core::System::ResultStatus load_result{system.Load(emu_window.get(), filepath)};
+    const Core::System::ResultStatus load_result{
+        gpu_trace_path.empty() ? system.Load(emu_window.get(), filepath)
+                               : system.LoadGPUTrace(emu_window.get(), gpu_trace_path)};
 
     switch (load_result) {
     case Core::System::ResultStatus::ErrorGetLoader:
@@ -174,9 +333,44 @@ int main(int argc, char** argv) {
         break; // Expected case
     }
 
+#ifndef _WIN32
+    if (!fork_server_path.empty()) {
+        ForkServer server{fork_server_path};
+        ForkServer::Request request;
+        if (!server.Serve(request)) {
+            return -1;
+        }
+
+        // This is a forked run from here on
+        benchmark_mode = request.benchmark_mode;
+        benchmark_config = request.benchmark_config;
+        if (!ApplyRunSettings(benchmark_mode, request.movie_record_path,
+                              request.movie_play_path)) {
+            return -1;
+        }
+        emu_window = std::make_unique<EmuWindow_SDL2>(benchmark_mode);
+        if (system.AttachWindow(emu_window.get()) != Core::System::ResultStatus::Success) {
+            LOG_CRITICAL(Frontend, "VideoCore not initialized");
+            return -1;
+        }
+    }
+#endif
+
     Core::Telemetry().AddField(Telemetry::FieldType::App, "Frontend", "SDL");
 
-    while (emu_window->IsOpen()) {
+    system.GPU().LoadDiskResources(nullptr);
+    Common::SetCurrentThreadRole(Common::ThreadRole::CPU);
+
+    if (benchmark_mode) {
+        Benchmark benchmark{benchmark_config, gpu_trace_path.empty() ? filepath : gpu_trace_path};
+        benchmark.Start();
+        while (emu_window->IsOpen() && !benchmark.IsDone() && !system.IsGPUTraceFinished()) {
+            system.RunLoop();
+        }
+        return benchmark.WriteReport() ? 0 : -1;
+    }
+
+    while (emu_window->IsOpen() && !system.IsGPUTraceFinished()) {
         system.RunLoop();
     }
 